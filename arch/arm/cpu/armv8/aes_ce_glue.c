@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * aes_ce_glue.c - AES-CBC using ARMv8 Crypto Extensions
+ */
+
+#include <uboot_aes.h>
+#include <asm/system.h>
+
+extern void aes_armv8_ce_invert_key(u8 *dk, const u8 *rk, u32 rounds);
+extern void aes_armv8_ce_cbc_encrypt(const u8 *rk, u32 rounds, const u8 *iv,
+				     const u8 *src, u8 *dst, u32 blocks);
+extern void aes_armv8_ce_cbc_decrypt(const u8 *dk, u32 rounds, const u8 *iv,
+				     const u8 *src, u8 *dst, u32 blocks);
+
+static bool cpu_has_aes(void)
+{
+	uint64_t reg;
+
+	__asm__ volatile("mrs %0, ID_AA64ISAR0_EL1\n" : "=r" (reg));
+	return reg & ID_AA64ISAR0_EL1_AES;
+}
+
+/* Nr = Nk + 6, with Nk the key length in 32-bit words */
+static u32 aes_ce_rounds(u32 key_len)
+{
+	return key_len / 4 + 6;
+}
+
+void aes_cbc_encrypt_blocks(u32 key_len, u8 *key_exp, u8 *iv, u8 *src, u8 *dst,
+			    u32 num_aes_blocks)
+{
+	if (cpu_has_aes())
+		aes_armv8_ce_cbc_encrypt(key_exp, aes_ce_rounds(key_len), iv,
+					 src, dst, num_aes_blocks);
+	else
+		aes_cbc_encrypt_blocks_generic(key_len, key_exp, iv, src, dst,
+					       num_aes_blocks);
+}
+
+void aes_cbc_decrypt_blocks(u32 key_len, u8 *key_exp, u8 *iv, u8 *src, u8 *dst,
+			    u32 num_aes_blocks)
+{
+	u8 dk[AES256_EXPAND_KEY_LENGTH];
+	u32 rounds = aes_ce_rounds(key_len);
+
+	if (!cpu_has_aes()) {
+		aes_cbc_decrypt_blocks_generic(key_len, key_exp, iv, src, dst,
+					       num_aes_blocks);
+		return;
+	}
+
+	aes_armv8_ce_invert_key(dk, key_exp, rounds);
+	aes_armv8_ce_cbc_decrypt(dk, rounds, iv, src, dst, num_aes_blocks);
+}
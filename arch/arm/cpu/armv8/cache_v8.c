@@ -111,6 +111,8 @@ u64 get_tcr(u64 *pips, u64 *pva_bits)
 }
 
 #define MAX_PTE_ENTRIES 512
+/* Number of entries in a run marked with the contiguous hint */
+#define PTE_CONT_ENTRIES 16
 
 static int pte_type(u64 *pte)
 {
@@ -239,6 +241,44 @@ static void apply_cmo_to_mappings(void (*cmo_fn)(unsigned long, unsigned long))
 static inline void apply_cmo_to_mappings(void *dummy) {}
 #endif
 
+/* Set when changes to the page tables need the whole TLB invalidated */
+static bool tlb_invalidate_all __section(".data");
+
+/* Drop the contiguous hint from the run of entries around *pte */
+static void pte_clear_cont(u64 *pte)
+{
+	u64 *run;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_ARMV8_MMU_CONT_HINT) || !(*pte & PTE_BLOCK_CONT))
+		return;
+
+	run = (u64 *)((uintptr_t)pte &
+		      ~(uintptr_t)(PTE_CONT_ENTRIES * sizeof(u64) - 1));
+	for (i = 0; i < PTE_CONT_ENTRIES; i++)
+		run[i] &= ~PTE_BLOCK_CONT;
+	flush_dcache_range((ulong)run, (ulong)(run + PTE_CONT_ENTRIES));
+	tlb_invalidate_all = true;
+}
+
+/* Invalidate the TLB entries of the current EL which translate @va */
+static void invalidate_tlb_va(u64 va)
+{
+	u64 arg = va >> 12;
+
+	switch (current_el()) {
+	case 3:
+		asm volatile("tlbi vae3, %0" : : "r" (arg));
+		break;
+	case 2:
+		asm volatile("tlbi vae2, %0" : : "r" (arg));
+		break;
+	default:
+		asm volatile("tlbi vaae1, %0" : : "r" (arg));
+		break;
+	}
+}
+
 /* Returns and creates a new full table (512 entries) */
 static u64 *create_table(void)
 {
@@ -281,6 +321,8 @@ static void split_block(u64 *pte, int level)
 		      "modify dcache settings for an range not covered in "
 		      "mem_map.", pte, old_pte);
 
+	pte_clear_cont(pte);
+	old_pte = *pte;
 	new_table = create_table();
 	debug("Splitting pte %p (%llx) into %p\n", pte, old_pte, new_table);
 
@@ -293,6 +335,8 @@ static void split_block(u64 *pte, int level)
 
 		debug("Setting new_table[%lld] = %llx\n", i, new_table[i]);
 	}
+	flush_dcache_range((ulong)new_table,
+			   (ulong)(new_table + MAX_PTE_ENTRIES));
 
 	/* Set the new table into effect */
 	set_pte_table(pte, new_table);
@@ -302,7 +346,8 @@ static void map_range(u64 virt, u64 phys, u64 size, int level,
 		      u64 *table, u64 attrs)
 {
 	u64 map_size = BIT_ULL(level2shift(level));
-	int i, idx;
+	u64 cont_size = map_size * PTE_CONT_ENTRIES;
+	int i, idx, cont = 0;
 
 	idx = (virt >> level2shift(level)) & (MAX_PTE_ENTRIES - 1);
 	for (i = idx; size; i++) {
@@ -310,10 +355,21 @@ static void map_range(u64 virt, u64 phys, u64 size, int level,
 
 		if (level >= 1 &&
 		    size >= map_size && !(virt & (map_size - 1))) {
+			/* Start a run of entries with the contiguous hint */
+			if (IS_ENABLED(CONFIG_ARMV8_MMU_CONT_HINT) && !cont &&
+			    size >= cont_size && !(virt & (cont_size - 1)) &&
+			    !(phys & (cont_size - 1)))
+				cont = PTE_CONT_ENTRIES;
+
+			pte_clear_cont(&table[i]);
 			if (level == 3)
 				table[i] = phys | attrs | PTE_TYPE_PAGE;
 			else
 				table[i] = phys | attrs;
+			if (cont) {
+				table[i] |= PTE_BLOCK_CONT;
+				cont--;
+			}
 
 			virt += map_size;
 			phys += map_size;
@@ -797,6 +853,21 @@ void flush_dcache_range(unsigned long start, unsigned long stop)
 {
 	__asm_flush_dcache_range(start, stop);
 }
+
+void invalidate_dcache_range_nosync(unsigned long start, unsigned long stop)
+{
+	__asm_invalidate_dcache_range_nosync(start, stop);
+}
+
+void flush_dcache_range_nosync(unsigned long start, unsigned long stop)
+{
+	__asm_flush_dcache_range_nosync(start, stop);
+}
+
+void dcache_range_sync(void)
+{
+	dsb();
+}
 #else
 void invalidate_dcache_range(unsigned long start, unsigned long stop)
 {
@@ -805,6 +876,14 @@ void invalidate_dcache_range(unsigned long start, unsigned long stop)
 void flush_dcache_range(unsigned long start, unsigned long stop)
 {
 }
+
+void invalidate_dcache_range_nosync(unsigned long start, unsigned long stop)
+{
+}
+
+void flush_dcache_range_nosync(unsigned long start, unsigned long stop)
+{
+}
 #endif /* CONFIG_SYS_DISABLE_DCACHE_OPS */
 
 void dcache_enable(void)
@@ -865,27 +944,60 @@ static bool is_aligned(u64 addr, u64 size, u64 align)
 	return !(addr & (align - 1)) && !(size & (align - 1));
 }
 
+/*
+ * Check whether the block or page mapping @start already has @attrs
+ *
+ * Return: the number of bytes from @start to the end of the mapping (at most
+ * @size) if it does, else 0
+ */
+static u64 region_has_attrs(u64 start, u64 size, u64 attrs, u64 mask)
+{
+	int level;
+	u64 *pte;
+
+	for (level = 1; level < 4; level++) {
+		pte = find_pte(start, level);
+		if (!pte)
+			return 0;
+		if (level == 3 || pte_type(pte) != PTE_TYPE_TABLE)
+			break;
+	}
+	if (pte_type(pte) == PTE_TYPE_FAULT ||
+	    (*pte & mask) != (attrs & mask))
+		return 0;
+
+	return min(BIT_ULL(level2shift(level)) -
+		   (start & (BIT_ULL(level2shift(level)) - 1)), size);
+}
+
 /* Use flag to indicate if attrs has more than d-cache attributes */
 static u64 set_one_region(u64 start, u64 size, u64 attrs, bool flag, int level)
 {
 	int levelshift = level2shift(level);
 	u64 levelsize = 1ULL << levelshift;
+	u64 mask = flag ? PMD_ATTRMASK : PMD_ATTRINDX_MASK;
 	u64 *pte = find_pte(start, level);
+	u64 done;
 
 	/* Can we can just modify the current level block PTE? */
 	if (is_aligned(start, size, levelsize)) {
-		if (flag) {
-			*pte &= ~PMD_ATTRMASK;
-			*pte |= attrs & PMD_ATTRMASK;
-		} else {
-			*pte &= ~PMD_ATTRINDX_MASK;
-			*pte |= attrs & PMD_ATTRINDX_MASK;
-		}
+		pte_clear_cont(pte);
+		*pte &= ~mask;
+		*pte |= attrs & mask;
 		debug("Set attrs=%llx pte=%p level=%d\n", attrs, pte, level);
+		flush_dcache_range((ulong)pte, (ulong)(pte + 1));
+		invalidate_tlb_va(start);
 
 		return levelsize;
 	}
 
+	/* A block which already has the attributes need not be split */
+	if (pte_type(pte) == PTE_TYPE_BLOCK) {
+		done = region_has_attrs(start, size, attrs, mask);
+		if (done)
+			return done;
+	}
+
 	/* Unaligned or doesn't fit, maybe split block into table */
 	debug("addr=%llx level=%d pte=%p (%llx)\n", start, level, pte, *pte);
 
@@ -908,12 +1020,27 @@ void mmu_set_region_dcache_behaviour(phys_addr_t start, size_t size,
 	u64 attrs = PMD_ATTRINDX(option >> 2);
 	u64 real_start = start;
 	u64 real_size = size;
+	u64 addr, left, done;
 
 	debug("start=%lx size=%lx\n", (ulong)start, (ulong)size);
 
 	if (!gd->arch.tlb_emerg)
 		panic("Emergency page table not setup.");
 
+	/*
+	 * Nothing to do if the mappings already have these attributes. This
+	 * avoids switching page tables, which runs with the caches off.
+	 */
+	for (addr = start, left = size; left; addr += done, left -= done) {
+		done = region_has_attrs(addr, left, attrs, PMD_ATTRINDX_MASK);
+		if (!done)
+			break;
+	}
+	if (!left) {
+		flush_dcache_range(real_start, real_start + real_size);
+		return;
+	}
+
 	/*
 	 * We can not modify page tables that we're currently running on,
 	 * so we first need to switch to the "emergency" page tables where
@@ -952,6 +1079,17 @@ void mmu_set_region_dcache_behaviour(phys_addr_t start, size_t size,
 	flush_dcache_range(real_start, real_start + real_size);
 }
 
+/* Complete the TLB invalidation for the page table entries changed so far */
+static void mmu_sync_tlb(void)
+{
+	if (tlb_invalidate_all) {
+		__asm_invalidate_tlb_all();
+		tlb_invalidate_all = false;
+	}
+	dsb();
+	isb();
+}
+
 /*
  * Modify MMU table for a region with updated PXN/UXN/Memory type/valid bits.
  * The procecess is break-before-make. The target region will be marked as
@@ -962,11 +1100,13 @@ void mmu_change_region_attr(phys_addr_t addr, size_t siz, u64 attrs)
 	int level;
 	u64 r, size, start;
 
+	tlb_invalidate_all = false;
 	start = addr;
 	size = siz;
 	/*
 	 * Loop through the address range until we find a page granule that fits
-	 * our alignment constraints, then set it to "invalid".
+	 * our alignment constraints, then set it to "invalid". Each entry is
+	 * written back and its TLB entries invalidated as it changes.
 	 */
 	while (size > 0) {
 		for (level = 1; level < 4; level++) {
@@ -982,9 +1122,7 @@ void mmu_change_region_attr(phys_addr_t addr, size_t siz, u64 attrs)
 		}
 	}
 
-	flush_dcache_range(gd->arch.tlb_addr,
-			   gd->arch.tlb_addr + gd->arch.tlb_size);
-	__asm_invalidate_tlb_all();
+	mmu_sync_tlb();
 
 	/*
 	 * Loop through the address range until we find a page granule that fits
@@ -1004,9 +1142,7 @@ void mmu_change_region_attr(phys_addr_t addr, size_t siz, u64 attrs)
 			}
 		}
 	}
-	flush_dcache_range(gd->arch.tlb_addr,
-			   gd->arch.tlb_addr + gd->arch.tlb_size);
-	__asm_invalidate_tlb_all();
+	mmu_sync_tlb();
 }
 
 #else	/* !CONFIG_IS_ENABLED(SYS_DCACHE_OFF) */
@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sampling timer for the profiler, using the EL1 physical timer
+ *
+ * The timer interrupt is a PPI, which the board must enable in its interrupt
+ * controller, since U-Boot does not otherwise use interrupts on ARMv8.
+ */
+
+#include <trace.h>
+#include <asm/global_data.h>
+#include <asm/ptrace.h>
+#include <asm/system.h>
+#include <asm/u-boot-arm.h>
+#include <linux/bitops.h>
+#include <linux/errno.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define CNTP_CTL_ENABLE		BIT(0)
+#define CNTP_CTL_ISTATUS	BIT(2)
+
+/* Timer ticks between samples */
+static ulong sample_ticks;
+
+__weak int board_trace_sample_irq(int enable)
+{
+	return -ENOSYS;
+}
+
+__weak void board_trace_sample_eoi(void)
+{
+}
+
+int arch_trace_sample_start(unsigned int hz, unsigned long *stack_top)
+{
+	ulong freq;
+	int ret;
+
+	asm volatile("mrs %0, cntfrq_el0" : "=r" (freq));
+	sample_ticks = max(freq / hz, 1UL);
+	ret = board_trace_sample_irq(1);
+	if (ret)
+		return ret;
+	*stack_top = gd->start_addr_sp;
+
+	asm volatile("msr cntp_tval_el0, %0" : : "r" (sample_ticks));
+	asm volatile("msr cntp_ctl_el0, %0" : : "r" ((ulong)CNTP_CTL_ENABLE));
+	isb();
+	asm volatile("msr daifclr, #2" : : : "memory");
+
+	return 0;
+}
+
+void arch_trace_sample_stop(void)
+{
+	asm volatile("msr daifset, #2" : : : "memory");
+	asm volatile("msr cntp_ctl_el0, %0" : : "r" (0UL));
+	isb();
+	board_trace_sample_irq(0);
+}
+
+int trace_sample_irq(struct pt_regs *pt_regs)
+{
+	ulong ctl;
+
+	asm volatile("mrs %0, cntp_ctl_el0" : "=r" (ctl));
+	if (!(ctl & CNTP_CTL_ENABLE) || !(ctl & CNTP_CTL_ISTATUS))
+		return 0;
+
+	/* Reloading the timer clears the interrupt */
+	asm volatile("msr cntp_tval_el0, %0" : : "r" (sample_ticks));
+	isb();
+
+	/* The interrupted code's stack is above the saved registers */
+	trace_sample_record(pt_regs->elr, pt_regs->regs[29],
+			    (ulong)(pt_regs + 1));
+	board_trace_sample_eoi();
+
+	return 1;
+}
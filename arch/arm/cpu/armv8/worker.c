@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Starting secondary CPUs through PSCI to run worker jobs
+ */
+
+#define LOG_CATEGORY LOGC_ARCH
+
+#include <cpu_func.h>
+#include <dm.h>
+#include <log.h>
+#include <malloc.h>
+#include <time.h>
+#include <worker.h>
+#include <asm/cache.h>
+#include <asm/global_data.h>
+#include <asm/io.h>
+#include <asm/system.h>
+#include <asm/armv8/mmu.h>
+#include <dm/ofnode.h>
+#include <linux/psci.h>
+#include <linux/sizes.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define MPIDR_HWID_MASK		0xff00ffffffUL
+#define WORKER_STACK_SIZE	SZ_16K
+#define WORKER_OFF_TIMEOUT_MS	100
+
+/**
+ * struct worker_cpu - Information for starting a secondary CPU
+ *
+ * This is read by worker_entry with the MMU off, so the layout of the
+ * first part must match worker_entry.S
+ *
+ * @stack: Top of the stack for the CPU
+ * @gd_ptr: Global data pointer
+ * @vbar: Exception vector base
+ * @mair: Memory attributes
+ * @tcr: Translation control
+ * @ttbr0: Page table base
+ * @sctlr: System control (enables the MMU and caches)
+ * @mpidr: Affinity of the CPU
+ * @done: Set by the CPU when it has no more jobs to take
+ */
+struct worker_cpu {
+	u64 stack;
+	u64 gd_ptr;
+	u64 vbar;
+	u64 mair;
+	u64 tcr;
+	u64 ttbr0;
+	u64 sctlr;
+	u64 mpidr;
+	int done;
+	u8 stack_base[WORKER_STACK_SIZE] __aligned(16);
+};
+
+extern char worker_entry[], worker_entry_end[];
+
+static struct worker_cpu *cpus;
+static int num_started;
+
+static u64 worker_read_vbar(void)
+{
+	u64 val;
+
+	switch (current_el()) {
+	case 1:
+		asm volatile("mrs %0, vbar_el1" : "=r" (val));
+		break;
+	case 2:
+		asm volatile("mrs %0, vbar_el2" : "=r" (val));
+		break;
+	default:
+		asm volatile("mrs %0, vbar_el3" : "=r" (val));
+		break;
+	}
+
+	return val;
+}
+
+void __noreturn worker_cpu_main(struct worker_cpu *cpu)
+{
+	worker_secondary();
+	__atomic_store_n(&cpu->done, 1, __ATOMIC_RELEASE);
+
+	/* Hand the CPU back to the firmware */
+	invoke_psci_fn(PSCI_0_2_FN_CPU_OFF, 0, 0, 0);
+	while (1)
+		wfi();
+}
+
+static int worker_cpu_mpidr(ofnode node, u64 *mpidrp)
+{
+	const fdt32_t *reg;
+	const char *type;
+	int len;
+
+	type = ofnode_read_string(node, "device_type");
+	if (!type || strcmp(type, "cpu"))
+		return -ENOENT;
+	reg = ofnode_read_prop(node, "reg", &len);
+	if (!reg || (len != sizeof(u32) && len != sizeof(u64)))
+		return -EINVAL;
+	*mpidrp = fdt32_to_cpu(reg[0]);
+	if (len == sizeof(u64))
+		*mpidrp = *mpidrp << 32 | fdt32_to_cpu(reg[1]);
+
+	return 0;
+}
+
+int arch_worker_start(int max)
+{
+	u64 self = read_mpidr() & MPIDR_HWID_MASK;
+	struct udevice *dev;
+	ofnode node;
+
+	/* PSCI is needed to start CPUs */
+	if (uclass_get_device_by_name(UCLASS_FIRMWARE, "psci", &dev))
+		return 0;
+	if (!(get_sctlr() & CR_M))
+		return 0;
+
+	max = min(max, CONFIG_WORKER_CPUS_MAX);
+	if (!cpus) {
+		cpus = memalign(ARCH_DMA_MINALIGN,
+				CONFIG_WORKER_CPUS_MAX * sizeof(*cpus));
+		if (!cpus)
+			return 0;
+	}
+	/* The CPUs start with the MMU off, so make sure they see the code */
+	flush_dcache_range((ulong)worker_entry, (ulong)worker_entry_end);
+
+	num_started = 0;
+	ofnode_for_each_subnode(node, ofnode_path("/cpus")) {
+		struct worker_cpu *cpu = &cpus[num_started];
+		unsigned long ret;
+		u64 mpidr;
+
+		if (num_started == max)
+			break;
+		if (worker_cpu_mpidr(node, &mpidr) || mpidr == self)
+			continue;
+
+		cpu->stack = (ulong)cpu->stack_base + WORKER_STACK_SIZE;
+		cpu->gd_ptr = (ulong)gd;
+		cpu->vbar = worker_read_vbar();
+		cpu->mair = MEMORY_ATTRIBUTES;
+		cpu->tcr = get_tcr(NULL, NULL);
+		cpu->ttbr0 = gd->arch.tlb_addr;
+		cpu->sctlr = get_sctlr();
+		cpu->mpidr = mpidr;
+		cpu->done = 0;
+		flush_dcache_range((ulong)cpu, (ulong)cpu->stack_base);
+
+		ret = invoke_psci_fn(PSCI_0_2_FN64_CPU_ON, mpidr,
+				     virt_to_phys(worker_entry),
+				     virt_to_phys(cpu));
+		if (ret) {
+			log_debug("CPU %llx did not start (err=%ld)\n", mpidr,
+				  (long)ret);
+			continue;
+		}
+		num_started++;
+	}
+
+	return num_started;
+}
+
+void arch_worker_stop(void)
+{
+	int i;
+
+	for (i = 0; i < num_started; i++) {
+		struct worker_cpu *cpu = &cpus[i];
+		ulong start;
+
+		/* Jobs can take a while, so there is no timeout here */
+		while (!__atomic_load_n(&cpu->done, __ATOMIC_ACQUIRE))
+			;
+
+		start = get_timer(0);
+		while (invoke_psci_fn(PSCI_0_2_FN64_AFFINITY_INFO, cpu->mpidr,
+				      0, 0) != PSCI_0_2_AFFINITY_LEVEL_OFF) {
+			if (get_timer(start) > WORKER_OFF_TIMEOUT_MS) {
+				log_err("CPU %llx did not power off\n",
+					cpu->mpidr);
+				break;
+			}
+		}
+	}
+	num_started = 0;
+}
@@ -26,7 +26,12 @@
  * that expect bulk OUT requests to be divisible by maxpacket size.
  */
 
-#define RKUSB_BUF_SIZE		EP_BUFFER_SIZE * 2
+/*
+ * Image writes are received straight into one half of this buffer while the
+ * other half is written to the block device
+ */
+#define RKUSB_DL_CHUNK_SIZE	CONFIG_ROCKUSB_DL_CHUNK_SIZE
+#define RKUSB_BUF_SIZE		(RKUSB_DL_CHUNK_SIZE * 2)
 #define RKBLOCK_BUF_SIZE		4096
 
 #define RKUSB_STATUS_IDLE			0
@@ -128,6 +133,7 @@ struct f_rockusb {
 	int reboot_flag;
 	void *buf;
 	void *buf_head;
+	void *cmd_buf;
 };
 
 /* init rockusb device, tell rockusb which device you want to read/write*/
@@ -8,12 +8,43 @@
 #define __ASM_ARM_DMA_MAPPING_H
 
 #include <asm/cache.h>
+#include <asm/system.h>
 #include <cpu_func.h>
 #include <linux/dma-direction.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <malloc.h>
 
+#ifdef CONFIG_SYS_NONCACHED_MEMORY
+/*
+ * Coherent memory comes from the non-cached region where possible, so that
+ * drivers need no cache maintenance for it. It falls back to cached memory
+ * when the region is full or not set up yet, e.g. in SPL.
+ */
+static inline void *dma_alloc_coherent(size_t len, unsigned long *handle)
+{
+	len = ROUND(len, ARCH_DMA_MINALIGN);
+	*handle = noncached_alloc(len, ARCH_DMA_MINALIGN);
+	if (!*handle)
+		*handle = (unsigned long)memalign(ARCH_DMA_MINALIGN, len);
+
+	return (void *)*handle;
+}
+
+static inline void dma_free_coherent(void *addr)
+{
+	if (noncached_contains((unsigned long)addr))
+		noncached_free((unsigned long)addr);
+	else
+		free(addr);
+}
+
+#define dma_coherent_is_uncached dma_coherent_is_uncached
+static inline bool dma_coherent_is_uncached(const void *vaddr)
+{
+	return noncached_contains((unsigned long)vaddr);
+}
+#else
 static inline void *dma_alloc_coherent(size_t len, unsigned long *handle)
 {
 	*handle = (unsigned long)memalign(ARCH_DMA_MINALIGN, ROUND(len, ARCH_DMA_MINALIGN));
@@ -24,5 +55,6 @@ static inline void dma_free_coherent(void *addr)
 {
 	free(addr);
 }
+#endif
 
 #endif /* __ASM_ARM_DMA_MAPPING_H */
@@ -24,4 +24,19 @@ typedef struct jmp_buf_data jmp_buf[1];
 int setjmp(jmp_buf jmp);
 void longjmp(jmp_buf jmp, int ret);
 
+/**
+ * initjmp() - Set up a jump buffer to start a function on a new stack
+ *
+ * A later longjmp() to @jmp calls @func with its stack at the top of the
+ * given region. @func must not return.
+ *
+ * @jmp: Jump buffer to set up
+ * @func: Function to call
+ * @stack_base: Lowest address of the stack
+ * @stack_sz: Size of the stack in bytes
+ * Return: 0 if OK, -ve on error
+ */
+int initjmp(jmp_buf jmp, void __noreturn (*func)(void), void *stack_base,
+	    size_t stack_sz);
+
 #endif /* _SETJMP_H_ */
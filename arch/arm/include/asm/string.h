@@ -9,9 +9,22 @@
 #undef __HAVE_ARCH_STRRCHR
 extern char * strrchr(const char * s, int c);
 
+#if CONFIG_IS_ENABLED(USE_ARCH_STRING)
+#define __HAVE_ARCH_STRCHR
+#else
 #undef __HAVE_ARCH_STRCHR
+#endif
 extern char * strchr(const char * s, int c);
 
+#if CONFIG_IS_ENABLED(USE_ARCH_STRING)
+#define __HAVE_ARCH_STRCMP
+#define __HAVE_ARCH_STRLEN
+#define __HAVE_ARCH_MEMCMP
+extern int strcmp(const char *, const char *);
+extern __kernel_size_t strlen(const char *);
+extern int memcmp(const void *, const void *, __kernel_size_t);
+#endif
+
 #if CONFIG_IS_ENABLED(USE_ARCH_MEMCPY)
 #define __HAVE_ARCH_MEMCPY
 #endif
@@ -24,7 +37,11 @@ extern void * memcpy(void *, const void *, __kernel_size_t);
 #endif
 extern void * memmove(void *, const void *, __kernel_size_t);
 
+#if CONFIG_IS_ENABLED(USE_ARCH_STRING)
+#define __HAVE_ARCH_MEMCHR
+#else
 #undef __HAVE_ARCH_MEMCHR
+#endif
 extern void * memchr(const void *, int, __kernel_size_t);
 
 #undef __HAVE_ARCH_MEMZERO
@@ -87,6 +87,9 @@
 #define HCR_EL2_AMO_EL2		(1 <<  5) /* Route SErrors to EL2             */
 
 #define ID_AA64ISAR0_EL1_RNDR	(0xFUL << 60) /* RNDR random registers */
+#define ID_AA64ISAR0_EL1_SHA2	(0xFUL << 12) /* SHA2 instructions */
+#define ID_AA64ISAR0_EL1_SHA2_SHA512	(0x2UL << 12) /* ... incl. SHA512 */
+#define ID_AA64ISAR0_EL1_AES	(0xFUL << 4) /* AES instructions */
 /*
  * ID_AA64ISAR1_EL1 bits definitions
  */
@@ -231,6 +234,14 @@ void __asm_flush_dcache_range(u64 start, u64 end);
  * @end: End address to invalidate up to (exclusive)
  */
 void __asm_invalidate_dcache_range(u64 start, u64 end);
+
+/*
+ * These are the same as __asm_flush_dcache_range() and
+ * __asm_invalidate_dcache_range() but do not wait for the operation to
+ * complete, so must be followed by a dsb
+ */
+void __asm_flush_dcache_range_nosync(u64 start, u64 end);
+void __asm_invalidate_dcache_range_nosync(u64 start, u64 end);
 void __asm_invalidate_tlb_all(void);
 void __asm_invalidate_icache_all(void);
 int __asm_invalidate_l3_dcache(void);
@@ -669,7 +680,35 @@ void mmu_set_region_dcache_behaviour(phys_addr_t start, size_t size,
  */
 int noncached_init(void);
 
+/**
+ * noncached_alloc() - Allocate memory from the non-cached region
+ *
+ * Memory from this region needs no cache maintenance before or after DMA, so
+ * it suits descriptor rings which are shared with a device.
+ *
+ * @size: Number of bytes to allocate
+ * @align: Alignment in bytes, a power of two
+ * Return: address of the memory, or 0 if there is not enough space or the
+ *	region is not set up yet
+ */
 phys_addr_t noncached_alloc(size_t size, size_t align);
+
+/**
+ * noncached_free() - Free memory allocated by noncached_alloc()
+ *
+ * This does nothing if @addr is not in the non-cached region
+ *
+ * @addr: Address returned by noncached_alloc()
+ */
+void noncached_free(phys_addr_t addr);
+
+/**
+ * noncached_contains() - Check if an address is in the non-cached region
+ *
+ * @addr: Address to check
+ * Return: true if @addr is in the region, false if not
+ */
+bool noncached_contains(phys_addr_t addr);
 #endif /* CONFIG_SYS_NONCACHED_MEMORY */
 
 #endif /* __ASSEMBLY__ */
@@ -49,6 +49,35 @@ void do_not_used(struct pt_regs *pt_regs);
 void do_fiq(struct pt_regs *pt_regs);
 void do_irq(struct pt_regs *pt_regs);
 
+/* arch/arm/cpu/armv8/trace_sample.c */
+
+/**
+ * trace_sample_irq() - Handle an interrupt from the sampling timer
+ *
+ * @pt_regs: Registers of the interrupted code
+ * Return: 1 if the interrupt was from the sampling timer, else 0
+ */
+int trace_sample_irq(struct pt_regs *pt_regs);
+
+/**
+ * board_trace_sample_irq() - Route the sampling timer's interrupt
+ *
+ * The board must implement this to enable the EL1 physical timer PPI in its
+ * interrupt controller, so that it is signalled to the CPU as an IRQ.
+ *
+ * @enable: 1 to enable the interrupt, 0 to disable it
+ * Return: 0 if OK, -ve on error
+ */
+int board_trace_sample_irq(int enable);
+
+/**
+ * board_trace_sample_eoi() - Signal the end of the sampling interrupt
+ *
+ * The board implements this if its interrupt controller needs to be told
+ * when each interrupt has been handled
+ */
+void board_trace_sample_eoi(void);
+
 void reset_misc(void);
 
 #endif /* __ASSEMBLY__ */
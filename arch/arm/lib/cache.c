@@ -10,6 +10,9 @@
 #include <malloc.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
+#include <linux/bitmap.h>
+#include <linux/bitops.h>
+#include <linux/errno.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -71,10 +74,18 @@ int check_cache_range(unsigned long start, unsigned long stop)
 /*
  * Reserve one MMU section worth of address space below the malloc() area that
  * will be mapped uncached.
+ *
+ * The area is handed out in granules of NONCACHED_GRANULE bytes. One bitmap
+ * records which granules are in use and another marks the first granule of
+ * each allocation, so that noncached_free() knows where an allocation ends.
  */
+#define NONCACHED_GRANULE	ARCH_DMA_MINALIGN
+
 static unsigned long noncached_start;
 static unsigned long noncached_end;
-static unsigned long noncached_next;
+static unsigned long *noncached_used;
+static unsigned long *noncached_first;
+static unsigned long noncached_granules;
 
 void noncached_set_region(void)
 {
@@ -97,9 +108,14 @@ int noncached_init(void)
 
 	debug("mapping memory %pa-%pa non-cached\n", &start, &end);
 
+	noncached_granules = size / NONCACHED_GRANULE;
+	noncached_used = calloc(BITS_TO_LONGS(noncached_granules), sizeof(long));
+	noncached_first = calloc(BITS_TO_LONGS(noncached_granules),
+				 sizeof(long));
+	if (!noncached_used || !noncached_first)
+		return -ENOMEM;
 	noncached_start = start;
 	noncached_end = end;
-	noncached_next = start;
 
 	noncached_set_region();
 
@@ -108,15 +124,55 @@ int noncached_init(void)
 
 phys_addr_t noncached_alloc(size_t size, size_t align)
 {
-	phys_addr_t next = ALIGN(noncached_next, align);
+	ulong count = DIV_ROUND_UP(size, NONCACHED_GRANULE);
+	ulong step = DIV_ROUND_UP(align, NONCACHED_GRANULE) ?: 1;
+	phys_addr_t addr;
+	ulong i, j;
+
+	if (!noncached_used || !count)
+		return 0;
 
-	if (next >= noncached_end || (noncached_end - next) < size)
+	/* The area is section-aligned, so aligning the granule is enough */
+	for (i = 0; i + count <= noncached_granules; i += step) {
+		for (j = 0; j < count && !test_bit(i + j, noncached_used); j++)
+			;
+		if (j == count)
+			break;
+	}
+	if (i + count > noncached_granules)
 		return 0;
+	bitmap_set(noncached_used, i, count);
+	set_bit(i, noncached_first);
+	addr = noncached_start + i * NONCACHED_GRANULE;
+
+	debug("allocated %zu bytes of uncached memory @%pa\n", size, &addr);
 
-	debug("allocated %zu bytes of uncached memory @%pa\n", size, &next);
-	noncached_next = next + size;
+	return addr;
+}
 
-	return next;
+void noncached_free(phys_addr_t addr)
+{
+	ulong i, first;
+
+	if (!noncached_contains(addr))
+		return;
+	first = (addr - noncached_start) / NONCACHED_GRANULE;
+	if (!test_bit(first, noncached_first)) {
+		log_err("Freeing %pa which is not a non-cached allocation\n",
+			&addr);
+		return;
+	}
+	clear_bit(first, noncached_first);
+	for (i = first; i < noncached_granules &&
+	     test_bit(i, noncached_used) &&
+	     (i == first || !test_bit(i, noncached_first)); i++)
+		clear_bit(i, noncached_used);
+}
+
+bool noncached_contains(phys_addr_t addr)
+{
+	return noncached_used && addr >= noncached_start &&
+		addr < noncached_end;
 }
 #endif /* CONFIG_SYS_NONCACHED_MEMORY */
 
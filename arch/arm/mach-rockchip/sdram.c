@@ -5,6 +5,7 @@
 
 #include <config.h>
 #include <dm.h>
+#include <handoff.h>
 #include <init.h>
 #include <log.h>
 #include <ram.h>
@@ -292,6 +293,15 @@ int dram_init_banksize(void)
 	size_t ram_top = (unsigned long)(gd->ram_size + CFG_SYS_SDRAM_BASE);
 	size_t top = min((unsigned long)ram_top, (unsigned long)(gd->ram_top));
 
+#if CONFIG_IS_ENABLED(HANDOFF) && !defined(CONFIG_XPL_BUILD)
+	struct spl_handoff *ho = handoff_get();
+
+	if (ho && ho->ram_bank[0].size) {
+		handoff_load_dram_banks(ho);
+		return 0;
+	}
+#endif
+
 #ifdef CONFIG_ARM64
 	int ret = rockchip_dram_init_banksize();
 
@@ -466,6 +476,16 @@ int dram_init(void)
 	struct udevice *dev;
 	int ret;
 
+#if CONFIG_IS_ENABLED(HANDOFF) && !defined(CONFIG_XPL_BUILD)
+	/* SPL has already sized DRAM, so there is no need to probe again */
+	struct spl_handoff *ho = handoff_get();
+
+	if (ho && ho->ram_size) {
+		handoff_load_dram_size(ho);
+		return 0;
+	}
+#endif
+
 	ret = uclass_get_device(UCLASS_RAM, 0, &dev);
 	if (ret) {
 		debug("DRAM init failed: %d\n", ret);
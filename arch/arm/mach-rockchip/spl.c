@@ -3,6 +3,7 @@
  * (C) Copyright 2019 Rockchip Electronics Co., Ltd
  */
 
+#include <bootcount.h>
 #include <cpu_func.h>
 #include <debug_uart.h>
 #include <dm.h>
@@ -15,6 +16,7 @@
 #include <asm/arch-rockchip/bootrom.h>
 #include <asm/arch-rockchip/timer.h>
 #include <asm/global_data.h>
+#include <asm/gpio.h>
 #include <asm/io.h>
 #include <linux/bitops.h>
 
@@ -80,6 +82,36 @@ u32 spl_mmc_boot_mode(struct mmc *mmc, const u32 boot_device)
 	return MMCSD_MODE_RAW;
 }
 
+#if CONFIG_IS_ENABLED(OS_BOOT)
+/*
+ * Go straight to Linux unless asked not to: either by a button given as
+ * /options/u-boot/falcon-fallback-gpios or because the kernel failed to boot
+ * often enough to exceed the bootcount limit.
+ */
+int spl_start_uboot(void)
+{
+#if CONFIG_IS_ENABLED(DM_GPIO)
+	struct gpio_desc gpio;
+	ofnode node;
+
+	node = ofnode_path("/options/u-boot");
+	if (ofnode_valid(node) &&
+	    !gpio_request_by_name_nodev(node, "falcon-fallback-gpios", 0, &gpio,
+					GPIOD_IS_IN)) {
+		int val = dm_gpio_get_value(&gpio);
+
+		dm_gpio_free(NULL, &gpio);
+		if (val > 0) {
+			puts("Falcon fallback button pressed, starting U-Boot\n");
+			return 1;
+		}
+	}
+#endif
+
+	return bootcount_error();
+}
+#endif
+
 __weak int board_early_init_f(void)
 {
 	return 0;
@@ -439,3 +439,9 @@ int sandbox_load_other_fdt(void **fdtp, int *sizep)
 
 	return 0;
 }
+
+int initjmp(jmp_buf jmp, void __noreturn (*func)(void), void *stack_base,
+	    size_t stack_sz)
+{
+	return os_initjmp(jmp, func, stack_base, stack_sz) ? -EINVAL : 0;
+}
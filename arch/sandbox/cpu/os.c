@@ -271,10 +271,28 @@ out:
 	return ret;
 }
 
-int os_unmap(void *buf, int size)
+int os_map_fd(int fd, off_t size, int os_flags, void **bufp)
+{
+	int prot = PROT_READ;
+	void *ptr;
+
+	if (size <= 0 || (unsigned long long)size > (unsigned long long)SIZE_MAX)
+		return -EFBIG;
+	if ((os_flags & OS_O_MASK) != OS_O_RDONLY)
+		prot |= PROT_WRITE;
+
+	ptr = mmap(0, size, prot, MAP_SHARED, fd, 0);
+	if (ptr == MAP_FAILED)
+		return -errno;
+	*bufp = ptr;
+
+	return 0;
+}
+
+int os_unmap(void *buf, size_t size)
 {
 	if (munmap(buf, size)) {
-		printf("Can't unmap %p %x\n", buf, size);
+		printf("Can't unmap %p %zx\n", buf, size);
 		return -EIO;
 	}
 
@@ -384,6 +402,104 @@ int os_setup_signal_handlers(void)
 	return 0;
 }
 
+static void os_prof_handler(int sig, siginfo_t *info, void *con)
+{
+	ucontext_t __maybe_unused *context = con;
+	unsigned long pc, fp, sp;
+
+#if defined(__x86_64__)
+	pc = context->uc_mcontext.gregs[REG_RIP];
+	fp = context->uc_mcontext.gregs[REG_RBP];
+	sp = context->uc_mcontext.gregs[REG_RSP];
+#elif defined(__aarch64__)
+	pc = context->uc_mcontext.pc;
+	fp = context->uc_mcontext.regs[29];
+	sp = context->uc_mcontext.sp;
+#elif defined(__riscv)
+	/* The frame record is below the frame pointer, so is not used */
+	pc = context->uc_mcontext.__gregs[REG_PC];
+	fp = 0;
+	sp = context->uc_mcontext.__gregs[REG_SP];
+#else
+	return;
+#endif
+
+	os_prof_action(pc, fp, sp);
+}
+
+int os_prof_timer(unsigned int hz, unsigned long *stack_top)
+{
+	struct itimerval timer = {};
+	struct sigaction act;
+	pthread_attr_t attr;
+	size_t size;
+	void *addr;
+	int ret;
+
+	if (hz) {
+		if (pthread_getattr_np(pthread_self(), &attr))
+			return -1;
+		ret = pthread_attr_getstack(&attr, &addr, &size);
+		pthread_attr_destroy(&attr);
+		if (ret)
+			return -1;
+		*stack_top = (unsigned long)addr + size;
+
+		act.sa_sigaction = os_prof_handler;
+		sigemptyset(&act.sa_mask);
+		act.sa_flags = SA_SIGINFO | SA_RESTART;
+		if (sigaction(SIGPROF, &act, NULL))
+			return -1;
+		timer.it_interval.tv_usec = hz < 1000000 ? 1000000 / hz : 1;
+		timer.it_value = timer.it_interval;
+	}
+
+	return setitimer(ITIMER_PROF, &timer, NULL) ? -1 : 0;
+}
+
+static struct {
+	jmp_buf *jmp;
+	void (*func)(void);
+} os_initjmp_state;
+
+static void os_initjmp_handler(int sig)
+{
+	void (*volatile func)(void) = os_initjmp_state.func;
+
+	/* Return from the signal; a longjmp() to the buffer gets back here */
+	if (!setjmp(*os_initjmp_state.jmp))
+		return;
+	func();
+}
+
+int os_initjmp(void *jmp, void (*func)(void), void *stack_base,
+	       size_t stack_size)
+{
+	struct sigaction act, old_act;
+	stack_t ss, old_ss;
+	int ret;
+
+	ss.ss_sp = stack_base;
+	ss.ss_size = stack_size;
+	ss.ss_flags = 0;
+	if (sigaltstack(&ss, &old_ss))
+		return -1;
+
+	act.sa_handler = os_initjmp_handler;
+	sigemptyset(&act.sa_mask);
+	act.sa_flags = SA_ONSTACK;
+	ret = sigaction(SIGUSR2, &act, &old_act);
+	if (!ret) {
+		os_initjmp_state.jmp = jmp;
+		os_initjmp_state.func = func;
+		ret = raise(SIGUSR2);
+		sigaction(SIGUSR2, &old_act, NULL);
+	}
+	sigaltstack(&old_ss, NULL);
+
+	return ret ? -1 : 0;
+}
+
 /* Put tty into raw mode so <tab> and <ctrl+c> work */
 void os_tty_raw(int fd, bool allow_sigs)
 {
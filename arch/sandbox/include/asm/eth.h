@@ -108,4 +108,12 @@ void sandbox_eth_set_tx_handler(int index, sandbox_eth_tx_hand_f *handler);
  */
 void sandbox_eth_set_priv(int index, void *priv);
 
+/*
+ * Set the checksum offload the device claims to support
+ *
+ * index - interface to set the offload for
+ * flags - ETH_CSUM_... flags, 0 for none
+ */
+void sandbox_eth_set_csum_offload(int index, unsigned int flags);
+
 #endif /* __ETH_H */
@@ -8,9 +8,11 @@
 #include <efi_loader.h>
 #include <irq_func.h>
 #include <os.h>
+#include <trace.h>
 #include <asm/global_data.h>
 #include <asm-generic/signal.h>
 #include <asm/u-boot-sandbox.h>
+#include <linux/errno.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -28,6 +30,22 @@ int disable_interrupts(void)
 	return 0;
 }
 
+void os_prof_action(unsigned long pc, unsigned long fp, unsigned long sp)
+{
+	if (CONFIG_IS_ENABLED(TRACE_SAMPLE))
+		trace_sample_record(pc, fp, sp);
+}
+
+int arch_trace_sample_start(unsigned int hz, unsigned long *stack_top)
+{
+	return os_prof_timer(hz, stack_top) ? -EIO : 0;
+}
+
+void arch_trace_sample_stop(void)
+{
+	os_prof_timer(0, NULL);
+}
+
 void os_signal_action(int sig, unsigned long pc)
 {
 	efi_restore_gd();
@@ -4,13 +4,24 @@
  */
 
 #include <fdtdec.h>
+#include <fdt_simplefb.h>
 #include <fdt_support.h>
+#include <video.h>
 
 #ifdef CONFIG_OF_BOARD_SETUP
 int ft_board_setup(void *blob, struct bd_info *bd)
 {
 	if (IS_ENABLED(CONFIG_TYPEC_FUSB302))
 		fdt_status_okay_by_compatible(blob, "fcs,fusb302");
+
+	/* Let the OS keep showing the splash until its own driver is up */
+	if (IS_ENABLED(CONFIG_FDT_SIMPLEFB) && video_is_active()) {
+		if (fdt_node_offset_by_compatible(blob, -1,
+						  "simple-framebuffer") < 0)
+			fdt_simplefb_add_node(blob);
+		fdt_simplefb_enable_and_mem_rsv(blob);
+	}
+
 	return 0;
 }
 #endif
@@ -16,6 +16,7 @@
 #include <malloc.h>
 #include <part.h>
 #include <sort.h>
+#include <task.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
 #include <dm/uclass-internal.h>
@@ -699,6 +700,144 @@ int bootdev_next_prio(struct bootflow_iter *iter, struct udevice **devp)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTD_HUNT_ASYNC)
+/**
+ * struct bootdev_bg_hunt - Hunting for bootdevs in the background
+ *
+ * While the scan looks at the bootdevs which are already known, a task runs
+ * the remaining hunters, one at a time and in the order the scan will want
+ * them. When the scan needs a hunter it waits for the task to finish the one
+ * it is running, then holds the task off while it runs the hunter itself, if
+ * that is still needed. So at most one hunter runs at a time, as before.
+ *
+ * @task: Task which runs the hunters
+ * @labels: Labels to hunt for, in order, or NULL to hunt in priority order
+ * @active: true from when @task is started until it is joined
+ * @stop: true to stop @task before it starts another hunter
+ * @hold: Number of hunters being run outside @task, which must not start
+ *	another one until this is 0
+ * @cur: Sequence number of the hunter being run by @task, or -1 if none
+ */
+static struct bootdev_bg_hunt {
+	struct task task;
+	const char *const *labels;
+	bool active;
+	bool stop;
+	int hold;
+	int cur;
+} bg_hunt;
+
+static bool bootdev_bg_hunt_hold(void)
+{
+	if (!bg_hunt.active || task_current() == &bg_hunt.task)
+		return false;
+
+	/* don't use the hardware while the task is using it */
+	bg_hunt.hold++;
+	while (bg_hunt.cur != -1)
+		task_yield();
+
+	return true;
+}
+
+static void bootdev_bg_hunt_release(void)
+{
+	bg_hunt.hold--;
+}
+
+static int bootdev_hunt_drv(struct bootdev_hunter *info, uint seq, bool show);
+static bool bootdev_hunter_match(struct bootdev_hunter *info,
+				 const char *spec);
+
+static int bootdev_bg_hunt_one(struct bootdev_hunter *info, uint seq)
+{
+	while (bg_hunt.hold && !bg_hunt.stop)
+		task_yield();
+	if (bg_hunt.stop)
+		return -EINTR;
+
+	/* an error is reported when the scan runs this hunter itself */
+	bg_hunt.cur = seq;
+	bootdev_hunt_drv(info, seq, false);
+	bg_hunt.cur = -1;
+
+	return 0;
+}
+
+static int bootdev_bg_hunt_run(void *arg)
+{
+	struct bootdev_hunter *start;
+	int n_ent, prio, i;
+
+	start = ll_entry_start(struct bootdev_hunter, bootdev_hunter);
+	n_ent = ll_entry_count(struct bootdev_hunter, bootdev_hunter);
+	if (bg_hunt.labels) {
+		const char *const *labelp;
+
+		for (labelp = bg_hunt.labels; *labelp; labelp++) {
+			for (i = 0; i < n_ent; i++) {
+				if (!bootdev_hunter_match(start + i, *labelp))
+					continue;
+				if (bootdev_bg_hunt_one(start + i, i))
+					return 0;
+			}
+		}
+	} else {
+		for (prio = BOOTDEVP_1_PRE_SCAN + 1; prio < BOOTDEVP_COUNT;
+		     prio++) {
+			for (i = 0; i < n_ent; i++) {
+				if (start[i].prio != prio)
+					continue;
+				if (bootdev_bg_hunt_one(start + i, i))
+					return 0;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void bootdev_bg_hunt_start(const char *const *labels)
+{
+	int ret;
+
+	bg_hunt.labels = labels;
+	bg_hunt.stop = false;
+	bg_hunt.hold = 0;
+	bg_hunt.cur = -1;
+	ret = task_start(&bg_hunt.task, "bootdev_hunt", bootdev_bg_hunt_run,
+			 NULL, 0);
+	if (ret) {
+		/* the scan runs the hunters itself, as it goes */
+		log_debug("Cannot start hunting task (err=%d)\n", ret);
+		return;
+	}
+	bg_hunt.active = true;
+}
+
+void bootdev_hunt_stop(void)
+{
+	if (!bg_hunt.active)
+		return;
+	bg_hunt.stop = true;
+	task_join(&bg_hunt.task);
+	bg_hunt.active = false;
+}
+#else
+static inline bool bootdev_bg_hunt_hold(void)
+{
+	return false;
+}
+
+static inline void bootdev_bg_hunt_release(void)
+{
+}
+
+static inline void bootdev_bg_hunt_start(const char *const *labels)
+{
+}
+#endif
+
 int bootdev_setup_iter(struct bootflow_iter *iter, const char *label,
 		       struct udevice **devp, int *method_flagsp)
 {
@@ -742,6 +881,9 @@ int bootdev_setup_iter(struct bootflow_iter *iter, const char *label,
 		return log_msg_ret("std", ret);
 	}
 
+	/* the labels from a previous scan are about to be freed */
+	bootdev_hunt_stop();
+
 	/* hunt for any pre-scan devices */
 	if (iter->flags & BOOTFLOWIF_HUNT) {
 		ret = bootdev_hunt_prio(BOOTDEVP_1_PRE_SCAN, show);
@@ -787,6 +929,10 @@ int bootdev_setup_iter(struct bootflow_iter *iter, const char *label,
 		if (!dev)
 			return log_msg_ret("fin", -ENOENT);
 		log_debug("Selected bootdev: %s\n", dev->name);
+
+		/* hunt for the rest while the scan looks at this one */
+		if (iter->flags & BOOTFLOWIF_HUNT)
+			bootdev_bg_hunt_start(iter->labels);
 	}
 
 	ret = device_probe(dev);
@@ -803,12 +949,18 @@ static int bootdev_hunt_drv(struct bootdev_hunter *info, uint seq, bool show)
 {
 	const char *name = uclass_get_name(info->uclass);
 	struct bootstd_priv *std;
+	bool held;
 	int ret;
 
 	ret = bootstd_get_priv(&std);
 	if (ret)
 		return log_msg_ret("std", ret);
 
+	if (std->hunters_used & BIT(seq))
+		return 0;
+
+	/* the background task may have run this hunter while we waited */
+	held = bootdev_bg_hunt_hold();
 	if (!(std->hunters_used & BIT(seq))) {
 		if (show)
 			printf("Hunting with: %s\n",
@@ -817,45 +969,61 @@ static int bootdev_hunt_drv(struct bootdev_hunter *info, uint seq, bool show)
 		if (info->hunt) {
 			ret = info->hunt(info, show);
 			log_debug("  - hunt result %d\n", ret);
-			if (ret && ret != -ENOENT)
-				return ret;
 		}
-		std->hunters_used |= BIT(seq);
+		if (!ret || ret == -ENOENT) {
+			std->hunters_used |= BIT(seq);
+			ret = 0;
+		}
 	}
+	if (held)
+		bootdev_bg_hunt_release();
 
-	return 0;
+	return ret;
+}
+
+/**
+ * bootdev_hunter_match() - Check whether a hunter is needed for a label
+ *
+ * @info: Hunter to check
+ * @spec: Label to check (e.g. "mmc1"), or NULL to match any hunter
+ * Return: true if @info hunts for bootdevs of @spec
+ */
+static bool bootdev_hunter_match(struct bootdev_hunter *info, const char *spec)
+{
+	const char *name = uclass_get_name(info->uclass);
+	const char *end;
+	size_t len;
+
+	if (!spec)
+		return true;
+	trailing_strtoln_end(spec, NULL, &end);
+	len = end - spec;
+
+	log_debug("looking at %.*s for %s\n",
+		  (int)max(strlen(name), len), spec, name);
+	if (!strncmp(spec, name, max(strlen(name), len)))
+		return true;
+
+	return info->uclass == UCLASS_ETH &&
+		(!strcmp("dhcp", spec) || !strcmp("pxe", spec));
 }
 
 int bootdev_hunt(const char *spec, bool show)
 {
 	struct bootdev_hunter *start;
-	const char *end;
 	int n_ent, i;
 	int result;
-	size_t len;
 
 	start = ll_entry_start(struct bootdev_hunter, bootdev_hunter);
 	n_ent = ll_entry_count(struct bootdev_hunter, bootdev_hunter);
 	result = 0;
 
-	len = SIZE_MAX;
-	if (spec) {
-		trailing_strtoln_end(spec, NULL, &end);
-		len = end - spec;
-	}
-
 	for (i = 0; i < n_ent; i++) {
 		struct bootdev_hunter *info = start + i;
-		const char *name = uclass_get_name(info->uclass);
 		int ret;
 
-		log_debug("looking at %.*s for %s\n",
-			  (int)max(strlen(name), len), spec, name);
-		if (spec && strncmp(spec, name, max(strlen(name), len))) {
-			if (info->uclass != UCLASS_ETH ||
-			    (strcmp("dhcp", spec) && strcmp("pxe", spec)))
-				continue;
-		}
+		if (!bootdev_hunter_match(info, spec))
+			continue;
 		ret = bootdev_hunt_drv(info, i, show);
 		if (ret)
 			result = ret;
@@ -11,9 +11,12 @@
 #include <bootmeth.h>
 #include <bootstd.h>
 #include <dm.h>
+#include <env.h>
 #include <env_internal.h>
 #include <malloc.h>
+#include <part.h>
 #include <serial.h>
+#include <vsprintf.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
 
@@ -96,6 +99,7 @@ void bootflow_iter_init(struct bootflow_iter *iter, int flags)
 
 void bootflow_iter_uninit(struct bootflow_iter *iter)
 {
+	bootdev_hunt_stop();
 	free(iter->method_order);
 }
 
@@ -500,6 +504,155 @@ int bootflow_read_all(struct bootflow *bflow)
 }
 #endif /* BOOTSTD_FULL */
 
+#if CONFIG_IS_ENABLED(BOOTSTD_LAST_BOOTFLOW)
+/* fields of the bootflow_last environment variable */
+enum {
+	LAST_BOOTDEV,
+	LAST_PART,
+	LAST_BOOTMETH,
+	LAST_PRIO,
+	LAST_UUID,
+
+	LAST_COUNT,
+};
+
+/**
+ * bootflow_part_uuid() - Get the UUID of the partition a bootflow is in
+ *
+ * @bflow: Bootflow to check
+ * @buf: Returns the UUID, or "-" if there is none
+ * @size: Size of @buf
+ */
+static void bootflow_part_uuid(struct bootflow *bflow, char *buf, int size)
+{
+	struct disk_partition info;
+
+	strlcpy(buf, "-", size);
+	if (!IS_ENABLED(CONFIG_PARTITION_UUIDS) || !bflow->blk || !bflow->part)
+		return;
+	if (part_get_info(dev_get_uclass_plat(bflow->blk), bflow->part, &info))
+		return;
+	if (*disk_partition_uuid(&info))
+		strlcpy(buf, disk_partition_uuid(&info), size);
+}
+
+/**
+ * bootflow_save_last() - Record a bootflow which is about to be booted
+ *
+ * This sets bootflow_last to "<bootdev> <part> <bootmeth> <prio> <uuid>" and
+ * saves the environment if that has changed, so that the next boot can try
+ * the same bootflow before scanning
+ *
+ * @bflow: Bootflow to record
+ */
+static void bootflow_save_last(struct bootflow *bflow)
+{
+	struct bootdev_uc_plat *ucp;
+	char uuid[UUID_STR_LEN + 1];
+	const char *old;
+	char buf[200];
+
+	/* global bootmeths choose their own bootdev */
+	if (!bflow->dev)
+		return;
+	ucp = dev_get_uclass_plat(bflow->dev);
+	bootflow_part_uuid(bflow, uuid, sizeof(uuid));
+	snprintf(buf, sizeof(buf), "%s %x %s %d %s", bflow->dev->name,
+		 bflow->part, bflow->method->name, ucp->prio, uuid);
+
+	old = env_get("bootflow_last");
+	if (old && !strcmp(old, buf))
+		return;
+	if (env_set("bootflow_last", buf))
+		return;
+	if (IS_ENABLED(CONFIG_CMD_SAVEENV) && env_save())
+		log_warning("Cannot save bootflow_last\n");
+}
+
+int bootflow_scan_last(struct bootflow_iter *iter, int flags,
+		       struct bootflow *bflow)
+{
+	struct udevice *dev, *meth;
+	char uuid[UUID_STR_LEN + 1];
+	const char **fields;
+	const char *val;
+	int ret, i;
+
+	bootflow_iter_init(iter, flags | BOOTFLOWIF_SKIP_GLOBAL |
+			   BOOTFLOWIF_SINGLE_DEV | BOOTFLOWIF_SINGLE_PARTITION);
+	val = env_get("bootflow_last");
+	if (!val)
+		return log_msg_ret("env", -ENOENT);
+	fields = str_to_list(val);
+	if (!fields)
+		return log_msg_ret("lis", -ENOMEM);
+	for (i = 0; i < LAST_COUNT && fields[i]; i++)
+		;
+	if (i != LAST_COUNT) {
+		ret = log_msg_ret("fmt", -EINVAL);
+		goto err;
+	}
+
+	ret = uclass_get_device_by_name(UCLASS_BOOTMETH, fields[LAST_BOOTMETH],
+					&meth);
+	if (ret) {
+		ret = log_msg_ret("meth", ret);
+		goto err;
+	}
+	iter->method_order = calloc(1, sizeof(struct udevice *));
+	if (!iter->method_order) {
+		ret = log_msg_ret("ord", -ENOMEM);
+		goto err;
+	}
+	iter->method_order[0] = meth;
+	iter->num_methods = 1;
+	iter->method = meth;
+
+	/* the bootdev may only appear once its hunter has run */
+	ret = uclass_get_device_by_name(UCLASS_BOOTDEV, fields[LAST_BOOTDEV],
+					&dev);
+	if (ret && (flags & BOOTFLOWIF_HUNT)) {
+		bootdev_hunt_prio(dectoul(fields[LAST_PRIO], NULL),
+				  flags & BOOTFLOWIF_SHOW);
+		ret = uclass_get_device_by_name(UCLASS_BOOTDEV,
+						fields[LAST_BOOTDEV], &dev);
+	}
+	if (ret) {
+		ret = log_msg_ret("dev", ret);
+		goto err;
+	}
+	iter->part = hextoul(fields[LAST_PART], NULL);
+	bootflow_iter_set_dev(iter, dev, 0);
+
+	ret = bootflow_check(iter, bflow);
+	if (ret) {
+		bootflow_free(bflow);
+		ret = log_msg_ret("chk", ret);
+		goto err;
+	}
+
+	/* make sure this is still the same partition */
+	bootflow_part_uuid(bflow, uuid, sizeof(uuid));
+	if (strcmp(uuid, fields[LAST_UUID])) {
+		bootflow_free(bflow);
+		ret = log_msg_ret("uui", -ESTALE);
+		goto err;
+	}
+	str_free_list(fields);
+
+	return 0;
+
+err:
+	str_free_list(fields);
+
+	return ret;
+}
+#else
+static inline void bootflow_save_last(struct bootflow *bflow)
+{
+}
+#endif
+
 int bootflow_boot(struct bootflow *bflow)
 {
 	int ret;
@@ -507,6 +660,10 @@ int bootflow_boot(struct bootflow *bflow)
 	if (bflow->state != BOOTFLOWST_READY)
 		return log_msg_ret("load", -EPROTO);
 
+	/* don't leave a hunter part-way through while the OS starts */
+	bootdev_hunt_stop();
+	bootflow_save_last(bflow);
+
 	ret = bootmeth_boot(bflow->method, bflow);
 	if (ret)
 		return log_msg_ret("boot", ret);
@@ -388,7 +388,6 @@ int bootmeth_common_read_file(struct udevice *dev, struct bootflow *bflow,
 {
 	struct blk_desc *desc = NULL;
 	loff_t len_read;
-	loff_t size;
 	int ret;
 
 	if (bflow->blk)
@@ -398,17 +397,10 @@ int bootmeth_common_read_file(struct udevice *dev, struct bootflow *bflow,
 	if (ret)
 		return log_msg_ret("fs", ret);
 
-	ret = fs_size(file_path, &size);
-	if (ret)
-		return log_msg_ret("size", ret);
-	if (size > *sizep)
-		return log_msg_ret("spc", -ENOSPC);
-
-	ret = bootmeth_setup_fs(bflow, desc);
-	if (ret)
-		return log_msg_ret("fs", ret);
-
-	ret = fs_read(file_path, addr, 0, 0, &len_read);
+	/* check the size and read with one setup of the filesystem */
+	ret = fs_read_max(file_path, addr, *sizep, &len_read);
+	if (ret == -ENOSPC)
+		return log_msg_ret("spc", ret);
 	if (ret)
 		return ret;
 	*sizep = len_read;
@@ -320,10 +320,11 @@ static int android_read_file(struct udevice *dev, struct bootflow *bflow,
  * @name: Partition name to read
  * @slot: Nul-terminated slot suffixed to partition name ("a\0" or "b\0")
  * @addr: Address where the partition content is loaded into
+ * @sizep: Returns the number of bytes loaded
  * Return: 0 if OK, negative errno on failure.
  */
 static int read_slotted_partition(struct blk_desc *desc, const char *const name,
-				  const char slot[2], ulong addr)
+				  const char slot[2], ulong addr, ulong *sizep)
 {
 	struct disk_partition partition;
 	char partname[PART_NAME_LEN];
@@ -342,6 +343,7 @@ static int read_slotted_partition(struct blk_desc *desc, const char *const name,
 	n = blk_dread(desc, partition.start, partition.size, map_sysmem(addr, 0));
 	if (n < partition.size)
 		return log_msg_ret("part read", -EIO);
+	*sizep = partition.size * desc->blksz;
 
 	return 0;
 }
@@ -376,19 +378,34 @@ static int avb_append_commandline(struct bootflow *bflow, char *cmdline)
 	return 0;
 }
 
-static int run_avb_verification(struct bootflow *bflow)
+/**
+ * run_avb_verification() - Verify the boot images with AVB
+ *
+ * The boot and vendor_boot partitions have already been loaded, so AVB hashes
+ * them where they are instead of reading them again.
+ *
+ * @bflow: Bootflow being booted
+ * @parts: Names of the loaded partitions, without the slot suffix, ending
+ *	with NULL
+ * @addrs: Addresses the partitions are loaded at
+ * @sizes: Number of bytes loaded for each partition
+ * Return: 0 if OK, negative errno on failure.
+ */
+static int run_avb_verification(struct bootflow *bflow,
+				const char * const parts[], const ulong addrs[],
+				const ulong sizes[])
 {
 	struct blk_desc *desc = dev_get_uclass_plat(bflow->blk);
 	struct android_priv *priv = bflow->bootmeth_priv;
-	const char * const requested_partitions[] = {"boot", "vendor_boot"};
 	struct AvbOps *avb_ops;
 	AvbSlotVerifyResult result;
 	AvbSlotVerifyData *out_data;
 	enum avb_boot_state boot_state;
+	char partname[PART_NAME_LEN];
 	char *extra_args;
 	char slot_suffix[3];
 	bool unlocked = false;
-	int ret;
+	int i, ret;
 
 	avb_ops = avb_ops_alloc(desc->devnum);
 	if (!avb_ops)
@@ -396,12 +413,22 @@ static int run_avb_verification(struct bootflow *bflow)
 
 	sprintf(slot_suffix, "_%s", priv->slot);
 
+	for (i = 0; parts[i]; i++) {
+		snprintf(partname, sizeof(partname), "%s%s", parts[i],
+			 slot_suffix);
+		ret = avb_add_preloaded_partition(avb_ops, partname,
+						  map_sysmem(addrs[i], 0),
+						  sizes[i]);
+		if (ret)
+			return log_msg_ret("avb preload", ret);
+	}
+
 	ret = avb_ops->read_is_device_unlocked(avb_ops, &unlocked);
 	if (ret != AVB_IO_RESULT_OK)
 		return log_msg_ret("avb lock", -EIO);
 
 	result = avb_slot_verify(avb_ops,
-				 requested_partitions,
+				 parts,
 				 slot_suffix,
 				 unlocked,
 				 AVB_HASHTREE_ERROR_MODE_RESTART_AND_INVALIDATE,
@@ -440,7 +467,9 @@ static int run_avb_verification(struct bootflow *bflow)
 	return log_msg_ret("avb cmdline", ret);
 }
 #else
-static int run_avb_verification(struct bootflow *bflow)
+static int run_avb_verification(struct bootflow *bflow,
+				const char * const parts[], const ulong addrs[],
+				const ulong sizes[])
 {
 	int ret;
 
@@ -462,23 +491,29 @@ static int boot_android_normal(struct bootflow *bflow)
 	int ret;
 	ulong loadaddr = env_get_hex("loadaddr", 0);
 	ulong vloadaddr = env_get_hex("vendor_boot_comp_addr_r", 0);
+	const char * const parts[] = {"boot", "vendor_boot", NULL};
+	const ulong addrs[] = {loadaddr, vloadaddr};
+	ulong sizes[2];
 
-	ret = run_avb_verification(bflow);
+	/* Load the images first so that AVB can verify them in place */
+	ret = read_slotted_partition(desc, "boot", priv->slot, loadaddr,
+				     &sizes[0]);
 	if (ret < 0)
-		return log_msg_ret("avb", ret);
+		return log_msg_ret("read boot", ret);
 
-	/* Read slot once more to decrement counter from BCB */
-	ret = android_read_slot_from_bcb(bflow, true);
+	ret = read_slotted_partition(desc, "vendor_boot", priv->slot, vloadaddr,
+				     &sizes[1]);
 	if (ret < 0)
-		return log_msg_ret("read slot", ret);
+		return log_msg_ret("read vendor_boot", ret);
 
-	ret = read_slotted_partition(desc, "boot", priv->slot, loadaddr);
+	ret = run_avb_verification(bflow, parts, addrs, sizes);
 	if (ret < 0)
-		return log_msg_ret("read boot", ret);
+		return log_msg_ret("avb", ret);
 
-	ret = read_slotted_partition(desc, "vendor_boot", priv->slot, vloadaddr);
+	/* Read slot once more to decrement counter from BCB */
+	ret = android_read_slot_from_bcb(bflow, true);
 	if (ret < 0)
-		return log_msg_ret("read vendor_boot", ret);
+		return log_msg_ret("read slot", ret);
 
 	set_abootimg_addr(loadaddr);
 	set_avendor_bootimg_addr(vloadaddr);
@@ -196,6 +196,23 @@ int expo_render(struct expo *exp)
 
 	back = CONFIG_IS_ENABLED(SYS_WHITE_ON_BLACK) ? VID_BLACK : VID_WHITE;
 	colour = video_index_to_colour(vid_priv, back);
+
+	/* only redraw what has changed, if the scene is already shown */
+	if (IS_ENABLED(CONFIG_EXPO_PARTIAL_REDRAW) && exp->scene_id &&
+	    exp->scene_id == exp->drawn_id && !exp->text_mode) {
+		scn = expo_lookup_scene_id(exp, exp->scene_id);
+		if (!scn)
+			return log_msg_ret("scp", -ENOENT);
+
+		ret = scene_render_partial(scn, colour);
+		if (ret)
+			return log_msg_ret("rep", ret);
+		video_sync(dev, true);
+
+		return 0;
+	}
+	exp->drawn_id = 0;
+
 	ret = video_fill(dev, colour);
 	if (ret)
 		return log_msg_ret("fill", ret);
@@ -208,6 +225,8 @@ int expo_render(struct expo *exp)
 		ret = scene_render(scn);
 		if (ret)
 			return log_msg_ret("ren", ret);
+		if (!exp->text_mode)
+			exp->drawn_id = scn->id;
 	}
 
 	video_sync(dev, true);
@@ -215,6 +234,11 @@ int expo_render(struct expo *exp)
 	return scn ? 0 : -ECHILD;
 }
 
+void expo_redraw(struct expo *exp)
+{
+	exp->drawn_id = 0;
+}
+
 int expo_send_key(struct expo *exp, int key)
 {
 	struct scene *scn = NULL;
@@ -14,6 +14,7 @@
 #include <linux/libfdt.h>
 
 #define ANDROID_IMAGE_DEFAULT_KERNEL_ADDR	0x10008000
+#define ANDROID_IMAGE_DEFAULT_RAMDISK_ADDR	0x11000000
 
 static char andr_tmp_str[ANDR_BOOT_ARGS_SIZE + 1];
 
@@ -384,6 +385,16 @@ ulong android_image_get_kcomp(const void *hdr,
 		return image_decomp_type(p, sizeof(u32));
 }
 
+/*
+ * Move one part of the ramdisk to where it is needed, unless it was loaded
+ * there already
+ */
+static void android_ramdisk_place(ulong dest, ulong src, ulong size)
+{
+	if (dest != src && size)
+		memmove((void *)dest, (void *)src, size);
+}
+
 int android_image_get_ramdisk(const void *hdr, const void *vendor_boot_img,
 			      ulong *rd_data, ulong *rd_len)
 {
@@ -398,21 +409,24 @@ int android_image_get_ramdisk(const void *hdr, const void *vendor_boot_img,
 
 	if (img_data.header_version > 2) {
 		ramdisk_ptr = img_data.ramdisk_addr;
-		memcpy((void *)(ramdisk_ptr), (void *)img_data.vendor_ramdisk_ptr,
-		       img_data.vendor_ramdisk_size);
+		android_ramdisk_place(ramdisk_ptr, img_data.vendor_ramdisk_ptr,
+				      img_data.vendor_ramdisk_size);
 		ramdisk_ptr += img_data.vendor_ramdisk_size;
-		memcpy((void *)(ramdisk_ptr), (void *)img_data.ramdisk_ptr,
-		       img_data.boot_ramdisk_size);
+		android_ramdisk_place(ramdisk_ptr, img_data.ramdisk_ptr,
+				      img_data.boot_ramdisk_size);
 		ramdisk_ptr += img_data.boot_ramdisk_size;
-		if (img_data.bootconfig_size) {
-			memcpy((void *)
-			       (ramdisk_ptr), (void *)img_data.bootconfig_addr,
-			       img_data.bootconfig_size);
-		}
+		android_ramdisk_place(ramdisk_ptr, img_data.bootconfig_addr,
+				      img_data.bootconfig_size);
 	} else {
-		ramdisk_ptr = img_data.ramdisk_addr;
-		memcpy((void *)(ramdisk_ptr), (void *)img_data.ramdisk_ptr,
-		       img_data.ramdisk_size);
+		/*
+		 * As with the kernel, the default address set by the Android
+		 * tools means that the ramdisk is used where it is in the image
+		 */
+		if (img_data.ramdisk_addr == ANDROID_IMAGE_DEFAULT_RAMDISK_ADDR)
+			img_data.ramdisk_addr = img_data.ramdisk_ptr;
+		android_ramdisk_place(img_data.ramdisk_addr,
+				      img_data.ramdisk_ptr,
+				      img_data.ramdisk_size);
 	}
 
 	printf("RAM disk load addr 0x%08lx size %u KiB\n",
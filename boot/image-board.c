@@ -12,6 +12,7 @@
 #include <bootstage.h>
 #include <cpu_func.h>
 #include <display_options.h>
+#include <dma.h>
 #include <env.h>
 #include <fpga.h>
 #include <image.h>
@@ -179,7 +180,7 @@ void memmove_wd(void *to, void *from, size_t len, ulong chunksz)
 				to -= tail;
 				from -= tail;
 			}
-			memmove(to, from, tail);
+			dma_bulk_copy(to, from, tail);
 			if (to < from) {
 				to += tail;
 				from += tail;
@@ -187,7 +188,7 @@ void memmove_wd(void *to, void *from, size_t len, ulong chunksz)
 			len -= tail;
 		}
 	} else {
-		memmove(to, from, len);
+		dma_bulk_copy(to, from, len);
 	}
 }
 
@@ -526,6 +527,8 @@ int boot_get_ramdisk(char const *select, struct bootm_headers *images,
  *
  * boot_ramdisk_high() takes a relocation hint from "initrd_high" environment
  * variable and if requested ramdisk data is moved to a specified location.
+ * With CONFIG_SYS_BOOT_RAMDISK_IN_PLACE the move is skipped if the ramdisk
+ * already sits in a free, page-aligned region below initrd_high.
  *
  * Initrd_start and initrd_end are set to final (after relocation) ramdisk
  * start/end addresses if ramdisk image start and len were provided,
@@ -563,6 +566,15 @@ int boot_ramdisk_high(ulong rd_data, ulong rd_len, ulong *initrd_start,
 			*initrd_start = rd_data;
 			*initrd_end = rd_data + rd_len;
 			lmb_reserve(rd_data, rd_len);
+		} else if (IS_ENABLED(CONFIG_SYS_BOOT_RAMDISK_IN_PLACE) &&
+			   IS_ALIGNED(rd_data, 0x1000) &&
+			   (!initrd_high || rd_data + rd_len <= initrd_high) &&
+			   lmb_alloc_addr(rd_data, rd_len) == rd_data) {
+			/* already where a copy would be allowed to go */
+			*initrd_start = rd_data;
+			*initrd_end = rd_data + rd_len;
+			printf("   Using Ramdisk in place at %08lx, end %08lx\n",
+			       *initrd_start, *initrd_end);
 		} else {
 			if (initrd_high)
 				*initrd_start = (ulong)lmb_alloc_base(rd_len,
@@ -579,8 +591,8 @@ int boot_ramdisk_high(ulong rd_data, ulong rd_len, ulong *initrd_start,
 			bootstage_mark(BOOTSTAGE_ID_COPY_RAMDISK);
 
 			*initrd_end = *initrd_start + rd_len;
-			printf("   Loading Ramdisk to %08lx, end %08lx ... ",
-			       *initrd_start, *initrd_end);
+			printf("   Loading Ramdisk to %08lx, end %08lx (%lu bytes) ... ",
+			       *initrd_start, *initrd_end, rd_len);
 
 			memmove_wd((void *)*initrd_start,
 				   (void *)rd_data, rd_len, CHUNKSZ);
@@ -8,6 +8,7 @@
  * Wolfgang Denk, DENX Software Engineering, wd@denx.de.
  */
 
+#include <abuf.h>
 #include <command.h>
 #include <fdt_support.h>
 #include <fdtdec.h>
@@ -21,6 +22,7 @@
 #include <linux/libfdt.h>
 #include <mapmem.h>
 #include <asm/io.h>
+#include <of_live.h>
 #include <dm/ofnode.h>
 #include <tee/optee.h>
 
@@ -565,6 +567,69 @@ __weak int arch_fixup_fdt(void *blob)
 	return 0;
 }
 
+/**
+ * image_fdt_fixup_live() - send EVT_FT_FIXUP for a flat tree via a livetree
+ *
+ * With a live control tree the ofnode functions only operate on live trees.
+ * Build one from @blob, let the event handlers edit it and write it back to
+ * @blob in one go, so that handlers do not move the tail of the flat tree
+ * around on each change. The memory reservations of @blob are kept.
+ *
+ * @images:	images which are being booted
+ * @blob:	flat tree to fix up, which may grow up to its totalsize
+ * Return:	0 if OK, -ve on error
+ */
+static int image_fdt_fixup_live(struct bootm_headers *images, void *blob)
+{
+	struct event_ft_fixup fixup;
+	struct device_node *root;
+	int size = fdt_totalsize(blob);
+	struct abuf buf;
+	void *new;
+	int i, ret;
+
+	ret = of_live_build(blob, &root);
+	if (ret)
+		return log_msg_ret("bld", ret);
+
+	fixup.tree = oftree_from_np(root);
+	fixup.images = images;
+	abuf_init(&buf);
+	ret = event_notify(EVT_FT_FIXUP, &fixup, sizeof(fixup));
+	if (!ret)
+		ret = of_live_flatten(root, &buf);
+	/* the livetree refers to strings and values inside @blob */
+	of_live_free(root);
+	if (ret)
+		goto out;
+
+	new = malloc(size);
+	if (!new) {
+		ret = -ENOMEM;
+		goto out;
+	}
+	ret = fdt_open_into(abuf_data(&buf), new, size);
+	for (i = 0; !ret && i < fdt_num_mem_rsv(blob); i++) {
+		u64 addr, len;
+
+		ret = fdt_get_mem_rsv(blob, i, &addr, &len);
+		if (!ret)
+			ret = fdt_add_mem_rsv(new, addr, len);
+	}
+	if (ret) {
+		printf("ERROR: fixed up fdt does not fit: %s\n",
+		       fdt_strerror(ret));
+		ret = -ENOSPC;
+	} else {
+		memcpy(blob, new, size);
+	}
+	free(new);
+out:
+	abuf_uninit(&buf);
+
+	return ret;
+}
+
 int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 {
 	ulong *initrd_start = &images->initrd_start;
@@ -648,8 +713,13 @@ int image_setup_libfdt(struct bootm_headers *images, void *blob, bool lmb)
 	if (!ft_verify_fdt(blob))
 		goto err;
 
-	/* after here we are using a livetree */
-	if (!of_live_active() && CONFIG_IS_ENABLED(EVENT)) {
+	if (of_live_active() && CONFIG_IS_ENABLED(EVENT)) {
+		ret = image_fdt_fixup_live(images, blob);
+		if (ret) {
+			printf("ERROR: fdt fixup event failed: %d\n", ret);
+			goto err;
+		}
+	} else if (CONFIG_IS_ENABLED(EVENT)) {
 		struct event_ft_fixup fixup;
 
 		fixup.tree = oftree_from_fdt(blob);
@@ -62,6 +62,82 @@ struct image_region *fit_region_make_list(const void *fit,
 	return region;
 }
 
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(FIT_SIGNATURE_CACHE)
+#define FIT_SIG_CACHE_SIZE		4
+
+/**
+ * struct fit_sig_cache_entry - a configuration signature which verified ok
+ *
+ * @key_blob: Blob containing the public keys
+ * @key_node: Offset of the required key in @key_blob, or -1 for any key
+ * @checksum: Checksum algorithm of the signature
+ * @crypto: Crypto algorithm of the signature
+ * @padding: Padding algorithm of the signature
+ * @digest: Digest over the signed regions followed by the signature value
+ */
+struct fit_sig_cache_entry {
+	const void *key_blob;
+	int key_node;
+	const struct checksum_algo *checksum;
+	const struct crypto_algo *crypto;
+	const struct padding_algo *padding;
+	uint8_t digest[FIT_MAX_HASH_LEN];
+};
+
+static struct fit_sig_cache_entry fit_sig_cache[FIT_SIG_CACHE_SIZE];
+static int fit_sig_cache_next;
+
+/**
+ * fit_sig_cache_find() - look up a verified signature
+ *
+ * @info: Signature information, as set up by fit_image_setup_verify()
+ * @digest: Digest of signed regions and signature value
+ * Return: matching entry, or NULL if none
+ */
+static struct fit_sig_cache_entry *
+fit_sig_cache_find(const struct image_sign_info *info, const uint8_t *digest)
+{
+	int i;
+
+	for (i = 0; i < FIT_SIG_CACHE_SIZE; i++) {
+		struct fit_sig_cache_entry *entry = &fit_sig_cache[i];
+
+		if (entry->checksum == info->checksum &&
+		    entry->crypto == info->crypto &&
+		    entry->padding == info->padding &&
+		    entry->key_blob == info->fdt_blob &&
+		    entry->key_node == info->required_keynode &&
+		    !memcmp(entry->digest, digest,
+			    info->checksum->checksum_len))
+			return entry;
+	}
+
+	return NULL;
+}
+
+/**
+ * fit_sig_cache_add() - remember a verified signature
+ *
+ * @info: Signature information, as set up by fit_image_setup_verify()
+ * @digest: Digest of signed regions and signature value
+ */
+static void fit_sig_cache_add(const struct image_sign_info *info,
+			      const uint8_t *digest)
+{
+	struct fit_sig_cache_entry *entry;
+
+	entry = &fit_sig_cache[fit_sig_cache_next];
+	fit_sig_cache_next = (fit_sig_cache_next + 1) % FIT_SIG_CACHE_SIZE;
+
+	entry->key_blob = info->fdt_blob;
+	entry->key_node = info->required_keynode;
+	entry->checksum = info->checksum;
+	entry->crypto = info->crypto;
+	entry->padding = info->padding;
+	memcpy(entry->digest, digest, info->checksum->checksum_len);
+}
+#endif
+
 static int fit_image_setup_verify(struct image_sign_info *info,
 				  const void *fit, int noffset,
 				  const void *key_blob, int required_keynode,
@@ -371,15 +447,36 @@ static int fit_config_check_sig(const void *fit, int noffset, int conf_noffset,
 		count++;
 	}
 
-	/* Allocate the region list on the stack */
-	struct image_region region[count];
+	/*
+	 * Allocate the region list on the stack, with room for the signature
+	 * value which is appended for the cache digest
+	 */
+	struct image_region region[count + 1];
 
 	fit_region_make_list(fit, fdt_regions, count, region);
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(FIT_SIGNATURE_CACHE)
+	uint8_t digest[FIT_MAX_HASH_LEN];
+	bool cacheable;
+
+	region[count].data = fit_value;
+	region[count].size = fit_value_len;
+	cacheable = info.checksum->checksum_len <= FIT_MAX_HASH_LEN &&
+		    !info.checksum->calculate(info.checksum->name, region,
+					      count + 1, digest);
+	if (cacheable && fit_sig_cache_find(&info, digest)) {
+		debug("%s: signature verified before\n", __func__);
+		return 0;
+	}
+#endif
 	if (info.crypto->verify(&info, region, count, fit_value,
 				fit_value_len)) {
 		*err_msgp = "Verification failed";
 		return -1;
 	}
+#if !defined(USE_HOSTCC) && CONFIG_IS_ENABLED(FIT_SIGNATURE_CACHE)
+	if (cacheable)
+		fit_sig_cache_add(&info, digest);
+#endif
 
 	return 0;
 }
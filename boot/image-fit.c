@@ -1403,6 +1403,136 @@ error:
 	return 0;
 }
 
+#ifndef USE_HOSTCC
+int fit_image_hash_stream_start(const void *fit, int image_noffset,
+				const void *key_blob,
+				struct fit_hash_stream *hs)
+{
+	int noffset, key_node;
+
+	memset(hs, '\0', sizeof(*hs));
+	hs->fit = fit;
+	hs->image_noffset = image_noffset;
+
+	/* A hash device only works on the whole image */
+	if (IS_ENABLED(CONFIG_DM_HASH))
+		return -ENOTSUPP;
+
+	/* Nor do signatures, whether required or just present */
+	if (FIT_IMAGE_ENABLE_VERIFY) {
+		key_node = fdt_subnode_offset(key_blob, 0, FIT_SIG_NODENAME);
+		fdt_for_each_subnode(noffset, key_blob, key_node) {
+			const char *required;
+
+			required = fdt_getprop(key_blob, noffset,
+					       FIT_KEY_REQUIRED, NULL);
+			if (required && !strcmp(required, "image"))
+				return -ENOTSUPP;
+		}
+	}
+
+	fdt_for_each_subnode(noffset, fit, image_noffset) {
+		const char *name = fit_get_name(fit, noffset, NULL);
+		struct hash_algo *algo;
+		const char *algo_name;
+		int ignore = 0;
+
+		if (FIT_IMAGE_ENABLE_VERIFY &&
+		    !strncmp(name, FIT_SIG_NODENAME, strlen(FIT_SIG_NODENAME)))
+			goto abort;
+		if (strncmp(name, FIT_HASH_NODENAME, strlen(FIT_HASH_NODENAME)))
+			continue;
+
+		/* Leave any errors for fit_image_verify_with_data() to show */
+		if (hs->count == FIT_HASH_STREAM_MAX ||
+		    fit_image_hash_get_algo(fit, noffset, &algo_name) ||
+		    hash_progressive_lookup_algo(algo_name, &algo))
+			goto abort;
+
+		hs->noffset[hs->count] = noffset;
+		hs->algo[hs->count] = algo;
+		fit_image_hash_get_ignore(fit, noffset, &ignore);
+		if (!ignore && algo->hash_init(algo, &hs->ctx[hs->count]))
+			goto abort;
+		hs->count++;
+	}
+
+	if (noffset == -FDT_ERR_TRUNCATED || noffset == -FDT_ERR_BADSTRUCTURE)
+		goto abort;
+
+	return 0;
+
+abort:
+	while (hs->count--) {
+		u8 value[FIT_MAX_HASH_LEN];
+
+		if (hs->ctx[hs->count])
+			hs->algo[hs->count]->hash_finish(hs->algo[hs->count],
+							 hs->ctx[hs->count],
+							 value, sizeof(value));
+	}
+
+	return -ENOTSUPP;
+}
+
+void fit_image_hash_stream_update(struct fit_hash_stream *hs,
+				  const void *data, size_t size)
+{
+	int i;
+
+	for (i = 0; i < hs->count; i++) {
+		if (hs->ctx[i])
+			hs->algo[i]->hash_update(hs->algo[i], hs->ctx[i], data,
+						 size, 0);
+	}
+}
+
+int fit_image_hash_stream_finish(struct fit_hash_stream *hs)
+{
+	ALLOC_CACHE_ALIGN_BUFFER(uint8_t, value, FIT_MAX_HASH_LEN);
+	char *err_msg = NULL;
+	int i, noffset = 0;
+
+	for (i = 0; i < hs->count; i++) {
+		struct hash_algo *algo = hs->algo[i];
+		uint8_t *fit_value;
+		int fit_value_len;
+
+		if (!hs->ctx[i]) {
+			if (!err_msg)
+				printf("%s-skipped ", algo->name);
+			continue;
+		}
+
+		algo->hash_update(algo, hs->ctx[i], value, 0, 1);
+		algo->hash_finish(algo, hs->ctx[i], value, FIT_MAX_HASH_LEN);
+		if (err_msg)
+			continue;
+
+		printf("%s", algo->name);
+		noffset = hs->noffset[i];
+		if (fit_image_hash_get_value(hs->fit, noffset, &fit_value,
+					     &fit_value_len))
+			err_msg = "Can't get hash value property";
+		else if (algo->digest_size != fit_value_len)
+			err_msg = "Bad hash value len";
+		else if (memcmp(value, fit_value, fit_value_len))
+			err_msg = "Bad hash value";
+		else
+			puts("+ ");
+	}
+
+	if (err_msg) {
+		printf(" error!\n%s for '%s' hash node in '%s' image node\n",
+		       err_msg, fit_get_name(hs->fit, noffset, NULL),
+		       fit_get_name(hs->fit, hs->image_noffset, NULL));
+		return 0;
+	}
+
+	return 1;
+}
+#endif /* !USE_HOSTCC */
+
 /**
  * fit_image_verify - verify data integrity
  * @fit: pointer to the FIT format image header
@@ -1716,6 +1846,105 @@ int fit_check_format(const void *fit, ulong size)
 	return 0;
 }
 
+int fit_conf_get_compat_node(const void *fit, int images_noffset,
+			     int noffset, const void **fdtp)
+{
+	const char *kfdt_name;
+	int kfdt_noffset;
+	size_t sz;
+	int len;
+
+	/* If there's a compat property in the config node, use that. */
+	if (fdt_getprop(fit, noffset, "compatible", NULL)) {
+		*fdtp = fit;		/* search in FIT image */
+		return noffset;		/* search under config node */
+	}
+
+	/* Otherwise extract it from the kernel FDT. */
+	kfdt_name = fdt_getprop(fit, noffset, "fdt", &len);
+	if (!kfdt_name) {
+		debug("No fdt property found.\n");
+		return -ENOENT;
+	}
+	kfdt_noffset = fdt_subnode_offset(fit, images_noffset, kfdt_name);
+	if (kfdt_noffset < 0) {
+		debug("No image node named \"%s\" found.\n", kfdt_name);
+		return -ENOENT;
+	}
+
+	if (!fit_image_check_comp(fit, kfdt_noffset, IH_COMP_NONE)) {
+		debug("Can't extract compat from \"%s\" (compressed)\n",
+		      kfdt_name);
+		return -ENOENT;
+	}
+
+	/* search in this config's kernel FDT */
+	if (fit_image_get_data_and_size(fit, kfdt_noffset, fdtp, &sz)) {
+		debug("Failed to get fdt \"%s\".\n", kfdt_name);
+		return -ENOENT;
+	}
+
+	return 0;  /* search kFDT under root node */
+}
+
+/**
+ * fit_conf_find_compat_index() - find a configuration using the index
+ *
+ * Looks up each of U-Boot's compatible strings in turn in the index written
+ * by mkimage, which lists the compatible strings of each configuration in
+ * the order of the configurations. The first hit is therefore the same
+ * configuration that searching all of them would pick. It is checked
+ * against the configuration itself, since the index is not signed.
+ *
+ * @fit: pointer to the FIT format image header
+ * @confs_noffset: offset of the configurations node
+ * @images_noffset: offset of the images node
+ * @compat: U-Boot's compatible strings
+ * @compat_len: length of @compat
+ * Return: offset of the configuration, or -ENOENT if there is no index or
+ *	it does not give an answer, so that all configurations must be searched
+ */
+static int fit_conf_find_compat_index(const void *fit, int confs_noffset,
+				      int images_noffset, const char *compat,
+				      int compat_len)
+{
+	const char *index, *end, *p, *conf;
+	const void *fdt;
+	int len, noffset, compat_noffset;
+
+	index = fdt_getprop(fit, confs_noffset, FIT_COMPAT_INDEX_PROP, &len);
+	if (!index || len <= 0 || index[len - 1])
+		return -ENOENT;
+	end = index + len;
+
+	for (; compat_len > 0; compat_len -= strlen(compat) + 1,
+	     compat += strlen(compat) + 1) {
+		for (p = index; p < end; p = conf + strlen(conf) + 1) {
+			conf = p + strlen(p) + 1;
+			if (conf >= end)
+				return -ENOENT;
+			if (strcmp(p, compat))
+				continue;
+
+			noffset = fdt_subnode_offset(fit, confs_noffset, conf);
+			if (noffset < 0)
+				return -ENOENT;
+			compat_noffset = fit_conf_get_compat_node(fit,
+								  images_noffset,
+								  noffset,
+								  &fdt);
+			if (compat_noffset < 0 ||
+			    fdt_node_check_compatible(fdt, compat_noffset,
+						      compat))
+				return -ENOENT;
+
+			return noffset;
+		}
+	}
+
+	return -ENOENT;
+}
+
 int fit_conf_find_compat(const void *fit, const void *fdt)
 {
 	int ndepth = 0;
@@ -1738,6 +1967,12 @@ int fit_conf_find_compat(const void *fit, const void *fdt)
 		return -1;
 	}
 
+	noffset = fit_conf_find_compat_index(fit, confs_noffset,
+					     images_noffset, fdt_compat,
+					     fdt_compat_len);
+	if (noffset >= 0)
+		return noffset;
+
 	/*
 	 * Loop over the configurations in the FIT image.
 	 */
@@ -1745,50 +1980,18 @@ int fit_conf_find_compat(const void *fit, const void *fdt)
 			(noffset >= 0) && (ndepth > 0);
 			noffset = fdt_next_node(fit, noffset, &ndepth)) {
 		const void *fdt;
-		const char *kfdt_name;
-		int kfdt_noffset, compat_noffset;
+		int compat_noffset;
 		const char *cur_fdt_compat;
 		int len;
-		size_t sz;
 		int i;
 
 		if (ndepth > 1)
 			continue;
 
-		/* If there's a compat property in the config node, use that. */
-		if (fdt_getprop(fit, noffset, "compatible", NULL)) {
-			fdt = fit;		  /* search in FIT image */
-			compat_noffset = noffset; /* search under config node */
-		} else {	/* Otherwise extract it from the kernel FDT. */
-			kfdt_name = fdt_getprop(fit, noffset, "fdt", &len);
-			if (!kfdt_name) {
-				debug("No fdt property found.\n");
-				continue;
-			}
-			kfdt_noffset = fdt_subnode_offset(fit, images_noffset,
-							  kfdt_name);
-			if (kfdt_noffset < 0) {
-				debug("No image node named \"%s\" found.\n",
-				      kfdt_name);
-				continue;
-			}
-
-			if (!fit_image_check_comp(fit, kfdt_noffset,
-						  IH_COMP_NONE)) {
-				debug("Can't extract compat from \"%s\" "
-				      "(compressed)\n", kfdt_name);
-				continue;
-			}
-
-			/* search in this config's kernel FDT */
-			if (fit_image_get_data_and_size(fit, kfdt_noffset,
-							&fdt, &sz)) {
-				debug("Failed to get fdt \"%s\".\n", kfdt_name);
-				continue;
-			}
-
-			compat_noffset = 0;  /* search kFDT under root node */
-		}
+		compat_noffset = fit_conf_get_compat_node(fit, images_noffset,
+							  noffset, &fdt);
+		if (compat_noffset < 0)
+			continue;
 
 		len = fdt_compat_len;
 		cur_fdt_compat = fdt_compat;
@@ -39,6 +39,14 @@ int bootstd_prog_boot(void)
 	flags = BOOTFLOWIF_HUNT | BOOTFLOWIF_SHOW | BOOTFLOWIF_SKIP_GLOBAL;
 
 	bootstd_clear_glob();
+	if (IS_ENABLED(CONFIG_BOOTSTD_LAST_BOOTFLOW)) {
+		ret = bootflow_scan_last(&iter, flags, &bflow);
+		if (!ret) {
+			bootflow_run_boot(&iter, &bflow);
+			bootflow_free(&bflow);
+		}
+		bootflow_iter_uninit(&iter);
+	}
 	for (i = 0, ret = bootflow_scan_first(NULL, NULL, &iter, flags, &bflow);
 	     i < 1000 && ret != -ENODEV;
 	     i++, ret = bootflow_scan_next(&iter, &bflow)) {
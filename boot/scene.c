@@ -16,6 +16,7 @@
 #include <video.h>
 #include <video_console.h>
 #include <linux/input.h>
+#include <u-boot/crc.h>
 #include "scene_internal.h"
 
 int scene_new(struct expo *exp, const char *name, uint id, struct scene **scnp)
@@ -582,6 +583,242 @@ int scene_render_deps(struct scene *scn, uint id)
 	return 0;
 }
 
+/* add a bounding box to another */
+static void scene_bbox_add(struct vidconsole_bbox *bbox,
+			   const struct vidconsole_bbox *add)
+{
+	if (!add->valid)
+		return;
+	if (bbox->valid) {
+		bbox->x0 = min(bbox->x0, add->x0);
+		bbox->y0 = min(bbox->y0, add->y0);
+		bbox->x1 = max(bbox->x1, add->x1);
+		bbox->y1 = max(bbox->y1, add->y1);
+	} else {
+		*bbox = *add;
+	}
+}
+
+static bool scene_bbox_overlap(const struct vidconsole_bbox *a,
+			       const struct vidconsole_bbox *b)
+{
+	return a->valid && b->valid && a->x0 < b->x1 && b->x0 < a->x1 &&
+		a->y0 < b->y1 && b->y0 < a->y1;
+}
+
+static bool scene_bbox_contains(const struct vidconsole_bbox *a,
+				const struct vidconsole_bbox *b)
+{
+	return a->x0 <= b->x0 && a->y0 <= b->y0 && a->x1 >= b->x1 &&
+		a->y1 >= b->y1;
+}
+
+/**
+ * scene_obj_extent() - Get the area of the display an object may draw on
+ *
+ * This covers the object itself, any background drawn behind it and, for a
+ * menu or textline, all of the objects drawn with it by scene_render_deps()
+ *
+ * @obj: Object to check
+ * @ext: Returns the area, in pixels
+ */
+static void scene_obj_extent(struct scene_obj *obj, struct vidconsole_bbox *ext)
+{
+	/* allow for glyphs which extend a little outside their advance */
+	int inset = obj->scene->expo->theme.menu_inset + 2;
+	struct vidconsole_bbox bbox, label_bbox;
+	int width = obj->dim.w;
+
+	/* text may have changed since its dimensions were calculated */
+	if (obj->type == SCENEOBJT_TEXT) {
+		int w;
+
+		if (scene_obj_get_hw(obj->scene, obj->id, &w) >= 0)
+			width = max(width, w);
+	}
+
+	ext->valid = true;
+	ext->x0 = obj->dim.x;
+	ext->y0 = obj->dim.y;
+	ext->x1 = obj->dim.x + width;
+	ext->y1 = obj->dim.y + obj->dim.h;
+	if (!scene_obj_calc_bbox(obj, &bbox, &label_bbox)) {
+		scene_bbox_add(ext, &bbox);
+		scene_bbox_add(ext, &label_bbox);
+	}
+	if (obj->type == SCENEOBJT_MENU) {
+		struct scene_obj_menu *menu = (struct scene_obj_menu *)obj;
+
+		scene_bbox_union(obj->scene, menu->pointer_id, 0, ext);
+	}
+	ext->x0 -= inset;
+	ext->y0 -= inset;
+	ext->x1 += inset;
+	ext->y1 += inset;
+}
+
+/**
+ * scene_obj_sig() - Calculate a signature for the visible state of an object
+ *
+ * @obj: Object to check
+ * @ext: Area of the display covered by the object
+ * Return: signature, which changes if the object would render differently
+ */
+static u32 scene_obj_sig(struct scene_obj *obj,
+			 const struct vidconsole_bbox *ext)
+{
+	struct expo *exp = obj->scene->expo;
+	u32 sig;
+
+	sig = crc32(0, (uchar *)ext, sizeof(*ext));
+	sig = crc32(sig, &obj->flags, sizeof(obj->flags));
+	switch (obj->type) {
+	case SCENEOBJT_NONE:
+		break;
+	case SCENEOBJT_IMAGE: {
+		struct scene_obj_img *img = (struct scene_obj_img *)obj;
+
+		sig = crc32(sig, (uchar *)&img->data, sizeof(img->data));
+		break;
+	}
+	case SCENEOBJT_TEXT: {
+		struct scene_obj_txt *txt = (struct scene_obj_txt *)obj;
+		const char *str = expo_get_str(exp, txt->str_id);
+
+		if (str)
+			sig = crc32(sig, (uchar *)str, strlen(str));
+		sig = crc32(sig, (uchar *)&txt->font_name,
+			    sizeof(txt->font_name));
+		sig = crc32(sig, (uchar *)&txt->font_size,
+			    sizeof(txt->font_size));
+		break;
+	}
+	case SCENEOBJT_MENU:
+		sig = crc32(sig, (uchar *)&exp->popup, sizeof(exp->popup));
+		break;
+	case SCENEOBJT_TEXTLINE: {
+		struct scene_obj_textline *tline;
+
+		tline = (struct scene_obj_textline *)obj;
+		sig = crc32(sig, (uchar *)&tline->pos, sizeof(tline->pos));
+		break;
+	}
+	}
+
+	return sig;
+}
+
+/* record what each object looks like on the display */
+static void scene_mark_drawn(struct scene *scn)
+{
+	struct vidconsole_bbox ext;
+	struct scene_obj *obj;
+
+	list_for_each_entry(obj, &scn->obj_head, sibling) {
+		if (obj->flags & SCENEOF_HIDE) {
+			obj->drawn.w = 0;
+			continue;
+		}
+		scene_obj_extent(obj, &ext);
+		obj->drawn.x = ext.x0;
+		obj->drawn.y = ext.y0;
+		obj->drawn.w = ext.x1 - ext.x0;
+		obj->drawn.h = ext.y1 - ext.y0;
+		obj->drawn_sig = scene_obj_sig(obj, &ext);
+	}
+}
+
+int scene_render_partial(struct scene *scn, u32 colour)
+{
+	struct udevice *dev = scn->expo->display;
+	struct video_priv *vid_priv = dev_get_uclass_priv(dev);
+	struct vidconsole_bbox damage, ext;
+	struct scene_obj *obj;
+	bool grown;
+	int ret;
+
+	/* find the area covered by objects which changed, before and after */
+	damage.valid = false;
+	list_for_each_entry(obj, &scn->obj_head, sibling) {
+		bool hide = obj->flags & SCENEOF_HIDE;
+
+		ext.valid = false;
+		if (!hide) {
+			scene_obj_extent(obj, &ext);
+			if (obj->drawn.w &&
+			    scene_obj_sig(obj, &ext) == obj->drawn_sig)
+				continue;
+		} else if (!obj->drawn.w) {
+			continue;
+		}
+		scene_bbox_add(&damage, &ext);
+		if (obj->drawn.w) {
+			ext.valid = true;
+			ext.x0 = obj->drawn.x;
+			ext.y0 = obj->drawn.y;
+			ext.x1 = obj->drawn.x + obj->drawn.w;
+			ext.y1 = obj->drawn.y + obj->drawn.h;
+			scene_bbox_add(&damage, &ext);
+		}
+	}
+	if (!damage.valid)
+		return 0;
+
+	/*
+	 * Everything touching that area is redrawn in full, so extend the area
+	 * to cover it all, which keeps the stacking order the same as a full
+	 * render
+	 */
+	do {
+		grown = false;
+		list_for_each_entry(obj, &scn->obj_head, sibling) {
+			if (obj->flags & SCENEOF_HIDE)
+				continue;
+			scene_obj_extent(obj, &ext);
+			if (scene_bbox_overlap(&damage, &ext) &&
+			    !scene_bbox_contains(&damage, &ext)) {
+				scene_bbox_add(&damage, &ext);
+				grown = true;
+			}
+		}
+	} while (grown);
+
+	damage.x0 = max(damage.x0, 0);
+	damage.y0 = max(damage.y0, 0);
+	damage.x1 = min(damage.x1, (int)vid_priv->xsize);
+	damage.y1 = min(damage.y1, (int)vid_priv->ysize);
+	if (damage.x0 < damage.x1 && damage.y0 < damage.y1) {
+		ret = video_fill_part(dev, damage.x0, damage.y0, damage.x1,
+				      damage.y1, colour);
+		if (ret)
+			return log_msg_ret("fil", ret);
+	}
+
+	list_for_each_entry(obj, &scn->obj_head, sibling) {
+		if (obj->flags & SCENEOF_HIDE)
+			continue;
+		scene_obj_extent(obj, &ext);
+		if (!scene_bbox_overlap(&damage, &ext))
+			continue;
+		ret = scene_obj_render(obj, false);
+		if (ret && ret != -ENOTSUPP)
+			return log_msg_ret("ren", ret);
+	}
+
+	obj = scene_obj_find(scn, scn->highlight_id, SCENEOBJT_NONE);
+	if (obj && !(obj->flags & SCENEOF_HIDE)) {
+		scene_obj_extent(obj, &ext);
+		if (scene_bbox_overlap(&damage, &ext)) {
+			ret = scene_render_deps(scn, scn->highlight_id);
+			if (ret && ret != -ENOTSUPP)
+				return log_msg_ret("dep", ret);
+		}
+	}
+	scene_mark_drawn(scn);
+
+	return 0;
+}
+
 int scene_render(struct scene *scn)
 {
 	struct expo *exp = scn->expo;
@@ -602,6 +839,8 @@ int scene_render(struct scene *scn)
 		if (ret && ret != -ENOTSUPP)
 			return log_msg_ret("dep", ret);
 	}
+	if (IS_ENABLED(CONFIG_EXPO_PARTIAL_REDRAW) && !exp->text_mode)
+		scene_mark_drawn(scn);
 
 	return 0;
 }
@@ -183,6 +183,19 @@ void scene_destroy(struct scene *scn);
  */
 int scene_render(struct scene *scn);
 
+/**
+ * scene_render_partial() - Redraw the parts of a scene which have changed
+ *
+ * This is called from expo_render() when the scene is already on the display.
+ * Objects whose appearance has changed since they were last rendered are
+ * redrawn, along with anything overlapping them.
+ *
+ * @scn: Scene to render
+ * @colour: Background colour
+ * Returns: 0 if OK, -ve on error
+ */
+int scene_render_partial(struct scene *scn, u32 colour);
+
 /**
  * scene_send_key() - set a keypress to a scene
  *
@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Measure block device and filesystem throughput
+ */
+
+#include <blk.h>
+#include <command.h>
+#include <dm.h>
+#include <fs.h>
+#include <getopt.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <part.h>
+#include <rand.h>
+#include <time.h>
+#include <vsprintf.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
+
+/**
+ * struct blkbench - settings for a block device benchmark
+ *
+ * @desc: Device to use
+ * @start: First block of the area to use
+ * @blocks: Number of blocks in the area
+ * @bs: Blocks per transfer
+ * @count: Number of transfers to do
+ * @random: true to pick a random place in the area for each transfer,
+ *	false to go through it in order
+ * @async: true to read through blk_read_submit()
+ */
+struct blkbench {
+	struct blk_desc *desc;
+	lbaint_t start;
+	lbaint_t blocks;
+	lbaint_t bs;
+	ulong count;
+	bool random;
+	bool async;
+};
+
+static void blkbench_report(const char *what, u64 bytes, ulong count,
+			    ulong us)
+{
+	u64 rate;
+
+	if (!us)
+		us = 1;
+	/* Bytes per microsecond is MB/s; keep one decimal place */
+	rate = div_u64(bytes * 10, us);
+	printf("%s: %llu bytes in %lu ms, %llu.%llu MB/s", what, bytes,
+	       us / 1000, rate / 10, rate % 10);
+	if (count)
+		printf(", %llu IOPS", div_u64((u64)count * 1000000, us));
+	printf("\n");
+}
+
+static lbaint_t blkbench_next(struct blkbench *bb, ulong i)
+{
+	lbaint_t slots = bb->blocks / bb->bs;
+
+	if (bb->random)
+		i = rand();
+
+	return bb->start + (i % slots) * bb->bs;
+}
+
+static int blkbench_transfer(struct blkbench *bb, void *buf, bool write)
+{
+	struct blk_desc *desc = bb->desc;
+	ulong start, i;
+	lbaint_t blk;
+	long ret;
+
+	/* Measure the device, not the cache */
+	blkcache_invalidate(desc->uclass_id, desc->devnum);
+
+	srand(0);
+	start = timer_get_us();
+	for (i = 0; i < bb->count; i++) {
+		blk = blkbench_next(bb, i);
+		if (write) {
+			ret = blk_dwrite(desc, blk, bb->bs, buf);
+		} else if (bb->async) {
+			struct blk_req req;
+
+			ret = blk_read_submit(desc->bdev, blk, bb->bs, buf,
+					      &req);
+			if (!ret)
+				ret = blk_req_wait(&req);
+		} else {
+			ret = blk_dread(desc, blk, bb->bs, buf);
+		}
+		if (ret != bb->bs) {
+			printf("%s failed at block " LBAF ": %ld\n",
+			       write ? "Write" : "Read", blk, ret);
+			return CMD_RET_FAILURE;
+		}
+	}
+	blkbench_report(write ? "write" : "read",
+			(u64)bb->count * bb->bs * desc->blksz, bb->count,
+			timer_get_us() - start);
+
+	return 0;
+}
+
+static int do_blkbench_rw(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	bool write = !strcmp(argv[0], "write");
+	struct disk_partition info;
+	struct getopt_state gs;
+	struct blkbench bb;
+	ulong size = SZ_64K;
+	ulong total = SZ_16M;
+	void *buf;
+	int opt, ret;
+
+	memset(&bb, '\0', sizeof(bb));
+	getopt_init_state(&gs);
+	while ((opt = getopt(&gs, argc, argv, "s:n:ra")) > 0) {
+		switch (opt) {
+		case 's':
+			size = ustrtoul(gs.arg, NULL, 0);
+			break;
+		case 'n':
+			total = ustrtoul(gs.arg, NULL, 0);
+			break;
+		case 'r':
+			bb.random = true;
+			break;
+		case 'a':
+			bb.async = true;
+			break;
+		default:
+			return CMD_RET_USAGE;
+		}
+	}
+	if (gs.index + 2 != argc)
+		return CMD_RET_USAGE;
+
+	if (blk_get_device_part_str(argv[gs.index], argv[gs.index + 1],
+				    &bb.desc, &info, 1) < 0)
+		return CMD_RET_FAILURE;
+
+	bb.start = info.start;
+	bb.blocks = info.size;
+	bb.bs = max_t(lbaint_t, size / bb.desc->blksz, 1);
+	if (bb.bs > bb.blocks) {
+		printf("Transfer size is larger than the device\n");
+		return CMD_RET_FAILURE;
+	}
+	bb.count = max_t(ulong, total / (bb.bs * bb.desc->blksz), 1);
+
+	buf = memalign(ARCH_DMA_MINALIGN, bb.bs * bb.desc->blksz);
+	if (!buf) {
+		printf("Out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+	if (write)
+		memset(buf, 0xa5, bb.bs * bb.desc->blksz);
+
+	ret = blkbench_transfer(&bb, buf, write);
+	free(buf);
+
+	return ret;
+}
+
+static int blkbench_fs_read(const char *ifname, const char *dev_part,
+			    const char *fname, void *buf, loff_t size,
+			    const char *what)
+{
+	loff_t actread;
+	ulong start;
+	int ret;
+
+	start = timer_get_us();
+	ret = fs_set_blk_dev(ifname, dev_part, FS_TYPE_ANY);
+	if (!ret)
+		ret = fs_read(fname, map_to_sysmem(buf), 0, size, &actread);
+	if (ret) {
+		printf("Cannot read '%s' (err=%d)\n", fname, ret);
+		return CMD_RET_FAILURE;
+	}
+	blkbench_report(what, actread, 0, timer_get_us() - start);
+
+	return 0;
+}
+
+static int do_blkbench_fs(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	struct blk_desc *desc;
+	struct disk_partition info;
+	loff_t size;
+	void *buf;
+	int ret;
+
+	if (argc != 4)
+		return CMD_RET_USAGE;
+
+	if (blk_get_device_part_str(argv[1], argv[2], &desc, &info, 1) < 0 ||
+	    fs_set_blk_dev(argv[1], argv[2], FS_TYPE_ANY))
+		return CMD_RET_FAILURE;
+	ret = fs_size(argv[3], &size);
+	if (ret) {
+		printf("Cannot find '%s' (err=%d)\n", argv[3], ret);
+		return CMD_RET_FAILURE;
+	}
+
+	buf = memalign(ARCH_DMA_MINALIGN, size);
+	if (!buf) {
+		printf("Out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+
+	/* First from the device, then again with whatever is now cached */
+	blkcache_invalidate(desc->uclass_id, desc->devnum);
+	ret = blkbench_fs_read(argv[1], argv[2], argv[3], buf, size, "cold");
+	if (!ret)
+		ret = blkbench_fs_read(argv[1], argv[2], argv[3], buf, size,
+				       "warm");
+	free(buf);
+
+	return ret;
+}
+
+U_BOOT_LONGHELP(blkbench,
+	"read [-ar] [-s <size>] [-n <total>] <interface> <dev[:part]>\n"
+	"    - time reads of <size> bytes (default 64KiB) until <total>\n"
+	"      bytes (default 16MiB) have been read\n"
+	"      -r  read from random places rather than in order\n"
+	"      -a  read through the asynchronous block API\n"
+	"blkbench write [-r] [-s <size>] [-n <total>] <interface> <dev[:part]>\n"
+	"    - time writes in the same way; this overwrites the data!\n"
+	"blkbench fs <interface> <dev[:part]> <file>\n"
+	"    - time reading a file, with the block cache empty and then again");
+
+U_BOOT_CMD_WITH_SUBCMDS(blkbench, "measure storage throughput",
+	blkbench_help_text,
+	U_BOOT_SUBCMD_MKENT(read, 9, 1, do_blkbench_rw),
+	U_BOOT_SUBCMD_MKENT(write, 9, 0, do_blkbench_rw),
+	U_BOOT_SUBCMD_MKENT(fs, 4, 1, do_blkbench_fs));
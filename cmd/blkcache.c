@@ -4,6 +4,7 @@
  * Author: Eric Nelson<eric@nelint.com>
  *
  */
+#include <blk.h>
 #include <command.h>
 #include <config.h>
 #include <malloc.h>
@@ -13,15 +14,27 @@
 static int blkc_show(struct cmd_tbl *cmdtp, int flag,
 		     int argc, char *const argv[])
 {
+	struct block_cache_dev_stats dstats;
 	struct block_cache_stats stats;
+	int i;
+
+	for (i = 0; !blkcache_dev_stats(i, &dstats); i++) {
+		if (!i)
+			printf("device     hits     misses   evictions entries\n");
+		printf("%-6s %-3d %-8u %-8u %-9u %u\n",
+		       blk_get_uclass_name(dstats.iftype), dstats.devnum,
+		       dstats.hits, dstats.misses, dstats.evictions,
+		       dstats.entries);
+	}
 	blkcache_stats(&stats);
 
 	printf("hits: %u\n"
 	       "misses: %u\n"
+	       "evictions: %u\n"
 	       "entries: %u\n"
 	       "max blocks/entry: %u\n"
 	       "max cache entries: %u\n",
-	       stats.hits, stats.misses, stats.entries,
+	       stats.hits, stats.misses, stats.evictions, stats.entries,
 	       stats.max_blocks_per_entry, stats.max_entries);
 	return 0;
 }
@@ -41,9 +54,24 @@ static int blkc_configure(struct cmd_tbl *cmdtp, int flag,
 	return 0;
 }
 
+static int __maybe_unused blkc_readahead(struct cmd_tbl *cmdtp, int flag,
+					  int argc, char *const argv[])
+{
+	if (argc > 2)
+		return CMD_RET_USAGE;
+
+	if (argc == 2)
+		blkcache_readahead_configure(simple_strtoul(argv[1], 0, 0));
+	printf("read-ahead window: %lu bytes\n", blkcache_readahead_size());
+	return 0;
+}
+
 static struct cmd_tbl cmd_blkc_sub[] = {
 	U_BOOT_CMD_MKENT(show, 0, 0, blkc_show, "", ""),
 	U_BOOT_CMD_MKENT(configure, 3, 0, blkc_configure, "", ""),
+#if CONFIG_IS_ENABLED(BLOCK_READAHEAD)
+	U_BOOT_CMD_MKENT(readahead, 2, 0, blkc_readahead, "", ""),
+#endif
 };
 
 static int do_blkcache(struct cmd_tbl *cmdtp, int flag,
@@ -72,4 +100,8 @@ U_BOOT_CMD(
 	"show - show and reset statistics\n"
 	"blkcache configure <blocks> <entries> "
 	"- set max blocks per entry and max cache entries\n"
+#if CONFIG_IS_ENABLED(BLOCK_READAHEAD)
+	"blkcache readahead [<size>] "
+	"- show or set the read-ahead window in bytes, 0 to disable\n"
+#endif
 );
@@ -200,6 +200,19 @@ static int do_bootflow_scan(struct cmd_tbl *cmdtp, int flag, int argc,
 		bootdev_clear_bootflows(dev);
 	else
 		bootstd_clear_glob();
+
+	/* try what booted last time, before scanning everything */
+	if (IS_ENABLED(CONFIG_BOOTSTD_LAST_BOOTFLOW) && boot && !menu &&
+	    !dev && !label) {
+		ret = bootflow_scan_last(&iter, flags, &bflow);
+		if (!ret) {
+			if (list)
+				printf("Using last bootflow '%s'\n", bflow.name);
+			bootflow_run_boot(&iter, &bflow);
+			bootflow_free(&bflow);
+		}
+		bootflow_iter_uninit(&iter);
+	}
 	for (i = 0,
 	     ret = bootflow_scan_first(dev, label, &iter, flags, &bflow);
 	     i < 1000 && ret != -ENODEV;
@@ -26,11 +26,13 @@ static int booti_start(struct bootm_info *bmi)
 	ulong ld;
 	ulong relocated_addr;
 	ulong image_size;
+	ulong src, len = 0;
 	uint8_t *temp;
-	ulong dest;
+	ulong dest = 0;
 	ulong dest_end;
 	unsigned long comp_len;
-	unsigned long decomp_len;
+	unsigned long decomp_len = 0;
+	bool direct = false;
 	int ctype;
 
 	ret = bootm_run_states(bmi, BOOTM_STATE_START);
@@ -50,43 +52,89 @@ static int booti_start(struct bootm_info *bmi)
 	if (ctype > 0) {
 		dest = env_get_ulong("kernel_comp_addr_r", 16, 0);
 		comp_len = env_get_ulong("kernel_comp_size", 16, 0);
-		if (!dest || !comp_len) {
-			puts("kernel_comp_addr_r or kernel_comp_size is not provided!\n");
-			return -EINVAL;
-		}
-		if (dest < gd->ram_base || dest > gd->ram_top) {
-			puts("kernel_comp_addr_r is outside of DRAM range!\n");
-			return -EINVAL;
+		if (!dest) {
+			/*
+			 * Decompress straight to a 2MB-aligned area. This is
+			 * where a relocatable kernel with a text_offset of 0
+			 * runs, so it does not need to be moved afterwards.
+			 * The decompressors stop at the end of the compressed
+			 * data, so the size only needs to be a limit.
+			 */
+			decomp_len = CONFIG_SYS_BOOTM_LEN;
+			dest = lmb_alloc(decomp_len, SZ_2M);
+			if (!dest) {
+				puts("Not enough memory to decompress kernel\n");
+				return -ENOMEM;
+			}
+			if (!comp_len)
+				comp_len = gd->ram_top - ld;
+			direct = true;
+		} else {
+			if (!comp_len) {
+				puts("kernel_comp_size is not provided!\n");
+				return -EINVAL;
+			}
+			if (dest < gd->ram_base || dest > gd->ram_top) {
+				puts("kernel_comp_addr_r is outside of DRAM range!\n");
+				return -EINVAL;
+			}
+			decomp_len = comp_len * 10;
 		}
 
 		debug("kernel image compression type %d size = 0x%08lx address = 0x%08lx\n",
 			ctype, comp_len, (ulong)dest);
-		decomp_len = comp_len * 10;
 		ret = image_decomp(ctype, 0, ld, IH_TYPE_KERNEL,
 				 (void *)dest, (void *)ld, comp_len,
 				 decomp_len, &dest_end);
-		if (ret)
+		if (ret) {
+			if (direct)
+				lmb_free(dest, decomp_len);
 			return ret;
-		/* dest_end contains the uncompressed Image size */
-		memmove((void *) ld, (void *)dest, dest_end);
+		}
+		src = dest;
+		len = dest_end;
+		if (direct) {
+			ld = dest;
+		} else {
+			/*
+			 * dest_end contains the uncompressed Image size. The
+			 * compressed data at ld is not needed any more, so
+			 * only put the Image header there to work out the
+			 * final location and copy the Image straight to it
+			 * below.
+			 */
+			memmove((void *)ld, (void *)dest,
+				min_t(ulong, dest_end, SZ_64));
+		}
+	} else {
+		src = ld;
 	}
-	unmap_sysmem((void *)ld);
+	unmap_sysmem(temp);
 
 	ret = booti_setup(ld, &relocated_addr, &image_size, false);
-	if (ret)
+	if (ret) {
+		if (direct)
+			lmb_free(dest, decomp_len);
 		return 1;
+	}
+	if (!len)
+		len = image_size;
 
 	/* Handle BOOTM_STATE_LOADOS */
-	if (relocated_addr != ld) {
-		printf("Moving Image from 0x%lx to 0x%lx, end=0x%lx\n", ld,
+	if (relocated_addr != src) {
+		printf("Moving Image from 0x%lx to 0x%lx, end=0x%lx\n", src,
 		       relocated_addr, relocated_addr + image_size);
-		memmove((void *)relocated_addr, (void *)ld, image_size);
+		memmove((void *)relocated_addr, (void *)src, len);
+	} else {
+		debug("Image already at 0x%lx, not relocating\n", src);
 	}
 
 	images->ep = relocated_addr;
 	images->os.start = relocated_addr;
 	images->os.end = relocated_addr + image_size;
 
+	if (direct)
+		lmb_free(dest, decomp_len);
 	lmb_reserve(images->ep, le32_to_cpu(image_size));
 
 	/*
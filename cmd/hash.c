@@ -13,19 +13,13 @@
 #include <hash.h>
 #include <linux/ctype.h>
 
-#if IS_ENABLED(CONFIG_HASH_VERIFY)
-#define HARGS 6
-#else
-#define HARGS 5
-#endif
-
 static int do_hash(struct cmd_tbl *cmdtp, int flag, int argc,
 		   char *const argv[])
 {
 	char *s;
 	int flags = HASH_FLAG_ENV;
 
-	if (argc < (HARGS - 1))
+	if (argc < 4)
 		return CMD_RET_USAGE;
 
 #if IS_ENABLED(CONFIG_HASH_VERIFY)
@@ -44,7 +38,7 @@ static int do_hash(struct cmd_tbl *cmdtp, int flag, int argc,
 }
 
 U_BOOT_CMD(
-	hash,	HARGS,	1,	do_hash,
+	hash,	CONFIG_SYS_MAXARGS,	1,	do_hash,
 	"compute hash message digest",
 	"algorithm address count [[*]hash_dest]\n"
 		"    - compute message digest [save to env var / *address]"
@@ -53,4 +47,8 @@ U_BOOT_CMD(
 		"    - verify message digest of memory area to immediate value, \n"
 		"      env var or *address"
 #endif
+	"\n\nalgorithm may be a comma-separated list, and several address count\n"
+	"pairs may be given. Each region is read once for all algorithms.\n"
+	"hash_dest / hash is then a comma-separated list with one entry per\n"
+	"algorithm for each region in turn."
 );
@@ -448,9 +448,17 @@ static int do_load_serial_bin(struct cmd_tbl *cmdtp, int flag, int argc,
 	ulong offset = 0;
 	ulong addr;
 	int load_baudrate, current_baudrate;
+	int ymodem_mode = xyzModem_ymodem;
+	const char *name = argv[0];
 	int rcode = 0;
 	char *s;
 
+	if (argc >= 2 && !strcmp(name, "loady") && !strcmp(argv[1], "-g")) {
+		ymodem_mode = xyzModem_ymodem_g;
+		argc--;
+		argv++;
+	}
+
 	/* pre-set offset from CONFIG_SYS_LOAD_ADDR */
 	offset = CONFIG_SYS_LOAD_ADDR;
 
@@ -486,13 +494,14 @@ static int do_load_serial_bin(struct cmd_tbl *cmdtp, int flag, int argc,
 		}
 	}
 
-	if (strcmp(argv[0],"loady")==0) {
-		printf("## Ready for binary (ymodem) download "
+	if (strcmp(name, "loady") == 0) {
+		printf("## Ready for binary (%s) download "
 			"to 0x%08lX at %d bps...\n",
+			ymodem_mode == xyzModem_ymodem_g ? "ymodem-g" : "ymodem",
 			offset,
 			load_baudrate);
 
-		addr = load_serial_ymodem(offset, xyzModem_ymodem);
+		addr = load_serial_ymodem(offset, ymodem_mode);
 
 		if (addr == ~0) {
 			image_load_addr = 0;
@@ -502,7 +511,7 @@ static int do_load_serial_bin(struct cmd_tbl *cmdtp, int flag, int argc,
 			printf("## Start Addr      = 0x%08lX\n", addr);
 			image_load_addr = addr;
 		}
-	} else if (strcmp(argv[0],"loadx")==0) {
+	} else if (strcmp(name, "loadx") == 0) {
 		printf("## Ready for binary (xmodem) download "
 			"to 0x%08lX at %d bps...\n",
 			offset,
@@ -1170,11 +1179,12 @@ U_BOOT_CMD(
 );
 
 U_BOOT_CMD(
-	loady, 3, 0,	do_load_serial_bin,
+	loady, 4, 0,	do_load_serial_bin,
 	"load binary file over serial line (ymodem mode)",
-	"[ addr [ baud ] ]\n"
+	"[ -g ] [ addr [ baud ] ]\n"
 	"    - load binary file over serial line"
-	" at address 'addr' with baudrate 'baud'"
+	" at address 'addr' with baudrate 'baud'\n"
+	"      -g: use ymodem-g, which streams blocks without waiting"
 );
 
 #endif	/* CONFIG_CMD_LOADB */
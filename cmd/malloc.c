@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Show information about the malloc() pool
+ */
+
+#include <command.h>
+#include <display_options.h>
+#include <malloc.h>
+#include <vsprintf.h>
+#include <linux/kernel.h>
+
+static int do_malloc_info(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	struct malloc_class_stats stats[MALLOC_NUM_CLASSES];
+	int i, count;
+
+	printf("pool      %08lx-%08lx, ", mem_malloc_start, mem_malloc_end);
+	print_size(mem_malloc_end - mem_malloc_start, "\n");
+	printf("extent    ");
+	print_size(mem_malloc_brk - mem_malloc_start, "\n");
+
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_SIZE_CLASSES))
+		return 0;
+	count = malloc_get_class_stats(stats, ARRAY_SIZE(stats));
+	printf("\n%5s %10s %10s %10s %10s %6s\n", "size", "hits", "misses",
+	       "frees", "spills", "free");
+	for (i = 0; i < count; i++) {
+		struct malloc_class_stats *cs = &stats[i];
+
+		printf("%5lu %10lu %10lu %10lu %10lu %6lu\n", cs->size, cs->hits,
+		       cs->misses, cs->frees, cs->spills, cs->count);
+	}
+
+	return 0;
+}
+
+static int do_malloc_flush(struct cmd_tbl *cmdtp, int flag, int argc,
+			   char *const argv[])
+{
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_SIZE_CLASSES))
+		return CMD_RET_FAILURE;
+	printf("Freed %d chunks\n", malloc_class_flush());
+
+	return 0;
+}
+
+static int do_malloc_prof(struct cmd_tbl *cmdtp, int flag, int argc,
+			  char *const argv[])
+{
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE))
+		return CMD_RET_FAILURE;
+	malloc_prof_show(argc > 1 ? dectoul(argv[1], NULL) : 0);
+
+	return 0;
+}
+
+U_BOOT_LONGHELP(malloc,
+	"info - show information about the malloc() pool\n"
+	"malloc flush - free chunks on the size-class lists to the pool\n"
+	"malloc prof [<n>] - show the <n> call sites using the most memory");
+
+U_BOOT_CMD_WITH_SUBCMDS(malloc, "malloc information", malloc_help_text,
+	U_BOOT_SUBCMD_MKENT(info, 1, 1, do_malloc_info),
+	U_BOOT_SUBCMD_MKENT(flush, 1, 1, do_malloc_flush),
+	U_BOOT_SUBCMD_MKENT(prof, 2, 1, do_malloc_prof));
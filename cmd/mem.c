@@ -16,21 +16,25 @@
 #include <command.h>
 #include <console.h>
 #include <display_options.h>
+#include <dma.h>
 #ifdef CONFIG_MTD_NOR_FLASH
 #include <flash.h>
 #endif
 #include <hash.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <rand.h>
 #include <time.h>
 #include <watchdog.h>
+#include <worker.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <linux/bitops.h>
 #include <linux/compiler.h>
 #include <linux/ctype.h>
 #include <linux/delay.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -359,7 +363,7 @@ static int do_mem_cp(struct cmd_tbl *cmdtp, int flag, int argc,
 	}
 #endif
 
-	memmove(dst, src, count * size);
+	dma_bulk_copy(dst, src, count * size);
 
 	unmap_sysmem(src);
 	unmap_sysmem(dst);
@@ -1058,6 +1062,161 @@ static ulong mem_test_quick(vu_long *buf, ulong start_addr, ulong end_addr,
 	return errs;
 }
 
+/* Number of bytes tested by each job in the fast test */
+#define MEM_TEST_FAST_CHUNK	SZ_64M
+
+/**
+ * struct mem_test_fast_res - errors found in one chunk by the fast test
+ *
+ * @errs: Number of words which read back wrongly
+ * @first: Index of the first bad word in the whole buffer
+ * @found: Value read from that word
+ */
+struct mem_test_fast_res {
+	ulong errs;
+	ulong first;
+	ulong found;
+};
+
+/**
+ * struct mem_test_fast - state shared between the fast-test jobs
+ *
+ * @buf: Memory being tested
+ * @words: Number of words in @buf
+ * @pattern: Value XORed with the word index to give the value of each word
+ * @res: Results, one per chunk
+ */
+struct mem_test_fast {
+	ulong *buf;
+	ulong words;
+	ulong pattern;
+	struct mem_test_fast_res *res;
+};
+
+static void mem_test_fast_fill(void *priv, int job)
+{
+	struct mem_test_fast *mt = priv;
+	ulong idx = job * (MEM_TEST_FAST_CHUNK / sizeof(ulong));
+	ulong end = min_t(ulong, idx + MEM_TEST_FAST_CHUNK / sizeof(ulong),
+			  mt->words);
+	ulong pat = mt->pattern;
+	ulong *p = mt->buf;
+
+	/* Write a whole 64-byte cache line at a time */
+	for (; idx + 8 <= end; idx += 8) {
+		p[idx] = pat ^ idx;
+		p[idx + 1] = pat ^ (idx + 1);
+		p[idx + 2] = pat ^ (idx + 2);
+		p[idx + 3] = pat ^ (idx + 3);
+		p[idx + 4] = pat ^ (idx + 4);
+		p[idx + 5] = pat ^ (idx + 5);
+		p[idx + 6] = pat ^ (idx + 6);
+		p[idx + 7] = pat ^ (idx + 7);
+	}
+	for (; idx < end; idx++)
+		p[idx] = pat ^ idx;
+}
+
+static void mem_test_fast_check_word(struct mem_test_fast *mt,
+				     struct mem_test_fast_res *res, ulong idx)
+{
+	ulong val = mt->buf[idx];
+
+	if (val == (mt->pattern ^ idx))
+		return;
+	if (!res->errs++) {
+		res->first = idx;
+		res->found = val;
+	}
+}
+
+static void mem_test_fast_check(void *priv, int job)
+{
+	struct mem_test_fast *mt = priv;
+	struct mem_test_fast_res *res = &mt->res[job];
+	ulong idx = job * (MEM_TEST_FAST_CHUNK / sizeof(ulong));
+	ulong end = min_t(ulong, idx + MEM_TEST_FAST_CHUNK / sizeof(ulong),
+			  mt->words);
+	ulong pat = mt->pattern;
+	ulong *p = mt->buf;
+	int i;
+
+	/* Read a whole cache line, only looking closer if it is wrong */
+	for (; idx + 8 <= end; idx += 8) {
+		if ((p[idx] ^ pat ^ idx) |
+		    (p[idx + 1] ^ pat ^ (idx + 1)) |
+		    (p[idx + 2] ^ pat ^ (idx + 2)) |
+		    (p[idx + 3] ^ pat ^ (idx + 3)) |
+		    (p[idx + 4] ^ pat ^ (idx + 4)) |
+		    (p[idx + 5] ^ pat ^ (idx + 5)) |
+		    (p[idx + 6] ^ pat ^ (idx + 6)) |
+		    (p[idx + 7] ^ pat ^ (idx + 7))) {
+			for (i = 0; i < 8; i++)
+				mem_test_fast_check_word(mt, res, idx + i);
+		}
+	}
+	for (; idx < end; idx++)
+		mem_test_fast_check_word(mt, res, idx);
+}
+
+/*
+ * Fill the whole range on all available CPUs, then read it back the same
+ * way. Each word holds its index XORed with the pattern, so addressing
+ * faults show up as well as stuck bits. The pattern is inverted on odd
+ * iterations.
+ */
+static ulong mem_test_fast(ulong *buf, ulong start_addr, ulong end_addr,
+			   ulong pattern, int iteration)
+{
+	const int plen = 2 * sizeof(ulong);
+	struct mem_test_fast mt;
+	ulong len, errs = 0;
+	ulong wr_us, rd_us;
+	ulong base;
+	int jobs, cpus;
+	int job;
+
+	len = end_addr - start_addr;
+	mt.buf = buf;
+	mt.words = len / sizeof(ulong);
+	mt.pattern = iteration & 1 ? ~pattern : pattern;
+	jobs = DIV_ROUND_UP(len, MEM_TEST_FAST_CHUNK);
+	mt.res = calloc(jobs, sizeof(*mt.res));
+	if (!mt.res) {
+		printf("\nOut of memory\n");
+		return -1;
+	}
+
+	printf("\rPattern %0*lX  ", plen, mt.pattern);
+	base = timer_get_us();
+	cpus = worker_run(mem_test_fast_fill, &mt, jobs);
+	wr_us = max_t(ulong, timer_get_us() - base, 1);
+
+	schedule();
+	base = timer_get_us();
+	worker_run(mem_test_fast_check, &mt, jobs);
+	rd_us = max_t(ulong, timer_get_us() - base, 1);
+
+	/* bytes per microsecond is the same as MB/s */
+	printf("Write %lu MB/s  Read %lu MB/s  (%d CPUs)", len / wr_us,
+	       len / rd_us, cpus);
+
+	for (job = 0; job < jobs; job++) {
+		struct mem_test_fast_res *res = &mt.res[job];
+
+		if (!res->errs)
+			continue;
+		printf("\nMem error @ 0x%0*lX: found %0*lX, expected %0*lX (%lu errors in region)\n",
+		       plen, start_addr + res->first * sizeof(ulong),
+		       plen, res->found, plen, mt.pattern ^ res->first,
+		       res->errs);
+		errs += res->errs;
+	}
+	free(mt.res);
+
+	return errs;
+}
+
 /*
  * Perform a memory test. A more complete alternative test can be
  * configured using CONFIG_SYS_ALT_MEMTEST. The complete test loops until
@@ -1073,8 +1232,16 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 	ulong count = 0;
 	ulong errs = 0;	/* number of errors, or -1 if interrupted */
 	ulong pattern = 0;
+	bool fast = false;
 	int iteration;
 
+	if (IS_ENABLED(CONFIG_SYS_MEMTEST_FAST) && argc > 1 &&
+	    !strcmp(argv[1], "-f")) {
+		fast = true;
+		argc--;
+		argv++;
+	}
+
 	start = CONFIG_SYS_MEMTEST_START;
 	end = CONFIG_SYS_MEMTEST_END;
 
@@ -1114,7 +1281,10 @@ static int do_mem_mtest(struct cmd_tbl *cmdtp, int flag, int argc,
 
 		printf("Iteration: %6d\r", iteration + 1);
 		debug("\n");
-		if (IS_ENABLED(CONFIG_SYS_ALT_MEMTEST)) {
+		if (fast) {
+			errs = mem_test_fast((ulong *)buf, start, end, pattern,
+					     iteration);
+		} else if (IS_ENABLED(CONFIG_SYS_ALT_MEMTEST)) {
 			errs = mem_test_alt(buf, start, end, dummy);
 			if (errs == -1UL)
 				break;
@@ -1413,9 +1583,14 @@ U_BOOT_CMD(
 
 #ifdef CONFIG_CMD_MEMTEST
 U_BOOT_CMD(
-	mtest,	5,	1,	do_mem_mtest,
+	mtest,	6,	1,	do_mem_mtest,
 	"simple RAM read/write test",
+#ifdef CONFIG_SYS_MEMTEST_FAST
+	"[-f] [start [end [pattern [iterations]]]]\n"
+	"  -f = fast test using all CPUs, showing bandwidth"
+#else
 	"[start [end [pattern [iterations]]]]"
+#endif
 );
 #endif	/* CONFIG_CMD_MEMTEST */
 
@@ -13,6 +13,7 @@
 #include <command.h>
 #include <dm.h>
 #include <dm/devres.h>
+#include <dm/uclass-internal.h>
 #include <env.h>
 #include <image.h>
 #include <log.h>
@@ -21,6 +22,7 @@
 #include <net/udp.h>
 #include <net/sntp.h>
 #include <net/ncsi.h>
+#include <net/wget.h>
 
 static int netboot_common(enum proto_t, struct cmd_tbl *, int, char * const []);
 
@@ -196,13 +198,27 @@ U_BOOT_CMD(
 #if defined(CONFIG_CMD_WGET)
 static int do_wget(struct cmd_tbl *cmdtp, int flag, int argc, char * const argv[])
 {
-	return netboot_common(WGET, cmdtp, argc, argv);
+	ulong start = 0, size = 0;
+	int ret;
+
+	if (argc > 3) {
+		start = hextoul(argv[3], NULL);
+		if (argc > 4)
+			size = hextoul(argv[4], NULL);
+		argc = 3;
+	}
+
+	wget_set_range(start, size);
+	ret = netboot_common(WGET, cmdtp, argc, argv);
+	wget_set_range(0, 0);
+
+	return ret;
 }
 
 U_BOOT_CMD(
-	wget,   3,      1,      do_wget,
+	wget,   5,      1,      do_wget,
 	"boot image via network using HTTP protocol",
-	"[loadAddress] [[hostIPaddr:]path and image name]"
+	"[loadAddress] [[hostIPaddr:]path and image name] [offset [size]]"
 );
 #endif
 
@@ -674,3 +690,63 @@ U_BOOT_CMD(
 );
 
 #endif  /* CONFIG_CMD_LINK_LOCAL */
+
+#if defined(CONFIG_CMD_NET_STATS)
+static void net_show_stats(struct udevice *dev, bool clear)
+{
+	struct eth_stats *stats;
+
+	/* The counters live in uclass data, which only probed devices have */
+	if (!device_active(dev)) {
+		printf("%s: not probed\n", dev->name);
+		return;
+	}
+	stats = eth_get_stats(dev);
+	printf("%s%s:\n", dev->name, dev == eth_get_dev() ? " (active)" : "");
+	printf("  RX: %llu packets, %llu bytes, %lu errors, %lu dropped, %lu checksum errors\n",
+	       stats->rx_packets, stats->rx_bytes, stats->rx_errors,
+	       stats->rx_dropped, stats->rx_csum_errors);
+	printf("  TX: %llu packets, %llu bytes, %lu errors, %lu ring full\n",
+	       stats->tx_packets, stats->tx_bytes, stats->tx_errors,
+	       stats->tx_ring_full);
+	if (clear)
+		memset(stats, '\0', sizeof(*stats));
+}
+
+static int do_net_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	bool clear = false;
+
+	if (argc > 1 && !strcmp(argv[1], "-c")) {
+		clear = true;
+		argc--;
+		argv++;
+	}
+	if (argc > 2)
+		return CMD_RET_USAGE;
+
+	if (argc == 2) {
+		if (uclass_find_device_by_name(UCLASS_ETH, argv[1], &dev)) {
+			printf("No such device '%s'\n", argv[1]);
+			return CMD_RET_FAILURE;
+		}
+		net_show_stats(dev, clear);
+		return CMD_RET_SUCCESS;
+	}
+
+	uclass_id_foreach_dev(UCLASS_ETH, dev, uc)
+		net_show_stats(dev, clear);
+
+	return CMD_RET_SUCCESS;
+}
+
+U_BOOT_LONGHELP(net,
+	"stats [-c] [<dev>] - show the traffic counters of the network\n"
+	"                     devices; -c clears them afterwards");
+
+U_BOOT_CMD_WITH_SUBCMDS(net, "network interface information", net_help_text,
+	U_BOOT_SUBCMD_MKENT(stats, 3, 1, do_net_stats));
+#endif /* CONFIG_CMD_NET_STATS */
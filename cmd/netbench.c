@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Measure network throughput with a stream of UDP packets
+ *
+ * One board (or a host running a packet generator) sends with 'blast' while
+ * the other counts what arrives with 'sink'. No flow control is done, so the
+ * difference between the two counts shows how many packets were lost.
+ */
+
+#include <command.h>
+#include <net.h>
+#include <time.h>
+#include <vsprintf.h>
+#include <linux/math64.h>
+#include <net/udp.h>
+
+#define NETBENCH_PORT		5001
+#define NETBENCH_SIZE		1472
+#define NETBENCH_SECS		10
+/* How long to keep sending before letting the network loop receive */
+#define NETBENCH_BURST_US	5000
+
+/**
+ * struct netbench - state of a benchmark run
+ *
+ * @port: UDP port to send to or listen on
+ * @size: Size of the UDP payload to send
+ * @duration: How long to run, in milliseconds
+ * @start: Time the first packet was sent or received, in microseconds
+ * @last: Time the last packet was sent or received, in microseconds
+ * @packets: Packets sent or received
+ * @bytes: UDP payload bytes sent or received
+ * @ether: MAC address of the server; zero until ARP has resolved it
+ */
+struct netbench {
+	int port;
+	int size;
+	ulong duration;
+	ulong start;
+	ulong last;
+	u64 packets;
+	u64 bytes;
+	uchar ether[ARP_HLEN];
+};
+
+static struct netbench netbench;
+
+static void netbench_report(const char *what, struct netbench *nb)
+{
+	ulong us = nb->last - nb->start;
+	u64 rate;
+
+	if (!us)
+		us = 1;
+	/* Bytes per microsecond is MB/s; keep one decimal place */
+	rate = div_u64(nb->bytes * 10, us);
+	printf("%s: %llu packets, %llu bytes in %lu ms, %llu.%llu MB/s, %llu pps\n",
+	       what, nb->packets, nb->bytes, us / 1000, rate / 10, rate % 10,
+	       div_u64(nb->packets * 1000000, us));
+}
+
+static void netbench_sink_handler(uchar *pkt, unsigned int dport,
+				  struct in_addr sip, unsigned int sport,
+				  unsigned int len)
+{
+	struct netbench *nb = &netbench;
+
+	if (dport != nb->port)
+		return;
+	nb->last = timer_get_us();
+	if (!nb->packets)
+		nb->start = nb->last;
+	nb->packets++;
+	nb->bytes += len;
+}
+
+static void netbench_sink_timeout(void)
+{
+	net_set_state(NETLOOP_SUCCESS);
+}
+
+static int netbench_sink_start(void *data)
+{
+	struct netbench *nb = data;
+
+	printf("Listening on UDP port %d for %lu s\n", nb->port,
+	       nb->duration / 1000);
+	net_set_udp_handler(netbench_sink_handler);
+	net_set_timeout_handler(nb->duration, netbench_sink_timeout);
+
+	return 0;
+}
+
+static int netbench_send(struct netbench *nb)
+{
+	return net_send_udp_packet(nb->ether, net_server_ip, nb->port,
+				   nb->port, nb->size);
+}
+
+static void netbench_blast_timeout(void)
+{
+	struct netbench *nb = &netbench;
+	ulong now = timer_get_us();
+	ulong burst = now;
+
+	/* Still waiting for the ARP reply, which sends the first packet */
+	if (is_zero_ethaddr(nb->ether)) {
+		if (now - nb->start > nb->duration * 1000) {
+			printf("No ARP reply from %pI4\n", &net_server_ip);
+			net_set_state(NETLOOP_FAIL);
+			return;
+		}
+		net_set_timeout_handler(10, netbench_blast_timeout);
+		return;
+	}
+
+	/* Time from the first burst, leaving out the ARP exchange */
+	if (!nb->last)
+		nb->start = now;
+	while (now - burst < NETBENCH_BURST_US) {
+		netbench_send(nb);
+		nb->packets++;
+		nb->bytes += nb->size;
+		now = timer_get_us();
+	}
+	nb->last = now;
+
+	if (now - nb->start > nb->duration * 1000) {
+		net_set_state(NETLOOP_SUCCESS);
+		return;
+	}
+	/* Come back straight away, once any received packets are handled */
+	net_set_timeout_handler(0, netbench_blast_timeout);
+}
+
+static int netbench_blast_start(void *data)
+{
+	struct netbench *nb = data;
+	uchar *payload;
+
+	printf("Sending %d-byte packets to %pI4:%d for %lu s\n", nb->size,
+	       &net_server_ip, nb->port, nb->duration / 1000);
+
+	/* The headers are rewritten for each packet but the payload is not */
+	payload = net_tx_packet + net_eth_hdr_size() + IP_UDP_HDR_SIZE;
+	memset(payload, 0x5a, nb->size);
+
+	memset(nb->ether, '\0', ARP_HLEN);
+	nb->start = timer_get_us();
+	/*
+	 * This sends an ARP request first; the reply fills in nb->ether and
+	 * sends the packet
+	 */
+	netbench_send(nb);
+	nb->packets++;
+	nb->bytes += nb->size;
+	net_set_timeout_handler(0, netbench_blast_timeout);
+
+	return 0;
+}
+
+static int netbench_parse(struct netbench *nb, int argc, char *const argv[],
+			  int max_size)
+{
+	memset(nb, '\0', sizeof(*nb));
+	nb->port = NETBENCH_PORT;
+	nb->size = NETBENCH_SIZE;
+	nb->duration = NETBENCH_SECS * 1000;
+
+	if (argc > 1)
+		nb->duration = dectoul(argv[1], NULL) * 1000;
+	if (argc > 2)
+		nb->port = dectoul(argv[2], NULL);
+	if (argc > 3)
+		nb->size = dectoul(argv[3], NULL);
+	if (!nb->duration || !nb->port || nb->port > 0xffff)
+		return -EINVAL;
+	if (nb->size < 1 || nb->size > max_size) {
+		printf("Size must be 1 to %d bytes\n", max_size);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int do_netbench_sink(struct cmd_tbl *cmdtp, int flag, int argc,
+			    char *const argv[])
+{
+	struct udp_ops ops = {
+		.start = netbench_sink_start,
+		.data = &netbench,
+	};
+
+	if (argc > 3 || netbench_parse(&netbench, argc, argv, NETBENCH_SIZE))
+		return CMD_RET_USAGE;
+
+	if (udp_loop(&ops) < 0)
+		return CMD_RET_FAILURE;
+	netbench_report("received", &netbench);
+
+	return 0;
+}
+
+static int do_netbench_blast(struct cmd_tbl *cmdtp, int flag, int argc,
+			     char *const argv[])
+{
+	struct udp_ops ops = {
+		.start = netbench_blast_start,
+		.data = &netbench,
+	};
+	int max_size = PKTSIZE - ETHER_HDR_SIZE - IP_UDP_HDR_SIZE;
+
+	if (netbench_parse(&netbench, argc, argv, max_size))
+		return CMD_RET_USAGE;
+
+	net_server_ip = env_get_ip("serverip");
+	if (!net_server_ip.s_addr) {
+		printf("serverip not set\n");
+		return CMD_RET_FAILURE;
+	}
+
+	if (udp_loop(&ops) < 0)
+		return CMD_RET_FAILURE;
+	netbench_report("sent", &netbench);
+
+	return 0;
+}
+
+U_BOOT_LONGHELP(netbench,
+	"sink [<secs> [<port>]]\n"
+	"    - count the UDP packets arriving on <port> (default 5001) for\n"
+	"      <secs> seconds (default 10)\n"
+	"netbench blast [<secs> [<port> [<size>]]]\n"
+	"    - send UDP packets with <size> bytes of payload (default 1472) to\n"
+	"      $serverip:<port> as fast as possible for <secs> seconds");
+
+U_BOOT_CMD_WITH_SUBCMDS(netbench, "measure network throughput",
+	netbench_help_text,
+	U_BOOT_SUBCMD_MKENT(sink, 3, 0, do_netbench_sink),
+	U_BOOT_SUBCMD_MKENT(blast, 4, 0, do_netbench_blast));
@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Show counts and times for events and device probes
+ */
+
+#include <command.h>
+#include <dm.h>
+#include <event.h>
+#include <event_stats.h>
+#include <malloc.h>
+#include <sort.h>
+#include <vsprintf.h>
+#include <dm/lists.h>
+#include <linux/kernel.h>
+
+/**
+ * struct perf_ent - an entry to show
+ *
+ * @name: Name of the event, uclass or driver
+ * @stat: Its count and time
+ */
+struct perf_ent {
+	const char *name;
+	const struct event_stat *stat;
+};
+
+static int h_cmp_time(const void *v1, const void *v2)
+{
+	const struct perf_ent *e1 = v1, *e2 = v2;
+
+	if (e1->stat->time_us != e2->stat->time_us)
+		return e1->stat->time_us < e2->stat->time_us ? 1 : -1;
+
+	return (int)e2->stat->count - (int)e1->stat->count;
+}
+
+/* Show the entries which have a count, slowest first */
+static void perf_show(const char *title, struct perf_ent *ent, int count)
+{
+	int i;
+
+	qsort(ent, count, sizeof(*ent), h_cmp_time);
+	printf("%-24s %10s %12s\n", title, "Count", "Time (us)");
+	for (i = 0; i < count; i++) {
+		if (ent[i].stat->count)
+			printf("%-24s %10u %12u\n", ent[i].name,
+			       ent[i].stat->count, ent[i].stat->time_us);
+	}
+	printf("\n");
+}
+
+static int do_perf_show(struct cmd_tbl *cmdtp, int flag, int argc,
+			char *const argv[])
+{
+	struct event_stats *stats = event_stats_get();
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	char names[EVT_COUNT][12];
+	struct perf_ent *ent;
+	int i, count;
+
+	if (!stats) {
+		printf("No stats recorded\n");
+		return CMD_RET_FAILURE;
+	}
+	ent = calloc(max(max((int)EVT_COUNT, (int)UCLASS_COUNT),
+			 stats->num_drivers), sizeof(*ent));
+	if (!ent) {
+		printf("Out of memory\n");
+		return CMD_RET_FAILURE;
+	}
+
+	for (i = 0; i < EVT_COUNT; i++) {
+		ent[i].stat = &stats->event[i];
+		ent[i].name = event_type_name(i);
+		if (!CONFIG_IS_ENABLED(EVENT_DEBUG)) {
+			snprintf(names[i], sizeof(names[i]), "event-%d", i);
+			ent[i].name = names[i];
+		}
+	}
+	perf_show("Event", ent, EVT_COUNT);
+
+	for (i = count = 0; i < UCLASS_COUNT; i++) {
+		struct uclass_driver *uc_drv;
+
+		if (!stats->uclass[i].count)
+			continue;
+		uc_drv = lists_uclass_lookup(i);
+		if (uc_drv) {
+			ent[count].name = uc_drv->name;
+			ent[count++].stat = &stats->uclass[i];
+		}
+	}
+	perf_show("Uclass", ent, count);
+
+	for (i = 0; i < stats->num_drivers; i++) {
+		ent[i].name = drv[i].name;
+		ent[i].stat = &stats->driver[i];
+	}
+	perf_show("Driver", ent, stats->num_drivers);
+	free(ent);
+
+	return 0;
+}
+
+static int do_perf_reset(struct cmd_tbl *cmdtp, int flag, int argc,
+			 char *const argv[])
+{
+	event_stats_reset();
+
+	return 0;
+}
+
+U_BOOT_LONGHELP(perf,
+	"show - show event and device-probe counts and times\n"
+	"perf reset - set all counts and times to zero");
+
+U_BOOT_CMD_WITH_SUBCMDS(perf, "show boot performance counters", perf_help_text,
+	U_BOOT_SUBCMD_MKENT(show, 1, 1, do_perf_show),
+	U_BOOT_SUBCMD_MKENT(reset, 1, 1, do_perf_reset));
@@ -163,57 +163,10 @@ static int do_spi_flash_probe(int argc, char *const argv[])
 	return 0;
 }
 
-/**
- * Write a block of data to SPI flash, first checking if it is different from
- * what is already there.
- *
- * If the data being written is the same, then *skipped is incremented by len.
- *
- * @param flash		flash context pointer
- * @param offset	flash offset to write
- * @param len		number of bytes to write
- * @param buf		buffer to write from
- * @param cmp_buf	read buffer to use to compare data
- * @param skipped	Count of skipped data (incremented by this function)
- * Return: NULL if OK, else a string containing the stage which failed
- */
-static const char *spi_flash_update_block(struct spi_flash *flash, u32 offset,
-		size_t len, const char *buf, char *cmp_buf, size_t *skipped)
-{
-	char *ptr = (char *)buf;
-	u32 start_offset = offset % flash->sector_size;
-	u32 read_offset = offset - start_offset;
-
-	debug("offset=%#x+%#x, sector_size=%#x, len=%#zx\n",
-	      read_offset, start_offset, flash->sector_size, len);
-	/* Read the entire sector so to allow for rewriting */
-	if (spi_flash_read(flash, read_offset, flash->sector_size, cmp_buf))
-		return "read";
-	/* Compare only what is meaningful (len) */
-	if (memcmp(cmp_buf + start_offset, buf, len) == 0) {
-		debug("Skip region %x+%x size %zx: no change\n",
-		      start_offset, read_offset, len);
-		*skipped += len;
-		return NULL;
-	}
-	/* Erase the entire sector */
-	if (spi_flash_erase(flash, offset, flash->sector_size))
-		return "erase";
-	/* If it's a partial sector, copy the data into the temp-buffer */
-	if (len != flash->sector_size) {
-		memcpy(cmp_buf + start_offset, buf, len);
-		ptr = cmp_buf;
-	}
-	/* Write one complete sector */
-	if (spi_flash_write(flash, offset, flash->sector_size, ptr))
-		return "write";
-
-	return NULL;
-}
-
 /**
  * Update an area of SPI flash by erasing and writing any blocks which need
- * to change. Existing blocks with the correct data are left unchanged.
+ * to change. Existing blocks with the correct data are left unchanged, and
+ * blocks which only need bits cleared are programmed without an erase.
  *
  * @param flash		flash context pointer
  * @param offset	flash offset to write
@@ -251,8 +204,9 @@ static int spi_flash_update(struct spi_flash *flash, u32 offset,
 							 start_time));
 				last_update = get_timer(0);
 			}
-			err_oper = spi_flash_update_block(flash, offset, todo,
-					buf, cmp_buf, &skipped);
+			if (spi_flash_update_sector(flash, offset, todo, buf,
+						    cmp_buf, &skipped))
+				err_oper = "update";
 		}
 	} else {
 		err_oper = "malloc";
@@ -4,7 +4,9 @@
  */
 
 #include <command.h>
+#include <errno.h>
 #include <env.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <trace.h>
 #include <vsprintf.h>
@@ -76,12 +78,94 @@ static int create_call_list(int argc, char *const argv[])
 	return 0;
 }
 
+/**
+ * export_samples() - Export the samples taken by the sampling profiler
+ *
+ * Sampling is stopped first. With no address, folded stacks are printed.
+ *
+ * @pprof: true to export a pprof profile, false for folded stacks
+ * @argc: Number of arguments, starting with the addr
+ * @argv: Arguments: [<addr> [<size>]]
+ * Return: 0 if OK, -ve on error
+ */
+static int export_samples(bool pprof, int argc, char *const argv[])
+{
+	ulong addr, size;
+	char *buf;
+	int len;
+
+	trace_sample_stop();
+	len = pprof ? trace_sample_pprof(NULL, 0) : trace_sample_folded(NULL, 0);
+	if (!argc) {
+		if (pprof)
+			return -EINVAL;
+		buf = malloc(len + 1);
+		if (!buf)
+			return -ENOMEM;
+		trace_sample_folded(buf, len + 1);
+		puts(buf);
+		free(buf);
+
+		return 0;
+	}
+
+	addr = hextoul(argv[0], NULL);
+	size = argc > 1 ? hextoul(argv[1], NULL) : len + !pprof;
+	buf = map_sysmem(addr, size);
+	if (pprof)
+		len = trace_sample_pprof(buf, size);
+	else
+		len = trace_sample_folded(buf, size);
+	unmap_sysmem(buf);
+	if (len + !pprof > size) {
+		printf("Error: truncated (%#x bytes needed)\n", len + !pprof);
+		return -ENOSPC;
+	}
+	env_set_hex("filesize", len);
+
+	return 0;
+}
+
+static int do_trace_sample(int argc, char *const argv[])
+{
+	const char *cmd = argc < 2 ? "stats" : argv[1];
+	uint hz;
+	int ret;
+
+	if (!CONFIG_IS_ENABLED(TRACE_SAMPLE))
+		return CMD_RET_USAGE;
+
+	if (!strcmp(cmd, "start")) {
+		hz = argc > 2 ? dectoul(argv[2], NULL) : 1000;
+		ret = trace_sample_start(hz);
+		if (ret) {
+			printf("Cannot start sampling (err=%dE)\n", ret);
+			return CMD_RET_FAILURE;
+		}
+	} else if (!strcmp(cmd, "stop")) {
+		trace_sample_stop();
+	} else if (!strcmp(cmd, "stats")) {
+		trace_sample_print_stats();
+	} else if (!strcmp(cmd, "folded") || !strcmp(cmd, "pprof")) {
+		if (export_samples(*cmd == 'p', argc - 2, argv + 2))
+			return CMD_RET_FAILURE;
+	} else {
+		return CMD_RET_USAGE;
+	}
+
+	return 0;
+}
+
 int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 {
 	const char *cmd = argc < 2 ? NULL : argv[1];
 
 	if (!cmd)
 		return cmd_usage(cmdtp);
+	if (!strcmp(cmd, "sample"))
+		return do_trace_sample(argc - 1, argv + 1);
+	if (!IS_ENABLED(CONFIG_TRACE))
+		return CMD_RET_USAGE;
 	switch (*cmd) {
 	case 'p':
 		trace_set_enabled(0);
@@ -108,7 +192,7 @@ int do_trace(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 }
 
 U_BOOT_CMD(
-	trace,	4,	1,	do_trace,
+	trace,	5,	1,	do_trace,
 	"trace utility commands",
 	"stats                        - display tracing statistics\n"
 	"trace pause                        - pause tracing\n"
@@ -116,4 +200,13 @@ U_BOOT_CMD(
 	"trace funclist [<addr> <size>]     - dump function list into buffer\n"
 	"trace calls  [<addr> <size>]       "
 		"- dump function call trace into buffer"
+#if CONFIG_IS_ENABLED(TRACE_SAMPLE)
+	"\ntrace sample start [<hz>]          - start sampling (default 1000Hz)\n"
+	"trace sample stop                  - stop sampling\n"
+	"trace sample stats                 - display sampling statistics\n"
+	"trace sample folded [<addr> [<size>]]\n"
+	"                                   - write folded stacks (to console\n"
+	"                                     if no <addr>)\n"
+	"trace sample pprof <addr> [<size>] - write a pprof CPU profile"
+#endif
 );
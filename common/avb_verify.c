@@ -595,6 +595,45 @@ static AvbIOResult read_from_partition(AvbOps *ops,
 			   num_bytes, buffer, out_num_read, IO_READ);
 }
 
+/**
+ * get_preloaded_partition() - gets a partition which is already in memory
+ *
+ * This lets libavb hash a partition where the caller has already loaded it,
+ * rather than reading it a second time into a buffer of its own.
+ *
+ * @ops: contains AVB ops handlers
+ * @partition: partition name, NUL-terminated UTF-8 string
+ * @num_bytes: number of bytes needed from the start of the partition
+ * @out_pointer: returns the partition contents, or NULL if not preloaded
+ * @out_num_bytes_preloaded: returns the number of bytes available
+ *
+ * @return:
+ *      AVB_IO_RESULT_OK always; libavb reads the partition itself if
+ *      @out_pointer is NULL
+ */
+static AvbIOResult get_preloaded_partition(AvbOps *ops,
+					   const char *partition,
+					   size_t num_bytes,
+					   u8 **out_pointer,
+					   size_t *out_num_bytes_preloaded)
+{
+	struct AvbOpsData *data = ops->user_data;
+	int i;
+
+	*out_pointer = NULL;
+	for (i = 0; i < data->num_preloaded; i++) {
+		struct avb_preloaded_part *pre = &data->preloaded[i];
+
+		if (strcmp(pre->name, partition) || pre->size < num_bytes)
+			continue;
+		*out_pointer = pre->addr;
+		*out_num_bytes_preloaded = num_bytes;
+		break;
+	}
+
+	return AVB_IO_RESULT_OK;
+}
+
 /**
  * write_to_partition() - writes N bytes to a partition identified by a string
  * name
@@ -1043,6 +1082,7 @@ AvbOps *avb_ops_alloc(int boot_device)
 	ops_data->ops.user_data = ops_data;
 
 	ops_data->ops.read_from_partition = read_from_partition;
+	ops_data->ops.get_preloaded_partition = get_preloaded_partition;
 	ops_data->ops.write_to_partition = write_to_partition;
 	ops_data->ops.validate_vbmeta_public_key = validate_vbmeta_public_key;
 	ops_data->ops.read_rollback_index = read_rollback_index;
@@ -1060,6 +1100,39 @@ AvbOps *avb_ops_alloc(int boot_device)
 	return &ops_data->ops;
 }
 
+/**
+ * avb_add_preloaded_partition() - tell AVB that a partition is in memory
+ *
+ * Verification then hashes the partition at @addr instead of reading it
+ * from the boot device again. The memory must stay valid until the
+ * verification data has been freed.
+ *
+ * @ops: AvbOps from avb_ops_alloc()
+ * @partition: partition name, including any slot suffix, e.g. "boot_a"
+ * @addr: address of the partition contents
+ * @size: number of bytes loaded from the start of the partition
+ * Return: 0 if OK, -ENOSPC if too many partitions are preloaded, -EINVAL if
+ * the name is too long
+ */
+int avb_add_preloaded_partition(AvbOps *ops, const char *partition,
+				void *addr, size_t size)
+{
+	struct AvbOpsData *data = ops->user_data;
+	struct avb_preloaded_part *pre;
+
+	if (data->num_preloaded == AVB_MAX_PRELOADED)
+		return -ENOSPC;
+	if (strlen(partition) >= PART_NAME_LEN)
+		return -EINVAL;
+
+	pre = &data->preloaded[data->num_preloaded++];
+	strcpy(pre->name, partition);
+	pre->addr = addr;
+	pre->size = size;
+
+	return 0;
+}
+
 void avb_ops_free(AvbOps *ops)
 {
 	struct AvbOpsData *ops_data;
@@ -22,6 +22,7 @@
 #include <env.h>
 #include <env_internal.h>
 #include <event.h>
+#include <event_stats.h>
 #include <fdtdec.h>
 #include <fs.h>
 #include <hang.h>
@@ -463,9 +464,32 @@ static int reserve_trace(void)
 	return 0;
 }
 
+/*
+ * Check whether U-Boot is already running close enough below the area
+ * reserved so far, that it can stay where it is. Relocation then neither
+ * copies the image nor applies any fixups.
+ */
+static bool reloc_in_place(void)
+{
+#ifdef CONFIG_RELOC_IN_PLACE
+	ulong start = (ulong)__image_copy_start;
+
+	if (start & (4096 - 1) || start + gd->mon_len > gd->relocaddr ||
+	    start + gd->mon_len + CONFIG_RELOC_IN_PLACE_GAP < gd->relocaddr)
+		return false;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
 static int reserve_uboot(void)
 {
-	if (!(gd->flags & GD_FLG_SKIP_RELOC)) {
+	if (reloc_in_place()) {
+		gd->relocaddr = (ulong)__image_copy_start;
+		debug("U-Boot stays at: %08lx\n", gd->relocaddr);
+	} else if (!(gd->flags & GD_FLG_SKIP_RELOC)) {
 		/*
 		 * reserve memory for U-Boot code, data & bss
 		 * round down to next 4 kB limit
@@ -593,6 +617,20 @@ static int reserve_bootstage(void)
 	return 0;
 }
 
+static int reserve_event_stats(void)
+{
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+	int size = event_stats_get_size();
+
+	gd->start_addr_sp = reserve_stack_aligned(size);
+	gd->boardf->new_event_stats = map_sysmem(gd->start_addr_sp, size);
+	debug("Reserving %#x Bytes for event stats at: %08lx\n", size,
+	      gd->start_addr_sp);
+#endif
+
+	return 0;
+}
+
 __weak int arch_reserve_stacks(void)
 {
 	return 0;
@@ -682,6 +720,18 @@ static int reloc_bootstage(void)
 	return 0;
 }
 
+static int reloc_event_stats(void)
+{
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+	if (gd->flags & GD_FLG_SKIP_RELOC)
+		return 0;
+	if (gd->boardf->new_event_stats)
+		event_stats_relocate(gd->boardf->new_event_stats);
+#endif
+
+	return 0;
+}
+
 static int reloc_bloblist(void)
 {
 #ifdef CONFIG_BLOBLIST
@@ -974,6 +1024,7 @@ static const init_fnc_t init_sequence_f[] = {
 	fix_fdt,
 #endif
 	reserve_bootstage,
+	reserve_event_stats,
 	reserve_bloblist,
 	reserve_arch,
 	reserve_stacks,
@@ -987,6 +1038,7 @@ static const init_fnc_t init_sequence_f[] = {
 	reloc_fdt,
 #endif
 	reloc_bootstage,
+	reloc_event_stats,
 	reloc_bloblist,
 	setup_reloc,
 #if defined(CONFIG_X86) || defined(CONFIG_ARC)
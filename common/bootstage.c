@@ -16,6 +16,7 @@
 #include <malloc.h>
 #include <sort.h>
 #include <spl.h>
+#include <vsprintf.h>
 #include <asm/global_data.h>
 #include <linux/compiler.h>
 #include <linux/libfdt.h>
@@ -24,6 +25,9 @@ DECLARE_GLOBAL_DATA_PTR;
 
 enum {
 	RECORD_COUNT = CONFIG_VAL(BOOTSTAGE_RECORD_COUNT),
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	SPAN_COUNT = CONFIG_BOOTSTAGE_SPAN_COUNT,
+#endif
 };
 
 struct bootstage_record {
@@ -34,10 +38,35 @@ struct bootstage_record {
 	enum bootstage_id id;
 };
 
+/**
+ * struct bootstage_span - A span of boot activity
+ *
+ * @name: Name of the span, or NULL to use @addr
+ * @addr: Address of the code the span covers, if any
+ * @start_us: Time the span started
+ * @end_us: Time the span ended, or 0 if it is still open
+ * @parent: Span which was open when this one started, or -1 if none
+ * @cat: Category of the span (enum bootstage_span_cat)
+ */
+struct bootstage_span {
+	const char *name;
+	ulong addr;
+	u32 start_us;
+	u32 end_us;
+	s16 parent;
+	u8 cat;
+};
+
 struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	uint span_count;
+	int span_cur;		/* Innermost open span, or -1 if none */
+	uint span_lost;		/* Spans not recorded, for lack of space */
+	struct bootstage_span span[SPAN_COUNT];
+#endif
 };
 
 enum {
@@ -79,6 +108,17 @@ int bootstage_relocate(void *to)
 		data->record[i].name = ptr;
 		ptr += strlen(ptr) + 1;
 	}
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	for (i = 0; i < data->span_count; i++) {
+		const char *from = data->span[i].name;
+
+		if (!from)
+			continue;
+		strcpy(ptr, from);
+		data->span[i].name = ptr;
+		ptr += strlen(ptr) + 1;
+	}
+#endif
 
 	return 0;
 }
@@ -206,6 +246,67 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name)
 	return start_us;
 }
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+int bootstage_span_begin(enum bootstage_span_cat cat, const char *name,
+			 ulong addr)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span;
+	int num;
+
+	if (!data)
+		return -ENOENT;
+	if (data->span_count == SPAN_COUNT) {
+		data->span_lost++;
+		return -ENOSPC;
+	}
+	num = data->span_count++;
+	span = &data->span[num];
+	span->name = name;
+	span->addr = addr;
+	span->start_us = timer_get_boot_us();
+	span->end_us = 0;
+	span->parent = data->span_cur;
+	span->cat = cat;
+	data->span_cur = num;
+
+	return num;
+}
+
+void bootstage_span_end(int num)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span;
+
+	if (num < 0 || !data || num >= data->span_count)
+		return;
+	span = &data->span[num];
+	span->end_us = timer_get_boot_us();
+	/* Don't leave the end as 0, since that means the span is open */
+	if (!span->end_us)
+		span->end_us = 1;
+	data->span_cur = span->parent;
+}
+
+/**
+ * get_span_name() - Get a span name as a printable string
+ *
+ * @buf: Buffer to put the name in, if needed
+ * @len: Length of buffer
+ * @span: Span to get the name of
+ * Return: pointer to name, either from the span or pointing to buf
+ */
+static const char *get_span_name(char *buf, int len,
+				 const struct bootstage_span *span)
+{
+	if (span->name)
+		return span->name;
+	snprintf(buf, len, "%#lx", span->addr);
+
+	return buf;
+}
+#endif
+
 uint32_t bootstage_accum(enum bootstage_id id)
 {
 	struct bootstage_data *data = gd->bootstage;
@@ -265,6 +366,62 @@ static int h_compare_record(const void *r1, const void *r2)
 }
 
 #ifdef CONFIG_OF_LIBFDT
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+/**
+ * add_spans_devicetree() - Add the bootstage spans to a device tree
+ *
+ * This adds a 'spans' node holding a property for each field of the spans,
+ * each with one entry per span, in the order the spans started
+ *
+ * @blob: Device tree blob
+ * @bootstage: Offset of the bootstage node
+ * Return: 0 on success, -EINVAL on failure
+ */
+static int add_spans_devicetree(void *blob, int bootstage)
+{
+	static const char *const props[] = {
+		"start-us", "end-us", "parent", "category",
+	};
+	struct bootstage_data *data = gd->bootstage;
+	fdt32_t *cells[ARRAY_SIZE(props)];
+	char buf[20];
+	int node, i, j;
+
+	node = fdt_add_subnode(blob, bootstage, "spans");
+	if (node < 0)
+		return -EINVAL;
+	for (i = 0; i < data->span_count; i++) {
+		if (fdt_appendprop_string(blob, node, "names",
+					  get_span_name(buf, sizeof(buf),
+							&data->span[i])))
+			return -EINVAL;
+	}
+	for (j = 0; j < ARRAY_SIZE(props); j++) {
+		if (fdt_setprop_placeholder(blob, node, props[j],
+					    data->span_count * sizeof(fdt32_t),
+					    (void **)&cells[j]))
+			return -EINVAL;
+	}
+
+	/* The placeholders may move as each is added, so look them up */
+	for (j = 0; j < ARRAY_SIZE(props); j++) {
+		cells[j] = fdt_getprop_w(blob, node, props[j], NULL);
+		if (!cells[j])
+			return -EINVAL;
+	}
+	for (i = 0; i < data->span_count; i++) {
+		const struct bootstage_span *span = &data->span[i];
+
+		cells[0][i] = cpu_to_fdt32(span->start_us);
+		cells[1][i] = cpu_to_fdt32(span->end_us);
+		cells[2][i] = cpu_to_fdt32(span->parent);
+		cells[3][i] = cpu_to_fdt32(span->cat);
+	}
+
+	return 0;
+}
+#endif
+
 /**
  * Add all bootstage timings to a device tree.
  *
@@ -317,7 +474,11 @@ static int add_bootstages_devicetree(struct fdt_header *blob)
 			return -EINVAL;
 	}
 
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	return add_spans_devicetree(blob, bootstage);
+#else
 	return 0;
+#endif
 }
 
 int bootstage_fdt_add_report(void)
@@ -361,6 +522,109 @@ void bootstage_report(void)
 	}
 }
 
+/**
+ * struct json_out - Output buffer for bootstage_export_json()
+ *
+ * @buf: Buffer to write to
+ * @size: Size of the buffer
+ * @len: Length of the output so far, which may exceed @size
+ */
+struct json_out {
+	char *buf;
+	int size;
+	int len;
+};
+
+static __printf(2, 3)
+void json_printf(struct json_out *out, const char *fmt, ...)
+{
+	int avail = out->size > out->len ? out->size - out->len : 0;
+	va_list args;
+
+	va_start(args, fmt);
+	out->len += vsnprintf(avail ? out->buf + out->len : NULL, avail, fmt,
+			      args);
+	va_end(args);
+}
+
+/* Write a quoted JSON string */
+static void json_string(struct json_out *out, const char *str)
+{
+	json_printf(out, "\"");
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			json_printf(out, "\\%c", *str);
+		else if ((unsigned char)*str < ' ')
+			json_printf(out, "\\u%04x", *str);
+		else
+			json_printf(out, "%c", *str);
+	}
+	json_printf(out, "\"");
+}
+
+int bootstage_export_json(char *buf, int size)
+{
+	static const char *const __maybe_unused
+			cat_name[BOOTSTAGE_SPAN_CAT_COUNT] = {
+		"user", "initcall", "probe",
+	};
+	struct bootstage_data *data = gd->bootstage;
+	struct json_out out = { buf, size, 0 };
+	const struct bootstage_record *rec;
+	__maybe_unused uint32_t now;
+	bool first;
+	char name[20];
+	int i;
+
+	json_printf(&out, "{\"traceEvents\":[\n"
+		    "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,"
+		    "\"tid\":0,\"args\":{\"name\":\"U-Boot\"}}");
+	for (rec = data->record, i = 0; i < data->rec_count; i++, rec++) {
+		if (rec->start_us)
+			continue;
+		json_printf(&out, ",\n{\"name\":");
+		json_string(&out, get_record_name(name, sizeof(name), rec));
+		json_printf(&out, ",\"cat\":\"mark\",\"ph\":\"i\",\"s\":\"g\","
+			    "\"ts\":%lu,\"pid\":0,\"tid\":0}", rec->time_us);
+	}
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	now = timer_get_boot_us();
+	for (i = 0; i < data->span_count; i++) {
+		const struct bootstage_span *span = &data->span[i];
+		u32 end = span->end_us ? span->end_us : now;
+
+		json_printf(&out, ",\n{\"name\":");
+		json_string(&out, get_span_name(name, sizeof(name), span));
+		json_printf(&out, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%u,"
+			    "\"dur\":%u,\"pid\":0,\"tid\":0,"
+			    "\"args\":{\"span\":%d,\"parent\":%d}}",
+			    span->cat < BOOTSTAGE_SPAN_CAT_COUNT ?
+			    cat_name[span->cat] : "unknown", span->start_us,
+			    end - span->start_us, i, span->parent);
+	}
+#endif
+	json_printf(&out, "\n],\n\"displayTimeUnit\":\"ms\",\n"
+		    "\"otherData\":{");
+	first = true;
+	for (rec = data->record, i = 0; i < data->rec_count; i++, rec++) {
+		if (!rec->start_us)
+			continue;
+		if (!first)
+			json_printf(&out, ",");
+		first = false;
+		json_string(&out, get_record_name(name, sizeof(name), rec));
+		json_printf(&out, ":%lu", rec->time_us);
+	}
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	if (data->span_lost)
+		json_printf(&out, "%s\"spans_lost\":%u", first ? "" : ",",
+			    data->span_lost);
+#endif
+	json_printf(&out, "}}\n");
+
+	return out.len;
+}
+
 /**
  * Append data to a memory buffer
  *
@@ -531,6 +795,12 @@ int bootstage_get_size(void)
 	for (rec = data->record, i = 0; i < data->rec_count;
 	     i++, rec++)
 		size += strlen(rec->name) + 1;
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	for (i = 0; i < data->span_count; i++) {
+		if (data->span[i].name)
+			size += strlen(data->span[i].name) + 1;
+	}
+#endif
 
 	return size;
 }
@@ -545,6 +815,9 @@ int bootstage_init(bool first)
 		return -ENOMEM;
 	data = gd->bootstage;
 	memset(data, '\0', size);
+#if CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+	data->span_cur = -1;
+#endif
 	if (first) {
 		data->next_id = BOOTSTAGE_ID_USER;
 		bootstage_add_record(BOOTSTAGE_ID_AWAKE, "reset", 0, 0);
@@ -137,6 +137,11 @@ int run_command_list(const char *cmd, int len, int flag)
 		need_buff = strchr(cmd, '\n') != NULL;
 #endif
 	}
+#ifdef CONFIG_HUSH_PARSER
+	/* the old hush can run the commands where they are, e.g. a script */
+	if (need_buff && use_hush_old())
+		return parse_buffer_outer(cmd, len, FLAG_PARSE_SEMICOLON);
+#endif
 	if (need_buff) {
 		buff = malloc(len + 1);
 		if (!buff)
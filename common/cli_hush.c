@@ -84,6 +84,7 @@
 #include <cli_hush.h>
 #include <command.h>        /* find_cmd */
 #include <asm/global_data.h>
+#include <linux/errno.h>
 #endif
 #ifndef __U_BOOT__
 #include <ctype.h>     /* isalpha, isdigit */
@@ -326,6 +327,8 @@ struct in_str {
 	const unsigned char *p;
 #ifndef __U_BOOT__
 	char peek_buf[2];
+#else
+	const unsigned char *end;	/* end of a buffer, or NULL */
 #endif
 	int __promptme;
 	int promptmode;
@@ -926,13 +929,28 @@ static int b_adduint(o_string *o, unsigned int i)
 
 static int static_get(struct in_str *i)
 {
-	int ch = *i->p++;
+	int ch;
+#ifdef __U_BOOT__
+	if (i->end && i->p >= i->end) {
+		/* End the last line, as parse_string_outer() does */
+		if (i->p == i->end && i->end[-1] != '\n') {
+			i->p++;
+			return '\n';
+		}
+		return EOF;
+	}
+#endif
+	ch = *i->p++;
 	if (ch=='\0') return EOF;
 	return ch;
 }
 
 static int static_peek(struct in_str *i)
 {
+#ifdef __U_BOOT__
+	if (i->end && i->p >= i->end)
+		return i->p == i->end && i->end[-1] != '\n' ? '\n' : '\0';
+#endif
 	return *i->p;
 }
 
@@ -1166,6 +1184,9 @@ static void setup_string_in_str(struct in_str *i, const char *s)
 	i->__promptme=1;
 	i->promptmode=1;
 	i->p = s;
+#ifdef __U_BOOT__
+	i->end = NULL;
+#endif
 }
 
 #ifndef __U_BOOT__
@@ -1535,6 +1556,7 @@ static int run_pipe_real(struct pipe *pi)
 	struct child_prog *child;
 	struct built_in_command *x;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1547,6 +1569,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1613,6 +1636,11 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/*
+		 * Count in a copy, since the pipe is run again by loops and
+		 * by the run cache
+		 */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1621,11 +1649,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1752,11 +1780,28 @@ static int run_pipe_real(struct pipe *pi)
 	return -1;
 }
 
+#ifdef __U_BOOT__
+/*
+ * Put back the variable name of a "for" loop which is left early, since the
+ * pipe may be run again
+ */
+static void restore_for_list(struct pipe *pi, char *save_name, char **list,
+			     char **save_list)
+{
+	while (*list)
+		free(*list++);
+	free(save_list);
+	free(pi->progs->argv[0]);
+	pi->progs->argv[0] = save_name;
+}
+#endif
+
 static int run_list_real(struct pipe *pi)
 {
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *save_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1796,6 +1841,11 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
+					if (list)
+						restore_for_list(save_pipe,
+								 save_name,
+								 list,
+								 save_list);
 					return 1;
 				}
 #endif
@@ -1825,6 +1875,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				save_pipe = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1895,6 +1946,9 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
+			if (list)
+				restore_for_list(save_pipe, save_name, list,
+						 save_list);
 			return -2;	/* exit */
 		}
 		last_return_code = rcode;
@@ -3251,6 +3305,145 @@ static int parse_stream_outer(struct in_str *inp, int flag)
 #endif /* __U_BOOT__ */
 }
 
+#if CONFIG_IS_ENABLED(HUSH_RUN_CACHE)
+#define RUN_CACHE_SIZE	8
+
+/**
+ * struct run_cache_ent - a script kept in its parsed form
+ *
+ * Running the parsed script does not change it, in the same way that a loop
+ * runs its body more than once, so it can be run again next time.
+ *
+ * @text: Text of the script, or NULL if this entry is empty
+ * @len: Length of @text
+ * @list: Parsed script
+ * @busy: true while the script is running; a script which runs itself is
+ *	parsed again for the inner run, since a "for" loop changes its
+ *	variable while it runs
+ */
+struct run_cache_ent {
+	char *text;
+	int len;
+	struct pipe *list;
+	bool busy;
+};
+
+static struct run_cache_ent run_cache[RUN_CACHE_SIZE];
+static int run_cache_next;
+
+/* Parse a whole script without running it; returns NULL on a syntax error */
+static struct pipe *parse_string_list(const char *s, int flag)
+{
+	struct p_context ctx;
+	o_string temp = NULL_O_STRING;
+	struct in_str input;
+	int rcode;
+
+	setup_string_in_str(&input, s);
+	ctx.type = flag;
+	initialize_context(&ctx);
+	update_ifs_map();
+	if (!(flag & FLAG_PARSE_SEMICOLON) || (flag & FLAG_REPARSING))
+		mapset((uchar *)";$&|", 0);
+	input.promptmode = 1;
+	rcode = parse_stream(&temp, &ctx, &input, -1);
+	if (rcode == 1 || ctx.old_flag != 0) {
+		if (rcode != 1)
+			syntax();
+		if (ctx.old_flag != 0)
+			free(ctx.stack);
+		flag_repeat = 0;
+		b_free(&temp);
+		free_pipe_list(ctx.list_head, 0);
+		return NULL;
+	}
+	done_word(&temp, &ctx);
+	done_pipe(&ctx, PIPE_SEQ);
+	b_free(&temp);
+
+	return ctx.list_head;
+}
+
+static struct run_cache_ent *run_cache_find(const char *s, int len)
+{
+	int i;
+
+	for (i = 0; i < RUN_CACHE_SIZE; i++) {
+		struct run_cache_ent *ent = &run_cache[i];
+
+		if (ent->text && !ent->busy && ent->len == len &&
+		    !strcmp(ent->text, s))
+			return ent;
+	}
+
+	return NULL;
+}
+
+/* Find an entry to reuse, dropping the script in it; NULL if all are busy */
+static struct run_cache_ent *run_cache_evict(void)
+{
+	int i;
+
+	for (i = 0; i < RUN_CACHE_SIZE; i++) {
+		struct run_cache_ent *ent = &run_cache[run_cache_next];
+
+		run_cache_next = (run_cache_next + 1) % RUN_CACHE_SIZE;
+		if (ent->busy)
+			continue;
+		if (ent->text) {
+			free_pipe_list(ent->list, 0);
+			free(ent->text);
+			ent->text = NULL;
+		}
+		return ent;
+	}
+
+	return NULL;
+}
+
+/*
+ * Run a script from the environment, parsing it only if it is not in the
+ * cache. Returns -ENOENT if the cache cannot be used, else the same as
+ * parse_stream_outer()
+ */
+static int run_cache_run(const char *s, int flag)
+{
+	int len = strlen(s);
+	struct run_cache_ent *ent;
+	struct pipe *list;
+	char *p;
+	int code;
+
+	ent = run_cache_find(s, len);
+	if (!ent) {
+		ent = run_cache_evict();
+		if (!ent)
+			return -ENOENT;
+		/* The parser needs a newline at the end, as below */
+		p = xmalloc(len + 2);
+		strcpy(p, s);
+		strcat(p, "\n");
+		list = parse_string_list(p, flag);
+		free(p);
+		if (!list)
+			return 1;
+		ent->text = xstrdup(s);
+		ent->len = len;
+		ent->list = list;
+	}
+
+	ent->busy = true;
+	code = run_list_real(ent->list);
+	ent->busy = false;
+	if (code == -2)		/* exit */
+		return -2;
+	if (code == -1)
+		flag_repeat = 0;
+
+	return (code != 0) ? 1 : 0;
+}
+#endif
+
 #ifndef __U_BOOT__
 static int parse_string_outer(const char *s, int flag)
 #else
@@ -3265,6 +3458,14 @@ int parse_string_outer(const char *s, int flag)
 		return 1;
 	if (!*s)
 		return 0;
+#if CONFIG_IS_ENABLED(HUSH_RUN_CACHE)
+	/* Only 'run' passes this flag */
+	if (flag & FLAG_CONT_ON_NEWLINE) {
+		rcode = run_cache_run(s, flag);
+		if (rcode != -ENOENT)
+			return rcode == -2 ? last_return_code : rcode;
+	}
+#endif
 	if (!(p = strchr(s, '\n')) || *++p) {
 		p = xmalloc(strlen(s) + 2);
 		strcpy(p, s);
@@ -3283,6 +3484,22 @@ int parse_string_outer(const char *s, int flag)
 #endif
 }
 
+#ifdef __U_BOOT__
+int parse_buffer_outer(const char *buf, int len, int flag)
+{
+	struct in_str input;
+	int rcode;
+
+	if (!len)
+		return 0;
+	setup_string_in_str(&input, buf);
+	input.end = (const unsigned char *)buf + len;
+	rcode = parse_stream_outer(&input, flag);
+
+	return rcode == -2 ? last_return_code : rcode;
+}
+
+#endif
 #ifndef __U_BOOT__
 static int parse_file_outer(FILE *f)
 #else
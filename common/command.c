@@ -15,7 +15,9 @@
 #include <env.h>
 #include <image.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
+#include <sort.h>
 #include <time.h>
 #include <asm/global_data.h>
 #include <linux/ctype.h>
@@ -126,10 +128,77 @@ struct cmd_tbl *find_cmd_tbl(const char *cmd, struct cmd_tbl *table,
 	return NULL;	/* not found or ambiguous command */
 }
 
+#if CONFIG_IS_ENABLED(CMDLINE_INDEX)
+/* Command table sorted by name, allocated on first use after relocation */
+static struct cmd_tbl **cmd_index;
+
+static int h_cmp_cmd(const void *v1, const void *v2)
+{
+	const struct cmd_tbl *const *c1 = v1, *const *c2 = v2;
+
+	return strcmp((*c1)->name, (*c2)->name);
+}
+
+static struct cmd_tbl **cmd_index_get(struct cmd_tbl *table, int count)
+{
+	int i;
+
+	if (cmd_index || !(gd->flags & GD_FLG_RELOC))
+		return cmd_index;
+
+	cmd_index = malloc(count * sizeof(*cmd_index));
+	if (!cmd_index)
+		return NULL;
+	for (i = 0; i < count; i++)
+		cmd_index[i] = &table[i];
+	qsort(cmd_index, count, sizeof(*cmd_index), h_cmp_cmd);
+
+	return cmd_index;
+}
+
+/*
+ * Names with the same prefix are next to each other in the index, with an
+ * exact match first, so this gives the same result as find_cmd_tbl()
+ */
+static struct cmd_tbl *cmd_index_find(struct cmd_tbl **index, int count,
+				      const char *cmd)
+{
+	const char *p;
+	int lo, hi, len;
+
+	len = ((p = strchr(cmd, '.')) == NULL) ? strlen(cmd) : (p - cmd);
+
+	/* Find the first name which does not sort before the command */
+	for (lo = 0, hi = count; lo < hi;) {
+		int mid = (lo + hi) / 2;
+
+		if (strncmp(index[mid]->name, cmd, len) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == count || strncmp(index[lo]->name, cmd, len))
+		return NULL;	/* not found */
+	if (strlen(index[lo]->name) == len)
+		return index[lo];	/* full match */
+	if (lo + 1 < count && !strncmp(index[lo + 1]->name, cmd, len))
+		return NULL;	/* ambiguous */
+
+	return index[lo];	/* abbreviated command */
+}
+#endif
+
 struct cmd_tbl *find_cmd(const char *cmd)
 {
 	struct cmd_tbl *start = ll_entry_start(struct cmd_tbl, cmd);
 	const int len = ll_entry_count(struct cmd_tbl, cmd);
+
+#if CONFIG_IS_ENABLED(CMDLINE_INDEX)
+	struct cmd_tbl **index = cmd_index_get(start, len);
+
+	if (index && cmd)
+		return cmd_index_find(index, len, cmd);
+#endif
 	return find_cmd_tbl(cmd, start, len);
 }
 
@@ -11,6 +11,7 @@
 #include <cyclic.h>
 #include <log.h>
 #include <malloc.h>
+#include <task.h>
 #include <time.h>
 #include <linux/errno.h>
 #include <linux/list.h>
@@ -94,12 +95,20 @@ void schedule(void)
 	if (IS_ENABLED(CONFIG_HW_WATCHDOG))
 		hw_watchdog_reset();
 
+	/* A task yields here, to let the code it interrupted carry on */
+	if (CONFIG_IS_ENABLED(TASK) && task_current()) {
+		task_yield();
+		return;
+	}
+
 	/*
 	 * schedule() might get called very early before the cyclic IF is
 	 * ready. Make sure to only call cyclic_run() when it's initalized.
 	 */
-	if (gd)
+	if (gd) {
 		cyclic_run();
+		task_run_all();
+	}
 }
 
 int cyclic_unregister_all(void)
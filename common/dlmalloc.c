@@ -18,6 +18,8 @@
 #include <malloc.h>
 #include <asm/io.h>
 #include <valgrind/memcheck.h>
+#include <linux/build_bug.h>
+#include <linux/log2.h>
 
 #ifdef DEBUG
 #if __STD_C
@@ -31,12 +33,18 @@ void malloc_stats();
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE) && defined(MCHECK_HEAP_PROTECTION)
+#error "CONFIG_SYS_MALLOC_PROFILE cannot be used with MCHECK_HEAP_PROTECTION"
+#endif
+
 #ifdef MCHECK_HEAP_PROTECTION
  #define STATIC_IF_MCHECK static
  #undef MALLOC_COPY
  #undef MALLOC_ZERO
 static inline void MALLOC_ZERO(void *p, size_t sz) { memset(p, 0, sz); }
 static inline void MALLOC_COPY(void *dest, const void *src, size_t sz) { memcpy(dest, src, sz); }
+#elif CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE)
+ #define STATIC_IF_MCHECK static
 #else
  #define STATIC_IF_MCHECK
  #define mALLOc_impl mALLOc
@@ -569,6 +577,39 @@ static mbinptr av_[NAV * 2 + 2] = {
 static void malloc_init(void);
 #endif
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SIZE_CLASSES)
+/*
+ * Size classes
+ *
+ * Small allocations are rounded up to one of a few sizes. When such a chunk
+ * is freed it goes on a free list for its size instead of back to the bins,
+ * so the next allocation of that size takes it without searching or
+ * splitting. The list link is stored in the first word of the chunk's user
+ * area. Chunks on the lists stay in use as far as the bins are concerned, so
+ * each list is limited in length and the lists are emptied if the pool runs
+ * out.
+ */
+static const size_t malloc_class_size[MALLOC_NUM_CLASSES] = {
+	16, 32, 64, 128, 256
+};
+
+/**
+ * struct malloc_class - Free list for one size class
+ *
+ * @head: First free chunk's user area, or NULL if none
+ * @stats: Statistics for the class
+ */
+struct malloc_class {
+	void *head;
+	struct malloc_class_stats stats;
+};
+
+static struct malloc_class malloc_classes[MALLOC_NUM_CLASSES];
+static bool malloc_class_flushing;	/* free() bypasses the lists */
+
+STATIC_IF_MCHECK void fREe_impl(Void_t *mem);
+#endif
+
 ulong mem_malloc_start = 0;
 ulong mem_malloc_end = 0;
 ulong mem_malloc_brk = 0;
@@ -605,6 +646,12 @@ void mem_malloc_init(ulong start, ulong size)
 #ifdef CONFIG_SYS_MALLOC_DEFAULT_TO_INIT
 	malloc_init();
 #endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SIZE_CLASSES)
+	memset(malloc_classes, '\0', sizeof(malloc_classes));
+#endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE)
+	malloc_prof_reset();
+#endif
 
 	debug("using memory %#lx-%#lx for malloc()\n", mem_malloc_start,
 	      mem_malloc_end);
@@ -1176,6 +1223,114 @@ static void malloc_extend_top(nb) INTERNAL_SIZE_T nb;
   assert(((unsigned long)((char*)top + top_size) & (pagesz - 1)) == 0);
 }
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SIZE_CLASSES)
+/* Get the smallest class which can hold @bytes, or -1 if too large */
+static int malloc_class_for_size(size_t bytes)
+{
+	int i;
+
+	for (i = 0; i < MALLOC_NUM_CLASSES; i++) {
+		if (bytes <= malloc_class_size[i])
+			return i;
+	}
+
+	return -1;
+}
+
+/* Get the class whose chunks have size @sz, or -1 if none */
+static int malloc_class_for_chunk(INTERNAL_SIZE_T sz)
+{
+	int i;
+
+	for (i = 0; i < MALLOC_NUM_CLASSES; i++) {
+		if (sz == request2size(malloc_class_size[i]))
+			return i;
+	}
+
+	return -1;
+}
+
+static void *malloc_class_alloc(int cls, size_t bytes)
+{
+	struct malloc_class *mc = &malloc_classes[cls];
+	void *mem = mc->head;
+
+	if (!mem) {
+		mc->stats.misses++;
+		return NULL;
+	}
+	VALGRIND_MAKE_MEM_DEFINED(mem, sizeof(void *));
+	mc->head = *(void **)mem;
+	mc->stats.count--;
+	mc->stats.hits++;
+	VALGRIND_MALLOCLIKE_BLOCK(mem, bytes, SIZE_SZ, false);
+
+	return mem;
+}
+
+/* Put a chunk on its class's free list, returning false if it cannot */
+static bool malloc_class_free(void *mem, INTERNAL_SIZE_T sz)
+{
+	struct malloc_class *mc;
+	int cls;
+
+	if (malloc_class_flushing)
+		return false;
+	cls = malloc_class_for_chunk(sz);
+	if (cls < 0)
+		return false;
+	mc = &malloc_classes[cls];
+	if (mc->stats.count >= CONFIG_VAL(SYS_MALLOC_CLASS_LIMIT)) {
+		mc->stats.spills++;
+		return false;
+	}
+	*(void **)mem = mc->head;
+	mc->head = mem;
+	mc->stats.count++;
+	mc->stats.frees++;
+	VALGRIND_FREELIKE_BLOCK(mem, SIZE_SZ);
+
+	return true;
+}
+
+int malloc_class_flush(void)
+{
+	int i, count = 0;
+
+	malloc_class_flushing = true;
+	for (i = 0; i < MALLOC_NUM_CLASSES; i++) {
+		struct malloc_class *mc = &malloc_classes[i];
+
+		while (mc->head) {
+			void *mem = mc->head;
+
+			VALGRIND_MAKE_MEM_DEFINED(mem, sizeof(void *));
+			mc->head = *(void **)mem;
+			VALGRIND_MALLOCLIKE_BLOCK(mem, sizeof(void *), SIZE_SZ,
+						  false);
+			fREe_impl(mem);
+			count++;
+		}
+		mc->stats.count = 0;
+	}
+	malloc_class_flushing = false;
+
+	return count;
+}
+
+int malloc_get_class_stats(struct malloc_class_stats *stats, int max)
+{
+	int i;
+
+	for (i = 0; i < MALLOC_NUM_CLASSES && i < max; i++) {
+		stats[i] = malloc_classes[i].stats;
+		stats[i].size = malloc_class_size[i];
+	}
+
+	return i;
+}
+#endif /* SYS_MALLOC_SIZE_CLASSES */
+
 /* Main public routines */
 
 /*
@@ -1277,6 +1432,17 @@ Void_t* mALLOc_impl(bytes) size_t bytes;
   if (bytes > CONFIG_SYS_MALLOC_LEN || (long)bytes < 0)
      return NULL;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SIZE_CLASSES)
+  idx = malloc_class_for_size(bytes);
+  if (idx >= 0) {
+    victim = malloc_class_alloc(idx, bytes);
+    if (victim)
+      return victim;
+    /* Round up so that the chunk fits the class when freed */
+    bytes = malloc_class_size[idx];
+  }
+#endif
+
   nb = request2size(bytes);  /* padded request size; */
 
   /* Check for exact match in a bin */
@@ -1484,7 +1650,14 @@ Void_t* mALLOc_impl(bytes) size_t bytes;
     /* Try to extend */
     malloc_extend_top(nb);
     if ( (remainder_size = chunksize(top) - nb) < (long)MINSIZE)
+    {
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SIZE_CLASSES)
+      /* Return the chunks on the free lists to the bins and try again */
+      if (malloc_class_flush())
+	return mALLOc_impl(bytes);
+#endif
       return NULL; /* propagate failure */
+    }
   }
 
   victim = top;
@@ -1561,6 +1734,10 @@ void fREe_impl(mem) Void_t* mem;
   check_inuse_chunk(p);
 
   sz = hd & ~PREV_INUSE;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SIZE_CLASSES)
+  if (malloc_class_free(mem, sz))
+    return;
+#endif
   next = chunk_at_offset(p, sz);
   nextsz = chunksize(next);
   VALGRIND_FREELIKE_BLOCK(mem, SIZE_SZ);
@@ -2242,6 +2419,170 @@ enum mcheck_status mprobe(void *__ptr) { return mcheck_mprobe(__ptr); }
 // mcheck API }
 #endif
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE)
+#define PROF_MAGIC	0xa5
+
+/**
+ * struct prof_hdr - Header placed just before each profiled allocation
+ *
+ * The allocation starts MALLOC_ALIGNMENT bytes into the chunk's memory, or
+ * further if it needs more alignment than that.
+ *
+ * @size: Number of bytes requested
+ * @site: Index of the call site, as returned by malloc_prof_alloc()
+ * @shift: log2 of the offset of the allocation from the chunk's memory
+ * @magic: PROF_MAGIC, to catch pointers which were not allocated here
+ */
+struct prof_hdr {
+	ulong size;
+	u16 site;
+	u8 shift;
+	u8 magic;
+};
+
+static struct prof_hdr *prof_hdr(void *mem)
+{
+	return (struct prof_hdr *)mem - 1;
+}
+
+/* Check whether the main pool is in use, rather than malloc_simple() */
+static bool prof_ready(void)
+{
+	return !CONFIG_IS_ENABLED(SYS_MALLOC_F) ||
+		(gd->flags & GD_FLG_FULL_MALLOC_INIT);
+}
+
+/* Check whether an allocation has a header */
+static bool prof_owns(void *mem)
+{
+	return prof_ready() && (ulong)mem >= mem_malloc_start &&
+		(ulong)mem < mem_malloc_end;
+}
+
+static void *prof_start(void *mem, uint shift, size_t bytes, ulong caller)
+{
+	struct prof_hdr *hdr;
+
+	mem += 1UL << shift;
+	hdr = prof_hdr(mem);
+	hdr->size = bytes;
+	hdr->site = malloc_prof_alloc(caller, bytes);
+	hdr->shift = shift;
+	hdr->magic = PROF_MAGIC;
+
+	return mem;
+}
+
+/* Record freeing an allocation, returning the chunk's memory */
+static void *prof_end(void *mem)
+{
+	struct prof_hdr *hdr = prof_hdr(mem);
+
+	if (hdr->magic != PROF_MAGIC) {
+		printf("malloc: bad pointer %p\n", mem);
+		return NULL;
+	}
+	malloc_prof_free(hdr->site, hdr->size);
+	hdr->magic = 0;
+
+	return mem - (1UL << hdr->shift);
+}
+
+static void *prof_alloc(size_t align, size_t bytes, bool zero, ulong caller)
+{
+	size_t pad = MALLOC_ALIGNMENT;
+	void *mem;
+
+	BUILD_BUG_ON(sizeof(struct prof_hdr) > MALLOC_ALIGNMENT);
+	if (!prof_ready()) {
+		mem = memalign_simple_caller(align ? align : 1, bytes, caller);
+		if (mem && zero)
+			memset(mem, '\0', bytes);
+		return mem;
+	}
+	if (align > pad)
+		pad = roundup_pow_of_two(align);
+	if (bytes > SIZE_MAX - pad)
+		return NULL;
+	if (pad > MALLOC_ALIGNMENT)
+		mem = mEMALIGn_impl(pad, pad + bytes);
+	else if (zero)
+		mem = cALLOc_impl(1, pad + bytes);
+	else
+		mem = mALLOc_impl(pad + bytes);
+	if (!mem)
+		return NULL;
+
+	return prof_start(mem, ilog2(pad), bytes, caller);
+}
+
+Void_t *mALLOc(size_t bytes)
+{
+	return prof_alloc(0, bytes, false, (ulong)__builtin_return_address(0));
+}
+
+void fREe(Void_t *mem)
+{
+	if (prof_owns(mem))
+		mem = prof_end(mem);
+	fREe_impl(mem);
+}
+
+Void_t *rEALLOc(Void_t *oldmem, size_t bytes)
+{
+	ulong caller = (ulong)__builtin_return_address(0);
+	struct prof_hdr *hdr;
+	void *mem;
+
+	if (!prof_owns(oldmem)) {
+		if (oldmem)
+			return rEALLOc_impl(oldmem, bytes);
+		return prof_alloc(0, bytes, false, caller);
+	}
+	hdr = prof_hdr(oldmem);
+	if (hdr->magic != PROF_MAGIC) {
+		printf("malloc: bad pointer %p\n", oldmem);
+		return NULL;
+	}
+
+	/* dlmalloc cannot keep extra alignment, so copy the allocation */
+	if (hdr->shift != ilog2(MALLOC_ALIGNMENT)) {
+		mem = prof_alloc(0, bytes, false, caller);
+		if (!mem)
+			return NULL;
+		memcpy(mem, oldmem, min(bytes, (size_t)hdr->size));
+		fREe(oldmem);
+		return mem;
+	}
+	if (bytes > SIZE_MAX - MALLOC_ALIGNMENT)
+		return NULL;
+	mem = rEALLOc_impl(oldmem - MALLOC_ALIGNMENT, MALLOC_ALIGNMENT + bytes);
+	if (!mem)
+		return NULL;
+
+	/* The header was copied with the data, so is still valid */
+	hdr = prof_hdr(mem + MALLOC_ALIGNMENT);
+	malloc_prof_free(hdr->site, hdr->size);
+
+	return prof_start(mem, ilog2(MALLOC_ALIGNMENT), bytes, caller);
+}
+
+Void_t *mEMALIGn(size_t alignment, size_t bytes)
+{
+	return prof_alloc(alignment, bytes, false,
+			  (ulong)__builtin_return_address(0));
+}
+
+Void_t *cALLOc(size_t n, size_t elem_size)
+{
+	if (elem_size && n > SIZE_MAX / elem_size)
+		return NULL;
+
+	return prof_alloc(0, n * elem_size, true,
+			  (ulong)__builtin_return_address(0));
+}
+#endif
+
 /*
 
     Malloc_trim gives memory back to the system (via negative
@@ -2341,6 +2682,16 @@ size_t malloc_usable_size(mem) Void_t* mem;
   mchunkptr p;
   if (mem == NULL)
     return 0;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE)
+  if (prof_owns(mem))
+  {
+    struct prof_hdr *hdr = prof_hdr(mem);
+    void *start = mem - (1UL << hdr->shift);
+
+    p = mem2chunk(start);
+    return chunksize(p) - SIZE_SZ - (1UL << hdr->shift);
+  }
+#endif
   else
   {
     p = mem2chunk(mem);
@@ -2386,6 +2737,16 @@ static void malloc_update_mallinfo(void)
     }
   }
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SIZE_CLASSES)
+  /* Chunks on the size-class lists are free as far as callers can tell */
+  for (i = 0; i < MALLOC_NUM_CLASSES; i++)
+  {
+    avail += malloc_classes[i].stats.count *
+	     request2size(malloc_class_size[i]);
+    navail += malloc_classes[i].stats.count;
+  }
+#endif
+
   current_mallinfo.ordblks = navail;
   current_mallinfo.uordblks = sbrked_mem - avail;
   current_mallinfo.fordblks = avail;
@@ -11,6 +11,7 @@
 
 #include <event.h>
 #include <event_internal.h>
+#include <event_stats.h>
 #include <log.h>
 #include <linker_lists.h>
 #include <malloc.h>
@@ -128,22 +129,16 @@ static int notify_dynamic(struct event *ev)
 	return 0;
 }
 
-int event_notify(enum event_t type, void *data, int size)
+static int notify(struct event *ev)
 {
-	struct event event;
 	int ret;
 
-	event.type = type;
-	if (size > sizeof(event.data))
-		return log_msg_ret("size", -E2BIG);
-	memcpy(&event.data, data, size);
-
-	ret = notify_static(&event);
+	ret = notify_static(ev);
 	if (ret)
 		return log_msg_ret("sta", ret);
 
 	if (CONFIG_IS_ENABLED(EVENT_DYNAMIC)) {
-		ret = notify_dynamic(&event);
+		ret = notify_dynamic(ev);
 		if (ret)
 			return log_msg_ret("dyn", ret);
 	}
@@ -151,6 +146,24 @@ int event_notify(enum event_t type, void *data, int size)
 	return 0;
 }
 
+int event_notify(enum event_t type, void *data, int size)
+{
+	struct event event;
+	ulong start;
+	int ret;
+
+	event.type = type;
+	if (size > sizeof(event.data))
+		return log_msg_ret("size", -E2BIG);
+	memcpy(&event.data, data, size);
+
+	start = event_stats_start();
+	ret = notify(&event);
+	event_stats_add_event(type, start);
+
+	return ret;
+}
+
 int event_notify_null(enum event_t type)
 {
 	return event_notify(type, NULL, 0);
@@ -0,0 +1,202 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Counts and times for events and device probes
+ *
+ * The table is allocated on first use, from the pre-relocation heap if U-Boot
+ * has not relocated yet. board_f reserves space for it and moves it there
+ * when relocating, in the same way as bootstage.
+ */
+
+#define LOG_CATEGORY	LOGC_EVENT
+
+#include <dm.h>
+#include <event.h>
+#include <event_stats.h>
+#include <linker_lists.h>
+#include <log.h>
+#include <malloc.h>
+#include <time.h>
+#include <asm/global_data.h>
+#include <dm/device-internal.h>
+#include <dm/lists.h>
+#include <dm/ofnode.h>
+#include <linux/errno.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+int event_stats_get_size(void)
+{
+	return sizeof(struct event_stats) +
+		ll_entry_count(struct driver, driver) *
+		sizeof(struct event_stat);
+}
+
+static struct event_stats *event_stats_alloc(void)
+{
+	struct event_stats *stats = gd->event_stats;
+
+	if (stats)
+		return stats;
+
+	/* Nothing is recorded until malloc() is available */
+	stats = calloc(1, event_stats_get_size());
+	if (!stats)
+		return NULL;
+	stats->num_drivers = ll_entry_count(struct driver, driver);
+	gd->event_stats = stats;
+
+	return stats;
+}
+
+struct event_stats *event_stats_get(void)
+{
+	return gd->event_stats;
+}
+
+ulong event_stats_start(void)
+{
+	/* Reading the timer before it is set up would probe it, recursively */
+	if (CONFIG_IS_ENABLED(TIMER) && !IS_ENABLED(CONFIG_TIMER_EARLY) &&
+	    !gd->timer)
+		return 0;
+
+	return timer_get_us();
+}
+
+static void event_stat_add(struct event_stat *stat, ulong start)
+{
+	stat->count++;
+	if (start)
+		stat->time_us += timer_get_us() - start;
+}
+
+void event_stats_add_event(enum event_t type, ulong start)
+{
+	struct event_stats *stats = event_stats_alloc();
+
+	if (stats && type < EVT_COUNT)
+		event_stat_add(&stats->event[type], start);
+}
+
+void event_stats_add_probe(struct udevice *dev, ulong start)
+{
+	struct event_stats *stats = event_stats_alloc();
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	enum uclass_id id = device_get_uclass_id(dev);
+	int idx = dev->driver - drv;
+	ulong time_us;
+
+	if (!stats)
+		return;
+	/* Read the timer once, so the uclass and driver agree */
+	time_us = start ? timer_get_us() - start : 0;
+	if (id >= 0 && id < UCLASS_COUNT) {
+		stats->uclass[id].count++;
+		stats->uclass[id].time_us += time_us;
+	}
+	if (idx >= 0 && idx < stats->num_drivers) {
+		stats->driver[idx].count++;
+		stats->driver[idx].time_us += time_us;
+	}
+}
+
+void event_stats_reset(void)
+{
+	struct event_stats *stats = gd->event_stats;
+	int num_drivers;
+
+	if (!stats)
+		return;
+	num_drivers = stats->num_drivers;
+	memset(stats, '\0', event_stats_get_size());
+	stats->num_drivers = num_drivers;
+}
+
+void event_stats_relocate(void *to)
+{
+	if (!gd->event_stats)
+		return;
+	log_debug("Copying event stats from %p to %p\n", gd->event_stats, to);
+	memcpy(to, gd->event_stats, event_stats_get_size());
+	gd->event_stats = to;
+}
+
+#if CONFIG_IS_ENABLED(OF_CONTROL)
+static int add_stat(ofnode node, const char *name,
+		    const struct event_stat *stat)
+{
+	fdt32_t val[2];
+
+	if (!stat->count)
+		return 0;
+	val[0] = cpu_to_fdt32(stat->count);
+	val[1] = cpu_to_fdt32(stat->time_us);
+
+	return ofnode_write_prop(node, name, val, sizeof(val), true);
+}
+
+static int add_stats_node(ofnode parent, const char *name, ofnode *nodep)
+{
+	int ret;
+
+	ret = ofnode_add_subnode(parent, name, nodep);
+	if (ret && ret != -EEXIST)
+		return log_msg_ret("sub", ret);
+
+	return 0;
+}
+
+/*
+ * Pass the stats to the OS under /chosen/u-boot,event-stats, with a property
+ * of <count time-us> for each event, uclass and driver which was recorded
+ */
+static int event_stats_ft_fixup(void *ctx, struct event *event)
+{
+	struct event_stats *stats = gd->event_stats;
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	ofnode chosen, node, sub;
+	char name[20];
+	int ret, i;
+
+	if (!stats)
+		return 0;
+	chosen = oftree_path(event->data.ft_fixup.tree, "/chosen");
+	if (!ofnode_valid(chosen))
+		return 0;
+	ret = add_stats_node(chosen, "u-boot,event-stats", &node);
+
+	if (!ret)
+		ret = add_stats_node(node, "events", &sub);
+	for (i = 0; !ret && i < EVT_COUNT; i++) {
+		const char *evname = event_type_name(i);
+
+		if (!CONFIG_IS_ENABLED(EVENT_DEBUG)) {
+			snprintf(name, sizeof(name), "event-%d", i);
+			evname = name;
+		}
+		ret = add_stat(sub, evname, &stats->event[i]);
+	}
+
+	if (!ret)
+		ret = add_stats_node(node, "uclasses", &sub);
+	for (i = 0; !ret && i < UCLASS_COUNT; i++) {
+		struct uclass_driver *uc_drv;
+
+		if (!stats->uclass[i].count)
+			continue;
+		uc_drv = lists_uclass_lookup(i);
+		if (uc_drv)
+			ret = add_stat(sub, uc_drv->name, &stats->uclass[i]);
+	}
+
+	if (!ret)
+		ret = add_stats_node(node, "drivers", &sub);
+	for (i = 0; !ret && i < stats->num_drivers; i++)
+		ret = add_stat(sub, drv[i].name, &stats->driver[i]);
+	if (ret)
+		return log_msg_ret("evs", ret);
+
+	return 0;
+}
+EVENT_SPY_FULL(EVT_FT_FIXUP, event_stats_ft_fixup);
+#endif
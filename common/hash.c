@@ -16,6 +16,7 @@
 #include <malloc.h>
 #include <mapmem.h>
 #include <hw_sha.h>
+#include <watchdog.h>
 #include <asm/cache.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
@@ -35,6 +36,33 @@
 #include <u-boot/sha512.h>
 #include <u-boot/md5.h>
 
+static int __maybe_unused hash_init_md5(struct hash_algo *algo, void **ctxp)
+{
+	MD5Context *ctx = malloc(sizeof(MD5Context));
+	MD5Init(ctx);
+	*ctxp = ctx;
+	return 0;
+}
+
+static int __maybe_unused hash_update_md5(struct hash_algo *algo, void *ctx,
+					  const void *buf, unsigned int size,
+					  int is_last)
+{
+	MD5Update((MD5Context *)ctx, buf, size);
+	return 0;
+}
+
+static int __maybe_unused hash_finish_md5(struct hash_algo *algo, void *ctx,
+					  void *dest_buf, int size)
+{
+	if (size < algo->digest_size)
+		return -1;
+
+	MD5Final(dest_buf, (MD5Context *)ctx);
+	free(ctx);
+	return 0;
+}
+
 static int __maybe_unused hash_init_sha1(struct hash_algo *algo, void **ctxp)
 {
 	sha1_context *ctx = malloc(sizeof(sha1_context));
@@ -209,6 +237,9 @@ static struct hash_algo hash_algo[] = {
 		.digest_size	= MD5_SUM_LEN,
 		.chunk_size	= CHUNKSZ_MD5,
 		.hash_func_ws	= md5_wd,
+		.hash_init	= hash_init_md5,
+		.hash_update	= hash_update_md5,
+		.hash_finish	= hash_finish_md5,
 	},
 #endif
 #if CONFIG_IS_ENABLED(SHA1)
@@ -527,6 +558,115 @@ static void hash_show(struct hash_algo *algo, ulong addr, ulong len, uint8_t *ou
 		printf("%02x", output[i]);
 }
 
+/**
+ * hash_report() - show, store or verify one digest
+ *
+ * @algo:	Hash algorithm used
+ * @addr:	Start address of the region hashed
+ * @len:	Length of the region hashed
+ * @output:	Digest of the region
+ * @dest:	Where to store the digest, or the digest to verify against, or
+ *		NULL to just show it
+ * @flags:	Flags value (HASH_FLAG_...)
+ * Return: 0 if ok, 1 if verification failed
+ */
+static int hash_report(struct hash_algo *algo, ulong addr, ulong len,
+		       u8 *output, char *dest, int flags)
+{
+	uint8_t vsum[HASH_MAX_DIGEST_SIZE];
+
+	/* Try to avoid code bloat when verify is not needed */
+#if defined(CONFIG_CRC32_VERIFY) || defined(CONFIG_SHA1SUM_VERIFY) || \
+	defined(CONFIG_MD5SUM_VERIFY) || defined(CONFIG_HASH_VERIFY)
+	if (flags & HASH_FLAG_VERIFY) {
+#else
+	if (0) {
+#endif
+		if (parse_verify_sum(algo, dest, vsum, flags & HASH_FLAG_ENV)) {
+			printf("ERROR: %s does not contain a valid "
+				"%s sum\n", dest, algo->name);
+			return 1;
+		}
+		if (memcmp(output, vsum, algo->digest_size) != 0) {
+			int i;
+
+			hash_show(algo, addr, len, output);
+			printf(" != ");
+			for (i = 0; i < algo->digest_size; i++)
+				printf("%02x", vsum[i]);
+			puts(" ** ERROR **\n");
+			return 1;
+		}
+	} else {
+		hash_show(algo, addr, len, output);
+		printf("\n");
+
+		if (dest)
+			store_result(algo, output, dest, flags & HASH_FLAG_ENV);
+	}
+
+	return 0;
+}
+
+/**
+ * hash_region_multi() - hash one region with several algorithms at once
+ *
+ * The region is read only once: each chunk is passed to every algorithm in
+ * turn while it is still in the cache.
+ *
+ * @algos:	Hash algorithms to use, which must all support progressive
+ *		hashing
+ * @count:	Number of algorithms
+ * @buf:	Region to hash
+ * @len:	Length of region
+ * @output:	Returns the digests, one every HASH_MAX_DIGEST_SIZE bytes
+ * Return: 0 if ok, -ve on error
+ */
+static int hash_region_multi(struct hash_algo **algos, int count,
+			     const void *buf, ulong len, u8 *output)
+{
+	void *ctx[ARRAY_SIZE(hash_algo)];
+	ulong pos = 0, chunk;
+	int i, ret = 0;
+	bool last;
+
+	for (i = 0; i < count; i++) {
+		ret = algos[i]->hash_init(algos[i], &ctx[i]);
+		if (ret)
+			break;
+	}
+	if (ret) {
+		while (i--)
+			algos[i]->hash_finish(algos[i], ctx[i], output,
+					      HASH_MAX_DIGEST_SIZE);
+		return ret;
+	}
+
+	do {
+		chunk = min(len - pos, (ulong)CHUNKSZ);
+		last = pos + chunk == len;
+		for (i = 0; i < count; i++) {
+			ret = algos[i]->hash_update(algos[i], ctx[i], buf + pos,
+						    chunk, last);
+			if (ret)
+				break;
+		}
+		pos += chunk;
+		schedule();
+	} while (!ret && !last);
+
+	for (i = 0; i < count; i++) {
+		int err = algos[i]->hash_finish(algos[i], ctx[i],
+						output + i * HASH_MAX_DIGEST_SIZE,
+						HASH_MAX_DIGEST_SIZE);
+
+		if (!ret)
+			ret = err;
+	}
+
+	return ret;
+}
+
 int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 		 int flag, int argc, char *const argv[])
 {
@@ -535,77 +675,110 @@ int hash_command(const char *algo_name, int flags, struct cmd_tbl *cmdtp,
 	if ((argc < 2) || ((flags & HASH_FLAG_VERIFY) && (argc < 3)))
 		return CMD_RET_USAGE;
 
-	addr = hextoul(*argv++, NULL);
-	len = hextoul(*argv++, NULL);
-
 	if (multi_hash()) {
-		struct hash_algo *algo;
+		struct hash_algo *algos[ARRAY_SIZE(hash_algo)];
+		char *names, *name, *dests = NULL, *dest = NULL, *p;
+		int nalgos = 0, nregions, i, j, ret = 0;
 		u8 *output;
-		uint8_t vsum[HASH_MAX_DIGEST_SIZE];
 		void *buf;
 
-		if (hash_lookup_algo(algo_name, &algo)) {
-			printf("Unknown hash algorithm '%s'\n", algo_name);
-			return CMD_RET_USAGE;
+		/*
+		 * algo_name may list several algorithms separated by commas
+		 * and argv may hold several "address count" pairs, optionally
+		 * followed by a comma-separated list with one destination (or
+		 * expected value) for each algorithm of each region in turn
+		 */
+		names = strdup(algo_name);
+		if (!names)
+			return CMD_RET_FAILURE;
+		for (p = names; (name = strsep(&p, ","));) {
+			if (nalgos == ARRAY_SIZE(algos) ||
+			    hash_lookup_algo(name, &algos[nalgos])) {
+				printf("Unknown hash algorithm '%s'\n", name);
+				free(names);
+				return CMD_RET_USAGE;
+			}
+			if (algos[nalgos]->digest_size > HASH_MAX_DIGEST_SIZE) {
+				puts("HASH_MAX_DIGEST_SIZE exceeded\n");
+				free(names);
+				return 1;
+			}
+			nalgos++;
+		}
+		free(names);
+		for (i = 0; nalgos > 1 && i < nalgos; i++) {
+			if (!algos[i]->hash_init) {
+				printf("%s cannot be combined with other algorithms\n",
+				       algos[i]->name);
+				return CMD_RET_USAGE;
+			}
 		}
-		argc -= 2;
 
-		if (algo->digest_size > HASH_MAX_DIGEST_SIZE) {
-			puts("HASH_MAX_DIGEST_SIZE exceeded\n");
-			return 1;
+		nregions = argc / 2;
+		if (argc & 1) {
+			int count = 1;
+
+			for (p = argv[argc - 1]; *p; p++)
+				count += *p == ',';
+			if (count != nregions * nalgos) {
+				printf("Expected %d hashes\n", nregions * nalgos);
+				return CMD_RET_USAGE;
+			}
+			dests = strdup(argv[argc - 1]);
+			if (!dests)
+				return CMD_RET_FAILURE;
+		} else if (flags & HASH_FLAG_VERIFY) {
+			return CMD_RET_USAGE;
 		}
 
-		output = memalign(ARCH_DMA_MINALIGN,
+		output = memalign(ARCH_DMA_MINALIGN, nalgos *
 				  sizeof(uint32_t) * HASH_MAX_DIGEST_SIZE);
-		if (!output)
+		if (!output) {
+			free(dests);
 			return CMD_RET_FAILURE;
+		}
 
-		buf = map_sysmem(addr, len);
-		algo->hash_func_ws(buf, len, output, algo->chunk_size);
-		unmap_sysmem(buf);
-
-		/* Try to avoid code bloat when verify is not needed */
-#if defined(CONFIG_CRC32_VERIFY) || defined(CONFIG_SHA1SUM_VERIFY) || \
-	defined(CONFIG_MD5SUM_VERIFY) || defined(CONFIG_HASH_VERIFY)
-		if (flags & HASH_FLAG_VERIFY) {
-#else
-		if (0) {
-#endif
-			if (parse_verify_sum(algo, *argv, vsum,
-					flags & HASH_FLAG_ENV)) {
-				printf("ERROR: %s does not contain a valid "
-					"%s sum\n", *argv, algo->name);
-				free(output);
-				return 1;
-			}
-			if (memcmp(output, vsum, algo->digest_size) != 0) {
-				int i;
-
-				hash_show(algo, addr, len, output);
-				printf(" != ");
-				for (i = 0; i < algo->digest_size; i++)
-					printf("%02x", vsum[i]);
-				puts(" ** ERROR **\n");
-				free(output);
-				return 1;
+		p = dests;
+		for (i = 0; i < nregions; i++) {
+			addr = hextoul(argv[i * 2], NULL);
+			len = hextoul(argv[i * 2 + 1], NULL);
+
+			buf = map_sysmem(addr, len);
+			if (nalgos == 1) {
+				algos[0]->hash_func_ws(buf, len, output,
+						       algos[0]->chunk_size);
+			} else if (hash_region_multi(algos, nalgos, buf, len,
+						     output)) {
+				printf("Hashing %08lx failed\n", addr);
+				unmap_sysmem(buf);
+				ret = 1;
+				break;
 			}
-		} else {
-			hash_show(algo, addr, len, output);
-			printf("\n");
-
-			if (argc) {
-				store_result(algo, output, *argv,
-					flags & HASH_FLAG_ENV);
+			unmap_sysmem(buf);
+
+			for (j = 0; j < nalgos; j++) {
+				if (dests)
+					dest = strsep(&p, ",");
+				if (hash_report(algos[j], addr, len,
+						output + j * HASH_MAX_DIGEST_SIZE,
+						dest, flags))
+					ret = 1;
 			}
 		}
 
 		free(output);
+		free(dests);
+
+		return ret;
 
 	/* Horrible code size hack for boards that just want crc32 */
 	} else {
 		ulong crc;
 		ulong *ptr;
 
+		addr = hextoul(*argv++, NULL);
+		len = hextoul(*argv++, NULL);
+
 		crc = crc32_wd(0, (const uchar *)addr, len, CHUNKSZ_CRC32);
 
 		printf("CRC32 for %08lx ... %08lx ==> %08lx\n",
@@ -0,0 +1,208 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Asynchronous initcalls, which let slow hardware set-up overlap with the
+ * rest of init
+ */
+
+#define LOG_CATEGORY	LOGC_BOOT
+
+#include <cyclic.h>
+#include <initcall.h>
+#include <log.h>
+#include <malloc.h>
+#include <linux/delay.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+
+enum async_state {
+	ASYNC_PENDING,		/* Waiting for the initcall it depends on */
+	ASYNC_RUNNING,		/* Started, now being polled */
+	ASYNC_DONE,		/* Finished, with the result in @ret */
+};
+
+/**
+ * struct async_priv - State of an asynchronous initcall
+ *
+ * @state: Current state
+ * @ret: Result, once the state is ASYNC_DONE
+ * @after: Index of the initcall this one depends on, or -1 if none
+ */
+struct async_priv {
+	enum async_state state;
+	int ret;
+	int after;
+};
+
+/**
+ * struct async_info - Information about the asynchronous initcalls
+ *
+ * @priv: State of each initcall, in linker-list order, or NULL if not
+ *	started yet
+ * @count: Number of initcalls
+ * @running: Number of initcalls not done yet
+ * @busy: true while stepping, to stop a poll function which calls
+ *	schedule() from stepping again
+ * @cyclic: Cyclic function which polls the initcalls
+ */
+struct async_info {
+	struct async_priv *priv;
+	int count;
+	int running;
+	bool busy;
+	struct cyclic_info cyclic;
+};
+
+static struct async_info async_info;
+
+static int async_find(const char *name)
+{
+	struct initcall_async *start = ll_entry_start(struct initcall_async,
+						      initcall_async);
+	int i;
+
+	for (i = 0; i < async_info.count; i++) {
+		if (!strcmp(start[i].name, name))
+			return i;
+	}
+
+	return -ENOENT;
+}
+
+static void async_done(struct initcall_async *call, struct async_priv *priv,
+		       int ret)
+{
+	priv->state = ASYNC_DONE;
+	priv->ret = ret;
+	async_info.running--;
+	if (ret)
+		log_debug("Async initcall %s failed (err=%dE)\n", call->name,
+			  ret);
+	else
+		log_debug("Async initcall %s done\n", call->name);
+}
+
+/* Start or poll each initcall which is not done yet */
+static void async_step(void)
+{
+	struct initcall_async *start = ll_entry_start(struct initcall_async,
+						      initcall_async);
+	struct async_info *info = &async_info;
+	int i, ret;
+
+	if (!info->priv || !info->running || info->busy)
+		return;
+	info->busy = true;
+	for (i = 0; i < info->count; i++) {
+		struct initcall_async *call = &start[i];
+		struct async_priv *priv = &info->priv[i];
+		struct async_priv *after;
+
+		if (priv->state == ASYNC_PENDING) {
+			after = priv->after >= 0 ? &info->priv[priv->after] :
+				NULL;
+			if (after && after->state != ASYNC_DONE)
+				continue;
+			if (after && after->ret) {
+				async_done(call, priv, -ENODEV);
+				continue;
+			}
+			log_debug("Starting async initcall %s\n", call->name);
+			ret = call->start ? call->start() : 0;
+			if (ret) {
+				async_done(call, priv, ret);
+				continue;
+			}
+			priv->state = ASYNC_RUNNING;
+		}
+		if (priv->state == ASYNC_RUNNING) {
+			ret = call->poll ? call->poll() : 0;
+			if (ret != -EAGAIN)
+				async_done(call, priv, ret);
+		}
+	}
+	if (!info->running && info->cyclic.func)
+		cyclic_unregister(&info->cyclic);
+	info->busy = false;
+}
+
+static void async_cyclic(struct cyclic_info *c)
+{
+	async_step();
+}
+
+int initcall_async_start_all(void)
+{
+	struct initcall_async *start = ll_entry_start(struct initcall_async,
+						      initcall_async);
+	struct async_info *info = &async_info;
+	int i;
+
+	info->count = ll_entry_count(struct initcall_async, initcall_async);
+	if (!info->count)
+		return 0;
+	info->priv = calloc(info->count, sizeof(struct async_priv));
+	if (!info->priv)
+		return -ENOMEM;
+	for (i = 0; i < info->count; i++) {
+		struct async_priv *priv = &info->priv[i];
+
+		priv->after = -1;
+		if (start[i].after) {
+			priv->after = async_find(start[i].after);
+			if (priv->after < 0)
+				log_warning("Async initcall %s: no initcall '%s'\n",
+					    start[i].name, start[i].after);
+		}
+	}
+	info->running = info->count;
+
+	async_step();
+	if (info->running)
+		cyclic_register(&info->cyclic, async_cyclic, 1000,
+				"initcall_async");
+
+	return 0;
+}
+
+void initcall_async_poll(void)
+{
+	async_step();
+}
+
+int initcall_async_join(const char *name)
+{
+	struct async_info *info = &async_info;
+	struct async_priv *priv;
+	int i;
+
+	if (!info->priv)
+		return -EAGAIN;
+	if (info->busy)
+		return -EDEADLK;
+	i = async_find(name);
+	if (i < 0)
+		return i;
+	priv = &info->priv[i];
+	while (priv->state != ASYNC_DONE) {
+		async_step();
+		if (priv->state != ASYNC_DONE)
+			udelay(100);
+	}
+
+	return priv->ret;
+}
+
+int initcall_async_join_all(void)
+{
+	struct initcall_async *start = ll_entry_start(struct initcall_async,
+						      initcall_async);
+	int i, ret, first = 0;
+
+	for (i = 0; i < async_info.count; i++) {
+		ret = initcall_async_join(start[i].name);
+		if (ret && !first)
+			first = ret;
+	}
+
+	return first;
+}
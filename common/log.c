@@ -460,6 +460,10 @@ int log_init(void)
 			      (struct list_head *)&gd->log_head);
 		drv++;
 	}
+#if CONFIG_IS_ENABLED(LOG_RING)
+	/* the ring is cheap, so keep more detail there than on the console */
+	log_add_filter("ring", NULL, CONFIG_LOG_RING_LEVEL, NULL);
+#endif
 	gd->flags |= GD_FLG_LOG_READY;
 	if (!gd->default_log_level)
 		gd->default_log_level = CONFIG_LOG_DEFAULT_LEVEL;
@@ -7,6 +7,7 @@
  */
 
 #include <log.h>
+#include <serial.h>
 #include <asm/global_data.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -16,6 +17,11 @@ static int log_console_emit(struct log_device *ldev, struct log_rec *rec)
 	int fmt = gd->log_fmt;
 	bool add_space = false;
 
+	/* Rather than wait for a slow serial line, skip the chatter */
+	if (IS_ENABLED(CONFIG_SERIAL_TX_BUFFER_DROP) &&
+	    rec->level > LOGL_NOTICE && serial_tx_congested())
+		return 0;
+
 	/*
 	 * The output format is designed to give someone a fighting chance of
 	 * figuring out which field is which:
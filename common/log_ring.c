@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Log driver which keeps records in a ring buffer in the bloblist
+ */
+
+#include <bloblist.h>
+#include <log.h>
+#include <linux/errno.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+
+static struct log_ring_hdr *log_ring_get(void)
+{
+	struct log_ring_hdr *ring;
+
+	ring = bloblist_find(BLOBLISTT_U_BOOT_LOG, 0);
+	if (!ring) {
+		ring = bloblist_add(BLOBLISTT_U_BOOT_LOG,
+				    sizeof(*ring) + CONFIG_LOG_RING_SIZE, 0);
+		if (!ring)
+			return NULL;
+		ring->magic = LOG_RING_MAGIC;
+		ring->size = CONFIG_LOG_RING_SIZE;
+	}
+	if (ring->magic != LOG_RING_MAGIC)
+		return NULL;
+
+	return ring;
+}
+
+static void log_ring_copy(struct log_ring_hdr *ring, u32 pos, void *buf,
+			  u32 len, bool write)
+{
+	u8 *data = (u8 *)(ring + 1);
+	u32 first;
+
+	pos %= ring->size;
+	first = min(len, ring->size - pos);
+	if (write) {
+		memcpy(data + pos, buf, first);
+		memcpy(data, buf + first, len - first);
+	} else {
+		memcpy(buf, data + pos, first);
+		memcpy(buf + first, data, len - first);
+	}
+}
+
+static int log_ring_emit(struct log_device *ldev, struct log_rec *rec)
+{
+	struct log_ring_hdr *ring = log_ring_get();
+	struct log_ring_rec hdr, old;
+	u32 len, size;
+
+	if (!ring || ring->size <= sizeof(hdr))
+		return -ENOSPC;
+
+	len = min_t(u32, strlen(rec->msg), ring->size - sizeof(hdr));
+	size = sizeof(hdr) + len;
+
+	/* drop the oldest records until there is space */
+	while (ring->size - ring->used < size) {
+		log_ring_copy(ring, ring->start, &old, sizeof(old), false);
+		ring->start = (ring->start + sizeof(old) + old.len) %
+			ring->size;
+		ring->used -= sizeof(old) + old.len;
+		ring->dropped++;
+	}
+
+	hdr.level = rec->level;
+	hdr.flags = rec->flags;
+	hdr.cat = rec->cat;
+	hdr.len = len;
+	log_ring_copy(ring, ring->start + ring->used, &hdr, sizeof(hdr), true);
+	log_ring_copy(ring, ring->start + ring->used + sizeof(hdr),
+		      (void *)rec->msg, len, true);
+	ring->used += size;
+
+	return 0;
+}
+
+LOG_DRIVER(ring) = {
+	.name	= "ring",
+	.emit	= log_ring_emit,
+	.flags	= LOGDF_ENABLE,
+};
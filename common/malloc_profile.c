@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Profile of malloc() use, recording how much memory each call site holds
+ *
+ * This is used before relocation, so everything is kept in the data section
+ * rather than BSS. Relocation then copies it along with the image.
+ */
+
+#include <event.h>
+#include <malloc.h>
+#include <sort.h>
+#include <asm/global_data.h>
+#include <linux/kernel.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+static struct malloc_prof_site prof_sites[CONFIG_SYS_MALLOC_PROFILE_SITES]
+	__section(".data");
+
+static struct malloc_prof prof __section(".data") = {
+	.sites = prof_sites,
+	.num_sites = ARRAY_SIZE(prof_sites),
+};
+
+/* Order in which to show the sites, only used after relocation */
+static u16 prof_order[CONFIG_SYS_MALLOC_PROFILE_SITES];
+
+/* Convert the caller to its link-time address, so it can be looked up */
+static ulong prof_caller(ulong caller)
+{
+	/* Sandbox is relocated by the OS, as with calc_reloc_ofs() */
+	if (IS_ENABLED(CONFIG_SANDBOX) || (gd->flags & GD_FLG_RELOC))
+		return caller - gd->reloc_off;
+
+	return caller;
+}
+
+/* Find the site for a caller, adding it if needed */
+static uint prof_find(ulong caller)
+{
+	uint i, start;
+
+	caller = prof_caller(caller);
+	start = (caller >> 2) % prof.num_sites;
+	i = start;
+	do {
+		struct malloc_prof_site *site = &prof_sites[i];
+
+		if (site->caller == caller)
+			return i;
+		if (!site->caller) {
+			site->caller = caller;
+			return i;
+		}
+		i = (i + 1) % prof.num_sites;
+	} while (i != start);
+	prof.untracked++;
+
+	return MALLOC_PROF_NO_SITE;
+}
+
+uint malloc_prof_alloc(ulong caller, size_t size)
+{
+	struct malloc_prof_site *site;
+	uint idx;
+
+	prof.live += size;
+	prof.peak = max(prof.peak, prof.live);
+	idx = prof_find(caller);
+	if (idx == MALLOC_PROF_NO_SITE)
+		return idx;
+	site = &prof_sites[idx];
+	site->live += size;
+	site->count++;
+	site->total++;
+	site->peak = max(site->peak, site->live);
+
+	return idx;
+}
+
+void malloc_prof_free(uint idx, size_t size)
+{
+	struct malloc_prof_site *site;
+
+	prof.live -= size;
+	if (idx >= prof.num_sites)
+		return;
+	site = &prof_sites[idx];
+	site->live -= size;
+	site->count--;
+}
+
+void malloc_prof_early(ulong caller, size_t size)
+{
+	uint idx;
+
+	prof.early_peak = max(prof.early_peak, (ulong)gd->malloc_ptr);
+	idx = prof_find(caller);
+	if (idx == MALLOC_PROF_NO_SITE)
+		return;
+	prof_sites[idx].early += size;
+	prof_sites[idx].total++;
+}
+
+void malloc_prof_reset(void)
+{
+	int i;
+
+	for (i = 0; i < prof.num_sites; i++) {
+		prof_sites[i].live = 0;
+		prof_sites[i].count = 0;
+	}
+	prof.live = 0;
+}
+
+const struct malloc_prof *malloc_prof_get(void)
+{
+	return &prof;
+}
+
+static int prof_cmp(const void *a, const void *b)
+{
+	const struct malloc_prof_site *sa = &prof_sites[*(const u16 *)a];
+	const struct malloc_prof_site *sb = &prof_sites[*(const u16 *)b];
+
+	if (sa->live != sb->live)
+		return sa->live < sb->live ? 1 : -1;
+	if (sa->early != sb->early)
+		return sa->early < sb->early ? 1 : -1;
+
+	return sa->caller < sb->caller ? -1 : sa->caller > sb->caller;
+}
+
+void malloc_prof_show(int max)
+{
+	int i, count;
+
+	printf("early peak  %#lx\n", prof.early_peak);
+	printf("live        %#lx\n", prof.live);
+	printf("peak        %#lx\n", prof.peak);
+	if (prof.untracked)
+		printf("untracked   %lu allocations\n", prof.untracked);
+
+	for (i = 0, count = 0; i < prof.num_sites; i++) {
+		if (prof_sites[i].caller)
+			prof_order[count++] = i;
+	}
+	qsort(prof_order, count, sizeof(prof_order[0]), prof_cmp);
+	if (max && count > max)
+		count = max;
+
+	printf("\n%*s %10s %7s %10s %7s %10s\n", 2 * (int)sizeof(ulong),
+	       "caller", "live", "count", "peak", "total", "early");
+	for (i = 0; i < count; i++) {
+		struct malloc_prof_site *site = &prof_sites[prof_order[i]];
+
+		printf("%0*lx %10lx %7lu %10lx %7lu %10lx\n",
+		       2 * (int)sizeof(ulong), site->caller, site->live,
+		       site->count, site->peak, site->total, site->early);
+	}
+}
+
+#if IS_ENABLED(CONFIG_SYS_MALLOC_PROFILE_REPORT) && !defined(CONFIG_XPL_BUILD)
+static int malloc_prof_report(void)
+{
+	printf("malloc() profile:\n");
+	malloc_prof_show(10);
+
+	return 0;
+}
+EVENT_SPY_SIMPLE(EVT_MAIN_LOOP, malloc_prof_report);
+#endif
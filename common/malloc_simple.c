@@ -16,7 +16,7 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
-static void *alloc_simple(size_t bytes, int align)
+static void *alloc_simple(size_t bytes, int align, ulong caller)
 {
 	ulong addr, new_ptr;
 	void *ptr;
@@ -32,6 +32,8 @@ static void *alloc_simple(size_t bytes, int align)
 
 	ptr = map_sysmem(addr, bytes);
 	gd->malloc_ptr = ALIGN(new_ptr, sizeof(new_ptr));
+	if (CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE))
+		malloc_prof_early(caller, bytes);
 
 	return ptr;
 }
@@ -40,7 +42,7 @@ void *malloc_simple(size_t bytes)
 {
 	void *ptr;
 
-	ptr = alloc_simple(bytes, 1);
+	ptr = alloc_simple(bytes, 1, (ulong)__builtin_return_address(0));
 	if (!ptr)
 		return ptr;
 
@@ -50,11 +52,11 @@ void *malloc_simple(size_t bytes)
 	return ptr;
 }
 
-void *memalign_simple(size_t align, size_t bytes)
+void *memalign_simple_caller(size_t align, size_t bytes, ulong caller)
 {
 	void *ptr;
 
-	ptr = alloc_simple(bytes, align);
+	ptr = alloc_simple(bytes, align, caller);
 	if (!ptr)
 		return ptr;
 	log_debug("aligned to %lx\n", (ulong)ptr);
@@ -63,13 +65,20 @@ void *memalign_simple(size_t align, size_t bytes)
 	return ptr;
 }
 
+void *memalign_simple(size_t align, size_t bytes)
+{
+	return memalign_simple_caller(align, bytes,
+				      (ulong)__builtin_return_address(0));
+}
+
 #if CONFIG_IS_ENABLED(SYS_MALLOC_SIMPLE)
 void *calloc(size_t nmemb, size_t elem_size)
 {
 	size_t size = nmemb * elem_size;
 	void *ptr;
 
-	ptr = malloc(size);
+	ptr = memalign_simple_caller(1, size,
+				     (ulong)__builtin_return_address(0));
 	if (!ptr)
 		return ptr;
 	memset(ptr, '\0', size);
@@ -786,6 +786,11 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 	    !IS_ENABLED(CONFIG_SPL_SYS_MALLOC_SIZE))
 		debug("SPL malloc() used 0x%x bytes (%d KB)\n",
 		      gd_malloc_ptr(), gd_malloc_ptr() / 1024);
+	if (IS_ENABLED(CONFIG_SYS_MALLOC_PROFILE_REPORT) &&
+	    CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE)) {
+		printf("SPL malloc() profile:\n");
+		malloc_prof_show(10);
+	}
 
 	bootstage_mark_name(get_bootstage_id(false), "end phase");
 	ret = bootstage_stash_default();
@@ -874,6 +879,35 @@ __weak void spl_relocate_stack_check(void)
 #endif
 }
 
+#if CONFIG_IS_ENABLED(SCRATCH)
+/* Bytes of the scratch area in use */
+static ulong spl_scratch_used;
+
+void *spl_scratch_alloc(size_t size)
+{
+	ulong base = CONFIG_SPL_SCRATCH_ADDR;
+	ulong addr = ALIGN(base + spl_scratch_used, ARCH_DMA_MINALIGN);
+
+	if (addr + size > base + CONFIG_SPL_SCRATCH_SIZE) {
+		log_debug("No room for %lx bytes\n", (ulong)size);
+		return NULL;
+	}
+	spl_scratch_used = addr + size - base;
+
+	return map_sysmem(addr, size);
+}
+
+ulong spl_scratch_mark(void)
+{
+	return spl_scratch_used;
+}
+
+void spl_scratch_release(ulong mark)
+{
+	spl_scratch_used = mark;
+}
+#endif
+
 /**
  * spl_relocate_stack_gd() - Relocate stack ready for board_init_r() execution
  *
@@ -16,6 +16,7 @@
 #include <log.h>
 #include <spl.h>
 #include <asm/cache.h>
+#include <linux/libfdt.h>
 
 /* Holds all the structures we need for bl31 parameter passing */
 struct bl2_to_bl31_params_mem {
@@ -188,8 +189,34 @@ static inline void raw_write_daif(unsigned int daif)
 
 typedef void __noreturn (*atf_entry_t)(struct bl31_params *params, void *plat_params);
 
+/*
+ * Linux expects its device tree in x0 rather than the MPIDR which BL33 gets
+ * by default, so update the BL33 entry-point arguments for Falcon mode
+ */
+static void bl31_set_bl33_fdt(void *bl31_params, uintptr_t bl33_fdt)
+{
+	struct entry_point_info *ep_info = NULL;
+
+	if (CONFIG_IS_ENABLED(ATF_LOAD_IMAGE_V2)) {
+		struct bl_params_node *node;
+
+		for_each_bl_params_node((struct bl_params *)bl31_params, node) {
+			if (node->image_id == ATF_BL33_IMAGE_ID)
+				ep_info = node->ep_info;
+		}
+	} else {
+		ep_info = ((struct bl31_params *)bl31_params)->bl33_ep_info;
+	}
+	if (!ep_info)
+		return;
+
+	memset(&ep_info->args, '\0', sizeof(ep_info->args));
+	ep_info->args.arg0 = bl33_fdt;
+}
+
 static void __noreturn bl31_entry(uintptr_t bl31_entry, uintptr_t bl32_entry,
-				  uintptr_t bl33_entry, uintptr_t fdt_addr)
+				  uintptr_t bl33_entry, uintptr_t fdt_addr,
+				  uintptr_t bl33_fdt)
 {
 	atf_entry_t  atf_entry = (atf_entry_t)bl31_entry;
 	void *bl31_params;
@@ -201,6 +228,8 @@ static void __noreturn bl31_entry(uintptr_t bl31_entry, uintptr_t bl32_entry,
 	else
 		bl31_params = bl2_plat_get_bl31_params(bl32_entry, bl33_entry,
 						       fdt_addr);
+	if (bl33_fdt)
+		bl31_set_bl33_fdt(bl31_params, bl33_fdt);
 
 	raw_write_daif(SPSR_EXCEPTION_MASK);
 	if (!CONFIG_IS_ENABLED(SYS_DCACHE_OFF))
@@ -255,6 +284,7 @@ void __noreturn spl_invoke_atf(struct spl_image_info *spl_image)
 {
 	uintptr_t  bl32_entry = 0;
 	uintptr_t  bl33_entry = CONFIG_TEXT_BASE;
+	uintptr_t  bl33_fdt = 0;
 	void *blob = spl_image->fdt_addr;
 	uintptr_t platform_param = (uintptr_t)blob;
 	int node;
@@ -272,13 +302,29 @@ void __noreturn spl_invoke_atf(struct spl_image_info *spl_image)
 	 * Find the U-Boot binary (in /fit-images) load addreess or
 	 * entry point (if different) and pass it as the BL3-3 entry
 	 * point.
-	 * This will need to be extended to support Falcon mode.
 	 */
 
 	node = spl_fit_images_find(blob, IH_OS_U_BOOT);
 	if (node >= 0)
 		bl33_entry = spl_fit_images_get_entry(blob, node);
 
+	/*
+	 * In Falcon mode the FIT carries a Linux kernel instead, which is
+	 * started as BL3-3 with its device tree: a tree prepared with
+	 * 'spl export' and loaded as the OS args if there is one, else the
+	 * one from the FIT configuration.
+	 */
+	if (CONFIG_IS_ENABLED(OS_BOOT)) {
+		node = spl_fit_images_find(blob, IH_OS_LINUX);
+		if (node >= 0) {
+			bl33_entry = spl_fit_images_get_entry(blob, node);
+			if (spl_image->arg && !fdt_check_header(spl_image->arg))
+				bl33_fdt = (uintptr_t)spl_image->arg;
+			else
+				bl33_fdt = (uintptr_t)blob;
+		}
+	}
+
 	/*
 	 * If ATF_NO_PLATFORM_PARAM is set, we override the platform
 	 * parameter and always pass 0.  This is a workaround for
@@ -293,5 +339,5 @@ void __noreturn spl_invoke_atf(struct spl_image_info *spl_image)
 	 * using similar logic.
 	 */
 	bl31_entry(spl_image->entry_point, bl32_entry,
-		   bl33_entry, platform_param);
+		   bl33_entry, platform_param, bl33_fdt);
 }
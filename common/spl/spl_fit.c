@@ -18,6 +18,7 @@
 #include <asm/io.h>
 #include <linux/libfdt.h>
 #include <linux/printk.h>
+#include <lzma/LzmaTools.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -187,6 +188,186 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return ALIGN(data_size, spl_get_bl_len(info));
 }
 
+/* Check whether SPL can decompress images using @comp */
+static bool spl_fit_can_decomp(uint8_t comp)
+{
+	return (IS_ENABLED(CONFIG_SPL_GZIP) && comp == IH_COMP_GZIP) ||
+		(IS_ENABLED(CONFIG_SPL_LZMA) && comp == IH_COMP_LZMA) ||
+		(IS_ENABLED(CONFIG_SPL_LZ4) && comp == IH_COMP_LZ4) ||
+		(IS_ENABLED(CONFIG_SPL_ZSTD) && comp == IH_COMP_ZSTD);
+}
+
+#if CONFIG_IS_ENABLED(FIT_STREAM)
+/* Find where the chunk at @pos is read to */
+static void *stream_chunk_buf(void *buf, ulong pos, ulong chunk, bool decomp,
+			      ulong bufs)
+{
+	if (!decomp)
+		return buf + pos;
+
+	return buf + pos / chunk % bufs * chunk;
+}
+
+/**
+ * load_simple_fit_stream() - load external image data a chunk at a time
+ * @info:	points to information about the device to load data from
+ * @fit_offset:	the start offset of the FIT image on the device
+ * @fit:	pointer to the FIT
+ * @node:	offset of the DT node describing the image to load
+ * @offset:	offset of the image data from @fit_offset
+ * @length:	size of the image data
+ * @image_comp:	compression used for the image data
+ * @load_addr:	address to load the image to
+ * @lengthp:	returns the size of the loaded (decompressed) image
+ *
+ * Each chunk is hashed and, for gzip and LZMA images, decompressed as soon
+ * as it is read, so that the image is only passed over once. Compressed data is read
+ * into a chunk-sized buffer from the scratch area or the heap, so no staging
+ * area is needed for the whole compressed image unless both are too small.
+ *
+ * If the device can start a read without waiting for it, the next chunk is
+ * read while the current one is worked on; compressed data then alternates
+ * between two chunk buffers.
+ *
+ * Return:	0 on success, -ENOTSUPP if the image must be loaded in one
+ *		go, or another negative error number.
+ */
+static int load_simple_fit_stream(struct spl_load_info *info, ulong fit_offset,
+				  const void *fit, int node, int offset,
+				  size_t length, uint8_t image_comp,
+				  ulong load_addr, size_t *lengthp)
+{
+	ulong chunk = ALIGN(CONFIG_SPL_FIT_STREAM_CHUNK, spl_get_bl_len(info));
+	ulong overhead = get_aligned_image_overhead(info, offset);
+	ulong dev_offset = fit_offset + get_aligned_image_offset(info, offset);
+	ulong size = get_aligned_image_size(info, length, offset);
+	bool gzip = IS_ENABLED(CONFIG_SPL_GZIP) && image_comp == IH_COMP_GZIP;
+	bool lzma = IS_ENABLED(CONFIG_SPL_LZMA) && image_comp == IH_COMP_LZMA;
+	bool decomp = gzip || lzma;
+	bool hashing = CONFIG_IS_ENABLED(FIT_SIGNATURE);
+	bool async = info->submit;
+	ulong bufs = decomp && async ? 2 : 1;
+	struct gunzip_stream *gs = NULL;
+	struct lzma_stream *ls = NULL;
+	struct fit_hash_stream hs;
+	bool decomp_err = false, pending = false;
+	void *load_ptr, *buf, *chunk_buf = NULL;
+	ulong pos, next, got, out_len;
+	int ret = 0;
+
+	/* Only gzip and LZMA data can be decompressed a piece at a time */
+	if (!decomp && spl_fit_can_decomp(image_comp))
+		return -ENOTSUPP;
+	/* Nothing to gain for an unchecked, uncompressed image */
+	if (!hashing && !decomp)
+		return -ENOTSUPP;
+	if (hashing &&
+	    fit_image_hash_stream_start(fit, node, gd_fdt_blob(), &hs))
+		return -ENOTSUPP;
+
+	load_ptr = map_sysmem(load_addr, length);
+	if (decomp) {
+		buf = spl_scratch_alloc(chunk * bufs);
+		if (!buf)
+			buf = chunk_buf = malloc_cache_aligned(chunk * bufs);
+		if (!buf)
+			buf = map_sysmem(ALIGN(CONFIG_SYS_LOAD_ADDR,
+					       ARCH_DMA_MINALIGN), chunk * bufs);
+		if (gzip)
+			gs = gunzip_stream_start(load_ptr, CONFIG_SYS_BOOTM_LEN);
+		else if (lzma)
+			ls = lzma_stream_start(load_ptr, CONFIG_SYS_BOOTM_LEN);
+		if (!gs && !ls)
+			ret = -ENOMEM;
+	} else {
+		buf = map_sysmem(ALIGN(load_addr, ARCH_DMA_MINALIGN), size);
+	}
+
+	if (hashing)
+		printf("## Checking hash(es) for Image %s ... ",
+		       fit_get_name(fit, node, NULL));
+
+	if (!ret && async)
+		pending = !info->submit(info, dev_offset, min(chunk, size),
+					stream_chunk_buf(buf, 0, chunk, decomp,
+							 bufs));
+
+	for (pos = 0; !ret && pos < size; pos += chunk) {
+		ulong count = min(chunk, size - pos);
+		ulong start = max(pos, overhead);
+		ulong end = min(pos + count, overhead + length);
+		void *dst = stream_chunk_buf(buf, pos, chunk, decomp, bufs);
+		void *data = dst + start - pos;
+
+		if (pending) {
+			got = info->wait(info);
+			/* Read the next chunk while this one is worked on */
+			next = pos + chunk;
+			pending = got >= end - pos && next < size &&
+				!info->submit(info, dev_offset + next,
+					      min(chunk, size - next),
+					      stream_chunk_buf(buf, next, chunk,
+							       decomp, bufs));
+		} else {
+			got = info->read(info, dev_offset + pos, count, dst);
+		}
+		if (got < end - pos) {
+			ret = -EIO;
+			break;
+		}
+		if (hashing)
+			fit_image_hash_stream_update(&hs, data, end - start);
+		/* Stop feeding once the end of the stream is found */
+		if (gs && !decomp_err &&
+		    gunzip_stream_feed(gs, data, end - start) < 0)
+			decomp_err = true;
+		if (ls && !decomp_err &&
+		    lzma_stream_feed(ls, data, end - start) < 0)
+			decomp_err = true;
+	}
+	debug("Streamed data: dst=%p, offset=%x, size=%lx\n", load_ptr, offset,
+	      (unsigned long)length);
+
+	if (hashing) {
+		if (!fit_image_hash_stream_finish(&hs)) {
+			if (!ret)
+				ret = -EPERM;
+		} else if (!ret) {
+			puts("OK\n");
+		}
+	}
+
+	if (gs || ls) {
+		if (gs && gunzip_stream_end(gs, &out_len))
+			decomp_err = true;
+		if (ls && lzma_stream_end(ls, &out_len))
+			decomp_err = true;
+		if (!ret && decomp_err) {
+			puts("Uncompressing error\n");
+			ret = -EIO;
+		}
+		length = out_len;
+	} else if (!ret) {
+		memmove(load_ptr, buf + overhead, length);
+	}
+	free(chunk_buf);
+	if (ret)
+		return ret;
+
+	*lengthp = length;
+
+	return 0;
+}
+#else
+static int load_simple_fit_stream(struct spl_load_info *info, ulong fit_offset,
+				  const void *fit, int node, int offset,
+				  size_t length, uint8_t image_comp,
+				  ulong load_addr, size_t *lengthp)
+{
+	return -ENOTSUPP;
+}
+#endif
+
 /**
  * load_simple_fit(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -201,9 +382,9 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
  *
  * Return:	0 on success or a negative error number.
  */
-static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
-			   const struct spl_fit_info *ctx, int node,
-			   struct spl_image_info *image_info)
+static int __load_simple_fit(struct spl_load_info *info, ulong fit_offset,
+			     const struct spl_fit_info *ctx, int node,
+			     struct spl_image_info *image_info)
 {
 	int offset;
 	size_t length;
@@ -261,16 +442,35 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 			return 0;
 		}
 
-		if (spl_decompression_enabled() &&
-		    (image_comp == IH_COMP_GZIP || image_comp == IH_COMP_LZMA))
-			src_ptr = map_sysmem(ALIGN(CONFIG_SYS_LOAD_ADDR, ARCH_DMA_MINALIGN), len);
-		else
-			src_ptr = map_sysmem(ALIGN(load_addr, ARCH_DMA_MINALIGN), len);
-		length = len;
+		if (CONFIG_IS_ENABLED(FIT_STREAM)) {
+			int ret;
+
+			ret = load_simple_fit_stream(info, fit_offset, fit,
+						     node, offset, len,
+						     image_comp, load_addr,
+						     &length);
+			if (!ret)
+				goto loaded;
+			if (ret != -ENOTSUPP)
+				return ret;
+		}
 
+		length = len;
 		overhead = get_aligned_image_overhead(info, offset);
 		size = get_aligned_image_size(info, length, offset);
 
+		/* Compressed data is staged apart from its load address */
+		src_ptr = NULL;
+		if (spl_fit_can_decomp(image_comp)) {
+			src_ptr = spl_scratch_alloc(size);
+			if (!src_ptr)
+				src_ptr = map_sysmem(ALIGN(CONFIG_SYS_LOAD_ADDR,
+							   ARCH_DMA_MINALIGN),
+						     len);
+		}
+		if (!src_ptr)
+			src_ptr = map_sysmem(ALIGN(load_addr, ARCH_DMA_MINALIGN), len);
+
 		if (info->read(info,
 			       fit_offset +
 			       get_aligned_image_offset(info, offset), size,
@@ -311,11 +511,11 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 			return -EIO;
 		}
 		length = size;
-	} else if (IS_ENABLED(CONFIG_SPL_LZMA) && image_comp == IH_COMP_LZMA) {
+	} else if (spl_fit_can_decomp(image_comp)) {
 		size = CONFIG_SYS_BOOTM_LEN;
 		ulong loadEnd;
 
-		if (image_decomp(IH_COMP_LZMA, CONFIG_SYS_LOAD_ADDR, 0, 0,
+		if (image_decomp(image_comp, CONFIG_SYS_LOAD_ADDR, 0, 0,
 				 load_ptr, src, length, size, &loadEnd)) {
 			puts("Uncompressing error\n");
 			return -EIO;
@@ -325,6 +525,7 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 		memcpy(load_ptr, src, length);
 	}
 
+loaded:
 	if (image_info) {
 		ulong entry_point;
 
@@ -342,6 +543,20 @@ static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
 	return 0;
 }
 
+static int load_simple_fit(struct spl_load_info *info, ulong fit_offset,
+			   const struct spl_fit_info *ctx, int node,
+			   struct spl_image_info *image_info)
+{
+	ulong mark = spl_scratch_mark();
+	int ret;
+
+	/* Staging and chunk buffers are only needed while the image loads */
+	ret = __load_simple_fit(info, fit_offset, ctx, node, image_info);
+	spl_scratch_release(mark);
+
+	return ret;
+}
+
 static bool os_takes_devicetree(uint8_t os)
 {
 	switch (os) {
@@ -549,6 +764,11 @@ static void *spl_get_fit_load_buffer(size_t size)
 {
 	void *buf;
 
+	/* The size comes from the FIT header, so keep it off the heap if we can */
+	buf = spl_scratch_alloc(size);
+	if (buf)
+		return buf;
+
 	buf = malloc_cache_aligned(size);
 	if (!buf) {
 		pr_err("Could not get FIT buffer of %lu bytes\n", (ulong)size);
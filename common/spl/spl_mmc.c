@@ -27,6 +27,36 @@ static ulong h_spl_load_read(struct spl_load_info *load, ulong off,
 	return blk_dread(bd, sector, count, buf) << bd->log2blksz;
 }
 
+#if CONFIG_IS_ENABLED(FIT_STREAM) && CONFIG_IS_ENABLED(BLK) && \
+	IS_ENABLED(CONFIG_BLK_ASYNC)
+/* SPL only ever has one read in flight */
+static struct blk_req spl_mmc_req;
+
+static int h_spl_load_submit(struct spl_load_info *load, ulong off,
+			     ulong size, void *buf)
+{
+	struct blk_desc *bd = load->priv;
+
+	return blk_read_submit(bd->bdev, off >> bd->log2blksz,
+			       size >> bd->log2blksz, buf, &spl_mmc_req);
+}
+
+static ulong h_spl_load_wait(struct spl_load_info *load)
+{
+	struct blk_desc *bd = load->priv;
+	long ret;
+
+	ret = blk_req_wait(&spl_mmc_req);
+	if (ret < 0)
+		return 0;
+
+	return ret << bd->log2blksz;
+}
+#else
+#define h_spl_load_submit	NULL
+#define h_spl_load_wait		NULL
+#endif
+
 static __maybe_unused unsigned long spl_mmc_raw_uboot_offset(int part)
 {
 #if IS_ENABLED(CONFIG_SYS_MMCSD_RAW_MODE_U_BOOT_USE_SECTOR)
@@ -47,6 +77,7 @@ int mmc_load_image_raw_sector(struct spl_image_info *spl_image,
 	struct spl_load_info load;
 
 	spl_load_init(&load, h_spl_load_read, bd, bd->blksz);
+	spl_load_set_async(&load, h_spl_load_submit, h_spl_load_wait);
 	ret = spl_load(spl_image, bootdev, &load, 0, sector << bd->log2blksz);
 	if (ret) {
 		puts("mmc_load_image_raw_sector: mmc block read error\n");
@@ -168,7 +199,10 @@ static int mmc_load_image_raw_os(struct spl_image_info *spl_image,
 	if (ret)
 		return ret;
 
-	if (spl_image->os != IH_OS_LINUX && spl_image->os != IH_OS_TEE) {
+	/* A FIT with TF-A starts the kernel through it as BL33 */
+	if (spl_image->os != IH_OS_LINUX && spl_image->os != IH_OS_TEE &&
+	    !(CONFIG_IS_ENABLED(ATF) &&
+	      spl_image->os == IH_OS_ARM_TRUSTED_FIRMWARE)) {
 		puts("Expected image is not found. Trying to start U-Boot\n");
 		return -ENOENT;
 	}
@@ -19,9 +19,17 @@
 static ulong spl_net_load_read(struct spl_load_info *load, ulong sector,
 			       ulong count, void *buf)
 {
+	void *src = map_sysmem(image_load_addr + sector, count);
+
 	debug("%s: sector %lx, count %lx, buf %lx\n",
 	      __func__, sector, count, (ulong)buf);
-	memcpy(buf, map_sysmem(image_load_addr + sector, count), count);
+	/*
+	 * The whole file is already in memory. If the caller wants it where
+	 * it was downloaded, e.g. a FIT at CONFIG_SYS_LOAD_ADDR with
+	 * SPL_LOAD_FIT_FULL, there is nothing to copy.
+	 */
+	if (buf != src)
+		memcpy(buf, src, count);
 	return count;
 }
 
@@ -41,6 +49,9 @@ static int spl_net_load_image(struct spl_image_info *spl_image,
 	}
 	if (bootdev->boot_device_name)
 		env_set("ethact", bootdev->boot_device_name);
+	/* Download a full FIT straight to where it is parsed */
+	if (IS_ENABLED(CONFIG_SPL_LOAD_FIT_FULL))
+		image_load_addr = CONFIG_SYS_LOAD_ADDR;
 	rv = net_loop(BOOTP);
 	if (rv < 0) {
 		printf("Problem booting with BOOTP\n");
@@ -11,12 +11,16 @@
 #include <gzip.h>
 #include <image.h>
 #include <log.h>
+#include <serial.h>
 #include <spl.h>
 #include <xyzModem.h>
+#include <asm/global_data.h>
 #include <linux/libfdt.h>
 
 #define BUF_SIZE 1024
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /*
  * Information required to load image using ymodem.
  *
@@ -34,6 +38,16 @@ static int getcymodem(void) {
 	return -1;
 }
 
+/* Change the baud rate, once the message has gone out at the old one */
+static void ymodem_setbrg(int baudrate)
+{
+	printf("spl: switch to %d baud\n", baudrate);
+	flush();
+	mdelay(50);
+	gd->baudrate = baudrate;
+	serial_setbrg();
+}
+
 static ulong ymodem_read_fit(struct spl_load_info *load, ulong offset,
 			     ulong size, void *addr)
 {
@@ -96,12 +110,18 @@ int spl_ymodem_load_image(struct spl_image_info *spl_image,
 	char buf[BUF_SIZE];
 	struct legacy_img_hdr *ih = NULL;
 	ulong addr = 0;
+	int baudrate = gd->baudrate;
+
+	if (CONFIG_SPL_YMODEM_BAUDRATE &&
+	    CONFIG_SPL_YMODEM_BAUDRATE != baudrate)
+		ymodem_setbrg(CONFIG_SPL_YMODEM_BAUDRATE);
 
-	info.mode = xyzModem_ymodem;
+	info.mode = IS_ENABLED(CONFIG_SPL_YMODEM_G) ? xyzModem_ymodem_g :
+		xyzModem_ymodem;
 	ret = xyzModem_stream_open(&info, &err);
 	if (ret) {
 		printf("spl: ymodem err - %s\n", xyzModem_error(err));
-		return ret;
+		goto out;
 	}
 
 	res = xyzModem_stream_read(buf, BUF_SIZE, &err);
@@ -125,7 +145,7 @@ int spl_ymodem_load_image(struct spl_image_info *spl_image,
 
 		ret = spl_parse_image_header(spl_image, bootdev, ih);
 		if (ret)
-			return ret;
+			goto out;
 	} else if (IS_ENABLED(CONFIG_SPL_LOAD_FIT) &&
 	    image_get_magic((struct legacy_img_hdr *)buf) == FDT_MAGIC) {
 		struct spl_load_info load;
@@ -167,6 +187,9 @@ end_stream:
 	xyzModem_stream_close(&err);
 	xyzModem_stream_terminate(false, &getcymodem);
 
+	if (gd->baudrate != baudrate)
+		ymodem_setbrg(baudrate);
+
 	printf("Loaded %lu bytes\n", size);
 
 #ifdef CONFIG_SPL_GZIP
@@ -184,5 +207,11 @@ end_stream:
 #endif
 
 	return ret;
+
+out:
+	if (gd->baudrate != baudrate)
+		ymodem_setbrg(baudrate);
+
+	return ret;
 }
 SPL_LOAD_IMAGE_METHOD("UART", 0, BOOT_DEVICE_UART, spl_ymodem_load_image);
@@ -0,0 +1,132 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Cooperative tasks, which let a long-running job yield while it waits
+ *
+ * Each task has its own stack. Tasks are run in turn from schedule(), each
+ * until it next calls schedule() or finishes, at which point the code that
+ * called schedule() carries on. Switching uses setjmp() and longjmp(), with
+ * initjmp() to start each task on its stack.
+ */
+
+#include <cyclic.h>
+#include <log.h>
+#include <malloc.h>
+#include <task.h>
+#include <vsprintf.h>
+#include <linux/errno.h>
+#include <linux/list.h>
+
+/* Written to the bottom of each stack, to detect overflow */
+#define TASK_STACK_MAGIC	0x7a5c0de5UL
+
+/**
+ * struct task_info - Information about the tasks
+ *
+ * @head: List of tasks which have not finished, in the order they are run
+ * @cur: Task which is running, or NULL if none
+ * @sched: Context to return to when the running task yields or finishes
+ */
+struct task_info {
+	struct list_head head;
+	struct task *cur;
+	jmp_buf sched;
+};
+
+static struct task_info task_info = {
+	.head = LIST_HEAD_INIT(task_info.head),
+};
+
+static void __noreturn task_entry(void)
+{
+	struct task *task = task_info.cur;
+
+	task->ret = task->func(task->arg);
+	task->done = true;
+	longjmp(task_info.sched, 1);
+}
+
+int task_start(struct task *task, const char *name, task_func_t func,
+	       void *arg, size_t stack_size)
+{
+	int ret;
+
+	if (!stack_size)
+		stack_size = CONFIG_TASK_STACK_SIZE;
+	task->name = name;
+	task->func = func;
+	task->arg = arg;
+	task->ret = 0;
+	task->done = false;
+	task->stack_size = stack_size;
+	task->stack = memalign(16, stack_size);
+	if (!task->stack)
+		return -ENOMEM;
+	*(ulong *)task->stack = TASK_STACK_MAGIC;
+	ret = initjmp(task->ctx, task_entry, task->stack, stack_size);
+	if (ret) {
+		free(task->stack);
+		task->stack = NULL;
+		return ret;
+	}
+	list_add_tail(&task->sibling, &task_info.head);
+	log_debug("Started task %s\n", name);
+
+	return 0;
+}
+
+struct task *task_current(void)
+{
+	return task_info.cur;
+}
+
+void task_yield(void)
+{
+	struct task *task = task_info.cur;
+
+	if (!task) {
+		schedule();
+		return;
+	}
+	if (!setjmp(task->ctx))
+		longjmp(task_info.sched, 1);
+}
+
+/* Run a task until it yields or finishes */
+static void task_run(struct task *task)
+{
+	if (!setjmp(task_info.sched)) {
+		task_info.cur = task;
+		longjmp(task->ctx, 1);
+	}
+	task_info.cur = NULL;
+
+	if (*(ulong *)task->stack != TASK_STACK_MAGIC)
+		panic("Task %s overflowed its %zx-byte stack\n", task->name,
+		      task->stack_size);
+	if (task->done) {
+		log_debug("Task %s done (ret=%d)\n", task->name, task->ret);
+		list_del(&task->sibling);
+		free(task->stack);
+		task->stack = NULL;
+	}
+}
+
+void task_run_all(void)
+{
+	struct task *task, *next;
+
+	if (task_info.cur)
+		return;
+	list_for_each_entry_safe(task, next, &task_info.head, sibling)
+		task_run(task);
+}
+
+int task_join(struct task *task)
+{
+	if (task == task_info.cur)
+		return -EDEADLK;
+	while (!task->done)
+		task_yield();
+
+	return task->ret;
+}
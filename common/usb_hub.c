@@ -566,18 +566,20 @@ static int usb_scan_port(struct usb_device_scan *usb_scan)
 	return 0;
 }
 
+/* Non-zero while the scan list is being scanned, or is held */
+static int usb_scan_running;
+
 static int usb_device_list_scan(void)
 {
 	struct usb_device_scan *usb_scan;
 	struct usb_device_scan *tmp;
-	static int running;
 	int ret = 0;
 
 	/* Only run this loop once for each controller */
-	if (running)
+	if (usb_scan_running)
 		return 0;
 
-	running = 1;
+	usb_scan_running = 1;
 
 	while (1) {
 		/* We're done, once the list is empty again */
@@ -597,14 +599,26 @@ static int usb_device_list_scan(void)
 out:
 	/*
 	 * This USB controller has finished scanning all its connected
-	 * USB devices. Set "running" back to 0, so that other USB controllers
+	 * USB devices. Set it back to 0, so that other USB controllers
 	 * will scan their devices too.
 	 */
-	running = 0;
+	usb_scan_running = 0;
 
 	return ret;
 }
 
+void usb_hub_scan_hold(void)
+{
+	usb_scan_running = 1;
+}
+
+int usb_hub_scan_release(void)
+{
+	usb_scan_running = 0;
+
+	return usb_device_list_scan();
+}
+
 static struct usb_hub_device *usb_get_hub_device(struct usb_device *dev)
 {
 	struct usb_hub_device *hub;
@@ -7,6 +7,7 @@
  * project.
  */
 #include <console.h>
+#include <cyclic.h>
 #include <dm.h>
 #include <env.h>
 #include <errno.h>
@@ -53,6 +54,9 @@ int overwrite_console(void)
 #define REPEAT_RATE	40		/* 40msec -> 25cps */
 #define REPEAT_DELAY	10		/* 10 x REPEAT_RATE = 400msec */
 
+/* Interval between polls of the interrupt queue by the cyclic function */
+#define USB_KBD_CYCLIC_US	20000
+
 #define NUM_LOCK	0x53
 #define CAPS_LOCK	0x39
 #define SCROLL_LOCK	0x47
@@ -130,12 +134,18 @@ struct usb_kbd_pdata {
 	uint8_t		old[USB_KBD_BOOT_REPORT_SIZE];
 
 	uint8_t		flags;
+
+#ifdef CONFIG_USB_KEYBOARD_CYCLIC
+	struct cyclic_info cyclic;
+	struct usb_device *dev;
+	bool		led_pending;
+#endif
 };
 
 extern int __maybe_unused net_busy_flag;
 
 /* The period of time between two calls of usb_kbd_testc(). */
-static unsigned long kbd_testc_tms;
+static unsigned long __maybe_unused kbd_testc_tms;
 
 int usb_kbd_remove_for_test(void)
 {
@@ -348,8 +358,17 @@ static int usb_kbd_irq_worker(struct usb_device *dev)
 	if ((data->new[2] > 3) && (data->old[2] == data->new[2]))
 		res |= usb_kbd_translate(data, data->new[2], data->new[0], 2);
 
-	if (res == 1)
+	if (res == 1) {
+#ifdef CONFIG_USB_KEYBOARD_CYCLIC
+		/*
+		 * This may run from schedule() in the middle of another USB
+		 * transfer, so leave the control transfer to usb_kbd_testc()
+		 */
+		data->led_pending = true;
+#else
 		usb_kbd_setled(dev);
+#endif
+	}
 
 	memcpy(data->old, data->new, USB_KBD_BOOT_REPORT_SIZE);
 
@@ -409,6 +428,21 @@ static inline void usb_kbd_poll_for_event(struct usb_device *dev)
 #endif
 }
 
+#ifdef CONFIG_USB_KEYBOARD_CYCLIC
+/*
+ * Poll the interrupt queue at a fixed rate, so that checking for a key only
+ * has to look at the keyboard buffer. Polling the queue just reads the
+ * transfer status from memory, so it is safe to do from schedule().
+ */
+static void usb_kbd_cyclic(struct cyclic_info *c)
+{
+	struct usb_kbd_pdata *data = container_of(c, struct usb_kbd_pdata,
+						  cyclic);
+
+	usb_kbd_poll_for_event(data->dev);
+}
+#endif
+
 /* test if a character is in the queue */
 static int usb_kbd_testc(struct stdio_dev *sdev)
 {
@@ -416,6 +450,19 @@ static int usb_kbd_testc(struct stdio_dev *sdev)
 	struct usb_device *usb_kbd_dev;
 	struct usb_kbd_pdata *data;
 
+#ifdef CONFIG_USB_KEYBOARD_CYCLIC
+	dev = stdio_get_by_name(sdev->name);
+	usb_kbd_dev = (struct usb_device *)dev->priv;
+	data = usb_kbd_dev->privptr;
+
+	if (data->led_pending) {
+		data->led_pending = false;
+		usb_kbd_setled(usb_kbd_dev);
+	}
+
+	return !(data->usb_in_pointer == data->usb_out_pointer);
+#else
+
 	/*
 	 * Polling the keyboard for an event can take dozens of milliseconds.
 	 * Add a delay between polls to avoid blocking activity which polls
@@ -451,6 +498,7 @@ static int usb_kbd_testc(struct stdio_dev *sdev)
 	}
 
 	return !(data->usb_in_pointer == data->usb_out_pointer);
+#endif
 }
 
 /* gets the character from the queue */
@@ -466,7 +514,8 @@ static int usb_kbd_getc(struct stdio_dev *sdev)
 
 	while (data->usb_in_pointer == data->usb_out_pointer) {
 		schedule();
-		usb_kbd_poll_for_event(usb_kbd_dev);
+		if (!IS_ENABLED(CONFIG_USB_KEYBOARD_CYCLIC))
+			usb_kbd_poll_for_event(usb_kbd_dev);
 	}
 
 	if (data->usb_out_pointer == USB_KBD_BUFFER_LEN - 1)
@@ -592,6 +641,12 @@ static int usb_kbd_probe_dev(struct usb_device *dev, unsigned int ifnum)
 		return 0;
 	}
 
+#ifdef CONFIG_USB_KEYBOARD_CYCLIC
+	data->dev = dev;
+	cyclic_register(&data->cyclic, usb_kbd_cyclic, USB_KBD_CYCLIC_US,
+			DEVNAME);
+#endif
+
 	/* Success. */
 	return 1;
 }
@@ -678,6 +733,10 @@ static int usb_kbd_remove(struct udevice *dev)
 		ret = -EPERM;
 		goto err;
 	}
+#ifdef CONFIG_USB_KEYBOARD_CYCLIC
+	if (data->dev)
+		cyclic_unregister(&data->cyclic);
+#endif
 #ifdef CONFIG_SYS_USB_EVENT_POLL_VIA_INT_QUEUE
 	destroy_int_queue(udev, data->intq);
 #endif
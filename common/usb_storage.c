@@ -35,6 +35,7 @@
 #include <bootdev.h>
 #include <command.h>
 #include <dm.h>
+#include <env.h>
 #include <errno.h>
 #include <log.h>
 #include <mapmem.h>
@@ -952,6 +953,47 @@ do_retry:
 	return USB_STOR_TRANSPORT_FAILED;
 }
 
+/* Quirks which can be set with the usb_storage_quirks variable */
+#define US_FL_MAX_SECTORS_64	BIT(0)	/* 'm': at most 64 blocks */
+#define US_FL_MAX_SECTORS_240	BIT(1)	/* 'g': at most 240 blocks */
+
+/**
+ * usb_stor_get_quirks() - Get the quirks for a device from the environment
+ *
+ * The usb_storage_quirks variable holds a comma-separated list of entries of
+ * the form "vid:pid:flags", with the IDs in hex. This follows the quirks
+ * parameter of the Linux usb-storage driver, using the same flag letters.
+ *
+ * @udev: Device to check
+ * Return: US_FL_... flags for the device, 0 if none
+ */
+static uint usb_stor_get_quirks(struct usb_device *udev)
+{
+	const char *p = env_get("usb_storage_quirks");
+	uint quirks = 0;
+	char *end;
+	ulong vid, pid;
+
+	while (p && *p) {
+		vid = hextoul(p, &end);
+		pid = *end == ':' ? hextoul(end + 1, &end) : ~0UL;
+		if (*end == ':' && vid == udev->descriptor.idVendor &&
+		    pid == udev->descriptor.idProduct) {
+			for (p = end + 1; *p && *p != ','; p++) {
+				if (*p == 'm')
+					quirks |= US_FL_MAX_SECTORS_64;
+				else if (*p == 'g')
+					quirks |= US_FL_MAX_SECTORS_240;
+			}
+		}
+		p = strchr(end, ',');
+		if (p)
+			p++;
+	}
+
+	return quirks;
+}
+
 static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 				      struct us_data *us)
 {
@@ -971,8 +1013,20 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
 	 * and 2048 for USB3 devices.
+	 *
+	 * Linux also uses 2048 for USB3 devices, so follow that, allowing
+	 * the limit to be lowered for a device which cannot handle it.
 	 */
 	unsigned short blk = 240;
+	uint quirks;
+
+	if (udev->speed >= USB_SPEED_SUPER)
+		blk = CONFIG_USB_STORAGE_SS_MAX_XFER_BLK;
+	quirks = usb_stor_get_quirks(udev);
+	if (quirks & US_FL_MAX_SECTORS_240)
+		blk = min_t(unsigned short, blk, 240);
+	if (quirks & US_FL_MAX_SECTORS_64)
+		blk = min_t(unsigned short, blk, 64);
 
 #if CONFIG_IS_ENABLED(DM_USB)
 	size_t size;
@@ -52,6 +52,7 @@ static struct
   int len, mode, total_retries;
   int total_SOH, total_STX, total_CAN;
   bool crc_mode, at_eof, tx_ack;
+  bool stream;			/* YMODEM-g: blocks are not acknowledged */
   bool first_xmodem_packet;
   ulong initial_time, timeout;
   unsigned long file_length, read_length;
@@ -66,20 +67,21 @@ typedef int cyg_int32;
 static int
 CYGACC_COMM_IF_GETC_TIMEOUT (char chan, char *c)
 {
+  ulong now;
 
-  ulong now = get_timer(0);
-  schedule();
-  while (!tstc ())
-    {
-      if (get_timer(now) > xyzModem_CHAR_TIMEOUT)
-        break;
-    }
-  if (tstc ())
+  /* Only start the clock if the character has not arrived yet */
+  if (!tstc ())
     {
-      *c = getchar();
-      return 1;
+      now = get_timer(0);
+      schedule();
+      while (!tstc ())
+	{
+	  if (get_timer(now) > xyzModem_CHAR_TIMEOUT)
+	    return 0;
+	}
     }
-  return 0;
+  *c = getchar();
+  return 1;
 }
 
 static void
@@ -88,6 +90,15 @@ CYGACC_COMM_IF_PUTC (char x, char y)
   putc (y);
 }
 
+/* Character asking the sender to start (or restart) sending */
+static char
+xyzModem_start_char (void)
+{
+  if (xyz.stream)
+    return 'G';
+  return xyz.crc_mode ? 'C' : NAK;
+}
+
 /* Validate a hex character */
 __inline__ static bool
 _is_hex (char c)
@@ -260,6 +271,7 @@ xyzModem_get_hdr (void)
   unsigned short cksum;
 
   ZM_DEBUG (zm_new ());
+  schedule();
   /* Find the start of a header */
   can_total = 0;
   hdr_chars = 0;
@@ -447,7 +459,8 @@ xyzModem_stream_open (connection_info_t * info, int *err)
   xyz.crc_mode = true;
   xyz.at_eof = false;
   xyz.tx_ack = false;
-  xyz.mode = info->mode;
+  xyz.stream = info->mode == xyzModem_ymodem_g;
+  xyz.mode = xyz.stream ? xyzModem_ymodem : info->mode;
   xyz.total_retries = 0;
   xyz.total_SOH = 0;
   xyz.total_STX = 0;
@@ -458,7 +471,7 @@ xyzModem_stream_open (connection_info_t * info, int *err)
   xyz.initial_time = get_timer(0);
   xyz.timeout = xyzModem_get_initial_timeout();
 
-  CYGACC_COMM_IF_PUTC (*xyz.__chan, (xyz.crc_mode ? 'C' : NAK));
+  CYGACC_COMM_IF_PUTC (*xyz.__chan, xyzModem_start_char ());
 
   if (xyz.mode == xyzModem_xmodem)
     {
@@ -488,6 +501,13 @@ xyzModem_stream_open (connection_info_t * info, int *err)
 	      parse_num ((char *) xyz.bufp, &xyz.file_length, NULL, " ");
 	      /* The rest of the file name data block quietly discarded */
 	      xyz.tx_ack = true;
+	      if (xyz.stream)
+		{
+		  /* Ask for the data, which then comes without pauses */
+		  CYGACC_COMM_IF_PUTC (*xyz.__chan, ACK);
+		  CYGACC_COMM_IF_PUTC (*xyz.__chan, 'G');
+		  xyz.tx_ack = false;
+		}
 	    }
 	  xyz.next_blk = 1;
 	  xyz.len = 0;
@@ -495,10 +515,10 @@ xyzModem_stream_open (connection_info_t * info, int *err)
 	}
       else if (stat == xyzModem_timeout)
 	{
-	  if (--crc_retries <= 0)
+	  if (--crc_retries <= 0 && !xyz.stream)
 	    xyz.crc_mode = false;
 	  CYGACC_CALL_IF_DELAY_US (5 * 100000);	/* Extra delay for startup */
-	  CYGACC_COMM_IF_PUTC (*xyz.__chan, (xyz.crc_mode ? 'C' : NAK));
+	  CYGACC_COMM_IF_PUTC (*xyz.__chan, xyzModem_start_char ());
 	  xyz.total_retries++;
 	  ZM_DEBUG (zm_dprintf ("NAK (%d)\n", __LINE__));
 	}
@@ -543,7 +563,7 @@ xyzModem_stream_read (char *buf, int size, int *err)
 		    xyz.first_xmodem_packet = false;
 		  if (xyz.blk == xyz.next_blk)
 		    {
-		      xyz.tx_ack = true;
+		      xyz.tx_ack = !xyz.stream;
 		      ZM_DEBUG (zm_dprintf
 				("ACK block %d (%d)\n", xyz.blk, __LINE__));
 		      xyz.next_blk = (xyz.next_blk + 1) & 0xFF;
@@ -602,7 +622,7 @@ xyzModem_stream_read (char *buf, int size, int *err)
 		  if (xyz.mode == xyzModem_ymodem)
 		    {
 		      CYGACC_COMM_IF_PUTC (*xyz.__chan,
-					   (xyz.crc_mode ? 'C' : NAK));
+					   xyzModem_start_char ());
 		      xyz.total_retries++;
 		      ZM_DEBUG (zm_dprintf ("Reading Final Header\n"));
 		      stat = xyzModem_get_hdr ();
@@ -614,7 +634,10 @@ xyzModem_stream_read (char *buf, int size, int *err)
 		  xyz.at_eof = true;
 		  break;
 		}
-	      CYGACC_COMM_IF_PUTC (*xyz.__chan, (xyz.crc_mode ? 'C' : NAK));
+	      /* A streaming sender cannot go back, so give up */
+	      if (xyz.stream)
+		break;
+	      CYGACC_COMM_IF_PUTC (*xyz.__chan, xyzModem_start_char ());
 	      xyz.total_retries++;
 	      ZM_DEBUG (zm_dprintf ("NAK (%d)\n", __LINE__));
 	    }
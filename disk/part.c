@@ -26,6 +26,33 @@
 /* Check all partition types */
 #define PART_TYPE_ALL		-1
 
+/**
+ * struct part_cache_ent - result of reading one partition entry
+ *
+ * @valid: true if the entry has been read
+ * @ret: value returned by the driver's get_info() method
+ * @info: partition information, if @ret is 0
+ */
+struct part_cache_ent {
+	bool valid;
+	int ret;
+	struct disk_partition info;
+};
+
+/**
+ * struct part_cache - partition entries read from a device
+ *
+ * @part_type: Partition-table type the entries were read with
+ * @hwpart: Hardware partition the entries were read from
+ * @ents: Entries, indexed by partition number, up to the driver's
+ *	max_entries
+ */
+struct part_cache {
+	int part_type;
+	int hwpart;
+	struct part_cache_ent ents[];
+};
+
 /**
  * part_driver_get_type() - Get a driver given its type
  *
@@ -276,6 +303,84 @@ void dev_print(struct blk_desc *desc)
 	}
 }
 
+#if CONFIG_IS_ENABLED(PART_CACHE)
+void part_cache_invalidate(struct blk_desc *desc)
+{
+	free(desc->part_cache);
+	desc->part_cache = NULL;
+}
+
+/**
+ * part_cache_get() - Get the cache entry for a partition
+ *
+ * This drops the cache if it was filled for a different table type or
+ * hardware partition, and allocates it if needed.
+ *
+ * @desc: Block device descriptor
+ * @drv: Partition driver for the device
+ * @part: Partition number
+ * Return: cache entry, or NULL if the partition cannot be cached
+ */
+static struct part_cache_ent *part_cache_get(struct blk_desc *desc,
+					     struct part_driver *drv, int part)
+{
+	struct part_cache *cache = desc->part_cache;
+
+	if (part < 1 || part >= drv->max_entries)
+		return NULL;
+
+	if (cache && (cache->part_type != drv->part_type ||
+		      cache->hwpart != desc->hwpart)) {
+		part_cache_invalidate(desc);
+		cache = NULL;
+	}
+	if (!cache) {
+		cache = calloc(1, sizeof(*cache) +
+			       drv->max_entries * sizeof(cache->ents[0]));
+		if (!cache)
+			return NULL;
+		cache->part_type = drv->part_type;
+		cache->hwpart = desc->hwpart;
+		desc->part_cache = cache;
+	}
+
+	return &cache->ents[part];
+}
+#endif
+
+/**
+ * part_driver_get_info() - Read a partition entry, using the cache if enabled
+ *
+ * @desc: Block device descriptor
+ * @drv: Partition driver to use, which must have a get_info() method
+ * @part: Partition number
+ * @info: Returns the partition information
+ * Return: 0 if OK, other value if the partition cannot be read
+ */
+static int part_driver_get_info(struct blk_desc *desc, struct part_driver *drv,
+				int part, struct disk_partition *info)
+{
+#if CONFIG_IS_ENABLED(PART_CACHE)
+	struct part_cache_ent *ent = NULL;
+
+	/* only the table actually on the device is cached */
+	if (drv->part_type == desc->part_type)
+		ent = part_cache_get(desc, drv, part);
+	if (ent) {
+		if (!ent->valid) {
+			ent->ret = drv->get_info(desc, part, &ent->info);
+			ent->valid = true;
+		}
+		if (!ent->ret)
+			*info = ent->info;
+
+		return ent->ret;
+	}
+#endif
+
+	return drv->get_info(desc, part, info);
+}
+
 void part_init(struct blk_desc *desc)
 {
 	struct part_driver *drv =
@@ -284,6 +389,7 @@ void part_init(struct blk_desc *desc)
 	struct part_driver *entry;
 
 	blkcache_invalidate(desc->uclass_id, desc->devnum);
+	part_cache_invalidate(desc);
 
 	if (desc->part_type != PART_TYPE_UNKNOWN) {
 		for (entry = drv; entry != drv + n_ents; entry++) {
@@ -361,7 +467,7 @@ int part_get_info_by_type(struct blk_desc *desc, int part, int part_type,
 			       drv->name);
 			return -ENOSYS;
 		}
-		if (drv->get_info(desc, part, info) == 0) {
+		if (part_driver_get_info(desc, drv, part, info) == 0) {
 			PRINTF("## Valid %s partition found ##\n", drv->name);
 			return 0;
 		}
@@ -681,7 +787,7 @@ int part_get_info_by_name(struct blk_desc *desc, const char *name,
 	}
 
 	for (i = 1; i < part_drv->max_entries; i++) {
-		ret = part_drv->get_info(desc, i, info);
+		ret = part_driver_get_info(desc, part_drv, i, info);
 		if (ret != 0) {
 			/*
 			 * Partition with this index can't be obtained, but
@@ -52,6 +52,7 @@ static int ata_io_flush(struct ahci_uc_priv *uc_priv, u8 port);
 #define WAIT_MS_LINKUP	200
 
 #define AHCI_CAP_S64A BIT(31)
+#define AHCI_CAP_SNCQ BIT(30)
 
 __weak void __iomem *ahci_port_base(void __iomem *base, u32 port)
 {
@@ -384,11 +385,9 @@ static int ahci_init_one(struct ahci_uc_priv *uc_priv, struct udevice *dev)
 
 #define MAX_DATA_BYTE_COUNT  (4*1024*1024)
 
-static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port,
+static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, struct ahci_sg *ahci_sg,
 			unsigned char *buf, int buf_len)
 {
-	struct ahci_ioports *pp = &(uc_priv->port[port]);
-	struct ahci_sg *ahci_sg = pp->cmd_tbl_sg;
 	phys_addr_t pa = virt_to_phys(buf);
 	u32 sg_count;
 	int i;
@@ -418,15 +417,16 @@ static int ahci_fill_sg(struct ahci_uc_priv *uc_priv, u8 port,
 	return sg_count;
 }
 
-static void ahci_fill_cmd_slot(struct ahci_ioports *pp, u32 opts)
+static void ahci_fill_cmd_slot(struct ahci_cmd_hdr *cmd_slot, ulong cmd_tbl,
+			       u32 opts)
 {
-	phys_addr_t pa = virt_to_phys((void *)pp->cmd_tbl);
+	phys_addr_t pa = virt_to_phys((void *)cmd_tbl);
 
-	pp->cmd_slot->opts = cpu_to_le32(opts);
-	pp->cmd_slot->status = 0;
-	pp->cmd_slot->tbl_addr = cpu_to_le32(lower_32_bits(pa));
+	cmd_slot->opts = cpu_to_le32(opts);
+	cmd_slot->status = 0;
+	cmd_slot->tbl_addr = cpu_to_le32(lower_32_bits(pa));
 #ifdef CONFIG_PHYS_64BIT
-	pp->cmd_slot->tbl_addr_hi = cpu_to_le32(upper_32_bits(pa));
+	cmd_slot->tbl_addr_hi = cpu_to_le32(upper_32_bits(pa));
 #endif
 }
 
@@ -544,9 +544,9 @@ static int ahci_device_data_io(struct ahci_uc_priv *uc_priv, u8 port, u8 *fis,
 
 	memcpy((unsigned char *)pp->cmd_tbl, fis, fis_len);
 
-	sg_count = ahci_fill_sg(uc_priv, port, buf, buf_len);
+	sg_count = ahci_fill_sg(uc_priv, pp->cmd_tbl_sg, buf, buf_len);
 	opts = (fis_len >> 2) | (sg_count << 16) | (is_write << 6);
-	ahci_fill_cmd_slot(pp, opts);
+	ahci_fill_cmd_slot(pp->cmd_slot, pp->cmd_tbl, opts);
 
 	ahci_dcache_flush_sata_cmd(pp);
 	ahci_dcache_flush_range((unsigned long)buf, (unsigned long)buf_len);
@@ -635,6 +635,17 @@ static int ata_scsiop_inquiry(struct ahci_uc_priv *uc_priv,
 	memcpy(idbuf, tmpid, ATA_ID_WORDS * 2);
 	ata_swap_buf_le16(idbuf, ATA_ID_WORDS);
 
+#if IS_ENABLED(CONFIG_AHCI_NCQ)
+	/* Queue reads if both the drive and the controller can */
+	if (ata_id_has_ncq(idbuf) && (uc_priv->cap & AHCI_CAP_SNCQ)) {
+		int depth = min3(ata_id_queue_depth(idbuf),
+				 (int)((uc_priv->cap >> 8) & 0x1f) + 1,
+				 CONFIG_AHCI_NCQ_DEPTH);
+
+		uc_priv->port[port].ncq_depth = depth > 1 ? depth : 0;
+	}
+#endif
+
 	memcpy(&pccb->pdata[8], "ATA     ", 8);
 	ata_id_strcpy((u16 *)&pccb->pdata[16], &idbuf[ATA_ID_PROD], 16);
 	ata_id_strcpy((u16 *)&pccb->pdata[32], &idbuf[ATA_ID_FW_REV], 4);
@@ -645,6 +656,108 @@ static int ata_scsiop_inquiry(struct ahci_uc_priv *uc_priv,
 	return 0;
 }
 
+#if IS_ENABLED(CONFIG_AHCI_NCQ)
+/*
+ * Read using native command queuing (READ FPDMA QUEUED). Up to ncq_depth
+ * commands are issued together, each with its own command slot and command
+ * table from the port's pool, and all of them are reaped before the next
+ * batch is issued.
+ */
+static int ahci_ncq_read(struct ahci_uc_priv *uc_priv, u8 port, lbaint_t lba,
+			 u32 blocks, u8 *buf)
+{
+	struct ahci_ioports *pp = &uc_priv->port[port];
+	void __iomem *port_mmio = pp->port_mmio;
+	int tbl_size = CONFIG_AHCI_NCQ_DEPTH * AHCI_CMD_TBL_SZ;
+	const int fis_len = 20;
+
+	if (!pp->ncq_tbl) {
+		void *mem = memalign(128, tbl_size);
+
+		if (!mem)
+			return -ENOMEM;
+		memset(mem, '\0', tbl_size);
+		pp->ncq_tbl = virt_to_phys(mem);
+	}
+
+	while (blocks) {
+		u8 *batch = buf;
+		u32 mask = 0;
+		u32 status;
+		int tag;
+
+		for (tag = 0; tag < pp->ncq_depth && blocks; tag++) {
+			u32 now_blocks = min_t(u32, MAX_SATA_BLOCKS_READ_WRITE,
+					       blocks);
+			ulong tbl = pp->ncq_tbl + tag * AHCI_CMD_TBL_SZ;
+			u8 *fis = (u8 *)tbl;
+			int sg_count;
+
+			memset(fis, '\0', fis_len);
+			fis[0] = 0x27;		/* Host to device FIS. */
+			fis[1] = 1 << 7;	/* Command FIS. */
+			fis[2] = ATA_CMD_FPDMA_READ;
+			/* The block count goes in the features registers */
+			fis[3] = now_blocks & 0xff;
+			fis[11] = (now_blocks >> 8) & 0xff;
+			fis[4] = (lba >> 0) & 0xff;
+			fis[5] = (lba >> 8) & 0xff;
+			fis[6] = (lba >> 16) & 0xff;
+			fis[7] = 1 << 6; /* device reg: set LBA mode */
+			fis[8] = (lba >> 24) & 0xff;
+#ifdef CONFIG_SYS_64BIT_LBA
+			fis[9] = (lba >> 32) & 0xff;
+			fis[10] = (lba >> 40) & 0xff;
+#endif
+			/* ...and the tag goes in the count register */
+			fis[12] = tag << 3;
+
+			sg_count = ahci_fill_sg(uc_priv, (struct ahci_sg *)
+						(tbl + AHCI_CMD_TBL_HDR), buf,
+						now_blocks * ATA_SECT_SIZE);
+			if (sg_count < 0)
+				return -EIO;
+			ahci_fill_cmd_slot(pp->cmd_slot + tag, tbl,
+					   (fis_len >> 2) | (sg_count << 16));
+			mask |= BIT(tag);
+
+			buf += now_blocks * ATA_SECT_SIZE;
+			lba += now_blocks;
+			blocks -= now_blocks;
+		}
+
+		ahci_dcache_flush_sata_cmd(pp);
+		ahci_dcache_flush_range((ulong)pp->ncq_tbl, tbl_size);
+		ahci_dcache_flush_range((ulong)batch, buf - batch);
+
+		writel_with_flush(mask, port_mmio + PORT_SCR_ACT);
+		writel_with_flush(mask, port_mmio + PORT_CMD_ISSUE);
+
+		/* The drive clears each SActive bit as its command finishes */
+		if (waiting_for_cmd_completed(port_mmio + PORT_SCR_ACT,
+					      WAIT_MS_DATAIO, mask) ||
+		    waiting_for_cmd_completed(port_mmio + PORT_CMD_ISSUE,
+					      WAIT_MS_DATAIO, mask)) {
+			printf("timeout exit!\n");
+			return -EIO;
+		}
+		status = readl(port_mmio + PORT_IRQ_STAT);
+		if (status & PORT_IRQ_TF_ERR) {
+			/* Go back to one command at a time for this drive */
+			writel(status, port_mmio + PORT_IRQ_STAT);
+			pp->ncq_depth = 0;
+			printf("scsi_ahci: Queued read failed, status %x\n",
+			       status);
+			return -EIO;
+		}
+
+		ahci_dcache_invalidate_range((ulong)batch, buf - batch);
+	}
+
+	return 0;
+}
+#endif
+
 /*
  * SCSI READ10/WRITE10 command operation.
  */
@@ -686,6 +799,17 @@ static int ata_scsiop_read_write(struct ahci_uc_priv *uc_priv,
 	debug("scsi_ahci: %s %u blocks starting from lba 0x" LBAFU "\n",
 	      is_write ?  "write" : "read", blocks, lba);
 
+#if IS_ENABLED(CONFIG_AHCI_NCQ)
+	if (!is_write && uc_priv->port[pccb->target].ncq_depth) {
+		if (blocks * ATA_SECT_SIZE > user_buffer_size) {
+			printf("scsi_ahci: Error: buffer too small.\n");
+			return -EIO;
+		}
+		return ahci_ncq_read(uc_priv, pccb->target, lba, blocks,
+				     user_buffer);
+	}
+#endif
+
 	/* Preset the FIS */
 	memset(fis, 0, sizeof(fis));
 	fis[0] = 0x27;		 /* Host to device FIS. */
@@ -429,19 +429,13 @@ static int blk_buffer_aligned(struct bounce_buffer *state)
 	return 1;	/* Default, any buffer is OK */
 }
 
-long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
+static long blk_read_blocks(struct udevice *dev, lbaint_t start,
+			    lbaint_t blkcnt, void *buf)
 {
 	struct blk_desc *desc = dev_get_uclass_plat(dev);
 	const struct blk_ops *ops = blk_get_ops(dev);
 	ulong blks_read;
 
-	if (!ops->read)
-		return -ENOSYS;
-
-	if (blkcache_read(desc->uclass_id, desc->devnum,
-			  start, blkcnt, desc->blksz, buf))
-		return blkcnt;
-
 	if (IS_ENABLED(CONFIG_BOUNCE_BUFFER) && desc->bb) {
 		struct blk_bounce_buffer bbstate = { .dev = dev };
 		int ret;
@@ -460,6 +454,63 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 		blks_read = ops->read(dev, start, blkcnt, buf);
 	}
 
+	return blks_read;
+}
+
+/**
+ * blk_read_ahead() - read blocks through the read-ahead buffer
+ *
+ * @dev: Block device to read from
+ * @start: Start block for the read
+ * @blkcnt: Number of blocks to read
+ * @buf: Place to put the data
+ * Return: true if the blocks were read, false if the caller should read them
+ */
+static bool blk_read_ahead(struct udevice *dev, lbaint_t start,
+			   lbaint_t blkcnt, void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	lbaint_t count;
+	ulong blks_read;
+	void *ra_buf;
+
+	count = desc->lba > start ? desc->lba - start : 0;
+	ra_buf = blkcache_readahead_start(desc->uclass_id, desc->devnum, start,
+					  blkcnt, desc->blksz, &count);
+	if (!ra_buf)
+		return false;
+
+	blks_read = blk_read_blocks(dev, start, count, ra_buf);
+	if (blks_read != count) {
+		blkcache_readahead_done(desc->uclass_id, desc->devnum, start, 0,
+					desc->blksz);
+		return false;
+	}
+	blkcache_readahead_done(desc->uclass_id, desc->devnum, start, count,
+				desc->blksz);
+	memcpy(buf, ra_buf, blkcnt * desc->blksz);
+
+	return true;
+}
+
+long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blks_read;
+
+	if (!ops->read)
+		return -ENOSYS;
+
+	if (blkcache_read(desc->uclass_id, desc->devnum,
+			  start, blkcnt, desc->blksz, buf))
+		return blkcnt;
+
+	if (CONFIG_IS_ENABLED(BLOCK_READAHEAD) &&
+	    blk_read_ahead(dev, start, blkcnt, buf))
+		return blkcnt;
+
+	blks_read = blk_read_blocks(dev, start, blkcnt, buf);
 	if (blks_read == blkcnt)
 		blkcache_fill(desc->uclass_id, desc->devnum, start, blkcnt,
 			      desc->blksz, buf);
@@ -467,6 +518,70 @@ long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *buf)
 	return blks_read;
 }
 
+int blk_read_submit(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+		    void *buf, struct blk_req *req)
+{
+	struct blk_desc *desc = dev_get_uclass_plat(dev);
+	const struct blk_ops *ops = blk_get_ops(dev);
+	int ret;
+
+	memset(req, '\0', sizeof(*req));
+	req->dev = dev;
+	req->start = start;
+	req->blkcnt = blkcnt;
+	req->buffer = buf;
+
+	if (!ops->read)
+		return -ENOSYS;
+
+	/* Drivers only see buffers they can use directly */
+	if (IS_ENABLED(CONFIG_BLK_ASYNC) && ops->read_submit &&
+	    !(IS_ENABLED(CONFIG_BOUNCE_BUFFER) && desc->bb) &&
+	    !blkcache_read(desc->uclass_id, desc->devnum, start, blkcnt,
+			   desc->blksz, buf)) {
+		ret = ops->read_submit(dev, req);
+		if (ret != -ENOSYS)
+			return ret;
+	}
+
+	req->done = blk_read(dev, start, blkcnt, buf);
+	req->complete = true;
+
+	return 0;
+}
+
+int blk_req_poll(struct blk_req *req)
+{
+	struct blk_desc *desc;
+	int ret;
+
+	if (req->complete)
+		return 0;
+
+	ret = blk_get_ops(req->dev)->req_poll(req->dev, req);
+	if (ret)
+		return ret;
+
+	req->complete = true;
+	desc = dev_get_uclass_plat(req->dev);
+	if (req->done == req->blkcnt)
+		blkcache_fill(desc->uclass_id, desc->devnum, req->start,
+			      req->blkcnt, desc->blksz, req->buffer);
+
+	return 0;
+}
+
+long blk_req_wait(struct blk_req *req)
+{
+	int ret;
+
+	do {
+		ret = blk_req_poll(req);
+	} while (ret == -EBUSY);
+
+	return ret ? ret : req->done;
+}
+
 long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 	       const void *buf)
 {
@@ -478,6 +593,7 @@ long blk_write(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		return -ENOSYS;
 
 	blkcache_invalidate(desc->uclass_id, desc->devnum);
+	part_cache_invalidate(desc);
 
 	if (IS_ENABLED(CONFIG_BOUNCE_BUFFER) && desc->bb) {
 		struct blk_bounce_buffer bbstate = { .dev = dev };
@@ -510,6 +626,7 @@ long blk_erase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 		return -ENOSYS;
 
 	blkcache_invalidate(desc->uclass_id, desc->devnum);
+	part_cache_invalidate(desc);
 
 	return ops->erase(dev, start, blkcnt);
 }
@@ -852,9 +969,17 @@ static int blk_post_probe(struct udevice *dev)
 	return 0;
 }
 
+static int blk_pre_remove(struct udevice *dev)
+{
+	part_cache_invalidate(dev_get_uclass_plat(dev));
+
+	return 0;
+}
+
 UCLASS_DRIVER(blk) = {
 	.id		= UCLASS_BLK,
 	.name		= "blk",
 	.post_probe	= blk_post_probe,
+	.pre_remove	= blk_pre_remove,
 	.per_device_plat_auto	= sizeof(struct blk_desc),
 };
@@ -5,70 +5,243 @@
  *
  */
 #include <blk.h>
+#include <errno.h>
 #include <log.h>
 #include <malloc.h>
 #include <part.h>
+#include <asm/cache.h>
 #include <asm/global_data.h>
 #include <linux/ctype.h>
 #include <linux/list.h>
+#include <linux/log2.h>
 
-struct block_cache_node {
+/* Upper limit on the number of hash buckets per device */
+#define BLKCACHE_MAX_BUCKETS	4096
+#define BLKCACHE_MIN_BUCKETS	16
+
+/**
+ * struct block_cache_dev - per-device part of the block cache
+ *
+ * Entries are hashed by the window their start block falls in. A window is
+ * a power of two at least as large as the maximum entry size, so an entry can
+ * only overlap its own window and the next one. A lookup therefore only has
+ * to look at two buckets, whatever the size of the cache.
+ *
+ * @lh: link in the list of devices
+ * @iftype: uclass_id of the device
+ * @devnum: device number
+ * @buckets: hash buckets, NULL until the first fill
+ * @bucket_bits: log2 of the number of buckets
+ * @stats: hit/miss/eviction counters for this device
+ * @ra_buf: read-ahead buffer, NULL until sequential access is seen
+ * @ra_start: first block held in @ra_buf
+ * @ra_blkcnt: number of valid blocks in @ra_buf, 0 if none
+ * @ra_blksz: block size of the data in @ra_buf
+ * @ra_next: block following the last block read, to detect sequential access
+ */
+struct block_cache_dev {
 	struct list_head lh;
 	int iftype;
 	int devnum;
+	struct hlist_head *buckets;
+	uint bucket_bits;
+	struct block_cache_dev_stats stats;
+	void *ra_buf;
+	lbaint_t ra_start;
+	lbaint_t ra_blkcnt;
+	unsigned long ra_blksz;
+	lbaint_t ra_next;
+};
+
+struct block_cache_node {
+	struct list_head lh;
+	struct hlist_node hn;
+	struct block_cache_dev *bdev;
 	lbaint_t start;
 	lbaint_t blkcnt;
 	unsigned long blksz;
 	char *cache;
 };
 
+/* All entries, most recently used first */
 static LIST_HEAD(block_cache);
+static LIST_HEAD(block_cache_devs);
 
 static struct block_cache_stats _stats = {
 	.max_blocks_per_entry = 8,
 	.max_entries = 32
 };
 
-static struct block_cache_node *cache_find(int iftype, int devnum,
-					   lbaint_t start, lbaint_t blkcnt,
-					   unsigned long blksz)
+/* Number of calls to blkcache_invalidate(), see blkcache_generation() */
+static ulong generation;
+
+#if CONFIG_IS_ENABLED(BLOCK_READAHEAD)
+static ulong ra_size = CONFIG_BLOCK_READAHEAD_SIZE;
+#else
+static ulong ra_size;
+#endif
+
+/* log2 of the window size used for hashing, see struct block_cache_dev */
+static uint cache_window_shift(void)
+{
+	return order_base_2(max(_stats.max_blocks_per_entry, 1U));
+}
+
+static uint cache_hash(struct block_cache_dev *bdev, lbaint_t start)
+{
+	u64 window = (u64)start >> cache_window_shift();
+	u32 key = (u32)window ^ (u32)(window >> 32);
+
+	/* Fibonacci hashing, see Knuth vol 3, 6.4 */
+	return (key * 0x9e3779b9U) >> (32 - bdev->bucket_bits);
+}
+
+static struct block_cache_dev *cache_find_dev(int iftype, int devnum,
+					      bool create)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		if (bdev->iftype == iftype && bdev->devnum == devnum) {
+			/* keep busy devices at the front */
+			if (block_cache_devs.next != &bdev->lh)
+				list_move(&bdev->lh, &block_cache_devs);
+			return bdev;
+		}
+	}
+	if (!create)
+		return NULL;
+
+	bdev = calloc(1, sizeof(*bdev));
+	if (!bdev)
+		return NULL;
+	bdev->iftype = iftype;
+	bdev->devnum = devnum;
+	bdev->stats.iftype = iftype;
+	bdev->stats.devnum = devnum;
+	list_add(&bdev->lh, &block_cache_devs);
+
+	return bdev;
+}
+
+static int cache_alloc_buckets(struct block_cache_dev *bdev)
+{
+	uint count;
+
+	count = clamp(_stats.max_entries, (uint)BLKCACHE_MIN_BUCKETS,
+		      (uint)BLKCACHE_MAX_BUCKETS);
+	count = roundup_pow_of_two(count);
+	bdev->buckets = calloc(count, sizeof(struct hlist_head));
+	if (!bdev->buckets)
+		return -ENOMEM;
+	bdev->bucket_bits = ilog2(count);
+
+	return 0;
+}
+
+static struct block_cache_node *cache_find_bucket(struct block_cache_dev *bdev,
+						  uint bucket, lbaint_t start,
+						  lbaint_t blkcnt,
+						  unsigned long blksz)
 {
 	struct block_cache_node *node;
 
-	list_for_each_entry(node, &block_cache, lh)
-		if ((node->iftype == iftype) &&
-		    (node->devnum == devnum) &&
-		    (node->blksz == blksz) &&
+	hlist_for_each_entry(node, &bdev->buckets[bucket], hn)
+		if ((node->blksz == blksz) &&
 		    (node->start <= start) &&
-		    (node->start + node->blkcnt >= start + blkcnt)) {
-			if (block_cache.next != &node->lh) {
-				/* maintain MRU ordering */
-				list_del(&node->lh);
-				list_add(&node->lh, &block_cache);
-			}
+		    (node->start + node->blkcnt >= start + blkcnt))
 			return node;
-		}
-	return 0;
+
+	return NULL;
+}
+
+static struct block_cache_node *cache_find(struct block_cache_dev *bdev,
+					   lbaint_t start, lbaint_t blkcnt,
+					   unsigned long blksz)
+{
+	struct block_cache_node *node;
+	lbaint_t window_start;
+	uint shift;
+
+	/* nothing larger than an entry can be in the cache */
+	if (!bdev->buckets || blkcnt > _stats.max_blocks_per_entry)
+		return NULL;
+
+	node = cache_find_bucket(bdev, cache_hash(bdev, start), start, blkcnt,
+				 blksz);
+
+	/* an entry may start in the previous window and extend into this one */
+	shift = cache_window_shift();
+	window_start = start >> shift << shift;
+	if (!node && window_start)
+		node = cache_find_bucket(bdev, cache_hash(bdev,
+							  window_start - 1),
+					 start, blkcnt, blksz);
+	if (!node)
+		return NULL;
+
+	/* maintain MRU ordering */
+	if (block_cache.next != &node->lh)
+		list_move(&node->lh, &block_cache);
+
+	return node;
+}
+
+static bool cache_ra_find(struct block_cache_dev *bdev, lbaint_t start,
+			  lbaint_t blkcnt, unsigned long blksz, void *buffer)
+{
+	if (!bdev->ra_blkcnt || bdev->ra_blksz != blksz ||
+	    start < bdev->ra_start ||
+	    start + blkcnt > bdev->ra_start + bdev->ra_blkcnt)
+		return false;
+
+	memcpy(buffer, bdev->ra_buf + (start - bdev->ra_start) * blksz,
+	       blkcnt * blksz);
+	bdev->ra_next = start + blkcnt;
+
+	return true;
+}
+
+static void cache_drop(struct block_cache_node *node)
+{
+	list_del(&node->lh);
+	hlist_del(&node->hn);
+	node->bdev->stats.entries--;
+	_stats.entries--;
 }
 
 int blkcache_read(int iftype, int devnum,
 		  lbaint_t start, lbaint_t blkcnt,
 		  unsigned long blksz, void *buffer)
 {
-	struct block_cache_node *node = cache_find(iftype, devnum, start,
-						   blkcnt, blksz);
+	struct block_cache_node *node = NULL;
+	struct block_cache_dev *bdev;
+
+	bdev = cache_find_dev(iftype, devnum, false);
+	if (bdev)
+		node = cache_find(bdev, start, blkcnt, blksz);
+	if (!node && bdev && cache_ra_find(bdev, start, blkcnt, blksz, buffer)) {
+		debug("ra hit: start " LBAF ", count " LBAFU "\n",
+		      start, blkcnt);
+		++_stats.hits;
+		++bdev->stats.hits;
+		return 1;
+	}
 	if (node) {
 		const char *src = node->cache + (start - node->start) * blksz;
 		memcpy(buffer, src, blksz * blkcnt);
 		debug("hit: start " LBAF ", count " LBAFU "\n",
 		      start, blkcnt);
 		++_stats.hits;
+		++bdev->stats.hits;
 		return 1;
 	}
 
 	debug("miss: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 	++_stats.misses;
+	if (bdev)
+		++bdev->stats.misses;
 	return 0;
 }
 
@@ -76,8 +249,9 @@ void blkcache_fill(int iftype, int devnum,
 		   lbaint_t start, lbaint_t blkcnt,
 		   unsigned long blksz, void const *buffer)
 {
-	lbaint_t bytes;
+	struct block_cache_dev *bdev;
 	struct block_cache_node *node;
+	lbaint_t bytes;
 
 	/* don't cache big stuff */
 	if (blkcnt > _stats.max_blocks_per_entry)
@@ -86,12 +260,20 @@ void blkcache_fill(int iftype, int devnum,
 	if (_stats.max_entries == 0)
 		return;
 
+	bdev = cache_find_dev(iftype, devnum, true);
+	if (!bdev)
+		return;
+	if (!bdev->buckets && cache_alloc_buckets(bdev))
+		return;
+
 	bytes = blksz * blkcnt;
 	if (_stats.max_entries <= _stats.entries) {
 		/* pop LRU */
-		node = (struct block_cache_node *)block_cache.prev;
-		list_del(&node->lh);
-		_stats.entries--;
+		node = list_last_entry(&block_cache, struct block_cache_node,
+				       lh);
+		node->bdev->stats.evictions++;
+		_stats.evictions++;
+		cache_drop(node);
 		debug("drop: start " LBAF ", count " LBAFU "\n",
 		      node->start, node->blkcnt);
 		if (node->blkcnt * node->blksz < bytes) {
@@ -116,30 +298,113 @@ void blkcache_fill(int iftype, int devnum,
 	debug("fill: start " LBAF ", count " LBAFU "\n",
 	      start, blkcnt);
 
-	node->iftype = iftype;
-	node->devnum = devnum;
+	node->bdev = bdev;
 	node->start = start;
 	node->blkcnt = blkcnt;
 	node->blksz = blksz;
 	memcpy(node->cache, buffer, bytes);
 	list_add(&node->lh, &block_cache);
+	hlist_add_head(&node->hn, &bdev->buckets[cache_hash(bdev, start)]);
+	bdev->stats.entries++;
 	_stats.entries++;
 }
 
+void *blkcache_readahead_start(int iftype, int devnum, lbaint_t start,
+			       lbaint_t blkcnt, unsigned long blksz,
+			       lbaint_t *countp)
+{
+	struct block_cache_dev *bdev;
+	lbaint_t window, next;
+
+	window = ra_size / blksz;
+	if (!window)
+		return NULL;
+
+	bdev = cache_find_dev(iftype, devnum, true);
+	if (!bdev)
+		return NULL;
+	next = bdev->ra_next;
+	bdev->ra_next = start + blkcnt;
+
+	/* only read ahead for small reads which follow on from the last one */
+	if (start != next || blkcnt >= window || *countp <= blkcnt)
+		return NULL;
+
+	if (!bdev->ra_buf) {
+		bdev->ra_buf = memalign(ARCH_DMA_MINALIGN, ra_size);
+		if (!bdev->ra_buf)
+			return NULL;
+	}
+	bdev->ra_blkcnt = 0;
+	*countp = min(*countp, window);
+	debug("ra: start " LBAF ", count " LBAFU "\n", start, *countp);
+
+	return bdev->ra_buf;
+}
+
+void blkcache_readahead_done(int iftype, int devnum, lbaint_t start,
+			     lbaint_t blkcnt, unsigned long blksz)
+{
+	struct block_cache_dev *bdev;
+
+	bdev = cache_find_dev(iftype, devnum, false);
+	if (!bdev)
+		return;
+	bdev->ra_start = start;
+	bdev->ra_blkcnt = blkcnt;
+	bdev->ra_blksz = blksz;
+}
+
 void blkcache_invalidate(int iftype, int devnum)
 {
-	struct list_head *entry, *n;
-	struct block_cache_node *node;
+	struct block_cache_node *node, *n;
+	struct block_cache_dev *bdev;
+	struct hlist_node *tmp;
+	uint i;
 
-	list_for_each_safe(entry, n, &block_cache) {
-		node = (struct block_cache_node *)entry;
-		if (iftype == -1 ||
-		    (node->iftype == iftype && node->devnum == devnum)) {
-			list_del(entry);
+	++generation;
+
+	if (iftype == -1) {
+		list_for_each_entry_safe(node, n, &block_cache, lh) {
+			cache_drop(node);
 			free(node->cache);
 			free(node);
-			--_stats.entries;
 		}
+		list_for_each_entry(bdev, &block_cache_devs, lh)
+			bdev->ra_blkcnt = 0;
+		return;
+	}
+
+	bdev = cache_find_dev(iftype, devnum, false);
+	if (!bdev)
+		return;
+	bdev->ra_blkcnt = 0;
+	if (!bdev->stats.entries)
+		return;
+
+	for (i = 0; i < 1U << bdev->bucket_bits; i++) {
+		hlist_for_each_entry_safe(node, tmp, &bdev->buckets[i], hn) {
+			cache_drop(node);
+			free(node->cache);
+			free(node);
+		}
+	}
+}
+
+ulong blkcache_generation(void)
+{
+	return generation;
+}
+
+static void blkcache_free_devs(void)
+{
+	struct block_cache_dev *bdev, *n;
+
+	list_for_each_entry_safe(bdev, n, &block_cache_devs, lh) {
+		list_del(&bdev->lh);
+		free(bdev->buckets);
+		free(bdev->ra_buf);
+		free(bdev);
 	}
 }
 
@@ -147,24 +412,72 @@ void blkcache_configure(unsigned blocks, unsigned entries)
 {
 	/* invalidate cache if there is a change */
 	if ((blocks != _stats.max_blocks_per_entry) ||
-	    (entries != _stats.max_entries))
+	    (entries != _stats.max_entries)) {
 		blkcache_invalidate(-1, 0);
+		/* the hash tables are sized from the old settings */
+		blkcache_free_devs();
+	}
 
 	_stats.max_blocks_per_entry = blocks;
 	_stats.max_entries = entries;
 
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
 }
 
 void blkcache_stats(struct block_cache_stats *stats)
 {
+	struct block_cache_dev *bdev;
+
 	memcpy(stats, &_stats, sizeof(*stats));
 	_stats.hits = 0;
 	_stats.misses = 0;
+	_stats.evictions = 0;
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		bdev->stats.hits = 0;
+		bdev->stats.misses = 0;
+		bdev->stats.evictions = 0;
+	}
+}
+
+void blkcache_readahead_configure(ulong size)
+{
+	struct block_cache_dev *bdev;
+
+	if (size == ra_size)
+		return;
+
+	/* buffers are allocated at the old size */
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		free(bdev->ra_buf);
+		bdev->ra_buf = NULL;
+		bdev->ra_blkcnt = 0;
+	}
+	ra_size = size;
+}
+
+ulong blkcache_readahead_size(void)
+{
+	return ra_size;
+}
+
+int blkcache_dev_stats(int seq, struct block_cache_dev_stats *stats)
+{
+	struct block_cache_dev *bdev;
+
+	list_for_each_entry(bdev, &block_cache_devs, lh) {
+		if (!seq--) {
+			memcpy(stats, &bdev->stats, sizeof(*stats));
+			return 0;
+		}
+	}
+
+	return -ENOENT;
 }
 
 void blkcache_free(void)
 {
 	blkcache_invalidate(-1, 0);
+	blkcache_free_devs();
 }
@@ -185,6 +185,10 @@ int blkmap_map_linear(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 	return err;
 }
 
+/* Copy-on-write mappings keep private copies in chunks of this many blocks */
+#define BLKMAP_COW_SHIFT	6
+#define BLKMAP_COW_BLKS		(1 << BLKMAP_COW_SHIFT)
+
 /**
  * struct blkmap_mem - Memory mapping
  *
@@ -193,11 +197,15 @@ int blkmap_map_linear(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
  * @remapped: True if @addr is backed by a physical to virtual memory
  * mapping that must be torn down at the end of this mapping's
  * lifetime.
+ * @overlay: For a copy-on-write mapping, the private copy of each chunk
+ * of BLKMAP_COW_BLKS blocks, or NULL where the chunk has not been written.
+ * NULL for a plain mapping, which writes to @addr directly.
  */
 struct blkmap_mem {
 	struct blkmap_slice slice;
 	void *addr;
 	bool remapped;
+	void **overlay;
 };
 
 static ulong blkmap_mem_read(struct blkmap *bm, struct blkmap_slice *bms,
@@ -225,16 +233,92 @@ static ulong blkmap_mem_write(struct blkmap *bm, struct blkmap_slice *bms,
 	return blkcnt;
 }
 
+static ulong blkmap_cow_read(struct blkmap *bm, struct blkmap_slice *bms,
+			     lbaint_t blknr, lbaint_t blkcnt, void *buffer)
+{
+	struct blkmap_mem *bmm = container_of(bms, struct blkmap_mem, slice);
+	struct blk_desc *bd = dev_get_uclass_plat(bm->blk);
+	lbaint_t todo = blkcnt;
+
+	while (todo) {
+		lbaint_t chunk = blknr >> BLKMAP_COW_SHIFT;
+		lbaint_t cnt, first = blknr & (BLKMAP_COW_BLKS - 1);
+		char *src;
+
+		cnt = min_t(lbaint_t, todo, BLKMAP_COW_BLKS - first);
+		if (bmm->overlay[chunk])
+			src = bmm->overlay[chunk] + (first << bd->log2blksz);
+		else
+			src = bmm->addr + (blknr << bd->log2blksz);
+		memcpy(buffer, src, cnt << bd->log2blksz);
+
+		blknr += cnt;
+		todo -= cnt;
+		buffer += cnt << bd->log2blksz;
+	}
+
+	return blkcnt;
+}
+
+static ulong blkmap_cow_write(struct blkmap *bm, struct blkmap_slice *bms,
+			      lbaint_t blknr, lbaint_t blkcnt,
+			      const void *buffer)
+{
+	struct blkmap_mem *bmm = container_of(bms, struct blkmap_mem, slice);
+	struct blk_desc *bd = dev_get_uclass_plat(bm->blk);
+	lbaint_t done = 0;
+
+	while (done < blkcnt) {
+		lbaint_t chunk = blknr >> BLKMAP_COW_SHIFT;
+		lbaint_t cnt, first = blknr & (BLKMAP_COW_BLKS - 1);
+
+		if (!bmm->overlay[chunk]) {
+			lbaint_t start = chunk << BLKMAP_COW_SHIFT;
+			lbaint_t len;
+
+			/* The last chunk may be cut short by the slice end */
+			len = min_t(lbaint_t, BLKMAP_COW_BLKS,
+				    bms->blkcnt - start);
+			bmm->overlay[chunk] = malloc(BLKMAP_COW_BLKS <<
+						     bd->log2blksz);
+			if (!bmm->overlay[chunk])
+				break;
+			memcpy(bmm->overlay[chunk],
+			       bmm->addr + (start << bd->log2blksz),
+			       len << bd->log2blksz);
+		}
+
+		cnt = min_t(lbaint_t, blkcnt - done, BLKMAP_COW_BLKS - first);
+		memcpy(bmm->overlay[chunk] + (first << bd->log2blksz), buffer,
+		       cnt << bd->log2blksz);
+
+		blknr += cnt;
+		done += cnt;
+		buffer += cnt << bd->log2blksz;
+	}
+
+	return done;
+}
+
 static void blkmap_mem_destroy(struct blkmap *bm, struct blkmap_slice *bms)
 {
 	struct blkmap_mem *bmm = container_of(bms, struct blkmap_mem, slice);
 
+	if (bmm->overlay) {
+		lbaint_t i, chunks;
+
+		chunks = (bms->blkcnt + BLKMAP_COW_BLKS - 1) >> BLKMAP_COW_SHIFT;
+		for (i = 0; i < chunks; i++)
+			free(bmm->overlay[i]);
+		free(bmm->overlay);
+	}
+
 	if (bmm->remapped)
 		unmap_sysmem(bmm->addr);
 }
 
 int __blkmap_map_mem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
-		     void *addr, bool remapped)
+		     void *addr, bool remapped, bool cow)
 {
 	struct blkmap *bm = dev_get_plat(dev);
 	struct blkmap_mem *bmm;
@@ -258,9 +342,22 @@ int __blkmap_map_mem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		.remapped = remapped,
 	};
 
+	if (cow) {
+		bmm->overlay = calloc((blkcnt + BLKMAP_COW_BLKS - 1) >>
+				      BLKMAP_COW_SHIFT, sizeof(void *));
+		if (!bmm->overlay) {
+			free(bmm);
+			return -ENOMEM;
+		}
+		bmm->slice.read = blkmap_cow_read;
+		bmm->slice.write = blkmap_cow_write;
+	}
+
 	err = blkmap_slice_add(bm, &bmm->slice);
-	if (err)
+	if (err) {
+		free(bmm->overlay);
 		free(bmm);
+	}
 
 	return err;
 }
@@ -268,11 +365,11 @@ int __blkmap_map_mem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 int blkmap_map_mem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		   void *addr)
 {
-	return __blkmap_map_mem(dev, blknr, blkcnt, addr, false);
+	return __blkmap_map_mem(dev, blknr, blkcnt, addr, false, false);
 }
 
-int blkmap_map_pmem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
-		    phys_addr_t paddr)
+static int blkmap_map_pmem_common(struct udevice *dev, lbaint_t blknr,
+				  lbaint_t blkcnt, phys_addr_t paddr, bool cow)
 {
 	struct blkmap *bm = dev_get_plat(dev);
 	struct blk_desc *bd = dev_get_uclass_plat(bm->blk);
@@ -283,13 +380,25 @@ int blkmap_map_pmem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 	if (!addr)
 		return -ENOMEM;
 
-	err = __blkmap_map_mem(dev, blknr, blkcnt, addr, true);
+	err = __blkmap_map_mem(dev, blknr, blkcnt, addr, true, cow);
 	if (err)
 		unmap_sysmem(addr);
 
 	return err;
 }
 
+int blkmap_map_pmem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
+		    phys_addr_t paddr)
+{
+	return blkmap_map_pmem_common(dev, blknr, blkcnt, paddr, false);
+}
+
+int blkmap_map_pmem_cow(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
+			phys_addr_t paddr)
+{
+	return blkmap_map_pmem_common(dev, blknr, blkcnt, paddr, true);
+}
+
 static ulong blkmap_blk_read_slice(struct blkmap *bm, struct blkmap_slice *bms,
 				   lbaint_t blknr, lbaint_t blkcnt,
 				   void *buffer)
@@ -402,6 +511,8 @@ static int blkmap_dev_unbind(struct udevice *dev)
 
 	list_for_each_entry_safe(bms, tmp, &bm->slices, node) {
 		list_del(&bms->node);
+		if (bms->destroy)
+			bms->destroy(bm, bms);
 		free(bms);
 	}
 
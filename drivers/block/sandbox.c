@@ -14,9 +14,20 @@
 #include <dm/device_compat.h>
 #include <dm/device-internal.h>
 #include <linux/errno.h>
+#include <linux/kernel.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
+/* Limit a request to the end of the file, as read() and write() would */
+static lbaint_t host_block_count(struct blk_desc *desc, unsigned long start,
+				 lbaint_t blkcnt)
+{
+	if (start >= desc->lba)
+		return 0;
+
+	return min_t(lbaint_t, blkcnt, desc->lba - start);
+}
+
 static unsigned long host_block_read(struct udevice *dev,
 				     unsigned long start, lbaint_t blkcnt,
 				     void *buffer)
@@ -25,6 +36,13 @@ static unsigned long host_block_read(struct udevice *dev,
 	struct udevice *host_dev = dev_get_parent(dev);
 	struct host_sb_plat *plat = dev_get_plat(host_dev);
 
+	if (plat->map) {
+		blkcnt = host_block_count(desc, start, blkcnt);
+		memcpy(buffer, plat->map + start * desc->blksz,
+		       blkcnt * desc->blksz);
+		return blkcnt;
+	}
+
 	if (os_lseek(plat->fd, start * desc->blksz, OS_SEEK_SET) < 0) {
 		printf("ERROR: Invalid block %lx\n", start);
 		return -1;
@@ -44,6 +62,13 @@ static unsigned long host_block_write(struct udevice *dev,
 	struct udevice *host_dev = dev_get_parent(dev);
 	struct host_sb_plat *plat = dev_get_plat(host_dev);
 
+	if (plat->map && plat->map_rw) {
+		blkcnt = host_block_count(desc, start, blkcnt);
+		memcpy(plat->map + start * desc->blksz, buffer,
+		       blkcnt * desc->blksz);
+		return blkcnt;
+	}
+
 	if (os_lseek(plat->fd, start * desc->blksz, OS_SEEK_SET) < 0) {
 		printf("ERROR: Invalid block %lx\n", start);
 		return -1;
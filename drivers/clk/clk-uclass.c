@@ -34,6 +34,68 @@ struct clk *dev_get_clk_ptr(struct udevice *dev)
 	return (struct clk *)dev_get_uclass_priv(dev);
 }
 
+/**
+ * struct clk_rate_ent - a clock rate read from a provider
+ *
+ * @dev: Clock provider, or NULL if the entry is empty
+ * @id: Clock ID within the provider
+ * @data: Clock data within the provider
+ * @rate: Rate returned by the provider's get_rate() method
+ */
+struct clk_rate_ent {
+	struct udevice *dev;
+	ulong id;
+	ulong data;
+	ulong rate;
+};
+
+#if CONFIG_IS_ENABLED(CLK_RATE_CACHE)
+#define CLK_RATE_CACHE_SIZE	32
+
+/**
+ * struct clk_uc_priv - uclass-private data for clocks
+ *
+ * @rate_cache: Rates read from providers, indexed by a hash of the clock
+ */
+struct clk_uc_priv {
+	struct clk_rate_ent rate_cache[CLK_RATE_CACHE_SIZE];
+};
+
+static struct clk_rate_ent *clk_rate_cache_ent(struct clk *clk)
+{
+	struct clk_uc_priv *uc_priv = uclass_get_priv(clk->dev->uclass);
+	struct clk *clkp = dev_get_clk_ptr(clk->dev);
+	uint hash;
+
+	if (!uc_priv || (clkp && clkp->flags & CLK_GET_RATE_NOCACHE))
+		return NULL;
+	hash = (ulong)clk->dev / sizeof(long) + clk->id * 31 + clk->data;
+
+	return &uc_priv->rate_cache[hash % CLK_RATE_CACHE_SIZE];
+}
+
+/*
+ * Changing one rate can change any other in the clock tree, including those
+ * of other providers, so forget them all
+ */
+static void clk_rate_cache_flush(struct udevice *dev)
+{
+	struct clk_uc_priv *uc_priv = uclass_get_priv(dev->uclass);
+
+	if (uc_priv)
+		memset(uc_priv->rate_cache, '\0', sizeof(uc_priv->rate_cache));
+}
+#else
+static struct clk_rate_ent *clk_rate_cache_ent(struct clk *clk)
+{
+	return NULL;
+}
+
+static void clk_rate_cache_flush(struct udevice *dev)
+{
+}
+#endif
+
 #if CONFIG_IS_ENABLED(OF_PLATDATA)
 int clk_get_by_phandle(struct udevice *dev, const struct phandle_1_arg *cells,
 		       struct clk *clk)
@@ -351,6 +413,14 @@ static int clk_set_default_rates(struct udevice *dev,
 		if (IS_ERR(c))
 			return PTR_ERR(c);
 
+		/*
+		 * Several devices often assign the same rate to a shared clock,
+		 * so skip it if it is already set, as Linux does
+		 */
+		if (CONFIG_IS_ENABLED(CLK_RATE_CACHE) &&
+		    clk_get_rate(c) == rates[index])
+			continue;
+
 		ret = clk_set_rate(c, rates[index]);
 
 		if (ret < 0) {
@@ -460,6 +530,8 @@ int clk_request(struct udevice *dev, struct clk *clk)
 ulong clk_get_rate(struct clk *clk)
 {
 	const struct clk_ops *ops;
+	struct clk_rate_ent *ent;
+	ulong rate;
 
 	debug("%s(clk=%p)\n", __func__, clk);
 	if (!clk_valid(clk))
@@ -469,7 +541,20 @@ ulong clk_get_rate(struct clk *clk)
 	if (!ops->get_rate)
 		return -ENOSYS;
 
-	return ops->get_rate(clk);
+	ent = clk_rate_cache_ent(clk);
+	if (ent && ent->dev == clk->dev && ent->id == clk->id &&
+	    ent->data == clk->data)
+		return ent->rate;
+
+	rate = ops->get_rate(clk);
+	if (ent && rate && !IS_ERR_VALUE(rate)) {
+		ent->dev = clk->dev;
+		ent->id = clk->id;
+		ent->data = clk->data;
+		ent->rate = rate;
+	}
+
+	return rate;
 }
 
 struct clk *clk_get_parent(struct clk *clk)
@@ -563,6 +648,7 @@ ulong clk_set_rate(struct clk *clk, ulong rate)
 {
 	const struct clk_ops *ops;
 	struct clk *clkp;
+	ulong ret;
 
 	debug("%s(clk=%p, rate=%lu)\n", __func__, clk, rate);
 	if (!clk_valid(clk))
@@ -577,7 +663,10 @@ ulong clk_set_rate(struct clk *clk, ulong rate)
 	/* Clean up cached rates for us and all child clocks */
 	clk_clean_rate_cache(clkp);
 
-	return ops->set_rate(clk, rate);
+	ret = ops->set_rate(clk, rate);
+	clk_rate_cache_flush(clk->dev);
+
+	return ret;
 }
 
 int clk_set_parent(struct clk *clk, struct clk *parent)
@@ -594,6 +683,7 @@ int clk_set_parent(struct clk *clk, struct clk *parent)
 		return -ENOSYS;
 
 	ret = ops->set_parent(clk, parent);
+	clk_rate_cache_flush(clk->dev);
 	if (ret)
 		return ret;
 
@@ -797,8 +887,20 @@ int clk_uclass_post_probe(struct udevice *dev)
 	return 0;
 }
 
+static int clk_uclass_pre_remove(struct udevice *dev)
+{
+	/* A new provider may later be allocated at the same address */
+	clk_rate_cache_flush(dev);
+
+	return 0;
+}
+
 UCLASS_DRIVER(clk) = {
 	.id		= UCLASS_CLK,
 	.name		= "clk",
 	.post_probe	= clk_uclass_post_probe,
+	.pre_remove	= clk_uclass_pre_remove,
+#if CONFIG_IS_ENABLED(CLK_RATE_CACHE)
+	.priv_auto	= sizeof(struct clk_uc_priv),
+#endif
 };
@@ -1978,6 +1978,17 @@ static int rk3588_clk_probe(struct udevice *dev)
 					      priv->cru, LPLL);
 		priv->armclk_init_hz = priv->armclk_enter_hz;
 	}
+#else
+	/*
+	 * SPL normally leaves the PLLs at the rates rk3588_clk_init() wants,
+	 * so pick up what is running to avoid re-locking them
+	 */
+	priv->cpll_hz = rockchip_pll_get_rate(&rk3588_pll_clks[CPLL],
+					      priv->cru, CPLL);
+	priv->gpll_hz = rockchip_pll_get_rate(&rk3588_pll_clks[GPLL],
+					      priv->cru, GPLL);
+	priv->ppll_hz = rockchip_pll_get_rate(&rk3588_pll_clks[PPLL],
+					      priv->cru, PPLL);
 #endif
 
 	priv->grf = syscon_get_first_range(ROCKCHIP_SYSCON_GRF);
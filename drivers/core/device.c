@@ -8,9 +8,11 @@
  * Pavel Herrmann <morpheus.ibis@gmail.com>
  */
 
+#include <bootstage.h>
 #include <cpu_func.h>
 #include <errno.h>
 #include <event.h>
+#include <event_stats.h>
 #include <log.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
@@ -26,6 +28,7 @@
 #include <dm/pinctrl.h>
 #include <dm/platdata.h>
 #include <dm/read.h>
+#include <dm/root.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -37,16 +40,89 @@
 
 DECLARE_GLOBAL_DATA_PTR;
 
+#if CONFIG_IS_ENABLED(DM_ARENA) && !CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
+/* Chunk of memory which is handed out by dm_alloc(), and how much is left */
+static void *dm_arena;
+static size_t dm_arena_left;
+#endif
+
+/**
+ * dm_alloc() - Allocate zeroed memory for driver model
+ *
+ * When devices are never removed, nothing this allocates is freed, so once
+ * malloc() is fully set up it is carved from larger chunks. This saves the
+ * heap overhead of many small blocks. Before that, malloc_simple() is used,
+ * which carves memory in the same way.
+ *
+ * @size: Number of bytes to allocate
+ * Return: pointer to memory, or NULL if out of memory
+ */
+static void *dm_alloc(size_t size)
+{
+#if CONFIG_IS_ENABLED(DM_ARENA) && !CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
+	void *ptr;
+
+	size = ALIGN(size, DM_ALLOC_ALIGN);
+	if ((gd->flags & GD_FLG_FULL_MALLOC_INIT) &&
+	    size <= CONFIG_DM_ARENA_CHUNK / 4) {
+		if (size > dm_arena_left) {
+			dm_arena = calloc(1, CONFIG_DM_ARENA_CHUNK);
+			if (!dm_arena) {
+				dm_arena_left = 0;
+				return NULL;
+			}
+			dm_arena_left = CONFIG_DM_ARENA_CHUNK;
+		}
+		ptr = dm_arena;
+		dm_arena += size;
+		dm_arena_left -= size;
+
+		return ptr;
+	}
+#endif
+
+	return calloc(1, size);
+}
+
+/**
+ * device_alloc_plat() - Allocate plat data for a device being bound
+ *
+ * With DM_ARENA this takes the space reserved for it after the device.
+ * Otherwise the data is allocated and @flag is set on the device, so that the
+ * data is freed when the device is unbound.
+ *
+ * @dev: Device being bound
+ * @nextp: Next free space after the device, updated by this function
+ * @size: Size of the data
+ * @flag: DM_FLAG_ALLOC_... flag for the data
+ * Return: pointer to the data, or NULL if out of memory
+ */
+static void *device_alloc_plat(struct udevice *dev, void **nextp, int size,
+			       uint flag)
+{
+	void *ptr;
+
+	if (CONFIG_IS_ENABLED(DM_ARENA)) {
+		ptr = *nextp;
+		*nextp += ALIGN(size, DM_ALLOC_ALIGN);
+		return ptr;
+	}
+	dev_or_flags(dev, flag);
+
+	return calloc(1, size);
+}
+
 static int device_bind_common(struct udevice *parent, const struct driver *drv,
 			      const char *name, void *plat,
 			      ulong driver_data, ofnode node,
 			      uint of_plat_size, struct udevice **devp)
 {
+	int plat_size, uc_plat_size, parent_plat_size = 0;
 	struct udevice *dev;
 	struct uclass *uc;
 	int size, ret = 0;
 	bool auto_seq = true;
-	void *ptr;
+	void *ptr, *next;
 
 	if (CONFIG_IS_ENABLED(OF_PLATDATA_NO_BIND))
 		return -ENOSYS;
@@ -56,15 +132,39 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	if (!name)
 		return -EINVAL;
 
-	ret = uclass_get(drv->id, &uc);
+	ret = uclass_get_no_lazy(drv->id, &uc);
 	if (ret) {
 		dm_warn("Missing uclass for driver %s\n", drv->name);
 		return ret;
 	}
 
-	dev = calloc(1, sizeof(struct udevice));
+	/*
+	 * Work out the plat data to allocate. For of-platdata, we try to use
+	 * the existing data, but if plat_auto is larger, we must allocate a
+	 * new space.
+	 */
+	plat_size = drv->plat_auto;
+	if (plat && !(CONFIG_IS_ENABLED(OF_PLATDATA) &&
+		      of_plat_size < plat_size))
+		plat_size = 0;
+	uc_plat_size = uc->uc_drv->per_device_plat_auto;
+	if (parent) {
+		parent_plat_size = parent->driver->per_child_plat_auto;
+		if (!parent_plat_size)
+			parent_plat_size =
+				parent->uclass->uc_drv->per_child_plat_auto;
+	}
+
+	size = sizeof(struct udevice);
+	if (CONFIG_IS_ENABLED(DM_ARENA))
+		size = ALIGN(size, DM_ALLOC_ALIGN) +
+			ALIGN(plat_size, DM_ALLOC_ALIGN) +
+			ALIGN(uc_plat_size, DM_ALLOC_ALIGN) +
+			parent_plat_size;
+	dev = dm_alloc(size);
 	if (!dev)
 		return -ENOMEM;
+	next = (void *)dev + ALIGN(sizeof(struct udevice), DM_ALLOC_ALIGN);
 
 	INIT_LIST_HEAD(&dev->sibling_node);
 	INIT_LIST_HEAD(&dev->child_head);
@@ -100,42 +200,25 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	if (auto_seq && !(uc->uc_drv->flags & DM_UC_FLAG_NO_AUTO_SEQ))
 		dev->seq_ = uclass_find_next_free_seq(uc);
 
-	/* Check if we need to allocate plat */
-	if (drv->plat_auto) {
-		bool alloc = !plat;
-
-		/*
-		 * For of-platdata, we try use the existing data, but if
-		 * plat_auto is larger, we must allocate a new space
-		 */
-		if (CONFIG_IS_ENABLED(OF_PLATDATA)) {
-			if (of_plat_size)
-				dev_or_flags(dev, DM_FLAG_OF_PLATDATA);
-			if (of_plat_size < drv->plat_auto)
-				alloc = true;
+	if (CONFIG_IS_ENABLED(OF_PLATDATA) && drv->plat_auto && of_plat_size)
+		dev_or_flags(dev, DM_FLAG_OF_PLATDATA);
+	if (plat_size) {
+		ptr = device_alloc_plat(dev, &next, plat_size,
+					DM_FLAG_ALLOC_PDATA);
+		if (!ptr) {
+			ret = -ENOMEM;
+			goto fail_alloc1;
 		}
-		if (alloc) {
-			dev_or_flags(dev, DM_FLAG_ALLOC_PDATA);
-			ptr = calloc(1, drv->plat_auto);
-			if (!ptr) {
-				ret = -ENOMEM;
-				goto fail_alloc1;
-			}
 
-			/*
-			 * For of-platdata, copy the old plat into the new
-			 * space
-			 */
-			if (CONFIG_IS_ENABLED(OF_PLATDATA) && plat)
-				memcpy(ptr, plat, of_plat_size);
-			dev_set_plat(dev, ptr);
-		}
+		/* For of-platdata, copy the old plat into the new space */
+		if (CONFIG_IS_ENABLED(OF_PLATDATA) && plat)
+			memcpy(ptr, plat, of_plat_size);
+		dev_set_plat(dev, ptr);
 	}
 
-	size = uc->uc_drv->per_device_plat_auto;
-	if (size) {
-		dev_or_flags(dev, DM_FLAG_ALLOC_UCLASS_PDATA);
-		ptr = calloc(1, size);
+	if (uc_plat_size) {
+		ptr = device_alloc_plat(dev, &next, uc_plat_size,
+					DM_FLAG_ALLOC_UCLASS_PDATA);
 		if (!ptr) {
 			ret = -ENOMEM;
 			goto fail_alloc2;
@@ -144,12 +227,9 @@ static int device_bind_common(struct udevice *parent, const struct driver *drv,
 	}
 
 	if (parent) {
-		size = parent->driver->per_child_plat_auto;
-		if (!size)
-			size = parent->uclass->uc_drv->per_child_plat_auto;
-		if (size) {
-			dev_or_flags(dev, DM_FLAG_ALLOC_PARENT_PDATA);
-			ptr = calloc(1, size);
+		if (parent_plat_size) {
+			ptr = device_alloc_plat(dev, &next, parent_plat_size,
+						DM_FLAG_ALLOC_PARENT_PDATA);
 			if (!ptr) {
 				ret = -ENOMEM;
 				goto fail_alloc3;
@@ -232,7 +312,10 @@ fail_alloc2:
 fail_alloc1:
 	devres_release_all(dev);
 
-	free(dev);
+	/* Memory from the arena cannot be freed */
+	if (!CONFIG_IS_ENABLED(DM_ARENA) ||
+	    CONFIG_IS_ENABLED(DM_DEVICE_REMOVE))
+		free(dev);
 
 	return ret;
 }
@@ -332,7 +415,7 @@ static void *alloc_priv(int size, uint flags)
 			flush_dcache_range((ulong)priv, (ulong)priv + size);
 		}
 	} else {
-		priv = calloc(1, size);
+		priv = dm_alloc(size);
 	}
 
 	return priv;
@@ -478,17 +561,19 @@ static int device_get_dma_constraints(struct udevice *dev)
 	return 0;
 }
 
-int device_probe(struct udevice *dev)
+/**
+ * device_do_probe() - Probe a device which is not yet active
+ *
+ * This does the work of device_probe()
+ *
+ * @dev: Device to probe
+ * Return: 0 if OK, -ve on error
+ */
+static int device_do_probe(struct udevice *dev)
 {
 	const struct driver *drv;
 	int ret;
 
-	if (!dev)
-		return -EINVAL;
-
-	if (dev_get_flags(dev) & DM_FLAG_ACTIVATED)
-		return 0;
-
 	ret = device_notify(dev, EVT_DM_PRE_PROBE);
 	if (ret)
 		return ret;
@@ -616,6 +701,27 @@ fail:
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	ulong start;
+	int span, ret;
+
+	if (!dev)
+		return -EINVAL;
+
+	if (dev_get_flags(dev) & DM_FLAG_ACTIVATED)
+		return 0;
+
+	start = event_stats_start();
+	span = bootstage_span_begin(BOOTSTAGE_SPAN_PROBE, dev->name, 0);
+	ret = device_do_probe(dev);
+	bootstage_span_end(span);
+	if (!ret)
+		event_stats_add_probe(dev, start);
+
+	return ret;
+}
+
 void *dev_get_plat(const struct udevice *dev)
 {
 	if (!dev) {
@@ -897,6 +1003,7 @@ static struct udevice *_device_find_global_by_ofnode(struct udevice *parent,
 
 int device_find_global_by_ofnode(ofnode ofnode, struct udevice **devp)
 {
+	dm_lazy_bind_all();
 	*devp = _device_find_global_by_ofnode(gd->dm_root, ofnode);
 
 	return *devp ? 0 : -ENOENT;
@@ -906,6 +1013,7 @@ int device_get_global_by_ofnode(ofnode ofnode, struct udevice **devp)
 {
 	struct udevice *dev;
 
+	dm_lazy_bind_all();
 	dev = _device_find_global_by_ofnode(gd->dm_root, ofnode);
 	return device_get_device_tail(dev, dev ? 0 : -ENOENT, devp);
 }
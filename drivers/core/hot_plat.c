@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Platform data generated by dtoc for selected drivers in U-Boot proper
+ *
+ * The table is keyed by devicetree offset, so it is only used if the control
+ * devicetree has the size of the one given to dtoc. Otherwise drivers fall
+ * back to reading the devicetree.
+ */
+
+#define LOG_CATEGORY	LOGC_DM
+
+#include <dm.h>
+#include <log.h>
+#include <asm/global_data.h>
+#include <dm/platdata.h>
+#include <linux/libfdt.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+const void *dev_get_hot_plat(const struct udevice *dev)
+{
+	const struct dm_hot_plat *ent;
+	int offset = dev_of_offset(dev);
+	int lo = 0, hi = dm_hot_plat_count;
+
+	if (!gd->fdt_blob || offset < 0 ||
+	    fdt_totalsize(gd->fdt_blob) != dm_hot_plat_fdt_size)
+		return NULL;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		ent = &dm_hot_plat[mid];
+		if (ent->of_offset == offset) {
+			/* Check the struct is the one the driver expects */
+			if (strcmp(ent->name, dev->driver->name))
+				return NULL;
+			log_debug("Using generated data for '%s'\n", dev->name);
+			return ent->plat;
+		}
+		if (ent->of_offset < offset)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return NULL;
+}
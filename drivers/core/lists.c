@@ -11,6 +11,8 @@
 #include <debug_uart.h>
 #include <errno.h>
 #include <log.h>
+#include <malloc.h>
+#include <asm/global_data.h>
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -20,6 +22,8 @@
 #include <fdtdec.h>
 #include <linux/compiler.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 struct driver *lists_driver_lookup_name(const char *name)
 {
 	struct driver *drv =
@@ -196,11 +200,156 @@ static int driver_check_compatible(const struct udevice_id *of_match,
 	return -ENOENT;
 }
 
-int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
-		   struct driver *drv, bool pre_reloc_only)
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+/**
+ * struct compat_entry - A compatible string and the first driver matching it
+ *
+ * @compat: Compatible string, or NULL for an empty slot
+ * @drv: Driver
+ * @id: Entry in the driver's match table
+ */
+struct compat_entry {
+	const char *compat;
+	struct driver *drv;
+	const struct udevice_id *id;
+};
+
+/* Open-addressed hash table, no more than half full */
+static struct compat_entry *compat_idx;
+static uint compat_idx_size;
+
+static uint compat_hash(const char *compat)
+{
+	uint hash = 2166136261U;
+
+	while (*compat)
+		hash = (hash ^ (u8)*compat++) * 16777619U;
+
+	return hash;
+}
+
+static struct compat_entry *compat_slot(const char *compat)
+{
+	uint mask = compat_idx_size - 1;
+	uint i;
+
+	for (i = compat_hash(compat) & mask; compat_idx[i].compat;
+	     i = (i + 1) & mask) {
+		if (!strcmp(compat_idx[i].compat, compat))
+			break;
+	}
+
+	return &compat_idx[i];
+}
+
+/*
+ * Build the index on first use after relocation, since the full malloc()
+ * pool and writable BSS are not available before then
+ */
+static int compat_idx_build(void)
 {
 	struct driver *driver = ll_entry_start(struct driver, driver);
 	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	struct compat_entry *slot;
+	struct driver *entry;
+	uint count = 0, size;
+
+	if (compat_idx)
+		return 0;
+	if (!(gd->flags & GD_FLG_RELOC))
+		return -EAGAIN;
+
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++)
+			count++;
+	}
+	for (size = 16; size < count * 2; size *= 2)
+		;
+	compat_idx = calloc(size, sizeof(*compat_idx));
+	if (!compat_idx)
+		return -ENOMEM;
+	compat_idx_size = size;
+
+	/* The first driver in the list wins, as with a search of the list */
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			slot = compat_slot(id->compatible);
+			if (!slot->compat) {
+				slot->compat = id->compatible;
+				slot->drv = entry;
+				slot->id = id;
+			}
+		}
+	}
+
+	return 0;
+}
+#endif
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_TABLE)
+/*
+ * Search the table generated by scripts/gen_compat_table.py. The entries for
+ * a string are in linker-list order, so the first one whose driver really
+ * matches is the one a walk along the driver list would find.
+ */
+static struct driver *compat_table_lookup(const char *compat,
+					  const struct udevice_id **idp)
+{
+	const struct dm_compat_entry *ent;
+	int lo = 0, hi = dm_compat_table_count;
+
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (strcmp(dm_compat_table[mid].compat, compat) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (ent = dm_compat_table + lo;
+	     ent != dm_compat_table + dm_compat_table_count &&
+	     !strcmp(ent->compat, compat); ent++) {
+		if (!driver_check_compatible(ent->drv->of_match, idp, compat))
+			return ent->drv;
+	}
+
+	return NULL;
+}
+#endif
+
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **idp)
+{
+	struct driver *driver = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	struct driver *entry;
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_TABLE)
+	entry = compat_table_lookup(compat, idp);
+	if (entry)
+		return entry;
+#endif
+#if CONFIG_IS_ENABLED(DM_COMPAT_INDEX)
+	if (!compat_idx_build()) {
+		struct compat_entry *slot = compat_slot(compat);
+
+		*idp = slot->id;
+		return slot->drv;
+	}
+#endif
+	for (entry = driver; entry != driver + n_ents; entry++) {
+		if (!driver_check_compatible(entry->of_match, idp, compat))
+			return entry;
+	}
+
+	return NULL;
+}
+
+int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
+		   struct driver *drv, bool pre_reloc_only)
+{
 	const struct udevice_id *id;
 	struct driver *entry;
 	struct udevice *dev;
@@ -238,20 +387,16 @@ int lists_bind_fdt(struct udevice *parent, ofnode node, struct udevice **devp,
 			  compat);
 
 		id = NULL;
-		for (entry = driver; entry != driver + n_ents; entry++) {
-			if (drv) {
-				if (drv != entry)
-					continue;
-				if (!entry->of_match)
-					break;
-			}
-			ret = driver_check_compatible(entry->of_match, &id,
-						      compat);
-			if (!ret)
-				break;
-		}
-		if (entry == driver + n_ents)
+		if (!drv) {
+			entry = lists_driver_lookup_compat(compat, &id);
+			if (!entry)
+				continue;
+		} else if (drv->of_match &&
+			   driver_check_compatible(drv->of_match, &id, compat)) {
 			continue;
+		} else {
+			entry = drv;
+		}
 
 		if (pre_reloc_only) {
 			if (!ofnode_pre_reloc(node) &&
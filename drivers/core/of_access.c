@@ -123,16 +123,30 @@ int of_simple_size_cells(const struct device_node *np)
 	return 2;
 }
 
+u32 of_prop_hash(const char *name)
+{
+	u32 hash = 0x811c9dc5;
+
+	while (*name) {
+		hash ^= (u8)*name++;
+		hash *= 0x01000193;
+	}
+
+	return hash;
+}
+
 struct property *of_find_property(const struct device_node *np,
 				  const char *name, int *lenp)
 {
 	struct property *pp;
+	u32 hash;
 
 	if (!np)
 		return NULL;
 
+	hash = of_prop_hash(name);
 	for (pp = np->properties; pp; pp = pp->next) {
-		if (strcmp(pp->name, name) == 0) {
+		if (pp->hash == hash && strcmp(pp->name, name) == 0) {
 			if (lenp)
 				*lenp = pp->length;
 			break;
@@ -941,12 +955,14 @@ int of_write_prop(struct device_node *np, const char *propname, int len,
 	struct property *pp;
 	struct property *pp_last = NULL;
 	struct property *new;
+	u32 hash;
 
 	if (!np)
 		return -EINVAL;
 
+	hash = of_prop_hash(propname);
 	for (pp = np->properties; pp; pp = pp->next) {
-		if (strcmp(pp->name, propname) == 0) {
+		if (pp->hash == hash && strcmp(pp->name, propname) == 0) {
 			/* Property exists -> change value */
 			pp->value = (void *)value;
 			pp->length = len;
@@ -968,6 +984,7 @@ int of_write_prop(struct device_node *np, const char *propname, int len,
 
 	new->value = (void *)value;
 	new->length = len;
+	new->hash = hash;
 	new->next = NULL;
 
 	if (pp_last)
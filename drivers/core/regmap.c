@@ -36,6 +36,23 @@ struct regmap_field {
 	unsigned int reg;
 };
 
+/**
+ * struct regmap_cache - Flat cache of register values
+ *
+ * @dev:	Device passed to @volatile_reg
+ * @volatile_reg: Returns true for registers which are not cached, or NULL
+ * @count:	Number of registers in the cache
+ * @vals:	Cached value of each register
+ * @valid:	Non-zero for each register which has a cached value
+ */
+struct regmap_cache {
+	struct udevice *dev;
+	bool (*volatile_reg)(struct udevice *dev, uint offset);
+	uint count;
+	uint *vals;
+	u8 *valid;
+};
+
 DECLARE_GLOBAL_DATA_PTR;
 
 /**
@@ -350,6 +367,13 @@ struct regmap *devm_regmap_init(struct udevice *dev,
 	if (config) {
 		map->width = config->width;
 		map->reg_offset_shift = config->reg_offset_shift;
+		if (config->cache) {
+			rc = regmap_cache_init(map, dev, config);
+			if (rc) {
+				regmap_uninit(map);
+				return ERR_PTR(rc);
+			}
+		}
 	}
 
 	devres_add(dev, mapp);
@@ -370,6 +394,7 @@ void *regmap_get_range(struct regmap *map, unsigned int range_num)
 
 int regmap_uninit(struct regmap *map)
 {
+	free(map->cache);
 	free(map);
 
 	return 0;
@@ -474,6 +499,87 @@ int regmap_raw_read(struct regmap *map, uint offset, void *valp, size_t val_len)
 	return regmap_raw_read_range(map, 0, offset, valp, val_len);
 }
 
+/* Distance between the offsets of consecutive registers */
+static uint regmap_stride(struct regmap *map)
+{
+	return map->reg_offset_shift ? 1 : map->width;
+}
+
+/**
+ * regmap_cache_index() - Find the cache slot for a register
+ *
+ * @map:	Regmap to check
+ * @offset:	Offset of the register
+ * Return: index into the cache, or -1 if the register is not cached
+ */
+static int regmap_cache_index(struct regmap *map, uint offset)
+{
+	struct regmap_cache *cache = map->cache;
+	uint stride;
+
+	if (!IS_ENABLED(CONFIG_REGMAP_CACHE) || !cache)
+		return -1;
+
+	stride = regmap_stride(map);
+	if (offset % stride || offset / stride >= cache->count)
+		return -1;
+	if (cache->volatile_reg && cache->volatile_reg(cache->dev, offset))
+		return -1;
+
+	return offset / stride;
+}
+
+int regmap_cache_init(struct regmap *map, struct udevice *dev,
+		      const struct regmap_config *config)
+{
+	struct regmap_cache *cache;
+	uint count;
+
+	if (!IS_ENABLED(CONFIG_REGMAP_CACHE))
+		return 0;
+
+	count = config->max_register / regmap_stride(map) + 1;
+	cache = calloc(1, sizeof(*cache) + count * (sizeof(uint) + 1));
+	if (!cache)
+		return -ENOMEM;
+	cache->dev = dev;
+	cache->volatile_reg = config->volatile_reg;
+	cache->count = count;
+	cache->vals = (uint *)(cache + 1);
+	cache->valid = (u8 *)(cache->vals + count);
+
+	free(map->cache);
+	map->cache = cache;
+
+	return 0;
+}
+
+int regmap_cache_sync(struct regmap *map)
+{
+	struct regmap_cache *cache = map->cache;
+	uint i;
+	int ret;
+
+	if (!IS_ENABLED(CONFIG_REGMAP_CACHE) || !cache)
+		return 0;
+
+	for (i = 0; i < cache->count; i++) {
+		if (!cache->valid[i])
+			continue;
+		ret = regmap_write(map, i * regmap_stride(map), cache->vals[i]);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+void regmap_cache_drop(struct regmap *map)
+{
+	if (IS_ENABLED(CONFIG_REGMAP_CACHE) && map->cache)
+		memset(map->cache->valid, '\0', map->cache->count);
+}
+
 int regmap_read(struct regmap *map, uint offset, uint *valp)
 {
 	union {
@@ -482,7 +588,13 @@ int regmap_read(struct regmap *map, uint offset, uint *valp)
 		u32 v32;
 		u64 v64;
 	} u;
-	int res;
+	int res, idx;
+
+	idx = regmap_cache_index(map, offset);
+	if (idx >= 0 && map->cache->valid[idx]) {
+		*valp = map->cache->vals[idx];
+		return 0;
+	}
 
 	res = regmap_raw_read(map, offset, &u, map->width);
 	if (res)
@@ -505,6 +617,45 @@ int regmap_read(struct regmap *map, uint offset, uint *valp)
 		unreachable();
 	}
 
+	if (idx >= 0) {
+		map->cache->vals[idx] = *valp;
+		map->cache->valid[idx] = 1;
+	}
+
+	return 0;
+}
+
+int regmap_bulk_read(struct regmap *map, uint offset, void *val,
+		     size_t val_count)
+{
+	uint stride = regmap_stride(map);
+	uint v;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < val_count; i++) {
+		ret = regmap_read(map, offset + i * stride, &v);
+		if (ret)
+			return ret;
+
+		switch (map->width) {
+		case REGMAP_SIZE_8:
+			((u8 *)val)[i] = v;
+			break;
+		case REGMAP_SIZE_16:
+			((u16 *)val)[i] = v;
+			break;
+		case REGMAP_SIZE_32:
+			((u32 *)val)[i] = v;
+			break;
+		case REGMAP_SIZE_64:
+			((u64 *)val)[i] = v;
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+
 	return 0;
 }
 
@@ -622,6 +773,7 @@ int regmap_write(struct regmap *map, uint offset, uint val)
 		u32 v32;
 		u64 v64;
 	} u;
+	int ret, idx;
 
 	switch (map->width) {
 	case REGMAP_SIZE_8:
@@ -642,21 +794,65 @@ int regmap_write(struct regmap *map, uint offset, uint val)
 		return -EINVAL;
 	}
 
-	return regmap_raw_write(map, offset, &u, map->width);
+	ret = regmap_raw_write(map, offset, &u, map->width);
+	idx = regmap_cache_index(map, offset);
+	if (idx >= 0) {
+		map->cache->vals[idx] = val;
+		map->cache->valid[idx] = !ret;
+	}
+
+	return ret;
+}
+
+int regmap_bulk_write(struct regmap *map, uint offset, const void *val,
+		      size_t val_count)
+{
+	uint stride = regmap_stride(map);
+	uint v;
+	size_t i;
+	int ret;
+
+	for (i = 0; i < val_count; i++) {
+		switch (map->width) {
+		case REGMAP_SIZE_8:
+			v = ((const u8 *)val)[i];
+			break;
+		case REGMAP_SIZE_16:
+			v = ((const u16 *)val)[i];
+			break;
+		case REGMAP_SIZE_32:
+			v = ((const u32 *)val)[i];
+			break;
+		case REGMAP_SIZE_64:
+			v = ((const u64 *)val)[i];
+			break;
+		default:
+			return -EINVAL;
+		}
+
+		ret = regmap_write(map, offset + i * stride, v);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
 }
 
 int regmap_update_bits(struct regmap *map, uint offset, uint mask, uint val)
 {
-	uint reg;
+	uint reg, new;
 	int ret;
 
 	ret = regmap_read(map, offset, &reg);
 	if (ret)
 		return ret;
 
-	reg &= ~mask;
+	new = (reg & ~mask) | (val & mask);
+	/* The cache shows the register already holds this value */
+	if (new == reg && regmap_cache_index(map, offset) >= 0)
+		return 0;
 
-	return regmap_write(map, offset, reg | (val & mask));
+	return regmap_write(map, offset, new);
 }
 
 int regmap_field_read(struct regmap_field *field, unsigned int *val)
@@ -27,6 +27,7 @@
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
+#include <linux/bitmap.h>
 #include <linux/list.h>
 #include <linux/printk.h>
 
@@ -125,6 +126,10 @@ int dm_init(bool of_live)
 	}
 
 	INIT_LIST_HEAD((struct list_head *)&gd->dmtag_list);
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+	dm_lazy_drop_parent(NULL);
+	dm_lazy_set_uclasses(CONFIG_DM_LAZY_BIND_UCLASSES);
+#endif
 
 	return 0;
 }
@@ -174,6 +179,204 @@ int dm_scan_plat(bool pre_reloc_only)
 }
 
 #if CONFIG_IS_ENABLED(OF_REAL)
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/**
+ * struct dm_lazy_node - A subtree whose binding has been put off
+ *
+ * @sibling: Next in dm_lazy_list
+ * @parent: Device to bind the top node to
+ * @node: Top node of the subtree
+ * @uclasses: Uclasses of the drivers for the nodes in the subtree
+ */
+struct dm_lazy_node {
+	struct list_head sibling;
+	struct udevice *parent;
+	ofnode node;
+	ulong uclasses[BITS_TO_LONGS(UCLASS_COUNT)];
+};
+
+/*
+ * All of this is only touched after relocation, since writable BSS is not
+ * available before then
+ */
+static LIST_HEAD(dm_lazy_list);
+/* Uclasses whose devices are bound only when needed */
+static ulong dm_lazy_mask[BITS_TO_LONGS(UCLASS_COUNT)];
+/* Uclasses of the drivers in dm_lazy_list */
+static ulong dm_lazy_pending[BITS_TO_LONGS(UCLASS_COUNT)];
+
+int dm_lazy_set_uclasses(const char *names)
+{
+	struct uclass_driver *uc_drv =
+		ll_entry_start(struct uclass_driver, uclass_driver);
+	const int n_ents = ll_entry_count(struct uclass_driver, uclass_driver);
+	struct uclass_driver *entry;
+	int len, ret = 0;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+
+	bitmap_zero(dm_lazy_mask, UCLASS_COUNT);
+	for (; *names; names += len) {
+		names += strspn(names, " ");
+		len = strcspn(names, " ");
+		if (!len)
+			break;
+		for (entry = uc_drv; entry != uc_drv + n_ents; entry++) {
+			if (strlen(entry->name) == len &&
+			    !strncmp(entry->name, names, len))
+				break;
+		}
+		if (entry == uc_drv + n_ents) {
+			log_warning("Unknown uclass '%.*s'\n", len, names);
+			ret = -ENOENT;
+			continue;
+		}
+		__set_bit(entry->id, dm_lazy_mask);
+	}
+
+	return ret;
+}
+
+/* Find the driver for a node, as lists_bind_fdt() would first try it */
+static struct driver *dm_lazy_driver(ofnode node)
+{
+	const struct udevice_id *id;
+	const char *compat;
+	struct driver *drv;
+	int len, i;
+
+	compat = ofnode_get_property(node, "compatible", &len);
+	for (i = 0; compat && i < len; i += strlen(compat + i) + 1) {
+		drv = lists_driver_lookup_compat(compat + i, &id);
+		if (drv)
+			return drv;
+	}
+
+	return NULL;
+}
+
+/* Note the uclass of each driver in a subtree */
+static void dm_lazy_mark(struct dm_lazy_node *lazy, ofnode node)
+{
+	struct driver *drv;
+	ofnode subnode;
+
+	drv = dm_lazy_driver(node);
+	if (drv)
+		__set_bit(drv->id, lazy->uclasses);
+	ofnode_for_each_subnode(subnode, node) {
+		if (ofnode_is_enabled(subnode))
+			dm_lazy_mark(lazy, subnode);
+	}
+}
+
+static void dm_lazy_update_pending(void)
+{
+	struct dm_lazy_node *lazy;
+
+	bitmap_zero(dm_lazy_pending, UCLASS_COUNT);
+	list_for_each_entry(lazy, &dm_lazy_list, sibling)
+		bitmap_or(dm_lazy_pending, dm_lazy_pending, lazy->uclasses,
+			  UCLASS_COUNT);
+}
+
+/**
+ * dm_lazy_defer() - Put off binding a node if its driver is in a lazy uclass
+ *
+ * @parent: Parent device for the node
+ * @node: Node to check
+ * Return: true if the node is to be bound later, false to bind it now
+ */
+static bool dm_lazy_defer(struct udevice *parent, ofnode node)
+{
+	struct dm_lazy_node *lazy;
+	struct driver *drv;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return false;
+	drv = dm_lazy_driver(node);
+	if (!drv || !test_bit(drv->id, dm_lazy_mask))
+		return false;
+
+	lazy = calloc(1, sizeof(*lazy));
+	if (!lazy)
+		return false;
+	lazy->parent = parent;
+	lazy->node = node;
+	dm_lazy_mark(lazy, node);
+	list_add_tail(&lazy->sibling, &dm_lazy_list);
+	bitmap_or(dm_lazy_pending, dm_lazy_pending, lazy->uclasses,
+		  UCLASS_COUNT);
+	log_debug("Putting off binding '%s'\n", ofnode_get_name(node));
+
+	return true;
+}
+
+static void dm_lazy_bind(struct dm_lazy_node *lazy)
+{
+	int ret;
+
+	list_del(&lazy->sibling);
+	dm_lazy_update_pending();
+	log_debug("Binding '%s'\n", ofnode_get_name(lazy->node));
+	ret = lists_bind_fdt(lazy->parent, lazy->node, NULL, NULL, false);
+	if (ret)
+		dm_warn("%s: ret=%d\n", ofnode_get_name(lazy->node), ret);
+	free(lazy);
+}
+
+void dm_lazy_bind_uclass(enum uclass_id id)
+{
+	struct dm_lazy_node *lazy;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	/* Binding may add to the list or take from it, so start over */
+	while (test_bit(id, dm_lazy_pending)) {
+		list_for_each_entry(lazy, &dm_lazy_list, sibling) {
+			if (test_bit(id, lazy->uclasses))
+				break;
+		}
+		if (&lazy->sibling == &dm_lazy_list)
+			break;
+		dm_lazy_bind(lazy);
+	}
+}
+
+void dm_lazy_bind_all(void)
+{
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	while (!list_empty(&dm_lazy_list))
+		dm_lazy_bind(list_first_entry(&dm_lazy_list,
+					      struct dm_lazy_node, sibling));
+}
+
+void dm_lazy_drop_parent(struct udevice *parent)
+{
+	struct dm_lazy_node *lazy, *next;
+
+	if (!(gd->flags & GD_FLG_RELOC))
+		return;
+
+	list_for_each_entry_safe(lazy, next, &dm_lazy_list, sibling) {
+		if (!parent || lazy->parent == parent) {
+			list_del(&lazy->sibling);
+			free(lazy);
+		}
+	}
+	dm_lazy_update_pending();
+}
+#else
+static bool dm_lazy_defer(struct udevice *parent, ofnode node)
+{
+	return false;
+}
+#endif
+
 /**
  * dm_scan_fdt_node() - Scan the device tree and bind drivers for a node
  *
@@ -204,6 +407,8 @@ static int dm_scan_fdt_node(struct udevice *parent, ofnode parent_node,
 			pr_debug("   - ignoring disabled device\n");
 			continue;
 		}
+		if (!pre_reloc_only && dm_lazy_defer(parent, node))
+			continue;
 		err = lists_bind_fdt(parent, node, NULL, NULL, pre_reloc_only);
 		if (err && !ret) {
 			ret = err;
@@ -16,6 +16,7 @@
 #include <dm/device.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
+#include <dm/root.h>
 #include <dm/uclass.h>
 #include <dm/uclass-internal.h>
 #include <dm/util.h>
@@ -107,6 +108,152 @@ fail_mem:
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+/* Smallest size of the index tables, which are kept no more than half full */
+#define UCLASS_IDX_MIN_SIZE	16
+
+static uint uclass_idx_hash(ulong key, uint size)
+{
+	return (u32)((key * 0x9e3779b97f4a7c15ULL) >> 32) & (size - 1);
+}
+
+static ulong uclass_idx_key(const struct udevice *dev, bool phandle)
+{
+	if (phandle)
+		return dev_read_phandle(dev);
+
+	return dev_ofnode(dev).of_offset;
+}
+
+static void uclass_idx_insert(struct udevice **tbl, uint size,
+			      struct udevice *dev, bool phandle)
+{
+	uint i;
+
+	i = uclass_idx_hash(uclass_idx_key(dev, phandle), size);
+	while (tbl[i])
+		i = (i + 1) & (size - 1);
+	tbl[i] = dev;
+}
+
+#if CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
+/*
+ * Remove a device from a table, moving back any later device which could no
+ * longer be found across the gap. This keeps devices with the same key in the
+ * order they were bound, as in the uclass list.
+ */
+static void uclass_idx_delete(struct udevice **tbl, uint size,
+			      struct udevice *dev, bool phandle)
+{
+	uint mask = size - 1;
+	uint i, j, home;
+
+	i = uclass_idx_hash(uclass_idx_key(dev, phandle), size);
+	while (tbl[i] != dev) {
+		if (!tbl[i])
+			return;
+		i = (i + 1) & mask;
+	}
+
+	for (j = (i + 1) & mask; tbl[j]; j = (j + 1) & mask) {
+		home = uclass_idx_hash(uclass_idx_key(tbl[j], phandle), size);
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			tbl[i] = tbl[j];
+			i = j;
+		}
+	}
+	tbl[i] = NULL;
+}
+#endif
+
+static struct udevice *uclass_idx_find(struct uclass *uc, ulong key,
+				       bool phandle)
+{
+	struct udevice **tbl = phandle ? uc->phandle_idx : uc->node_idx;
+	uint i;
+
+	for (i = uclass_idx_hash(key, uc->idx_size); tbl[i];
+	     i = (i + 1) & (uc->idx_size - 1)) {
+		if (uclass_idx_key(tbl[i], phandle) == key)
+			return tbl[i];
+	}
+
+	return NULL;
+}
+
+static void uclass_idx_free(struct uclass *uc)
+{
+	free(uc->node_idx);
+	uc->node_idx = NULL;
+	uc->phandle_idx = NULL;
+	uc->idx_size = 0;
+	uc->idx_count = 0;
+}
+
+static void uclass_idx_add_dev(struct uclass *uc, struct udevice *dev)
+{
+	uclass_idx_insert(uc->node_idx, uc->idx_size, dev, false);
+	if (dev_read_phandle(dev))
+		uclass_idx_insert(uc->phandle_idx, uc->idx_size, dev, true);
+	uc->idx_count++;
+}
+
+/* Build the index afresh from the uclass list, with room to grow */
+static void uclass_idx_rebuild(struct uclass *uc)
+{
+	struct udevice **tbl;
+	struct udevice *dev;
+	uint size, count = 0;
+
+	uclass_foreach_dev(dev, uc) {
+		if (ofnode_valid(dev_ofnode(dev)))
+			count++;
+	}
+	for (size = UCLASS_IDX_MIN_SIZE; size < count * 2; size *= 2)
+		;
+
+	uclass_idx_free(uc);
+	/* Without the index, lookups walk the uclass list instead */
+	tbl = calloc(size * 2, sizeof(*tbl));
+	if (!tbl)
+		return;
+	uc->node_idx = tbl;
+	uc->phandle_idx = tbl + size;
+	uc->idx_size = size;
+	uclass_foreach_dev(dev, uc) {
+		if (ofnode_valid(dev_ofnode(dev)))
+			uclass_idx_add_dev(uc, dev);
+	}
+}
+
+static void uclass_idx_add(struct uclass *uc, struct udevice *dev)
+{
+	if (!ofnode_valid(dev_ofnode(dev)))
+		return;
+	if ((uc->idx_count + 1) * 2 > uc->idx_size)
+		uclass_idx_rebuild(uc);
+	else
+		uclass_idx_add_dev(uc, dev);
+}
+
+#if CONFIG_IS_ENABLED(DM_DEVICE_REMOVE)
+static void uclass_idx_remove(struct uclass *uc, struct udevice *dev)
+{
+	if (!uc->idx_size || !ofnode_valid(dev_ofnode(dev)))
+		return;
+	uclass_idx_delete(uc->node_idx, uc->idx_size, dev, false);
+	if (dev_read_phandle(dev))
+		uclass_idx_delete(uc->phandle_idx, uc->idx_size, dev, true);
+	if (!--uc->idx_count)
+		uclass_idx_free(uc);
+}
+#endif
+#else
+static inline void uclass_idx_add(struct uclass *uc, struct udevice *dev) {}
+static inline void uclass_idx_remove(struct uclass *uc, struct udevice *dev) {}
+static inline void uclass_idx_free(struct uclass *uc) {}
+#endif
+
 int uclass_destroy(struct uclass *uc)
 {
 	struct uclass_driver *uc_drv;
@@ -136,12 +283,23 @@ int uclass_destroy(struct uclass *uc)
 	list_del(&uc->sibling_node);
 	if (uc_drv->priv_auto)
 		free(uclass_get_priv(uc));
+	uclass_idx_free(uc);
 	free(uc);
 
 	return 0;
 }
 
 int uclass_get(enum uclass_id id, struct uclass **ucp)
+{
+	/* Immediately fail if driver model is not set up */
+	if (!gd->uclass_root)
+		return -EDEADLK;
+	dm_lazy_bind_uclass(id);
+
+	return uclass_get_no_lazy(id, ucp);
+}
+
+int uclass_get_no_lazy(enum uclass_id id, struct uclass **ucp)
 {
 	struct uclass *uc;
 
@@ -393,6 +551,13 @@ int uclass_find_device_by_ofnode(enum uclass_id id, ofnode node,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->idx_size) {
+		*devp = uclass_idx_find(uc, node.of_offset, false);
+		ret = *devp ? 0 : -ENODEV;
+		goto done;
+	}
+#endif
 	uclass_foreach_dev(dev, uc) {
 		log(LOGC_DM, LOGL_DEBUG_CONTENT, "      - checking %s\n",
 		    dev->name);
@@ -422,6 +587,12 @@ static int uclass_find_device_by_phandle_id(enum uclass_id id,
 	if (ret)
 		return ret;
 
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	if (uc->idx_size && find_phandle) {
+		*devp = uclass_idx_find(uc, find_phandle, true);
+		return *devp ? 0 : -ENODEV;
+	}
+#endif
 	uclass_foreach_dev(dev, uc) {
 		uint phandle;
 
@@ -703,6 +874,7 @@ int uclass_bind_device(struct udevice *dev)
 				goto err;
 		}
 	}
+	uclass_idx_add(uc, dev);
 
 	return 0;
 err:
@@ -730,6 +902,7 @@ int uclass_pre_unbind_device(struct udevice *dev)
 
 int uclass_unbind_device(struct udevice *dev)
 {
+	uclass_idx_remove(dev->uclass, dev);
 	list_del(&dev->uclass_node);
 
 	return 0;
@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Hash engine of the Rockchip crypto v2 block (RK3568, RK3588)
+ *
+ * The engine fetches its input through a list of DMA descriptors and pads
+ * the message itself, so a whole buffer is hashed with one DMA transfer.
+ * Input the engine cannot reach is handed to the software implementation.
+ */
+
+#include <clk.h>
+#include <cpu_func.h>
+#include <dm.h>
+#include <hash.h>
+#include <log.h>
+#include <malloc.h>
+#include <reset.h>
+#include <watchdog.h>
+#include <asm/cache.h>
+#include <asm/io.h>
+#include <asm/unaligned.h>
+#include <linux/bitops.h>
+#include <linux/delay.h>
+#include <linux/iopoll.h>
+#include <linux/sizes.h>
+#include <u-boot/hash.h>
+
+#define _SBF(s, v)			((v) << (s))
+#define WRITE_MASK(mask, val)		(((u32)(mask) << 16) | (val))
+
+/* register offsets */
+#define CRYPTO_CLK_CTL			0x0000
+#define   CRYPTO_AUTO_CLKGATE_EN		BIT(0)
+#define CRYPTO_RST_CTL			0x0004
+#define   CRYPTO_SW_CC_RESET			BIT(0)
+#define CRYPTO_DMA_INT_EN		0x0008
+#define CRYPTO_DMA_INT_ST		0x000c
+#define   CRYPTO_DMA_INT_ERR			GENMASK(6, 3)
+#define   CRYPTO_LIST_DONE_INT_ST		BIT(0)
+#define CRYPTO_DMA_CTL			0x0010
+#define   CRYPTO_DMA_START			BIT(0)
+#define CRYPTO_DMA_LLI_ADDR		0x0014
+#define CRYPTO_FIFO_CTL			0x0040
+#define   CRYPTO_DOUT_BYTESWAP			BIT(1)
+#define   CRYPTO_DOIN_BYTESWAP			BIT(0)
+#define CRYPTO_BC_CTL			0x0044
+#define CRYPTO_HASH_CTL			0x0048
+#define   CRYPTO_HASH_ALGO_SHA1			_SBF(4, 0x00)
+#define   CRYPTO_HASH_ALGO_MD5			_SBF(4, 0x01)
+#define   CRYPTO_HASH_ALGO_SHA256		_SBF(4, 0x02)
+#define   CRYPTO_HASH_ALGO_SHA512		_SBF(4, 0x08)
+#define   CRYPTO_HASH_ALGO_SHA384		_SBF(4, 0x09)
+#define   CRYPTO_HW_PAD_ENABLE			BIT(2)
+#define   CRYPTO_HASH_ENABLE			BIT(0)
+#define CRYPTO_HASH_DOUT_0		0x03a0
+#define CRYPTO_HASH_VALID		0x03e4
+#define   CRYPTO_HASH_IS_VALID			BIT(0)
+
+/* DMA descriptor fields */
+#define LLI_DMA_CTRL_LAST		BIT(0)
+#define LLI_USER_STRING_START		BIT(1)
+#define LLI_USER_STRING_LAST		BIT(2)
+
+/* bytes per descriptor, the engine is fed in pieces of this size */
+#define RK_CRYPTO_LLI_MAX		SZ_16M
+#define RK_CRYPTO_TIMEOUT_US		100000
+
+/**
+ * struct rk_crypto_lli - DMA descriptor of the crypto engine
+ *
+ * @src_addr:	physical address of input data
+ * @src_len:	number of input bytes
+ * @dst_addr:	physical address of output data, unused for hashing
+ * @dst_len:	number of output bytes, unused for hashing
+ * @user_define: LLI_USER_... flags
+ * @reserved:	reserved
+ * @dma_ctrl:	LLI_DMA_CTRL_... flags
+ * @next_addr:	physical address of next descriptor
+ */
+struct rk_crypto_lli {
+	u32 src_addr;
+	u32 src_len;
+	u32 dst_addr;
+	u32 dst_len;
+	u32 user_define;
+	u32 reserved;
+	u32 dma_ctrl;
+	u32 next_addr;
+};
+
+struct rk_crypto {
+	void __iomem *base;
+	struct clk_bulk clks;
+	struct reset_ctl_bulk resets;
+};
+
+static u32 rk_crypto_hash_mode(enum HASH_ALGO algo)
+{
+	switch (algo) {
+	case HASH_ALGO_MD5:
+		return CRYPTO_HASH_ALGO_MD5;
+	case HASH_ALGO_SHA1:
+		return CRYPTO_HASH_ALGO_SHA1;
+	case HASH_ALGO_SHA256:
+		return CRYPTO_HASH_ALGO_SHA256;
+	case HASH_ALGO_SHA384:
+		return CRYPTO_HASH_ALGO_SHA384;
+	case HASH_ALGO_SHA512:
+		return CRYPTO_HASH_ALGO_SHA512;
+	default:
+		return U32_MAX;
+	}
+}
+
+/**
+ * rk_crypto_hash_sw() - hash a buffer in software
+ *
+ * This is used for algorithms and buffers the engine cannot handle.
+ */
+static int rk_crypto_hash_sw(enum HASH_ALGO algo, const void *ibuf,
+			     const uint32_t ilen, void *obuf, uint32_t chunk_sz)
+{
+	struct hash_algo *sw;
+	int ret;
+
+	ret = hash_lookup_algo(hash_algo_name(algo), &sw);
+	if (ret)
+		return ret;
+
+	sw->hash_func_ws(ibuf, ilen, obuf, chunk_sz);
+
+	return 0;
+}
+
+static int rk_crypto_wait(struct rk_crypto *priv, uint32_t ilen)
+{
+	ulong timeout = RK_CRYPTO_TIMEOUT_US + (ilen >> 6);
+	u32 st;
+
+	/* Keep the watchdog happy while hashing large images */
+	while (1) {
+		st = readl(priv->base + CRYPTO_DMA_INT_ST);
+		if (st & (CRYPTO_LIST_DONE_INT_ST | CRYPTO_DMA_INT_ERR))
+			break;
+		if (!timeout--)
+			return -ETIMEDOUT;
+		udelay(1);
+		if (!(timeout & 0xfff))
+			schedule();
+	}
+	writel(st, priv->base + CRYPTO_DMA_INT_ST);
+	if (st & CRYPTO_DMA_INT_ERR) {
+		log_debug("DMA error %#x\n", st);
+		return -EIO;
+	}
+
+	return readl_poll_timeout(priv->base + CRYPTO_HASH_VALID, st,
+				  st & CRYPTO_HASH_IS_VALID,
+				  RK_CRYPTO_TIMEOUT_US);
+}
+
+static int rk_crypto_digest_wd(struct udevice *dev, enum HASH_ALGO algo,
+			       const void *ibuf, const uint32_t ilen,
+			       void *obuf, uint32_t chunk_sz)
+{
+	struct rk_crypto *priv = dev_get_priv(dev);
+	ulong start = (ulong)ibuf;
+	struct rk_crypto_lli *lli;
+	u32 mode, size, val;
+	int count, i, ret;
+
+	mode = rk_crypto_hash_mode(algo);
+	count = DIV_ROUND_UP(ilen, RK_CRYPTO_LLI_MAX);
+	if (mode == U32_MAX || !count ||
+	    upper_32_bits((u64)start + ilen - 1))
+		return rk_crypto_hash_sw(algo, ibuf, ilen, obuf, chunk_sz);
+
+	lli = memalign(ARCH_DMA_MINALIGN,
+		       ALIGN(count * sizeof(*lli), ARCH_DMA_MINALIGN));
+	if (!lli)
+		return -ENOMEM;
+	if (upper_32_bits((ulong)lli)) {
+		free(lli);
+		return rk_crypto_hash_sw(algo, ibuf, ilen, obuf, chunk_sz);
+	}
+
+	for (i = 0; i < count; i++) {
+		size = min_t(u32, ilen - i * RK_CRYPTO_LLI_MAX,
+			     RK_CRYPTO_LLI_MAX);
+		memset(&lli[i], '\0', sizeof(*lli));
+		lli[i].src_addr = start + i * RK_CRYPTO_LLI_MAX;
+		lli[i].src_len = size;
+		if (!i)
+			lli[i].user_define |= LLI_USER_STRING_START;
+		if (i == count - 1) {
+			lli[i].user_define |= LLI_USER_STRING_LAST;
+			lli[i].dma_ctrl = LLI_DMA_CTRL_LAST;
+		} else {
+			lli[i].next_addr = (ulong)&lli[i + 1];
+		}
+	}
+
+	flush_dcache_range(ALIGN_DOWN(start, ARCH_DMA_MINALIGN),
+			   ALIGN(start + ilen, ARCH_DMA_MINALIGN));
+	flush_dcache_range((ulong)lli,
+			   (ulong)lli + ALIGN(count * sizeof(*lli),
+					      ARCH_DMA_MINALIGN));
+
+	/* Reset the engine and configure it for hashing */
+	writel(WRITE_MASK(CRYPTO_SW_CC_RESET, CRYPTO_SW_CC_RESET),
+	       priv->base + CRYPTO_RST_CTL);
+	ret = readl_poll_timeout(priv->base + CRYPTO_RST_CTL, val,
+				 !(val & CRYPTO_SW_CC_RESET),
+				 RK_CRYPTO_TIMEOUT_US);
+	if (ret)
+		goto out;
+
+	writel(WRITE_MASK(0xffff, 0), priv->base + CRYPTO_BC_CTL);
+	writel(WRITE_MASK(0xffff, CRYPTO_DOUT_BYTESWAP | CRYPTO_DOIN_BYTESWAP),
+	       priv->base + CRYPTO_FIFO_CTL);
+	writel(0, priv->base + CRYPTO_DMA_INT_EN);
+	writel(readl(priv->base + CRYPTO_DMA_INT_ST),
+	       priv->base + CRYPTO_DMA_INT_ST);
+	writel(WRITE_MASK(0xffff, mode | CRYPTO_HW_PAD_ENABLE |
+			  CRYPTO_HASH_ENABLE),
+	       priv->base + CRYPTO_HASH_CTL);
+
+	writel((ulong)lli, priv->base + CRYPTO_DMA_LLI_ADDR);
+	writel(WRITE_MASK(CRYPTO_DMA_START, CRYPTO_DMA_START),
+	       priv->base + CRYPTO_DMA_CTL);
+
+	ret = rk_crypto_wait(priv, ilen);
+	if (ret)
+		goto out;
+
+	/* The digest registers hold the result in big-endian words */
+	for (i = 0; i < hash_algo_digest_size(algo); i += sizeof(u32)) {
+		val = readl(priv->base + CRYPTO_HASH_DOUT_0 + i);
+		put_unaligned_be32(val, obuf + i);
+	}
+
+out:
+	writel(WRITE_MASK(0xffff, 0), priv->base + CRYPTO_HASH_CTL);
+	free(lli);
+
+	return ret;
+}
+
+static int rk_crypto_digest(struct udevice *dev, enum HASH_ALGO algo,
+			    const void *ibuf, const uint32_t ilen, void *obuf)
+{
+	return rk_crypto_digest_wd(dev, algo, ibuf, ilen, obuf, ilen);
+}
+
+static int rk_crypto_probe(struct udevice *dev)
+{
+	struct rk_crypto *priv = dev_get_priv(dev);
+	int ret;
+
+	priv->base = dev_read_addr_ptr(dev);
+	if (!priv->base)
+		return -EINVAL;
+
+	ret = clk_get_bulk(dev, &priv->clks);
+	if (ret && ret != -ENOENT)
+		return ret;
+	if (!ret) {
+		ret = clk_enable_bulk(&priv->clks);
+		if (ret)
+			return ret;
+	}
+
+	ret = reset_get_bulk(dev, &priv->resets);
+	if (!ret)
+		reset_deassert_bulk(&priv->resets);
+
+	writel(WRITE_MASK(CRYPTO_AUTO_CLKGATE_EN, CRYPTO_AUTO_CLKGATE_EN),
+	       priv->base + CRYPTO_CLK_CTL);
+
+	return 0;
+}
+
+static int rk_crypto_remove(struct udevice *dev)
+{
+	struct rk_crypto *priv = dev_get_priv(dev);
+
+	clk_release_bulk(&priv->clks);
+
+	return 0;
+}
+
+static const struct hash_ops rk_crypto_ops = {
+	.hash_digest_wd = rk_crypto_digest_wd,
+	.hash_digest = rk_crypto_digest,
+};
+
+static const struct udevice_id rk_crypto_ids[] = {
+	{ .compatible = "rockchip,rk3568-crypto" },
+	{ .compatible = "rockchip,rk3588-crypto" },
+	{ }
+};
+
+U_BOOT_DRIVER(rockchip_crypto_v2) = {
+	.name = "rockchip_crypto_v2",
+	.id = UCLASS_HASH,
+	.of_match = rk_crypto_ids,
+	.ops = &rk_crypto_ops,
+	.probe = rk_crypto_probe,
+	.remove = rk_crypto_remove,
+	.priv_auto = sizeof(struct rk_crypto),
+};
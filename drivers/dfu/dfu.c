@@ -10,18 +10,22 @@
 #include <errno.h>
 #include <log.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <mmc.h>
 #include <fat.h>
 #include <dfu.h>
 #include <hash.h>
+#include <time.h>
 #include <linux/list.h>
 #include <linux/compiler.h>
+#include <linux/math64.h>
 #include <linux/printk.h>
 
 LIST_HEAD(dfu_list);
 static int dfu_alt_num;
 static int alt_num_cnt;
 static struct hash_algo *dfu_hash_algo;
+static ulong dfu_start_time;
 #ifdef CONFIG_DFU_TIMEOUT
 static unsigned long dfu_timeout = 0;
 #endif
@@ -325,11 +329,25 @@ int dfu_transaction_initiate(struct dfu_entity *dfu, bool read)
 	}
 
 	dfu->inited = 1;
+	dfu_start_time = get_timer(0);
 	dfu_initiated_callback(dfu);
 
 	return 0;
 }
 
+/* Show how long a download took, so slow media or links are easy to spot */
+static void dfu_show_rate(struct dfu_entity *dfu)
+{
+	ulong ms;
+
+	if (IS_ENABLED(CONFIG_XPL_BUILD) || !dfu->offset)
+		return;
+
+	ms = max(get_timer(dfu_start_time), 1UL);
+	printf("\nDFU %s: %llu bytes in %lu ms (%llu KiB/s)\n", dfu->name,
+	       dfu->offset, ms, div_u64(dfu->offset * 1000 / 1024, ms));
+}
+
 int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 {
 	int ret = 0;
@@ -341,6 +359,8 @@ int dfu_flush(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	if (dfu->flush_medium)
 		ret = dfu->flush_medium(dfu);
 
+	dfu_show_rate(dfu);
+
 	if (dfu_hash_algo)
 		printf("\nDFU complete %s: 0x%08x\n", dfu_hash_algo->name,
 		       dfu->crc);
@@ -388,37 +408,29 @@ int dfu_write(struct dfu_entity *dfu, void *buf, int size, int blk_seq_num)
 	/* handle rollover */
 	dfu->i_blk_seq_num = (dfu->i_blk_seq_num + 1) & 0xffff;
 
-	/* flush buffer if overflow */
-	if ((dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
-		if (ret) {
-			dfu_transaction_cleanup(dfu);
-			dfu_error_callback(dfu, "DFU write error");
-			return ret;
-		}
-	}
-
-	/* we should be in buffer now (if not then size too large) */
-	if ((dfu->i_buf + size) > dfu->i_buf_end) {
-		pr_err("Buffer overflow! (0x%p + 0x%x > 0x%p)\n", dfu->i_buf,
-		      size, dfu->i_buf_end);
-		dfu_transaction_cleanup(dfu);
-		dfu_error_callback(dfu, "Buffer overflow");
-		return -1;
-	}
-
-	memcpy(dfu->i_buf, buf, size);
-	dfu->i_buf += size;
-
-	/* if end or if buffer full flush */
-	if (size == 0 || (dfu->i_buf + size) > dfu->i_buf_end) {
-		ret = dfu_write_buffer_drain(dfu);
-		if (ret) {
-			dfu_transaction_cleanup(dfu);
-			dfu_error_callback(dfu, "DFU write error");
-			return ret;
+	/*
+	 * A block may be larger than the buffer (e.g. a large wTransferSize
+	 * with a buffer limited to the flash erase size), so fill the buffer
+	 * and write it out as many times as needed. An empty block marks the
+	 * end of the download and flushes what is left.
+	 */
+	do {
+		long chunk = min((long)size, (long)(dfu->i_buf_end - dfu->i_buf));
+
+		memcpy(dfu->i_buf, buf, chunk);
+		dfu->i_buf += chunk;
+		buf += chunk;
+		size -= chunk;
+
+		if (!chunk || dfu->i_buf == dfu->i_buf_end) {
+			ret = dfu_write_buffer_drain(dfu);
+			if (ret) {
+				dfu_transaction_cleanup(dfu);
+				dfu_error_callback(dfu, "DFU write error");
+				return ret;
+			}
 		}
-	}
+	} while (size > 0);
 
 	return 0;
 }
@@ -739,6 +751,39 @@ int dfu_get_alt(char *name)
 	return -ENODEV;
 }
 
+/*
+ * Write data which is already in memory straight to the medium, in chunks of
+ * the DFU buffer size, instead of copying it through the DFU buffer first
+ */
+int dfu_write_direct(struct dfu_entity *dfu, void *buf, long size)
+{
+	int ret;
+
+	ret = dfu_transaction_initiate(dfu, false);
+	if (ret < 0)
+		return ret;
+
+	while (size > 0) {
+		long w_size = min(size, (long)dfu_get_buf_size());
+
+		if (dfu_hash_algo)
+			dfu_hash_algo->hash_update(dfu_hash_algo, &dfu->crc,
+						   buf, w_size, 0);
+		ret = dfu->write_medium(dfu, dfu->offset, buf, &w_size);
+		if (ret) {
+			dfu_transaction_cleanup(dfu);
+			dfu_error_callback(dfu, "DFU write error");
+			return ret;
+		}
+		dfu->offset += w_size;
+		buf += w_size;
+		size -= w_size;
+		puts("#");
+	}
+
+	return 0;
+}
+
 int dfu_write_from_mem_addr(struct dfu_entity *dfu, void *buf, int size)
 {
 	unsigned long dfu_buf_size, write, left = size;
@@ -754,6 +799,16 @@ int dfu_write_from_mem_addr(struct dfu_entity *dfu, void *buf, int size)
 	dfu_buf_size = dfu_get_buf_size();
 	debug("%s: dfu buf size: %lu\n", __func__, dfu_buf_size);
 
+	/* the medium may use DMA, so only skip the copy if that is safe */
+	if (IS_ALIGNED((ulong)buf, ARCH_DMA_MINALIGN)) {
+		ret = dfu_write_direct(dfu, buf, size);
+		if (ret) {
+			pr_err("DFU write failed\n");
+			return ret;
+		}
+		left = 0;
+	}
+
 	for (i = 0; left > 0; i++) {
 		write = min(dfu_buf_size, left);
 
@@ -260,6 +260,83 @@ int dma_memcpy(void *dst, void *src, size_t len)
 	return ret;
 }
 
+#if CONFIG_IS_ENABLED(DMA_BULK_COPY)
+static void dma_copy_unmap(struct dma_copy *copy)
+{
+	dma_unmap_single((ulong)copy->dst, copy->len, DMA_FROM_DEVICE);
+	dma_unmap_single((ulong)copy->src, copy->len, DMA_TO_DEVICE);
+}
+
+void dma_copy_start(struct dma_copy *copy, void *dst, const void *src,
+		    size_t len)
+{
+	const struct dma_ops *ops;
+	struct udevice *dev;
+	dma_addr_t destination;
+	dma_addr_t source;
+	int ret;
+
+	copy->dev = NULL;
+	copy->dst = dst;
+	copy->src = (void *)src;
+	copy->len = len;
+
+	/*
+	 * The destination is invalidated before the transfer, so it must not
+	 * share a cache line with anything else
+	 */
+	if (len < CONFIG_DMA_BULK_COPY_THRESHOLD ||
+	    !IS_ALIGNED((ulong)dst | len, ARCH_DMA_MINALIGN) ||
+	    (dst < src + len && src < dst + len) ||
+	    dma_get_device(DMA_SUPPORTS_MEM_TO_MEM, &dev))
+		goto cpu_copy;
+
+	ops = device_get_ops(dev);
+	if (!ops->transfer_start && !ops->transfer)
+		goto cpu_copy;
+
+	destination = dma_map_single(dst, len, DMA_FROM_DEVICE);
+	source = dma_map_single(copy->src, len, DMA_TO_DEVICE);
+
+	if (ops->transfer_start) {
+		ret = ops->transfer_start(dev, DMA_MEM_TO_MEM, destination,
+					  source, len);
+		if (!ret) {
+			copy->dev = dev;
+			return;
+		}
+	} else {
+		ret = ops->transfer(dev, DMA_MEM_TO_MEM, destination, source,
+				    len);
+	}
+	dma_copy_unmap(copy);
+	if (!ret)
+		return;
+	log_debug("DMA copy failed (err=%d), using memcpy()\n", ret);
+
+cpu_copy:
+	memmove(dst, src, len);
+}
+
+void dma_copy_wait(struct dma_copy *copy)
+{
+	const struct dma_ops *ops;
+	int ret;
+
+	if (!copy->dev)
+		return;
+
+	ops = device_get_ops(copy->dev);
+	ret = ops->transfer_wait ? ops->transfer_wait(copy->dev) : 0;
+	dma_copy_unmap(copy);
+	copy->dev = NULL;
+	if (ret) {
+		log_debug("DMA copy failed (err=%d), using memcpy()\n", ret);
+		memcpy(copy->dst, copy->src, copy->len);
+	}
+}
+#endif /* DMA_BULK_COPY */
+
 UCLASS_DRIVER(dma) = {
 	.id		= UCLASS_DMA,
 	.name		= "dma",
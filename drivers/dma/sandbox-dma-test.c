@@ -36,6 +36,7 @@ struct sandbox_dma_dev {
 	uchar	*buf_rx;
 	size_t	data_len;
 	u32	meta;
+	bool	copy_busy;
 };
 
 static int sandbox_dma_transfer(struct udevice *dev, int direction,
@@ -46,6 +47,30 @@ static int sandbox_dma_transfer(struct udevice *dev, int direction,
 	return 0;
 }
 
+static int sandbox_dma_transfer_start(struct udevice *dev, int direction,
+				      dma_addr_t dst, dma_addr_t src,
+				      size_t len)
+{
+	struct sandbox_dma_dev *ud = dev_get_priv(dev);
+
+	if (ud->copy_busy)
+		return -EBUSY;
+	ud->copy_busy = true;
+
+	return sandbox_dma_transfer(dev, direction, dst, src, len);
+}
+
+static int sandbox_dma_transfer_wait(struct udevice *dev)
+{
+	struct sandbox_dma_dev *ud = dev_get_priv(dev);
+
+	if (!ud->copy_busy)
+		return -EINVAL;
+	ud->copy_busy = false;
+
+	return 0;
+}
+
 static int sandbox_dma_of_xlate(struct dma *dma,
 				struct ofnode_phandle_args *args)
 {
@@ -229,6 +254,8 @@ static int sandbox_dma_prepare_rcv_buf(struct dma *dma, void *dst, size_t size)
 
 static const struct dma_ops sandbox_dma_ops = {
 	.transfer	= sandbox_dma_transfer,
+	.transfer_start	= sandbox_dma_transfer_start,
+	.transfer_wait	= sandbox_dma_transfer_wait,
 	.of_xlate	= sandbox_dma_of_xlate,
 	.request	= sandbox_dma_request,
 	.rfree		= sandbox_dma_rfree,
@@ -12,8 +12,11 @@
 #include <fb_nand.h>
 #include <part.h>
 #include <stdlib.h>
+#include <time.h>
 #include <vsprintf.h>
+#include <linux/math64.h>
 #include <linux/printk.h>
+#include <linux/sizes.h>
 
 /**
  * image_size - final fastboot image size
@@ -30,6 +33,37 @@ static u32 fastboot_bytes_received;
  */
 static u32 fastboot_bytes_expected;
 
+/**
+ * download_start - time at which the current download started, in ms
+ */
+static ulong download_start;
+
+/**
+ * download_rate - speed of the last download, in bytes per second
+ */
+static u32 download_rate;
+
+/**
+ * stream_part - partition which the next download is written to as it arrives
+ */
+static char stream_part[FASTBOOT_COMMAND_LEN];
+
+/**
+ * stream_size - size of each half of the download buffer, or 0 if the current
+ * download is not being streamed
+ */
+static u32 stream_size;
+
+/**
+ * stream_half - half of the download buffer receiving data
+ */
+static int stream_half;
+
+/**
+ * stream_fill - number of bytes received into the current half
+ */
+static u32 stream_fill;
+
 static void okay(char *, char *);
 static void getvar(char *, char *);
 static void download(char *, char *);
@@ -43,6 +77,7 @@ static void oem_partconf(char *, char *);
 static void oem_bootbus(char *, char *);
 static void oem_console(char *, char *);
 static void oem_board(char *, char *);
+static void oem_stream(char *, char *);
 static void run_ucmd(char *, char *);
 static void run_acmd(char *, char *);
 
@@ -118,6 +153,10 @@ static const struct {
 		.command = "oem board",
 		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_OEM_BOARD, (oem_board), (NULL))
 	},
+	[FASTBOOT_COMMAND_OEM_STREAM] = {
+		.command = "oem stream",
+		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM, (oem_stream), (NULL))
+	},
 	[FASTBOOT_COMMAND_UCMD] = {
 		.command = "UCmd",
 		.dispatch = CONFIG_IS_ENABLED(FASTBOOT_UUU_SUPPORT, (run_ucmd), (NULL))
@@ -234,10 +273,33 @@ static void download(char *cmd_parameter, char *response)
 	}
 	fastboot_bytes_received = 0;
 	fastboot_bytes_expected = hextoul(cmd_parameter, &tmp);
+	download_start = get_timer(0);
 	if (fastboot_bytes_expected == 0) {
 		fastboot_fail("Expected nonzero image size", response);
 		return;
 	}
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) && stream_part[0]) {
+		/* Each half is a whole number of pages, to help the transport */
+		stream_size = ALIGN_DOWN(fastboot_buf_size / 2, SZ_4K);
+		stream_half = 0;
+		stream_fill = 0;
+		if (!stream_size) {
+			fastboot_fail("Buffer too small for streaming",
+				      response);
+		} else if (!fastboot_mmc_stream_start(stream_part,
+						      fastboot_bytes_expected,
+						      response)) {
+			printf("Starting download of %d bytes to '%s'\n",
+			       fastboot_bytes_expected, stream_part);
+			fastboot_response("DATA", response, "%s",
+					  cmd_parameter);
+			return;
+		}
+		stream_size = 0;
+		stream_part[0] = '\0';
+		fastboot_bytes_expected = 0;
+		return;
+	}
 	/*
 	 * Nothing to download yet. Response is of the form:
 	 * [DATA|FAIL]$cmd_parameter
@@ -263,6 +325,101 @@ u32 fastboot_data_remaining(void)
 	return fastboot_bytes_expected - fastboot_bytes_received;
 }
 
+u32 fastboot_data_rate(void)
+{
+	return download_rate;
+}
+
+/**
+ * stream_end() - Finish a streamed download
+ *
+ * @response: Pointer to fastboot response buffer, or NULL if the download has
+ *	already failed
+ */
+static void stream_end(char *response)
+{
+	char ignored[FASTBOOT_RESPONSE_LEN];
+
+	fastboot_mmc_stream_end(response ? response : ignored);
+	stream_size = 0;
+	stream_part[0] = '\0';
+}
+
+/**
+ * stream_flush() - Write the data in the current half of the buffer
+ *
+ * The other half then receives the data which follows.
+ *
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error
+ */
+static int stream_flush(char *response)
+{
+	void *buf = fastboot_buf_addr + stream_half * stream_size;
+	u32 len = stream_fill;
+
+	stream_half ^= 1;
+	stream_fill = 0;
+
+	return fastboot_mmc_stream_write(buf, len, response);
+}
+
+/**
+ * stream_data() - Add received data to a streamed download
+ *
+ * Each half of the download buffer is written as soon as it is full. Data
+ * which is already in place, having been received there by the transport, is
+ * not copied.
+ *
+ * @data: Pointer to received data
+ * @len: Length of received data
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error, in which case the download is abandoned
+ */
+static int stream_data(const void *data, u32 len, char *response)
+{
+	void *dst;
+	u32 n;
+
+	while (len) {
+		dst = fastboot_buf_addr + stream_half * stream_size +
+			stream_fill;
+		n = min(len, stream_size - stream_fill);
+		if (dst != data)
+			memcpy(dst, data, n);
+		stream_fill += n;
+		data += n;
+		len -= n;
+
+		if (stream_fill == stream_size && stream_flush(response)) {
+			stream_end(NULL);
+			fastboot_bytes_expected = 0;
+			fastboot_bytes_received = 0;
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+void *fastboot_data_stream_buf(u32 len, u32 *size)
+{
+	int half = stream_half;
+	u32 fill;
+
+	if (!CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) || !stream_size)
+		return NULL;
+
+	fill = stream_fill + len;
+	if (fill >= stream_size) {
+		half ^= 1;
+		fill -= stream_size;
+	}
+	*size = stream_size - fill;
+
+	return fastboot_buf_addr + half * stream_size + fill;
+}
+
 /**
  * fastboot_data_download() - Copy image data to fastboot_buf_addr.
  *
@@ -291,9 +448,14 @@ void fastboot_data_download(const void *fastboot_data,
 			      response);
 		return;
 	}
-	/* Download data to fastboot_buf_addr */
-	memcpy(fastboot_buf_addr + fastboot_bytes_received,
-	       fastboot_data, fastboot_data_len);
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) && stream_size) {
+		if (stream_data(fastboot_data, fastboot_data_len, response))
+			return;
+	} else {
+		/* Download data to fastboot_buf_addr */
+		memcpy(fastboot_buf_addr + fastboot_bytes_received,
+		       fastboot_data, fastboot_data_len);
+	}
 
 	pre_dot_num = fastboot_bytes_received / BYTES_PER_DOT;
 	fastboot_bytes_received += fastboot_data_len;
@@ -320,6 +482,18 @@ void fastboot_data_complete(char *response)
 	fastboot_okay(NULL, response);
 	printf("\ndownloading of %d bytes finished\n", fastboot_bytes_received);
 	image_size = fastboot_bytes_received;
+
+	/* Write the rest of a streamed image, which leaves nothing to flash */
+	if (CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM) && stream_size) {
+		if (!stream_fill || !stream_flush(response))
+			stream_end(response);
+		else
+			stream_end(NULL);
+		image_size = 0;
+	}
+	/* This includes writing a streamed image */
+	download_rate = div_u64((u64)fastboot_bytes_received * 1000,
+				max(get_timer(download_start), 1UL));
 	env_set_hex("filesize", image_size);
 	fastboot_bytes_expected = 0;
 	fastboot_bytes_received = 0;
@@ -548,6 +722,26 @@ static void __maybe_unused oem_console(char *cmd_parameter, char *response)
 		fastboot_response(FASTBOOT_MULTIRESPONSE_START, response, NULL);
 }
 
+/**
+ * oem_stream() - Execute the OEM stream command
+ *
+ * The next download is written to the partition indicated by cmd_parameter
+ * as it arrives, so no "flash" command is needed for it.
+ *
+ * @cmd_parameter: Pointer to partition name
+ * @response: Pointer to fastboot response buffer
+ */
+static void __maybe_unused oem_stream(char *cmd_parameter, char *response)
+{
+	if (!cmd_parameter || !*cmd_parameter) {
+		fastboot_fail("Expected partition name", response);
+		return;
+	}
+
+	strlcpy(stream_part, cmd_parameter, sizeof(stream_part));
+	fastboot_okay(NULL, response);
+}
+
 /**
  * fastboot_oem_board() - Execute the OEM board command. This is default
  * weak implementation, which may be overwritten in board/ files.
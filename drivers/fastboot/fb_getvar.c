@@ -17,6 +17,7 @@
 static void getvar_version(char *var_parameter, char *response);
 static void getvar_version_bootloader(char *var_parameter, char *response);
 static void getvar_downloadsize(char *var_parameter, char *response);
+static void getvar_download_rate(char *var_parameter, char *response);
 static void getvar_serialno(char *var_parameter, char *response);
 static void getvar_version_baseband(char *var_parameter, char *response);
 static void getvar_product(char *var_parameter, char *response);
@@ -48,6 +49,10 @@ static const struct {
 		.variable = "max-download-size",
 		.dispatch = getvar_downloadsize,
 		.list = true
+	}, {
+		.variable = "download-rate",
+		.dispatch = getvar_download_rate,
+		.list = true
 	}, {
 		.variable = "serialno",
 		.dispatch = getvar_serialno,
@@ -146,6 +151,12 @@ static void getvar_downloadsize(char *var_parameter, char *response)
 	fastboot_response("OKAY", response, "0x%08x", fastboot_buf_size);
 }
 
+static void getvar_download_rate(char *var_parameter, char *response)
+{
+	fastboot_response("OKAY", response, "%u KiB/s",
+			  fastboot_data_rate() / 1024);
+}
+
 static void getvar_serialno(char *var_parameter, char *response)
 {
 	const char *tmp = env_get("serial#");
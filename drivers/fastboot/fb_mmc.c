@@ -164,6 +164,21 @@ static lbaint_t fb_mmc_sparse_reserve(struct sparse_storage *info,
 	return blkcnt;
 }
 
+static lbaint_t fb_mmc_sparse_write_zeroes(struct sparse_storage *info,
+		lbaint_t blk, lbaint_t blkcnt)
+{
+	struct fb_mmc_sparse *sparse = info->priv;
+	struct blk_desc *dev_desc = sparse->dev_desc;
+	struct mmc *mmc = find_mmc_device(dev_desc->devnum);
+
+	/* The erase is done FASTBOOT_MAX_BLK_WRITE blocks at a time */
+	if (!mmc || !mmc_erase_reads_zero(mmc, blk, blkcnt) ||
+	    (!mmc->can_trim && FASTBOOT_MAX_BLK_WRITE % mmc->erase_grp_size))
+		return 0;
+
+	return fb_mmc_blk_write(dev_desc, blk, blkcnt, NULL);
+}
+
 static void write_raw_image(struct blk_desc *dev_desc,
 			    struct disk_partition *info, const char *part_name,
 			    void *buffer, u32 download_bytes, char *response)
@@ -620,6 +635,7 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 		sparse.size = info.size;
 		sparse.write = fb_mmc_sparse_write;
 		sparse.reserve = fb_mmc_sparse_reserve;
+		sparse.write_zeroes = fb_mmc_sparse_write_zeroes;
 		sparse.mssg = fastboot_fail;
 
 		printf("Flashing sparse image at offset " LBAFU "\n",
@@ -636,6 +652,178 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
 	}
 }
 
+#if CONFIG_IS_ENABLED(FASTBOOT_FLASH_STREAM)
+/**
+ * struct fb_mmc_stream - Partition written by a streamed download
+ *
+ * @name: Name of the partition
+ * @dev_desc: Device holding the partition
+ * @info: Partition information
+ * @sparse_priv: Private data for @sparse
+ * @sparse: Storage for a sparse image
+ * @ss: Sparse image state, or NULL if the image is raw
+ * @size: Size of the image, in bytes
+ * @done: Number of bytes of the image written so far
+ */
+static struct fb_mmc_stream {
+	const char *name;
+	struct blk_desc *dev_desc;
+	struct disk_partition info;
+	struct fb_mmc_sparse sparse_priv;
+	struct sparse_storage sparse;
+	struct sparse_stream *ss;
+	u32 size;
+	u32 done;
+} fb_mmc_stream;
+
+/**
+ * fastboot_mmc_stream_start() - Prepare to write an image as it arrives
+ *
+ * @cmd: Named partition to write image to, which must stay valid until
+ *	fastboot_mmc_stream_end() is called
+ * @size: Size of the image, in bytes
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error
+ */
+int fastboot_mmc_stream_start(const char *cmd, u32 size, char *response)
+{
+	struct fb_mmc_stream *st = &fb_mmc_stream;
+	int ret;
+
+	memset(st, '\0', sizeof(*st));
+	st->name = cmd;
+	st->size = size;
+
+#if IS_ENABLED(CONFIG_FASTBOOT_MMC_USER_SUPPORT)
+	if (strcmp(cmd, CONFIG_FASTBOOT_MMC_USER_NAME) == 0) {
+		st->dev_desc = fastboot_mmc_get_dev(response);
+		if (!st->dev_desc)
+			return -ENODEV;
+
+		strlcpy((char *)&st->info.name, cmd, sizeof(st->info.name));
+		st->info.size	= st->dev_desc->lba;
+		st->info.blksz	= st->dev_desc->blksz;
+	}
+#endif
+
+	if (!st->info.name[0]) {
+		ret = fastboot_mmc_get_part_info(cmd, &st->dev_desc, &st->info,
+						 response);
+		if (ret < 0)
+			return ret;
+	}
+
+	/* A sparse image is never larger than what it expands to */
+	if (DIV_ROUND_UP(size, st->info.blksz) > st->info.size) {
+		pr_err("too large for partition: '%s'\n", cmd);
+		fastboot_fail("too large for partition", response);
+		return -EFBIG;
+	}
+
+	return 0;
+}
+
+/**
+ * fastboot_mmc_stream_write() - Write the next part of a streamed image
+ *
+ * @buf: Pointer to image data. If @len is not a whole number of blocks this
+ *	must be the last part, and @buf must have room to pad it to one.
+ * @len: Size of the data
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error
+ */
+int fastboot_mmc_stream_write(void *buf, u32 len, char *response)
+{
+	struct fb_mmc_stream *st = &fb_mmc_stream;
+	struct disk_partition *info = &st->info;
+	lbaint_t blkcnt, blks;
+	u32 pad;
+
+	if (!st->done) {
+		if (len >= sizeof(sparse_header_t) && is_sparse_image(buf)) {
+			st->sparse_priv.dev_desc = st->dev_desc;
+			st->sparse.blksz = info->blksz;
+			st->sparse.start = info->start;
+			st->sparse.size = info->size;
+			st->sparse.write = fb_mmc_sparse_write;
+			st->sparse.reserve = fb_mmc_sparse_reserve;
+			st->sparse.write_zeroes = fb_mmc_sparse_write_zeroes;
+			st->sparse.mssg = fastboot_fail;
+			st->sparse.priv = &st->sparse_priv;
+
+			printf("Flashing sparse image at offset " LBAFU "\n",
+			       st->sparse.start);
+			st->ss = sparse_stream_start(&st->sparse, st->name,
+						     response);
+			if (!st->ss)
+				return -ENOMEM;
+		} else {
+			puts("Flashing Raw Image\n");
+		}
+	}
+
+	if (st->ss) {
+		st->done += len;
+		return sparse_stream_write(st->ss, buf, len, response) ?
+			-EIO : 0;
+	}
+
+	blkcnt = lldiv(len, info->blksz);
+	pad = len - blkcnt * info->blksz;
+	if (pad) {
+		if (st->done + len != st->size) {
+			fastboot_fail("unaligned stream write", response);
+			return -EINVAL;
+		}
+		memset(buf + len, '\0', info->blksz - pad);
+		blkcnt++;
+	}
+
+	blks = fb_mmc_blk_write(st->dev_desc,
+				info->start + lldiv(st->done, info->blksz),
+				blkcnt, buf);
+	if (blks != blkcnt) {
+		pr_err("failed writing to device %d\n", st->dev_desc->devnum);
+		fastboot_fail("failed writing to device", response);
+		return -EIO;
+	}
+	st->done += len;
+
+	return 0;
+}
+
+/**
+ * fastboot_mmc_stream_end() - Finish writing a streamed image
+ *
+ * This must be called after fastboot_mmc_stream_start(), even if writing
+ * failed, to free resources. It writes OKAY to @response if the whole image
+ * was written.
+ *
+ * @response: Pointer to fastboot response buffer
+ */
+void fastboot_mmc_stream_end(char *response)
+{
+	struct fb_mmc_stream *st = &fb_mmc_stream;
+	int ret;
+
+	if (st->ss) {
+		ret = sparse_stream_end(st->ss, response);
+		st->ss = NULL;
+		if (ret)
+			return;
+	} else if (st->done == st->size) {
+		printf("........ wrote %u bytes to '%s'\n", st->done,
+		       st->name);
+	}
+
+	if (st->done != st->size) {
+		fastboot_fail("image is truncated", response);
+		return;
+	}
+	fastboot_okay(NULL, response);
+}
+#endif
+
 /**
  * fastboot_mmc_flash_erase() - Erase eMMC for fastboot
  *
@@ -77,6 +77,10 @@ static int sandbox_p2sb_emul_read_config(const struct udevice *emul,
 	case PCI_CLASS_CODE:
 		*valuep = SANDBOX_PCI_CLASS_CODE;
 		break;
+	case PCI_CLASS_REVISION:
+		*valuep = (SANDBOX_PCI_CLASS_CODE << 24) |
+				(SANDBOX_PCI_CLASS_SUB_CODE << 16);
+		break;
 	case PCI_BASE_ADDRESS_0:
 	case PCI_BASE_ADDRESS_1:
 	case PCI_BASE_ADDRESS_2:
@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * eMMC Command Queue Host Controller Interface (CQHCI)
+ *
+ * The engine is polled rather than interrupt driven: tasks are queued by
+ * ringing the doorbell and reaped from the task completion notification
+ * register. Only 64-bit task descriptors and 32-bit data addresses are used.
+ */
+
+#define LOG_CATEGORY UCLASS_MMC
+
+#include <cpu_func.h>
+#include <cqhci.h>
+#include <log.h>
+#include <malloc.h>
+#include <mmc.h>
+#include <time.h>
+#include <asm/cache.h>
+#include <asm/io.h>
+#include <linux/errno.h>
+#include <linux/kernel.h>
+
+/* Each slot is a task descriptor followed by a link descriptor */
+#define CQHCI_SLOT_WORDS	2
+#define CQHCI_DESC_SIZE		(CQHCI_NUM_SLOTS * CQHCI_SLOT_WORDS * sizeof(u64))
+#define CQHCI_TRANS_SIZE	(CQHCI_NUM_SLOTS * CQHCI_MAX_SEGS * sizeof(u64))
+
+/* Give up if no task completes for this long */
+#define CQHCI_TIMEOUT_US	1000000
+#define CQHCI_HALT_TIMEOUT_MS	100
+
+static inline u32 cqhci_readl(struct cqhci_host *cq, int reg)
+{
+	return readl(cq->base + reg);
+}
+
+static inline void cqhci_writel(struct cqhci_host *cq, u32 val, int reg)
+{
+	writel(val, cq->base + reg);
+}
+
+int cqhci_init(struct cqhci_host *cq, struct mmc *mmc, void __iomem *base)
+{
+	int ret;
+
+	cq->base = base;
+	cq->mmc = mmc;
+	cq->desc = memalign(ARCH_DMA_MINALIGN,
+			    ALIGN(CQHCI_DESC_SIZE, ARCH_DMA_MINALIGN));
+	cq->trans = memalign(ARCH_DMA_MINALIGN,
+			     ALIGN(CQHCI_TRANS_SIZE, ARCH_DMA_MINALIGN));
+	if (!cq->desc || !cq->trans) {
+		ret = -ENOMEM;
+		goto err;
+	}
+
+	if (upper_32_bits((u64)virt_to_phys(cq->desc) + CQHCI_DESC_SIZE) ||
+	    upper_32_bits((u64)virt_to_phys(cq->trans) + CQHCI_TRANS_SIZE)) {
+		ret = -EINVAL;
+		goto err;
+	}
+	memset(cq->desc, '\0', CQHCI_DESC_SIZE);
+
+	return 0;
+err:
+	free(cq->desc);
+	free(cq->trans);
+
+	return ret;
+}
+
+int cqhci_enable(struct cqhci_host *cq)
+{
+	u32 cfg;
+
+	cq->num_slots = min_t(int, cq->mmc->cmdq_depth, CQHCI_NUM_SLOTS);
+	if (!cq->num_slots)
+		return -ENOSYS;
+
+	/* The configuration must not be changed while the engine is on */
+	cfg = cqhci_readl(cq, CQHCI_CFG);
+	cfg &= ~(CQHCI_ENABLE | CQHCI_DCMD | CQHCI_TASK_DESC_SZ);
+	cqhci_writel(cq, cfg, CQHCI_CFG);
+
+	cqhci_writel(cq, lower_32_bits(virt_to_phys(cq->desc)), CQHCI_TDLBA);
+	cqhci_writel(cq, 0, CQHCI_TDLBAU);
+	cqhci_writel(cq, cq->mmc->rca, CQHCI_SSC2);
+
+	/* Latch status for polling but do not raise interrupts */
+	cqhci_writel(cq, CQHCI_IS_MASK, CQHCI_ISTE);
+	cqhci_writel(cq, 0, CQHCI_ISGE);
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_IS), CQHCI_IS);
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_TCN), CQHCI_TCN);
+
+	cqhci_writel(cq, cfg | CQHCI_ENABLE, CQHCI_CFG);
+	if (cqhci_readl(cq, CQHCI_CTL) & CQHCI_HALT)
+		cqhci_writel(cq, 0, CQHCI_CTL);
+
+	return 0;
+}
+
+static int cqhci_halt(struct cqhci_host *cq)
+{
+	ulong start = get_timer(0);
+
+	cqhci_writel(cq, CQHCI_HALT, CQHCI_CTL);
+	while (!(cqhci_readl(cq, CQHCI_CTL) & CQHCI_HALT)) {
+		if (get_timer(start) > CQHCI_HALT_TIMEOUT_MS)
+			return -ETIMEDOUT;
+	}
+
+	return 0;
+}
+
+int cqhci_disable(struct cqhci_host *cq)
+{
+	int ret = 0;
+
+	/* Tasks are only left behind after an error; throw them away */
+	if (cqhci_readl(cq, CQHCI_TDBR)) {
+		ret = cqhci_halt(cq);
+		cqhci_writel(cq, CQHCI_HALT | CQHCI_CLEAR_ALL_TASKS, CQHCI_CTL);
+	}
+
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_CFG) & ~CQHCI_ENABLE, CQHCI_CFG);
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_TCN), CQHCI_TCN);
+	cqhci_writel(cq, cqhci_readl(cq, CQHCI_IS), CQHCI_IS);
+	cqhci_writel(cq, 0, CQHCI_ISTE);
+
+	return ret;
+}
+
+/* Fill in the descriptors for one task and hand them to the engine */
+static void cqhci_prep_task(struct cqhci_host *cq, int tag, lbaint_t start,
+			    lbaint_t blkcnt, ulong addr, bool write)
+{
+	u64 *task = &cq->desc[tag * CQHCI_SLOT_WORDS];
+	u64 *trans = &cq->trans[tag * CQHCI_MAX_SEGS];
+	lbaint_t done, seg;
+	int i = 0;
+
+	for (done = 0; done < blkcnt; done += seg, i++) {
+		seg = min_t(lbaint_t, blkcnt - done, CQHCI_SEG_BLOCKS);
+		trans[i] = cpu_to_le64(CQHCI_VALID |
+				       CQHCI_ACT(CQHCI_ACT_TRAN) |
+				       CQHCI_DAT_LENGTH(seg * MMC_MAX_BLOCK_LEN) |
+				       CQHCI_DAT_ADDR(addr +
+						      done * MMC_MAX_BLOCK_LEN));
+	}
+	trans[i - 1] |= cpu_to_le64(CQHCI_END);
+
+	task[0] = cpu_to_le64(CQHCI_VALID | CQHCI_END | CQHCI_INT |
+			      CQHCI_ACT(CQHCI_ACT_TASK) |
+			      (write ? 0 : CQHCI_DATA_DIR) |
+			      CQHCI_BLK_COUNT(blkcnt) | CQHCI_BLK_ADDR(start));
+	task[1] = cpu_to_le64(CQHCI_VALID | CQHCI_ACT(CQHCI_ACT_LINK) |
+			      CQHCI_DAT_ADDR(virt_to_phys(trans)));
+
+	flush_dcache_range((ulong)trans,
+			   (ulong)trans + CQHCI_MAX_SEGS * sizeof(u64));
+	flush_dcache_range((ulong)cq->desc, (ulong)cq->desc + CQHCI_DESC_SIZE);
+}
+
+/* Queue tasks for the rest of the transfer in any free slots */
+static void cqhci_fill_slots(struct cqhci_host *cq)
+{
+	struct cqhci_xfer *xfer = &cq->xfer;
+	lbaint_t cnt;
+	int tag;
+
+	for (tag = 0; tag < cq->num_slots && xfer->queued < xfer->blkcnt;
+	     tag++) {
+		if (xfer->busy & BIT(tag))
+			continue;
+		cnt = min_t(lbaint_t, xfer->blkcnt - xfer->queued,
+			    CQHCI_TASK_BLOCKS);
+		cqhci_prep_task(cq, tag, xfer->start + xfer->queued, cnt,
+				xfer->addr + xfer->queued * MMC_MAX_BLOCK_LEN,
+				xfer->write);
+		cqhci_writel(cq, BIT(tag), CQHCI_TDBR);
+		xfer->busy |= BIT(tag);
+		xfer->queued += cnt;
+	}
+}
+
+int cqhci_xfer_start(struct cqhci_host *cq, lbaint_t start, lbaint_t blkcnt,
+		     void *buf, bool write)
+{
+	struct cqhci_xfer *xfer = &cq->xfer;
+	ulong addr = virt_to_phys(buf);
+	ulong len = blkcnt * MMC_MAX_BLOCK_LEN;
+
+	if (!IS_ALIGNED((ulong)buf, ARCH_DMA_MINALIGN) ||
+	    upper_32_bits((u64)addr + len - 1))
+		return -EINVAL;
+
+	flush_dcache_range((ulong)buf, (ulong)buf + len);
+
+	xfer->start = start;
+	xfer->blkcnt = blkcnt;
+	xfer->queued = 0;
+	xfer->addr = addr;
+	xfer->buf = buf;
+	xfer->busy = 0;
+	xfer->write = write;
+	xfer->last = timer_get_us();
+	cqhci_fill_slots(cq);
+
+	return 0;
+}
+
+static void cqhci_xfer_end(struct cqhci_host *cq)
+{
+	struct cqhci_xfer *xfer = &cq->xfer;
+
+	if (!xfer->write)
+		invalidate_dcache_range((ulong)xfer->buf, (ulong)xfer->buf +
+					xfer->blkcnt * MMC_MAX_BLOCK_LEN);
+	xfer->blkcnt = 0;
+}
+
+int cqhci_xfer_poll(struct cqhci_host *cq)
+{
+	struct cqhci_xfer *xfer = &cq->xfer;
+	u32 done, status;
+
+	status = cqhci_readl(cq, CQHCI_IS);
+	if (status & CQHCI_IS_ERR) {
+		log_debug("Task error: status %#x, TERRI %#x\n", status,
+			  cqhci_readl(cq, CQHCI_TERRI));
+		cqhci_xfer_end(cq);
+		return -EIO;
+	}
+
+	done = cqhci_readl(cq, CQHCI_TCN) & xfer->busy;
+	if (done) {
+		cqhci_writel(cq, done, CQHCI_TCN);
+		cqhci_writel(cq, CQHCI_IS_TCC, CQHCI_IS);
+		xfer->busy &= ~done;
+		xfer->last = timer_get_us();
+		cqhci_fill_slots(cq);
+	} else if (timer_get_us() - xfer->last > CQHCI_TIMEOUT_US) {
+		log_debug("Timeout, %#x still busy\n", xfer->busy);
+		cqhci_xfer_end(cq);
+		return -ETIMEDOUT;
+	}
+
+	if (xfer->queued < xfer->blkcnt || xfer->busy)
+		return -EBUSY;
+	cqhci_xfer_end(cq);
+
+	return 0;
+}
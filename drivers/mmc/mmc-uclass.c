@@ -8,15 +8,19 @@
 #define LOG_CATEGORY UCLASS_MMC
 
 #include <bootdev.h>
+#include <initcall.h>
 #include <log.h>
 #include <mmc.h>
 #include <dm.h>
+#include <asm/global_data.h>
 #include <dm/device-internal.h>
 #include <dm/device_compat.h>
 #include <dm/lists.h>
 #include <linux/compat.h>
 #include "mmc_private.h"
 
+DECLARE_GLOBAL_DATA_PTR;
+
 static int dm_mmc_get_b_max(struct udevice *dev, void *dst, lbaint_t blkcnt)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
@@ -165,6 +169,55 @@ int mmc_hs400_prepare_ddr(struct mmc *mmc)
 	return dm_mmc_hs400_prepare_ddr(mmc->dev);
 }
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+static int dm_mmc_cqe_enable(struct udevice *dev, bool enable)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (ops->cqe_enable)
+		return ops->cqe_enable(dev, enable);
+
+	return -ENOSYS;
+}
+
+int mmc_cqe_enable(struct mmc *mmc, bool enable)
+{
+	return dm_mmc_cqe_enable(mmc->dev, enable);
+}
+
+static int dm_mmc_cqe_xfer_start(struct udevice *dev, lbaint_t start,
+				 lbaint_t blkcnt, void *buf, bool write)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (ops->cqe_xfer_start)
+		return ops->cqe_xfer_start(dev, start, blkcnt, buf, write);
+
+	return -ENOSYS;
+}
+
+int mmc_cqe_xfer_start(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+		       void *buf, bool write)
+{
+	return dm_mmc_cqe_xfer_start(mmc->dev, start, blkcnt, buf, write);
+}
+
+static int dm_mmc_cqe_xfer_poll(struct udevice *dev)
+{
+	struct dm_mmc_ops *ops = mmc_get_ops(dev);
+
+	if (ops->cqe_xfer_poll)
+		return ops->cqe_xfer_poll(dev);
+
+	return -ENOSYS;
+}
+
+int mmc_cqe_xfer_poll(struct mmc *mmc)
+{
+	return dm_mmc_cqe_xfer_poll(mmc->dev);
+}
+#endif
+
 static int dm_mmc_host_power_cycle(struct udevice *dev)
 {
 	struct dm_mmc_ops *ops = mmc_get_ops(dev);
@@ -373,6 +426,65 @@ void mmc_do_preinit(void)
 	}
 }
 
+#if CONFIG_IS_ENABLED(MMC_INIT_ASYNC)
+static int mmc_async_start(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret;
+
+	ret = mmc_initialize(gd->bd);
+	if (ret)
+		return ret;
+	ret = uclass_get(UCLASS_MMC, &uc);
+	if (ret)
+		return ret;
+	uclass_foreach_dev(dev, uc) {
+		struct mmc *m = mmc_get_mmc_dev(dev);
+
+		if (!m || m->has_init || m->init_in_progress ||
+		    !device_active(dev) || !mmc_getcd(m))
+			continue;
+		m->init_async = 1;
+		ret = mmc_start_init(m);
+		if (ret)
+			log_debug("%s: cannot start init (err=%dE)\n", dev->name,
+				  ret);
+	}
+
+	return 0;
+}
+
+static int mmc_async_poll(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret, busy = 0;
+
+	ret = uclass_get(UCLASS_MMC, &uc);
+	if (ret)
+		return ret;
+	uclass_foreach_dev(dev, uc) {
+		struct mmc *m = mmc_get_mmc_dev(dev);
+
+		if (!m || !m->init_async)
+			continue;
+		ret = mmc_poll_init(m);
+		if (ret == -EAGAIN) {
+			busy = 1;
+		} else if (ret) {
+			/* Leave it to mmc_init() to try again */
+			log_debug("%s: not ready (err=%dE)\n", dev->name, ret);
+			m->init_async = 0;
+		}
+	}
+
+	return busy ? -EAGAIN : 0;
+}
+
+INITCALL_ASYNC(mmc, NULL, mmc_async_start, mmc_async_poll);
+#endif
+
 #if !defined(CONFIG_XPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
 void print_mmc_devices(char separator)
 {
@@ -472,6 +584,9 @@ static int mmc_select_hwpart(struct udevice *bdev, int hwpart)
 	struct blk_desc *desc = dev_get_uclass_plat(bdev);
 	int ret;
 
+	/* Any command queue read must finish before the card is touched */
+	mmc_cqe_wait(mmc);
+
 	if (desc->hwpart == hwpart)
 		return 0;
 
@@ -521,6 +636,10 @@ static int mmc_blk_remove(struct udevice *dev)
 
 static const struct blk_ops mmc_blk_ops = {
 	.read	= mmc_bread,
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	.read_submit	= mmc_bread_submit,
+	.req_poll	= mmc_breq_poll,
+#endif
 #if CONFIG_IS_ENABLED(MMC_WRITE)
 	.write	= mmc_bwrite,
 	.erase	= mmc_berase,
@@ -9,6 +9,7 @@
 
 #include <config.h>
 #include <blk.h>
+#include <bloblist.h>
 #include <command.h>
 #include <dm.h>
 #include <log.h>
@@ -16,6 +17,7 @@
 #include <errno.h>
 #include <mmc.h>
 #include <part.h>
+#include <spl.h>
 #include <time.h>
 #include <linux/bitops.h>
 #include <linux/delay.h>
@@ -455,11 +457,36 @@ int mmc_send_stop_transmission(struct mmc *mmc, bool write)
 	return mmc_send_cmd(mmc, &cmd, NULL);
 }
 
+bool mmc_use_set_block_count(struct mmc *mmc, lbaint_t blkcnt)
+{
+	/* The count is a 16-bit field */
+	if (blkcnt < 2 || blkcnt > 0xffff || mmc_host_is_spi(mmc) ||
+	    !(mmc->host_caps & MMC_CAP_CMD23))
+		return false;
+
+	return !IS_SD(mmc) || (mmc->scr[0] & SD_SCR_CMD23_SUPPORT);
+}
+
+int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt)
+{
+	struct mmc_cmd cmd;
+
+	cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+	cmd.cmdarg = blkcnt & 0xffff;
+	cmd.resp_type = MMC_RSP_R1;
+
+	return mmc_send_cmd(mmc, &cmd, NULL);
+}
+
 static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 			   lbaint_t blkcnt)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
+	bool sbc = mmc_use_set_block_count(mmc, blkcnt);
+
+	if (sbc && mmc_set_block_count(mmc, blkcnt))
+		return 0;
 
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -481,7 +508,7 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	if (mmc_send_cmd(mmc, &cmd, &data))
 		return 0;
 
-	if (blkcnt > 1) {
+	if (blkcnt > 1 && !sbc) {
 		if (mmc_send_stop_transmission(mmc, false)) {
 #if !defined(CONFIG_XPL_BUILD) || defined(CONFIG_SPL_LIBCOMMON_SUPPORT)
 			log_err("mmc fail to send stop cmd\n");
@@ -503,6 +530,130 @@ static int mmc_get_b_max(struct mmc *mmc, void *dst, lbaint_t blkcnt)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+static int mmc_cqe_failed(struct mmc *mmc, int ret)
+{
+	log_warning("Command queue failed (err=%d), not using it\n", ret);
+	mmc->cmdq_depth = 0;
+
+	return ret;
+}
+
+/* Take the bus back from the engine and switch the card out of CMDQ mode */
+static int mmc_cqe_finish(struct mmc *mmc, int ret)
+{
+	struct mmc_cmd cmd;
+	int err;
+
+	err = mmc_cqe_enable(mmc, false);
+	if (!ret)
+		ret = err;
+
+	if (ret) {
+		/* Drop anything the card still has queued */
+		cmd.cmdidx = MMC_CMD_CMDQ_TASK_MGMT;
+		cmd.cmdarg = MMC_CMDQ_DISCARD_QUEUE;
+		cmd.resp_type = MMC_RSP_R1b;
+		mmc_send_cmd(mmc, &cmd, NULL);
+	}
+
+	err = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 0);
+	if (!ret)
+		ret = err;
+	if (ret)
+		return mmc_cqe_failed(mmc, ret);
+
+	return 0;
+}
+
+/* Switch the card into CMDQ mode and start the transfer on the engine */
+static int mmc_cqe_start(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+			 void *buf, bool write)
+{
+	int ret;
+
+	/* RPMB cannot be accessed in command queue mode */
+	if (!mmc->cmdq_depth || blkcnt < MMC_CQE_MIN_BLOCKS ||
+	    mmc_get_blk_desc(mmc)->hwpart == MMC_PART_RPMB ||
+	    !IS_ALIGNED((ulong)buf, ARCH_DMA_MINALIGN))
+		return -ENOSYS;
+
+	ret = mmc_switch(mmc, EXT_CSD_CMD_SET_NORMAL, EXT_CSD_CMDQ_MODE_EN, 1);
+	if (ret)
+		return mmc_cqe_failed(mmc, ret);
+
+	ret = mmc_cqe_enable(mmc, true);
+	if (!ret)
+		ret = mmc_cqe_xfer_start(mmc, start, blkcnt, buf, write);
+	if (ret)
+		return mmc_cqe_finish(mmc, ret);
+
+	return 0;
+}
+
+int mmc_cqe_rw(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt, void *buf,
+	       bool write)
+{
+	int ret;
+
+	ret = mmc_cqe_start(mmc, start, blkcnt, buf, write);
+	if (ret)
+		return ret;
+
+	do {
+		ret = mmc_cqe_xfer_poll(mmc);
+	} while (ret == -EBUSY);
+
+	return mmc_cqe_finish(mmc, ret);
+}
+
+#if CONFIG_IS_ENABLED(BLK)
+int mmc_bread_submit(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+
+	if (!mmc)
+		return -ENOSYS;
+
+	/*
+	 * Anything unusual, including errors, is left to mmc_bread() which
+	 * reports it
+	 */
+	if (blk_dselect_hwpart(block_dev, block_dev->hwpart) < 0 ||
+	    req->start + req->blkcnt > block_dev->lba ||
+	    mmc_set_blocklen(mmc, mmc->read_bl_len))
+		return -ENOSYS;
+
+	if (mmc_cqe_start(mmc, req->start, req->blkcnt, req->buffer, false))
+		return -ENOSYS;
+	mmc->cqe_req = req;
+
+	return 0;
+}
+
+int mmc_breq_poll(struct udevice *dev, struct blk_req *req)
+{
+	struct blk_desc *block_dev = dev_get_uclass_plat(dev);
+	struct mmc *mmc = find_mmc_device(block_dev->devnum);
+	int ret;
+
+	ret = mmc_cqe_xfer_poll(mmc);
+	if (ret == -EBUSY)
+		return ret;
+
+	mmc->cqe_req = NULL;
+	if (mmc_cqe_finish(mmc, ret))
+		req->done = mmc_bread(dev, req->start, req->blkcnt,
+				      req->buffer);
+	else
+		req->done = req->blkcnt;
+
+	return 0;
+}
+#endif
+#endif
+
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt, void *dst)
 #else
@@ -546,6 +697,9 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 		return 0;
 	}
 
+	if (!mmc_cqe_rw(mmc, start, blkcnt, dst, false))
+		return blkcnt;
+
 	b_max = mmc_get_b_max(mmc, dst, blkcnt);
 
 	do {
@@ -766,10 +920,15 @@ static int mmc_send_op_cond(struct mmc *mmc)
 		if (mmc->ocr & OCR_BUSY)
 			break;
 
+		/* Let the card power up while other things happen */
+		if (mmc->init_async && i)
+			break;
+
 		if (get_timer(start) > timeout)
 			return -ETIMEDOUT;
 		udelay(100);
 	}
+	mmc->op_cond_start = start;
 	mmc->op_cond_pending = 1;
 	return 0;
 }
@@ -783,8 +942,12 @@ static int mmc_complete_op_cond(struct mmc *mmc)
 
 	mmc->op_cond_pending = 0;
 	if (!(mmc->ocr & OCR_BUSY)) {
-		/* Some cards seem to need this */
-		mmc_go_idle(mmc);
+		/*
+		 * Some cards seem to need this, but a card left powering up
+		 * by mmc_send_op_cond() would have to start again
+		 */
+		if (!mmc->init_async)
+			mmc_go_idle(mmc);
 
 		start = get_timer(0);
 		while (1) {
@@ -1774,6 +1937,42 @@ static inline int mmc_set_signal_voltage(struct mmc *mmc, uint signal_voltage)
 }
 #endif
 
+/* Find SPL's record of the eMMC setup, if it was for this card */
+static const struct mmc_handoff *mmc_get_handoff(struct mmc *mmc)
+{
+	const struct mmc_handoff *ho;
+
+	if (!IS_ENABLED(CONFIG_SPL_MMC_HANDOFF) ||
+	    !CONFIG_IS_ENABLED(BLOBLIST) || xpl_phase() <= PHASE_SPL ||
+	    IS_SD(mmc))
+		return NULL;
+
+	ho = bloblist_find(BLOBLISTT_U_BOOT_MMC, sizeof(*ho));
+	if (!ho || memcmp(ho->cid, mmc->cid, sizeof(ho->cid)))
+		return NULL;
+
+	return ho;
+}
+
+/* Record the eMMC setup in SPL, for U-Boot proper */
+static void mmc_save_handoff(struct mmc *mmc)
+{
+	struct mmc_handoff *ho;
+
+	if (!IS_ENABLED(CONFIG_SPL_MMC_HANDOFF) ||
+	    !CONFIG_IS_ENABLED(BLOBLIST) || xpl_phase() != PHASE_SPL ||
+	    IS_SD(mmc) || !mmc->ext_csd)
+		return;
+
+	ho = bloblist_ensure(BLOBLISTT_U_BOOT_MMC, sizeof(*ho));
+	if (!ho)
+		return;
+	memcpy(ho->cid, mmc->cid, sizeof(ho->cid));
+	ho->mode = mmc->selected_mode;
+	ho->bus_width = mmc->bus_width;
+	memcpy(ho->ext_csd, mmc->ext_csd, sizeof(ho->ext_csd));
+}
+
 #if !CONFIG_IS_ENABLED(MMC_TINY)
 static const struct mode_width_tuning sd_modes_by_pref[] = {
 #if CONFIG_IS_ENABLED(MMC_UHS_SUPPORT)
@@ -2153,7 +2352,18 @@ static int mmc_select_hs400es(struct mmc *mmc)
 	    ecbv++) \
 		if ((ddr == ecbv->is_ddr) && (caps & ecbv->cap))
 
-static int mmc_select_mode_and_width(struct mmc *mmc, uint card_caps)
+/**
+ * _mmc_select_mode_and_width() - Select the fastest mode and width that work
+ *
+ * @mmc:	MMC to set up
+ * @card_caps:	Modes and widths to try
+ * @trusted:	true if the modes to try are known to work with this card, so
+ *		there is no need to check the configuration by reading back
+ *		EXT_CSD
+ * Return: 0 if OK, -ENOTSUPP if no mode could be selected
+ */
+static int _mmc_select_mode_and_width(struct mmc *mmc, uint card_caps,
+				      bool trusted)
 {
 	int err = 0;
 	const struct mode_width_tuning *mwt;
@@ -2273,6 +2483,8 @@ static int mmc_select_mode_and_width(struct mmc *mmc, uint card_caps)
 			}
 
 			/* do a transfer to check the configuration */
+			if (trusted)
+				return 0;
 			err = mmc_read_and_compare_ext_csd(mmc);
 			if (!err)
 				return 0;
@@ -2291,6 +2503,27 @@ error:
 
 	return -ENOTSUPP;
 }
+
+static int mmc_select_mode_and_width(struct mmc *mmc, uint card_caps)
+{
+	const struct mmc_handoff *ho = mmc_get_handoff(mmc);
+
+	/* Go straight to the mode which SPL found to work with this card */
+	if (ho && (card_caps & MMC_CAP(ho->mode))) {
+		uint caps = MMC_CAP(ho->mode);
+
+		if (ho->bus_width == 8)
+			caps |= MMC_MODE_8BIT;
+		else if (ho->bus_width == 4)
+			caps |= MMC_MODE_4BIT;
+		else
+			caps |= MMC_MODE_1BIT;
+		if (!_mmc_select_mode_and_width(mmc, card_caps & caps, true))
+			return 0;
+	}
+
+	return _mmc_select_mode_and_width(mmc, card_caps, false);
+}
 #else
 static int sd_select_mode_and_width(struct mmc *mmc, uint card_caps)
 {
@@ -2307,6 +2540,19 @@ static int mmc_select_mode_and_width(struct mmc *mmc, uint card_caps)
 DEFINE_CACHE_ALIGN_BUFFER(u8, ext_csd_bkup, MMC_MAX_BLOCK_LEN);
 #endif
 
+/* Read EXT_CSD, or use the copy which SPL read from this card */
+static int mmc_startup_ext_csd(struct mmc *mmc, u8 *ext_csd)
+{
+	const struct mmc_handoff *ho = mmc_get_handoff(mmc);
+
+	if (ho) {
+		memcpy(ext_csd, ho->ext_csd, MMC_MAX_BLOCK_LEN);
+		return 0;
+	}
+
+	return mmc_send_ext_csd(mmc, ext_csd);
+}
+
 static int mmc_startup_v4(struct mmc *mmc)
 {
 	int err, i;
@@ -2334,7 +2580,7 @@ static int mmc_startup_v4(struct mmc *mmc)
 	if (!mmc->ext_csd)
 		memset(ext_csd_bkup, 0, MMC_MAX_BLOCK_LEN);
 
-	err = mmc_send_ext_csd(mmc, ext_csd);
+	err = mmc_startup_ext_csd(mmc, ext_csd);
 	if (err)
 		goto error;
 
@@ -2348,7 +2594,7 @@ static int mmc_startup_v4(struct mmc *mmc)
 		return 0;
 
 	/* check  ext_csd version and capacity */
-	err = mmc_send_ext_csd(mmc, ext_csd);
+	err = mmc_startup_ext_csd(mmc, ext_csd);
 	if (err)
 		goto error;
 
@@ -2382,6 +2628,14 @@ static int mmc_startup_v4(struct mmc *mmc)
 	if (mmc->version >= MMC_VERSION_4_5)
 		mmc->gen_cmd6_time = ext_csd[EXT_CSD_GENERIC_CMD6_TIME];
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	mmc->cmdq_depth = 0;
+	if (mmc->version >= MMC_VERSION_5_1 && mmc->high_capacity &&
+	    (ext_csd[EXT_CSD_CMDQ_SUPPORT] & EXT_CSD_CMDQ_SUPPORTED))
+		mmc->cmdq_depth = (ext_csd[EXT_CSD_CMDQ_DEPTH] &
+				   EXT_CSD_CMDQ_DEPTH_MASK) + 1;
+#endif
+
 	/* The partition data may be non-zero but it is only
 	 * effective if PARTITION_SETTING_COMPLETED is set in
 	 * EXT_CSD, so ignore any data if this bit is not set,
@@ -2706,6 +2960,7 @@ static int mmc_startup(struct mmc *mmc)
 		return err;
 
 	mmc->best_mode = mmc->selected_mode;
+	mmc_save_handoff(mmc);
 
 	/* Fix the block length for DDR mode */
 	if (mmc->ddr_mode) {
@@ -3022,6 +3277,25 @@ int mmc_start_init(struct mmc *mmc)
 	return err;
 }
 
+int mmc_poll_init(struct mmc *mmc)
+{
+	int err;
+
+	if (!mmc->init_in_progress || !mmc->op_cond_pending ||
+	    (mmc->ocr & OCR_BUSY))
+		return 0;
+
+	err = mmc_send_op_cond_iter(mmc, 1);
+	if (err)
+		return err;
+	if (mmc->ocr & OCR_BUSY)
+		return 0;
+	if (get_timer(mmc->op_cond_start) > 1000)
+		return -ETIMEDOUT;
+
+	return -EAGAIN;
+}
+
 static int mmc_complete_init(struct mmc *mmc)
 {
 	int err = 0;
@@ -3029,6 +3303,7 @@ static int mmc_complete_init(struct mmc *mmc)
 	mmc->init_in_progress = 0;
 	if (mmc->op_cond_pending)
 		err = mmc_complete_op_cond(mmc);
+	mmc->init_async = 0;
 
 	if (!err)
 		err = mmc_startup(mmc);
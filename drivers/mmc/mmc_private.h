@@ -17,6 +17,28 @@ int mmc_poll_for_busy(struct mmc *mmc, int timeout);
 
 int mmc_set_blocklen(struct mmc *mmc, int len);
 
+/**
+ * mmc_use_set_block_count() - check whether to announce a transfer's length
+ *
+ * Multi-block transfers can be preceded by CMD23 (SET_BLOCK_COUNT), after
+ * which the card stops by itself and no CMD12 is needed. This needs support
+ * in both the host and the card.
+ *
+ * @mmc:	MMC device
+ * @blkcnt:	Number of blocks to be transferred
+ * Return: true to use CMD23, false to use CMD12 (or a single-block command)
+ */
+bool mmc_use_set_block_count(struct mmc *mmc, lbaint_t blkcnt);
+
+/**
+ * mmc_set_block_count() - send CMD23 (SET_BLOCK_COUNT)
+ *
+ * @mmc:	MMC device
+ * @blkcnt:	Number of blocks in the following read or write command
+ * Return: 0 if OK, -ve on error
+ */
+int mmc_set_block_count(struct mmc *mmc, lbaint_t blkcnt);
+
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_bread(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 		void *dst);
@@ -132,4 +154,72 @@ int mmc_switch_part(struct mmc *mmc, unsigned int part_num);
  */
 int mmc_switch(struct mmc *mmc, u8 set, u8 index, u8 value);
 
+/* Smallest transfer worth switching the card into command queue mode */
+#define MMC_CQE_MIN_BLOCKS	2048
+
+/**
+ * mmc_cqe_rw() - Transfer blocks using the command queue engine
+ *
+ * Switches the card into command queue mode, hands the transfer to the host
+ * engine and switches back. If the engine fails it is not used again and the
+ * caller is expected to fall back to the synchronous path.
+ *
+ * @mmc:	MMC device
+ * @start:	First block to transfer
+ * @blkcnt:	Number of blocks to transfer
+ * @buf:	Buffer to transfer to or from
+ * @write:	true to write to the card, false to read from it
+ * Return: 0 if OK, -ENOSYS if the transfer is not suitable for command
+ * queueing, other -ve on error
+ */
+#if CONFIG_IS_ENABLED(MMC_CQE)
+int mmc_cqe_rw(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt, void *buf,
+	       bool write);
+#else
+static inline int mmc_cqe_rw(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+			     void *buf, bool write)
+{
+	return -ENOSYS;
+}
+#endif
+
+/**
+ * mmc_bread_submit() - Start an asynchronous read with the command queue
+ *
+ * The read runs on the command queue engine while the caller carries on.
+ * Reads which are not suited to the engine are left to mmc_bread().
+ *
+ * @dev:	Block device to read from
+ * @req:	Read to start
+ * Return: 0 if started, -ENOSYS to have the read done synchronously
+ */
+int mmc_bread_submit(struct udevice *dev, struct blk_req *req);
+
+/**
+ * mmc_breq_poll() - Check an asynchronous read started by mmc_bread_submit()
+ *
+ * If the engine fails, the read is retried synchronously before returning.
+ *
+ * @dev:	Block device being read
+ * @req:	Read to check
+ * Return: 0 if finished, with @req->done set, -EBUSY if still in progress
+ */
+int mmc_breq_poll(struct udevice *dev, struct blk_req *req);
+
+/**
+ * mmc_cqe_wait() - Wait for an asynchronous command queue read to finish
+ *
+ * Nothing else may be sent to the card while the engine owns it, so this
+ * must be called before any other access.
+ *
+ * @mmc:	MMC device
+ */
+static inline void mmc_cqe_wait(struct mmc *mmc)
+{
+#if CONFIG_IS_ENABLED(MMC_CQE) && CONFIG_IS_ENABLED(BLK)
+	if (mmc->cqe_req)
+		blk_req_wait(mmc->cqe_req);
+#endif
+}
+
 #endif /* _MMC_PRIVATE_H_ */
@@ -65,6 +65,24 @@ err_out:
 	return err;
 }
 
+bool mmc_erase_reads_zero(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt)
+{
+	u32 start_rem, blkcnt_rem;
+
+	/* SD cards report this in the SCR, which is not kept */
+	if (IS_SD(mmc) || !mmc->ext_csd ||
+	    mmc->ext_csd[EXT_CSD_ERASED_MEM_CONT])
+		return false;
+	if (mmc->can_trim)
+		return true;
+
+	/* Otherwise the erase would be widened to whole erase groups */
+	div_u64_rem(start, mmc->erase_grp_size, &start_rem);
+	div_u64_rem(blkcnt, mmc->erase_grp_size, &blkcnt_rem);
+
+	return !start_rem && !blkcnt_rem;
+}
+
 #if CONFIG_IS_ENABLED(BLK)
 ulong mmc_berase(struct udevice *dev, lbaint_t start, lbaint_t blkcnt)
 #else
@@ -144,6 +162,7 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	struct mmc_cmd cmd;
 	struct mmc_data data;
 	int timeout_ms = 1000;
+	bool sbc;
 
 	if ((start + blkcnt) > mmc_get_blk_desc(mmc)->lba) {
 		printf("MMC: block number 0x" LBAF " exceeds max(0x" LBAF ")\n",
@@ -153,7 +172,14 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 
 	if (blkcnt == 0)
 		return 0;
-	else if (blkcnt == 1)
+
+	sbc = mmc_use_set_block_count(mmc, blkcnt);
+	if (sbc && mmc_set_block_count(mmc, blkcnt)) {
+		printf("mmc fail to set block count\n");
+		return 0;
+	}
+
+	if (blkcnt == 1)
 		cmd.cmdidx = MMC_CMD_WRITE_SINGLE_BLOCK;
 	else
 		cmd.cmdidx = MMC_CMD_WRITE_MULTIPLE_BLOCK;
@@ -176,9 +202,10 @@ static ulong mmc_write_blocks(struct mmc *mmc, lbaint_t start,
 	}
 
 	/* SPI multiblock writes terminate using a special
-	 * token, not a STOP_TRANSMISSION request.
+	 * token, not a STOP_TRANSMISSION request. Nor is one needed
+	 * when the block count was set in advance.
 	 */
-	if (!mmc_host_is_spi(mmc) && blkcnt > 1) {
+	if (!mmc_host_is_spi(mmc) && blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -221,9 +248,24 @@ ulong mmc_bwrite(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	if (mmc_set_blocklen(mmc, mmc->write_bl_len))
 		return 0;
 
+	if (!mmc_cqe_rw(mmc, start, blkcnt, (void *)src, true))
+		return blkcnt;
+
 	do {
 		cur = (blocks_todo > mmc->cfg->b_max) ?
 			mmc->cfg->b_max : blocks_todo;
+		/*
+		 * Split large writes at erase-group boundaries, so that each
+		 * request covers whole groups where possible. Cards program
+		 * these much faster than writes which straddle two groups.
+		 */
+		if (cur < blocks_todo && mmc->erase_grp_size > 1 &&
+		    cur >= mmc->erase_grp_size) {
+			u32 rem;
+
+			div_u64_rem(start + cur, mmc->erase_grp_size, &rem);
+			cur -= rem;
+		}
 		if (mmc_write_blocks(mmc, start, cur, src) != cur)
 			return 0;
 		blocks_todo -= cur;
@@ -57,14 +57,52 @@ static uint rockchip_dwmmc_get_mmc_clk(struct dwmci_host *host, uint freq)
 	return freq;
 }
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA_HOT) && defined(DTD_HOT_rockchip_rk3288_dw_mshc)
+/* Set up the host from the data generated by dtoc, rather than the DT */
+static int rockchip_dwmmc_hot_to_plat(struct udevice *dev)
+{
+	const struct dtd_rockchip_rk3288_dw_mshc *dtplat;
+	struct rockchip_dwmmc_priv *priv = dev_get_priv(dev);
+	struct dwmci_host *host = &priv->host;
+
+	dtplat = dev_get_hot_plat(dev);
+	if (!dtplat)
+		return -ENOENT;
+
+	host->name = dev->name;
+	host->ioaddr = map_sysmem(dtplat->reg[0], dtplat->reg[1]);
+	host->buswidth = dtplat->bus_width;
+	host->get_mmc_clk = rockchip_dwmmc_get_mmc_clk;
+	host->priv = dev;
+	/* These are not in every node, so there may be no struct member */
+	host->dev_index = dev_read_bool(dev, "non-removable") ? 0 : 1;
+	priv->fifo_mode = dev_read_bool(dev, "fifo-mode");
+	priv->fifo_depth = dtplat->fifo_depth;
+	priv->minmax[0] = 400000;  /* 400 kHz */
+	priv->minmax[1] = dtplat->max_frequency;
+
+	return 0;
+}
+#else
+static int rockchip_dwmmc_hot_to_plat(struct udevice *dev)
+{
+	return -ENOENT;
+}
+#endif
+
 static int rockchip_dwmmc_of_to_plat(struct udevice *dev)
 {
 	struct rockchip_dwmmc_priv *priv = dev_get_priv(dev);
 	struct dwmci_host *host = &priv->host;
+	int ret;
 
 	if (!CONFIG_IS_ENABLED(OF_REAL))
 		return 0;
 
+	ret = rockchip_dwmmc_hot_to_plat(dev);
+	if (ret != -ENOENT)
+		return ret;
+
 	host->name = dev->name;
 	host->ioaddr = dev_read_addr_ptr(dev);
 	host->buswidth = dev_read_u32_default(dev, "bus-width", 4);
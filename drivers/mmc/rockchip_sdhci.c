@@ -6,6 +6,7 @@
  */
 
 #include <clk.h>
+#include <cqhci.h>
 #include <dm.h>
 #include <dm/ofnode.h>
 #include <dt-structs.h>
@@ -89,6 +90,11 @@
 #define ROCKCHIP_MAX_CLKS		3
 
 #define FLAG_INVERTER_FLAG_IN_RXCLK	BIT(0)
+#define FLAG_HAS_CQE			BIT(1)
+
+/* Offset of the command queue registers, from the vendor area 2 pointer */
+#define DWCMSHC_P_VENDOR_AREA2		0xea
+#define DWCMSHC_AREA2_MASK		GENMASK(11, 0)
 
 struct rockchip_sdhc_plat {
 	struct mmc_config cfg;
@@ -107,6 +113,9 @@ struct rockchip_sdhc {
 	void *base;
 	struct rockchip_emmc_phy *phy;
 	struct clk emmc_clk;
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	struct cqhci_host cqhci;
+#endif
 };
 
 struct sdhci_data {
@@ -612,6 +621,20 @@ static int rockchip_sdhci_probe(struct udevice *dev)
 	    dev_read_bool(dev, "u-boot,spl-fifo-mode"))
 		host->flags &= ~USE_DMA;
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	if ((data->flags & FLAG_HAS_CQE) && dev_read_bool(dev, "supports-cqe")) {
+		u16 area2 = sdhci_readw(host, DWCMSHC_P_VENDOR_AREA2) &
+			    DWCMSHC_AREA2_MASK;
+
+		ret = cqhci_init(&priv->cqhci, host->mmc, host->ioaddr + area2);
+		if (!ret)
+			host->cqe = &priv->cqhci;
+		else
+			printf("%s: Command queue unavailable: %d\n",
+			       __func__, ret);
+	}
+#endif
+
 	return sdhci_probe(dev);
 }
 
@@ -651,7 +674,7 @@ static const struct sdhci_data rk3568_data = {
 	.set_ios_post = rk3568_sdhci_set_ios_post,
 	.set_clock = rk3568_sdhci_set_clock,
 	.config_dll = rk3568_sdhci_config_dll,
-	.flags = FLAG_INVERTER_FLAG_IN_RXCLK,
+	.flags = FLAG_INVERTER_FLAG_IN_RXCLK | FLAG_HAS_CQE,
 	.hs200_txclk_tapnum = DLL_TXCLK_TAPNUM_DEFAULT,
 	.hs400_txclk_tapnum = 0x8,
 };
@@ -660,6 +683,7 @@ static const struct sdhci_data rk3588_data = {
 	.set_ios_post = rk3568_sdhci_set_ios_post,
 	.set_clock = rk3568_sdhci_set_clock,
 	.config_dll = rk3568_sdhci_config_dll,
+	.flags = FLAG_HAS_CQE,
 	.hs200_txclk_tapnum = DLL_TXCLK_TAPNUM_DEFAULT,
 	.hs400_txclk_tapnum = 0x9,
 };
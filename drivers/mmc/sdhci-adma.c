@@ -7,6 +7,7 @@
 #include <sdhci.h>
 #include <malloc.h>
 #include <asm/cache.h>
+#include <linux/dma-mapping.h>
 
 void sdhci_adma_write_desc(struct sdhci_host *host, void **next_desc,
 			   dma_addr_t addr, int len, bool end)
@@ -70,18 +71,28 @@ void sdhci_prepare_adma_table(struct sdhci_host *host,
 
 	__sdhci_adma_write_desc(host, &next_desc, addr, trans_bytes, true);
 
-	flush_cache((phys_addr_t)table,
-		    ROUND(next_desc - (void *)table,
-			  ARCH_DMA_MINALIGN));
+	if (!dma_coherent_is_uncached(table))
+		flush_cache((phys_addr_t)table,
+			    ROUND(next_desc - (void *)table,
+				  ARCH_DMA_MINALIGN));
 }
 
 /**
  * sdhci_adma_init() - initialize the ADMA descriptor table
  *
+ * The table comes from non-cached memory if available, so that it need not be
+ * flushed before each transfer.
+ *
  * Return: pointer to the allocated descriptor table or NULL in case of an
  * error.
  */
 struct sdhci_adma_desc *sdhci_adma_init(void)
 {
+#ifdef CONFIG_SYS_NONCACHED_MEMORY
+	void *table = (void *)noncached_alloc(ADMA_TABLE_SZ, ARCH_DMA_MINALIGN);
+
+	if (table)
+		return table;
+#endif
 	return memalign(ARCH_DMA_MINALIGN, ADMA_TABLE_SZ);
 }
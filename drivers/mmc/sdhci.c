@@ -8,6 +8,7 @@
  */
 
 #include <cpu_func.h>
+#include <cqhci.h>
 #include <dm.h>
 #include <errno.h>
 #include <log.h>
@@ -838,6 +839,59 @@ static int sdhci_set_enhanced_strobe(struct udevice *dev)
 }
 #endif
 
+#if CONFIG_IS_ENABLED(MMC_CQE)
+static int sdhci_cqe_enable(struct udevice *dev, bool enable)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+	u8 ctrl;
+	int ret;
+
+	if (!host->cqe)
+		return -ENOSYS;
+
+	if (!enable) {
+		ret = cqhci_disable(host->cqe);
+		sdhci_reset(host, SDHCI_RESET_CMD);
+		sdhci_reset(host, SDHCI_RESET_DATA);
+		sdhci_writel(host, SDHCI_INT_DATA_MASK | SDHCI_INT_CMD_MASK,
+			     SDHCI_INT_ENABLE);
+		return ret;
+	}
+
+	/* The engine moves data with the host's ADMA2 unit */
+	ctrl = sdhci_readb(host, SDHCI_HOST_CONTROL);
+	ctrl &= ~SDHCI_CTRL_DMA_MASK;
+	ctrl |= SDHCI_CTRL_ADMA32;
+	sdhci_writeb(host, ctrl, SDHCI_HOST_CONTROL);
+	sdhci_writew(host, SDHCI_MAKE_BLKSZ(SDHCI_DEFAULT_BOUNDARY_ARG,
+					    MMC_MAX_BLOCK_LEN),
+		     SDHCI_BLOCK_SIZE);
+	sdhci_writeb(host, 0xe, SDHCI_TIMEOUT_CONTROL);
+	sdhci_writel(host, SDHCI_INT_CQE | SDHCI_INT_ERROR_MASK,
+		     SDHCI_INT_ENABLE);
+
+	return cqhci_enable(host->cqe);
+}
+
+static int sdhci_cqe_xfer_start(struct udevice *dev, lbaint_t start,
+				lbaint_t blkcnt, void *buf, bool write)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	return cqhci_xfer_start(host->cqe, start, blkcnt, buf, write);
+}
+
+static int sdhci_cqe_xfer_poll(struct udevice *dev)
+{
+	struct mmc *mmc = mmc_get_mmc_dev(dev);
+	struct sdhci_host *host = mmc->priv;
+
+	return cqhci_xfer_poll(host->cqe);
+}
+#endif
+
 const struct dm_mmc_ops sdhci_ops = {
 	.send_cmd	= sdhci_send_command,
 	.set_ios	= sdhci_set_ios,
@@ -850,6 +904,11 @@ const struct dm_mmc_ops sdhci_ops = {
 #if CONFIG_IS_ENABLED(MMC_HS400_ES_SUPPORT)
 	.set_enhanced_strobe = sdhci_set_enhanced_strobe,
 #endif
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	.cqe_enable	= sdhci_cqe_enable,
+	.cqe_xfer_start	= sdhci_cqe_xfer_start,
+	.cqe_xfer_poll	= sdhci_cqe_xfer_poll,
+#endif
 };
 #else
 static const struct mmc_ops sdhci_ops = {
@@ -1015,6 +1074,9 @@ int sdhci_setup_cfg(struct mmc_config *cfg, struct sdhci_host *host,
 	if (caps_1 & SDHCI_SUPPORT_DDR50)
 		cfg->host_caps |= MMC_CAP(UHS_DDR50);
 
+	if (!(host->quirks & SDHCI_QUIRK_BROKEN_CMD23))
+		cfg->host_caps |= MMC_CAP_CMD23;
+
 	if (host->host_caps)
 		cfg->host_caps |= host->host_caps;
 
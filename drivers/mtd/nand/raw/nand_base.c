@@ -2282,6 +2282,66 @@ static int nand_setup_read_retry(struct mtd_info *mtd, int retry_mode)
 	return chip->setup_read_retry(mtd, retry_mode);
 }
 
+/*
+ * READ CACHE needs the generic command function, which knows to wait for the
+ * chip after 31h/3Fh, and the core sending the page read commands
+ */
+static bool nand_cont_read_allowed(struct nand_chip *chip,
+				   struct mtd_oob_ops *ops)
+{
+	return (chip->options & NAND_CACHE_READ) &&
+	       chip->cmdfunc == nand_command_lp &&
+	       nand_standard_page_accessors(&chip->ecc) &&
+	       chip->read_retries <= 1 && !ops->oobbuf;
+}
+
+/*
+ * Start a READ CACHE sequence over the whole pages from @page onwards, stopping
+ * at the end of the block, if there are at least two of them
+ */
+static void nand_cont_read_begin(struct nand_chip *chip, int page,
+				 u32 readlen)
+{
+	int pages_per_block = 1 << (chip->phys_erase_shift - chip->page_shift);
+	int last = page + (readlen >> chip->page_shift) - 1;
+
+	last = min(last, page | (pages_per_block - 1));
+	if (last <= page)
+		return;
+
+	chip->cont_read.ongoing = true;
+	chip->cont_read.first_page = page;
+	chip->cont_read.last_page = last;
+
+	/* every page in the sequence must come from the chip */
+	chip->pagebuf = -1;
+}
+
+/*
+ * Get a page ready for data output, as part of a READ CACHE sequence if one
+ * is in progress. Each READ CACHE SEQUENTIAL makes the previous page
+ * available while the chip reads the next one from the array.
+ */
+static int nand_read_page_cont_op(struct nand_chip *chip, int page)
+{
+	struct mtd_info *mtd = nand_to_mtd(chip);
+
+	if (!chip->cont_read.ongoing)
+		return nand_read_page_op(chip, page, 0, NULL, 0);
+
+	if (page == chip->cont_read.first_page)
+		chip->cmdfunc(mtd, NAND_CMD_READ0, 0, page);
+
+	if (page == chip->cont_read.last_page) {
+		chip->cmdfunc(mtd, NAND_CMD_READCACHEEND, -1, -1);
+		chip->cont_read.ongoing = false;
+	} else {
+		chip->cmdfunc(mtd, NAND_CMD_READCACHESEQ, -1, -1);
+	}
+
+	return 0;
+}
+
 /**
  * nand_do_read_ops - [INTERN] Read data with ECC
  * @mtd: MTD device structure
@@ -2305,6 +2365,7 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 	unsigned int max_bitflips = 0;
 	int retry_mode = 0;
 	bool ecc_fail = false;
+	bool cont_read = nand_cont_read_allowed(chip, ops);
 
 	chipnr = (int)(from >> chip->chip_shift);
 	chip->select_chip(mtd, chipnr);
@@ -2333,6 +2394,9 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 		else
 			use_bufpoi = 0;
 
+		if (cont_read && !chip->cont_read.ongoing && !col)
+			nand_cont_read_begin(chip, page, readlen);
+
 		/* Is the current page in the buffer? */
 		if (realpage != chip->pagebuf || oob) {
 			bufpoi = use_bufpoi ? chip->buffers->databuf : buf;
@@ -2343,7 +2407,7 @@ static int nand_do_read_ops(struct mtd_info *mtd, loff_t from,
 
 read_retry:
 			if (nand_standard_page_accessors(&chip->ecc)) {
-				ret = nand_read_page_op(chip, page, 0, NULL, 0);
+				ret = nand_read_page_cont_op(chip, page);
 				if (ret)
 					break;
 			}
@@ -2456,6 +2520,12 @@ read_retry:
 			chip->select_chip(mtd, chipnr);
 		}
 	}
+
+	/* Finish a READ CACHE sequence cut short by an error */
+	if (chip->cont_read.ongoing) {
+		chip->cmdfunc(mtd, NAND_CMD_READCACHEEND, -1, -1);
+		chip->cont_read.ongoing = false;
+	}
 	chip->select_chip(mtd, -1);
 
 	ops->retlen = ops->len - (size_t) readlen;
@@ -3949,6 +4019,10 @@ static int nand_flash_detect_onfi(struct mtd_info *mtd, struct nand_chip *chip)
 		pr_warn("Could not retrieve ONFI ECC requirements\n");
 	}
 
+	if (IS_ENABLED(CONFIG_NAND_CACHE_READ) &&
+	    le16_to_cpu(p->opt_cmd) & ONFI_OPT_CMD_READ_CACHE)
+		chip->options |= NAND_CACHE_READ;
+
 	return 1;
 }
 #else
@@ -0,0 +1,108 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Updating SPI flash with as few erase and program operations as possible
+ *
+ * Erasing a sector takes tens or hundreds of milliseconds and programming a
+ * page about a millisecond, while reading a sector to compare it is quick.
+ * So the sector is only erased if some bits need to change from 0 to 1, and
+ * only pages which differ are programmed.
+ */
+
+#include <spi_flash.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+
+/* Check whether programming @new over @old can give @new, without an erase */
+static bool sf_can_program(const u8 *old, const u8 *new, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		if ((old[i] & new[i]) != new[i])
+			return false;
+	}
+
+	return true;
+}
+
+/* Check whether a page needs programming to hold @data */
+static bool sf_page_differs(const u8 *data, const u8 *old, size_t len)
+{
+	size_t i;
+
+	if (old)
+		return memcmp(data, old, len);
+	for (i = 0; i < len; i++) {
+		if (data[i] != 0xff)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Program the pages in @start..@end of a sector which need it, writing each run
+ * of adjacent pages at once. @data points to what the sector must hold and @old
+ * to what it holds now, or NULL if it is erased.
+ */
+static int sf_program_pages(struct spi_flash *flash, u32 sector,
+			    const u8 *data, const u8 *old, u32 start, u32 end)
+{
+	u32 page = flash->page_size ? flash->page_size : flash->sector_size;
+	u32 pos, run = start;
+	int ret;
+
+	for (pos = start; pos < end; ) {
+		u32 next = min(end, ALIGN(pos + 1, page));
+
+		if (!sf_page_differs(data + pos, old ? old + pos : NULL,
+				     next - pos)) {
+			if (run < pos) {
+				ret = spi_flash_write(flash, sector + run,
+						      pos - run, data + run);
+				if (ret)
+					return ret;
+			}
+			run = next;
+		}
+		pos = next;
+	}
+	if (run < end)
+		return spi_flash_write(flash, sector + run, end - run,
+				       data + run);
+
+	return 0;
+}
+
+int spi_flash_update_sector(struct spi_flash *flash, u32 offset, size_t len,
+			    const void *buf, void *cmp_buf, size_t *skipped)
+{
+	u32 start = offset % flash->sector_size;
+	u32 sector = offset - start;
+	u8 *old = cmp_buf;
+	int ret;
+
+	if (start + len > flash->sector_size)
+		return -EINVAL;
+
+	ret = spi_flash_read(flash, sector, flash->sector_size, old);
+	if (ret)
+		return ret;
+	if (!memcmp(old + start, buf, len)) {
+		*skipped += len;
+		return 0;
+	}
+
+	/* Just program the pages which differ, if bits only need clearing */
+	if (sf_can_program(old + start, buf, len))
+		return sf_program_pages(flash, sector, buf - start, old, start,
+					start + len);
+
+	/* Erase and program back the sector, with the new data merged in */
+	ret = spi_flash_erase(flash, sector, flash->sector_size);
+	if (ret)
+		return ret;
+	memcpy(old + start, buf, len);
+
+	return sf_program_pages(flash, sector, old, NULL, 0, flash->sector_size);
+}
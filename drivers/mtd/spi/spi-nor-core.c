@@ -1627,7 +1627,8 @@ static int spi_nor_read(struct mtd_info *mtd, loff_t from, size_t len,
 #endif
 		}
 
-		if (len < rem_bank_len)
+		/* Only 3-byte addresses are limited to a bank */
+		if (nor->addr_width != 3 || len < rem_bank_len)
 			read_len = len;
 		else
 			read_len = rem_bank_len;
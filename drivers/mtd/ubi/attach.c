@@ -833,6 +833,7 @@ static int scan_peb(struct ubi_device *ubi, struct ubi_attach_info *ai,
 		return 0;
 	}
 
+	ubi_io_read_hdrs(ubi, pnum);
 	err = ubi_io_read_ec_hdr(ubi, pnum, ech, 0);
 	if (err < 0)
 		return err;
@@ -1242,14 +1243,23 @@ static int scan_all(struct ubi_device *ubi, struct ubi_attach_info *ai,
 	if (!vidh)
 		goto out_ech;
 
+	/* If there is no memory, just read the headers separately */
+	ubi->hdrs_buf = kmalloc(ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize,
+				GFP_KERNEL);
+	err = 0;
 	for (pnum = start; pnum < ubi->peb_count; pnum++) {
 		cond_resched();
 
 		dbg_gen("process PEB %d", pnum);
 		err = scan_peb(ubi, ai, pnum, NULL, NULL);
 		if (err < 0)
-			goto out_vidh;
+			break;
 	}
+	kfree(ubi->hdrs_buf);
+	ubi->hdrs_buf = NULL;
+	ubi->hdrs_pnum = -1;
+	if (err < 0)
+		goto out_vidh;
 
 	ubi_msg(ubi, "scanning is finished");
 
@@ -1478,6 +1488,17 @@ int ubi_attach(struct ubi_device *ubi, int force_scan)
 		if (err)
 			goto out_wl;
 	}
+
+	/*
+	 * Write a fastmap if there was none, so that the next attach need not
+	 * scan the whole device. fm_disabled is only clear here if autoconvert
+	 * is enabled or a fastmap was found.
+	 */
+	if (!ubi->fm && !ubi->fm_disabled && !ubi->ro_mode) {
+		err = ubi_update_fastmap(ubi);
+		if (err)
+			ubi_warn(ubi, "failed to write fastmap, error %d", err);
+	}
 #endif
 
 	destroy_ai(ai);
@@ -238,6 +238,8 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 	dbg_io("write %d bytes to PEB %d:%d", len, pnum, offset);
 
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+	if (pnum == ubi->hdrs_pnum)
+		ubi->hdrs_pnum = -1;
 	ubi_assert(offset >= 0 && offset + len <= ubi->peb_size);
 	ubi_assert(offset % ubi->hdrs_min_io_size == 0);
 	ubi_assert(len > 0 && len % ubi->hdrs_min_io_size == 0);
@@ -321,6 +323,8 @@ static int do_sync_erase(struct ubi_device *ubi, int pnum)
 
 	dbg_io("erase PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
+	if (pnum == ubi->hdrs_pnum)
+		ubi->hdrs_pnum = -1;
 
 	if (ubi->ro_mode) {
 		ubi_err(ubi, "read-only mode");
@@ -697,6 +701,48 @@ bad:
 	return 1;
 }
 
+/**
+ * ubi_io_read_hdrs - read both headers of a physical eraseblock at once.
+ * @ubi: UBI device description object
+ * @pnum: physical eraseblock to read from
+ *
+ * When scanning, the EC and VID headers of each physical eraseblock are read
+ * one after the other. This function reads the flash from the start of the
+ * EC header to the end of the VID header with one read, which the NAND driver
+ * can do as a multi-page read, and saves it in @ubi->hdrs_buf for
+ * 'ubi_io_read_ec_hdr()' and 'ubi_io_read_vid_hdr()'. If the read fails, or
+ * reports an ECC error, nothing is saved and the headers are read separately,
+ * so that errors are put down to the right header.
+ */
+void ubi_io_read_hdrs(struct ubi_device *ubi, int pnum)
+{
+	int err;
+
+	ubi->hdrs_pnum = -1;
+	if (!ubi->hdrs_buf)
+		return;
+
+	err = ubi_io_read(ubi, ubi->hdrs_buf, pnum, 0,
+			  ubi->vid_hdr_aloffset + ubi->vid_hdr_alsize);
+	if (err && err != UBI_IO_BITFLIPS)
+		return;
+
+	ubi->hdrs_pnum = pnum;
+	ubi->hdrs_err = err;
+}
+
+/* Read a header, using the data saved by 'ubi_io_read_hdrs()' if possible */
+static int read_hdr(struct ubi_device *ubi, void *buf, int pnum, int offset,
+		    int len)
+{
+	if (ubi->hdrs_buf && pnum == ubi->hdrs_pnum) {
+		memcpy(buf, ubi->hdrs_buf + offset, len);
+		return ubi->hdrs_err;
+	}
+
+	return ubi_io_read(ubi, buf, pnum, offset, len);
+}
+
 /**
  * ubi_io_read_ec_hdr - read and check an erase counter header.
  * @ubi: UBI device description object
@@ -728,7 +774,7 @@ int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 	dbg_io("read EC header from PEB %d", pnum);
 	ubi_assert(pnum >= 0 && pnum < ubi->peb_count);
 
-	read_err = ubi_io_read(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
+	read_err = read_hdr(ubi, ec_hdr, pnum, 0, UBI_EC_HDR_SIZE);
 	if (read_err) {
 		if (read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
 			return read_err;
@@ -1003,8 +1049,8 @@ int ubi_io_read_vid_hdr(struct ubi_device *ubi, int pnum,
 	ubi_assert(pnum >= 0 &&  pnum < ubi->peb_count);
 
 	p = (char *)vid_hdr - ubi->vid_hdr_shift;
-	read_err = ubi_io_read(ubi, p, pnum, ubi->vid_hdr_aloffset,
-			  ubi->vid_hdr_alsize);
+	read_err = read_hdr(ubi, p, pnum, ubi->vid_hdr_aloffset,
+			    ubi->vid_hdr_alsize);
 	if (read_err && read_err != UBI_IO_BITFLIPS && !mtd_is_eccerr(read_err))
 		return read_err;
 
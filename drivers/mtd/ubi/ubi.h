@@ -525,6 +525,10 @@ struct ubi_debug_info {
  *                  time (MTD write buffer size)
  * @mtd: MTD device descriptor
  *
+ * @hdrs_buf: buffer holding both headers of PEB @hdrs_pnum, read with one
+ *            read while scanning, or %NULL if not scanning
+ * @hdrs_pnum: PEB whose headers are in @hdrs_buf, or -1 if none
+ * @hdrs_err: result of reading @hdrs_buf (%0 or %UBI_IO_BITFLIPS)
  * @peb_buf: a buffer of PEB size used for different purposes
  * @buf_mutex: protects @peb_buf
  * @ckvol_mutex: serializes static volume checking when opening
@@ -624,6 +628,10 @@ struct ubi_device {
 	int max_write_size;
 	struct mtd_info *mtd;
 
+	void *hdrs_buf;
+	int hdrs_pnum;
+	int hdrs_err;
+
 	void *peb_buf;
 	struct mutex buf_mutex;
 	struct mutex ckvol_mutex;
@@ -891,6 +899,7 @@ int ubi_io_write(struct ubi_device *ubi, const void *buf, int pnum, int offset,
 int ubi_io_sync_erase(struct ubi_device *ubi, int pnum, int torture);
 int ubi_io_is_bad(const struct ubi_device *ubi, int pnum);
 int ubi_io_mark_bad(const struct ubi_device *ubi, int pnum);
+void ubi_io_read_hdrs(struct ubi_device *ubi, int pnum);
 int ubi_io_read_ec_hdr(struct ubi_device *ubi, int pnum,
 		       struct ubi_ec_hdr *ec_hdr, int verbose);
 int ubi_io_write_ec_hdr(struct ubi_device *ubi, int pnum,
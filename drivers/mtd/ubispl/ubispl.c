@@ -1069,7 +1069,6 @@ int ubispl_load_volumes(struct ubispl_info *info, struct ubispl_load *lvols,
 	int res, i, fastmap = info->fastmap;
 	u32 fsize;
 
-retry:
 	/*
 	 * We do a partial initializiation of @ubi. Cleaning fm_buf is
 	 * not necessary.
@@ -1102,6 +1101,7 @@ retry:
 		generic_set_bit(lv->vol_id, ubi->toload);
 	}
 
+rescan:
 	ipl_scan(ubi);
 
 	for (i = 0; i < nrvols; i++) {
@@ -1127,8 +1127,17 @@ retry:
 		res = ipl_load(ubi, lv->vol_id, lv->load_addr);
 		if (res < 0) {
 			if (fastmap) {
+				/*
+				 * Fall back to a full scan. The VID headers
+				 * read so far came from the flash, so keep
+				 * them and only drop what the fastmap said.
+				 */
 				fastmap = 0;
-				goto retry;
+				ubi->fm_enabled = 0;
+				ubi->fastmap_pebs = 0;
+				memset(ubi->fm_used, 0, sizeof(ubi->fm_used));
+				memset(ubi->volinfo, 0, sizeof(ubi->volinfo));
+				goto rescan;
 			}
 			ubi_warn("Failed");
 			return res;
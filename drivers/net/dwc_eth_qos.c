@@ -53,6 +53,7 @@
 #endif
 #include <linux/bitfield.h>
 #include <linux/delay.h>
+#include <linux/dma-mapping.h>
 #include <linux/printk.h>
 
 #include "dwc_eth_qos.h"
@@ -77,12 +78,14 @@
  */
 static void *eqos_alloc_descs(struct eqos_priv *eqos, unsigned int num)
 {
-	return memalign(ARCH_DMA_MINALIGN, num * eqos->desc_size);
+	unsigned long handle;
+
+	return dma_alloc_coherent(num * eqos->desc_size, &handle);
 }
 
 static void eqos_free_descs(void *descs)
 {
-	free(descs);
+	dma_free_coherent(descs);
 }
 
 static struct eqos_desc *eqos_get_desc(struct eqos_priv *eqos,
@@ -98,7 +101,8 @@ void eqos_inval_desc_generic(void *desc)
 	unsigned long end = ALIGN(start + sizeof(struct eqos_desc),
 				  ARCH_DMA_MINALIGN);
 
-	invalidate_dcache_range(start, end);
+	if (!dma_coherent_is_uncached(desc))
+		invalidate_dcache_range(start, end);
 }
 
 void eqos_flush_desc_generic(void *desc)
@@ -107,7 +111,8 @@ void eqos_flush_desc_generic(void *desc)
 	unsigned long end = ALIGN(start + sizeof(struct eqos_desc),
 				  ARCH_DMA_MINALIGN);
 
-	flush_dcache_range(start, end);
+	if (!dma_coherent_is_uncached(desc))
+		flush_dcache_range(start, end);
 }
 
 static void eqos_inval_buffer_tegra186(void *buf, size_t size)
@@ -684,6 +689,7 @@ static int eqos_get_phy_addr(struct eqos_priv *priv, struct udevice *dev)
 static int eqos_start(struct udevice *dev)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
+	struct eth_pdata *pdata = dev_get_plat(dev);
 	int ret, i;
 	ulong rate;
 	u32 val, tx_fifo_sz, rx_fifo_sz, tqs, rqs, pbl;
@@ -924,6 +930,20 @@ static int eqos_start(struct udevice *dev)
 			EQOS_MAC_CONFIGURATION_CST |
 			EQOS_MAC_CONFIGURATION_ACS);
 
+	/* Let the checksum offload engine check and insert checksums */
+	pdata->csum_offload = 0;
+	if (IS_ENABLED(CONFIG_DWC_ETH_QOS_CSUM_OFFLOAD)) {
+		val = readl(&eqos->mac_regs->hw_feature0);
+		if (val & EQOS_MAC_HW_FEATURE0_RXCOESEL) {
+			setbits_le32(&eqos->mac_regs->configuration,
+				     EQOS_MAC_CONFIGURATION_IPC);
+			pdata->csum_offload |= ETH_CSUM_RX;
+		}
+		/* Needs the TX store and forward mode set above */
+		if (val & EQOS_MAC_HW_FEATURE0_TXCOESEL)
+			pdata->csum_offload |= ETH_CSUM_TX;
+	}
+
 	eqos_write_hwaddr(dev);
 
 	/* Configure DMA */
@@ -1093,6 +1113,7 @@ static void eqos_stop(struct udevice *dev)
 static int eqos_send(struct udevice *dev, void *packet, int length)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
+	struct eth_pdata *pdata = dev_get_plat(dev);
 	struct eqos_desc *tx_desc;
 	int i;
 
@@ -1115,6 +1136,8 @@ static int eqos_send(struct udevice *dev, void *packet, int length)
 	 */
 	mb();
 	tx_desc->des3 = EQOS_DESC3_OWN | EQOS_DESC3_FD | EQOS_DESC3_LD | length;
+	if (pdata->csum_offload & ETH_CSUM_TX)
+		tx_desc->des3 |= EQOS_DESC3_CIC_FULL;
 	eqos->config->ops->eqos_flush_desc(tx_desc);
 
 	writel((ulong)eqos_get_desc(eqos, eqos->tx_desc_idx, false),
@@ -1132,9 +1155,24 @@ static int eqos_send(struct udevice *dev, void *packet, int length)
 	return -ETIMEDOUT;
 }
 
+/* Check if the MAC found correct IPv4 and TCP or UDP checksums */
+static bool eqos_rx_csum_ok(struct eqos_desc *rx_desc)
+{
+	u32 status = rx_desc->des1;
+	u32 pt = status & EQOS_DESC1_PT_MASK;
+
+	if (!(rx_desc->des3 & EQOS_DESC3_RS1V) || !(status & EQOS_DESC1_IPV4))
+		return false;
+	if (status & (EQOS_DESC1_IPHE | EQOS_DESC1_IPCE | EQOS_DESC1_IPCB))
+		return false;
+
+	return pt == EQOS_DESC1_PT_UDP || pt == EQOS_DESC1_PT_TCP;
+}
+
 static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
+	struct eth_pdata *pdata = dev_get_plat(dev);
 	struct eqos_desc *rx_desc;
 	int length;
 
@@ -1150,6 +1188,9 @@ static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 	length = rx_desc->des3 & 0x7fff;
 	debug("%s: *packetp=%p, length=%d\n", __func__, *packetp, length);
 
+	if (pdata->csum_offload & ETH_CSUM_RX && eqos_rx_csum_ok(rx_desc))
+		eth_set_rx_csum_ok(dev);
+
 	eqos->config->ops->eqos_inval_buffer(*packetp, length);
 
 	return length;
@@ -1158,7 +1199,7 @@ static int eqos_recv(struct udevice *dev, int flags, uchar **packetp)
 static int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
 {
 	struct eqos_priv *eqos = dev_get_priv(dev);
-	u32 idx, idx_mask = eqos->desc_per_cacheline - 1;
+	u32 first, idx, idx_mask = eqos->desc_per_cacheline - 1;
 	uchar *packet_expected;
 	struct eqos_desc *rx_desc = NULL;
 
@@ -1172,20 +1213,22 @@ static int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
 		return -EINVAL;
 	}
 
-	eqos->config->ops->eqos_inval_buffer(packet, length);
-
+	/*
+	 * The descriptors sharing a cache line are handed back together, once
+	 * all of them have been received, so that flushing the line cannot
+	 * overwrite a descriptor written by the hardware. Their buffers are
+	 * next to each other, so they are invalidated in one go, and the line
+	 * is flushed once.
+	 */
 	if ((eqos->rx_desc_idx & idx_mask) == idx_mask) {
-		for (idx = eqos->rx_desc_idx - idx_mask;
-		     idx <= eqos->rx_desc_idx;
-		     idx++) {
+		first = eqos->rx_desc_idx - idx_mask;
+		eqos->config->ops->eqos_inval_buffer(eqos->rx_dma_buf +
+				first * EQOS_MAX_PACKET_SIZE,
+				(idx_mask + 1) * EQOS_MAX_PACKET_SIZE);
+		for (idx = first; idx <= eqos->rx_desc_idx; idx++) {
 			ulong addr64;
 
 			rx_desc = eqos_get_desc(eqos, idx, true);
-			rx_desc->des0 = 0;
-			rx_desc->des1 = 0;
-			mb();
-			eqos->config->ops->eqos_flush_desc(rx_desc);
-			eqos->config->ops->eqos_inval_buffer(packet, length);
 			addr64 = (ulong)(eqos->rx_dma_buf + (idx * EQOS_MAX_PACKET_SIZE));
 			rx_desc->des0 = lower_32_bits(addr64);
 			rx_desc->des1 = upper_32_bits(addr64);
@@ -1197,8 +1240,8 @@ static int eqos_free_pkt(struct udevice *dev, uchar *packet, int length)
 			 */
 			mb();
 			rx_desc->des3 = EQOS_DESC3_OWN | EQOS_DESC3_BUF1V;
-			eqos->config->ops->eqos_flush_desc(rx_desc);
 		}
+		eqos->config->ops->eqos_flush_desc(rx_desc);
 		writel((ulong)rx_desc, &eqos->dma_regs->ch0_rxdesc_tail_pointer);
 	}
 
@@ -1231,6 +1274,11 @@ static int eqos_probe_resources_core(struct udevice *dev)
 					(unsigned int)ARCH_DMA_MINALIGN);
 	}
 	eqos->desc_per_cacheline = ARCH_DMA_MINALIGN / eqos->desc_size;
+	if (EQOS_DESCRIPTORS_RX % eqos->desc_per_cacheline) {
+		debug("%s: %d RX descriptors do not fill whole cache lines of %d\n",
+		      __func__, EQOS_DESCRIPTORS_RX, eqos->desc_per_cacheline);
+		return -EINVAL;
+	}
 
 	eqos->tx_descs = eqos_alloc_descs(eqos, EQOS_DESCRIPTORS_TX);
 	if (!eqos->tx_descs) {
@@ -38,6 +38,7 @@ struct eqos_mac_regs {
 	u32 address0_low;				/* 0x304 */
 };
 
+#define EQOS_MAC_CONFIGURATION_IPC			BIT(27)
 #define EQOS_MAC_CONFIGURATION_GPSLCE			BIT(23)
 #define EQOS_MAC_CONFIGURATION_CST			BIT(21)
 #define EQOS_MAC_CONFIGURATION_ACS			BIT(20)
@@ -69,6 +70,8 @@ struct eqos_mac_regs {
 #define EQOS_MAC_RXQ_CTRL2_PSRQ0_SHIFT			0
 #define EQOS_MAC_RXQ_CTRL2_PSRQ0_MASK			0xff
 
+#define EQOS_MAC_HW_FEATURE0_RXCOESEL			BIT(16)
+#define EQOS_MAC_HW_FEATURE0_TXCOESEL			BIT(14)
 #define EQOS_MAC_HW_FEATURE0_MMCSEL_SHIFT		8
 #define EQOS_MAC_HW_FEATURE0_HDSEL_SHIFT		2
 #define EQOS_MAC_HW_FEATURE0_GMIISEL_SHIFT		1
@@ -198,8 +201,8 @@ struct eqos_tegra186_regs {
 #define EQOS_AUTO_CAL_STATUS_ACTIVE			BIT(31)
 
 /* Descriptors */
-#define EQOS_DESCRIPTORS_TX	4
-#define EQOS_DESCRIPTORS_RX	4
+#define EQOS_DESCRIPTORS_TX	CONFIG_DWC_ETH_QOS_DESCRIPTORS_TX
+#define EQOS_DESCRIPTORS_RX	CONFIG_DWC_ETH_QOS_DESCRIPTORS_RX
 #define EQOS_DESCRIPTORS_NUM	(EQOS_DESCRIPTORS_TX + EQOS_DESCRIPTORS_RX)
 #define EQOS_BUFFER_ALIGN	ARCH_DMA_MINALIGN
 #define EQOS_MAX_PACKET_SIZE	ALIGN(1568, ARCH_DMA_MINALIGN)
@@ -215,7 +218,19 @@ struct eqos_desc {
 #define EQOS_DESC3_OWN		BIT(31)
 #define EQOS_DESC3_FD		BIT(29)
 #define EQOS_DESC3_LD		BIT(28)
+#define EQOS_DESC3_RS1V		BIT(26)
 #define EQOS_DESC3_BUF1V	BIT(24)
+/* Insert the IP header and payload checksums, with the pseudo-header */
+#define EQOS_DESC3_CIC_FULL	(3 << 16)
+
+/* Receive status in des1, valid if EQOS_DESC3_RS1V is set */
+#define EQOS_DESC1_IPCE		BIT(7)
+#define EQOS_DESC1_IPCB		BIT(6)
+#define EQOS_DESC1_IPV4		BIT(4)
+#define EQOS_DESC1_IPHE		BIT(3)
+#define EQOS_DESC1_PT_MASK	7
+#define EQOS_DESC1_PT_UDP	1
+#define EQOS_DESC1_PT_TCP	2
 
 #define EQOS_AXI_WIDTH_32	4
 #define EQOS_AXI_WIDTH_64	8
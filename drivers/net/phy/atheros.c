@@ -7,6 +7,7 @@
  * Copyright (c) 2019 Michael Walle <michael@walle.cc>
  */
 #include <phy.h>
+#include <time.h>
 #include <dm/device_compat.h>
 #include <linux/bitfield.h>
 #include <linux/bitops.h>
@@ -114,6 +115,7 @@ static int ar8021_config(struct phy_device *phydev)
 {
 	phy_write(phydev, MDIO_DEVAD_NONE, MII_BMCR,
 		  BMCR_ANENABLE | BMCR_ANRESTART);
+	phydev->aneg_start = get_timer(0);
 
 	ar803x_enable_tx_delay(phydev, true);
 
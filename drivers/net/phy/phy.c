@@ -15,6 +15,7 @@
 #include <command.h>
 #include <miiphy.h>
 #include <phy.h>
+#include <time.h>
 #include <errno.h>
 #include <asm/global_data.h>
 #include <asm-generic/gpio.h>
@@ -167,6 +168,7 @@ int genphy_restart_aneg(struct phy_device *phydev)
 	ctl &= ~(BMCR_ISOLATE);
 
 	ctl = phy_write(phydev, MDIO_DEVAD_NONE, MII_BMCR, ctl);
+	phydev->aneg_start = get_timer(0);
 
 	return ctl;
 }
@@ -242,15 +244,20 @@ int genphy_update_link(struct phy_device *phydev)
 
 	if ((phydev->autoneg == AUTONEG_ENABLE) &&
 	    !(mii_reg & BMSR_ANEGCOMPLETE)) {
+		ulong start = get_timer(0);
 		int i = 0;
 
+		/* Count the time negotiation has already had in the background */
+		if (IS_ENABLED(CONFIG_PHY_ANEG_EARLY) && phydev->aneg_start)
+			start = phydev->aneg_start;
+
 		printf("%s Waiting for PHY auto negotiation to complete",
 		       phydev->dev->name);
 		while (!(mii_reg & BMSR_ANEGCOMPLETE)) {
 			/*
 			 * Timeout reached ?
 			 */
-			if (i > (CONFIG_PHY_ANEG_TIMEOUT / 50)) {
+			if (get_timer(start) > CONFIG_PHY_ANEG_TIMEOUT) {
 				printf(" TIMEOUT !\n");
 				phydev->link = 0;
 				return -ETIMEDOUT;
@@ -756,6 +763,8 @@ int phy_reset(struct phy_device *phydev)
 		puts("PHY reset timed out\n");
 		return -1;
 	}
+	/* A reset restarts autonegotiation */
+	phydev->aneg_start = get_timer(0);
 
 	return 0;
 }
@@ -850,6 +859,14 @@ static void phy_connect_dev(struct phy_device *phydev, struct udevice *dev,
 	phydev->interface = interface;
 	debug("%s connected to %s mode %s\n", dev->name, phydev->drv->name,
 	      phy_string_for_interface(interface));
+
+	/*
+	 * Ethernet devices are normally probed, and so connected to their
+	 * PHYs, by eth_initialize(). Starting negotiation here lets it run
+	 * on all PHYs at once while U-Boot carries on booting.
+	 */
+	if (IS_ENABLED(CONFIG_PHY_ANEG_EARLY))
+		phy_config(phydev);
 }
 
 #ifdef CONFIG_PHY_XILINX_GMII2RGMII
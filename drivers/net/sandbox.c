@@ -319,6 +319,30 @@ void sandbox_eth_set_priv(int index, void *priv)
 	dev_priv->priv = priv;
 }
 
+/*
+ * Set the checksum offload the device claims to support
+ *
+ * With ETH_CSUM_RX every packet received is reported as having correct
+ * checksums. With ETH_CSUM_TX the packets sent are passed to the handler as
+ * the stack built them, without inserting any checksum.
+ *
+ * index - interface to set the offload for
+ * flags - ETH_CSUM_... flags
+ */
+void sandbox_eth_set_csum_offload(int index, unsigned int flags)
+{
+	struct eth_pdata *pdata;
+	struct udevice *dev;
+	int ret;
+
+	ret = uclass_get_device(UCLASS_ETH, index, &dev);
+	if (ret)
+		return;
+
+	pdata = dev_get_plat(dev);
+	pdata->csum_offload = flags;
+}
+
 static int sb_eth_start(struct udevice *dev)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
@@ -349,6 +373,7 @@ static int sb_eth_send(struct udevice *dev, void *packet, int length)
 static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 {
 	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct eth_pdata *pdata = dev_get_plat(dev);
 
 	if (skip_timeout) {
 		timer_test_add_offset(11000UL);
@@ -361,6 +386,8 @@ static int sb_eth_recv(struct udevice *dev, int flags, uchar **packetp)
 		debug("eth_sandbox: received packet[%d], %d waiting\n",
 		      lcl_recv_packet_length, priv->recv_packets - 1);
 		*packetp = priv->recv_packet_buffer[0];
+		if (pdata->csum_offload & ETH_CSUM_RX)
+			eth_set_rx_csum_ok(dev);
 		return lcl_recv_packet_length;
 	}
 	return 0;
@@ -9,6 +9,7 @@
 #include <cpu_func.h>
 #include <dm.h>
 #include <errno.h>
+#include <lmb.h>
 #include <log.h>
 #include <malloc.h>
 #include <memalign.h>
@@ -17,7 +18,8 @@
 #include <linux/compat.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+/* A queue with N entries can hold N - 1 commands */
+#define NVME_Q_DEPTH		(CONFIG_NVME_QUEUE_DEPTH + 1)
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
@@ -25,7 +27,7 @@
 				      ARCH_DMA_MINALIGN)
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
+#define NVME_SLOT_FREE		((u64)-1)
 
 static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 {
@@ -44,12 +46,40 @@ static int nvme_wait_csts(struct nvme_dev *dev, u32 mask, u32 val)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+/**
+ * nvme_alloc_prp_pool() - allocate the PRP lists for the I/O queue
+ *
+ * Each slot of the I/O queue gets its own PRP list, large enough for the
+ * maximum transfer size, so that commands can be in flight together.
+ *
+ * @dev:	NVMe device, with the page size and maximum transfer size set
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int nvme_alloc_prp_pool(struct nvme_dev *dev)
+{
+	u32 page_size = dev->page_size;
+	u32 prps_per_page = page_size >> 3;
+	u32 nprps;
+
+	nprps = DIV_ROUND_UP(1ULL << dev->max_transfer_shift, page_size);
+	dev->prp_slot_pages = max_t(u32, 1, DIV_ROUND_UP(nprps - 1,
+							 prps_per_page - 1));
+
+	free(dev->prp_pool);
+	dev->prp_pool = memalign(page_size, dev->q_depth *
+				 dev->prp_slot_pages * page_size);
+	if (!dev->prp_pool)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static int nvme_setup_prps(struct nvme_dev *dev, int slot, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
 	int offset = dma_addr & (page_size - 1);
-	u64 *prp_pool;
+	u64 *prp_pool, *prp_list;
 	int length = total_len;
 	int i, nprps;
 	u32 prps_per_page = page_size >> 3;
@@ -73,36 +103,28 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	nprps = DIV_ROUND_UP(length, page_size);
 	num_pages = DIV_ROUND_UP(nprps - 1, prps_per_page - 1);
 
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = num_pages * (prps_per_page - 1) + 1;
+	if (num_pages > dev->prp_slot_pages) {
+		printf("Error: transfer too large for PRP list\n");
+		return -E2BIG;
 	}
 
-	prp_pool = dev->prp_pool;
+	prp_list = dev->prp_pool + slot * dev->prp_slot_pages * prps_per_page;
+	prp_pool = prp_list;
 	i = 0;
 	while (nprps) {
 		if ((i == (prps_per_page - 1)) && nprps > 1) {
-			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
-					page_size);
+			*(prp_pool + i) = cpu_to_le64((ulong)(prp_pool +
+					prps_per_page));
 			i = 0;
-			prp_pool += page_size;
+			prp_pool += prps_per_page;
 		}
 		*(prp_pool + i++) = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
+	flush_dcache_range((ulong)prp_list, (ulong)prp_list +
 			   num_pages * page_size);
 
 	return 0;
@@ -217,6 +239,56 @@ static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 	return status;
 }
 
+/**
+ * nvme_reap_cmd() - wait for the next completion on a queue
+ *
+ * Unlike nvme_submit_sync_cmd() this does not care which command completes,
+ * so it can be used with several commands in flight.
+ *
+ * @nvmeq:	The queue to poll
+ * @cmd:	Command passed to the driver's complete_cmd() hook
+ * @cidp:	Returns the command ID of the completed command
+ * @statusp:	Returns the status of the completed command, 0 for success
+ * @timeout_us:	Time to wait for a completion, in microseconds
+ * Return: 0 if a command completed, -ETIMEDOUT if not
+ */
+static int nvme_reap_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd,
+			 u16 *cidp, u16 *statusp, ulong timeout_us)
+{
+	struct nvme_ops *ops;
+	u16 head = nvmeq->cq_head;
+	u16 phase = nvmeq->cq_phase;
+	ulong start_time;
+	u16 status;
+
+	start_time = timer_get_us();
+
+	for (;;) {
+		status = nvme_read_completion_status(nvmeq, head);
+		if ((status & 0x01) == phase)
+			break;
+		if ((timer_get_us() - start_time) >= timeout_us)
+			return -ETIMEDOUT;
+	}
+
+	ops = (struct nvme_ops *)nvmeq->dev->udev->driver->ops;
+	if (ops && ops->complete_cmd)
+		ops->complete_cmd(nvmeq, cmd);
+
+	*cidp = readw(&nvmeq->cqes[head].command_id);
+	*statusp = status >> 1;
+
+	if (++head == nvmeq->q_depth) {
+		head = 0;
+		phase = !phase;
+	}
+	writel(head, nvmeq->q_db + nvmeq->dev->db_stride);
+	nvmeq->cq_head = head;
+	nvmeq->cq_phase = phase;
+
+	return 0;
+}
+
 static int nvme_submit_admin_cmd(struct nvme_dev *dev, struct nvme_command *cmd,
 				 u32 *result)
 {
@@ -636,6 +708,8 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 
 	dev->nn = le32_to_cpu(ctrl->nn);
 	dev->vwc = ctrl->vwc;
+	dev->hmpre = (u64)le32_to_cpu(ctrl->hmpre) << 12;
+	dev->hmmin = (u64)le32_to_cpu(ctrl->hmmin) << 12;
 	memcpy(dev->serial, ctrl->sn, sizeof(ctrl->sn));
 	memcpy(dev->model, ctrl->mn, sizeof(ctrl->mn));
 	memcpy(dev->firmware_rev, ctrl->fr, sizeof(ctrl->fr));
@@ -667,6 +741,115 @@ static int nvme_get_info_from_identify(struct nvme_dev *dev)
 	return 0;
 }
 
+#if IS_ENABLED(CONFIG_NVME_HMB)
+static int nvme_set_host_mem(struct nvme_dev *dev, u32 dword11)
+{
+	struct nvme_command c;
+
+	memset(&c, 0, sizeof(c));
+	c.features.opcode = nvme_admin_set_features;
+	c.features.fid = cpu_to_le32(NVME_FEAT_HOST_MEM_BUF);
+	c.features.dword11 = cpu_to_le32(dword11);
+	if (dword11) {
+		c.features.dword12 = cpu_to_le32(dev->hmb_size /
+						  dev->page_size);
+		c.features.dword13 =
+			cpu_to_le32(lower_32_bits((ulong)dev->hmb_desc));
+		c.features.dword14 =
+			cpu_to_le32(upper_32_bits((ulong)dev->hmb_desc));
+		c.features.dword15 = cpu_to_le32(1);
+	}
+
+	return nvme_submit_admin_cmd(dev, &c, NULL);
+}
+
+/**
+ * nvme_setup_host_mem() - give the controller a Host Memory Buffer
+ *
+ * DRAM-less controllers ask for some host memory to cache their mapping
+ * tables; without it every read needs extra flash accesses. The buffer is
+ * a single region reserved in the lmb so that images are not loaded over
+ * it. It is handed back by nvme_shutdown() before the OS starts.
+ *
+ * @dev:	NVMe device, after identify
+ * Return: 0 if OK or not wanted, -ve on error
+ */
+static int nvme_setup_host_mem(struct nvme_dev *dev)
+{
+	u64 size = min_t(u64, dev->hmpre, (u64)CONFIG_NVME_HMB_MAX_SIZE << 20);
+	struct nvme_host_mem_buf_desc *desc;
+	phys_addr_t addr;
+	int ret;
+
+	size = ALIGN(size, dev->page_size);
+	if (!size || size < dev->hmmin)
+		return 0;
+
+	addr = lmb_alloc_flags(size, dev->page_size, LMB_NOOVERWRITE);
+	if (!addr)
+		return -ENOMEM;
+	desc = memalign(ARCH_DMA_MINALIGN, ALIGN(sizeof(*desc),
+						 ARCH_DMA_MINALIGN));
+	if (!desc) {
+		ret = -ENOMEM;
+		goto err_lmb;
+	}
+
+	desc->addr = cpu_to_le64(addr);
+	desc->size = cpu_to_le32(size / dev->page_size);
+	desc->rsvd = 0;
+	flush_dcache_range((ulong)desc, (ulong)desc +
+			   ALIGN(sizeof(*desc), ARCH_DMA_MINALIGN));
+	/* the controller owns the buffer from now on */
+	flush_dcache_range(addr, addr + size);
+
+	dev->hmb_addr = addr;
+	dev->hmb_size = size;
+	dev->hmb_desc = desc;
+	ret = nvme_set_host_mem(dev, 1);
+	if (ret) {
+		ret = -EIO;
+		goto err_desc;
+	}
+	log_debug("%s: host memory buffer %lluKiB\n", dev->udev->name,
+		  size >> 10);
+
+	return 0;
+
+err_desc:
+	free(desc);
+	dev->hmb_desc = NULL;
+	dev->hmb_addr = 0;
+err_lmb:
+	lmb_free_flags(addr, size, LMB_NOOVERWRITE);
+
+	return ret;
+}
+
+static void nvme_release_host_mem(struct nvme_dev *dev)
+{
+	if (!dev->hmb_addr)
+		return;
+
+	if (nvme_set_host_mem(dev, 0))
+		log_warning("%s: cannot disable host memory buffer\n",
+			    dev->udev->name);
+	lmb_free_flags(dev->hmb_addr, dev->hmb_size, LMB_NOOVERWRITE);
+	free(dev->hmb_desc);
+	dev->hmb_desc = NULL;
+	dev->hmb_addr = 0;
+}
+#else
+static inline int nvme_setup_host_mem(struct nvme_dev *dev)
+{
+	return 0;
+}
+
+static inline void nvme_release_host_mem(struct nvme_dev *dev)
+{
+}
+#endif
+
 int nvme_get_namespace_id(struct udevice *udev, u32 *ns_id, u8 *eui64)
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
@@ -741,65 +924,196 @@ static int nvme_blk_probe(struct udevice *udev)
 	return 0;
 }
 
-static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
-			 lbaint_t blkcnt, void *buffer, bool read)
+/**
+ * struct nvme_xfer - a read or write split into commands on the I/O queue
+ *
+ * @ns:		Namespace being accessed
+ * @c:		Command template, updated for each command submitted
+ * @slot_slba:	First LBA of the command in each slot, NVME_SLOT_FREE if none
+ * @buffer:	Start of the caller's buffer
+ * @next_buf:	Buffer address for the next command
+ * @start:	First LBA of the transfer
+ * @slba:	LBA for the next command
+ * @end:	LBA after the end of the transfer
+ * @done:	Lowest LBA known not to have been transferred, @end if none
+ * @max_inflight: Maximum number of commands to keep in flight
+ * @inflight:	Number of commands in flight
+ * @last_us:	Time of the last submission or completion, in microseconds
+ * @read:	true to read, false to write
+ */
+struct nvme_xfer {
+	struct nvme_ns *ns;
+	struct nvme_command c;
+	u64 slot_slba[NVME_Q_DEPTH];
+	void *buffer;
+	uintptr_t next_buf;
+	u64 start;
+	u64 slba;
+	u64 end;
+	u64 done;
+	int max_inflight;
+	int inflight;
+	ulong last_us;
+	bool read;
+};
+
+static void nvme_xfer_start(struct nvme_xfer *xfer, struct nvme_ns *ns,
+			    lbaint_t blknr, lbaint_t blkcnt, void *buffer,
+			    bool read)
 {
-	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
-	struct nvme_command c;
-	struct blk_desc *desc = dev_get_uclass_plat(udev);
-	int status;
-	u64 prp2;
-	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
-	uintptr_t temp_buffer = (uintptr_t)buffer;
+	struct nvme_ops *ops = (struct nvme_ops *)dev->udev->driver->ops;
+	int i;
+
+	memset(xfer, 0, sizeof(*xfer));
+	xfer->ns = ns;
+	xfer->buffer = buffer;
+	xfer->next_buf = (uintptr_t)buffer;
+	xfer->start = blknr;
+	xfer->slba = blknr;
+	xfer->end = blknr + blkcnt;
+	xfer->done = xfer->end;
+	xfer->read = read;
 
-	u64 slba = blknr;
-	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
-	u64 total_lbas = blkcnt;
+	/*
+	 * Commands are tracked by their slot, which is also the command ID
+	 * and selects the PRP list. Controllers with their own submission
+	 * hooks complete commands in queue order, so keep one in flight.
+	 */
+	xfer->max_inflight = (ops && ops->submit_cmd) ? 1 :
+		dev->queues[NVME_IO_Q]->q_depth - 1;
+	for (i = 0; i < xfer->max_inflight; i++)
+		xfer->slot_slba[i] = NVME_SLOT_FREE;
 
 	flush_dcache_range((unsigned long)buffer,
-			   (unsigned long)buffer + total_len);
-
-	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
-	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
-
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
-			total_lbas -= lbas;
-		}
+			   (unsigned long)buffer + (blkcnt << ns->lba_shift));
+
+	xfer->c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
+	xfer->c.rw.nsid = cpu_to_le32(ns->ns_id);
+	xfer->last_us = timer_get_us();
+}
+
+/* Submit commands until the queue is full or the transfer all submitted */
+static void nvme_xfer_fill(struct nvme_xfer *xfer)
+{
+	struct nvme_ns *ns = xfer->ns;
+	struct nvme_dev *dev = ns->dev;
+	struct nvme_command *c = &xfer->c;
+	u32 max_lbas;
+	u64 prp2;
+	int i;
+
+	/* The length field of a command holds at most 64K blocks */
+	max_lbas = min(1U << (dev->max_transfer_shift - ns->lba_shift),
+		       0x10000U);
+
+	/* Stop once something has gone wrong */
+	while (xfer->slba < xfer->end && xfer->inflight < xfer->max_inflight &&
+	       xfer->done == xfer->end) {
+		u32 lbas = min_t(u64, xfer->end - xfer->slba, max_lbas);
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, temp_buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64(temp_buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+		for (i = 0; xfer->slot_slba[i] != NVME_SLOT_FREE; i++)
+			;
+		if (nvme_setup_prps(dev, i, &prp2, lbas << ns->lba_shift,
+				    xfer->next_buf)) {
+			xfer->done = xfer->slba;
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		temp_buffer += lbas << ns->lba_shift;
+		}
+		c->rw.command_id = cpu_to_le16(i);
+		c->rw.slba = cpu_to_le64(xfer->slba);
+		c->rw.length = cpu_to_le16(lbas - 1);
+		c->rw.prp1 = cpu_to_le64(xfer->next_buf);
+		c->rw.prp2 = cpu_to_le64(prp2);
+		nvme_submit_cmd(dev->queues[NVME_IO_Q], c);
+
+		xfer->slot_slba[i] = xfer->slba;
+		xfer->inflight++;
+		xfer->slba += lbas;
+		xfer->next_buf += (ulong)lbas << ns->lba_shift;
+		xfer->last_us = timer_get_us();
+	}
+}
+
+/**
+ * nvme_xfer_step() - reap a completion and submit more commands
+ *
+ * @xfer:	Transfer to advance
+ * @timeout_us:	Time to wait for a completion, 0 to just check
+ * Return: 0 if the transfer is finished, -EBUSY if not
+ */
+static int nvme_xfer_step(struct nvme_xfer *xfer, ulong timeout_us)
+{
+	struct nvme_queue *nvmeq = xfer->ns->dev->queues[NVME_IO_Q];
+	u16 cid, status;
+	int i;
+
+	nvme_xfer_fill(xfer);
+	if (!xfer->inflight)
+		return 0;
+
+	if (nvme_reap_cmd(nvmeq, &xfer->c, &cid, &status, timeout_us)) {
+		if (timer_get_us() - xfer->last_us < IO_TIMEOUT * 100000)
+			return -EBUSY;
+		cid = NVME_Q_DEPTH;
 	}
 
-	if (read)
-		invalidate_dcache_range((unsigned long)buffer,
-					(unsigned long)buffer + total_len);
+	if (cid >= xfer->max_inflight ||
+	    xfer->slot_slba[cid] == NVME_SLOT_FREE) {
+		/* Nothing still outstanding can be relied upon */
+		printf("ERROR: I/O command timed out\n");
+		for (i = 0; i < xfer->max_inflight; i++) {
+			xfer->done = min(xfer->done, xfer->slot_slba[i]);
+			xfer->slot_slba[i] = NVME_SLOT_FREE;
+		}
+		xfer->inflight = 0;
+		return 0;
+	}
+
+	if (status) {
+		printf("ERROR: status = %x, lba = %llx\n", status,
+		       xfer->slot_slba[cid]);
+		xfer->done = min(xfer->done, xfer->slot_slba[cid]);
+	}
+	xfer->slot_slba[cid] = NVME_SLOT_FREE;
+	xfer->inflight--;
+	xfer->last_us = timer_get_us();
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	nvme_xfer_fill(xfer);
+
+	return xfer->inflight ? -EBUSY : 0;
+}
+
+/* Finish a transfer, returning the number of blocks transferred */
+static ulong nvme_xfer_end(struct nvme_xfer *xfer)
+{
+	if (xfer->read)
+		invalidate_dcache_range((unsigned long)xfer->buffer,
+					(unsigned long)xfer->next_buf);
+
+	return xfer->done - xfer->start;
+}
+
+/* Wait for any asynchronous read on the device, so the queue is free */
+static void nvme_xfer_drain(struct nvme_dev *dev)
+{
+	if (dev->xfer)
+		while (nvme_xfer_step(dev->xfer, IO_TIMEOUT * 100000))
+			;
+}
+
+static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
+			 lbaint_t blkcnt, void *buffer, bool read)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_xfer xfer;
+
+	nvme_xfer_drain(ns->dev);
+
+	nvme_xfer_start(&xfer, ns, blknr, blkcnt, buffer, read);
+	while (nvme_xfer_step(&xfer, IO_TIMEOUT * 100000))
+		;
+
+	return nvme_xfer_end(&xfer);
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -814,9 +1128,52 @@ static ulong nvme_blk_write(struct udevice *udev, lbaint_t blknr,
 	return nvme_blk_rw(udev, blknr, blkcnt, (void *)buffer, false);
 }
 
+#if IS_ENABLED(CONFIG_BLK_ASYNC)
+static int nvme_blk_read_submit(struct udevice *udev, struct blk_req *req)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_dev *dev = ns->dev;
+	struct nvme_xfer *xfer;
+
+	xfer = malloc(sizeof(*xfer));
+	if (!xfer)
+		return -ENOSYS;
+
+	nvme_xfer_drain(dev);
+
+	nvme_xfer_start(xfer, ns, req->start, req->blkcnt, req->buffer, true);
+	nvme_xfer_fill(xfer);
+	dev->xfer = xfer;
+	req->priv = xfer;
+
+	return 0;
+}
+
+static int nvme_blk_req_poll(struct udevice *udev, struct blk_req *req)
+{
+	struct nvme_ns *ns = dev_get_priv(udev);
+	struct nvme_xfer *xfer = req->priv;
+
+	/* A later read on the device finishes this one first */
+	if (ns->dev->xfer == xfer && nvme_xfer_step(xfer, 0))
+		return -EBUSY;
+
+	if (ns->dev->xfer == xfer)
+		ns->dev->xfer = NULL;
+	req->done = nvme_xfer_end(xfer);
+	free(xfer);
+
+	return 0;
+}
+#endif
+
 static const struct blk_ops nvme_blk_ops = {
 	.read	= nvme_blk_read,
 	.write	= nvme_blk_write,
+#if IS_ENABLED(CONFIG_BLK_ASYNC)
+	.read_submit	= nvme_blk_read_submit,
+	.req_poll	= nvme_blk_req_poll,
+#endif
 };
 
 U_BOOT_DRIVER(nvme_blk) = {
@@ -860,15 +1217,6 @@ int nvme_init(struct udevice *udev)
 		goto free_queue;
 	}
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
-		ret = -ENOMEM;
-		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
-	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
-
 	ret = nvme_setup_io_queues(ndev);
 	if (ret) {
 		log_debug("Unable to setup I/O queues(err=%dE)\n", ret);
@@ -877,6 +1225,19 @@ int nvme_init(struct udevice *udev)
 
 	nvme_get_info_from_identify(ndev);
 
+	/* Allocate after the page and maximum transfer sizes are known */
+	ret = nvme_alloc_prp_pool(ndev);
+	if (ret) {
+		printf("Error: %s: Out of memory!\n", udev->name);
+		goto free_queue;
+	}
+
+	/* Optional, so carry on without it if this fails */
+	ret = nvme_setup_host_mem(ndev);
+	if (ret)
+		log_warning("%s: no host memory buffer (err=%dE)\n",
+			    udev->name, ret);
+
 	/* Create a blk device for each namespace */
 
 	id = memalign(ndev->page_size, sizeof(struct nvme_id_ns));
@@ -936,6 +1297,7 @@ int nvme_shutdown(struct udevice *udev)
 	struct nvme_dev *ndev = dev_get_priv(udev);
 	int ret;
 
+	nvme_release_host_mem(ndev);
 	ret = nvme_shutdown_ctrl(ndev);
 	if (ret < 0) {
 		printf("Error: %s: Shutdown timed out!\n", udev->name);
@@ -56,7 +56,10 @@ struct nvme_id_ctrl {
 	__u8			apsta;
 	__le16			wctemp;
 	__le16			cctemp;
-	__u8			rsvd270[242];
+	__le16			mtfa;
+	__le32			hmpre;
+	__le32			hmmin;
+	__u8			rsvd280[232];
 	__u8			sqes;
 	__u8			cqes;
 	__u8			rsvd514[2];
@@ -341,6 +344,7 @@ enum {
 	NVME_FEAT_WRITE_ATOMIC	= 0x0a,
 	NVME_FEAT_ASYNC_EVENT	= 0x0b,
 	NVME_FEAT_AUTO_PST	= 0x0c,
+	NVME_FEAT_HOST_MEM_BUF	= 0x0d,
 	NVME_FEAT_SW_PROGRESS	= 0x80,
 	NVME_FEAT_HOST_ID	= 0x81,
 	NVME_FEAT_RESV_MASK	= 0x82,
@@ -376,7 +380,17 @@ struct nvme_features {
 	__le64			prp2;
 	__le32			fid;
 	__le32			dword11;
-	__u32			rsvd12[4];
+	__le32			dword12;
+	__le32			dword13;
+	__le32			dword14;
+	__le32			dword15;
+};
+
+/* Host Memory Buffer descriptor list entry, see NVME_FEAT_HOST_MEM_BUF */
+struct nvme_host_mem_buf_desc {
+	__le64			addr;
+	__le32			size;	/* in memory pages */
+	__u32			rsvd;
 };
 
 struct nvme_create_cq {
@@ -618,9 +632,15 @@ struct nvme_dev {
 	u32 stripe_size;
 	u32 page_size;
 	u8 vwc;
-	u64 *prp_pool;
-	u32 prp_entry_num;
+	u64 *prp_pool;		/* one PRP list per I/O queue slot */
+	u32 prp_slot_pages;	/* pages in each slot's PRP list */
 	u32 nn;
+	u64 hmpre;		/* preferred host memory buffer size, in bytes */
+	u64 hmmin;		/* minimum usable host memory buffer size */
+	u64 hmb_addr;		/* host memory buffer, or 0 if none */
+	u32 hmb_size;
+	struct nvme_host_mem_buf_desc *hmb_desc;
+	struct nvme_xfer *xfer;	/* asynchronous read in progress, or NULL */
 };
 
 /* Admin queue and a single I/O queue. */
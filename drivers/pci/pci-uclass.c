@@ -74,6 +74,20 @@ pci_dev_t dm_pci_get_bdf(const struct udevice *dev)
 	return PCI_ADD_BUS(dev_seq(bus), pplat->devfn);
 }
 
+u8 dm_pci_get_header_type(const struct udevice *dev)
+{
+	struct pci_child_plat *pplat = dev_get_parent_plat(dev);
+
+	return pplat->header_type;
+}
+
+uint dm_pci_get_class(const struct udevice *dev)
+{
+	struct pci_child_plat *pplat = dev_get_parent_plat(dev);
+
+	return pplat->class;
+}
+
 /**
  * pci_get_bus_max() - returns the bus number of the last active bus
  *
@@ -645,8 +659,7 @@ int dm_pci_hose_probe_bus(struct udevice *bus)
 
 	debug("%s\n", __func__);
 
-	dm_pci_read_config8(bus, PCI_HEADER_TYPE, &header_type);
-	header_type &= 0x7f;
+	header_type = dm_pci_get_header_type(bus) & 0x7f;
 	if (header_type != PCI_HEADER_TYPE_BRIDGE) {
 		debug("%s: Skipping PCI device %d with Non-Bridge Header Type 0x%x\n",
 		      __func__, PCI_DEV(dm_pci_get_bdf(bus)), header_type);
@@ -858,6 +871,32 @@ __weak extern void board_pci_fixup_dev(struct udevice *bus, struct udevice *dev)
 {
 }
 
+/*
+ * A PCIe link has only device 0 on the far side, so there is no need to look
+ * for the other 31 behind a root or downstream port
+ */
+static bool pci_bus_only_one_child(struct udevice *bus)
+{
+	u16 flags;
+	int pos;
+
+	if (IS_ENABLED(CONFIG_PCI_ARID) || !device_is_on_pci_bus(bus))
+		return false;
+
+	pos = dm_pci_find_capability(bus, PCI_CAP_ID_EXP);
+	if (!pos)
+		return false;
+	dm_pci_read_config16(bus, pos + PCI_EXP_FLAGS, &flags);
+	switch ((flags & PCI_EXP_FLAGS_TYPE) >> 4) {
+	case PCI_EXP_TYPE_ROOT_PORT:
+	case PCI_EXP_TYPE_DOWNSTREAM:
+	case PCI_EXP_TYPE_PCIE_BRIDGE:
+		return true;
+	}
+
+	return false;
+}
+
 int pci_bind_bus_devices(struct udevice *bus)
 {
 	ulong vendor, device;
@@ -868,7 +907,8 @@ int pci_bind_bus_devices(struct udevice *bus)
 	int ret;
 
 	found_multi = false;
-	end = PCI_BDF(dev_seq(bus), PCI_MAX_PCI_DEVICES - 1,
+	end = PCI_BDF(dev_seq(bus),
+		      pci_bus_only_one_child(bus) ? 0 : PCI_MAX_PCI_DEVICES - 1,
 		      PCI_MAX_PCI_FUNCTIONS - 1);
 	for (bdf = PCI_BDF(dev_seq(bus), 0, 0); bdf <= end;
 	     bdf += PCI_BDF(0, 0, 1)) {
@@ -937,6 +977,7 @@ int pci_bind_bus_devices(struct udevice *bus)
 		pplat->vendor = vendor;
 		pplat->device = device;
 		pplat->class = class;
+		pplat->header_type = header_type;
 
 		if (IS_ENABLED(CONFIG_PCI_ARID)) {
 			ari_off = dm_pci_find_ext_capability(dev,
@@ -1675,7 +1716,7 @@ int dm_pci_find_capability(struct udevice *dev, int cap)
 	if (!(status & PCI_STATUS_CAP_LIST))
 		return 0;
 
-	dm_pci_read_config8(dev, PCI_HEADER_TYPE, &header_type);
+	header_type = dm_pci_get_header_type(dev);
 	if ((header_type & 0x7f) == PCI_HEADER_TYPE_CARDBUS)
 		pos = PCI_CB_CAPABILITY_LIST;
 	else
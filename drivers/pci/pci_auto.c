@@ -42,8 +42,7 @@ static void dm_pciauto_setup_device(struct udevice *dev,
 	cmdstat = (cmdstat & ~(PCI_COMMAND_IO | PCI_COMMAND_MEMORY)) |
 			PCI_COMMAND_MASTER;
 
-	dm_pci_read_config8(dev, PCI_HEADER_TYPE, &header_type);
-	header_type &= 0x7f;
+	header_type = dm_pci_get_header_type(dev) & 0x7f;
 
 	switch (header_type) {
 	case PCI_HEADER_TYPE_NORMAL:
@@ -172,7 +171,7 @@ static void dm_pciauto_setup_device(struct udevice *dev,
 	}
 
 	/* PCI_COMMAND_IO must be set for VGA device */
-	dm_pci_read_config16(dev, PCI_CLASS_DEVICE, &class);
+	class = dm_pci_get_class(dev) >> 8;
 	if (class == PCI_CLASS_DISPLAY_VGA)
 		cmdstat |= PCI_COMMAND_IO;
 
@@ -533,7 +532,7 @@ int dm_pciauto_config_device(struct udevice *dev)
 	pci_prefetch = ctlr_hose->pci_prefetch;
 	pci_io = ctlr_hose->pci_io;
 
-	dm_pci_read_config16(dev, PCI_CLASS_DEVICE, &class);
+	class = dm_pci_get_class(dev) >> 8;
 
 	switch (class) {
 	case PCI_CLASS_BRIDGE_PCI:
@@ -7,15 +7,18 @@
 
 #include <clk.h>
 #include <dm.h>
+#include <event.h>
 #include <generic-phy.h>
 #include <pci.h>
 #include <power-domain.h>
 #include <reset.h>
 #include <syscon.h>
+#include <time.h>
 #include <asm/arch-rockchip/clock.h>
 #include <asm/global_data.h>
 #include <asm/io.h>
 #include <asm-generic/gpio.h>
+#include <dm/device-internal.h>
 #include <dm/device_compat.h>
 #include <linux/bitfield.h>
 #include <linux/iopoll.h>
@@ -32,6 +35,10 @@ DECLARE_GLOBAL_DATA_PTR;
  * @vpcie3v3: The 3.3v power supply for slot
  * @apb_base: The base address of vendor regs
  * @rst_gpio: The #PERST signal for slot
+ * @link: State of link training, which runs while U-Boot carries on
+ * @link_time: Time in ms when LTSSM was enabled, or #PERST released once
+ *	link training is under way
+ * @start_err: Result of rk_pcie_start(), valid once @link is not LINK_OFF
  */
 struct rk_pcie {
 	/* Must be first member of the struct */
@@ -44,8 +51,21 @@ struct rk_pcie {
 	struct gpio_desc	rst_gpio;
 	u32		gen;
 	u32		num_lanes;
+	enum {
+		LINK_OFF,	/* port not started */
+		LINK_PERST,	/* waiting for refclk to settle */
+		LINK_TRAINING,	/* #PERST released, waiting for link */
+		LINK_UP,
+		LINK_FAIL,
+	} link;
+	ulong		link_time;
+	int		start_err;
 };
 
+/* Time from enabling LTSSM to releasing #PERST, and from then to link up */
+#define RK_PCIE_PERST_MS		100
+#define RK_PCIE_LINK_TIMEOUT_MS		1000
+
 /* Parameters for the waiting for iATU enabled routine */
 #define PCIE_CLIENT_GENERAL_DEBUG	0x104
 #define PCIE_CLIENT_HOT_RESET_CTRL	0x180
@@ -268,19 +288,19 @@ static int is_link_up(struct rk_pcie *priv)
 }
 
 /**
- * rk_pcie_link_up() - Wait for the link to come up
+ * rk_pcie_start_link() - Start link training
  *
- * @rk_pcie: Pointer to the PCI controller state
+ * Holds the device in reset and enables LTSSM. #PERST is released later by
+ * rk_pcie_link_poll(), once the refclk has had time to settle.
  *
- * Return: 1 (true) for active line and negetive (false) for no link (timeout)
+ * @rk_pcie: Pointer to the PCI controller state
  */
-static int rk_pcie_link_up(struct rk_pcie *priv)
+static void rk_pcie_start_link(struct rk_pcie *priv)
 {
-	int retries;
-
 	if (is_link_up(priv)) {
 		printf("PCI Link already up before configuration!\n");
-		return 1;
+		priv->link = LINK_UP;
+		return;
 	}
 
 	/* DW pre link configurations */
@@ -296,38 +316,94 @@ static int rk_pcie_link_up(struct rk_pcie *priv)
 
 	/* Enable LTSSM */
 	rk_pcie_enable_ltssm(priv);
+	priv->link = LINK_PERST;
+	priv->link_time = get_timer(0);
+}
 
-	/*
-	 * PCIe requires the refclk to be stable for 100ms prior to releasing
-	 * PERST. See table 2-4 in section 2.6.2 AC Specifications of the PCI
-	 * Express Card Electromechanical Specification, 1.1. However, we don't
-	 * know if the refclk is coming from RC's PHY or external OSC. If it's
-	 * from RC, so enabling LTSSM is the just right place to release #PERST.
-	 */
-	mdelay(100);
-	if (dm_gpio_is_valid(&priv->rst_gpio))
-		dm_gpio_set_value(&priv->rst_gpio, 1);
+static void rk_pcie_power_off(struct rk_pcie *priv)
+{
+	clk_disable_bulk(&priv->clks);
+	reset_assert_bulk(&priv->rsts);
+	generic_phy_power_off(&priv->phy);
+	generic_phy_exit(&priv->phy);
+	regulator_set_enable_if_allowed(priv->vpcie3v3, false);
+}
 
-	/* Check if the link is up or not */
-	for (retries = 0; retries < 10; retries++) {
-		if (is_link_up(priv))
-			break;
+/**
+ * rk_pcie_link_poll() - Move link training along without waiting
+ *
+ * @rk_pcie: Pointer to the PCI controller state
+ *
+ * Return: 0 if the link is up, -EBUSY if training is still in progress,
+ * -EIO if the link did not come up (the port is then powered off)
+ */
+static int rk_pcie_link_poll(struct rk_pcie *priv)
+{
+	struct udevice *dev = priv->dw.dev;
 
-		mdelay(100);
+	switch (priv->link) {
+	case LINK_UP:
+		return 0;
+	case LINK_OFF:
+	case LINK_FAIL:
+		return -EIO;
+	case LINK_PERST:
+		/*
+		 * PCIe requires the refclk to be stable for 100ms prior to
+		 * releasing PERST. See table 2-4 in section 2.6.2 AC
+		 * Specifications of the PCI Express Card Electromechanical
+		 * Specification, 1.1. However, we don't know if the refclk is
+		 * coming from RC's PHY or external OSC. If it's from RC, so
+		 * enabling LTSSM is the just right place to release #PERST.
+		 */
+		if (get_timer(priv->link_time) < RK_PCIE_PERST_MS)
+			return -EBUSY;
+		if (dm_gpio_is_valid(&priv->rst_gpio))
+			dm_gpio_set_value(&priv->rst_gpio, 1);
+		priv->link = LINK_TRAINING;
+		priv->link_time = get_timer(0);
+		return -EBUSY;
+	case LINK_TRAINING:
+		break;
 	}
 
-	if (retries >= 10) {
-		dev_err(priv->dw.dev, "PCIe-%d Link Fail\n",
-			dev_seq(priv->dw.dev));
+	if (!is_link_up(priv)) {
+		if (get_timer(priv->link_time) < RK_PCIE_LINK_TIMEOUT_MS)
+			return -EBUSY;
+		dev_err(dev, "PCIe-%d Link Fail\n", dev_seq(dev));
+		rk_pcie_power_off(priv);
+		priv->link = LINK_FAIL;
 		return -EIO;
 	}
 
-	dev_info(priv->dw.dev, "PCIe Link up, LTSSM is 0x%x\n",
+	priv->link = LINK_UP;
+	dev_info(dev, "PCIe Link up, LTSSM is 0x%x\n",
 		 rk_pcie_readl_apb(priv, PCIE_CLIENT_LTSSM_STATUS));
 	rk_pcie_debug_dump(priv);
+	dev_info(dev, "PCIE-%d: Link up (Gen%d-x%d, Bus%d)\n",
+		 dev_seq(dev), pcie_dw_get_link_speed(&priv->dw),
+		 pcie_dw_get_link_width(&priv->dw), priv->dw.first_busno);
+
 	return 0;
 }
 
+/**
+ * rk_pcie_link_wait() - Wait for link training to finish
+ *
+ * @rk_pcie: Pointer to the PCI controller state
+ *
+ * Return: 0 if the link is up, -EIO if not
+ */
+static int rk_pcie_link_wait(struct rk_pcie *priv)
+{
+	int ret;
+
+	while ((ret = rk_pcie_link_poll(priv)) == -EBUSY)
+		mdelay(1);
+
+	return ret;
+}
+
 static int rockchip_pcie_init_port(struct udevice *dev)
 {
 	int ret;
@@ -380,13 +456,9 @@ static int rockchip_pcie_init_port(struct udevice *dev)
 	rk_pcie_writel_apb(priv, 0x0, 0xf00040);
 	pcie_dw_setup_host(&priv->dw);
 
-	ret = rk_pcie_link_up(priv);
-	if (ret < 0)
-		goto err_link_up;
+	rk_pcie_start_link(priv);
 
 	return 0;
-err_link_up:
-	clk_disable_bulk(&priv->clks);
 err_deassert_bulk:
 	reset_assert_bulk(&priv->rsts);
 err_power_off_phy:
@@ -474,58 +546,106 @@ rockchip_pcie_parse_dt_err_reset_get_bulk:
 }
 
 /**
- * rockchip_pcie_probe() - Probe the PCIe bus for active link
+ * rk_pcie_start() - Power up the port and start link training
  *
- * @dev: A pointer to the device being operated on
+ * This is done at probe, or earlier from rockchip_pcie_start_links(), and
+ * only once.
  *
- * Probe for an active link on the PCIe bus and configure the controller
- * to enable this port.
+ * @dev: A pointer to the device being operated on
  *
- * Return: 0 on success, else -ENODEV
+ * Return: 0 on success, else -ve error
  */
-static int rockchip_pcie_probe(struct udevice *dev)
+static int rk_pcie_start(struct udevice *dev)
 {
 	struct rk_pcie *priv = dev_get_priv(dev);
-	struct udevice *ctlr = pci_get_controller(dev);
-	struct pci_controller *hose = dev_get_uclass_priv(ctlr);
-	int ret = 0;
+	int ret;
+
+	if (priv->link != LINK_OFF)
+		return priv->start_err;
 
 	priv->dw.first_busno = dev_seq(dev);
 	priv->dw.dev = dev;
 
 	ret = rockchip_pcie_parse_dt(dev);
 	if (ret)
-		return ret;
+		goto out;
 
 	ret = rockchip_pcie_init_port(dev);
+	if (ret) {
+		clk_release_bulk(&priv->clks);
+		reset_release_bulk(&priv->rsts);
+		dm_gpio_free(dev, &priv->rst_gpio);
+	}
+out:
+	priv->start_err = ret;
 	if (ret)
-		goto rockchip_pcie_probe_err_init_port;
+		priv->link = LINK_FAIL;
 
-	dev_info(dev, "PCIE-%d: Link up (Gen%d-x%d, Bus%d)\n",
-		 dev_seq(dev), pcie_dw_get_link_speed(&priv->dw),
-		 pcie_dw_get_link_width(&priv->dw),
-		 hose->first_busno);
-
-	ret = pcie_dw_prog_outbound_atu_unroll(&priv->dw,
-					       PCIE_ATU_REGION_INDEX0,
-					       PCIE_ATU_TYPE_MEM,
-					       priv->dw.mem.phys_start,
-					       priv->dw.mem.bus_start,
-					       priv->dw.mem.size);
-	if (!ret)
+	return ret;
+}
+
+/**
+ * rockchip_pcie_probe() - Probe the PCIe bus for active link
+ *
+ * @dev: A pointer to the device being operated on
+ *
+ * Configure the controller to enable this port. Link training carries on
+ * in the background and is only waited for when a device behind the port
+ * is first accessed, normally when the bus is enumerated.
+ *
+ * Return: 0 on success, else -ve error
+ */
+static int rockchip_pcie_probe(struct udevice *dev)
+{
+	struct rk_pcie *priv = dev_get_priv(dev);
+	int ret;
+
+	ret = rk_pcie_start(dev);
+	if (ret)
 		return ret;
 
-rockchip_pcie_probe_err_init_port:
-	clk_release_bulk(&priv->clks);
-	reset_release_bulk(&priv->rsts);
-	dm_gpio_free(dev, &priv->rst_gpio);
+	return pcie_dw_prog_outbound_atu_unroll(&priv->dw,
+						PCIE_ATU_REGION_INDEX0,
+						PCIE_ATU_TYPE_MEM,
+						priv->dw.mem.phys_start,
+						priv->dw.mem.bus_start,
+						priv->dw.mem.size);
+}
 
-	return ret;
+/*
+ * Only the root port can be reached before the link is up, so wait for
+ * training to finish before touching anything behind it. If the link fails
+ * the bus just looks empty.
+ */
+static int rockchip_pcie_read_config(const struct udevice *bus, pci_dev_t bdf,
+				     uint offset, ulong *valuep,
+				     enum pci_size_t size)
+{
+	struct rk_pcie *priv = dev_get_priv(bus);
+
+	if (PCI_BUS(bdf) != priv->dw.first_busno && rk_pcie_link_wait(priv)) {
+		*valuep = pci_get_ff(size);
+		return 0;
+	}
+
+	return pcie_dw_read_config(bus, bdf, offset, valuep, size);
+}
+
+static int rockchip_pcie_write_config(struct udevice *bus, pci_dev_t bdf,
+				      uint offset, ulong value,
+				      enum pci_size_t size)
+{
+	struct rk_pcie *priv = dev_get_priv(bus);
+
+	if (PCI_BUS(bdf) != priv->dw.first_busno && rk_pcie_link_wait(priv))
+		return 0;
+
+	return pcie_dw_write_config(bus, bdf, offset, value, size);
 }
 
 static const struct dm_pci_ops rockchip_pcie_ops = {
-	.read_config	= pcie_dw_read_config,
-	.write_config	= pcie_dw_write_config,
+	.read_config	= rockchip_pcie_read_config,
+	.write_config	= rockchip_pcie_write_config,
 };
 
 static const struct udevice_id rockchip_pcie_ids[] = {
@@ -542,3 +662,30 @@ U_BOOT_DRIVER(rockchip_dw_pcie) = {
 	.probe			= rockchip_pcie_probe,
 	.priv_auto		= sizeof(struct rk_pcie),
 };
+
+#if IS_ENABLED(CONFIG_PCIE_DW_ROCKCHIP_EARLY_LINK)
+/*
+ * Start training every link as soon as driver model is up, so that it has
+ * finished, or nearly so, by the time the bus is enumerated.
+ */
+static int rockchip_pcie_start_links(void)
+{
+	struct udevice *dev;
+	struct uclass *uc;
+	int ret;
+
+	uclass_id_foreach_dev(UCLASS_PCI, dev, uc) {
+		if (dev->driver != DM_DRIVER_GET(rockchip_dw_pcie) ||
+		    device_active(dev))
+			continue;
+		ret = device_of_to_plat(dev);
+		if (!ret)
+			ret = rk_pcie_start(dev);
+		if (ret)
+			dev_dbg(dev, "Cannot start link (err=%d)\n", ret);
+	}
+
+	return 0;
+}
+EVENT_SPY_SIMPLE(EVT_DM_POST_INIT_R, rockchip_pcie_start_links);
+#endif
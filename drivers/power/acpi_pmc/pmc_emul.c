@@ -72,6 +72,10 @@ static int sandbox_pmc_emul_read_config(const struct udevice *emul, uint offset,
 	case PCI_CLASS_CODE:
 		*valuep = SANDBOX_PCI_CLASS_CODE;
 		break;
+	case PCI_CLASS_REVISION:
+		*valuep = (SANDBOX_PCI_CLASS_CODE << 24) |
+				(SANDBOX_PCI_CLASS_SUB_CODE << 16);
+		break;
 	case PCI_BASE_ADDRESS_0:
 	case PCI_BASE_ADDRESS_1:
 	case PCI_BASE_ADDRESS_2:
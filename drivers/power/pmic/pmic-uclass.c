@@ -14,6 +14,7 @@
 #include <dm/lists.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
+#include <dm/devres.h>
 #include <power/pmic.h>
 #include <linux/ctype.h>
 
@@ -108,9 +109,59 @@ int pmic_reg_count(struct udevice *dev)
 	return ops->reg_count(dev);
 }
 
+/* Check whether a register is held in the shadow cache */
+static bool pmic_reg_cached(struct udevice *dev, uint reg)
+{
+	struct uc_pmic_priv *priv = dev_get_uclass_priv(dev);
+	const struct dm_pmic_ops *ops = dev_get_driver_ops(dev);
+
+	return priv->cache && reg < priv->cache_size &&
+		!ops->reg_volatile(dev, reg);
+}
+
+/* Fill @buffer from the cache; returns false unless every byte is cached */
+static bool pmic_cache_read(struct udevice *dev, uint reg, uint8_t *buffer,
+			    int len)
+{
+	struct uc_pmic_priv *priv = dev_get_uclass_priv(dev);
+	int i;
+
+	if (!IS_ENABLED(CONFIG_PMIC_REG_CACHE) || !priv->cache)
+		return false;
+
+	for (i = 0; i < len; i++) {
+		if (!pmic_reg_cached(dev, reg + i) ||
+		    !priv->cache_valid[reg + i])
+			return false;
+	}
+	memcpy(buffer, priv->cache + reg, len);
+
+	return true;
+}
+
+/* Record what the device holds, or forget it if @buffer is NULL */
+static void pmic_cache_update(struct udevice *dev, uint reg,
+			      const uint8_t *buffer, int len)
+{
+	struct uc_pmic_priv *priv = dev_get_uclass_priv(dev);
+	int i;
+
+	if (!IS_ENABLED(CONFIG_PMIC_REG_CACHE) || !priv->cache)
+		return;
+
+	for (i = 0; i < len; i++) {
+		if (!pmic_reg_cached(dev, reg + i))
+			continue;
+		if (buffer)
+			priv->cache[reg + i] = buffer[i];
+		priv->cache_valid[reg + i] = !!buffer;
+	}
+}
+
 int pmic_read(struct udevice *dev, uint reg, uint8_t *buffer, int len)
 {
 	const struct dm_pmic_ops *ops = dev_get_driver_ops(dev);
+	int ret;
 
 	if (!buffer)
 		return -EFAULT;
@@ -118,12 +169,20 @@ int pmic_read(struct udevice *dev, uint reg, uint8_t *buffer, int len)
 	if (!ops || !ops->read)
 		return -ENOSYS;
 
-	return ops->read(dev, reg, buffer, len);
+	if (pmic_cache_read(dev, reg, buffer, len))
+		return 0;
+
+	ret = ops->read(dev, reg, buffer, len);
+	if (!ret)
+		pmic_cache_update(dev, reg, buffer, len);
+
+	return ret;
 }
 
 int pmic_write(struct udevice *dev, uint reg, const uint8_t *buffer, int len)
 {
 	const struct dm_pmic_ops *ops = dev_get_driver_ops(dev);
+	int ret;
 
 	if (!buffer)
 		return -EFAULT;
@@ -131,7 +190,10 @@ int pmic_write(struct udevice *dev, uint reg, const uint8_t *buffer, int len)
 	if (!ops || !ops->write)
 		return -ENOSYS;
 
-	return ops->write(dev, reg, buffer, len);
+	ret = ops->write(dev, reg, buffer, len);
+	pmic_cache_update(dev, reg, ret ? NULL : buffer, len);
+
+	return ret;
 }
 
 int pmic_reg_read(struct udevice *dev, uint reg)
@@ -173,7 +235,7 @@ int pmic_reg_write(struct udevice *dev, uint reg, uint value)
 int pmic_clrsetbits(struct udevice *dev, uint reg, uint clr, uint set)
 {
 	struct uc_pmic_priv *priv = dev_get_uclass_priv(dev);
-	u32 val = 0;
+	u32 val = 0, new;
 	int ret;
 
 	if (priv->trans_len < 1 || priv->trans_len > sizeof(val)) {
@@ -185,8 +247,12 @@ int pmic_clrsetbits(struct udevice *dev, uint reg, uint clr, uint set)
 	if (ret < 0)
 		return ret;
 
-	val = (val & ~clr) | set;
-	return pmic_write(dev, reg, (uint8_t *)&val, priv->trans_len);
+	new = (val & ~clr) | set;
+	/* A cached register already holds this value, so skip the write */
+	if (new == val && pmic_reg_cached(dev, reg))
+		return 0;
+
+	return pmic_write(dev, reg, (uint8_t *)&new, priv->trans_len);
 }
 
 static int pmic_pre_probe(struct udevice *dev)
@@ -197,9 +263,34 @@ static int pmic_pre_probe(struct udevice *dev)
 	return 0;
 }
 
+static int pmic_post_probe(struct udevice *dev)
+{
+	struct uc_pmic_priv *priv = dev_get_uclass_priv(dev);
+	const struct dm_pmic_ops *ops = dev_get_driver_ops(dev);
+	int count;
+
+	/* The cache is indexed by byte, so needs single-byte registers */
+	if (!IS_ENABLED(CONFIG_PMIC_REG_CACHE) || !ops || !ops->reg_volatile ||
+	    priv->trans_len != 1)
+		return 0;
+
+	count = pmic_reg_count(dev);
+	if (count <= 0)
+		return 0;
+
+	priv->cache = devm_kzalloc(dev, count * 2, GFP_KERNEL);
+	if (!priv->cache)
+		return -ENOMEM;
+	priv->cache_valid = priv->cache + count;
+	priv->cache_size = count;
+
+	return 0;
+}
+
 UCLASS_DRIVER(pmic) = {
 	.id		= UCLASS_PMIC,
 	.name		= "pmic",
 	.pre_probe	= pmic_pre_probe,
+	.post_probe	= pmic_post_probe,
 	.per_device_auto	= sizeof(struct uc_pmic_priv),
 };
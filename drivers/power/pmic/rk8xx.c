@@ -116,6 +116,34 @@ static int rk8xx_reg_count(struct udevice *dev)
 	return RK808_NUM_OF_REGS;
 }
 
+/*
+ * Only the regulator configuration, voltage and sleep-enable registers are
+ * cached. The enable registers of some variants have write-mask bits which
+ * do not read back, and most of the rest are status registers.
+ */
+static bool rk8xx_reg_volatile(struct udevice *dev, uint reg)
+{
+	struct rk8xx_priv *priv = dev_get_priv(dev);
+
+	switch (priv->variant) {
+	case RK806_ID:
+		return !((reg >= RK806_POWER_SLP_EN0 &&
+			  reg <= RK806_POWER_SLP_EN2) ||
+			 (reg >= 0x10 && reg <= 0x2d) ||
+			 (reg >= 0x43 && reg <= 0x4c) ||
+			 (reg >= 0x4e && reg <= 0x59));
+	case RK809_ID:
+	case RK817_ID:
+		return !((reg >= 0xb5 && reg <= 0xb6) ||
+			 (reg >= 0xba && reg <= 0xc5) ||
+			 (reg >= 0xcc && reg <= 0xdd));
+	default:
+		return !((reg >= REG_SLEEP_SET_OFF1 &&
+			  reg <= REG_SLEEP_SET_OFF2) ||
+			 (reg >= REG_BUCK1_CONFIG && reg <= REG_LDO8_SLP_VSEL));
+	}
+}
+
 #if CONFIG_IS_ENABLED(SPI) && CONFIG_IS_ENABLED(DM_SPI)
 struct rk806_cmd {
 	uint8_t	len: 4; /* Payload size in bytes - 1 */
@@ -350,6 +378,7 @@ static struct dm_pmic_ops rk8xx_ops = {
 	.reg_count = rk8xx_reg_count,
 	.read = rk8xx_read,
 	.write = rk8xx_write,
+	.reg_volatile = rk8xx_reg_volatile,
 };
 
 static const struct udevice_id rk8xx_ids[] = {
@@ -14,6 +14,7 @@
 #include <ram.h>
 #include <regmap.h>
 #include <spl.h>
+#include <spi_flash.h>
 #include <syscon.h>
 #include <asm/arch-rockchip/clock.h>
 #include <asm/arch-rockchip/cru.h>
@@ -25,6 +26,7 @@
 #include <linux/delay.h>
 #include <linux/err.h>
 #include <time.h>
+#include <u-boot/crc.h>
 
 #define PRESET_SGRF_HOLD(n)	((0x1 << (6 + 16)) | ((n) << 6))
 #define PRESET_GPIO0_HOLD(n)	((0x1 << (7 + 16)) | ((n) << 7))
@@ -63,6 +65,30 @@ struct chan_info {
 	struct msch_regs *msch;
 };
 
+/* "DRAM" */
+#define SDRAM_CACHE_MAGIC	0x4d415244
+
+/**
+ * struct sdram_cache - what was found when the DRAM was last set up
+ *
+ * Only the order in which ranks and bus widths are tried comes from the
+ * cache, so a stale cache costs time but never gives a wrong setup.
+ *
+ * @magic: SDRAM_CACHE_MAGIC
+ * @key: CRC32 of the sdram parameters from the device tree; a cache written
+ *	with other parameters is ignored
+ * @rank: Number of ranks found on each channel, 0 if none
+ * @bw: Bus width found on each channel (1 = 16 bits, 2 = 32 bits)
+ * @crc: CRC32 of the fields above
+ */
+struct sdram_cache {
+	u32 magic;
+	u32 key;
+	u8 rank[2];
+	u8 bw[2];
+	u32 crc;
+};
+
 struct dram_info {
 	u32 pwrup_srefresh_exit[2];
 	struct chan_info chan[2];
@@ -76,6 +102,7 @@ struct dram_info {
 	const struct sdram_rk3399_ops *ops;
 	struct ram_info info;
 	struct rk3399_pmugrf_regs *pmugrf;
+	struct sdram_cache cache;	/* hints from the last boot, if valid */
 };
 
 struct sdram_rk3399_ops {
@@ -2689,19 +2716,21 @@ static u64 dram_detect_cap(struct dram_info *dram,
 	u32 training_flag;
 	u32 ddrconfig;
 
-	/* detect bw */
+	/* detect bw, starting with the width found last time */
 	bw = 2;
 	if (params->base.dramtype != LPDDR4) {
+		if (dram->cache.bw[channel] == 1)
+			bw = 1;
 		dram_set_bw(chan, bw);
 		cap_info->bw = bw;
 		if (data_training(dram, channel, params,
 				  PI_READ_GATE_TRAINING)) {
-			bw = 1;
-			dram_set_bw(chan, 1);
+			bw = 3 - bw;
+			dram_set_bw(chan, bw);
 			cap_info->bw = bw;
 			if (data_training(dram, channel, params,
 					  PI_READ_GATE_TRAINING)) {
-				printf("16bit error!!!\n");
+				printf("%dbit error!!!\n", 16 * bw);
 				goto error;
 			}
 		}
@@ -2912,7 +2941,7 @@ static int sdram_init(struct dram_info *dram,
 {
 	unsigned char dramtype = params->base.dramtype;
 	unsigned int ddr_freq = params->base.ddr_freq;
-	int channel, ch, rank;
+	int channel, ch, rank, first, i;
 	u32 tmp, ret;
 
 	debug("Starting SDRAM initialization...\n");
@@ -2924,10 +2953,15 @@ static int sdram_init(struct dram_info *dram,
 		return -E2BIG;
 	}
 
-	/* detect rank */
+	/*
+	 * detect rank, starting with the count found last time: each attempt
+	 * restarts the controller, and one which fails takes longest
+	 */
 	for (ch = 0; ch < 2; ch++) {
 		params->ch[ch].cap_info.rank = 2;
-		for (rank = 2; rank != 0; rank--) {
+		first = dram->cache.rank[ch] == 1 ? 1 : 2;
+		for (i = 0; i < 2; i++) {
+			rank = i ? 3 - first : first;
 			for (channel = 0; channel < 2; channel++) {
 				const struct chan_info *chan =
 					&dram->chan[channel];
@@ -2959,6 +2993,8 @@ static int sdram_init(struct dram_info *dram,
 				break;
 			}
 		}
+		if (i == 2)
+			rank = 0;
 		/* Computed rank with associated channel number */
 		params->ch[ch].cap_info.rank = rank;
 	}
@@ -3081,10 +3117,117 @@ static const struct sdram_rk3399_ops rk3399_ops = {
 #endif
 };
 
+#if IS_ENABLED(CONFIG_RAM_ROCKCHIP_TRAINING_CACHE)
+/**
+ * rockchip_sdram_cache_read() - read the DRAM setup cache from storage
+ *
+ * The default reads it from the first SPI flash, at
+ * CONFIG_RAM_ROCKCHIP_TRAINING_CACHE_OFFSET. Boards may keep it elsewhere.
+ *
+ * @buf: Place to put the cache
+ * @size: Size of the cache in bytes
+ * Return: 0 if OK, -ve on error
+ */
+__weak int rockchip_sdram_cache_read(void *buf, int size)
+{
+#if CONFIG_IS_ENABLED(DM_SPI_FLASH)
+	struct udevice *dev;
+	int ret;
+
+	ret = uclass_first_device_err(UCLASS_SPI_FLASH, &dev);
+	if (ret)
+		return ret;
+
+	return spi_flash_read_dm(dev, CONFIG_RAM_ROCKCHIP_TRAINING_CACHE_OFFSET,
+				 size, buf);
+#else
+	return -ENOSYS;
+#endif
+}
+
+/**
+ * rockchip_sdram_cache_write() - write the DRAM setup cache to storage
+ *
+ * @buf: Cache to write
+ * @size: Size of the cache in bytes
+ * Return: 0 if OK, -ve on error
+ */
+__weak int rockchip_sdram_cache_write(const void *buf, int size)
+{
+#if CONFIG_IS_ENABLED(DM_SPI_FLASH) && !CONFIG_IS_ENABLED(SPI_FLASH_TINY)
+	u32 offset = CONFIG_RAM_ROCKCHIP_TRAINING_CACHE_OFFSET;
+	struct spi_flash *flash;
+	struct udevice *dev;
+	int ret;
+
+	ret = uclass_first_device_err(UCLASS_SPI_FLASH, &dev);
+	if (ret)
+		return ret;
+	flash = dev_get_uclass_priv(dev);
+
+	ret = spi_flash_erase_dm(dev, offset, flash->erase_size);
+	if (ret)
+		return ret;
+
+	return spi_flash_write_dm(dev, offset, size, buf);
+#else
+	return -ENOSYS;
+#endif
+}
+
+static u32 sdram_cache_crc(const struct sdram_cache *cache)
+{
+	return crc32(0, (const void *)cache, offsetof(struct sdram_cache, crc));
+}
+
+static void sdram_cache_load(struct dram_info *dram, u32 key)
+{
+	struct sdram_cache *cache = &dram->cache;
+
+	if (rockchip_sdram_cache_read(cache, sizeof(*cache)) ||
+	    cache->magic != SDRAM_CACHE_MAGIC || cache->key != key ||
+	    cache->crc != sdram_cache_crc(cache)) {
+		debug("%s: no valid DRAM cache\n", __func__);
+		memset(cache, '\0', sizeof(*cache));
+	}
+}
+
+/* Record what was found, if it differs from what the cache said */
+static void sdram_cache_store(struct dram_info *dram, u32 key,
+			      const struct rk3399_sdram_params *params)
+{
+	struct sdram_cache cache = {
+		.magic	= SDRAM_CACHE_MAGIC,
+		.key	= key,
+	};
+	int ch;
+
+	for (ch = 0; ch < 2; ch++) {
+		const struct sdram_cap_info *cap_info = &params->ch[ch].cap_info;
+
+		cache.rank[ch] = cap_info->rank;
+		if (cap_info->rank && cap_info->bw <= 2)
+			cache.bw[ch] = cap_info->bw;
+	}
+	cache.crc = sdram_cache_crc(&cache);
+	if (!memcmp(&cache, &dram->cache, sizeof(cache)))
+		return;
+
+	if (rockchip_sdram_cache_write(&cache, sizeof(cache)))
+		debug("%s: cannot write DRAM cache\n", __func__);
+}
+#else
+static void sdram_cache_load(struct dram_info *dram, u32 key) {}
+
+static void sdram_cache_store(struct dram_info *dram, u32 key,
+			      const struct rk3399_sdram_params *params) {}
+#endif
+
 static int rk3399_dmc_init(struct udevice *dev)
 {
 	struct dram_info *priv = dev_get_priv(dev);
 	struct rockchip_dmc_plat *plat = dev_get_plat(dev);
+	u32 key = 0;
 	int ret;
 #if CONFIG_IS_ENABLED(OF_REAL)
 	struct rk3399_sdram_params *params = &plat->sdram_params;
@@ -3138,11 +3281,17 @@ static int rk3399_dmc_init(struct udevice *dev)
 		return ret;
 	}
 
+	if (IS_ENABLED(CONFIG_RAM_ROCKCHIP_TRAINING_CACHE)) {
+		key = crc32(0, (const void *)params, sizeof(*params));
+		sdram_cache_load(priv, key);
+	}
+
 	ret = sdram_init(priv, params);
 	if (ret < 0) {
 		printf("%s DRAM init failed %d\n", __func__, ret);
 		return ret;
 	}
+	sdram_cache_store(priv, key, params);
 
 	return 0;
 }
@@ -232,27 +232,104 @@ int serial_initialize(void)
 	return serial_init();
 }
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+/* Send as much of the TX buffer as the UART will take without waiting */
+static void serial_tx_drain(struct udevice *dev)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	uint rd;
+
+	/* The driver's putc() may call schedule(), which comes back here */
+	if (upriv->tx_busy)
+		return;
+	upriv->tx_busy = true;
+	while (upriv->tx_rd != upriv->tx_wr) {
+		rd = upriv->tx_rd % CONFIG_SERIAL_TX_BUFFER_SIZE;
+		if (ops->putc(dev, upriv->tx_buf[rd]) == -EAGAIN)
+			break;
+		upriv->tx_rd++;
+	}
+	upriv->tx_busy = false;
+}
+
+static void serial_tx_cyclic(struct cyclic_info *c)
+{
+	struct serial_dev_priv *upriv;
+
+	upriv = container_of(c, struct serial_dev_priv, tx_cyclic);
+	serial_tx_drain(upriv->dev);
+}
+
+/* Add a character to the TX buffer, waiting for room if needed */
+static void serial_tx_queue(struct udevice *dev, char ch)
+{
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	BUILD_BUG_ON_NOT_POWER_OF_2(CONFIG_SERIAL_TX_BUFFER_SIZE);
+
+	while (upriv->tx_wr - upriv->tx_rd == CONFIG_SERIAL_TX_BUFFER_SIZE) {
+		/* Printing from within a drain cannot make room, so drop it */
+		if (upriv->tx_busy)
+			return;
+		serial_tx_drain(dev);
+	}
+	upriv->tx_buf[upriv->tx_wr++ % CONFIG_SERIAL_TX_BUFFER_SIZE] = ch;
+}
+
+bool serial_tx_congested(void)
+{
+	struct serial_dev_priv *upriv;
+
+	if (!gd->cur_serial_dev)
+		return false;
+	upriv = dev_get_uclass_priv(gd->cur_serial_dev);
+
+	return upriv->tx_wr - upriv->tx_rd >
+		CONFIG_SERIAL_TX_BUFFER_SIZE / 4 * 3;
+}
+#endif /* CONFIG_IS_ENABLED(SERIAL_TX_BUFFER) */
+
 static void _serial_flush(struct udevice *dev)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+
+	while (upriv->tx_rd != upriv->tx_wr && !upriv->tx_busy)
+		serial_tx_drain(dev);
+#endif
 	if (!ops->pending)
 		return;
 	while (ops->pending(dev, false) > 0)
 		;
 }
 
-static void _serial_putc(struct udevice *dev, char ch)
+static void __serial_putc(struct udevice *dev, char ch)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 	int err;
 
-	if (ch == '\n')
-		_serial_putc(dev, '\r');
-
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	/* Devices probed before relocation go away, so only buffer after */
+	if (gd->flags & GD_FLG_RELOC) {
+		serial_tx_queue(dev, ch);
+		serial_tx_drain(dev);
+		return;
+	}
+#endif
 	do {
 		err = ops->putc(dev, ch);
 	} while (err == -EAGAIN);
+}
+
+static void _serial_putc(struct udevice *dev, char ch)
+{
+	if (ch == '\n')
+		_serial_putc(dev, '\r');
+
+	__serial_putc(dev, ch);
 
 	if (IS_ENABLED(CONFIG_CONSOLE_FLUSH_ON_NEWLINE) && ch == '\n')
 		_serial_flush(dev);
@@ -278,7 +355,8 @@ static void _serial_puts(struct udevice *dev, const char *str)
 {
 	struct dm_serial_ops *ops = serial_get_ops(dev);
 
-	if (!CONFIG_IS_ENABLED(SERIAL_PUTS) || !ops->puts) {
+	if (!CONFIG_IS_ENABLED(SERIAL_PUTS) || !ops->puts ||
+	    CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)) {
 		while (*str)
 			_serial_putc(dev, *str++);
 		return;
@@ -574,6 +652,17 @@ static int serial_post_probe(struct udevice *dev)
 			return ret;
 	}
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	/* Output is only buffered after relocation, see __serial_putc() */
+	if (gd->flags & GD_FLG_RELOC) {
+		struct serial_dev_priv *tpriv = dev_get_uclass_priv(dev);
+
+		tpriv->dev = dev;
+		cyclic_register(&tpriv->tx_cyclic, serial_tx_cyclic, 1000,
+				dev->name);
+	}
+#endif
+
 #if CONFIG_IS_ENABLED(DM_STDIO)
 	if (!(gd->flags & GD_FLG_RELOC))
 		return 0;
@@ -595,12 +684,22 @@ static int serial_post_probe(struct udevice *dev)
 
 static int serial_pre_remove(struct udevice *dev)
 {
-#if CONFIG_IS_ENABLED(SYS_STDIO_DEREGISTER)
+#if CONFIG_IS_ENABLED(SYS_STDIO_DEREGISTER) || CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
 	struct serial_dev_priv *upriv = dev_get_uclass_priv(dev);
+#endif
 
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	/* Send everything before the OS takes over the UART */
+	_serial_flush(dev);
+#endif
+#if CONFIG_IS_ENABLED(SYS_STDIO_DEREGISTER)
 	if (stdio_deregister_dev(upriv->sdev, true))
 		return -EPERM;
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	if (upriv->dev)
+		cyclic_unregister(&upriv->tx_cyclic);
+#endif
 
 	return 0;
 }
@@ -8,6 +8,7 @@
  *	   Jon Lin <Jon.lin@rock-chips.com>
  */
 
+#include <asm/cache.h>
 #include <asm/io.h>
 #include <bouncebuf.h>
 #include <clk.h>
@@ -16,6 +17,7 @@
 #include <linux/bitops.h>
 #include <linux/delay.h>
 #include <linux/iopoll.h>
+#include <linux/kernel.h>
 #include <spi.h>
 #include <spi-mem.h>
 
@@ -357,6 +359,19 @@ static int rockchip_sfc_wait_for_dma_finished(struct rockchip_sfc *sfc, int time
 	return 0;
 }
 
+/*
+ * The DMA master only takes a 32-bit address, so the buffer must be below
+ * 4GiB as well as aligned to use it directly
+ */
+static int rockchip_sfc_dma_addr_aligned(struct bounce_buffer *state)
+{
+	ulong addr = (ulong)state->user_buffer;
+
+	return IS_ALIGNED(addr, ARCH_DMA_MINALIGN) &&
+	       state->len == state->len_aligned &&
+	       !upper_32_bits(addr + state->len_aligned - 1);
+}
+
 static int rockchip_sfc_xfer_setup(struct rockchip_sfc *sfc,
 				   struct spi_slave *mem,
 				   const struct spi_mem_op *op,
@@ -526,12 +541,15 @@ static int rockchip_sfc_xfer_data_dma(struct rockchip_sfc *sfc,
 		bb_flags = GEN_BB_WRITE;
 	}
 
-	ret = bounce_buffer_start(&bb, dma_buf, len, bb_flags);
+	ret = bounce_buffer_start_extalign(&bb, dma_buf, len, bb_flags,
+					   ARCH_DMA_MINALIGN,
+					   rockchip_sfc_dma_addr_aligned);
 	if (ret)
 		return ret;
 
 	ret = rockchip_sfc_fifo_transfer_dma(sfc, (dma_addr_t)bb.bounce_buffer, len);
-	rockchip_sfc_wait_for_dma_finished(sfc, len * 10);
+	if (rockchip_sfc_wait_for_dma_finished(sfc, len * 10))
+		ret = -ETIMEDOUT;
 	bounce_buffer_stop(&bb);
 
 	return ret;
@@ -586,6 +604,23 @@ static int rockchip_sfc_adjust_op_size(struct spi_slave *mem, struct spi_mem_op
 
 	op->data.nbytes = min(op->data.nbytes, sfc->max_iosize);
 
+	/*
+	 * Split reads at cache-line boundaries in the buffer, so that the bulk
+	 * of the data is sent by DMA straight into it rather than through a
+	 * bounce buffer. The unaligned head and tail are small enough to use
+	 * the FIFO.
+	 */
+	if (sfc->use_dma && op->data.dir == SPI_MEM_DATA_IN) {
+		ulong buf = (ulong)op->data.buf.in;
+		ulong head = ALIGN(buf, ARCH_DMA_MINALIGN) - buf;
+
+		if (head)
+			op->data.nbytes = min_t(ulong, op->data.nbytes, head);
+		else if (op->data.nbytes >= ARCH_DMA_MINALIGN)
+			op->data.nbytes = ALIGN_DOWN(op->data.nbytes,
+						     ARCH_DMA_MINALIGN);
+	}
+
 	return 0;
 }
 
@@ -20,6 +20,7 @@
 #include <hexdump.h>
 #include <scsi.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 #include <asm/dma-mapping.h>
 #include <linux/bitops.h>
 #include <linux/delay.h>
@@ -59,6 +60,9 @@
 /* maximum bytes per request */
 #define UFS_MAX_BYTES	(128 * 256 * 1024)
 
+/* smallest piece a read or write is split into when using several slots */
+#define UFS_MIN_SLOT_BYTES	(64 * 1024)
+
 static inline bool ufshcd_is_hba_active(struct ufs_hba *hba);
 static inline void ufshcd_hba_stop(struct ufs_hba *hba);
 static int ufshcd_hba_enable(struct ufs_hba *hba);
@@ -607,21 +611,26 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
 	dma_addr_t cmd_desc_dma_addr;
 	u16 response_offset;
 	u16 prdt_offset;
+	int i;
 
-	utrdlp = hba->utrdl;
-	cmd_desc_dma_addr = (dma_addr_t)hba->ucdl;
+	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
+	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
 
-	utrdlp->command_desc_base_addr_lo =
+	/* Each transfer request slot has its own command descriptor */
+	for (i = 0; i < hba->nutrs; i++) {
+		utrdlp = &hba->utrdl[i];
+		cmd_desc_dma_addr = (dma_addr_t)&hba->ucdl[i];
+
+		utrdlp->command_desc_base_addr_lo =
 				cpu_to_le32(lower_32_bits(cmd_desc_dma_addr));
-	utrdlp->command_desc_base_addr_hi =
+		utrdlp->command_desc_base_addr_hi =
 				cpu_to_le32(upper_32_bits(cmd_desc_dma_addr));
 
-	response_offset = offsetof(struct utp_transfer_cmd_desc, response_upiu);
-	prdt_offset = offsetof(struct utp_transfer_cmd_desc, prd_table);
-
-	utrdlp->response_upiu_offset = cpu_to_le16(response_offset >> 2);
-	utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
-	utrdlp->response_upiu_length = cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+		utrdlp->response_upiu_offset = cpu_to_le16(response_offset >> 2);
+		utrdlp->prd_table_offset = cpu_to_le16(prdt_offset >> 2);
+		utrdlp->response_upiu_length =
+				cpu_to_le16(ALIGNED_UPIU_SIZE >> 2);
+	}
 
 	hba->ucd_req_ptr = (struct utp_upiu_req *)hba->ucdl;
 	hba->ucd_rsp_ptr =
@@ -635,23 +644,23 @@ static void ufshcd_host_memory_configure(struct ufs_hba *hba)
  */
 static int ufshcd_memory_alloc(struct ufs_hba *hba)
 {
-	/* Allocate one Transfer Request Descriptor
+	/* Allocate a Transfer Request Descriptor for each slot in use
 	 * Should be aligned to 1k boundary.
 	 */
 	hba->utrdl = memalign(1024,
-			      ALIGN(sizeof(struct utp_transfer_req_desc),
-				    ARCH_DMA_MINALIGN));
+			      ALIGN(sizeof(struct utp_transfer_req_desc) *
+				    hba->nutrs, ARCH_DMA_MINALIGN));
 	if (!hba->utrdl) {
 		dev_err(hba->dev, "Transfer Descriptor memory allocation failed\n");
 		return -ENOMEM;
 	}
 
-	/* Allocate one Command Descriptor
+	/* Allocate a Command Descriptor for each slot in use
 	 * Should be aligned to 1k boundary.
 	 */
 	hba->ucdl = memalign(1024,
-			     ALIGN(sizeof(struct utp_transfer_cmd_desc),
-				   ARCH_DMA_MINALIGN));
+			     ALIGN(sizeof(struct utp_transfer_cmd_desc) *
+				   hba->nutrs, ARCH_DMA_MINALIGN));
 	if (!hba->ucdl) {
 		dev_err(hba->dev, "Command descriptor memory allocation failed\n");
 		return -ENOMEM;
@@ -731,10 +740,11 @@ static void ufshcd_cache_invalidate(void *addr, unsigned long size)
  * descriptor according to request
  */
 static void ufshcd_prepare_req_desc_hdr(struct ufs_hba *hba,
+					unsigned int task_tag,
 					u32 *upiu_flags,
 					enum dma_data_direction cmd_dir)
 {
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
+	struct utp_transfer_req_desc *req_desc = &hba->utrdl[task_tag];
 	u32 data_direction;
 	u32 dword_0;
 
@@ -841,7 +851,7 @@ static int ufshcd_comp_devman_upiu(struct ufs_hba *hba,
 
 	hba->dev_cmd.type = cmd_type;
 
-	ufshcd_prepare_req_desc_hdr(hba, &upiu_flags, DMA_NONE);
+	ufshcd_prepare_req_desc_hdr(hba, TASK_TAG, &upiu_flags, DMA_NONE);
 	switch (cmd_type) {
 	case DEV_CMD_TYPE_QUERY:
 		ufshcd_prepare_utp_query_req_upiu(hba, upiu_flags);
@@ -891,6 +901,62 @@ static int ufshcd_send_command(struct ufs_hba *hba, unsigned int task_tag)
 	return 0;
 }
 
+#if IS_ENABLED(CONFIG_UFS_MULTI_REQ)
+/**
+ * ufshcd_send_commands() - Issue several requests and wait for them all
+ *
+ * The doorbell bits are rung together so the device can work on all of the
+ * requests at once. Completions are reaped in batches: each time the
+ * interrupt status shows a completion it is cleared and the doorbell is read
+ * back to see which slots are still outstanding.
+ *
+ * @hba: UFS host
+ * @tags: Mask of the transfer request slots to issue
+ * Return: 0 if all requests completed, -ve on error or timeout
+ */
+static int ufshcd_send_commands(struct ufs_hba *hba, u32 tags)
+{
+	unsigned long start;
+	u32 intr_status;
+	u32 enabled_intr_status;
+	u32 pending = tags;
+
+	ufshcd_writel(hba, tags, REG_UTP_TRANSFER_REQ_DOOR_BELL);
+
+	/* Make sure doorbell reg is updated before reading interrupt status */
+	wmb();
+
+	start = get_timer(0);
+	while (pending) {
+		intr_status = ufshcd_readl(hba, REG_INTERRUPT_STATUS);
+		enabled_intr_status = intr_status & hba->intr_mask;
+		ufshcd_writel(hba, intr_status, REG_INTERRUPT_STATUS);
+
+		if (enabled_intr_status & UFSHCD_ERROR_MASK) {
+			dev_err(hba->dev, "Error in status:%08x\n",
+				enabled_intr_status);
+
+			return -1;
+		}
+
+		if (enabled_intr_status & UTP_TRANSFER_REQ_COMPL)
+			pending = ufshcd_readl(hba,
+					       REG_UTP_TRANSFER_REQ_DOOR_BELL) &
+				  tags;
+
+		if (pending && get_timer(start) > QUERY_REQ_TIMEOUT) {
+			dev_err(hba->dev,
+				"Timedout waiting for UTP responses (%08x)\n",
+				pending);
+
+			return -ETIMEDOUT;
+		}
+	}
+
+	return 0;
+}
+#endif
+
 /**
  * ufshcd_get_req_rsp - returns the TR response transaction type
  */
@@ -905,9 +971,10 @@ static inline int ufshcd_get_req_rsp(struct utp_upiu_rsp *ucd_rsp_ptr)
  * ufshcd_get_tr_ocs - Get the UTRD Overall Command Status
  *
  */
-static inline int ufshcd_get_tr_ocs(struct ufs_hba *hba)
+static inline int ufshcd_get_tr_ocs(struct ufs_hba *hba,
+				    unsigned int task_tag)
 {
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
+	struct utp_transfer_req_desc *req_desc = &hba->utrdl[task_tag];
 
 	ufshcd_cache_invalidate(req_desc, sizeof(*req_desc));
 
@@ -982,7 +1049,7 @@ static int ufshcd_exec_dev_cmd(struct ufs_hba *hba, enum dev_cmd_type cmd_type,
 	if (err)
 		return err;
 
-	err = ufshcd_get_tr_ocs(hba);
+	err = ufshcd_get_tr_ocs(hba, TASK_TAG);
 	if (err) {
 		dev_err(hba->dev, "Error in OCS:%d\n", err);
 		return -EINVAL;
@@ -1438,15 +1505,19 @@ static int ufshcd_uic_change_pwr_mode(struct ufs_hba *hba, u8 mode)
 
 static
 void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba,
-				      struct scsi_cmd *pccb, u32 upiu_flags)
+				      struct scsi_cmd *pccb, u32 upiu_flags,
+				      unsigned int task_tag)
 {
-	struct utp_upiu_req *ucd_req_ptr = hba->ucd_req_ptr;
+	struct utp_transfer_cmd_desc *ucd = &hba->ucdl[task_tag];
+	struct utp_upiu_req *ucd_req_ptr = (struct utp_upiu_req *)ucd;
+	struct utp_upiu_rsp *ucd_rsp_ptr =
+		(struct utp_upiu_rsp *)ucd->response_upiu;
 	unsigned int cdb_len;
 
 	/* command descriptor fields */
 	ucd_req_ptr->header.dword_0 =
 			UPIU_HEADER_DWORD(UPIU_TRANSACTION_COMMAND, upiu_flags,
-					  pccb->lun, TASK_TAG);
+					  pccb->lun, task_tag);
 	ucd_req_ptr->header.dword_1 =
 			UPIU_HEADER_DWORD(UPIU_COMMAND_SET_TYPE_SCSI, 0, 0, 0);
 
@@ -1459,9 +1530,9 @@ void ufshcd_prepare_utp_scsi_cmd_upiu(struct ufs_hba *hba,
 	memset(ucd_req_ptr->sc.cdb, 0, UFS_CDB_SIZE);
 	memcpy(ucd_req_ptr->sc.cdb, pccb->cmd, cdb_len);
 
-	memset(hba->ucd_rsp_ptr, 0, sizeof(struct utp_upiu_rsp));
+	memset(ucd_rsp_ptr, 0, sizeof(struct utp_upiu_rsp));
 	ufshcd_cache_flush(ucd_req_ptr, sizeof(*ucd_req_ptr));
-	ufshcd_cache_flush(hba->ucd_rsp_ptr, sizeof(*hba->ucd_rsp_ptr));
+	ufshcd_cache_flush(ucd_rsp_ptr, sizeof(*ucd_rsp_ptr));
 }
 
 static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
@@ -1472,10 +1543,11 @@ static inline void prepare_prdt_desc(struct ufshcd_sg_entry *entry,
 	entry->upper_addr = cpu_to_le32(upper_32_bits((unsigned long)buf));
 }
 
-static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
+static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb,
+			       unsigned int task_tag)
 {
-	struct utp_transfer_req_desc *req_desc = hba->utrdl;
-	struct ufshcd_sg_entry *prd_table = hba->ucd_prdt_ptr;
+	struct utp_transfer_req_desc *req_desc = &hba->utrdl[task_tag];
+	struct ufshcd_sg_entry *prd_table = hba->ucdl[task_tag].prd_table;
 	ulong datalen = pccb->datalen;
 	int table_length;
 	u8 *buf;
@@ -1504,30 +1576,33 @@ static void prepare_prdt_table(struct ufs_hba *hba, struct scsi_cmd *pccb)
 	ufshcd_cache_flush(req_desc, sizeof(*req_desc));
 }
 
-static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
+/* Set up a transfer request slot to carry a SCSI command */
+static void ufshcd_prepare_scsi_slot(struct ufs_hba *hba,
+				     struct scsi_cmd *pccb,
+				     unsigned int task_tag)
 {
-	struct ufs_hba *hba = dev_get_uclass_priv(scsi_dev->parent);
 	u32 upiu_flags;
-	int ocs, result = 0;
-	u8 scsi_status;
 
-	ufshcd_prepare_req_desc_hdr(hba, &upiu_flags, pccb->dma_dir);
-	ufshcd_prepare_utp_scsi_cmd_upiu(hba, pccb, upiu_flags);
-	prepare_prdt_table(hba, pccb);
-
-	ufshcd_cache_flush(pccb->pdata, pccb->datalen);
-
-	ufshcd_send_command(hba, TASK_TAG);
+	ufshcd_prepare_req_desc_hdr(hba, task_tag, &upiu_flags, pccb->dma_dir);
+	ufshcd_prepare_utp_scsi_cmd_upiu(hba, pccb, upiu_flags, task_tag);
+	prepare_prdt_table(hba, pccb, task_tag);
+}
 
-	ufshcd_cache_invalidate(pccb->pdata, pccb->datalen);
+/* Check the outcome of a completed SCSI command in a slot */
+static int ufshcd_scsi_result(struct ufs_hba *hba, unsigned int task_tag)
+{
+	struct utp_upiu_rsp *ucd_rsp_ptr =
+		(struct utp_upiu_rsp *)hba->ucdl[task_tag].response_upiu;
+	int ocs, result;
+	u8 scsi_status;
 
-	ocs = ufshcd_get_tr_ocs(hba);
+	ocs = ufshcd_get_tr_ocs(hba, task_tag);
 	switch (ocs) {
 	case OCS_SUCCESS:
-		result = ufshcd_get_req_rsp(hba->ucd_rsp_ptr);
+		result = ufshcd_get_req_rsp(ucd_rsp_ptr);
 		switch (result) {
 		case UPIU_TRANSACTION_RESPONSE:
-			result = ufshcd_get_rsp_upiu_result(hba->ucd_rsp_ptr);
+			result = ufshcd_get_rsp_upiu_result(ucd_rsp_ptr);
 
 			scsi_status = result & MASK_SCSI_STATUS;
 			if (scsi_status)
@@ -1554,6 +1629,100 @@ static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
 	return 0;
 }
 
+#if IS_ENABLED(CONFIG_UFS_MULTI_REQ)
+/**
+ * ufs_scsi_exec_split() - Run a large read or write using several slots
+ *
+ * The transfer is split into pieces, one per transfer request slot, each a
+ * READ(10) or WRITE(10) of its own covering part of the blocks. All pieces
+ * are issued together so the device can work on them concurrently.
+ *
+ * @hba: UFS host
+ * @pccb: SCSI command to run, a READ(10) or WRITE(10)
+ * @count: Number of slots to use, at least 2
+ * Return: 0 if OK, -ve on error
+ */
+static int ufs_scsi_exec_split(struct ufs_hba *hba, struct scsi_cmd *pccb,
+			       int count)
+{
+	struct scsi_cmd piece = *pccb;
+	ulong blocks, blksz, per_slot, lba;
+	u32 tags = 0;
+	int i, ret;
+
+	lba = get_unaligned_be32(&pccb->cmd[2]);
+	blocks = get_unaligned_be16(&pccb->cmd[7]);
+	blksz = pccb->datalen / blocks;
+	per_slot = DIV_ROUND_UP(blocks, count);
+
+	for (i = 0; i < count && blocks; i++) {
+		ulong todo = min(per_slot, blocks);
+
+		put_unaligned_be32(lba, &piece.cmd[2]);
+		put_unaligned_be16(todo, &piece.cmd[7]);
+		piece.datalen = todo * blksz;
+		ufshcd_prepare_scsi_slot(hba, &piece, i);
+		tags |= 1 << i;
+
+		piece.pdata += piece.datalen;
+		lba += todo;
+		blocks -= todo;
+	}
+
+	ufshcd_cache_flush(pccb->pdata, pccb->datalen);
+
+	ret = ufshcd_send_commands(hba, tags);
+
+	ufshcd_cache_invalidate(pccb->pdata, pccb->datalen);
+	if (ret)
+		return ret;
+
+	for (i = 0; tags >> i; i++) {
+		ret = ufshcd_scsi_result(hba, i);
+		if (ret)
+			return ret;
+	}
+
+	return 0;
+}
+
+/* Work out how many slots to spread a command over, or 1 to not split it */
+static int ufs_scsi_split_count(struct ufs_hba *hba, struct scsi_cmd *pccb)
+{
+	ulong blocks;
+
+	if (pccb->cmd[0] != SCSI_READ10 && pccb->cmd[0] != SCSI_WRITE10)
+		return 1;
+	blocks = get_unaligned_be16(&pccb->cmd[7]);
+	if (!blocks || pccb->datalen % blocks)
+		return 1;
+
+	return min_t(ulong, min_t(ulong, hba->nutrs, blocks),
+		     pccb->datalen / UFS_MIN_SLOT_BYTES);
+}
+#endif
+
+static int ufs_scsi_exec(struct udevice *scsi_dev, struct scsi_cmd *pccb)
+{
+	struct ufs_hba *hba = dev_get_uclass_priv(scsi_dev->parent);
+
+#if IS_ENABLED(CONFIG_UFS_MULTI_REQ)
+	int count = ufs_scsi_split_count(hba, pccb);
+
+	if (count > 1)
+		return ufs_scsi_exec_split(hba, pccb, count);
+#endif
+	ufshcd_prepare_scsi_slot(hba, pccb, TASK_TAG);
+
+	ufshcd_cache_flush(pccb->pdata, pccb->datalen);
+
+	ufshcd_send_command(hba, TASK_TAG);
+
+	ufshcd_cache_invalidate(pccb->pdata, pccb->datalen);
+
+	return ufshcd_scsi_result(hba, TASK_TAG);
+}
+
 static inline int ufshcd_read_desc(struct ufs_hba *hba, enum desc_idn desc_id,
 				   int desc_index, u8 *buf, u32 size)
 {
@@ -1966,6 +2135,11 @@ int ufshcd_probe(struct udevice *ufs_dev, struct ufs_hba_ops *hba_ops)
 	hba->capabilities = ufshcd_readl(hba, REG_CONTROLLER_CAPABILITIES);
 	if (hba->quirks & UFSHCD_QUIRK_BROKEN_64BIT_ADDRESS)
 		hba->capabilities &= ~MASK_64_ADDRESSING_SUPPORT;
+	if (IS_ENABLED(CONFIG_UFS_MULTI_REQ))
+		hba->nutrs = (hba->capabilities &
+			      MASK_TRANSFER_REQUESTS_SLOTS) + 1;
+	else
+		hba->nutrs = 1;
 
 	/* Get UFS version supported by the controller */
 	hba->version = ufshcd_get_ufs_version(hba);
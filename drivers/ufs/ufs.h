@@ -875,6 +875,8 @@ struct ufs_hba {
 	struct ufs_hba_ops	*ops;
 	struct ufs_desc_size	desc_size;
 	u32			capabilities;
+	/* number of transfer request slots in use */
+	int			nutrs;
 	u32			version;
 	u32			intr_mask;
 	enum ufshcd_quirks	quirks;
@@ -828,6 +828,12 @@ static void dwc3_prepare_one_trb(struct dwc3_ep *dep,
  * transfers. The function returns once there are no more TRBs available or
  * it runs out of requests.
  */
+static bool dwc3_gadget_multi_req(struct dwc3_ep *dep)
+{
+	return IS_ENABLED(CONFIG_USB_DWC3_GADGET_MULTI_REQ) &&
+	       !usb_endpoint_xfer_isoc(dep->endpoint.desc);
+}
+
 static void dwc3_prepare_trbs(struct dwc3_ep *dep, bool starting)
 {
 	struct dwc3_request	*req, *n;
@@ -882,14 +888,26 @@ static void dwc3_prepare_trbs(struct dwc3_ep *dep, bool starting)
 	list_for_each_entry_safe(req, n, &dep->request_list, list) {
 		unsigned	length;
 		dma_addr_t	dma;
+		bool		last;
 
 		dma = req->request.dma;
 		length = req->request.length;
 
+		/*
+		 * Bulk and interrupt endpoints may take as many requests as
+		 * there are free TRBs, one TRB each, with LST on the final
+		 * one. The core then moves from one request to the next
+		 * without waiting for us.
+		 */
+		last = !dwc3_gadget_multi_req(dep) || trbs_left <= 1 ||
+		       list_is_last(&req->list, &dep->request_list);
+
 		dwc3_prepare_one_trb(dep, req, dma, length,
-				     true, false, 0);
+				     last, false, 0);
 
-		break;
+		if (last)
+			break;
+		trbs_left--;
 	}
 }
 
@@ -1827,6 +1845,35 @@ static int __dwc3_cleanup_done_trbs(struct dwc3 *dwc, struct dwc3_ep *dep,
 	return 0;
 }
 
+/*
+ * With several requests on the ring one event may find more than one of
+ * them finished, so give back every request whose TRB the core has handed
+ * back and stop at the first one it still owns. Events for TRBs retired this
+ * way find nothing left to do. The endpoint stays busy until the ring is
+ * empty or the transfer has ended, so that a later XferNotReady restarts it
+ * from the first request still queued.
+ */
+static int dwc3_cleanup_done_multi_reqs(struct dwc3 *dwc, struct dwc3_ep *dep,
+		const struct dwc3_event_depevt *event, int status)
+{
+	struct dwc3_request	*req;
+	struct dwc3_trb		*trb;
+
+	while ((req = next_request(&dep->req_queued))) {
+		trb = &dep->trb_pool[req->start_slot];
+
+		dwc3_flush_cache((uintptr_t)trb, sizeof(*trb));
+		if (trb->ctrl & DWC3_TRB_CTRL_HWO)
+			break;
+
+		__dwc3_cleanup_done_trbs(dwc, dep, req, trb, event, status);
+		dwc3_gadget_giveback(dep, req, status);
+	}
+
+	return list_empty(&dep->req_queued) ||
+	       event->endpoint_event == DWC3_DEPEVT_XFERCOMPLETE;
+}
+
 static int dwc3_cleanup_done_reqs(struct dwc3 *dwc, struct dwc3_ep *dep,
 		const struct dwc3_event_depevt *event, int status)
 {
@@ -1834,6 +1881,9 @@ static int dwc3_cleanup_done_reqs(struct dwc3 *dwc, struct dwc3_ep *dep,
 	struct dwc3_trb		*trb;
 	unsigned int		slot;
 
+	if (dwc3_gadget_multi_req(dep))
+		return dwc3_cleanup_done_multi_reqs(dwc, dep, event, status);
+
 	req = next_request(&dep->req_queued);
 	if (!req) {
 		WARN_ON_ONCE(1);
@@ -14,7 +14,12 @@
 #include <linux/usb/composite.h>
 #include "u_os_desc.h"
 
+/* DFU transfers its download blocks through the ep0 request buffer */
+#if defined(CONFIG_DFU_USB_TRANSFER_SIZE) && CONFIG_DFU_USB_TRANSFER_SIZE > 4096
+#define USB_BUFSIZ	CONFIG_DFU_USB_TRANSFER_SIZE
+#else
 #define USB_BUFSIZ	4096
+#endif
 
 /* Helper type for accessing packed u16 pointers */
 typedef struct { __le16 val; } __packed __le16_packed;
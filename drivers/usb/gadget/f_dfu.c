@@ -203,7 +203,7 @@ static int handle_getstatus(struct usb_request *req)
 
 	if (f_dfu->poll_timeout)
 		if (!(f_dfu->blk_seq_num %
-		      (dfu_get_buf_size() / DFU_USB_BUFSIZ)))
+		      max(dfu_get_buf_size() / DFU_USB_BUFSIZ, 1UL)))
 			dfu_set_poll_timeout(dstat, f_dfu->poll_timeout);
 
 	/* send status response */
@@ -20,8 +20,8 @@
 #define DFU_BIT_CAN_UPLOAD		(0x1 << 1)
 #define DFU_BIT_CAN_DNLOAD		0x1
 
-/* big enough to hold our biggest descriptor */
-#define DFU_USB_BUFSIZ			4096
+/* largest block in a DNLOAD/UPLOAD, also big enough for our descriptors */
+#define DFU_USB_BUFSIZ			CONFIG_DFU_USB_TRANSFER_SIZE
 
 #define USB_REQ_DFU_DETACH		0x00
 #define USB_REQ_DFU_DNLOAD		0x01
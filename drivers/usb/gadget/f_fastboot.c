@@ -44,6 +44,9 @@ struct f_fastboot {
 	/* IN/OUT EP's and corresponding requests */
 	struct usb_ep *in_ep, *out_ep;
 	struct usb_request *in_req, *out_req;
+
+	/* out_req's own buffer, while it receives into the download buffer */
+	void *out_buf;
 };
 
 static char fb_ext_prop_name[] = "DeviceInterfaceGUID";
@@ -283,7 +286,7 @@ static void fastboot_disable(struct usb_function *f)
 	usb_ep_disable(f_fb->in_ep);
 
 	if (f_fb->out_req) {
-		free(f_fb->out_req->buf);
+		free(f_fb->out_buf);
 		usb_ep_free_request(f_fb->out_ep, f_fb->out_req);
 		f_fb->out_req = NULL;
 	}
@@ -339,6 +342,7 @@ static int fastboot_set_alt(struct usb_function *f,
 		goto err;
 	}
 	f_fb->out_req->complete = rx_handler_command;
+	f_fb->out_buf = f_fb->out_req->buf;
 
 	d = fb_ep_desc(gadget, &fs_ep_in, &hs_ep_in, &ss_ep_in);
 	ret = usb_ep_enable(f_fb->in_ep, d);
@@ -449,12 +453,46 @@ static unsigned int rx_bytes_expected(struct usb_ep *ep)
 	return rx_remain;
 }
 
+/*
+ * Queue @req to receive the part of a streamed download which follows the
+ * @len bytes it holds, straight into the download buffer. This lets the
+ * controller receive it while the data before it is written to flash.
+ */
+static bool rx_queue_stream(struct usb_ep *ep, struct usb_request *req,
+			    unsigned int len)
+{
+	unsigned int rx_remain = fastboot_data_remaining() - len;
+	unsigned int maxpacket = usb_endpoint_maxp(ep->desc);
+	void *buf;
+	u32 size;
+
+	buf = fastboot_data_stream_buf(len, &size);
+	if (!buf || !rx_remain ||
+	    !IS_ALIGNED((ulong)buf, CONFIG_SYS_CACHELINE_SIZE))
+		return false;
+
+	/* As in rx_bytes_expected(), ask for a whole number of packets */
+	if (rx_remain < size)
+		len = roundup(rx_remain, maxpacket);
+	else
+		len = rounddown(size, maxpacket);
+	if (!len || len > size)
+		return false;
+
+	req->buf = buf;
+	req->length = len;
+	req->actual = 0;
+
+	return !usb_ep_queue(ep, req, 0);
+}
+
 static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 {
 	char response[FASTBOOT_RESPONSE_LEN] = {0};
 	unsigned int transfer_size = fastboot_data_remaining();
 	const unsigned char *buffer = req->buf;
 	unsigned int buffer_size = req->actual;
+	bool queued;
 
 	if (req->status != 0) {
 		printf("Bad status: %d\n", req->status);
@@ -464,8 +502,18 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	if (buffer_size < transfer_size)
 		transfer_size = buffer_size;
 
+	queued = rx_queue_stream(ep, req, transfer_size);
+
 	fastboot_data_download(buffer, transfer_size, response);
 	if (response[0]) {
+		/* Give up on the download and wait for the next command */
+		req->complete = rx_handler_command;
+		if (queued)
+			usb_ep_dequeue(ep, req);
+		queued = false;
+		req->buf = fastboot_func->out_buf;
+		req->length = EP_BUFFER_SIZE;
+
 		fastboot_tx_write_str(response);
 	} else if (!fastboot_data_remaining()) {
 		fastboot_data_complete(response);
@@ -474,15 +522,19 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 		 * Reset global transfer variable
 		 */
 		req->complete = rx_handler_command;
+		req->buf = fastboot_func->out_buf;
 		req->length = EP_BUFFER_SIZE;
 
 		fastboot_tx_write_str(response);
-	} else {
+	} else if (!queued) {
+		req->buf = fastboot_func->out_buf;
 		req->length = rx_bytes_expected(ep);
 	}
 
-	req->actual = 0;
-	usb_ep_queue(ep, req, 0);
+	if (!queued) {
+		req->actual = 0;
+		usb_ep_queue(ep, req, 0);
+	}
 }
 
 static void do_exit_on_complete(struct usb_ep *ep, struct usb_request *req)
@@ -2498,6 +2498,7 @@ static struct fsg_common *fsg_common_init(struct fsg_common *common,
 	common->lun = 0;
 
 	/* Data buffers cyclic list */
+	BUILD_BUG_ON(FSG_BUFLEN % PAGE_CACHE_SIZE);
 	bh = common->buffhds;
 
 	i = FSG_NUM_BUFFERS;
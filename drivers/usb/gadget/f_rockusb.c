@@ -204,6 +204,10 @@ static void rockusb_disable(struct usb_function *f)
 	usb_ep_disable(f_rkusb->in_ep);
 
 	if (f_rkusb->out_req) {
+		/* the request may still point into the download buffer */
+		if (f_rkusb->cmd_buf)
+			f_rkusb->out_req->buf = f_rkusb->cmd_buf;
+		f_rkusb->cmd_buf = NULL;
 		free(f_rkusb->out_req->buf);
 		usb_ep_free_request(f_rkusb->out_ep, f_rkusb->out_req);
 		f_rkusb->out_req = NULL;
@@ -415,8 +419,8 @@ static unsigned int rx_bytes_expected(struct usb_ep *ep)
 
 	if (rx_remain <= 0)
 		return 0;
-	else if (rx_remain > EP_BUFFER_SIZE)
-		return EP_BUFFER_SIZE;
+	else if (rx_remain > RKUSB_DL_CHUNK_SIZE)
+		return RKUSB_DL_CHUNK_SIZE;
 
 	rem = rx_remain % maxpacket;
 	if (rem > 0)
@@ -484,18 +488,39 @@ static void tx_handler_ul_image(struct usb_ep *ep, struct usb_request *req)
 		printf("Error %d on queue\n", ret);
 }
 
-/* usb_request complete call back to handle down load image */
+/* Go back to receiving commands after a download */
+static void rockusb_dl_finish(struct usb_request *req)
+{
+	struct f_rockusb *f_rkusb = get_rkusb();
+
+	req->complete = rx_handler_command;
+	req->buf = f_rkusb->cmd_buf;
+	req->length = EP_BUFFER_SIZE;
+	f_rkusb->cmd_buf = NULL;
+	f_rkusb->buf = f_rkusb->buf_head;
+	f_rkusb->dl_size = 0;
+}
+
+/*
+ * usb_request complete call back to handle down load image
+ *
+ * Data arrives directly in one half of the download buffer. The request is
+ * queued again on the other half before this half is written out, so that
+ * a UDC which does DMA by itself can carry on receiving during the write.
+ */
 static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 {
 	struct f_rockusb *f_rkusb = get_rkusb();
 	unsigned int transfer_size = 0;
-	const unsigned char *buffer = req->buf;
+	void *buffer = req->buf;
 	unsigned int buffer_size = req->actual;
+	bool done;
 
 	transfer_size = f_rkusb->dl_size - f_rkusb->dl_bytes;
 
 	if (req->status != 0) {
 		printf("Bad status: %d\n", req->status);
+		rockusb_dl_finish(req);
 		rockusb_tx_write_csw(f_rkusb->tag, 0, CSW_FAIL,
 				     USB_BULK_CS_WRAP_LEN);
 		return;
@@ -504,17 +529,36 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	if (buffer_size < transfer_size)
 		transfer_size = buffer_size;
 
-	memcpy((void *)f_rkusb->buf, buffer, transfer_size);
 	f_rkusb->dl_bytes += transfer_size;
+	done = f_rkusb->dl_bytes >= f_rkusb->dl_size;
 	int blks = 0, blkcnt = transfer_size  / f_rkusb->desc->blksz;
 
+	if (!done) {
+		if (f_rkusb->buf == f_rkusb->buf_head)
+			f_rkusb->buf = f_rkusb->buf_head + RKUSB_DL_CHUNK_SIZE;
+		else
+			f_rkusb->buf = f_rkusb->buf_head;
+		req->buf = f_rkusb->buf;
+		req->length = rx_bytes_expected(ep);
+		req->actual = 0;
+		usb_ep_queue(ep, req, 0);
+
+		debug("remain %x bytes, %lx sectors\n", req->length,
+		      req->length / f_rkusb->desc->blksz);
+	}
+
 	debug("dl %x bytes, %x blks, write lba %x, dl_size:%x, dl_bytes:%x, ",
 	      transfer_size, blkcnt, f_rkusb->lba, f_rkusb->dl_size,
 	      f_rkusb->dl_bytes);
-	blks = blk_dwrite(f_rkusb->desc, f_rkusb->lba, blkcnt, f_rkusb->buf);
+	blks = blk_dwrite(f_rkusb->desc, f_rkusb->lba, blkcnt, buffer);
 	if (blks != blkcnt) {
 		printf("failed writing to device %s: %d\n", f_rkusb->dev_type,
 		       f_rkusb->dev_index);
+		if (!done)
+			usb_ep_dequeue(ep, req);
+		rockusb_dl_finish(req);
+		req->actual = 0;
+		usb_ep_queue(ep, req, 0);
 		rockusb_tx_write_csw(f_rkusb->tag, 0, CSW_FAIL,
 				     USB_BULK_CS_WRAP_LEN);
 		return;
@@ -522,27 +566,14 @@ static void rx_handler_dl_image(struct usb_ep *ep, struct usb_request *req)
 	f_rkusb->lba += blkcnt;
 
 	/* Check if transfer is done */
-	if (f_rkusb->dl_bytes >= f_rkusb->dl_size) {
-		req->complete = rx_handler_command;
-		req->length = EP_BUFFER_SIZE;
-		f_rkusb->buf = f_rkusb->buf_head;
+	if (done) {
 		debug("transfer 0x%x bytes done\n", f_rkusb->dl_size);
-		f_rkusb->dl_size = 0;
+		rockusb_dl_finish(req);
 		rockusb_tx_write_csw(f_rkusb->tag, 0, CSW_GOOD,
 				     USB_BULK_CS_WRAP_LEN);
-	} else {
-		req->length = rx_bytes_expected(ep);
-		if (f_rkusb->buf == f_rkusb->buf_head)
-			f_rkusb->buf = f_rkusb->buf_head + EP_BUFFER_SIZE;
-		else
-			f_rkusb->buf = f_rkusb->buf_head;
-
-		debug("remain %x bytes, %lx sectors\n", req->length,
-		      req->length / f_rkusb->desc->blksz);
+		req->actual = 0;
+		usb_ep_queue(ep, req, 0);
 	}
-
-	req->actual = 0;
-	usb_ep_queue(ep, req, 0);
 }
 
 static void cb_test_unit_ready(struct usb_ep *ep, struct usb_request *req)
@@ -693,6 +724,10 @@ static void cb_write_lba(struct usb_ep *ep, struct usb_request *req)
 		rockusb_tx_write_csw(cbw->tag, cbw->data_transfer_length,
 				     CSW_FAIL, USB_BULK_CS_WRAP_LEN);
 	} else {
+		/* receive the image straight into the download buffer */
+		f_rkusb->cmd_buf = req->buf;
+		f_rkusb->buf = f_rkusb->buf_head;
+		req->buf = f_rkusb->buf;
 		req->complete = rx_handler_dl_image;
 		req->length = rx_bytes_expected(ep);
 	}
@@ -38,6 +38,8 @@
 static void thor_tx_data(struct udevice *udc, unsigned char *data, int len);
 static void thor_set_dma(void *addr, int len);
 static int thor_rx_data(struct udevice *udc);
+static int thor_rx_queue(void);
+static int thor_rx_wait(struct udevice *udc);
 
 static struct f_thor *thor_func;
 static inline struct f_thor *func_to_thor(struct usb_function *f)
@@ -146,69 +148,84 @@ static int process_rqt_cmd(struct udevice *udc, const struct rqt_box *rqt)
 	return true;
 }
 
+/* Release the download buffer, making sure no receive still targets it */
+static void download_abort(void *bufs, bool rx_queued)
+{
+	struct thor_dev *dev = thor_func->dev;
+
+	if (rx_queued) {
+		usb_ep_dequeue(dev->out_ep, dev->out_req);
+		dev->rxdata = 0;
+	}
+	free(bufs);
+}
+
 static long long int download_head(struct udevice *udc,
 				   unsigned long long total,
 				   unsigned int packet_size,
 				   long long int *left,
 				   int *cnt)
 {
-	long long int rcv_cnt = 0, left_to_rcv, ret_rcv;
+	long long int rcv_cnt = 0, ret_rcv;
 	struct dfu_entity *dfu_entity = dfu_get_entity(alt_setting_num);
-	void *transfer_buffer = dfu_get_buf(dfu_entity);
-	void *buf = transfer_buffer;
+	void *bufs, *buf, *data;
 	int usb_pkt_cnt = 0, ret;
 
 	/*
-	 * Files smaller than THOR_STORE_UNIT_SIZE (now 32 MiB) are stored on
-	 * the medium.
-	 * The packet response is sent on the purpose after successful data
-	 * chunk write. There is a room for improvement when asynchronous write
-	 * is performed.
+	 * Each packet is received into one half of a double buffer. Once it
+	 * has arrived the next packet is queued into the other half and the
+	 * host is told to send it, and only then is this one written to the
+	 * medium. A UDC which does DMA by itself thus receives the next packet
+	 * while the previous one is being stored. A write error still aborts
+	 * the download, although by then the packet has been acknowledged.
 	 */
-	while (total - rcv_cnt >= packet_size) {
-		thor_set_dma(buf, packet_size);
-		buf += packet_size;
-		ret_rcv = thor_rx_data(udc);
-		if (ret_rcv < 0)
+	bufs = memalign(ARCH_DMA_MINALIGN, 2 * packet_size);
+	if (!bufs)
+		return -ENOMEM;
+
+	*left = 0;
+	buf = bufs;
+	thor_set_dma(buf, packet_size);
+	if (total) {
+		ret = thor_rx_queue();
+		if (ret) {
+			free(bufs);
+			return ret;
+		}
+	}
+
+	while (rcv_cnt < total) {
+		ret_rcv = thor_rx_wait(udc);
+		if (ret_rcv < 0) {
+			download_abort(bufs, true);
 			return ret_rcv;
+		}
 		rcv_cnt += ret_rcv;
 		debug("%d: RCV data count: %llu cnt: %d\n", usb_pkt_cnt,
 		      rcv_cnt, *cnt);
 
-		if ((rcv_cnt % THOR_STORE_UNIT_SIZE) == 0) {
-			ret = dfu_write(dfu_get_entity(alt_setting_num),
-					transfer_buffer, THOR_STORE_UNIT_SIZE,
-					(*cnt)++);
+		data = buf;
+		if (rcv_cnt < total) {
+			buf = buf == bufs ? bufs + packet_size : bufs;
+			thor_set_dma(buf, packet_size);
+			ret = thor_rx_queue();
 			if (ret) {
-				pr_err("DFU write failed [%d] cnt: %d\n",
-				      ret, *cnt);
+				free(bufs);
 				return ret;
 			}
-			buf = transfer_buffer;
 		}
 		send_data_rsp(udc, 0, ++usb_pkt_cnt);
-	}
-
-	/* Calculate the amount of data to arrive from PC (in bytes) */
-	left_to_rcv = total - rcv_cnt;
 
-	/*
-	 * Calculate number of data already received. but not yet stored
-	 * on the medium (they are smaller than THOR_STORE_UNIT_SIZE)
-	 */
-	*left = left_to_rcv + buf - transfer_buffer;
-	debug("%s: left: %llu left_to_rcv: %llu buf: 0x%p\n", __func__,
-	      *left, left_to_rcv, buf);
-
-	if (left_to_rcv) {
-		thor_set_dma(buf, packet_size);
-		ret_rcv = thor_rx_data(udc);
-		if (ret_rcv < 0)
-			return ret_rcv;
-		rcv_cnt += ret_rcv;
-		send_data_rsp(udc, 0, ++usb_pkt_cnt);
+		ret = dfu_write_direct(dfu_entity, data, ret_rcv);
+		if (ret) {
+			pr_err("DFU write failed [%d] packet: %d\n", ret,
+			       usb_pkt_cnt);
+			download_abort(bufs, rcv_cnt < total);
+			return ret;
+		}
 	}
 
+	free(bufs);
 	debug("%s: %llu total: %llu cnt: %d\n", __func__, rcv_cnt, total, *cnt);
 
 	return rcv_cnt;
@@ -538,33 +555,59 @@ static struct usb_request *alloc_ep_req(struct usb_ep *ep, unsigned length)
 	return req;
 }
 
+/* Queue a receive into the buffer set up by thor_set_dma() */
+static int thor_rx_queue(void)
+{
+	struct thor_dev *dev = thor_func->dev;
+	int status;
+
+	debug("dev->out_req->length:%d dev->rxdata:%d\n",
+	      dev->out_req->length, dev->rxdata);
+
+	status = usb_ep_queue(dev->out_ep, dev->out_req, 0);
+	if (status) {
+		pr_err("kill %s:  resubmit %d bytes --> %d\n",
+		      dev->out_ep->name, dev->out_req->length, status);
+		usb_ep_set_halt(dev->out_ep);
+		return -EAGAIN;
+	}
+
+	return 0;
+}
+
+/* Wait for a receive queued by thor_rx_queue(), returning its length */
+static int thor_rx_wait(struct udevice *udc)
+{
+	struct thor_dev *dev = thor_func->dev;
+
+	while (!dev->rxdata) {
+		dm_usb_gadget_handle_interrupts(udc);
+		if (ctrlc())
+			return -1;
+	}
+	dev->rxdata = 0;
+
+	return dev->out_req->actual;
+}
+
 static int thor_rx_data(struct udevice *udc)
 {
 	struct thor_dev *dev = thor_func->dev;
-	int data_to_rx, tmp, status;
+	int data_to_rx, tmp, ret;
 
 	data_to_rx = dev->out_req->length;
 	tmp = data_to_rx;
 	do {
 		dev->out_req->length = data_to_rx;
-		debug("dev->out_req->length:%d dev->rxdata:%d\n",
-		      dev->out_req->length, dev->rxdata);
-
-		status = usb_ep_queue(dev->out_ep, dev->out_req, 0);
-		if (status) {
-			pr_err("kill %s:  resubmit %d bytes --> %d\n",
-			      dev->out_ep->name, dev->out_req->length, status);
-			usb_ep_set_halt(dev->out_ep);
-			return -EAGAIN;
-		}
 
-		while (!dev->rxdata) {
-			dm_usb_gadget_handle_interrupts(udc);
-			if (ctrlc())
-				return -1;
-		}
-		dev->rxdata = 0;
-		data_to_rx -= dev->out_req->actual;
+		ret = thor_rx_queue();
+		if (ret)
+			return ret;
+
+		ret = thor_rx_wait(udc);
+		if (ret < 0)
+			return ret;
+		data_to_rx -= ret;
 	} while (data_to_rx);
 
 	return tmp;
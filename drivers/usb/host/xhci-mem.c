@@ -33,12 +33,31 @@
  * @param len	the length of the cache line to be flushed
  * Return: none
  */
+/* Batch which xhci_flush_cache() adds to, or NULL to flush immediately */
+static struct dcache_batch *xhci_batch;
+
 void xhci_flush_cache(uintptr_t addr, u32 len)
 {
 	BUG_ON((void *)addr == NULL || len == 0);
 
-	flush_dcache_range(addr & ~(CACHELINE_SIZE - 1),
-				ALIGN(addr + len, CACHELINE_SIZE));
+	if (xhci_batch)
+		dcache_batch_flush(xhci_batch, addr & ~(CACHELINE_SIZE - 1),
+				   ALIGN(addr + len, CACHELINE_SIZE));
+	else
+		flush_dcache_range(addr & ~(CACHELINE_SIZE - 1),
+				   ALIGN(addr + len, CACHELINE_SIZE));
+}
+
+void xhci_cache_batch_start(struct dcache_batch *batch)
+{
+	dcache_batch_init(batch);
+	xhci_batch = batch;
+}
+
+void xhci_cache_batch_end(void)
+{
+	dcache_batch_sync(xhci_batch);
+	xhci_batch = NULL;
 }
 
 /**
@@ -658,6 +658,7 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 	u32 trb_fields[4];
 	u64 buf_64 = xhci_dma_map(ctrl, buffer, length);
 	dma_addr_t last_transfer_trb_addr;
+	struct dcache_batch batch;
 	int available_length;
 
 	debug("dev=%p, pipe=%lx, buffer=%p, length=%d\n",
@@ -743,7 +744,11 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 
 	first_trb = true;
 
-	/* flush the buffer before use */
+	/*
+	 * Flush the buffer and the TRBs together, with a single barrier
+	 * before the TD is handed to the controller
+	 */
+	xhci_cache_batch_start(&batch);
 	xhci_flush_cache((uintptr_t)buffer, length);
 
 	/* Queue the first TRB, even if it's zero-length */
@@ -800,6 +805,7 @@ int xhci_bulk_tx(struct usb_device *udev, unsigned long pipe,
 
 		schedule();
 	} while (running_total < length);
+	xhci_cache_batch_end();
 
 	giveback_first_trb(udev, ep_index, start_cycle, start_trb);
 
@@ -531,7 +531,9 @@ static int xhci_init_ep_contexts_if(struct usb_device *udev,
 						   ep_index);
 
 		/* Allocate the ep rings */
-		virt_dev->eps[ep_index].ring = xhci_ring_alloc(ctrl, 1, true);
+		virt_dev->eps[ep_index].ring =
+			xhci_ring_alloc(ctrl, CONFIG_USB_XHCI_EP_RING_SEGS,
+					true);
 		if (!virt_dev->eps[ep_index].ring)
 			return -ENOMEM;
 
@@ -1417,13 +1419,16 @@ static int xhci_update_hub_device(struct udevice *dev, struct usb_device *udev)
 static int xhci_get_max_xfer_size(struct udevice *dev, size_t *size)
 {
 	/*
-	 * xHCD allocates one segment which includes 64 TRBs for each endpoint
-	 * and the last TRB in this segment is configured as a link TRB to form
-	 * a TRB ring. Each TRB can transfer up to 64K bytes, however data
-	 * buffers referenced by transfer TRBs shall not span 64KB boundaries.
-	 * Hence the maximum number of TRBs we can use in one transfer is 62.
+	 * xHCD allocates CONFIG_USB_XHCI_EP_RING_SEGS segments, each of which
+	 * includes 64 TRBs, for each endpoint and the last TRB in each segment
+	 * is configured as a link TRB to form a TRB ring. Each TRB can transfer
+	 * up to 64K bytes, however data buffers referenced by transfer TRBs
+	 * shall not span 64KB boundaries, so an unaligned buffer needs one
+	 * more TRB. Hence the maximum number of TRBs we can use in one transfer
+	 * is 62 for each segment, plus 63 for each further segment.
 	 */
-	*size = (TRBS_PER_SEGMENT - 2) * TRB_MAX_BUFF_SIZE;
+	*size = (CONFIG_USB_XHCI_EP_RING_SEGS * (TRBS_PER_SEGMENT - 1) - 1) *
+		TRB_MAX_BUFF_SIZE;
 
 	return 0;
 }
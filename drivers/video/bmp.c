@@ -113,10 +113,24 @@ int bmp_display(ulong addr, int x, int y)
 	struct bmp_image *bmp = map_sysmem(addr, 0);
 	void *bmp_alloc_addr = NULL;
 	unsigned long len;
+	bool align = false;
+
+	if (x == BMP_ALIGN_CENTER || y == BMP_ALIGN_CENTER)
+		align = true;
 
 	if (!((bmp->header.signature[0] == 'B') &&
-	      (bmp->header.signature[1] == 'M')))
+	      (bmp->header.signature[1] == 'M'))) {
+		/* Try to draw it as it is unpacked, before unpacking it all */
+		if (CONFIG_IS_ENABLED(VIDEO_BMP_GZIP) &&
+		    !uclass_first_device_err(UCLASS_VIDEO, &dev)) {
+			ret = video_bmp_display_gz(dev, addr,
+						   CONFIG_VAL(VIDEO_LOGO_MAX_SIZE),
+						   x, y, align);
+			if (ret != -ENOENT && ret != -EPROTONOSUPPORT)
+				return ret ? CMD_RET_FAILURE : 0;
+		}
 		bmp = gunzip_bmp(addr, &len, &bmp_alloc_addr);
+	}
 
 	if (!bmp) {
 		printf("There is no valid bmp file at the given address\n");
@@ -125,14 +139,8 @@ int bmp_display(ulong addr, int x, int y)
 	addr = map_to_sysmem(bmp);
 
 	ret = uclass_first_device_err(UCLASS_VIDEO, &dev);
-	if (!ret) {
-		bool align = false;
-
-		if (x == BMP_ALIGN_CENTER || y == BMP_ALIGN_CENTER)
-			align = true;
-
+	if (!ret)
 		ret = video_bmp_display(dev, addr, x, y, align);
-	}
 
 	if (bmp_alloc_addr)
 		free(bmp_alloc_addr);
@@ -18,22 +18,17 @@ static int console_set_row(struct udevice *dev, uint row, int clr)
 	struct video_priv *vid_priv = dev_get_uclass_priv(dev->parent);
 	struct console_simple_priv *priv = dev_get_priv(dev);
 	struct video_fontdata *fontdata = priv->fontdata;
-	void *line, *dst, *end;
+	void *line, *end;
 	int pixels = fontdata->height * vid_priv->xsize;
 	int ret;
-	int i;
-	int pbytes;
 
 	ret = check_bpix_support(vid_priv->bpix);
 	if (ret)
 		return ret;
 
 	line = vid_priv->fb + row * fontdata->height * vid_priv->line_length;
-	dst = line;
-	pbytes = VNBYTES(vid_priv->bpix);
-	for (i = 0; i < pixels; i++)
-		fill_pixel_and_goto_next(&dst, clr, pbytes, pbytes);
-	end = dst;
+	video_fill_pixels(line, clr, pixels, vid_priv->bpix);
+	end = line + pixels * VNBYTES(vid_priv->bpix);
 
 	ret = vidconsole_sync_copy(dev, line, end);
 	if (ret)
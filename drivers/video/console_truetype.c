@@ -127,6 +127,32 @@ struct pos_info {
  */
 #define POS_HISTORY_SIZE	(CONFIG_SYS_CBSIZE * 11 / 10)
 
+/* Number of sub-pixel positions for which a glyph is cached */
+#define GLYPH_SUBPIXELS		4
+
+/**
+ * struct console_tt_glyph - A rendered glyph in the glyph cache
+ *
+ * @valid:	true if this entry holds a glyph
+ * @cp:		Code point of the glyph
+ * @shift:	Sub-pixel X shift, in units of 1 / GLYPH_SUBPIXELS pixels
+ * @data:	8-bit-per-pixel image of the glyph, NULL if it is empty
+ * @width:	Width of the image in pixels
+ * @height:	Height of the image in pixels
+ * @xoff:	X offset of the image from the cursor position
+ * @yoff:	Y offset of the image from the baseline
+ */
+struct console_tt_glyph {
+	bool valid;
+	int cp;
+	int shift;
+	u8 *data;
+	int width;
+	int height;
+	int xoff;
+	int yoff;
+};
+
 /**
  * struct console_tt_metrics - Information about a font / size combination
  *
@@ -145,6 +171,8 @@ struct pos_info {
  * @scale:	Scale of the font. This is calculated from the pixel height
  *		of the font. It is used by the STB library to generate images
  *		of the correct size.
+ * @glyphs:	Glyph cache with CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE entries,
+ *		allocated when the first character is written
  */
 struct console_tt_metrics {
 	const char *font_name;
@@ -153,6 +181,7 @@ struct console_tt_metrics {
 	stbtt_fontinfo font;
 	int baseline;
 	double scale;
+	struct console_tt_glyph *glyphs;
 };
 
 /**
@@ -261,6 +290,46 @@ static int console_truetype_move_rows(struct udevice *dev, uint rowdst,
 	return 0;
 }
 
+/**
+ * tt_get_glyph() - Get a rendered glyph, using the glyph cache
+ *
+ * @met:	Metrics of the font to use
+ * @cp:		Code point to render
+ * @x_shift:	Sub-pixel X position of the character, 0 <= x_shift < 1
+ * Return: glyph, or NULL if out of memory
+ */
+static struct console_tt_glyph *tt_get_glyph(struct console_tt_metrics *met,
+					     int cp, double x_shift)
+{
+	struct console_tt_glyph *glyph;
+	int shift;
+
+	if (!met->glyphs) {
+		met->glyphs = calloc(CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE,
+				     sizeof(*glyph));
+		if (!met->glyphs)
+			return NULL;
+	}
+
+	shift = (int)(x_shift * GLYPH_SUBPIXELS) % GLYPH_SUBPIXELS;
+	glyph = &met->glyphs[((uint)cp * GLYPH_SUBPIXELS + shift) %
+			     CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE];
+	if (glyph->valid && glyph->cp == cp && glyph->shift == shift)
+		return glyph;
+
+	/* evict whatever was there */
+	free(glyph->data);
+	glyph->data = stbtt_GetCodepointBitmapSubpixel(&met->font, met->scale,
+			met->scale, (double)shift / GLYPH_SUBPIXELS, 0, cp,
+			&glyph->width, &glyph->height, &glyph->xoff,
+			&glyph->yoff);
+	glyph->cp = cp;
+	glyph->shift = shift;
+	glyph->valid = true;
+
+	return glyph;
+}
+
 static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 				    int cp)
 {
@@ -278,6 +347,7 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	u8 *bits, *data;
 	int advance;
 	void *start, *end, *line;
+	bool cached = false;
 	int row, ret;
 
 	/* First get some basic metrics about this character */
@@ -319,9 +389,24 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	 * image of the character. For empty characters, like ' ', data will
 	 * return NULL;
 	 */
-	data = stbtt_GetCodepointBitmapSubpixel(font, met->scale, met->scale,
-						x_shift, 0, cp, &width, &height,
-						&xoff, &yoff);
+	if (CONFIG_CONSOLE_TRUETYPE_GLYPH_CACHE) {
+		struct console_tt_glyph *glyph;
+
+		glyph = tt_get_glyph(met, cp, x_shift);
+		if (!glyph)
+			return -ENOMEM;
+		data = glyph->data;
+		width = glyph->width;
+		height = glyph->height;
+		xoff = glyph->xoff;
+		yoff = glyph->yoff;
+		cached = true;
+	} else {
+		data = stbtt_GetCodepointBitmapSubpixel(font, met->scale,
+							met->scale, x_shift, 0,
+							cp, &width, &height,
+							&xoff, &yoff);
+	}
 	if (!data)
 		return width_frac;
 
@@ -412,7 +497,8 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 			break;
 		}
 		default:
-			free(data);
+			if (!cached)
+				free(data);
 			return -ENOSYS;
 		}
 
@@ -421,7 +507,8 @@ static int console_truetype_putc_xy(struct udevice *dev, uint x, uint y,
 	ret = vidconsole_sync_copy(dev, start, line);
 	if (ret)
 		return ret;
-	free(data);
+	if (!cached)
+		free(data);
 
 	return width_frac;
 }
@@ -0,0 +1,442 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Rockchip VOP2 display controller, as found on the RK3588
+ *
+ * This drives a single Esmart window on the first video port which has a
+ * working display attached, which is all that is needed for a splash screen
+ * and console. The frame buffer is left scanning out when U-Boot hands over
+ * to the OS, so that it can be picked up as a simple-framebuffer.
+ */
+
+#include <clk.h>
+#include <display.h>
+#include <dm.h>
+#include <dm/device_compat.h>
+#include <dm/device-internal.h>
+#include <dm/uclass-internal.h>
+#include <efi_loader.h>
+#include <log.h>
+#include <regmap.h>
+#include <syscon.h>
+#include <video.h>
+#include <asm/global_data.h>
+#include <asm/io.h>
+#include <dt-bindings/soc/rockchip,vop2.h>
+#include <linux/bitfield.h>
+#include <linux/bitops.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+#define VOP2_REG_CFG_DONE		0x000
+#define  VOP2_CFG_DONE_GLB_EN		BIT(15)
+#define VOP2_VERSION_INFO		0x004
+#define VOP2_DSP_IF_EN			0x028
+#define  RK3588_DSP_IF_EN_DP0		BIT(0)
+#define  RK3588_DSP_IF_EN_DP1		BIT(1)
+#define  RK3588_DSP_IF_EN_EDP0		BIT(2)
+#define  RK3588_DSP_IF_EN_HDMI0		BIT(3)
+#define  RK3588_DSP_IF_EN_EDP1		BIT(4)
+#define  RK3588_DSP_IF_EN_HDMI1		BIT(5)
+#define  RK3588_DSP_IF_DP0_MUX		GENMASK(13, 12)
+#define  RK3588_DSP_IF_DP1_MUX		GENMASK(15, 14)
+#define  RK3588_DSP_IF_EDP_HDMI0_MUX	GENMASK(17, 16)
+#define  RK3588_DSP_IF_EDP_HDMI1_MUX	GENMASK(19, 18)
+
+#define VOP2_OVL_CTRL			0x600
+#define  VOP2_OVL_LAYERSEL_REGDONE_IMD	BIT(28)
+#define VOP2_OVL_LAYER_SEL		0x604
+#define VOP2_OVL_PORT_SEL		0x608
+#define  VOP2_OVL_PORT_MUX(vp)		(0xf << ((vp) * 4))
+#define  VOP2_OVL_PORT_MUX_NONE		8
+#define  VOP2_OVL_SEL_PORT_ESMART0	GENMASK(25, 24)
+
+/* Video port registers, one block of these for each port */
+#define VOP2_VP_BASE(vp)		(0xc00 + (vp) * 0x100)
+#define VOP2_VP_DSP_CTRL		0x00
+#define  VOP2_VP_DSP_STANDBY		BIT(31)
+#define  VOP2_VP_DSP_OUT_MODE		GENMASK(3, 0)
+#define  VOP2_OUT_MODE_AAAA		15
+#define VOP2_VP_CLK_CTRL		0x0c
+#define VOP2_VP_DSP_BG			0x2c
+#define VOP2_VP_POST_DSP_HACT_INFO	0x34
+#define VOP2_VP_POST_DSP_VACT_INFO	0x38
+#define VOP2_VP_POST_SCL_FACTOR_YRGB	0x3c
+#define VOP2_VP_POST_SCL_CTRL		0x40
+#define VOP2_VP_DSP_HTOTAL_HS_END	0x48
+#define VOP2_VP_DSP_HACT_ST_END		0x4c
+#define VOP2_VP_DSP_VTOTAL_VS_END	0x50
+#define VOP2_VP_DSP_VACT_ST_END		0x54
+
+/* Esmart window 0 registers */
+#define VOP2_ESMART0_BASE		0x1800
+#define VOP2_ESMART0_LAYER_SEL_ID	2
+#define VOP2_SMART_REGION0_CTRL		0x10
+#define  VOP2_SMART_WIN_EN		BIT(0)
+#define  VOP2_SMART_DATA_FMT		GENMASK(5, 1)
+#define  VOP2_FMT_ARGB8888		0
+#define VOP2_SMART_REGION0_YRGB_MST	0x14
+#define VOP2_SMART_REGION0_VIR		0x1c
+#define VOP2_SMART_REGION0_ACT_INFO	0x20
+#define VOP2_SMART_REGION0_DSP_INFO	0x24
+#define VOP2_SMART_REGION0_DSP_ST	0x28
+
+/* Polarity and output enables held in the GRFs */
+#define RK3588_GRF_VOP_CON2		0x08
+#define RK3588_GRF_VO1_CON0		0x00
+
+#define VOP2_MAX_VPS			4
+
+#define HIWORD_UPDATE(val, h, l)	\
+	((((val) << (l)) & GENMASK(h, l)) | (GENMASK(h, l) << 16))
+
+struct rk3588_vop2_priv {
+	void __iomem *regs;
+	struct regmap *vop_grf;
+	struct regmap *vo1_grf;
+	int vp;
+};
+
+static void vop2_writel(struct rk3588_vop2_priv *priv, uint reg, u32 val)
+{
+	writel(val, priv->regs + reg);
+}
+
+static void vop2_vp_writel(struct rk3588_vop2_priv *priv, uint reg, u32 val)
+{
+	writel(val, priv->regs + VOP2_VP_BASE(priv->vp) + reg);
+}
+
+static void vop2_win_writel(struct rk3588_vop2_priv *priv, uint reg, u32 val)
+{
+	writel(val, priv->regs + VOP2_ESMART0_BASE + reg);
+}
+
+static void vop2_cfg_done(struct rk3588_vop2_priv *priv)
+{
+	vop2_writel(priv, VOP2_REG_CFG_DONE, VOP2_CFG_DONE_GLB_EN |
+		    BIT(priv->vp) | BIT(priv->vp) << 16);
+}
+
+/**
+ * vop2_set_intf() - Route the video port to an output interface
+ *
+ * @dev:	VOP2 device
+ * @ep_id:	Endpoint type (ROCKCHIP_VOP2_EP_...)
+ * @flags:	Display flags from the timing, used for the sync polarity
+ * Return: 0 if OK, -ENOSYS if the interface is not supported
+ */
+static int vop2_set_intf(struct udevice *dev, int ep_id, u32 flags)
+{
+	struct rk3588_vop2_priv *priv = dev_get_priv(dev);
+	u32 die, pol = 0;
+
+	if (flags & DISPLAY_FLAGS_HSYNC_HIGH)
+		pol |= BIT(0);
+	if (flags & DISPLAY_FLAGS_VSYNC_HIGH)
+		pol |= BIT(1);
+
+	die = readl(priv->regs + VOP2_DSP_IF_EN);
+	switch (ep_id) {
+	case ROCKCHIP_VOP2_EP_HDMI0:
+		die &= ~RK3588_DSP_IF_EDP_HDMI0_MUX;
+		die |= RK3588_DSP_IF_EN_HDMI0 |
+			FIELD_PREP(RK3588_DSP_IF_EDP_HDMI0_MUX, priv->vp);
+		regmap_write(priv->vop_grf, RK3588_GRF_VOP_CON2,
+			     HIWORD_UPDATE(1, 1, 1));
+		regmap_write(priv->vo1_grf, RK3588_GRF_VO1_CON0,
+			     HIWORD_UPDATE(pol, 6, 5));
+		break;
+	case ROCKCHIP_VOP2_EP_HDMI1:
+		die &= ~RK3588_DSP_IF_EDP_HDMI1_MUX;
+		die |= RK3588_DSP_IF_EN_HDMI1 |
+			FIELD_PREP(RK3588_DSP_IF_EDP_HDMI1_MUX, priv->vp);
+		regmap_write(priv->vop_grf, RK3588_GRF_VOP_CON2,
+			     HIWORD_UPDATE(1, 4, 4));
+		regmap_write(priv->vo1_grf, RK3588_GRF_VO1_CON0,
+			     HIWORD_UPDATE(pol, 8, 7));
+		break;
+	case ROCKCHIP_VOP2_EP_EDP0:
+		die &= ~RK3588_DSP_IF_EDP_HDMI0_MUX;
+		die |= RK3588_DSP_IF_EN_EDP0 |
+			FIELD_PREP(RK3588_DSP_IF_EDP_HDMI0_MUX, priv->vp);
+		regmap_write(priv->vop_grf, RK3588_GRF_VOP_CON2,
+			     HIWORD_UPDATE(1, 0, 0));
+		break;
+	case ROCKCHIP_VOP2_EP_EDP1:
+		die &= ~RK3588_DSP_IF_EDP_HDMI1_MUX;
+		die |= RK3588_DSP_IF_EN_EDP1 |
+			FIELD_PREP(RK3588_DSP_IF_EDP_HDMI1_MUX, priv->vp);
+		regmap_write(priv->vop_grf, RK3588_GRF_VOP_CON2,
+			     HIWORD_UPDATE(1, 3, 3));
+		break;
+	case ROCKCHIP_VOP2_EP_DP0:
+		die &= ~RK3588_DSP_IF_DP0_MUX;
+		die |= RK3588_DSP_IF_EN_DP0 |
+			FIELD_PREP(RK3588_DSP_IF_DP0_MUX, priv->vp);
+		break;
+	case ROCKCHIP_VOP2_EP_DP1:
+		die &= ~RK3588_DSP_IF_DP1_MUX;
+		die |= RK3588_DSP_IF_EN_DP1 |
+			FIELD_PREP(RK3588_DSP_IF_DP1_MUX, priv->vp);
+		break;
+	default:
+		dev_dbg(dev, "unsupported output interface %d\n", ep_id);
+		return -ENOSYS;
+	}
+	vop2_writel(priv, VOP2_DSP_IF_EN, die);
+
+	return 0;
+}
+
+static void vop2_mode_set(struct udevice *dev,
+			  const struct display_timing *edid)
+{
+	struct rk3588_vop2_priv *priv = dev_get_priv(dev);
+	u32 hsync_len = edid->hsync_len.typ;
+	u32 hact_st = hsync_len + edid->hback_porch.typ;
+	u32 hact_end = hact_st + edid->hactive.typ;
+	u32 htotal = hact_end + edid->hfront_porch.typ;
+	u32 vsync_len = edid->vsync_len.typ;
+	u32 vact_st = vsync_len + edid->vback_porch.typ;
+	u32 vact_end = vact_st + edid->vactive.typ;
+	u32 vtotal = vact_end + edid->vfront_porch.typ;
+
+	vop2_vp_writel(priv, VOP2_VP_DSP_HTOTAL_HS_END,
+		       htotal << 16 | hsync_len);
+	vop2_vp_writel(priv, VOP2_VP_DSP_HACT_ST_END, hact_st << 16 | hact_end);
+	vop2_vp_writel(priv, VOP2_VP_DSP_VTOTAL_VS_END,
+		       vtotal << 16 | vsync_len);
+	vop2_vp_writel(priv, VOP2_VP_DSP_VACT_ST_END, vact_st << 16 | vact_end);
+	vop2_vp_writel(priv, VOP2_VP_POST_DSP_HACT_INFO,
+		       hact_st << 16 | hact_end);
+	vop2_vp_writel(priv, VOP2_VP_POST_DSP_VACT_INFO,
+		       vact_st << 16 | vact_end);
+	vop2_vp_writel(priv, VOP2_VP_POST_SCL_FACTOR_YRGB, 0x10001000);
+	vop2_vp_writel(priv, VOP2_VP_POST_SCL_CTRL, 0);
+	vop2_vp_writel(priv, VOP2_VP_DSP_BG, 0);
+	/* The dclk is set to the pixel clock, so no further division */
+	vop2_vp_writel(priv, VOP2_VP_CLK_CTRL, 0);
+	/* HDMI, eDP and DP all take 10-bit-per-channel output */
+	vop2_vp_writel(priv, VOP2_VP_DSP_CTRL,
+		       FIELD_PREP(VOP2_VP_DSP_OUT_MODE, VOP2_OUT_MODE_AAAA));
+}
+
+static void vop2_enable_win(struct udevice *dev, ulong fbbase,
+			    const struct display_timing *edid)
+{
+	struct rk3588_vop2_priv *priv = dev_get_priv(dev);
+	u32 hactive = edid->hactive.typ;
+	u32 vactive = edid->vactive.typ;
+	u32 size = (vactive - 1) << 16 | (hactive - 1);
+	u32 port_sel;
+	int vp;
+
+	/* Give Esmart0 to our port as its only layer; other ports get none */
+	port_sel = readl(priv->regs + VOP2_OVL_PORT_SEL);
+	for (vp = 0; vp < VOP2_MAX_VPS - 1; vp++) {
+		port_sel &= ~VOP2_OVL_PORT_MUX(vp);
+		port_sel |= (vp == priv->vp ? 0 : VOP2_OVL_PORT_MUX_NONE) <<
+			(vp * 4);
+	}
+	port_sel &= ~VOP2_OVL_SEL_PORT_ESMART0;
+	port_sel |= FIELD_PREP(VOP2_OVL_SEL_PORT_ESMART0, priv->vp);
+	vop2_writel(priv, VOP2_OVL_PORT_SEL, port_sel);
+	vop2_writel(priv, VOP2_OVL_LAYER_SEL, VOP2_ESMART0_LAYER_SEL_ID);
+	setbits_le32(priv->regs + VOP2_OVL_CTRL, VOP2_OVL_LAYERSEL_REGDONE_IMD);
+
+	vop2_win_writel(priv, VOP2_SMART_REGION0_YRGB_MST, fbbase);
+	vop2_win_writel(priv, VOP2_SMART_REGION0_VIR, hactive);
+	vop2_win_writel(priv, VOP2_SMART_REGION0_ACT_INFO, size);
+	vop2_win_writel(priv, VOP2_SMART_REGION0_DSP_INFO, size);
+	vop2_win_writel(priv, VOP2_SMART_REGION0_DSP_ST, 0);
+	vop2_win_writel(priv, VOP2_SMART_REGION0_CTRL, VOP2_SMART_WIN_EN |
+			FIELD_PREP(VOP2_SMART_DATA_FMT, VOP2_FMT_ARGB8888));
+
+	vop2_cfg_done(priv);
+}
+
+/**
+ * vop2_display_init() - Try to enable a display on a video port
+ *
+ * This finds the display device referenced by @ep_node, sets the pixel clock
+ * and timing from it, routes the port to the display's interface and turns
+ * on the window showing the frame buffer.
+ *
+ * @dev:	VOP2 device
+ * @fbbase:	Frame buffer address
+ * @vp:		Video port number
+ * @ep_node:	Endpoint node within the port
+ * Return: 0 if OK, -ve if something went wrong
+ */
+static int vop2_display_init(struct udevice *dev, ulong fbbase, int vp,
+			     ofnode ep_node)
+{
+	struct video_priv *uc_priv = dev_get_uclass_priv(dev);
+	struct rk3588_vop2_priv *priv = dev_get_priv(dev);
+	struct display_plat *disp_uc_plat;
+	struct display_timing timing;
+	struct udevice *disp = NULL;
+	u32 remote_phandle;
+	char clk_name[10];
+	struct clk dclk;
+	ofnode remote;
+	int ep_id;
+	int ret;
+
+	ep_id = ofnode_read_u32_default(ep_node, "reg", -1);
+	ret = ofnode_read_u32(ep_node, "remote-endpoint", &remote_phandle);
+	if (ret)
+		return ret;
+
+	remote = ofnode_get_by_phandle(remote_phandle);
+	while (ofnode_valid(remote)) {
+		remote = ofnode_get_parent(remote);
+		if (!ofnode_valid(remote))
+			return -EINVAL;
+		uclass_find_device_by_ofnode(UCLASS_DISPLAY, remote, &disp);
+		if (disp)
+			break;
+	}
+	if (!disp)
+		return -ENODEV;
+
+	disp_uc_plat = dev_get_uclass_plat(disp);
+	if (display_in_use(disp))
+		return -EBUSY;
+	disp_uc_plat->source_id = vp;
+	disp_uc_plat->src_dev = dev;
+
+	ret = device_probe(disp);
+	if (ret)
+		return ret;
+
+	ret = display_read_timing(disp, &timing);
+	if (ret)
+		return ret;
+
+	snprintf(clk_name, sizeof(clk_name), "dclk_vp%d", vp);
+	ret = clk_get_by_name(dev, clk_name, &dclk);
+	if (!ret)
+		ret = clk_set_rate(&dclk, timing.pixelclock.typ);
+	if (IS_ERR_VALUE(ret)) {
+		dev_dbg(dev, "failed to set %s: ret=%d\n", clk_name, ret);
+		return ret;
+	}
+	clk_enable(&dclk);
+
+	priv->vp = vp;
+	ret = vop2_set_intf(dev, ep_id, timing.flags);
+	if (ret)
+		return ret;
+	vop2_mode_set(dev, &timing);
+	vop2_enable_win(dev, fbbase, &timing);
+
+	ret = display_enable(disp, 1 << VIDEO_BPP32, &timing);
+	if (ret)
+		return ret;
+
+	uc_priv->xsize = timing.hactive.typ;
+	uc_priv->ysize = timing.vactive.typ;
+	uc_priv->bpix = VIDEO_BPP32;
+	debug("%s: vp%d fb=%lx, size=%d %d\n", __func__, vp, fbbase,
+	      uc_priv->xsize, uc_priv->ysize);
+
+	return 0;
+}
+
+static int rk3588_vop2_probe(struct udevice *dev)
+{
+	struct video_uc_plat *plat = dev_get_uclass_plat(dev);
+	struct rk3588_vop2_priv *priv = dev_get_priv(dev);
+	struct clk_bulk clks;
+	ofnode ports, port, node;
+	int ret;
+
+	/* Before relocation we don't need to do anything */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+
+	priv->regs = dev_read_addr_index_ptr(dev, 0);
+	if (!priv->regs)
+		return -EINVAL;
+	priv->vop_grf = syscon_regmap_lookup_by_phandle(dev,
+							"rockchip,vop-grf");
+	if (IS_ERR(priv->vop_grf))
+		return PTR_ERR(priv->vop_grf);
+	priv->vo1_grf = syscon_regmap_lookup_by_phandle(dev,
+							"rockchip,vo1-grf");
+	if (IS_ERR(priv->vo1_grf))
+		return PTR_ERR(priv->vo1_grf);
+
+	ret = clk_get_bulk(dev, &clks);
+	if (!ret)
+		ret = clk_enable_bulk(&clks);
+	if (ret)
+		dev_warn(dev, "failed to enable clocks (ret=%d)\n", ret);
+
+#if defined(CONFIG_EFI_LOADER)
+	debug("Adding to EFI map %d @ %lx\n", plat->size, plat->base);
+	efi_add_memory_map(plat->base, plat->size, EFI_RESERVED_MEMORY_TYPE);
+#endif
+	debug("%s: VOP2 version %08x\n", __func__,
+	      readl(priv->regs + VOP2_VERSION_INFO));
+
+	/* Use the first port which has a display that comes up */
+	ports = dev_read_subnode(dev, "ports");
+	if (!ofnode_valid(ports))
+		return -EINVAL;
+
+	ret = -ENODEV;
+	ofnode_for_each_subnode(port, ports) {
+		int vp = ofnode_read_u32_default(port, "reg", -1);
+
+		if (vp < 0 || vp >= VOP2_MAX_VPS)
+			continue;
+		ofnode_for_each_subnode(node, port) {
+			ret = vop2_display_init(dev, plat->base, vp, node);
+			if (!ret)
+				break;
+			debug("%s: vp%d %s failed: ret=%d\n", __func__, vp,
+			      ofnode_get_name(node), ret);
+		}
+		if (!ret)
+			break;
+	}
+	video_set_flush_dcache(dev, 1);
+
+	return ret;
+}
+
+static int rk3588_vop2_bind(struct udevice *dev)
+{
+	struct video_uc_plat *plat = dev_get_uclass_plat(dev);
+
+	plat->size = 4 * (CONFIG_VIDEO_ROCKCHIP_MAX_XRES *
+			  CONFIG_VIDEO_ROCKCHIP_MAX_YRES);
+
+	return 0;
+}
+
+static const struct udevice_id rk3588_vop2_ids[] = {
+	{ .compatible = "rockchip,rk3588-vop" },
+	{ /* sentinel */ }
+};
+
+static const struct video_ops rk3588_vop2_ops = {
+};
+
+/*
+ * There is no remove() method: the window keeps scanning out the frame buffer
+ * while the OS boots, which takes it over through the simple-framebuffer node
+ * and the memory reservation added by fdt_simplefb_enable_and_mem_rsv().
+ */
+U_BOOT_DRIVER(rk3588_vop2) = {
+	.name	= "rk3588_vop2",
+	.id	= UCLASS_VIDEO,
+	.of_match = rk3588_vop2_ids,
+	.ops	= &rk3588_vop2_ops,
+	.bind	= rk3588_vop2_bind,
+	.probe	= rk3588_vop2_probe,
+	.priv_auto	= sizeof(struct rk3588_vop2_priv),
+	.flags	= DM_FLAG_PRE_RELOC,
+};
@@ -165,49 +165,87 @@ ulong video_get_fb(void)
 	return 0;
 }
 
+static inline void video_put_pixel(u8 *dst, u32 colour, int pbytes)
+{
+	switch (pbytes) {
+	case 4:
+		*(u32 *)dst = colour;
+		break;
+	case 2:
+		*(u16 *)dst = colour;
+		break;
+	default:
+		*dst = colour;
+		break;
+	}
+}
+
+void video_fill_pixels(void *dst, u32 colour, int pixels,
+		       enum video_log2_bpp bpix)
+{
+	int pbytes = VNBYTES(bpix);
+	u8 *ptr = dst, *end;
+	ulong pattern;
+
+	switch (pbytes) {
+	case 1:
+		colour = (colour & 0xff) * 0x01010101;
+		break;
+	case 2:
+		colour = (colour & 0xffff) * 0x00010001;
+		break;
+	case 4:
+		break;
+	default:
+		return;
+	}
+
+	/* A colour made of a single repeated byte, e.g. black or white */
+	if (colour == (colour & 0xff) * 0x01010101) {
+		memset(dst, colour & 0xff, pixels * pbytes);
+		return;
+	}
+
+	/*
+	 * Write single pixels up to a word boundary, then whole words holding
+	 * the colour replicated, then any remaining pixels
+	 */
+	end = ptr + pixels * pbytes;
+	while (ptr < end && !IS_ALIGNED((ulong)ptr, sizeof(ulong))) {
+		video_put_pixel(ptr, colour, pbytes);
+		ptr += pbytes;
+	}
+	pattern = (ulong)((u64)colour << 32 | colour);
+	for (; ptr + sizeof(ulong) <= end; ptr += sizeof(ulong))
+		*(ulong *)ptr = pattern;
+	while (ptr < end) {
+		video_put_pixel(ptr, colour, pbytes);
+		ptr += pbytes;
+	}
+}
+
 int video_fill_part(struct udevice *dev, int xstart, int ystart, int xend,
 		    int yend, u32 colour)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
 	void *start, *line;
 	int pixels = xend - xstart;
-	int row, i, ret;
+	int row, ret;
+
+	switch (priv->bpix) {
+	case VIDEO_BPP8:
+	case VIDEO_BPP16:
+	case VIDEO_BPP32:
+		break;
+	default:
+		return -ENOSYS;
+	}
 
 	start = priv->fb + ystart * priv->line_length;
 	start += xstart * VNBYTES(priv->bpix);
 	line = start;
 	for (row = ystart; row < yend; row++) {
-		switch (priv->bpix) {
-		case VIDEO_BPP8: {
-			u8 *dst = line;
-
-			if (IS_ENABLED(CONFIG_VIDEO_BPP8)) {
-				for (i = 0; i < pixels; i++)
-					*dst++ = colour;
-			}
-			break;
-		}
-		case VIDEO_BPP16: {
-			u16 *dst = line;
-
-			if (IS_ENABLED(CONFIG_VIDEO_BPP16)) {
-				for (i = 0; i < pixels; i++)
-					*dst++ = colour;
-			}
-			break;
-		}
-		case VIDEO_BPP32: {
-			u32 *dst = line;
-
-			if (IS_ENABLED(CONFIG_VIDEO_BPP32)) {
-				for (i = 0; i < pixels; i++)
-					*dst++ = colour;
-			}
-			break;
-		}
-		default:
-			return -ENOSYS;
-		}
+		video_fill_pixels(line, colour, pixels, priv->bpix);
 		line += priv->line_length;
 	}
 	ret = video_sync_copy(dev, start, line);
@@ -367,6 +405,37 @@ void video_set_default_colors(struct udevice *dev, bool invert)
 	priv->colour_bg = video_index_to_colour(priv, back);
 }
 
+#if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF) && \
+	defined(CONFIG_VIDEO_DAMAGE)
+/* Flush only the damaged area, one line at a time unless it is full-width */
+static void video_flush_damage(struct video_priv *priv)
+{
+	struct video_damage *damage = &priv->damage;
+	ulong start, end;
+	int y;
+
+	if (damage->xend <= damage->xstart)
+		return;
+
+	if (!damage->xstart && damage->xend == priv->xsize) {
+		start = (ulong)priv->fb + damage->ystart * priv->line_length;
+		end = (ulong)priv->fb + damage->yend * priv->line_length;
+		flush_dcache_range(ALIGN_DOWN(start, CONFIG_SYS_CACHELINE_SIZE),
+				   ALIGN(end, CONFIG_SYS_CACHELINE_SIZE));
+		return;
+	}
+
+	for (y = damage->ystart; y < damage->yend; y++) {
+		start = (ulong)priv->fb + y * priv->line_length +
+			damage->xstart * VNBITS(priv->bpix) / 8;
+		end = (ulong)priv->fb + y * priv->line_length +
+			DIV_ROUND_UP(damage->xend * VNBITS(priv->bpix), 8);
+		flush_dcache_range(ALIGN_DOWN(start, CONFIG_SYS_CACHELINE_SIZE),
+				   ALIGN(end, CONFIG_SYS_CACHELINE_SIZE));
+	}
+}
+#endif
+
 /* Flush video activity to the caches */
 int video_sync(struct udevice *vid, bool force)
 {
@@ -391,13 +460,19 @@ int video_sync(struct udevice *vid, bool force)
 	 */
 #if defined(CONFIG_ARM) && !CONFIG_IS_ENABLED(SYS_DCACHE_OFF)
 	if (priv->flush_dcache) {
+#ifdef CONFIG_VIDEO_DAMAGE
+		video_flush_damage(priv);
+#else
 		flush_dcache_range((ulong)priv->fb,
 				   ALIGN((ulong)priv->fb + priv->fb_size,
 					 CONFIG_SYS_CACHELINE_SIZE));
+#endif
 	}
 #elif defined(CONFIG_VIDEO_SANDBOX_SDL)
 	sandbox_sdl_sync(priv->fb);
 #endif
+	if (IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		memset(&priv->damage, '\0', sizeof(priv->damage));
 	priv->last_sync = get_timer(0);
 
 	return 0;
@@ -451,54 +526,117 @@ int video_get_ysize(struct udevice *dev)
 	return priv->ysize;
 }
 
-#ifdef CONFIG_VIDEO_COPY
+#ifdef CONFIG_VIDEO_DAMAGE
+void video_damage(struct udevice *vid, int x, int y, int width, int height)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	struct video_damage *damage = &priv->damage;
+	int xend = min(x + width, (int)priv->xsize);
+	int yend = min(y + height, (int)priv->ysize);
+
+	x = max(x, 0);
+	y = max(y, 0);
+	if (x >= xend || y >= yend)
+		return;
+
+	if (damage->xend <= damage->xstart) {
+		damage->xstart = x;
+		damage->ystart = y;
+		damage->xend = xend;
+		damage->yend = yend;
+		return;
+	}
+	damage->xstart = min(damage->xstart, x);
+	damage->ystart = min(damage->ystart, y);
+	damage->xend = max(damage->xend, xend);
+	damage->yend = max(damage->yend, yend);
+}
+
+/**
+ * video_damage_range() - Record damage for a byte range in the frame buffer
+ *
+ * A range within a single line is recorded as such, anything longer covers
+ * the full width of the lines it touches.
+ *
+ * @vid: Video device being updated
+ * @offset: Offset of the range from the start of the frame buffer
+ * @size: Size of the range in bytes
+ */
+static void video_damage_range(struct udevice *vid, long offset, long size)
+{
+	struct video_priv *priv = dev_get_uclass_priv(vid);
+	int bits = VNBITS(priv->bpix);
+	int ystart, yend, xstart, xend;
+
+	if (size <= 0)
+		return;
+
+	ystart = offset / priv->line_length;
+	yend = (offset + size - 1) / priv->line_length + 1;
+	if (yend - ystart == 1) {
+		xstart = (offset % priv->line_length) * 8 / bits;
+		xend = DIV_ROUND_UP(((offset + size - 1) % priv->line_length + 1) *
+				    8, bits);
+	} else {
+		xstart = 0;
+		xend = priv->xsize;
+	}
+	video_damage(vid, xstart, ystart, xend - xstart, yend - ystart);
+}
+#endif
+
+#if defined(CONFIG_VIDEO_COPY) || defined(CONFIG_VIDEO_DAMAGE)
 int video_sync_copy(struct udevice *dev, void *from, void *to)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
+	long offset, size;
 
-	if (priv->copy_fb) {
-		long offset, size;
+	if (!priv->copy_fb && !IS_ENABLED(CONFIG_VIDEO_DAMAGE))
+		return 0;
 
-		/* Find the offset of the first byte to copy */
-		if ((ulong)to > (ulong)from) {
-			size = to - from;
-			offset = from - priv->fb;
-		} else {
-			size = from - to;
-			offset = to - priv->fb;
-		}
+	/* Find the offset of the first byte to copy */
+	if ((ulong)to > (ulong)from) {
+		size = to - from;
+		offset = from - priv->fb;
+	} else {
+		size = from - to;
+		offset = to - priv->fb;
+	}
 
-		/*
-		 * Allow a bit of leeway for valid requests somewhere near the
-		 * frame buffer
-		 */
-		if (offset < -priv->fb_size || offset > 2 * priv->fb_size) {
+	/*
+	 * Allow a bit of leeway for valid requests somewhere near the
+	 * frame buffer
+	 */
+	if (offset < -priv->fb_size || offset > 2 * priv->fb_size) {
 #ifdef DEBUG
-			char str[120];
+		char str[120];
 
-			snprintf(str, sizeof(str),
-				 "[** FAULT sync_copy fb=%p, from=%p, to=%p, offset=%lx]",
-				 priv->fb, from, to, offset);
-			console_puts_select_stderr(true, str);
+		snprintf(str, sizeof(str),
+			 "[** FAULT sync_copy fb=%p, from=%p, to=%p, offset=%lx]",
+			 priv->fb, from, to, offset);
+		console_puts_select_stderr(true, str);
 #endif
-			return -EFAULT;
-		}
+		return -EFAULT;
+	}
 
-		/*
-		 * Silently crop the memcpy. This allows callers to avoid doing
-		 * this themselves. It is common for the end pointer to go a
-		 * few lines after the end of the frame buffer, since most of
-		 * the update algorithms terminate a line after their last write
-		 */
-		if (offset + size > priv->fb_size) {
-			size = priv->fb_size - offset;
-		} else if (offset < 0) {
-			size += offset;
-			offset = 0;
-		}
+	/*
+	 * Silently crop the memcpy. This allows callers to avoid doing
+	 * this themselves. It is common for the end pointer to go a
+	 * few lines after the end of the frame buffer, since most of
+	 * the update algorithms terminate a line after their last write
+	 */
+	if (offset + size > priv->fb_size) {
+		size = priv->fb_size - offset;
+	} else if (offset < 0) {
+		size += offset;
+		offset = 0;
+	}
 
+#ifdef CONFIG_VIDEO_DAMAGE
+	video_damage_range(dev, offset, size);
+#endif
+	if (priv->copy_fb)
 		memcpy(priv->copy_fb + offset, priv->fb + offset, size);
-	}
 
 	return 0;
 }
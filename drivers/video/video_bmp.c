@@ -5,7 +5,9 @@
 
 #include <bmp_layout.h>
 #include <dm.h>
+#include <gzip.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <splash.h>
 #include <video.h>
@@ -252,29 +254,149 @@ void video_bmp_get_info(void *bmp_image, ulong *widthp, ulong *heightp,
 	*bpixp = get_unaligned_le16(&bmp->header.bit_count);
 }
 
-int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
-		      bool align)
+/**
+ * write_bmp_row() - Write one row of a BMP image to the frame buffer
+ *
+ * @fb:		Place in frame buffer to update
+ * @bmap:	Row of BMP pixel data
+ * @width:	Number of pixels to write
+ * @bmp_bpix:	Bits per pixel in the BMP image
+ * @bpix:	Frame buffer bits-per-pixel
+ * @eformat:	Frame buffer format
+ * @palette:	BMP palette table, used for 1bpp and 8bpp images
+ */
+static void write_bmp_row(uchar *fb, uchar *bmap, ulong width, uint bmp_bpix,
+			  uint bpix, enum video_format eformat,
+			  struct bmp_color_table_entry *palette)
+{
+	int j;
+
+	switch (bmp_bpix) {
+	case 1:
+	case 8:
+		for (j = 0; j < width; j++) {
+			write_pix8(fb, bpix, eformat, palette, bmap);
+			bmap++;
+			fb += bpix / 8;
+		}
+		break;
+	case 16:
+		if (CONFIG_IS_ENABLED(BMP_16BPP)) {
+			for (j = 0; j < width; j++) {
+				*fb++ = *bmap++;
+				*fb++ = *bmap++;
+			}
+		}
+		break;
+	case 24:
+		if (CONFIG_IS_ENABLED(BMP_24BPP)) {
+			for (j = 0; j < width; j++) {
+				if (bpix == 16) {
+					/* 16bit 565RGB format */
+					*(u16 *)fb = ((bmap[2] >> 3)
+						<< 11) |
+						((bmap[1] >> 2) << 5) |
+						(bmap[0] >> 3);
+					bmap += 3;
+					fb += 2;
+				} else if (eformat == VIDEO_X2R10G10B10) {
+					u32 pix;
+
+					pix = *bmap++ << 2U;
+					pix |= *bmap++ << 12U;
+					pix |= *bmap++ << 22U;
+					*fb++ = pix & 0xff;
+					*fb++ = (pix >> 8) & 0xff;
+					*fb++ = (pix >> 16) & 0xff;
+					*fb++ = pix >> 24;
+				} else if (eformat == VIDEO_RGBA8888) {
+					u32 pix;
+
+					pix = *bmap++ << 8U; /* blue */
+					pix |= *bmap++ << 16U; /* green */
+					pix |= *bmap++ << 24U; /* red */
+
+					*fb++ = (pix >> 24) & 0xff;
+					*fb++ = (pix >> 16) & 0xff;
+					*fb++ = (pix >> 8) & 0xff;
+					*fb++ = 0xff;
+				} else {
+					*fb++ = *bmap++;
+					*fb++ = *bmap++;
+					*fb++ = *bmap++;
+					*fb++ = 0;
+				}
+			}
+		}
+		break;
+	case 32:
+		if (CONFIG_IS_ENABLED(BMP_32BPP)) {
+			for (j = 0; j < width; j++) {
+				if (eformat == VIDEO_X2R10G10B10) {
+					u32 pix;
+
+					pix = *bmap++ << 2U;
+					pix |= *bmap++ << 12U;
+					pix |= *bmap++ << 22U;
+					pix |= (*bmap++ >> 6) << 30U;
+					*fb++ = pix & 0xff;
+					*fb++ = (pix >> 8) & 0xff;
+					*fb++ = (pix >> 16) & 0xff;
+					*fb++ = pix >> 24;
+				} else if (eformat == VIDEO_RGBA8888) {
+					u32 pix;
+
+					pix = *bmap++ << 8U; /* blue */
+					pix |= *bmap++ << 16U; /* green */
+					pix |= *bmap++ << 24U; /* red */
+					bmap++;
+					*fb++ = (pix >> 24) & 0xff;
+					*fb++ = (pix >> 16) & 0xff;
+					*fb++ = (pix >> 8) & 0xff;
+					*fb++ = 0xff; /* opacity */
+				} else {
+					*fb++ = *bmap++;
+					*fb++ = *bmap++;
+					*fb++ = *bmap++;
+					*fb++ = *bmap++;
+				}
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+/**
+ * video_bmp_draw() - Draw a BMP image, from memory or from a stream
+ *
+ * @dev:	Device to display the bitmap on
+ * @bmp:	BMP header, followed by the palette. If @gs is NULL this is the
+ *		whole image
+ * @gs:		Stream to read the pixel data from, row by row, or NULL to use
+ *		the data following @bmp
+ * @x:		X position in pixels from the left
+ * @y:		Y position in pixels from the top
+ * @align:	true to adjust the coordinates, see video_bmp_display()
+ * Return: 0 if OK, -EPROTONOSUPPORT if the image cannot be drawn from a
+ *	stream, other -ve on error
+ */
+static int video_bmp_draw(struct udevice *dev, struct bmp_image *bmp,
+			  struct gunzip_stream *gs, int x, int y, bool align)
 {
 	struct video_priv *priv = dev_get_uclass_priv(dev);
-	int i, j;
+	int i;
 	uchar *start, *fb;
-	struct bmp_image *bmp = map_sysmem(bmp_image, 0);
-	uchar *bmap;
+	uchar *bmap, *row = NULL;
 	ushort padded_width;
-	unsigned long width, height, byte_width;
+	unsigned long width, height, stride, skip;
 	unsigned long pwidth = priv->xsize;
 	unsigned colours, bpix, bmp_bpix;
 	enum video_format eformat;
 	struct bmp_color_table_entry *palette;
 	int hdr_size;
-	int ret;
-
-	if (!bmp || !(bmp->header.signature[0] == 'B' &&
-	    bmp->header.signature[1] == 'M')) {
-		printf("Error: no valid bmp image at %lx\n", bmp_image);
-
-		return -EINVAL;
-	}
+	int ret = 0;
 
 	video_bmp_get_info(bmp, &width, &height, &bmp_bpix);
 	hdr_size = get_unaligned_le16(&bmp->header.size);
@@ -312,6 +434,8 @@ int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
 	      (int)width, (int)height, (int)colours, 1 << bpix);
 
 	padded_width = (width & 0x3 ? (width & ~0x3) + 4 : width);
+	/* Size of each row in the file, as rows are padded to 32 bits */
+	stride = ALIGN(width * bmp_bpix, 32) / 8;
 
 	if (align) {
 		video_splash_align_axis(&x, priv->xsize, width);
@@ -323,147 +447,139 @@ int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
 	if ((y + height) > priv->ysize)
 		height = priv->ysize - y;
 
-	bmap = (uchar *)bmp + get_unaligned_le32(&bmp->header.data_offset);
 	start = (uchar *)(priv->fb +
 		(y + height) * priv->line_length + x * bpix / 8);
 
 	/* Move back to the final line to be drawn */
 	fb = start - priv->line_length;
 
+	/* 1bpp images are drawn a byte per pixel, so need the whole image */
+	if (gs && bmp_bpix == 1)
+		return -EPROTONOSUPPORT;
+
+	if ((bmp_bpix == 1 || bmp_bpix == 8) &&
+	    CONFIG_IS_ENABLED(VIDEO_BMP_RLE8) &&
+	    get_unaligned_le32(&bmp->header.compression) == BMP_BI_RLE8) {
+		debug("compressed %d\n", BMP_BI_RLE8);
+		if (gs)
+			return -EPROTONOSUPPORT;
+		video_display_rle8_bitmap(dev, bmp, bpix, palette, fb, x, y,
+					  width, height);
+		height = 0;
+	}
+
+	/* How far to move through the image data after each row */
 	switch (bmp_bpix) {
 	case 1:
 	case 8:
-		if (CONFIG_IS_ENABLED(VIDEO_BMP_RLE8)) {
-			u32 compression = get_unaligned_le32(
-				&bmp->header.compression);
-			debug("compressed %d %d\n", compression, BMP_BI_RLE8);
-			if (compression == BMP_BI_RLE8) {
-				video_display_rle8_bitmap(dev, bmp, bpix, palette, fb,
-							  x, y, width, height);
-				break;
-			}
-		}
-
-		/* Not compressed */
-		byte_width = width * (bpix / 8);
-		if (!byte_width)
-			byte_width = width;
-
-		for (i = 0; i < height; ++i) {
-			schedule();
-			for (j = 0; j < width; j++) {
-				write_pix8(fb, bpix, eformat, palette, bmap);
-				bmap++;
-				fb += bpix / 8;
-			}
-			bmap += (padded_width - width);
-			fb -= byte_width + priv->line_length;
-		}
+		skip = padded_width;
 		break;
 	case 16:
-		if (CONFIG_IS_ENABLED(BMP_16BPP)) {
-			for (i = 0; i < height; ++i) {
-				schedule();
-				for (j = 0; j < width; j++) {
-					*fb++ = *bmap++;
-					*fb++ = *bmap++;
-				}
-				bmap += (padded_width - width);
-				fb -= width * 2 + priv->line_length;
-			}
-		}
+		skip = width * 2 + padded_width - width;
 		break;
 	case 24:
-		if (CONFIG_IS_ENABLED(BMP_24BPP)) {
-			for (i = 0; i < height; ++i) {
-				for (j = 0; j < width; j++) {
-					if (bpix == 16) {
-						/* 16bit 565RGB format */
-						*(u16 *)fb = ((bmap[2] >> 3)
-							<< 11) |
-							((bmap[1] >> 2) << 5) |
-							(bmap[0] >> 3);
-						bmap += 3;
-						fb += 2;
-					} else if (eformat == VIDEO_X2R10G10B10) {
-						u32 pix;
-
-						pix = *bmap++ << 2U;
-						pix |= *bmap++ << 12U;
-						pix |= *bmap++ << 22U;
-						*fb++ = pix & 0xff;
-						*fb++ = (pix >> 8) & 0xff;
-						*fb++ = (pix >> 16) & 0xff;
-						*fb++ = pix >> 24;
-					} else if (eformat == VIDEO_RGBA8888) {
-						u32 pix;
-
-						pix = *bmap++ << 8U; /* blue */
-						pix |= *bmap++ << 16U; /* green */
-						pix |= *bmap++ << 24U; /* red */
-
-						*fb++ = (pix >> 24) & 0xff;
-						*fb++ = (pix >> 16) & 0xff;
-						*fb++ = (pix >> 8) & 0xff;
-						*fb++ = 0xff;
-					} else {
-						*fb++ = *bmap++;
-						*fb++ = *bmap++;
-						*fb++ = *bmap++;
-						*fb++ = 0;
-					}
-				}
-				fb -= priv->line_length + width * (bpix / 8);
-				bmap += (padded_width - width);
-			}
-		}
-		break;
-	case 32:
-		if (CONFIG_IS_ENABLED(BMP_32BPP)) {
-			for (i = 0; i < height; ++i) {
-				for (j = 0; j < width; j++) {
-					if (eformat == VIDEO_X2R10G10B10) {
-						u32 pix;
-
-						pix = *bmap++ << 2U;
-						pix |= *bmap++ << 12U;
-						pix |= *bmap++ << 22U;
-						pix |= (*bmap++ >> 6) << 30U;
-						*fb++ = pix & 0xff;
-						*fb++ = (pix >> 8) & 0xff;
-						*fb++ = (pix >> 16) & 0xff;
-						*fb++ = pix >> 24;
-					} else if (eformat == VIDEO_RGBA8888) {
-						u32 pix;
-
-						pix = *bmap++ << 8U; /* blue */
-						pix |= *bmap++ << 16U; /* green */
-						pix |= *bmap++ << 24U; /* red */
-						bmap++;
-						*fb++ = (pix >> 24) & 0xff;
-						*fb++ = (pix >> 16) & 0xff;
-						*fb++ = (pix >> 8) & 0xff;
-						*fb++ = 0xff; /* opacity */
-					} else {
-						*fb++ = *bmap++;
-						*fb++ = *bmap++;
-						*fb++ = *bmap++;
-						*fb++ = *bmap++;
-					}
-				}
-				fb -= priv->line_length + width * (bpix / 8);
-			}
-		}
+		skip = width * 3 + padded_width - width;
 		break;
 	default:
+		skip = width * 4;
 		break;
-	};
+	}
+
+	if (gs) {
+		row = malloc(stride);
+		if (!row)
+			return -ENOMEM;
+	}
+	bmap = (uchar *)bmp + get_unaligned_le32(&bmp->header.data_offset);
+	for (i = 0; i < height; ++i) {
+		schedule();
+		if (gs) {
+			ret = gunzip_stream_read(gs, row, stride);
+			if (ret)
+				break;
+			bmap = row;
+		}
+		write_bmp_row(fb, bmap, width, bmp_bpix, bpix, eformat,
+			      palette);
+		if (!gs)
+			bmap += skip;
+		fb -= priv->line_length;
+	}
+	free(row);
 
 	/* Find the position of the top left of the image in the framebuffer */
 	fb = (uchar *)(priv->fb + y * priv->line_length + x * bpix / 8);
+	if (ret) {
+		video_sync_copy(dev, start, fb);
+		return log_ret(ret);
+	}
 	ret = video_sync_copy(dev, start, fb);
 	if (ret)
 		return log_ret(ret);
 
 	return video_sync(dev, false);
 }
+
+int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
+		      bool align)
+{
+	struct bmp_image *bmp = map_sysmem(bmp_image, 0);
+
+	if (!bmp || !(bmp->header.signature[0] == 'B' &&
+	    bmp->header.signature[1] == 'M')) {
+		printf("Error: no valid bmp image at %lx\n", bmp_image);
+
+		return -EINVAL;
+	}
+
+	return video_bmp_draw(dev, bmp, NULL, x, y, align);
+}
+
+#if CONFIG_IS_ENABLED(VIDEO_BMP_GZIP)
+int video_bmp_display_gz(struct udevice *dev, ulong addr, ulong len, int x,
+			 int y, bool align)
+{
+	struct gunzip_stream *gs;
+	struct bmp_image *bmp, *hdr;
+	ulong size, data_offset;
+	u8 *src = map_sysmem(addr, len);
+	int ret;
+
+	if (len < 10 || src[0] != 0x1f || src[1] != 0x8b)
+		return -ENOENT;
+	gs = gunzip_stream_open(src, len);
+	if (!gs)
+		return -ENOENT;
+
+	/* Read the headers and palette, then leave the rest in the stream */
+	ret = -ENOMEM;
+	bmp = malloc(sizeof(bmp->header));
+	if (!bmp)
+		goto err;
+	ret = -ENOENT;
+	if (gunzip_stream_read(gs, bmp, sizeof(bmp->header)) ||
+	    bmp->header.signature[0] != 'B' || bmp->header.signature[1] != 'M')
+		goto err;
+	data_offset = get_unaligned_le32(&bmp->header.data_offset);
+	if (data_offset < sizeof(bmp->header) ||
+	    data_offset > CONFIG_VAL(VIDEO_LOGO_MAX_SIZE))
+		goto err;
+	ret = -ENOMEM;
+	hdr = realloc(bmp, data_offset);
+	if (!hdr)
+		goto err;
+	bmp = hdr;
+	ret = -EIO;
+	if (gunzip_stream_read(gs, (void *)bmp + sizeof(bmp->header),
+			       data_offset - sizeof(bmp->header)))
+		goto err;
+	debug("Gzipped BMP image detected, streaming\n");
+
+	ret = video_bmp_draw(dev, bmp, gs, x, y, align);
+err:
+	free(bmp);
+	gunzip_stream_end(gs, &size);
+
+	return ret;
+}
+#endif
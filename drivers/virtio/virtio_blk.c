@@ -59,19 +59,32 @@ static void virtio_blk_init_data_sg(void *buffer, lbaint_t blkcnt, struct virtio
 	sg->length = blkcnt * 512;
 }
 
-static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
-			       lbaint_t blkcnt, void *buffer, u32 type)
-{
-	struct virtio_blk_priv *priv = dev_get_priv(dev);
+/**
+ * struct virtio_blk_req - state for one request while it is in the queue
+ *
+ * @out_hdr: Request header, read by the device
+ * @wz_hdr: Range to zero, for VIRTIO_BLK_T_WRITE_ZEROES
+ * @status: Status written back by the device
+ */
+struct virtio_blk_req {
 	struct virtio_blk_outhdr out_hdr;
 	struct virtio_blk_discard_write_zeroes wz_hdr;
+	u8 status;
+};
+
+/* Smallest piece a read or write is split into, in sectors */
+#define VIRTIO_BLK_MIN_REQ_SECTORS	128
+
+static int virtio_blk_add_req(struct udevice *dev, struct virtio_blk_req *req,
+			      u64 sector, lbaint_t blkcnt, void *buffer,
+			      u32 type)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
 	unsigned int num_out = 0, num_in = 0;
 	struct virtio_sg hdr_sg, wz_sg, data_sg, status_sg;
 	struct virtio_sg *sgs[3];
-	u8 status;
-	int ret;
 
-	virtio_blk_init_header_sg(dev, sector, type, &out_hdr, &hdr_sg);
+	virtio_blk_init_header_sg(dev, sector, type, &req->out_hdr, &hdr_sg);
 	sgs[num_out++] = &hdr_sg;
 
 	switch (type) {
@@ -85,7 +98,8 @@ static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
 		break;
 
 	case VIRTIO_BLK_T_WRITE_ZEROES:
-		virtio_blk_init_write_zeroes_sg(dev, sector, blkcnt, &wz_hdr, &wz_sg);
+		virtio_blk_init_write_zeroes_sg(dev, sector, blkcnt,
+						&req->wz_hdr, &wz_sg);
 		sgs[num_out++] = &wz_sg;
 		break;
 
@@ -93,23 +107,71 @@ static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
 		return -EINVAL;
 	}
 
-	virtio_blk_init_status_sg(&status, &status_sg);
+	virtio_blk_init_status_sg(&req->status, &status_sg);
 	sgs[num_out + num_in++] = &status_sg;
 	log_debug("dev=%s, active=%d, priv=%p, priv->vq=%p\n", dev->name,
 		  device_active(dev), priv, priv->vq);
 
-	ret = virtqueue_add(priv->vq, sgs, num_out, num_in);
-	if (ret)
-		return ret;
-
-	virtqueue_kick(priv->vq);
-
-	log_debug("wait...");
-	while (!virtqueue_get_buf(priv->vq, NULL))
-		;
-	log_debug("done\n");
+	return virtqueue_add(priv->vq, sgs, num_out, num_in);
+}
 
-	return status == VIRTIO_BLK_S_OK ? blkcnt : -EIO;
+/*
+ * Reads and writes are split into up to CONFIG_VIRTIO_BLK_MAX_REQS requests
+ * which are all added to the queue before a single kick, so that the host can
+ * work on them in parallel. The completions are then collected together.
+ */
+static ulong virtio_blk_do_req(struct udevice *dev, u64 sector,
+			       lbaint_t blkcnt, void *buffer, u32 type)
+{
+	struct virtio_blk_priv *priv = dev_get_priv(dev);
+	struct virtio_blk_req reqs[CONFIG_VIRTIO_BLK_MAX_REQS];
+	lbaint_t done = 0;
+	int ret = 0;
+
+	do {
+		lbaint_t left = blkcnt - done;
+		lbaint_t per_req = left;
+		int count = 1, queued, i;
+
+		if (type == VIRTIO_BLK_T_IN || type == VIRTIO_BLK_T_OUT) {
+			count = min_t(lbaint_t, CONFIG_VIRTIO_BLK_MAX_REQS,
+				      DIV_ROUND_UP(left,
+						   VIRTIO_BLK_MIN_REQ_SECTORS));
+			per_req = DIV_ROUND_UP(left, count);
+		}
+
+		for (queued = 0; queued < count && left; queued++) {
+			lbaint_t n = min(per_req, left);
+
+			ret = virtio_blk_add_req(dev, &reqs[queued],
+						 sector + done, n,
+						 buffer ? buffer + done * 512 :
+						 NULL, type);
+			/* if the ring is full, send what we have */
+			if (ret)
+				break;
+			done += n;
+			left -= n;
+		}
+		if (!queued)
+			return ret;
+
+		virtqueue_kick(priv->vq);
+
+		log_debug("wait %d...", queued);
+		for (i = 0; i < queued;) {
+			if (virtqueue_get_buf(priv->vq, NULL))
+				i++;
+		}
+		log_debug("done\n");
+
+		for (i = 0; i < queued; i++) {
+			if (reqs[i].status != VIRTIO_BLK_S_OK)
+				return -EIO;
+		}
+	} while (done < blkcnt);
+
+	return blkcnt;
 }
 
 static ulong virtio_blk_read(struct udevice *dev, lbaint_t start,
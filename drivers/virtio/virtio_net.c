@@ -12,7 +12,7 @@
 #include "virtio_net.h"
 
 /* Amount of buffers to keep in the RX virtqueue */
-#define VIRTIO_NET_NUM_RX_BUFS	32
+#define VIRTIO_NET_NUM_RX_BUFS	CONFIG_VIRTIO_NET_RX_BUFS
 
 /*
  * This value comes from the VirtIO spec: 1500 for maximum packet size,
@@ -58,10 +58,11 @@ static int virtio_net_start(struct udevice *dev)
 		/* receive buffer length is always 1526 */
 		sg.length = VIRTIO_NET_RX_BUF_SIZE;
 
-		/* setup the receive buffer address */
+		/* setup the receive buffer address, as many as the ring holds */
 		for (i = 0; i < VIRTIO_NET_NUM_RX_BUFS; i++) {
 			sg.addr = priv->rx_buff[i];
-			virtqueue_add(priv->rx_vq, sgs, 0, 1);
+			if (virtqueue_add(priv->rx_vq, sgs, 0, 1))
+				break;
 		}
 
 		virtqueue_kick(priv->rx_vq);
@@ -129,6 +130,12 @@ static int virtio_net_free_pkt(struct udevice *dev, uchar *packet, int length)
 	/* Put the buffer back to the rx ring */
 	virtqueue_add(priv->rx_vq, sgs, 0, 1);
 
+	/*
+	 * Let the host know, in case it ran out of buffers. With
+	 * VIRTIO_RING_F_EVENT_IDX this only notifies when the host asked.
+	 */
+	virtqueue_kick(priv->rx_vq);
+
 	return 0;
 }
 
@@ -57,6 +57,9 @@ struct blkfront_info {
  * @backend: Backend XenStore path
  * @info: Private data
  * @devid: Device id
+ * @bounce_buffer: Sector buffer for I/O to unaligned memory
+ * @aiocbs: One control block for each ring slot, so that a large transfer
+ *	    can keep the ring full
  */
 struct blkfront_dev {
 	domid_t dom;
@@ -71,6 +74,7 @@ struct blkfront_dev {
 	struct blkfront_info info;
 	unsigned int devid;
 	u8 *bounce_buffer;
+	struct blkfront_aiocb *aiocbs;
 };
 
 struct blkfront_plat {
@@ -116,6 +120,7 @@ static void free_blkfront(struct blkfront_dev *dev)
 
 	unbind_evtchn(dev->evtchn);
 
+	free(dev->aiocbs);
 	free(dev->bounce_buffer);
 	free(dev->nodename);
 	free(dev);
@@ -269,6 +274,12 @@ done:
 		goto error;
 	}
 
+	dev->aiocbs = calloc(RING_SIZE(&dev->ring), sizeof(*dev->aiocbs));
+	if (!dev->aiocbs) {
+		printf("Failed to allocate AIO control blocks\n");
+		goto error;
+	}
+
 	debug("%llu sectors of %u bytes, bounce buffer at %p\n",
 	      dev->info.sectors, dev->info.sector_size,
 	      dev->bounce_buffer);
@@ -531,12 +542,8 @@ static void blkfront_aio_cb(struct blkfront_aiocb *aiocbp, int ret)
 	aiocbp->aio_cb = NULL;
 }
 
-static void blkfront_io(struct blkfront_aiocb *aiocbp, int write)
+static void blkfront_aio_wait(struct blkfront_aiocb *aiocbp)
 {
-	aiocbp->aio_cb = blkfront_aio_cb;
-	blkfront_aio(aiocbp, write);
-	aiocbp->data = NULL;
-
 	while (true) {
 		blkfront_aio_poll(aiocbp->aio_dev);
 		if (aiocbp->data)
@@ -545,6 +552,61 @@ static void blkfront_io(struct blkfront_aiocb *aiocbp, int write)
 	}
 }
 
+static void blkfront_io(struct blkfront_aiocb *aiocbp, int write)
+{
+	aiocbp->aio_cb = blkfront_aio_cb;
+	blkfront_aio(aiocbp, write);
+	aiocbp->data = NULL;
+
+	blkfront_aio_wait(aiocbp);
+}
+
+/**
+ * blkfront_io_batch() - Transfer a sector-aligned buffer
+ * @dev: Blkfront device
+ * @offset: Byte offset on the device
+ * @buf: Memory buffer, which must be sector-aligned
+ * @nbytes: Number of bytes to transfer
+ * @write: 0 to read, 1 to write
+ *
+ * The transfer is split into requests of the maximum size, which are all
+ * put on the ring before waiting for any of them, so that the backend can
+ * work on several at once. A control block is only reused once its previous
+ * request has completed.
+ */
+static void blkfront_io_batch(struct blkfront_dev *dev, off_t offset,
+			      u8 *buf, size_t nbytes, int write)
+{
+	size_t max = (BLKIF_MAX_SEGMENTS_PER_REQUEST - 1) * PAGE_SIZE;
+	int count = RING_SIZE(&dev->ring);
+	struct blkfront_aiocb *aiocbp;
+	int i;
+
+	for (i = 0; nbytes; i = (i + 1) % count) {
+		aiocbp = dev->aiocbs + i;
+		if (aiocbp->aio_cb)
+			blkfront_aio_wait(aiocbp);
+
+		aiocbp->aio_dev = dev;
+		aiocbp->aio_buf = buf;
+		aiocbp->aio_nbytes = min(max, nbytes);
+		aiocbp->aio_offset = offset;
+		aiocbp->aio_cb = blkfront_aio_cb;
+		aiocbp->data = NULL;
+		blkfront_aio(aiocbp, write);
+
+		offset += aiocbp->aio_nbytes;
+		buf += aiocbp->aio_nbytes;
+		nbytes -= aiocbp->aio_nbytes;
+	}
+
+	for (i = 0; i < count; i++) {
+		aiocbp = dev->aiocbs + i;
+		if (aiocbp->aio_cb)
+			blkfront_aio_wait(aiocbp);
+	}
+}
+
 static void blkfront_push_operation(struct blkfront_dev *dev, u8 op,
 				    uint64_t id)
 {
@@ -618,6 +680,11 @@ static ulong pvblock_iop(struct udevice *udev, lbaint_t blknr,
 	}
 
 	unaligned = (uintptr_t)buffer & (blk_dev->info.sector_size - 1);
+	if (!unaligned) {
+		blkfront_io_batch(blk_dev, blknr * desc->blksz, buffer,
+				  blkcnt * desc->blksz, write);
+		return blkcnt;
+	}
 
 	aiocb.aio_dev = blk_dev;
 	aiocb.aio_offset = blknr * desc->blksz;
@@ -625,19 +692,16 @@ static ulong pvblock_iop(struct udevice *udev, lbaint_t blknr,
 	aiocb.data = NULL;
 	blocks_todo = blkcnt;
 	do {
-		aiocb.aio_buf = unaligned ? blk_dev->bounce_buffer : buffer;
+		aiocb.aio_buf = blk_dev->bounce_buffer;
 
-		if (write && unaligned)
+		if (write)
 			memcpy(blk_dev->bounce_buffer, buffer, desc->blksz);
 
-		aiocb.aio_nbytes = unaligned ? desc->blksz :
-			min((size_t)((BLKIF_MAX_SEGMENTS_PER_REQUEST - 1)
-					* PAGE_SIZE),
-			    (size_t)(blocks_todo * desc->blksz));
+		aiocb.aio_nbytes = desc->blksz;
 
 		blkfront_io(&aiocb, write);
 
-		if (!write && unaligned)
+		if (!write)
 			memcpy(buffer, blk_dev->bounce_buffer, desc->blksz);
 
 		aiocb.aio_offset += aiocb.aio_nbytes;
@@ -253,6 +253,121 @@ char *from_env(const char *envvar)
 	return ret;
 }
 
+/* Copy the value of variable @name to @buf, returning its length */
+static int env_copy_value(const char *name, const char *value, char *buf,
+			  unsigned len)
+{
+	unsigned res = strlen(value);
+
+	memcpy(buf, value, min(len, res + 1));
+
+	if (len <= res) {
+		buf[len - 1] = '\0';
+		printf("env_buf [%u bytes] too small for value of \"%s\"\n",
+		       len, name);
+	}
+
+	return res;
+}
+
+#if CONFIG_IS_ENABLED(ENV_F_INDEX)
+/**
+ * struct env_f_index - index of a linear environment, sorted by name
+ *
+ * @env:	Environment the index was built for
+ * @count:	Number of variables
+ * @var:	Start of each "name=value" variable, sorted by name. Variables
+ *		with the same name stay in the order they have in @env
+ */
+struct env_f_index {
+	const char *env;
+	int count;
+	const char *var[];
+};
+
+/* Compare variable names, either of which may be followed by '=' */
+static int env_f_name_cmp(const char *a, const char *b)
+{
+	while (*a && *a != '=' && *a == *b) {
+		a++;
+		b++;
+	}
+
+	return (*a == '=' ? 0 : (u8)*a) - (*b == '=' ? 0 : (u8)*b);
+}
+
+static int env_f_var_cmp(const void *a, const void *b)
+{
+	const char *va = *(const char **)a;
+	const char *vb = *(const char **)b;
+	int ret;
+
+	ret = env_f_name_cmp(va, vb);
+	if (ret)
+		return ret;
+
+	return va < vb ? -1 : va > vb;
+}
+
+/*
+ * Get the index for @env, building it the first time. The index lives in
+ * the pre-relocation malloc() area, so U-Boot proper only uses it until it
+ * has relocated. Returns NULL to fall back to a linear search.
+ */
+static struct env_f_index *env_f_index_get(const char *env)
+{
+	struct env_f_index *idx = gd->env_f_index;
+	const char *p, *end;
+	int count = 0;
+
+	if (!IS_ENABLED(CONFIG_XPL_BUILD) && (gd->flags & GD_FLG_RELOC))
+		return NULL;
+
+	if (idx && idx->env == env)
+		return idx;
+
+	for (p = env; *p != '\0'; p = end + 1) {
+		for (end = p; *end != '\0'; ++end)
+			if (end - env >= CONFIG_ENV_SIZE)
+				return NULL;
+		count++;
+	}
+
+	free(idx);
+	idx = malloc(sizeof(*idx) + count * sizeof(idx->var[0]));
+	gd->env_f_index = idx;
+	if (!idx)
+		return NULL;
+
+	idx->env = env;
+	idx->count = 0;
+	for (p = env; *p != '\0'; p += strlen(p) + 1)
+		idx->var[idx->count++] = p;
+	qsort(idx->var, count, sizeof(idx->var[0]), env_f_var_cmp);
+
+	return idx;
+}
+
+static int env_f_index_lookup(struct env_f_index *idx, const char *name,
+			      char *buf, unsigned len)
+{
+	int lo = 0, hi = idx->count, mid;
+
+	/* find the first variable not sorting before @name */
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (env_f_name_cmp(name, idx->var[mid]) > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == idx->count || env_f_name_cmp(name, idx->var[lo]))
+		return -1;
+
+	return env_copy_value(name, idx->var[lo] + strlen(name) + 1, buf, len);
+}
+#endif /* ENV_F_INDEX */
+
 static int env_get_from_linear(const char *env, const char *name, char *buf,
 			       unsigned len)
 {
@@ -262,30 +377,26 @@ static int env_get_from_linear(const char *env, const char *name, char *buf,
 	if (name == NULL || *name == '\0')
 		return -1;
 
+#if CONFIG_IS_ENABLED(ENV_F_INDEX)
+	{
+		struct env_f_index *idx = env_f_index_get(env);
+
+		if (idx)
+			return env_f_index_lookup(idx, name, buf, len);
+	}
+#endif
+
 	name_len = strlen(name);
 
 	for (p = env; *p != '\0'; p = end + 1) {
-		const char *value;
-		unsigned res;
-
 		for (end = p; *end != '\0'; ++end)
 			if (end - env >= CONFIG_ENV_SIZE)
 				return -1;
 
 		if (strncmp(name, p, name_len) || p[name_len] != '=')
 			continue;
-		value = &p[name_len + 1];
-
-		res = end - value;
-		memcpy(buf, value, min(len, res + 1));
-
-		if (len <= res) {
-			buf[len - 1] = '\0';
-			printf("env_buf [%u bytes] too small for value of \"%s\"\n",
-			       len, name);
-		}
 
-		return res;
+		return env_copy_value(name, &p[name_len + 1], buf, len);
 	}
 
 	return -1;
@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Journal of environment changes, so that saving the environment only needs
+ * to append the variables which changed since the last save
+ *
+ * The journal is an area of storage following the environment. Each record
+ * holds a list of changes in the same form as the environment data, i.e.
+ * "name=value" to set a variable and "name" to delete it, each terminated by
+ * a NUL, with an empty string at the end. A record starts with its length and
+ * a CRC32 which is seeded with the CRC of the environment it applies to, so
+ * that a journal left over from an older environment is never replayed.
+ *
+ * Records are added to the erased (0xff) part of the journal. A torn or
+ * corrupted record stops the replay, after which the journal is considered
+ * full, so that the next save writes out the whole environment again. This
+ * also erases the journal.
+ */
+
+#include <env.h>
+#include <env_internal.h>
+#include <log.h>
+#include <malloc.h>
+#include <search.h>
+#include <asm/unaligned.h>
+#include <linux/errno.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+#include <u-boot/crc.h>
+
+#define JOURNAL_ERASED		(~(u32)0)
+
+/**
+ * struct env_journal_rec - Header of a journal record
+ *
+ * The length comes first, so that a record which was only partly written
+ * cannot look like the erased end of the journal
+ *
+ * @len: Number of bytes of data following the header
+ * @crc: CRC32 of the data, seeded with the CRC of the environment
+ */
+struct env_journal_rec {
+	u32 len;
+	u32 crc;
+};
+
+/**
+ * struct env_journal - State of the journal
+ *
+ * @base: Environment as it is in storage, as exported by hexport_r(), or
+ *	NULL if not known, so that the whole environment must be saved
+ * @base_len: Length of @base in bytes, including the final NUL
+ * @next: Environment after the pending record is written, or NULL if none
+ * @next_len: Length of @next in bytes
+ * @seed: CRC of the environment in storage, used to seed the record CRCs
+ * @used: Number of bytes of the journal which are in use
+ * @full: true if no more records can be added
+ */
+struct env_journal {
+	char *base;
+	int base_len;
+	char *next;
+	int next_len;
+	u32 seed;
+	uint used;
+	bool full;
+};
+
+static struct env_journal env_journal;
+
+static int env_journal_export(char **bufp)
+{
+	*bufp = NULL;
+
+	return hexport_r(&env_htab, '\0', 0, bufp, 0, 0, NULL);
+}
+
+/* Compare the names of two "name=value" strings */
+static int env_journal_keycmp(const char *a, const char *b)
+{
+	for (; *a != '=' && *a == *b; a++, b++)
+		;
+
+	return (*a == '=' ? 0 : (u8)*a) - (*b == '=' ? 0 : (u8)*b);
+}
+
+/**
+ * env_journal_diff() - Write out the changes between two exported environments
+ *
+ * Both lists are sorted by name, as produced by hexport_r()
+ *
+ * @old: Old environment
+ * @new: New environment
+ * @out: Buffer for the changes, or NULL to just work out their size
+ * Return: number of bytes of changes, excluding the final NUL
+ */
+static uint env_journal_diff(const char *old, const char *new, char *out)
+{
+	uint len = 0;
+
+	while (*old || *new) {
+		const char *add = NULL;
+		int cmp, size;
+
+		if (!*new)
+			cmp = -1;
+		else if (!*old)
+			cmp = 1;
+		else
+			cmp = env_journal_keycmp(old, new);
+
+		if (cmp < 0) {
+			/* Deleted, so just give the name */
+			size = strchrnul(old, '=') - old;
+			if (out) {
+				memcpy(out + len, old, size);
+				out[len + size] = '\0';
+			}
+			len += size + 1;
+		} else if (cmp > 0 || strcmp(old, new)) {
+			add = new;
+		}
+		if (add) {
+			size = strlen(add) + 1;
+			if (out)
+				memcpy(out + len, add, size);
+			len += size;
+		}
+		if (cmp <= 0)
+			old += strlen(old) + 1;
+		if (cmp >= 0)
+			new += strlen(new) + 1;
+	}
+
+	return len;
+}
+
+/* Set the environment in storage, as the base for the next record */
+static void env_journal_set_base(char *base, int len)
+{
+	free(env_journal.base);
+	env_journal.base = base;
+	env_journal.base_len = len;
+}
+
+int env_journal_load(const void *buf, uint size, u32 seed)
+{
+	struct env_journal *jnl = &env_journal;
+	const struct env_journal_rec *rec;
+	uint pos = 0, count = 0;
+	char *base;
+	int len;
+
+	jnl->seed = seed;
+	jnl->full = false;
+	while (pos + sizeof(*rec) <= size) {
+		u32 rec_len, crc;
+
+		rec = buf + pos;
+		rec_len = get_unaligned(&rec->len);
+		crc = get_unaligned(&rec->crc);
+		if (rec_len == JOURNAL_ERASED && crc == JOURNAL_ERASED)
+			break;
+		if (rec_len > size - pos - sizeof(*rec) ||
+		    crc32(seed, (uchar *)(rec + 1), rec_len) != crc) {
+			log_warning("Bad environment journal record at %x\n",
+				    pos);
+			jnl->full = true;
+			break;
+		}
+		if (!himport_r(&env_htab, (char *)(rec + 1), rec_len, '\0',
+			       H_NOCLEAR | H_EXTERNAL, 0, 0, NULL))
+			log_warning("Cannot import environment journal record at %x\n",
+				    pos);
+		pos += ALIGN(sizeof(*rec) + rec_len, 4);
+		count++;
+	}
+	jnl->used = pos;
+	log_debug("Replayed %u journal records, %x bytes\n", count, pos);
+
+	len = env_journal_export(&base);
+	if (len < 0) {
+		env_journal_set_base(NULL, 0);
+		return -ENOMEM;
+	}
+	env_journal_set_base(base, len);
+
+	return count;
+}
+
+void env_journal_reset(u32 seed)
+{
+	char *base;
+	int len;
+
+	env_journal.seed = seed;
+	env_journal.used = 0;
+	env_journal.full = false;
+	len = env_journal_export(&base);
+	env_journal_set_base(len < 0 ? NULL : base, len);
+}
+
+int env_journal_add(uint size, void **recp, uint *offsetp)
+{
+	struct env_journal *jnl = &env_journal;
+	struct env_journal_rec *rec;
+	uint len, rec_size;
+	char *next;
+	int next_len;
+
+	if (!jnl->base || jnl->full)
+		return -ENOSPC;
+	next_len = env_journal_export(&next);
+	if (next_len < 0)
+		return -ENOMEM;
+
+	/* The journal is no use if the environment cannot be compacted */
+	len = env_journal_diff(jnl->base, next, NULL);
+	rec_size = ALIGN(sizeof(*rec) + len + 1, 4);
+	if (next_len > ENV_SIZE || jnl->used + rec_size > size) {
+		free(next);
+		return -ENOSPC;
+	}
+	if (!len) {
+		free(next);
+		return 0;
+	}
+
+	rec = calloc(1, rec_size);
+	if (!rec) {
+		free(next);
+		return -ENOMEM;
+	}
+	env_journal_diff(jnl->base, next, (char *)(rec + 1));
+	rec->len = len + 1;
+	rec->crc = crc32(jnl->seed, (uchar *)(rec + 1), rec->len);
+
+	free(jnl->next);
+	jnl->next = next;
+	jnl->next_len = next_len;
+	*recp = rec;
+	*offsetp = jnl->used;
+
+	return rec_size;
+}
+
+void env_journal_added(uint rec_size)
+{
+	struct env_journal *jnl = &env_journal;
+
+	jnl->used += rec_size;
+	env_journal_set_base(jnl->next, jnl->next_len);
+	jnl->next = NULL;
+}
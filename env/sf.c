@@ -36,6 +36,15 @@ static ulong env_new_offset	= CONFIG_ENV_OFFSET_REDUND;
 
 #endif /* CONFIG_ENV_OFFSET_REDUND */
 
+#if CONFIG_IS_ENABLED(ENV_JOURNAL)
+#define ENV_JOURNAL_SIZE	CONFIG_ENV_JOURNAL_SIZE
+#else
+#define ENV_JOURNAL_SIZE	0
+#endif
+
+/* The journal follows the environment and is erased along with it */
+#define ENV_AREA_SIZE		(CONFIG_ENV_SIZE + ENV_JOURNAL_SIZE)
+
 DECLARE_GLOBAL_DATA_PTR;
 
 __weak int spi_get_env_dev(void)
@@ -74,6 +83,61 @@ static int setup_flash_device(struct spi_flash **env_flash)
 	return 0;
 }
 
+/*
+ * Append the changes since the last save to the journal of the environment at
+ * @offset. If this fails, the whole environment must be saved instead.
+ */
+static int env_sf_journal_save(struct spi_flash *env_flash, u32 offset)
+{
+	void *rec;
+	uint pos;
+	int size, ret;
+
+	if (!CONFIG_IS_ENABLED(ENV_JOURNAL))
+		return -ENOSPC;
+	size = env_journal_add(ENV_JOURNAL_SIZE, &rec, &pos);
+	if (size < 0)
+		return size;
+	if (!size) {
+		puts("No changes...");
+		return 0;
+	}
+
+	puts("Writing journal to SPI flash...");
+	ret = spi_flash_write(env_flash, offset + CONFIG_ENV_SIZE + pos, size,
+			      rec);
+	free(rec);
+	if (ret)
+		return ret;
+	env_journal_added(size);
+	puts("done\n");
+
+	return 0;
+}
+
+/* Replay the journal of the environment at @offset, which has CRC @crc */
+static void env_sf_journal_load(struct spi_flash *env_flash, u32 offset,
+				u32 crc)
+{
+	void *buf;
+	int ret;
+
+	if (!CONFIG_IS_ENABLED(ENV_JOURNAL))
+		return;
+	buf = memalign(ARCH_DMA_MINALIGN, ENV_JOURNAL_SIZE);
+	if (!buf) {
+		puts("Cannot read environment journal\n");
+		return;
+	}
+	ret = spi_flash_read(env_flash, offset + CONFIG_ENV_SIZE,
+			     ENV_JOURNAL_SIZE, buf);
+	if (!ret)
+		ret = env_journal_load(buf, ENV_JOURNAL_SIZE, crc);
+	if (ret < 0)
+		printf("Cannot read environment journal (err=%d)\n", ret);
+	free(buf);
+}
+
 #if defined(CONFIG_ENV_OFFSET_REDUND)
 static int env_sf_save(void)
 {
@@ -91,9 +155,15 @@ static int env_sf_save(void)
 	if (IS_ENABLED(CONFIG_ENV_SECT_SIZE_AUTO))
 		sect_size = env_flash->mtd.erasesize;
 
+	if (!env_sf_journal_save(env_flash, gd->env_valid == ENV_VALID ?
+				 CONFIG_ENV_OFFSET : CONFIG_ENV_OFFSET_REDUND))
+		goto done;
+
 	ret = env_export(&env_new);
-	if (ret)
-		return -EIO;
+	if (ret) {
+		ret = -EIO;
+		goto done;
+	}
 	env_new.flags	= ENV_REDUND_ACTIVE;
 
 	if (gd->env_valid == ENV_VALID) {
@@ -105,9 +175,9 @@ static int env_sf_save(void)
 	}
 
 	/* Is the sector larger than the env (i.e. embedded) */
-	if (sect_size > CONFIG_ENV_SIZE) {
-		saved_size = sect_size - CONFIG_ENV_SIZE;
-		saved_offset = env_new_offset + CONFIG_ENV_SIZE;
+	if (sect_size > ENV_AREA_SIZE) {
+		saved_size = sect_size - ENV_AREA_SIZE;
+		saved_offset = env_new_offset + ENV_AREA_SIZE;
 		saved_buffer = memalign(ARCH_DMA_MINALIGN, saved_size);
 		if (!saved_buffer) {
 			ret = -ENOMEM;
@@ -119,7 +189,7 @@ static int env_sf_save(void)
 			goto done;
 	}
 
-	sector = DIV_ROUND_UP(CONFIG_ENV_SIZE, sect_size);
+	sector = DIV_ROUND_UP(ENV_AREA_SIZE, sect_size);
 
 	puts("Erasing SPI flash...");
 	ret = spi_flash_erase(env_flash, env_new_offset,
@@ -134,7 +204,7 @@ static int env_sf_save(void)
 	if (ret)
 		goto done;
 
-	if (sect_size > CONFIG_ENV_SIZE) {
+	if (sect_size > ENV_AREA_SIZE) {
 		ret = spi_flash_write(env_flash, saved_offset,
 					saved_size, saved_buffer);
 		if (ret)
@@ -149,6 +219,8 @@ static int env_sf_save(void)
 	puts("done\n");
 
 	gd->env_valid = gd->env_valid == ENV_REDUND ? ENV_VALID : ENV_REDUND;
+	if (CONFIG_IS_ENABLED(ENV_JOURNAL))
+		env_journal_reset(env_new.crc);
 
 	printf("Valid environment: %d\n", (int)gd->env_valid);
 
@@ -189,6 +261,14 @@ static int env_sf_load(void)
 
 	ret = env_import_redund((char *)tmp_env1, read1_fail, (char *)tmp_env2,
 				read2_fail, H_EXTERNAL);
+	if (!ret) {
+		if (gd->env_valid == ENV_VALID)
+			env_sf_journal_load(env_flash, CONFIG_ENV_OFFSET,
+					    tmp_env1->crc);
+		else
+			env_sf_journal_load(env_flash, CONFIG_ENV_OFFSET_REDUND,
+					    tmp_env2->crc);
+	}
 
 	spi_flash_free(env_flash);
 out:
@@ -214,10 +294,15 @@ static int env_sf_save(void)
 	if (IS_ENABLED(CONFIG_ENV_SECT_SIZE_AUTO))
 		sect_size = env_flash->mtd.erasesize;
 
+	if (!env_sf_journal_save(env_flash, CONFIG_ENV_OFFSET)) {
+		ret = 0;
+		goto done;
+	}
+
 	/* Is the sector larger than the env (i.e. embedded) */
-	if (sect_size > CONFIG_ENV_SIZE) {
-		saved_size = sect_size - CONFIG_ENV_SIZE;
-		saved_offset = CONFIG_ENV_OFFSET + CONFIG_ENV_SIZE;
+	if (sect_size > ENV_AREA_SIZE) {
+		saved_size = sect_size - ENV_AREA_SIZE;
+		saved_offset = CONFIG_ENV_OFFSET + ENV_AREA_SIZE;
 		saved_buffer = malloc(saved_size);
 		if (!saved_buffer) {
 			ret = -ENOMEM;
@@ -234,7 +319,7 @@ static int env_sf_save(void)
 	if (ret)
 		goto done;
 
-	sector = DIV_ROUND_UP(CONFIG_ENV_SIZE, sect_size);
+	sector = DIV_ROUND_UP(ENV_AREA_SIZE, sect_size);
 
 	puts("Erasing SPI flash...");
 	ret = spi_flash_erase(env_flash, CONFIG_ENV_OFFSET,
@@ -248,7 +333,7 @@ static int env_sf_save(void)
 	if (ret)
 		goto done;
 
-	if (sect_size > CONFIG_ENV_SIZE) {
+	if (sect_size > ENV_AREA_SIZE) {
 		ret = spi_flash_write(env_flash, saved_offset,
 			saved_size, saved_buffer);
 		if (ret)
@@ -257,6 +342,8 @@ static int env_sf_save(void)
 
 	ret = 0;
 	puts("done\n");
+	if (CONFIG_IS_ENABLED(ENV_JOURNAL))
+		env_journal_reset(env_new.crc);
 
 done:
 	spi_flash_free(env_flash);
@@ -291,8 +378,11 @@ static int env_sf_load(void)
 	}
 
 	ret = env_import(buf, 1, H_EXTERNAL);
-	if (!ret)
+	if (!ret) {
 		gd->env_valid = ENV_VALID;
+		env_sf_journal_load(env_flash, CONFIG_ENV_OFFSET,
+				    ((env_t *)buf)->crc);
+	}
 
 err_read:
 	spi_flash_free(env_flash);
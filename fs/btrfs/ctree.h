@@ -122,6 +122,18 @@ struct btrfs_fs_info {
 	u32 nodesize;
 	u32 sectorsize;
 	u32 stripesize;
+
+	/* Compressed data read ahead by the last file read */
+	char *ra_buf;
+	u32 ra_size;
+	u64 ra_start;
+	u32 ra_len;
+
+	/* The last compressed extent which was only partly read */
+	char *dc_buf;
+	u32 dc_size;
+	u64 dc_bytenr;
+	u32 dc_len;
 };
 
 static inline u32 BTRFS_MAX_ITEM_SIZE(const struct btrfs_fs_info *info)
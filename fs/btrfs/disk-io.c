@@ -761,6 +761,8 @@ void btrfs_free_fs_info(struct btrfs_fs_info *fs_info)
 	free(fs_info->chunk_root);
 	free(fs_info->csum_root);
 	free(fs_info->super_copy);
+	free(fs_info->ra_buf);
+	free(fs_info->dc_buf);
 	free(fs_info);
 }
 
@@ -409,31 +409,106 @@ out:
 }
 
 /*
- * Read out regular extent.
+ * Maximum amount of compressed data to read in one go. Compressed extents
+ * are at most 128KiB, so the ones following the extent being read are read
+ * together with it.
+ */
+#define BTRFS_READ_AHEAD_SIZE	SZ_1M
+
+/* Return the end of the chunk containing @logical */
+static u64 chunk_end(struct btrfs_fs_info *fs_info, u64 logical)
+{
+	struct cache_extent *ce;
+
+	ce = search_cache_extent(&fs_info->mapping_tree.cache_tree, logical);
+	if (!ce || ce->start > logical)
+		return logical;
+	return ce->start + ce->size;
+}
+
+/* Read @len bytes of data at @logical, trying each mirror in turn */
+static int read_data_mirrors(struct btrfs_fs_info *fs_info, char *dest,
+			     u64 logical, u64 len)
+{
+	int num_copies;
+	u64 read;
+	int i;
+	int ret;
+
+	num_copies = btrfs_num_copies(fs_info, logical, len);
+	for (i = 1; i <= num_copies; i++) {
+		read = len;
+		ret = read_extent_data(fs_info, dest, logical, &read, i);
+		if (ret < 0 || read != len)
+			continue;
+		return 0;
+	}
+	return -EIO;
+}
+
+/*
+ * Get the on-disk data of the compressed extent at @bytenr.
  *
- * Truncating should be handled by the caller.
+ * Up to @ra_len bytes (but no more than BTRFS_READ_AHEAD_SIZE) are read from
+ * @bytenr on, so that the compressed extents following this one are likely
+ * to be read already. Data gets no bigger when compressed, so @ra_len is the
+ * remaining length to be read from the file.
  *
- * @offset and @len should not cross the extent boundary.
- * Return the number of bytes read.
- * Return <0 for error.
+ * Return 0 and set @cbuf to the data, or <0 for error.
  */
-int btrfs_read_extent_reg(struct btrfs_path *path,
-			  struct btrfs_file_extent_item *fi, u64 offset,
-			  int len, char *dest)
+static int read_compressed_data(struct btrfs_fs_info *fs_info, u64 bytenr,
+				u32 csize, u64 ra_len, char **cbuf)
+{
+	u64 len;
+	int ret;
+
+	if (fs_info->ra_buf && bytenr >= fs_info->ra_start &&
+	    bytenr + csize <= fs_info->ra_start + fs_info->ra_len)
+		goto out;
+
+	len = min_t(u64, ra_len, BTRFS_READ_AHEAD_SIZE);
+	len = min(len, chunk_end(fs_info, bytenr) - bytenr);
+	len = round_up(max_t(u64, len, csize), fs_info->sectorsize);
+
+	fs_info->ra_len = 0;
+	if (len > fs_info->ra_size) {
+		free(fs_info->ra_buf);
+		fs_info->ra_size = 0;
+		fs_info->ra_buf = malloc_cache_aligned(len);
+		if (!fs_info->ra_buf)
+			return -ENOMEM;
+		fs_info->ra_size = len;
+	}
+
+	ret = read_data_mirrors(fs_info, fs_info->ra_buf, bytenr, len);
+	/* Don't fail on data which is not needed yet */
+	if (ret < 0 && len > csize) {
+		len = csize;
+		ret = read_data_mirrors(fs_info, fs_info->ra_buf, bytenr, len);
+	}
+	if (ret < 0)
+		return ret;
+	fs_info->ra_start = bytenr;
+	fs_info->ra_len = len;
+out:
+	*cbuf = fs_info->ra_buf + bytenr - fs_info->ra_start;
+	return 0;
+}
+
+static int __btrfs_read_extent_reg(struct btrfs_path *path,
+				   struct btrfs_file_extent_item *fi,
+				   u64 offset, int len, char *dest, u64 ra_len)
 {
 	struct extent_buffer *leaf = path->nodes[0];
 	struct btrfs_fs_info *fs_info = leaf->fs_info;
 	struct btrfs_key key;
 	u64 extent_num_bytes;
+	u64 extent_offset;
 	u64 disk_bytenr;
-	u64 read;
-	char *cbuf = NULL;
-	char *dbuf = NULL;
+	char *cbuf;
+	char *dbuf;
 	u32 csize;
 	u32 dsize;
-	bool finished = false;
-	int num_copies;
-	int i;
 	int slot = path->slots[0];
 	int ret;
 
@@ -451,74 +526,84 @@ int btrfs_read_extent_reg(struct btrfs_path *path,
 		return len;
 	}
 
-	if (btrfs_file_extent_compression(leaf, fi) == BTRFS_COMPRESS_NONE) {
-		u64 logical;
-
-		logical = btrfs_file_extent_disk_bytenr(leaf, fi) +
-			  btrfs_file_extent_offset(leaf, fi) +
-			  offset - key.offset;
-		read = len;
+	extent_offset = btrfs_file_extent_offset(leaf, fi) + offset - key.offset;
+	disk_bytenr = btrfs_file_extent_disk_bytenr(leaf, fi);
 
-		num_copies = btrfs_num_copies(fs_info, logical, len);
-		for (i = 1; i <= num_copies; i++) {
-			ret = read_extent_data(fs_info, dest, logical, &read, i);
-			if (ret < 0 || read != len)
-				continue;
-			finished = true;
-			break;
-		}
-		if (!finished)
-			return -EIO;
+	if (btrfs_file_extent_compression(leaf, fi) == BTRFS_COMPRESS_NONE) {
+		ret = read_data_mirrors(fs_info, dest,
+					disk_bytenr + extent_offset, len);
+		if (ret < 0)
+			return ret;
 		return len;
 	}
 
 	csize = btrfs_file_extent_disk_num_bytes(leaf, fi);
 	dsize = btrfs_file_extent_ram_bytes(leaf, fi);
-	disk_bytenr = btrfs_file_extent_disk_bytenr(leaf, fi);
-	num_copies = btrfs_num_copies(fs_info, disk_bytenr, csize);
 
-	cbuf = malloc_cache_aligned(csize);
-	dbuf = malloc_cache_aligned(dsize);
-	if (!cbuf || !dbuf) {
-		ret = -ENOMEM;
-		goto out;
-	}
+	/* Decompressed by the previous read, e.g. of its unaligned head */
+	if (fs_info->dc_len && fs_info->dc_bytenr == disk_bytenr &&
+	    fs_info->dc_len == dsize)
+		goto copy;
+
 	/* For compressed extent, we must read the whole on-disk extent */
-	for (i = 1; i <= num_copies; i++) {
-		read = csize;
-		ret = read_extent_data(fs_info, cbuf, disk_bytenr,
-				       &read, i);
-		if (ret < 0 || read != csize)
-			continue;
-		finished = true;
-		break;
+	ret = read_compressed_data(fs_info, disk_bytenr, csize, ra_len, &cbuf);
+	if (ret < 0)
+		return ret;
+
+	/* The whole extent is needed, decompress it in place */
+	if (extent_offset == 0 && len == dsize) {
+		ret = btrfs_decompress(btrfs_file_extent_compression(leaf, fi),
+				       cbuf, csize, dest, dsize);
+		if (ret < 0)
+			return -EIO;
+		if (ret < dsize)
+			memset(dest + ret, 0, dsize - ret);
+		return len;
 	}
-	if (!finished) {
-		ret = -EIO;
-		goto out;
+
+	fs_info->dc_len = 0;
+	if (dsize > fs_info->dc_size) {
+		free(fs_info->dc_buf);
+		fs_info->dc_size = 0;
+		fs_info->dc_buf = malloc_cache_aligned(dsize);
+		if (!fs_info->dc_buf)
+			return -ENOMEM;
+		fs_info->dc_size = dsize;
 	}
+	dbuf = fs_info->dc_buf;
 
 	ret = btrfs_decompress(btrfs_file_extent_compression(leaf, fi), cbuf,
 			       csize, dbuf, dsize);
-	if (ret < 0) {
-		ret = -EIO;
-		goto out;
-	}
+	if (ret < 0)
+		return -EIO;
 	/*
 	 * The compressed part ends before sector boundary, the remaining needs
 	 * to be zeroed out.
 	 */
 	if (ret < dsize)
 		memset(dbuf + ret, 0, dsize - ret);
+	fs_info->dc_bytenr = disk_bytenr;
+	fs_info->dc_len = dsize;
+copy:
 	/* Then copy the needed part */
-	memcpy(dest,
-	       dbuf + btrfs_file_extent_offset(leaf, fi) + offset - key.offset,
-	       len);
-	ret = len;
-out:
-	free(cbuf);
-	free(dbuf);
-	return ret;
+	memcpy(dest, fs_info->dc_buf + extent_offset, len);
+	return len;
+}
+
+/*
+ * Read out regular extent.
+ *
+ * Truncating should be handled by the caller.
+ *
+ * @offset and @len should not cross the extent boundary.
+ * Return the number of bytes read.
+ * Return <0 for error.
+ */
+int btrfs_read_extent_reg(struct btrfs_path *path,
+			  struct btrfs_file_extent_item *fi, u64 offset,
+			  int len, char *dest)
+{
+	return __btrfs_read_extent_reg(path, fi, offset, len, dest, 0);
 }
 
 /*
@@ -672,6 +757,10 @@ int btrfs_file_read(struct btrfs_root *root, u64 ino, u64 file_offset, u64 len,
 	u64 aligned_end = round_down(file_offset + len, fs_info->sectorsize);
 	u64 next_offset;
 	u64 cur = aligned_start;
+	u64 pending_logical = 0;
+	u64 pending_len = 0;
+	char *pending_dest = NULL;
+	u64 read_len;
 	int ret = 0;
 
 	btrfs_init_path(&path);
@@ -748,12 +837,53 @@ int btrfs_file_read(struct btrfs_root *root, u64 ino, u64 file_offset, u64 len,
 		/* Read the remaining part of the extent */
 		extent_num_bytes = btrfs_file_extent_num_bytes(path.nodes[0],
 							       fi);
-		ret = btrfs_read_extent_reg(&path, fi, cur,
-				min(extent_num_bytes, aligned_end - cur),
-				dest + cur - file_offset);
+		read_len = min(key.offset + extent_num_bytes, aligned_end) - cur;
+
+		/*
+		 * Uncompressed extents which follow each other on disk are
+		 * read together, as long as they are in the same chunk.
+		 */
+		if (btrfs_file_extent_compression(path.nodes[0], fi) ==
+		    BTRFS_COMPRESS_NONE) {
+			u64 logical;
+
+			logical = btrfs_file_extent_disk_bytenr(path.nodes[0],
+								fi) +
+				  btrfs_file_extent_offset(path.nodes[0], fi) +
+				  cur - key.offset;
+			if (pending_len &&
+			    (logical != pending_logical + pending_len ||
+			     logical + read_len >
+			     chunk_end(fs_info, pending_logical))) {
+				ret = read_data_mirrors(fs_info, pending_dest,
+							pending_logical,
+							pending_len);
+				if (ret < 0)
+					goto out;
+				pending_len = 0;
+			}
+			if (!pending_len) {
+				pending_logical = logical;
+				pending_dest = dest + cur - file_offset;
+			}
+			pending_len += read_len;
+			cur += read_len;
+			continue;
+		}
+
+		ret = __btrfs_read_extent_reg(&path, fi, cur, read_len,
+					      dest + cur - file_offset,
+					      aligned_end - cur);
+		if (ret < 0)
+			goto out;
+		cur += read_len;
+	}
+	if (pending_len) {
+		ret = read_data_mirrors(fs_info, pending_dest, pending_logical,
+					pending_len);
 		if (ret < 0)
 			goto out;
-		cur += min(extent_num_bytes, aligned_end - cur);
+		pending_len = 0;
 	}
 
 	/* Read the tailing unaligned part*/
@@ -772,6 +902,9 @@ int btrfs_file_read(struct btrfs_root *root, u64 ino, u64 file_offset, u64 len,
 	}
 out:
 	btrfs_release_path(&path);
+	if (ret >= 0 && pending_len)
+		ret = read_data_mirrors(fs_info, pending_dest, pending_logical,
+					pending_len);
 	if (ret < 0)
 		return ret;
 	return len;
@@ -216,11 +216,205 @@ static int erofs_read_raw_data(struct erofs_inode *inode, char *buffer,
 	return 0;
 }
 
+#ifdef CONFIG_FS_EROFS_ZIP_CACHE_ENTRIES
+#define Z_EROFS_CACHE_ENTRIES		CONFIG_FS_EROFS_ZIP_CACHE_ENTRIES
+#else
+#define Z_EROFS_CACHE_ENTRIES		1
+#endif
+/* larger extents are decompressed without being cached */
+#define Z_EROFS_CACHE_MAX_SIZE		(1 << 20)
+
+/*
+ * Physically adjacent pclusters are read from the device together, up to
+ * this many bytes and extents at a time.
+ */
+#define Z_EROFS_BATCH_MAX_SIZE		(1 << 20)
+#define Z_EROFS_BATCH_MAX_EXTENTS	32
+
+/* the part of a compressed extent which is to be decompressed */
+struct z_erofs_extent {
+	erofs_off_t m_pa, m_la;
+	u64 m_plen, m_llen;
+	char m_algorithmformat;
+	unsigned int m_flags;
+
+	char *out;
+	erofs_off_t skip, length;
+	bool trimmed;
+};
+
+struct z_erofs_batch {
+	struct z_erofs_extent ext[Z_EROFS_BATCH_MAX_EXTENTS];
+	unsigned int nr;
+	/* device range covered by the queued extents */
+	erofs_off_t start, end;
+	char *raw;
+	unsigned int bufsize;
+};
+
+/* a decompressed extent, kept for reads which only need part of it */
+struct z_erofs_cache_entry {
+	erofs_off_t m_pa, m_la;
+	char *data;
+	unsigned int size;
+	ulong last_used;
+};
+
+static struct z_erofs_cache_entry z_erofs_cache[Z_EROFS_CACHE_ENTRIES];
+static ulong z_erofs_cache_count;
+
+void z_erofs_drop_cache(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(z_erofs_cache); i++) {
+		free(z_erofs_cache[i].data);
+		z_erofs_cache[i].data = NULL;
+	}
+}
+
+static void z_erofs_fill_extent(struct z_erofs_extent *e,
+				struct erofs_map_blocks *map, erofs_off_t pa,
+				char *buffer, erofs_off_t skip,
+				erofs_off_t length, bool trimmed)
+{
+	*e = (struct z_erofs_extent) {
+		.m_pa = pa,
+		.m_la = map->m_la,
+		.m_plen = map->m_plen,
+		.m_llen = map->m_llen,
+		.m_algorithmformat = map->m_algorithmformat,
+		.m_flags = map->m_flags,
+		.out = buffer,
+		.skip = skip,
+		.length = length,
+		.trimmed = trimmed,
+	};
+}
+
+static void z_erofs_init_req(struct z_erofs_decompress_req *rq,
+			     const struct z_erofs_extent *e, char *raw,
+			     char *out, erofs_off_t skip, erofs_off_t length,
+			     bool trimmed)
+{
+	*rq = (struct z_erofs_decompress_req) {
+		.in = raw,
+		.out = out,
+		.decodedskip = skip,
+		.interlaced_offset =
+			e->m_algorithmformat == Z_EROFS_COMPRESSION_INTERLACED ?
+				erofs_blkoff(e->m_la) : 0,
+		.inputsize = e->m_plen,
+		.decodedlength = length,
+		.alg = e->m_algorithmformat,
+		.partial_decoding = trimmed ? true :
+			!(e->m_flags & EROFS_MAP_FULL_MAPPED) ||
+				(e->m_flags & EROFS_MAP_PARTIAL_REF),
+	};
+}
+
+static char *z_erofs_cache_lookup(const struct z_erofs_extent *e)
+{
+	struct z_erofs_cache_entry *ce;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(z_erofs_cache); i++) {
+		ce = &z_erofs_cache[i];
+		if (ce->data && ce->m_pa == e->m_pa && ce->m_la == e->m_la &&
+		    ce->size >= e->length) {
+			ce->last_used = ++z_erofs_cache_count;
+			return ce->data;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Decompress all of the mapped part of an extent into the cache, replacing
+ * the least recently used entry. Returns the decompressed data, or NULL if
+ * the extent cannot be cached.
+ */
+static char *z_erofs_cache_extent(const struct z_erofs_extent *e, char *raw)
+{
+	struct z_erofs_cache_entry *ce, *lru = NULL;
+	struct z_erofs_decompress_req rq;
+	char *data;
+	int i;
+
+	if (e->m_llen > Z_EROFS_CACHE_MAX_SIZE)
+		return NULL;
+
+	data = malloc(e->m_llen);
+	if (!data)
+		return NULL;
+
+	z_erofs_init_req(&rq, e, raw, data, 0, e->m_llen, false);
+	if (z_erofs_decompress(&rq) < 0) {
+		free(data);
+		return NULL;
+	}
+
+	for (i = 0; i < ARRAY_SIZE(z_erofs_cache); i++) {
+		ce = &z_erofs_cache[i];
+		if (!lru || (lru->data &&
+			     (!ce->data || ce->last_used < lru->last_used)))
+			lru = ce;
+	}
+
+	free(lru->data);
+	lru->m_pa = e->m_pa;
+	lru->m_la = e->m_la;
+	lru->data = data;
+	lru->size = e->m_llen;
+	lru->last_used = ++z_erofs_cache_count;
+	return data;
+}
+
+static int z_erofs_decompress_extent(const struct z_erofs_extent *e,
+				     char *raw)
+{
+	struct z_erofs_decompress_req rq;
+	char *data;
+
+	/*
+	 * Only part of the extent is needed. Keep all of it, since the rest
+	 * is likely to be read next, e.g. by the following readdir() or for
+	 * the next file packed into the same fragment.
+	 */
+	if (e->skip || e->trimmed) {
+		data = z_erofs_cache_extent(e, raw);
+		if (data) {
+			memcpy(e->out, data + e->skip, e->length - e->skip);
+			return 0;
+		}
+	}
+
+	z_erofs_init_req(&rq, e, raw, e->out, e->skip, e->length, e->trimmed);
+	return z_erofs_decompress(&rq);
+}
+
+/* copy a partly needed extent from the cache, if it is there */
+static bool z_erofs_read_cached(const struct z_erofs_extent *e)
+{
+	char *data;
+
+	if (!e->skip && !e->trimmed)
+		return false;
+
+	data = z_erofs_cache_lookup(e);
+	if (!data)
+		return false;
+
+	memcpy(e->out, data + e->skip, e->length - e->skip);
+	return true;
+}
+
 int z_erofs_read_one_data(struct erofs_inode *inode,
 			  struct erofs_map_blocks *map, char *raw, char *buffer,
 			  erofs_off_t skip, erofs_off_t length, bool trimmed)
 {
 	struct erofs_map_dev mdev;
+	struct z_erofs_extent e;
 	int ret = 0;
 
 	if (map->m_flags & EROFS_MAP_FRAGMENT) {
@@ -248,29 +442,109 @@ int z_erofs_read_one_data(struct erofs_inode *inode,
 		return ret;
 	}
 
+	z_erofs_fill_extent(&e, map, mdev.m_pa, buffer, skip, length, trimmed);
+	if (z_erofs_read_cached(&e))
+		return 0;
+
 	ret = erofs_dev_read(mdev.m_deviceid, raw, mdev.m_pa, map->m_plen);
 	if (ret < 0)
 		return ret;
 
-	ret = z_erofs_decompress(&(struct z_erofs_decompress_req) {
-			.in = raw,
-			.out = buffer,
-			.decodedskip = skip,
-			.interlaced_offset =
-				map->m_algorithmformat == Z_EROFS_COMPRESSION_INTERLACED ?
-					erofs_blkoff(map->m_la) : 0,
-			.inputsize = map->m_plen,
-			.decodedlength = length,
-			.alg = map->m_algorithmformat,
-			.partial_decoding = trimmed ? true :
-				!(map->m_flags & EROFS_MAP_FULL_MAPPED) ||
-					(map->m_flags & EROFS_MAP_PARTIAL_REF),
-			 });
+	ret = z_erofs_decompress_extent(&e, raw);
 	if (ret < 0)
 		return ret;
 	return 0;
 }
 
+/* read all queued pclusters with one device read, then decompress them */
+static int z_erofs_flush_batch(struct z_erofs_batch *b)
+{
+	erofs_off_t len = b->end - b->start;
+	unsigned int i;
+	char *raw;
+	int ret;
+
+	if (!b->nr)
+		return 0;
+
+	if (len > b->bufsize) {
+		raw = realloc(b->raw, len);
+		if (!raw)
+			return -ENOMEM;
+		b->raw = raw;
+		b->bufsize = len;
+	}
+
+	ret = erofs_dev_read(0, b->raw, b->start, len);
+	if (ret < 0)
+		return ret;
+
+	for (i = 0; i < b->nr; i++) {
+		ret = z_erofs_decompress_extent(&b->ext[i], b->raw +
+						b->ext[i].m_pa - b->start);
+		if (ret < 0)
+			return ret;
+	}
+	b->nr = 0;
+	return 0;
+}
+
+static int z_erofs_queue_extent(struct erofs_inode *inode,
+				struct z_erofs_batch *b,
+				struct erofs_map_blocks *map, char *buffer,
+				erofs_off_t skip, erofs_off_t length,
+				bool trimmed)
+{
+	struct erofs_map_dev mdev;
+	struct z_erofs_extent *e;
+	int ret;
+
+	if (map->m_flags & EROFS_MAP_FRAGMENT)
+		return z_erofs_read_one_data(inode, map, NULL, buffer, skip,
+					     length, trimmed);
+
+	mdev = (struct erofs_map_dev) {
+		.m_pa = map->m_pa,
+	};
+	ret = erofs_map_dev(&mdev);
+	if (ret) {
+		DBG_BUGON(1);
+		return ret;
+	}
+
+	/* uncompressed data is read straight into the output buffer */
+	if (map->m_algorithmformat == Z_EROFS_COMPRESSION_SHIFTED) {
+		if (length > map->m_plen)
+			return -EFSCORRUPTED;
+		DBG_BUGON(length < skip);
+		return erofs_dev_read(mdev.m_deviceid, buffer,
+				      mdev.m_pa + skip, length - skip);
+	}
+
+	/*
+	 * Extents are mapped from the end of the file backwards, so the next
+	 * pcluster to join a batch lies just before the current one.
+	 */
+	if (b->nr && (b->nr == Z_EROFS_BATCH_MAX_EXTENTS ||
+		      mdev.m_pa + map->m_plen != b->start ||
+		      b->end - mdev.m_pa > Z_EROFS_BATCH_MAX_SIZE)) {
+		ret = z_erofs_flush_batch(b);
+		if (ret < 0)
+			return ret;
+	}
+
+	e = &b->ext[b->nr];
+	z_erofs_fill_extent(e, map, mdev.m_pa, buffer, skip, length, trimmed);
+	if (z_erofs_read_cached(e))
+		return 0;
+
+	if (!b->nr)
+		b->end = mdev.m_pa + map->m_plen;
+	b->start = mdev.m_pa;
+	b->nr++;
+	return 0;
+}
+
 static int z_erofs_read_data(struct erofs_inode *inode, char *buffer,
 			     erofs_off_t size, erofs_off_t offset)
 {
@@ -278,9 +552,10 @@ static int z_erofs_read_data(struct erofs_inode *inode, char *buffer,
 	struct erofs_map_blocks map = {
 		.index = UINT_MAX,
 	};
+	struct z_erofs_batch batch = {
+		.nr = 0,
+	};
 	bool trimmed;
-	unsigned int bufsize = 0;
-	char *raw = NULL;
 	int ret = 0;
 
 	end = offset + size;
@@ -318,23 +593,15 @@ static int z_erofs_read_data(struct erofs_inode *inode, char *buffer,
 			continue;
 		}
 
-		if (map.m_plen > bufsize) {
-			bufsize = map.m_plen;
-			raw = realloc(raw, bufsize);
-			if (!raw) {
-				ret = -ENOMEM;
-				break;
-			}
-		}
-
-		ret = z_erofs_read_one_data(inode, &map, raw,
-					    buffer + end - offset, skip, length,
-					    trimmed);
+		ret = z_erofs_queue_extent(inode, &batch, &map,
+					   buffer + end - offset, skip, length,
+					   trimmed);
 		if (ret < 0)
 			break;
 	}
-	if (raw)
-		free(raw);
+	if (ret >= 0)
+		ret = z_erofs_flush_batch(&batch);
+	free(batch.raw);
 	return ret < 0 ? ret : 0;
 }
 
@@ -34,6 +34,7 @@ int erofs_probe(struct blk_desc *fs_dev_desc,
 {
 	int ret;
 
+	z_erofs_drop_cache();
 	ctxt.cur_dev = fs_dev_desc;
 	ctxt.cur_part_info = *fs_partition;
 
@@ -252,6 +253,7 @@ int erofs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 
 void erofs_close(void)
 {
+	z_erofs_drop_cache();
 	ctxt.cur_dev = NULL;
 }
 
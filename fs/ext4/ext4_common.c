@@ -303,6 +303,15 @@ static int _get_new_blk_no(unsigned char *buffer)
 	return -1;
 }
 
+/* Note that a group's bitmap must be written back by ext4fs_update() */
+static void ext4fs_bmap_dirty(int index, u8 type)
+{
+	struct ext_filesystem *fs = get_fs();
+
+	if (fs->bmap_dirty)
+		fs->bmap_dirty[index] |= type;
+}
+
 int ext4fs_set_block_bmap(long int blockno, unsigned char *buffer, int index)
 {
 	int i, remainder, status;
@@ -321,6 +330,7 @@ int ext4fs_set_block_bmap(long int blockno, unsigned char *buffer, int index)
 			return -1;
 
 		*ptr = *ptr | operand;
+		ext4fs_bmap_dirty(index, EXT4_BMAP_DIRTY_BLOCK);
 		return 0;
 	} else {
 		if (remainder == 0) {
@@ -335,6 +345,7 @@ int ext4fs_set_block_bmap(long int blockno, unsigned char *buffer, int index)
 			return -1;
 
 		*ptr = *ptr | operand;
+		ext4fs_bmap_dirty(index, EXT4_BMAP_DIRTY_BLOCK);
 		return 0;
 	}
 }
@@ -367,6 +378,7 @@ void ext4fs_reset_block_bmap(long int blockno, unsigned char *buffer, int index)
 		if (status)
 			*ptr = *ptr & ~(operand);
 	}
+	ext4fs_bmap_dirty(index, EXT4_BMAP_DIRTY_BLOCK);
 }
 
 int ext4fs_set_inode_bmap(int inode_no, unsigned char *buffer, int index)
@@ -390,6 +402,7 @@ int ext4fs_set_inode_bmap(int inode_no, unsigned char *buffer, int index)
 		return -1;
 
 	*ptr = *ptr | operand;
+	ext4fs_bmap_dirty(index, EXT4_BMAP_DIRTY_INODE);
 
 	return 0;
 }
@@ -413,6 +426,7 @@ void ext4fs_reset_inode_bmap(int inode_no, unsigned char *buffer, int index)
 	status = *ptr & operand;
 	if (status)
 		*ptr = *ptr & ~(operand);
+	ext4fs_bmap_dirty(index, EXT4_BMAP_DIRTY_INODE);
 }
 
 uint16_t ext4fs_checksum_update(uint32_t i)
@@ -966,10 +980,8 @@ uint32_t ext4fs_get_new_blk_no(void)
 	static int prev_bg_bitmap_index = -1;
 	unsigned int blk_per_grp = le32_to_cpu(ext4fs_root->sblock.blocks_per_group);
 	struct ext_filesystem *fs = get_fs();
-	char *journal_buffer = zalloc(fs->blksz);
-	char *zero_buffer = zalloc(fs->blksz);
-	if (!journal_buffer || !zero_buffer)
-		goto fail;
+	/* this runs for every block, so only allocate when journalling */
+	char *journal_buffer = NULL;
 
 	if (fs->first_pass_bbmap == 0) {
 		for (i = 0; i < fs->no_blkgrp; i++) {
@@ -980,7 +992,7 @@ uint32_t ext4fs_get_new_blk_no(void)
 				uint64_t b_bitmap_blk =
 					ext4fs_bg_get_block_id(bgd, fs);
 				if (bg_flags & EXT4_BG_BLOCK_UNINIT) {
-					memcpy(fs->blk_bmaps[i], zero_buffer,
+					memset(fs->blk_bmaps[i], '\0',
 					       fs->blksz);
 					put_ext4(b_bitmap_blk * fs->blksz,
 						 fs->blk_bmaps[i], fs->blksz);
@@ -992,11 +1004,15 @@ uint32_t ext4fs_get_new_blk_no(void)
 				if (fs->curr_blkno == -1)
 					/* block bitmap is completely filled */
 					continue;
+				ext4fs_bmap_dirty(i, EXT4_BMAP_DIRTY_BLOCK);
 				fs->curr_blkno = fs->curr_blkno +
 						(i * fs->blksz * 8);
 				fs->first_pass_bbmap++;
 				ext4fs_bg_free_blocks_dec(bgd, fs);
 				ext4fs_sb_free_blocks_dec(fs->sb);
+				journal_buffer = zalloc(fs->blksz);
+				if (!journal_buffer)
+					goto fail;
 				status = ext4fs_devread(b_bitmap_blk *
 							fs->sect_perblk,
 							0, fs->blksz,
@@ -1044,9 +1060,9 @@ restart:
 		uint16_t bg_flags = ext4fs_bg_get_flags(bgd);
 		uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
 		if (bg_flags & EXT4_BG_BLOCK_UNINIT) {
-			memcpy(fs->blk_bmaps[bg_idx], zero_buffer, fs->blksz);
+			memset(fs->blk_bmaps[bg_idx], '\0', fs->blksz);
 			put_ext4(b_bitmap_blk * fs->blksz,
-				 zero_buffer, fs->blksz);
+				 fs->blk_bmaps[bg_idx], fs->blksz);
 			bg_flags &= ~EXT4_BG_BLOCK_UNINIT;
 			ext4fs_bg_set_flags(bgd, bg_flags);
 		}
@@ -1061,6 +1077,9 @@ restart:
 
 		/* journal backup */
 		if (prev_bg_bitmap_index != bg_idx) {
+			journal_buffer = zalloc(fs->blksz);
+			if (!journal_buffer)
+				goto fail;
 			status = ext4fs_devread(b_bitmap_blk * fs->sect_perblk,
 						0, fs->blksz, journal_buffer);
 			if (status == 0)
@@ -1076,12 +1095,10 @@ restart:
 	}
 success:
 	free(journal_buffer);
-	free(zero_buffer);
 
 	return fs->curr_blkno;
 fail:
 	free(journal_buffer);
-	free(zero_buffer);
 
 	return -1;
 }
@@ -1126,6 +1143,7 @@ int ext4fs_get_new_inode_no(void)
 				if (fs->curr_inode_no == -1)
 					/* inode bitmap is completely filled */
 					continue;
+				ext4fs_bmap_dirty(i, EXT4_BMAP_DIRTY_INODE);
 				fs->curr_inode_no = fs->curr_inode_no +
 							(i * inodes_per_grp);
 				fs->first_pass_ibmap++;
@@ -1640,6 +1658,89 @@ int ext4fs_read_inode(struct ext2_data *data, int ino, struct ext2_inode *inode)
 	return 1;
 }
 
+/**
+ * ext4fs_read_extent() - map file blocks of an extent-based inode
+ *
+ * @inode: Inode to look up
+ * @fileblock: First file block to map
+ * @max: Maximum number of blocks to map
+ * @countp: Returns the number of blocks from @fileblock which are either
+ *	contiguous on the disk or all in a hole, at most @max
+ * @cache: Cache for the extent tree, or NULL
+ * Return: filesystem block holding @fileblock, 0 if it is in a hole, or
+ *	-ve on error
+ */
+static long int ext4fs_read_extent(struct ext2_inode *inode, int fileblock,
+				   int max, int *countp,
+				   struct ext_block_cache *cache)
+{
+	long int startblock, endblock;
+	struct ext_block_cache *c, cd;
+	struct ext4_extent_header *ext_block;
+	struct ext4_extent *extent;
+	unsigned long long start;
+	long int blknr = 0;
+	int log2_blksz;
+	int i;
+
+	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
+		- get_fs()->dev_desc->log2blksz;
+	*countp = 1;
+
+	if (cache) {
+		c = cache;
+	} else {
+		c = &cd;
+		ext_cache_init(c);
+	}
+	ext_block =
+		ext4fs_get_extent_block(ext4fs_root, c,
+					(struct ext4_extent_header *)
+					inode->b.blocks.dir_blocks,
+					fileblock, log2_blksz);
+	if (!ext_block) {
+		printf("invalid extent block\n");
+		if (!cache)
+			ext_cache_fini(c);
+		return -EINVAL;
+	}
+
+	extent = (struct ext4_extent *)(ext_block + 1);
+
+	for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
+		startblock = le32_to_cpu(extent[i].ee_block);
+		endblock = startblock + le16_to_cpu(extent[i].ee_len);
+
+		if (startblock > fileblock) {
+			/* Sparse file */
+			*countp = min_t(long int, startblock - fileblock, max);
+			break;
+
+		} else if (fileblock < endblock) {
+			start = le16_to_cpu(extent[i].ee_start_hi);
+			start = (start << 32) +
+				le32_to_cpu(extent[i].ee_start_lo);
+			*countp = min_t(long int, endblock - fileblock, max);
+			blknr = (fileblock - startblock) + start;
+			break;
+		}
+	}
+
+	if (!cache)
+		ext_cache_fini(c);
+	return blknr;
+}
+
+long int read_allocated_run(struct ext2_inode *inode, int fileblock, int max,
+			    int *countp, struct ext_block_cache *cache)
+{
+	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL)
+		return ext4fs_read_extent(inode, fileblock, max, countp, cache);
+
+	*countp = 1;
+	return read_allocated_block(inode, fileblock, cache);
+}
+
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache)
 {
@@ -1650,62 +1751,15 @@ long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 	long int rblock;
 	long int perblock_parent;
 	long int perblock_child;
-	unsigned long long start;
 	/* get the blocksize of the filesystem */
 	blksz = EXT2_BLOCK_SIZE(ext4fs_root);
 	log2_blksz = LOG2_BLOCK_SIZE(ext4fs_root)
 		- get_fs()->dev_desc->log2blksz;
 
 	if (le32_to_cpu(inode->flags) & EXT4_EXTENTS_FL) {
-		long int startblock, endblock;
-		struct ext_block_cache *c, cd;
-		struct ext4_extent_header *ext_block;
-		struct ext4_extent *extent;
-		int i;
-
-		if (cache) {
-			c = cache;
-		} else {
-			c = &cd;
-			ext_cache_init(c);
-		}
-		ext_block =
-			ext4fs_get_extent_block(ext4fs_root, c,
-						(struct ext4_extent_header *)
-						inode->b.blocks.dir_blocks,
-						fileblock, log2_blksz);
-		if (!ext_block) {
-			printf("invalid extent block\n");
-			if (!cache)
-				ext_cache_fini(c);
-			return -EINVAL;
-		}
-
-		extent = (struct ext4_extent *)(ext_block + 1);
-
-		for (i = 0; i < le16_to_cpu(ext_block->eh_entries); i++) {
-			startblock = le32_to_cpu(extent[i].ee_block);
-			endblock = startblock + le16_to_cpu(extent[i].ee_len);
-
-			if (startblock > fileblock) {
-				/* Sparse file */
-				if (!cache)
-					ext_cache_fini(c);
-				return 0;
-
-			} else if (fileblock < endblock) {
-				start = le16_to_cpu(extent[i].ee_start_hi);
-				start = (start << 32) +
-					le32_to_cpu(extent[i].ee_start_lo);
-				if (!cache)
-					ext_cache_fini(c);
-				return (fileblock - startblock) + start;
-			}
-		}
+		int count;
 
-		if (!cache)
-			ext_cache_fini(c);
-		return 0;
+		return ext4fs_read_extent(inode, fileblock, 1, &count, cache);
 	}
 
 	/* Direct blocks. */
@@ -2040,6 +2094,207 @@ void ext4fs_close(void)
 	ext4fs_reinit_global();
 }
 
+/*
+ * Set up a node for the entry @dirent in directory @diro, reading its inode
+ * if the entry does not record the file type. Returns the node, or NULL on
+ * error.
+ */
+static struct ext2fs_node *ext4fs_dirent_node(struct ext2fs_node *diro,
+					      const struct ext2_dirent *dirent,
+					      int *typep)
+{
+	struct ext2fs_node *fdiro;
+	int type = FILETYPE_UNKNOWN;
+	int status;
+
+	fdiro = zalloc(sizeof(struct ext2fs_node));
+	if (!fdiro)
+		return NULL;
+
+	fdiro->data = diro->data;
+	fdiro->ino = le32_to_cpu(dirent->inode);
+
+	if (dirent->filetype != FILETYPE_UNKNOWN) {
+		fdiro->inode_read = 0;
+
+		if (dirent->filetype == FILETYPE_DIRECTORY)
+			type = FILETYPE_DIRECTORY;
+		else if (dirent->filetype == FILETYPE_SYMLINK)
+			type = FILETYPE_SYMLINK;
+		else if (dirent->filetype == FILETYPE_REG)
+			type = FILETYPE_REG;
+	} else {
+		status = ext4fs_read_inode(diro->data,
+					   le32_to_cpu(dirent->inode),
+					   &fdiro->inode);
+		if (status == 0) {
+			free(fdiro);
+			return NULL;
+		}
+		fdiro->inode_read = 1;
+
+		if ((le16_to_cpu(fdiro->inode.mode) &
+		     FILETYPE_INO_MASK) == FILETYPE_INO_DIRECTORY) {
+			type = FILETYPE_DIRECTORY;
+		} else if ((le16_to_cpu(fdiro->inode.mode)
+			    & FILETYPE_INO_MASK) == FILETYPE_INO_SYMLINK) {
+			type = FILETYPE_SYMLINK;
+		} else if ((le16_to_cpu(fdiro->inode.mode)
+			    & FILETYPE_INO_MASK) == FILETYPE_INO_REG) {
+			type = FILETYPE_REG;
+		}
+	}
+	*typep = type;
+
+	return fdiro;
+}
+
+/* Read block @blk of directory @diro into @buf */
+static int ext4fs_dx_read(struct ext2fs_node *diro, u32 blk, char *buf,
+			  int blksz)
+{
+	loff_t actread;
+
+	if (ext4fs_read_file(diro, (loff_t)blk * blksz, blksz, buf,
+			     &actread) < 0 || actread != blksz)
+		return -EIO;
+
+	return 0;
+}
+
+/**
+ * ext4fs_dx_lookup() - Look up a name using a directory's hash tree
+ *
+ * The index blocks are followed down to the one leaf block which can hold
+ * @name, so only that block is searched, plus any following leaves which
+ * continue a run of names with the same hash.
+ *
+ * @diro: Directory to search, which has EXT4_INDEX_FL set
+ * @name: Name to find
+ * @fnode: Returns the node for the file
+ * @ftype: Returns the file type (FILETYPE_...)
+ * Return: 1 if found, 0 if not found, -ENOTSUPP if the index cannot be
+ *	used so that the directory must be scanned, other -ve on error
+ */
+static int ext4fs_dx_lookup(struct ext2fs_node *diro, const char *name,
+			    struct ext2fs_node **fnode, int *ftype)
+{
+	struct ext2_sblock *sb = &diro->data->sblock;
+	int blksz = EXT2_BLOCK_SIZE(diro->data);
+	int len = strlen(name);
+	struct dx_root_info *info;
+	struct dx_entry *entries;
+	uint count, levels, lo, hi, at, level;
+	u32 seed[4], hash, blk;
+	char *idx, *leaf;
+	int i, version, ret;
+
+	if (!(le32_to_cpu(sb->feature_compatibility) &
+	      EXT4_FEATURE_COMPAT_DIR_INDEX) ||
+	    (le32_to_cpu(diro->inode.flags) &
+	     (EXT4_ENCRYPT_FL | EXT4_CASEFOLD_FL)))
+		return -ENOTSUPP;
+
+	idx = malloc(blksz * 2);
+	if (!idx)
+		return -ENOMEM;
+	leaf = idx + blksz;
+
+	ret = -ENOTSUPP;
+	if (ext4fs_dx_read(diro, 0, idx, blksz))
+		goto out;
+
+	/* The root follows the 12-byte "." and ".." entries */
+	info = (struct dx_root_info *)(idx + 24);
+	levels = info->indirect_levels;
+	if (info->reserved_zero || info->info_length < sizeof(*info) ||
+	    levels >= DX_MAX_LEVELS || info->hash_version > DX_HASH_TEA)
+		goto out;
+
+	version = info->hash_version;
+	if (le32_to_cpu(sb->flags) & EXT2_FLAGS_UNSIGNED_HASH)
+		version += DX_HASH_LEGACY_UNSIGNED;
+	for (i = 0; i < 4; i++)
+		seed[i] = le32_to_cpu(sb->hash_seed[i]);
+	if (ext4fs_dirhash(name, len, version, seed, &hash))
+		goto out;
+
+	entries = (struct dx_entry *)((char *)info + info->info_length);
+	for (level = 0;; level++) {
+		count = le16_to_cpu(((struct dx_countlimit *)entries)->count);
+		if (!count || (char *)(entries + count) > idx + blksz)
+			goto out;
+
+		/* Find the last entry whose hash is not above ours */
+		lo = 1;
+		hi = count;
+		while (lo < hi) {
+			uint mid = (lo + hi) / 2;
+
+			if (le32_to_cpu(entries[mid].hash) > hash)
+				hi = mid;
+			else
+				lo = mid + 1;
+		}
+		at = lo - 1;
+		blk = le32_to_cpu(entries[at].block) & 0x0fffffff;
+		if (level == levels)
+			break;
+
+		/* Index blocks start with an empty 8-byte entry */
+		if (ext4fs_dx_read(diro, blk, idx, blksz))
+			goto out;
+		entries = (struct dx_entry *)(idx + 8);
+	}
+
+	for (;;) {
+		int pos;
+
+		if (ext4fs_dx_read(diro, blk, leaf, blksz))
+			goto out;
+
+		for (pos = 0; pos + sizeof(struct ext2_dirent) <= blksz;) {
+			struct ext2_dirent *dirent;
+			int direntlen;
+
+			dirent = (struct ext2_dirent *)(leaf + pos);
+			direntlen = le16_to_cpu(dirent->direntlen);
+			if (direntlen < sizeof(*dirent) ||
+			    pos + direntlen > blksz)
+				goto out;
+			if (dirent->inode && dirent->namelen == len &&
+			    !memcmp(leaf + pos + sizeof(*dirent), name, len)) {
+				*fnode = ext4fs_dirent_node(diro, dirent,
+							    ftype);
+				ret = *fnode ? 1 : -ENOMEM;
+				goto out;
+			}
+			pos += direntlen;
+		}
+
+		/*
+		 * The next leaf continues this one if its hash has the
+		 * collision bit set. That leaf may be under the next index
+		 * block, so leave that rare case to a full scan.
+		 */
+		if (at + 1 < count) {
+			if ((le32_to_cpu(entries[at + 1].hash) & ~1) != hash)
+				break;
+			at++;
+			blk = le32_to_cpu(entries[at].block) & 0x0fffffff;
+		} else if (levels) {
+			goto out;
+		} else {
+			break;
+		}
+	}
+	ret = 0;
+out:
+	free(idx);
+
+	return ret;
+}
+
 int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 				struct ext2fs_node **fnode, int *ftype)
 {
@@ -2057,6 +2312,13 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 		if (status == 0)
 			return 0;
 	}
+	/* Use the hash tree to find a name, if there is one */
+	if (name && fnode && ftype &&
+	    (le32_to_cpu(diro->inode.flags) & EXT4_INDEX_FL)) {
+		status = ext4fs_dx_lookup(diro, name, fnode, ftype);
+		if (status != -ENOTSUPP)
+			return status > 0;
+	}
 	/* Search the file.  */
 	while (fpos < le32_to_cpu(diro->inode.size)) {
 		struct ext2_dirent dirent;
@@ -2075,7 +2337,7 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 		if (dirent.namelen != 0) {
 			char filename[dirent.namelen + 1];
 			struct ext2fs_node *fdiro;
-			int type = FILETYPE_UNKNOWN;
+			int type;
 
 			status = ext4fs_read_file(diro,
 						  fpos +
@@ -2085,49 +2347,12 @@ int ext4fs_iterate_dir(struct ext2fs_node *dir, char *name,
 			if (status < 0)
 				return 0;
 
-			fdiro = zalloc(sizeof(struct ext2fs_node));
+			fdiro = ext4fs_dirent_node(diro, &dirent, &type);
 			if (!fdiro)
 				return 0;
 
-			fdiro->data = diro->data;
-			fdiro->ino = le32_to_cpu(dirent.inode);
-
 			filename[dirent.namelen] = '\0';
 
-			if (dirent.filetype != FILETYPE_UNKNOWN) {
-				fdiro->inode_read = 0;
-
-				if (dirent.filetype == FILETYPE_DIRECTORY)
-					type = FILETYPE_DIRECTORY;
-				else if (dirent.filetype == FILETYPE_SYMLINK)
-					type = FILETYPE_SYMLINK;
-				else if (dirent.filetype == FILETYPE_REG)
-					type = FILETYPE_REG;
-			} else {
-				status = ext4fs_read_inode(diro->data,
-							   le32_to_cpu
-							   (dirent.inode),
-							   &fdiro->inode);
-				if (status == 0) {
-					free(fdiro);
-					return 0;
-				}
-				fdiro->inode_read = 1;
-
-				if ((le16_to_cpu(fdiro->inode.mode) &
-				     FILETYPE_INO_MASK) ==
-				    FILETYPE_INO_DIRECTORY) {
-					type = FILETYPE_DIRECTORY;
-				} else if ((le16_to_cpu(fdiro->inode.mode)
-					    & FILETYPE_INO_MASK) ==
-					   FILETYPE_INO_SYMLINK) {
-					type = FILETYPE_SYMLINK;
-				} else if ((le16_to_cpu(fdiro->inode.mode)
-					    & FILETYPE_INO_MASK) ==
-					   FILETYPE_INO_REG) {
-					type = FILETYPE_REG;
-				}
-			}
 #ifdef DEBUG
 			printf("iterate >%s<\n", filename);
 #endif /* of DEBUG */
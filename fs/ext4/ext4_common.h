@@ -47,6 +47,53 @@ static inline void *zalloc(size_t size)
 	return kzalloc(size, 0);
 }
 
+/* Hash-tree (dir_index) directories */
+#define DX_HASH_LEGACY			0
+#define DX_HASH_HALF_MD4		1
+#define DX_HASH_TEA			2
+#define DX_HASH_LEGACY_UNSIGNED		3
+#define DX_HASH_HALF_MD4_UNSIGNED	4
+#define DX_HASH_TEA_UNSIGNED		5
+#define DX_HTREE_EOF			0x7fffffff
+#define DX_MAX_LEVELS			3
+
+/* Superblock flags saying how the hashes treat the sign of characters */
+#define EXT2_FLAGS_SIGNED_HASH		0x0001
+#define EXT2_FLAGS_UNSIGNED_HASH	0x0002
+
+/* Follows the "." and ".." entries in the first block of the directory */
+struct dx_root_info {
+	__le32 reserved_zero;
+	__u8 hash_version;
+	__u8 info_length;
+	__u8 indirect_levels;
+	__u8 unused_flags;
+};
+
+/* The first entry of each index block holds the limit and count instead */
+struct dx_entry {
+	__le32 hash;
+	__le32 block;
+};
+
+struct dx_countlimit {
+	__le16 limit;
+	__le16 count;
+};
+
+/**
+ * ext4fs_dirhash() - Hash a file name as for a hash-tree directory
+ *
+ * @name: File name
+ * @len: Length of @name
+ * @version: Hash version (DX_HASH_...), including the unsigned variants
+ * @seed: Hash seed from the superblock, in CPU order, or all zero for none
+ * @hashp: Returns the major hash, with the bottom bit clear
+ * Return: 0 if OK, -EINVAL if @version is not supported
+ */
+int ext4fs_dirhash(const char *name, int len, int version, const u32 *seed,
+		   u32 *hashp);
+
 int ext4fs_read_inode(struct ext2_data *data, int ino,
 		      struct ext2_inode *inode);
 int ext4fs_read_file(struct ext2fs_node *node, loff_t pos, loff_t len,
@@ -65,6 +65,93 @@ static inline void ext4fs_bg_free_blocks_inc
 		bg->free_blocks_high = cpu_to_le16(free_blocks >> 16);
 }
 
+/* Get the block holding the block or inode bitmap of a group */
+static uint64_t ext4fs_bmap_blk(struct ext_filesystem *fs, int group,
+				bool inode)
+{
+	struct ext2_block_group *bgd = ext4fs_get_group_descriptor(fs, group);
+
+	return inode ? ext4fs_bg_get_inode_id(bgd, fs) :
+		ext4fs_bg_get_block_id(bgd, fs);
+}
+
+/*
+ * Count the groups from @start whose bitmaps follow each other on disk, as
+ * they do with flex_bg. If @type is not 0, only groups with that dirty flag
+ * are counted.
+ */
+static int ext4fs_bmap_run(struct ext_filesystem *fs, int start, bool inode,
+			   u8 type)
+{
+	uint64_t blk = ext4fs_bmap_blk(fs, start, inode);
+	int i;
+
+	for (i = start + 1; i < fs->no_blkgrp; i++) {
+		if (type && !(fs->bmap_dirty[i] & type))
+			break;
+		if (ext4fs_bmap_blk(fs, i, inode) != blk + i - start)
+			break;
+	}
+
+	return i - start;
+}
+
+/*
+ * Write back the bitmaps which have changed, each run of adjacent bitmaps
+ * in one go
+ */
+static void ext4fs_write_bmaps(struct ext_filesystem *fs,
+			       unsigned char **bmaps, bool inode)
+{
+	u8 type = inode ? EXT4_BMAP_DIRTY_INODE : EXT4_BMAP_DIRTY_BLOCK;
+	int i, count;
+
+	for (i = 0; i < fs->no_blkgrp; i += count) {
+		count = 1;
+		if (!(fs->bmap_dirty[i] & type))
+			continue;
+		count = ext4fs_bmap_run(fs, i, inode, type);
+		put_ext4(ext4fs_bmap_blk(fs, i, inode) * fs->blksz, bmaps[i],
+			 count * fs->blksz);
+	}
+}
+
+/*
+ * Allocate the bitmaps of all groups in one buffer and read them, each run of
+ * adjacent bitmaps in one go
+ */
+static unsigned char **ext4fs_read_bmaps(struct ext_filesystem *fs,
+					 bool inode)
+{
+	unsigned char **bmaps;
+	unsigned char *buf;
+	int i, count;
+
+	bmaps = zalloc(fs->no_blkgrp * sizeof(char *));
+	if (!bmaps)
+		return NULL;
+	buf = zalloc(fs->no_blkgrp * fs->blksz);
+	if (!buf) {
+		free(bmaps);
+		return NULL;
+	}
+	for (i = 0; i < fs->no_blkgrp; i++)
+		bmaps[i] = buf + i * fs->blksz;
+
+	for (i = 0; i < fs->no_blkgrp; i += count) {
+		count = ext4fs_bmap_run(fs, i, inode, 0);
+		if (!ext4fs_devread(ext4fs_bmap_blk(fs, i, inode) *
+				    fs->sect_perblk, 0, count * fs->blksz,
+				    (char *)bmaps[i])) {
+			free(buf);
+			free(bmaps);
+			return NULL;
+		}
+	}
+
+	return bmaps;
+}
+
 static void ext4fs_update(void)
 {
 	short i;
@@ -76,22 +163,15 @@ static void ext4fs_update(void)
 	put_ext4((uint64_t)(SUPERBLOCK_SIZE),
 		 (struct ext2_sblock *)fs->sb, (uint32_t)SUPERBLOCK_SIZE);
 
-	/* update block bitmaps */
 	for (i = 0; i < fs->no_blkgrp; i++) {
 		bgd = ext4fs_get_group_descriptor(fs, i);
 		bgd->bg_checksum = cpu_to_le16(ext4fs_checksum_update(i));
-		uint64_t b_bitmap_blk = ext4fs_bg_get_block_id(bgd, fs);
-		put_ext4(b_bitmap_blk * fs->blksz,
-			 fs->blk_bmaps[i], fs->blksz);
 	}
 
-	/* update inode bitmaps */
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		bgd = ext4fs_get_group_descriptor(fs, i);
-		uint64_t i_bitmap_blk = ext4fs_bg_get_inode_id(bgd, fs);
-		put_ext4(i_bitmap_blk * fs->blksz,
-			 fs->inode_bmaps[i], fs->blksz);
-	}
+	/* update the block and inode bitmaps which changed */
+	ext4fs_write_bmaps(fs, fs->blk_bmaps, false);
+	ext4fs_write_bmaps(fs, fs->inode_bmaps, true);
+	memset(fs->bmap_dirty, '\0', fs->no_blkgrp);
 
 	/* update the block group descriptor table */
 	put_ext4((uint64_t)((uint64_t)fs->gdtable_blkno * (uint64_t)fs->blksz),
@@ -595,7 +675,6 @@ fail:
 
 int ext4fs_init(void)
 {
-	short status;
 	int i;
 	uint32_t real_free_blocks = 0;
 	struct ext_filesystem *fs = get_fs();
@@ -628,46 +707,16 @@ int ext4fs_init(void)
 		goto fail;
 	}
 
-	/* load all the available bitmap block of the partition */
-	fs->blk_bmaps = zalloc(fs->no_blkgrp * sizeof(char *));
+	/* load all the block and inode bitmaps of the partition */
+	fs->blk_bmaps = ext4fs_read_bmaps(fs, false);
 	if (!fs->blk_bmaps)
 		goto fail;
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		fs->blk_bmaps[i] = zalloc(fs->blksz);
-		if (!fs->blk_bmaps[i])
-			goto fail;
-	}
-
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		struct ext2_block_group *bgd =
-			ext4fs_get_group_descriptor(fs, i);
-		status = ext4fs_devread(ext4fs_bg_get_block_id(bgd, fs) *
-				   fs->sect_perblk, 0,
-				   fs->blksz, (char *)fs->blk_bmaps[i]);
-		if (status == 0)
-			goto fail;
-	}
-
-	/* load all the available inode bitmap of the partition */
-	fs->inode_bmaps = zalloc(fs->no_blkgrp * sizeof(unsigned char *));
+	fs->inode_bmaps = ext4fs_read_bmaps(fs, true);
 	if (!fs->inode_bmaps)
 		goto fail;
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		fs->inode_bmaps[i] = zalloc(fs->blksz);
-		if (!fs->inode_bmaps[i])
-			goto fail;
-	}
-
-	for (i = 0; i < fs->no_blkgrp; i++) {
-		struct ext2_block_group *bgd =
-			ext4fs_get_group_descriptor(fs, i);
-		status = ext4fs_devread(ext4fs_bg_get_inode_id(bgd, fs) *
-					fs->sect_perblk,
-					0, fs->blksz,
-					(char *)fs->inode_bmaps[i]);
-		if (status == 0)
-			goto fail;
-	}
+	fs->bmap_dirty = zalloc(fs->no_blkgrp);
+	if (!fs->bmap_dirty)
+		goto fail;
 
 	/*
 	 * check filesystem consistency with free blocks of file system
@@ -693,7 +742,6 @@ fail:
 
 void ext4fs_deinit(void)
 {
-	int i;
 	struct ext2_inode inode_journal;
 	struct journal_superblock_t *jsb;
 	uint32_t blknr;
@@ -727,23 +775,20 @@ void ext4fs_deinit(void)
 	free(fs->sb);
 	fs->sb = NULL;
 
+	/* all the bitmaps of each kind share one buffer */
 	if (fs->blk_bmaps) {
-		for (i = 0; i < fs->no_blkgrp; i++) {
-			free(fs->blk_bmaps[i]);
-			fs->blk_bmaps[i] = NULL;
-		}
+		free(fs->blk_bmaps[0]);
 		free(fs->blk_bmaps);
 		fs->blk_bmaps = NULL;
 	}
 
 	if (fs->inode_bmaps) {
-		for (i = 0; i < fs->no_blkgrp; i++) {
-			free(fs->inode_bmaps[i]);
-			fs->inode_bmaps[i] = NULL;
-		}
+		free(fs->inode_bmaps[0]);
 		free(fs->inode_bmaps);
 		fs->inode_bmaps = NULL;
 	}
+	free(fs->bmap_dirty);
+	fs->bmap_dirty = NULL;
 
 	free(fs->gdtable);
 	fs->gdtable = NULL;
@@ -29,6 +29,9 @@
 #include <part.h>
 #include <u-boot/uuid.h>
 
+/* Largest read passed to ext4fs_devread() in one go, since it takes an int */
+#define EXT4_MAX_DEVREAD	(1U << 30)
+
 int ext4fs_symlinknest;
 struct ext_filesystem ext_fs;
 
@@ -52,8 +55,8 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 		loff_t len, char *buf, loff_t *actread)
 {
 	struct ext_filesystem *fs = get_fs();
-	int i;
-	lbaint_t blockcnt;
+	int i, count;
+	lbaint_t blockcnt, firstblock;
 	int log2blksz = fs->dev_desc->log2blksz;
 	int log2_fs_blocksize = LOG2_BLOCK_SIZE(node->data) - log2blksz;
 	int blocksize = (1 << (log2_fs_blocksize + log2blksz));
@@ -80,42 +83,49 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 	}
 
 	blockcnt = lldiv(((len + pos) + blocksize - 1), blocksize);
-
-	for (i = lldiv(pos, blocksize); i < blockcnt; i++) {
+	firstblock = lldiv(pos, blocksize);
+
+	/*
+	 * Map the file a run of blocks at a time, so that each extent needs
+	 * only one lookup, and physically contiguous runs are read from the
+	 * device straight into the buffer with a single request.
+	 */
+	for (i = firstblock; i < blockcnt; i += count) {
 		long int blknr;
-		int blockoff = pos - (blocksize * i);
-		int blockend = blocksize;
+		lbaint_t blockend;
 		int skipfirst = 0;
-		blknr = read_allocated_block(&node->inode, i, &cache);
+
+		blknr = read_allocated_run(&node->inode, i, blockcnt - i,
+					   &count, &cache);
 		if (blknr < 0) {
 			ext_cache_fini(&cache);
 			return -1;
 		}
 
 		blknr = blknr << log2_fs_blocksize;
+		blockend = (lbaint_t)count * blocksize;
 
-		/* Last block.  */
-		if (i == blockcnt - 1) {
-			blockend = (len + pos) - (blocksize * i);
-
-			/* The last portion is exactly blocksize. */
-			if (!blockend)
-				blockend = blocksize;
-		}
+		/* Run containing the last block.  */
+		if (i + count == blockcnt)
+			blockend -= blocksize * blockcnt - (len + pos);
 
-		/* First block. */
-		if (i == lldiv(pos, blocksize)) {
-			skipfirst = blockoff;
+		/* Run containing the first block. */
+		if (i == firstblock) {
+			skipfirst = pos - (blocksize * (loff_t)i);
 			blockend -= skipfirst;
 		}
 		if (blknr) {
 			int status;
 
-			if (previous_block_number != -1) {
-				if (delayed_next == blknr) {
-					delayed_extent += blockend;
-					delayed_next += blockend >> log2blksz;
-				} else {	/* spill */
+			/* fs_devread() takes an int length */
+			if (previous_block_number != -1 &&
+			    delayed_next == blknr &&
+			    delayed_extent + blockend <= EXT4_MAX_DEVREAD) {
+				delayed_extent += blockend;
+				delayed_next += (lbaint_t)count << log2_fs_blocksize;
+			} else {
+				if (previous_block_number != -1) {
+					/* spill */
 					status = ext4fs_devread(delayed_start,
 							delayed_skipfirst,
 							delayed_extent,
@@ -124,26 +134,18 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 						ext_cache_fini(&cache);
 						return -1;
 					}
-					previous_block_number = blknr;
-					delayed_start = blknr;
-					delayed_extent = blockend;
-					delayed_skipfirst = skipfirst;
-					delayed_buf = buf;
-					delayed_next = blknr +
-						(blockend >> log2blksz);
 				}
-			} else {
 				previous_block_number = blknr;
 				delayed_start = blknr;
 				delayed_extent = blockend;
 				delayed_skipfirst = skipfirst;
 				delayed_buf = buf;
 				delayed_next = blknr +
-					(blockend >> log2blksz);
+					((lbaint_t)count << log2_fs_blocksize);
 			}
 		} else {
-			int n;
-			int n_left;
+			lbaint_t n;
+			lbaint_t n_left;
 			if (previous_block_number != -1) {
 				/* spill */
 				status = ext4fs_devread(delayed_start,
@@ -157,13 +159,13 @@ int ext4fs_read_file(struct ext2fs_node *node, loff_t pos,
 				previous_block_number = -1;
 			}
 			/* Zero no more than `len' bytes. */
-			n = blocksize - skipfirst;
+			n = (lbaint_t)count * blocksize - skipfirst;
 			n_left = len - ( buf - start_buf );
 			if (n > n_left)
 				n = n_left;
 			memset(buf, 0, n);
 		}
-		buf += blocksize - skipfirst;
+		buf += (lbaint_t)count * blocksize - skipfirst;
 	}
 	if (previous_block_number != -1) {
 		/* spill */
@@ -45,6 +45,60 @@ static void downcase(char *str, size_t len)
 static struct blk_desc *cur_dev;
 static struct disk_partition cur_part_info;
 
+#if CONFIG_FS_FAT_DCACHE_ENTRIES
+/**
+ * struct fat_dcache_ent - a cached directory lookup
+ *
+ * @valid:	set if this entry is in use
+ * @dir:	first cluster of the directory searched
+ * @hash:	hash of the name looked up, see fat_dcache_hash()
+ * @clust:	cluster holding the first slot of the directory entry
+ * @index:	index of that slot in the cluster
+ */
+struct fat_dcache_ent {
+	bool valid;
+	u32 dir;
+	u32 hash;
+	u32 clust;
+	u32 index;
+};
+
+/*
+ * Where names were last found in their directories, so that looking up the
+ * same path again does not need to walk each directory from the start. The
+ * cache belongs to one filesystem, identified by its device, partition and
+ * volume serial number. Entries are only hints: each is checked against the
+ * directory before use.
+ */
+static struct {
+	struct blk_desc *dev;
+	lbaint_t start;
+	u8 volume_id[4];
+	struct fat_dcache_ent ent[CONFIG_FS_FAT_DCACHE_ENTRIES];
+} dcache;
+
+static void fat_dcache_clear(void)
+{
+	memset(dcache.ent, '\0', sizeof(dcache.ent));
+}
+
+static void fat_dcache_check(const volume_info *volinfo)
+{
+	if (dcache.dev == cur_dev && dcache.start == cur_part_info.start &&
+	    !memcmp(dcache.volume_id, volinfo->volume_id,
+		    sizeof(dcache.volume_id)))
+		return;
+
+	fat_dcache_clear();
+	dcache.dev = cur_dev;
+	dcache.start = cur_part_info.start;
+	memcpy(dcache.volume_id, volinfo->volume_id, sizeof(dcache.volume_id));
+}
+#else
+static inline void fat_dcache_clear(void) {}
+static inline void fat_dcache_check(const volume_info *volinfo) {}
+#endif
+
 #define DOS_BOOT_MAGIC_OFFSET	0x1fe
 #define DOS_FS_TYPE_OFFSET	0x36
 #define DOS_FS32_TYPE_OFFSET	0x52
@@ -263,22 +317,40 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 
 	debug("gc - clustnum: %d, startsect: %d\n", clustnum, startsect);
 
-	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
-		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
+	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1) &&
+	    size >= mydata->sect_size) {
+		__u32 sect_count = size / mydata->sect_size;
+		__u32 chunk = min(sect_count,
+				  (__u32)(MAX_CLUSTSIZE / mydata->sect_size));
+		__u8 *tmpbuf;
 
 		debug("FAT: Misaligned buffer address (%p)\n", buffer);
 
-		while (size >= mydata->sect_size) {
-			ret = disk_read(startsect++, 1, tmpbuf);
-			if (ret != 1) {
+		/* bounce through a cluster-sized buffer, not sector by sector */
+		tmpbuf = malloc_cache_aligned(chunk * mydata->sect_size);
+		if (!tmpbuf) {
+			debug("Error: allocating buffer\n");
+			return -1;
+		}
+
+		while (sect_count) {
+			__u32 count = min(sect_count, chunk);
+			__u32 bytes = count * mydata->sect_size;
+
+			ret = disk_read(startsect, count, tmpbuf);
+			if (ret != count) {
 				debug("Error reading data (got %d)\n", ret);
+				free(tmpbuf);
 				return -1;
 			}
 
-			memcpy(buffer, tmpbuf, mydata->sect_size);
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
+			memcpy(buffer, tmpbuf, bytes);
+			startsect += count;
+			sect_count -= count;
+			buffer += bytes;
+			size -= bytes;
 		}
+		free(tmpbuf);
 	} else if (size >= mydata->sect_size) {
 		__u32 bytes_read;
 		__u32 sect_count = size / mydata->sect_size;
@@ -626,6 +698,7 @@ static int get_fs_info(fsdata *mydata)
 		debug("Error: reading boot sector\n");
 		return ret;
 	}
+	fat_dcache_check(&volinfo);
 
 	if (mydata->fatsize == 32) {
 		mydata->fatlength = bs.fat32_length;
@@ -1091,6 +1164,122 @@ static int fat_itr_isdir(fat_itr *itr)
 	return !!(itr->dent->attr & ATTR_DIR);
 }
 
+/**
+ * fat_itr_match() - check the name at the current cursor position
+ *
+ * @itr: the iterator
+ * @path: path whose first component is to be matched
+ * @len: length of that component
+ * Return: true if the long or short name matches, ignoring case
+ */
+static bool fat_itr_match(fat_itr *itr, const char *path, int len)
+{
+	size_t n = max(strlen(itr->name), (size_t)len);
+
+	if (!strncasecmp(path, itr->name, n))
+		return true;
+
+	return itr->name != itr->s_name && !strncasecmp(path, itr->s_name, n);
+}
+
+#if CONFIG_FS_FAT_DCACHE_ENTRIES
+static u32 fat_dcache_hash(const char *name, int len)
+{
+	u32 hash = 0;
+
+	while (len--)
+		hash = hash * 31 + tolower(*name++);
+
+	return hash;
+}
+
+/**
+ * fat_dcache_find() - look up a name in the directory cache
+ *
+ * If the name was found in this directory before, move the iterator to
+ * where it was and check that it is still there. If not, the iterator is
+ * left at the start of the directory.
+ *
+ * @itr: iterator at the start of the directory to search
+ * @hash: hash of the name
+ * @path: path whose first component is the name
+ * @len: length of the name
+ * Return: true if the cursor is now at the name
+ */
+static bool fat_dcache_find(fat_itr *itr, u32 hash, const char *path, int len)
+{
+	struct fat_dcache_ent *ent;
+	unsigned int nbytes;
+	dir_entry *dent;
+
+	ent = &dcache.ent[(itr->start_clust ^ hash) %
+			  CONFIG_FS_FAT_DCACHE_ENTRIES];
+	if (!ent->valid || ent->dir != itr->start_clust || ent->hash != hash)
+		return false;
+
+	/* Leave the cursor just before the entry */
+	itr->next_clust = ent->clust;
+	if (ent->index) {
+		dent = fat_next_cluster(itr, &nbytes);
+		if (!dent || ent->index >= nbytes / sizeof(dir_entry))
+			goto miss;
+		itr->dent = dent + ent->index - 1;
+		itr->remaining = nbytes / sizeof(dir_entry) - ent->index;
+	}
+
+	if (fat_itr_next(itr) && itr->dent_clust == ent->clust &&
+	    itr->dent_start == (dir_entry *)itr->block + ent->index &&
+	    fat_itr_match(itr, path, len))
+		return true;
+
+miss:
+	ent->valid = false;
+	itr->clust = itr->start_clust;
+	itr->next_clust = itr->start_clust;
+	itr->dent = NULL;
+	itr->remaining = 0;
+	itr->last_cluster = 0;
+
+	return false;
+}
+
+/**
+ * fat_dcache_add() - remember where a name was found
+ *
+ * @itr: iterator with the cursor at the name
+ * @hash: hash of the name
+ */
+static void fat_dcache_add(fat_itr *itr, u32 hash)
+{
+	struct fat_dcache_ent *ent;
+
+	/* Long names which cross into another cluster are not cached */
+	if (itr->dent_clust != itr->clust)
+		return;
+
+	ent = &dcache.ent[(itr->start_clust ^ hash) %
+			  CONFIG_FS_FAT_DCACHE_ENTRIES];
+	ent->valid = true;
+	ent->dir = itr->start_clust;
+	ent->hash = hash;
+	ent->clust = itr->dent_clust;
+	ent->index = itr->dent_start - (dir_entry *)itr->block;
+}
+#else
+static inline u32 fat_dcache_hash(const char *name, int len)
+{
+	return 0;
+}
+
+static inline bool fat_dcache_find(fat_itr *itr, u32 hash, const char *path,
+				   int len)
+{
+	return false;
+}
+
+static inline void fat_dcache_add(fat_itr *itr, u32 hash) {}
+#endif
+
 /*
  * Helpers:
  */
@@ -1117,6 +1306,7 @@ static int fat_itr_isdir(fat_itr *itr)
 static int fat_itr_resolve(fat_itr *itr, const char *path, unsigned type)
 {
 	const char *next;
+	u32 hash;
 
 	/* chomp any extra leading slashes: */
 	while (path[0] && ISDIRDELIM(path[0]))
@@ -1157,39 +1347,37 @@ static int fat_itr_resolve(fat_itr *itr, const char *path, unsigned type)
 		}
 	}
 
-	while (fat_itr_next(itr)) {
-		int match = 0;
-		unsigned n = max(strlen(itr->name), (size_t)(next - path));
-
-		/* check both long and short name: */
-		if (!strncasecmp(path, itr->name, n))
-			match = 1;
-		else if (itr->name != itr->s_name &&
-			 !strncasecmp(path, itr->s_name, n))
-			match = 1;
+	hash = fat_dcache_hash(path, next - path);
+	if (fat_dcache_find(itr, hash, path, next - path))
+		goto found;
 
-		if (!match)
+	while (fat_itr_next(itr)) {
+		if (!fat_itr_match(itr, path, next - path))
 			continue;
 
-		if (fat_itr_isdir(itr)) {
-			/* recurse into directory: */
-			fat_itr_child(itr, itr);
-			return fat_itr_resolve(itr, next, type);
-		} else if (next[0]) {
-			/*
-			 * If next is not empty then we have a case
-			 * like: /path/to/realfile/nonsense
-			 */
-			debug("bad trailing path: %s\n", next);
-			return -ENOENT;
-		} else if (!(type & TYPE_FILE)) {
-			return -ENOTDIR;
-		} else {
-			return 0;
-		}
+		fat_dcache_add(itr, hash);
+		goto found;
 	}
 
 	return -ENOENT;
+
+found:
+	if (fat_itr_isdir(itr)) {
+		/* recurse into directory: */
+		fat_itr_child(itr, itr);
+		return fat_itr_resolve(itr, next, type);
+	} else if (next[0]) {
+		/*
+		 * If next is not empty then we have a case
+		 * like: /path/to/realfile/nonsense
+		 */
+		debug("bad trailing path: %s\n", next);
+		return -ENOENT;
+	} else if (!(type & TYPE_FILE)) {
+		return -ENOTDIR;
+	}
+
+	return 0;
 }
 
 int file_fat_detectfs(void)
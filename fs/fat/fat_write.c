@@ -192,6 +192,19 @@ out:
 }
 
 static int total_sector;
+
+/*
+ * Where to start looking for a free cluster. This is kept across writes to
+ * the same filesystem, so that each new file or cluster run does not have
+ * to rescan the whole FAT from the start. It is only ever a hint: entries
+ * are still checked before use and the search wraps around.
+ */
+static struct {
+	struct blk_desc *dev;
+	lbaint_t start;
+	__u32 clust;
+} free_hint;
+
 static int disk_write(__u32 block, __u32 nr_blocks, void *buf)
 {
 	ulong ret;
@@ -205,6 +218,9 @@ static int disk_write(__u32 block, __u32 nr_blocks, void *buf)
 		return -1;
 	}
 
+	/* Entries may move or clusters be reused, so forget lookups */
+	fat_dcache_clear();
+
 	ret = blk_dwrite(cur_dev, cur_part_info.start + block, nr_blocks, buf);
 	if (nr_blocks && ret == 0)
 		return -1;
@@ -487,6 +503,11 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 	/* Mark as dirty */
 	mydata->fat_dirty = 1;
 
+	/* A freed cluster before the hint is the next one to hand out */
+	if (!entry_value && free_hint.dev == cur_dev &&
+	    free_hint.start == cur_part_info.start && entry < free_hint.clust)
+		free_hint.clust = entry;
+
 	/* Set the actual entry */
 	switch (mydata->fatsize) {
 	case 32:
@@ -541,23 +562,60 @@ static int set_fatent_value(fsdata *mydata, __u32 entry, __u32 entry_value)
 	return 0;
 }
 
+/*
+ * Return the number of the first cluster past the end of the filesystem
+ */
+static __u32 fat_clust_limit(fsdata *mydata)
+{
+	__u32 limit = (mydata->total_sect - mydata->data_begin) /
+		      mydata->clust_size;
+	__u32 entries = mydata->fatlength * mydata->sect_size * 8 /
+			mydata->fatsize;
+
+	return min(limit, entries);
+}
+
+/*
+ * Find a free cluster, searching upwards from 'entry' and wrapping around
+ * at the end of the FAT. Returns 0 if the filesystem is full.
+ */
+static __u32 find_free_cluster(fsdata *mydata, __u32 entry)
+{
+	__u32 limit = fat_clust_limit(mydata);
+	__u32 first;
+
+	if (entry < 3 || entry >= limit)
+		entry = 3;
+	first = entry;
+	do {
+		if (!get_fatent(mydata, entry)) {
+			free_hint.dev = cur_dev;
+			free_hint.start = cur_part_info.start;
+			free_hint.clust = entry + 1;
+			return entry;
+		}
+		if (++entry >= limit)
+			entry = 3;
+	} while (entry != first);
+
+	return 0;
+}
+
 /*
  * Determine the next free cluster after 'entry' in a FAT (12/16/32) table
  * and link it to 'entry'. EOC marker is not set on returned entry.
+ * Returns 0 if there is no free cluster.
  */
 static __u32 determine_fatent(fsdata *mydata, __u32 entry)
 {
-	__u32 next_fat, next_entry = entry + 1;
+	__u32 next_entry;
 
-	while (1) {
-		next_fat = get_fatent(mydata, next_entry);
-		if (next_fat == 0) {
-			/* found free entry, link to entry */
-			set_fatent_value(mydata, entry, next_entry);
-			break;
-		}
-		next_entry++;
-	}
+	next_entry = find_free_cluster(mydata, entry + 1);
+	if (!next_entry)
+		return 0;
+
+	/* found free entry, link to entry */
+	set_fatent_value(mydata, entry, next_entry);
 	debug("FAT%d: entry: %08x, entry_value: %04x\n",
 	       mydata->fatsize, entry, next_entry);
 
@@ -582,22 +640,39 @@ set_sectors(fsdata *mydata, u32 startsect, u8 *buffer, u32 size)
 
 	debug("startsect: %d\n", startsect);
 
-	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
-		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
+	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1) &&
+	    size >= mydata->sect_size) {
+		u32 nsects = size / mydata->sect_size;
+		u32 chunk = min(nsects, (u32)(MAX_CLUSTSIZE / mydata->sect_size));
+		u8 *tmpbuf;
 
 		debug("FAT: Misaligned buffer address (%p)\n", buffer);
 
-		while (size >= mydata->sect_size) {
-			memcpy(tmpbuf, buffer, mydata->sect_size);
-			ret = disk_write(startsect++, 1, tmpbuf);
-			if (ret != 1) {
+		/* bounce through a cluster-sized buffer, not sector by sector */
+		tmpbuf = malloc_cache_aligned(chunk * mydata->sect_size);
+		if (!tmpbuf) {
+			debug("Error: allocating buffer\n");
+			return -1;
+		}
+
+		while (nsects) {
+			u32 count = min(nsects, chunk);
+			u32 bytes = count * mydata->sect_size;
+
+			memcpy(tmpbuf, buffer, bytes);
+			ret = disk_write(startsect, count, tmpbuf);
+			if (ret != count) {
 				debug("Error writing data (got %d)\n", ret);
+				free(tmpbuf);
 				return -1;
 			}
 
-			buffer += mydata->sect_size;
-			size -= mydata->sect_size;
+			startsect += count;
+			nsects -= count;
+			buffer += bytes;
+			size -= bytes;
 		}
+		free(tmpbuf);
 	} else if (size >= mydata->sect_size) {
 		u32 nsects;
 
@@ -800,20 +875,18 @@ get_set_cluster(fsdata *mydata, __u32 clustnum, loff_t pos, __u8 *buffer,
 }
 
 /*
- * Find the first empty cluster
+ * Find an empty cluster, starting where the last allocation left off
+ * Returns 0 if the filesystem is full.
  */
-static int find_empty_cluster(fsdata *mydata)
+static __u32 find_empty_cluster(fsdata *mydata)
 {
-	__u32 fat_val, entry = 3;
+	__u32 entry = 3;
 
-	while (1) {
-		fat_val = get_fatent(mydata, entry);
-		if (fat_val == 0)
-			break;
-		entry++;
-	}
+	if (free_hint.dev == cur_dev &&
+	    free_hint.start == cur_part_info.start)
+		entry = free_hint.clust;
 
-	return entry;
+	return find_free_cluster(mydata, entry);
 }
 
 /**
@@ -830,6 +903,8 @@ static int new_dir_table(fat_itr *itr)
 	unsigned int bytesperclust = mydata->clust_size * mydata->sect_size;
 
 	dir_newclust = find_empty_cluster(mydata);
+	if (!dir_newclust)
+		return -EIO;
 
 	/*
 	 * Flush before updating FAT to ensure valid directory structure
@@ -876,10 +951,7 @@ static int clear_fatent(fsdata *mydata, __u32 entry)
 		entry = fat_val;
 	}
 
-	/* Flush fat buffer */
-	if (flush_dirty_fat_buffer(mydata) < 0)
-		return -1;
-
+	/* The caller flushes the FAT buffer once it is done with it */
 	return 0;
 }
 
@@ -1072,12 +1144,21 @@ set_clusters:
 	/* Assure that curclust is valid */
 	if (!curclust) {
 		curclust = find_empty_cluster(mydata);
+		if (!curclust) {
+			printf("Error: no space left: %llu\n", filesize);
+			return -1;
+		}
 		set_start_cluster(mydata, dentptr, curclust);
 	} else {
 		newclust = get_fatent(mydata, curclust);
 
 		if (IS_LAST_CLUST(newclust, mydata->fatsize)) {
 			newclust = determine_fatent(mydata, curclust);
+			if (!newclust) {
+				printf("Error: no space left: %llu\n",
+				       filesize);
+				return -1;
+			}
 			set_fatent_value(mydata, curclust, newclust);
 			curclust = newclust;
 		} else {
@@ -1098,6 +1179,19 @@ set_clusters:
 		/* search for consecutive clusters */
 		while (actsize < filesize) {
 			newclust = determine_fatent(mydata, endclust);
+			if (!newclust) {
+				/* Mark end of file so the chain stays valid */
+				if (mydata->fatsize == 12)
+					newclust = 0xfff;
+				else if (mydata->fatsize == 16)
+					newclust = 0xffff;
+				else
+					newclust = 0xfffffff;
+				set_fatent_value(mydata, endclust, newclust);
+				printf("Error: no space left: %llu\n",
+				       filesize);
+				return -1;
+			}
 
 			if ((newclust - 1) != endclust)
 				/* write to <curclust..endclust> */
@@ -39,6 +39,31 @@ static int fs_dev_part;
 static struct disk_partition fs_partition;
 static int fs_type = FS_TYPE_ANY;
 
+struct fstype_info;
+
+/**
+ * struct fs_mount - a filesystem which stays mounted after fs_close()
+ *
+ * With CONFIG_FS_KEEP_MOUNTED, the filesystem last probed is not closed by
+ * fs_close() if its type allows that. The next command on the same partition
+ * then uses it without probing again.
+ *
+ * @info: filesystem type, or NULL if nothing is kept mounted
+ * @desc: block device
+ * @part: partition number
+ * @start: first block of the partition
+ * @size: number of blocks in the partition
+ * @gen: block-cache generation when probed, see blkcache_generation()
+ */
+static struct fs_mount {
+	struct fstype_info *info;
+	struct blk_desc *desc;
+	int part;
+	lbaint_t start;
+	lbaint_t size;
+	ulong gen;
+} fs_mount;
+
 void fs_set_type(int type)
 {
 	fs_type = type;
@@ -154,6 +179,12 @@ struct fstype_info {
 	 * filesystem.
 	 */
 	bool null_dev_desc_ok;
+	/*
+	 * Can the filesystem stay mounted after close() is skipped? Its
+	 * operations must only rely on the state set up by probe(), see
+	 * struct fs_mount.
+	 */
+	bool keep_mounted;
 	int (*probe)(struct blk_desc *fs_dev_desc,
 		     struct disk_partition *fs_partition);
 	int (*ls)(const char *dirname);
@@ -190,6 +221,7 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_FAT,
 		.name = "fat",
 		.null_dev_desc_ok = false,
+		.keep_mounted = true,
 		.probe = fat_set_blk_dev,
 		.close = fat_close,
 		.ls = fs_ls_generic,
@@ -302,6 +334,7 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_BTRFS,
 		.name = "btrfs",
 		.null_dev_desc_ok = false,
+		.keep_mounted = true,
 		.probe = btrfs_probe,
 		.close = btrfs_close,
 		.ls = btrfs_ls,
@@ -322,6 +355,7 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_SQUASHFS,
 		.name = "squashfs",
 		.null_dev_desc_ok = false,
+		.keep_mounted = true,
 		.probe = sqfs_probe,
 		.opendir = sqfs_opendir,
 		.readdir = sqfs_readdir,
@@ -343,6 +377,7 @@ static struct fstype_info fstypes[] = {
 		.fstype = FS_TYPE_EROFS,
 		.name = "erofs",
 		.null_dev_desc_ok = false,
+		.keep_mounted = true,
 		.probe = erofs_probe,
 		.opendir = erofs_opendir,
 		.readdir = erofs_readdir,
@@ -418,6 +453,63 @@ const char *fs_get_type_name(void)
 	return fs_get_info(fs_type)->name;
 }
 
+static bool fs_keep_mounted(struct fstype_info *info)
+{
+	return CONFIG_IS_ENABLED(FS_KEEP_MOUNTED) &&
+		CONFIG_IS_ENABLED(BLOCK_CACHE) && info->keep_mounted;
+}
+
+/* Close the filesystem kept mounted by fs_close(), if any */
+static void fs_unmount(void)
+{
+	if (fs_mount.info) {
+		fs_mount.info->close();
+		fs_mount.info = NULL;
+	}
+}
+
+/*
+ * Use the filesystem kept mounted, if it is on the selected partition and
+ * nothing has been written to a device since it was probed. Otherwise close
+ * it, so that the partition can be probed.
+ */
+static bool fs_reuse_mount(int part, int fstype)
+{
+	struct fstype_info *info = fs_mount.info;
+
+	if (!info)
+		return false;
+
+	if (fs_mount.desc == fs_dev_desc && fs_mount.part == part &&
+	    fs_mount.start == fs_partition.start &&
+	    fs_mount.size == fs_partition.size &&
+	    fs_mount.gen == blkcache_generation() &&
+	    (fstype == FS_TYPE_ANY || fstype == info->fstype)) {
+		fs_type = info->fstype;
+		fs_dev_part = part;
+		return true;
+	}
+
+	fs_unmount();
+	return false;
+}
+
+static void fs_set_mounted(struct fstype_info *info, int part)
+{
+	fs_type = info->fstype;
+	fs_dev_part = part;
+
+	if (!fs_keep_mounted(info))
+		return;
+
+	fs_mount.info = info;
+	fs_mount.desc = fs_dev_desc;
+	fs_mount.part = part;
+	fs_mount.start = fs_partition.start;
+	fs_mount.size = fs_partition.size;
+	fs_mount.gen = blkcache_generation();
+}
+
 int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 {
 	struct fstype_info *info;
@@ -428,6 +520,9 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 	if (part < 0)
 		return -1;
 
+	if (fs_reuse_mount(part, fstype))
+		return 0;
+
 	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
 		if (fstype != FS_TYPE_ANY && info->fstype != FS_TYPE_ANY &&
 				fstype != info->fstype)
@@ -437,8 +532,7 @@ int fs_set_blk_dev(const char *ifname, const char *dev_part_str, int fstype)
 			continue;
 
 		if (!info->probe(fs_dev_desc, &fs_partition)) {
-			fs_type = info->fstype;
-			fs_dev_part = part;
+			fs_set_mounted(info, part);
 			return 0;
 		}
 	}
@@ -460,10 +554,12 @@ int fs_set_blk_dev_with_part(struct blk_desc *desc, int part)
 		return ret;
 	fs_dev_desc = desc;
 
+	if (fs_reuse_mount(part, FS_TYPE_ANY))
+		return 0;
+
 	for (i = 0, info = fstypes; i < ARRAY_SIZE(fstypes); i++, info++) {
 		if (!info->probe(fs_dev_desc, &fs_partition)) {
-			fs_type = info->fstype;
-			fs_dev_part = part;
+			fs_set_mounted(info, part);
 			return 0;
 		}
 	}
@@ -475,7 +571,12 @@ void fs_close(void)
 {
 	struct fstype_info *info = fs_get_info(fs_type);
 
-	info->close();
+	/* Anything written, even by this filesystem, means probing again */
+	if (info != fs_mount.info || fs_mount.gen != blkcache_generation()) {
+		if (info == fs_mount.info)
+			fs_mount.info = NULL;
+		info->close();
+	}
 
 	fs_type = FS_TYPE_ANY;
 }
@@ -596,6 +697,24 @@ int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	return _fs_read(filename, addr, offset, len, 0, actread);
 }
 
+int fs_read_max(const char *filename, ulong addr, loff_t max_len,
+		loff_t *actread)
+{
+	struct fstype_info *info = fs_get_info(fs_type);
+	loff_t size;
+	int ret;
+
+	ret = info->size(filename, &size);
+	if (!ret && size > max_len)
+		ret = -ENOSPC;
+	if (ret) {
+		fs_close();
+		return ret;
+	}
+
+	return _fs_read(filename, addr, 0, 0, 0, actread);
+}
+
 int fs_write(const char *filename, ulong addr, loff_t offset, loff_t len,
 	     loff_t *actwrite)
 {
@@ -12,6 +12,7 @@
 #include <errno.h>
 #include <fs.h>
 #include <linux/types.h>
+#include <linux/sizes.h>
 #include <asm/byteorder.h>
 #include <linux/compat.h>
 #include <memalign.h>
@@ -26,6 +27,9 @@
 
 #define MAX_SYMLINK_NEST 8
 
+/* Largest read of consecutive data blocks done at once, in bytes */
+#define SQFS_MAX_READ_SIZE	SZ_1M
+
 static struct squashfs_ctxt ctxt;
 static int symlinknest;
 
@@ -897,13 +901,123 @@ out:
 	return metablks_count;
 }
 
+static void sqfs_free_cache(void)
+{
+	int i;
+
+	free(ctxt.inode_table);
+	free(ctxt.dir_table);
+	free(ctxt.dir_pos_list);
+	ctxt.inode_table = NULL;
+	ctxt.dir_table = NULL;
+	ctxt.dir_pos_list = NULL;
+	ctxt.dir_metablks = 0;
+	for (i = 0; i < ARRAY_SIZE(ctxt.frag_cache); i++) {
+		free(ctxt.frag_cache[i].data);
+		ctxt.frag_cache[i].data = NULL;
+	}
+	ctxt.cache_dev = NULL;
+}
+
+/* Read and decompress the inode and directory tables, unless already done */
+static int sqfs_read_tables(void)
+{
+	if (ctxt.inode_table)
+		return 0;
+
+	if (sqfs_read_inode_table(&ctxt.inode_table))
+		return -EINVAL;
+
+	ctxt.dir_metablks = sqfs_read_directory_table(&ctxt.dir_table,
+						      &ctxt.dir_pos_list);
+	if (ctxt.dir_metablks < 1) {
+		free(ctxt.inode_table);
+		ctxt.inode_table = NULL;
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/*
+ * Get the decompressed fragment block for entry @e, reading it into the
+ * fragment cache if needed. The block belongs to the cache and must not be
+ * freed.
+ */
+static int sqfs_get_fragment(struct squashfs_fragment_block_entry *e,
+			     char **datap, u32 *sizep)
+{
+	struct squashfs_frag_cache *fc, *lru = NULL;
+	u64 start, n_blks, table_size, table_offset;
+	unsigned long dest_len;
+	char *buf, *data;
+	int i, ret;
+
+	for (i = 0; i < ARRAY_SIZE(ctxt.frag_cache); i++) {
+		fc = &ctxt.frag_cache[i];
+		if (fc->data && fc->start == e->start) {
+			fc->last_used = ++ctxt.frag_count;
+			*datap = fc->data;
+			*sizep = fc->size;
+			return 0;
+		}
+		/* Use an empty entry, else the least recently used */
+		if (!lru || (lru->data &&
+			     (!fc->data || fc->last_used < lru->last_used)))
+			lru = fc;
+	}
+
+	start = lldiv(e->start, ctxt.cur_dev->blksz);
+	table_size = SQFS_BLOCK_SIZE(e->size);
+	table_offset = e->start - (start * ctxt.cur_dev->blksz);
+	n_blks = DIV_ROUND_UP(table_size + table_offset, ctxt.cur_dev->blksz);
+
+	buf = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
+	if (!buf)
+		return -ENOMEM;
+
+	if (sqfs_disk_read(start, n_blks, buf) < 0) {
+		free(buf);
+		return -EIO;
+	}
+
+	if (SQFS_COMPRESSED_BLOCK(e->size)) {
+		dest_len = get_unaligned_le32(&ctxt.sblk->block_size);
+		data = malloc(dest_len);
+		if (!data) {
+			free(buf);
+			return -ENOMEM;
+		}
+
+		ret = sqfs_decompress(&ctxt, data, &dest_len,
+				      buf + table_offset, table_size);
+		free(buf);
+		if (ret) {
+			free(data);
+			return ret;
+		}
+	} else {
+		data = buf;
+		memmove(data, buf + table_offset, table_size);
+		dest_len = table_size;
+	}
+
+	free(lru->data);
+	lru->start = e->start;
+	lru->data = data;
+	lru->size = dest_len;
+	lru->last_used = ++ctxt.frag_count;
+	*datap = data;
+	*sizep = dest_len;
+
+	return 0;
+}
+
 static int sqfs_opendir_nest(const char *filename, struct fs_dir_stream **dirsp)
 {
-	unsigned char *inode_table = NULL, *dir_table = NULL;
-	int j, token_count = 0, ret = 0, metablks_count;
+	int j, token_count = 0, ret = 0;
 	struct squashfs_dir_stream *dirs;
 	char **token_list = NULL, *path = NULL;
-	u32 *pos_list = NULL;
 
 	dirs = calloc(1, sizeof(*dirs));
 	if (!dirs)
@@ -916,17 +1030,9 @@ static int sqfs_opendir_nest(const char *filename, struct fs_dir_stream **dirsp)
 	dirs->inode_table = NULL;
 	dirs->dir_table = NULL;
 
-	ret = sqfs_read_inode_table(&inode_table);
-	if (ret) {
-		ret = -EINVAL;
+	ret = sqfs_read_tables();
+	if (ret)
 		goto out;
-	}
-
-	metablks_count = sqfs_read_directory_table(&dir_table, &pos_list);
-	if (metablks_count < 1) {
-		ret = -EINVAL;
-		goto out;
-	}
 
 	/* Tokenize filename */
 	token_count = sqfs_count_tokens(filename);
@@ -955,10 +1061,10 @@ static int sqfs_opendir_nest(const char *filename, struct fs_dir_stream **dirsp)
 	 * ldir's (extended directory) size is greater than dir, so it works as
 	 * a general solution for the malloc size, since 'i' is a union.
 	 */
-	dirs->inode_table = inode_table;
-	dirs->dir_table = dir_table;
-	ret = sqfs_search_dir(dirs, token_list, token_count, pos_list,
-			      metablks_count);
+	dirs->inode_table = ctxt.inode_table;
+	dirs->dir_table = ctxt.dir_table;
+	ret = sqfs_search_dir(dirs, token_list, token_count, ctxt.dir_pos_list,
+			      ctxt.dir_metablks);
 	if (ret)
 		goto out;
 
@@ -982,12 +1088,9 @@ out:
 	for (j = 0; j < token_count; j++)
 		free(token_list[j]);
 	free(token_list);
-	free(pos_list);
 	free(path);
-	if (ret) {
-		free(inode_table);
+	if (ret)
 		free(dirs);
-	}
 
 	return ret;
 }
@@ -1140,6 +1243,16 @@ int sqfs_probe(struct blk_desc *fs_dev_desc, struct disk_partition *fs_partition
 		goto error;
 	}
 
+	/* Drop anything cached from a different filesystem */
+	if (ctxt.cache_dev != fs_dev_desc ||
+	    ctxt.cache_start != fs_partition->start ||
+	    memcmp(&ctxt.cache_sblk, sblk, sizeof(*sblk))) {
+		sqfs_free_cache();
+		ctxt.cache_dev = fs_dev_desc;
+		ctxt.cache_start = fs_partition->start;
+		ctxt.cache_sblk = *sblk;
+	}
+
 	ctxt.sblk = sblk;
 
 	ret = sqfs_decompressor_init(&ctxt);
@@ -1354,9 +1467,10 @@ static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 			  loff_t len, loff_t *actread)
 {
 	char *dir = NULL, *fragment_block, *datablock = NULL;
-	char *fragment = NULL, *file = NULL, *resolved, *data;
+	char *file = NULL, *resolved, *data, *data_buffer = NULL, *dest;
 	u64 start, n_blks, table_size, data_offset, table_offset, sparse_size;
-	int ret, j, i_number, datablk_count = 0;
+	int ret, i, j, k, i_number, datablk_count = 0;
+	u32 frag_size, block_size;
 	struct squashfs_super_block *sblk = ctxt.sblk;
 	struct squashfs_fragment_block_entry frag_entry;
 	struct squashfs_file_info finfo = {0};
@@ -1371,6 +1485,7 @@ static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 	unsigned char *ipos;
 
 	*actread = 0;
+	block_size = get_unaligned_le32(&sblk->block_size);
 
 	if (offset) {
 		/*
@@ -1484,80 +1599,90 @@ static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 
 	if (datablk_count) {
 		data_offset = finfo.start;
-		datablock = malloc(get_unaligned_le32(&sblk->block_size));
+		datablock = malloc(block_size);
 		if (!datablock) {
 			ret = -ENOMEM;
 			goto out;
 		}
+
+		/* Room for the largest read, plus the offset into a block */
+		n_blks = DIV_ROUND_UP(max_t(u32, SQFS_MAX_READ_SIZE, block_size),
+				      ctxt.cur_dev->blksz) + 1;
+		data_buffer = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
+		if (!data_buffer) {
+			ret = -ENOMEM;
+			goto out;
+		}
 	}
 
-	for (j = 0; j < datablk_count; j++) {
-		char *data_buffer;
+	for (j = 0; j < datablk_count && *actread < len; j = k) {
+		u64 run_size = 0;
+
+		/*
+		 * The data blocks follow each other on the disk, so read as many
+		 * as fit in the buffer, but no more than are needed for @len
+		 */
+		for (k = j; k < datablk_count; k++) {
+			table_size = SQFS_BLOCK_SIZE(finfo.blk_sizes[k]);
+			if (k > j && (run_size + table_size > SQFS_MAX_READ_SIZE ||
+				      (u64)(k - j) * block_size >= len - *actread))
+				break;
+			run_size += table_size;
+		}
 
 		start = lldiv(data_offset, ctxt.cur_dev->blksz);
-		table_size = SQFS_BLOCK_SIZE(finfo.blk_sizes[j]);
 		table_offset = data_offset - (start * ctxt.cur_dev->blksz);
-		n_blks = DIV_ROUND_UP(table_size + table_offset,
+		n_blks = DIV_ROUND_UP(run_size + table_offset,
 				      ctxt.cur_dev->blksz);
 
 		/* Don't load any data for sparse blocks */
-		if (finfo.blk_sizes[j] == 0) {
-			n_blks = 0;
-			table_offset = 0;
-			data_buffer = NULL;
-			data = NULL;
-		} else {
-			data_buffer = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-
-			if (!data_buffer) {
-				ret = -ENOMEM;
-				goto out;
-			}
-
+		if (run_size) {
 			ret = sqfs_disk_read(start, n_blks, data_buffer);
 			if (ret < 0) {
-				/*
-				 * Possible causes: too many data blocks or too large
-				 * SquashFS block size. Tip: re-compile the SquashFS
-				 * image with mksquashfs's -b <block_size> option.
-				 */
-				printf("Error: too many data blocks to be read.\n");
+				printf("Error: failed to read data blocks.\n");
 				goto out;
 			}
-
-			data = data_buffer + table_offset;
 		}
-
-		/* Load the data */
-		if (finfo.blk_sizes[j] == 0) {
-			/* This is a sparse block */
-			sparse_size = get_unaligned_le32(&sblk->block_size);
-			if ((*actread + sparse_size) > len)
-				sparse_size = len - *actread;
-			memset(buf + *actread, 0, sparse_size);
-			*actread += sparse_size;
-		} else if (SQFS_COMPRESSED_BLOCK(finfo.blk_sizes[j])) {
-			dest_len = get_unaligned_le32(&sblk->block_size);
-			ret = sqfs_decompress(&ctxt, datablock, &dest_len,
-					      data, table_size);
-			if (ret)
-				goto out;
-
-			if ((*actread + dest_len) > len)
-				dest_len = len - *actread;
-			memcpy(buf + *actread, datablock, dest_len);
-			*actread += dest_len;
-		} else {
-			if ((*actread + table_size) > len)
-				table_size = len - *actread;
-			memcpy(buf + *actread, data, table_size);
-			*actread += table_size;
+		data = data_buffer + table_offset;
+		data_offset += run_size;
+
+		for (i = j; i < k && *actread < len; i++) {
+			table_size = SQFS_BLOCK_SIZE(finfo.blk_sizes[i]);
+
+			/* Load the data */
+			if (finfo.blk_sizes[i] == 0) {
+				/* This is a sparse block */
+				sparse_size = block_size;
+				if ((*actread + sparse_size) > len)
+					sparse_size = len - *actread;
+				memset(buf + *actread, 0, sparse_size);
+				*actread += sparse_size;
+			} else if (SQFS_COMPRESSED_BLOCK(finfo.blk_sizes[i])) {
+				/* Full blocks go straight to the caller's buffer */
+				dest = datablock;
+				if (len - *actread >= block_size)
+					dest = buf + *actread;
+				dest_len = block_size;
+				ret = sqfs_decompress(&ctxt, dest, &dest_len,
+						      data, table_size);
+				if (ret)
+					goto out;
+
+				if ((*actread + dest_len) > len)
+					dest_len = len - *actread;
+				if (dest == datablock)
+					memcpy(buf + *actread, datablock,
+					       dest_len);
+				*actread += dest_len;
+			} else {
+				sparse_size = table_size;
+				if ((*actread + sparse_size) > len)
+					sparse_size = len - *actread;
+				memcpy(buf + *actread, data, sparse_size);
+				*actread += sparse_size;
+			}
+			data += table_size;
 		}
-
-		data_offset += table_size;
-		free(data_buffer);
-		if (*actread >= len)
-			break;
 	}
 
 	/*
@@ -1568,53 +1693,20 @@ static int sqfs_read_nest(const char *filename, void *buf, loff_t offset,
 		goto out;
 	}
 
-	start = lldiv(frag_entry.start, ctxt.cur_dev->blksz);
-	table_size = SQFS_BLOCK_SIZE(frag_entry.size);
-	table_offset = frag_entry.start - (start * ctxt.cur_dev->blksz);
-	n_blks = DIV_ROUND_UP(table_size + table_offset, ctxt.cur_dev->blksz);
-
-	fragment = malloc_cache_aligned(n_blks * ctxt.cur_dev->blksz);
-
-	if (!fragment) {
-		ret = -ENOMEM;
+	ret = sqfs_get_fragment(&frag_entry, &fragment_block, &frag_size);
+	if (ret)
 		goto out;
-	}
 
-	ret = sqfs_disk_read(start, n_blks, fragment);
-	if (ret < 0)
+	if (finfo.offset + finfo.size - *actread > frag_size) {
+		ret = -EINVAL;
 		goto out;
-
-	/* File compressed and fragmented */
-	if (finfo.frag && finfo.comp) {
-		dest_len = get_unaligned_le32(&sblk->block_size);
-		fragment_block = malloc(dest_len);
-		if (!fragment_block) {
-			ret = -ENOMEM;
-			goto out;
-		}
-
-		ret = sqfs_decompress(&ctxt, fragment_block, &dest_len,
-				      (void *)fragment  + table_offset,
-				      frag_entry.size);
-		if (ret) {
-			free(fragment_block);
-			goto out;
-		}
-
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
-
-		free(fragment_block);
-
-	} else if (finfo.frag && !finfo.comp) {
-		fragment_block = (void *)fragment + table_offset;
-
-		memcpy(buf + *actread, &fragment_block[finfo.offset], finfo.size - *actread);
-		*actread = finfo.size;
 	}
+	memcpy(buf + *actread, &fragment_block[finfo.offset],
+	       finfo.size - *actread);
+	*actread = finfo.size;
 
 out:
-	free(fragment);
+	free(data_buffer);
 	free(datablock);
 	free(file);
 	free(dir);
@@ -1779,6 +1871,8 @@ int sqfs_size(const char *filename, loff_t *size)
 
 void sqfs_close(void)
 {
+	if (!IS_ENABLED(CONFIG_SQUASHFS_CACHE))
+		sqfs_free_cache();
 	sqfs_decompressor_cleanup(&ctxt);
 	free(ctxt.sblk);
 	ctxt.sblk = NULL;
@@ -1793,8 +1887,6 @@ void sqfs_closedir(struct fs_dir_stream *dirs)
 		return;
 
 	sqfs_dirs = (struct squashfs_dir_stream *)dirs;
-	free(sqfs_dirs->inode_table);
-	free(sqfs_dirs->dir_table);
 	free(sqfs_dirs->dir_header);
 	free(sqfs_dirs);
 }
@@ -71,6 +71,42 @@ struct squashfs_super_block {
 	__le64 export_table_start;
 };
 
+/**
+ * struct squashfs_frag_cache - A decompressed fragment block
+ *
+ * @start: Position of the fragment block on the disk
+ * @data: Decompressed data, or NULL if this entry is unused
+ * @size: Size of @data in bytes
+ * @last_used: Value of the fragment-cache counter when last used
+ */
+struct squashfs_frag_cache {
+	u64 start;
+	void *data;
+	u32 size;
+	ulong last_used;
+};
+
+/**
+ * struct squashfs_ctxt - State of the SquashFS filesystem being read
+ *
+ * The inode table, directory table and fragment blocks are decompressed at
+ * most once. With CONFIG_SQUASHFS_CACHE they are kept after sqfs_close(), for
+ * as long as the same filesystem is probed again.
+ *
+ * @cur_part_info: Partition being read
+ * @cur_dev: Device being read, or NULL if none
+ * @sblk: Superblock
+ * @zstd_workspace: Workspace for zstd decompression
+ * @cache_dev: Device which the cached tables were read from
+ * @cache_start: Start of the partition which the cached tables were read from
+ * @cache_sblk: Superblock of the filesystem which the tables were read from
+ * @inode_table: Decompressed inode table, or NULL if not read yet
+ * @dir_table: Decompressed directory table
+ * @dir_pos_list: Position of each metadata block in the directory table
+ * @dir_metablks: Number of metadata blocks in the directory table
+ * @frag_cache: Cached fragment blocks
+ * @frag_count: Counter, incremented each time a fragment block is used
+ */
 struct squashfs_ctxt {
 	struct disk_partition cur_part_info;
 	struct blk_desc *cur_dev;
@@ -78,6 +114,15 @@ struct squashfs_ctxt {
 #if IS_ENABLED(CONFIG_ZSTD)
 	void *zstd_workspace;
 #endif
+	struct blk_desc *cache_dev;
+	lbaint_t cache_start;
+	struct squashfs_super_block cache_sblk;
+	unsigned char *inode_table;
+	unsigned char *dir_table;
+	u32 *dir_pos_list;
+	int dir_metablks;
+	struct squashfs_frag_cache frag_cache[CONFIG_SQUASHFS_FRAG_CACHE_ENTRIES];
+	ulong frag_count;
 };
 
 struct squashfs_directory_index {
@@ -1351,6 +1351,7 @@ static int mount_ubifs(struct ubifs_info *c)
 		printf("UBIFS: only ro mode in U-Boot allowed.\n");
 		return -EACCES;
 	}
+	c->bulk_read = IS_ENABLED(CONFIG_UBIFS_BULK_READ);
 #endif
 
 	err = init_constants_early(c);
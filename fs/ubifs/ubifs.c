@@ -721,23 +721,13 @@ static inline void *kmap(struct page *page)
 	return page->addr;
 }
 
-static int read_block(struct inode *inode, void *addr, unsigned int block,
-		      struct ubifs_data_node *dn)
+/* Decompress the data node @dn into block @block of @inode at @addr */
+static int unpack_block(struct ubifs_info *c, struct inode *inode, void *addr,
+			unsigned int block, struct ubifs_data_node *dn)
 {
-	struct ubifs_info *c = inode->i_sb->s_fs_info;
 	int err, len, out_len;
-	union ubifs_key key;
 	unsigned int dlen;
 
-	data_key_init(c, &key, inode->i_ino, block);
-	err = ubifs_tnc_lookup(c, &key, dn);
-	if (err) {
-		if (err == -ENOENT)
-			/* Not found, so it must be a hole */
-			memset(addr, 0, UBIFS_BLOCK_SIZE);
-		return err;
-	}
-
 	ubifs_assert(le64_to_cpu(dn->ch.sqnum) > ubifs_inode(inode)->creat_sqnum);
 
 	len = le32_to_cpu(dn->size);
@@ -768,6 +758,84 @@ dump:
 	return -EINVAL;
 }
 
+static int read_block(struct inode *inode, void *addr, unsigned int block,
+		      struct ubifs_data_node *dn)
+{
+	struct ubifs_info *c = inode->i_sb->s_fs_info;
+	union ubifs_key key;
+	int err;
+
+	data_key_init(c, &key, inode->i_ino, block);
+	err = ubifs_tnc_lookup(c, &key, dn);
+	if (err) {
+		if (err == -ENOENT)
+			/* Not found, so it must be a hole */
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+		return err;
+	}
+
+	return unpack_block(c, inode, addr, block, dn);
+}
+
+/**
+ * bulk_read() - Read a run of full blocks with one LEB read
+ *
+ * This looks up the data nodes from @block onwards which follow each other in
+ * the same LEB, reads them in one go and decompresses them to @addr. Holes
+ * between them are zeroed.
+ *
+ * @c: UBIFS file-system description object
+ * @inode: Inode to read from
+ * @addr: Buffer for the data
+ * @block: First block to read
+ * @max_blocks: Maximum number of blocks to read into @addr
+ * Return: number of blocks read, 0 if there are not enough consecutive data
+ *	nodes to be worth it, or -ve on error
+ */
+static int bulk_read(struct ubifs_info *c, struct inode *inode, void *addr,
+		     unsigned int block, int max_blocks)
+{
+	struct bu_info *bu = &c->bu;
+	int err, i, n, blk_cnt;
+	void *buf;
+
+	if (!c->bulk_read || max_blocks < 2)
+		return 0;
+
+	mutex_lock(&c->bu_mutex);
+	data_key_init(c, &bu->key, inode->i_ino, block);
+	bu->buf_len = c->max_bu_buf_len;
+	err = ubifs_tnc_get_bu_keys(c, bu);
+	if (err)
+		goto out;
+	blk_cnt = min(bu->blk_cnt, max_blocks);
+	if (bu->cnt < 2 || blk_cnt < 2 ||
+	    key_block(c, &bu->zbranch[0].key) != block)
+		goto out;
+
+	err = ubifs_tnc_bulk_read(c, bu);
+	if (err)
+		goto out;
+
+	buf = bu->buf;
+	for (n = 0, i = 0; n < blk_cnt; n++, addr += UBIFS_BLOCK_SIZE) {
+		if (i >= bu->cnt ||
+		    key_block(c, &bu->zbranch[i].key) != block + n) {
+			memset(addr, 0, UBIFS_BLOCK_SIZE);
+			continue;
+		}
+		err = unpack_block(c, inode, addr, block + n, buf);
+		if (err)
+			goto out;
+		buf += ALIGN(bu->zbranch[i++].len, 8);
+	}
+	err = blk_cnt;
+out:
+	mutex_unlock(&c->bu_mutex);
+
+	return err;
+}
+
 static int do_readpage(struct ubifs_info *c, struct inode *inode,
 		       struct page *page, int last_block_size)
 {
@@ -889,7 +957,7 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	struct inode *inode;
 	struct page page;
 	int err = 0;
-	int i;
+	int i, n;
 	int count;
 	int last_block_size = 0;
 
@@ -943,19 +1011,30 @@ int ubifs_read(const char *filename, void *buf, loff_t offset,
 	page.addr = buf;
 	page.index = offset / PAGE_SIZE;
 	page.inode = inode;
-	for (i = 0; i < count; i++) {
-		/*
-		 * Make sure to not read beyond the requested size
-		 */
-		if (((i + 1) == count) && (size < inode->i_size))
-			last_block_size = size - (i * PAGE_SIZE);
-
-		err = do_readpage(c, inode, &page, last_block_size);
-		if (err)
+	for (i = 0; i < count; i += n) {
+		/* The last block may be partial, so is never bulk-read */
+		n = bulk_read(c, inode, page.addr,
+			      page.index << UBIFS_BLOCKS_PER_PAGE_SHIFT,
+			      count - i - 1);
+		if (n < 0) {
+			err = n;
 			break;
+		}
+		if (!n) {
+			/*
+			 * Make sure to not read beyond the requested size
+			 */
+			if (((i + 1) == count) && (size < inode->i_size))
+				last_block_size = size - (i * PAGE_SIZE);
+
+			err = do_readpage(c, inode, &page, last_block_size);
+			if (err)
+				break;
+			n = 1;
+		}
 
-		page.addr += PAGE_SIZE;
-		page.index++;
+		page.addr += n * PAGE_SIZE;
+		page.index += n;
 	}
 
 	if (err) {
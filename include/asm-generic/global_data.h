@@ -156,6 +156,12 @@ struct global_data {
 	 * @env_buf: buffer for env_get() before reloc
 	 */
 	char env_buf[32];
+#if CONFIG_IS_ENABLED(ENV_F_INDEX)
+	/**
+	 * @env_f_index: sorted index of the environment used before reloc
+	 */
+	struct env_f_index *env_f_index;
+#endif
 #endif /* ENV_SUPPORT */
 	/**
 	 * @fdt_src: Source of FDT
@@ -430,6 +436,12 @@ struct global_data {
 	 */
 	struct event_state event_state;
 #endif
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+	/**
+	 * @event_stats: counts and times for events and device probes
+	 */
+	struct event_stats *event_stats;
+#endif
 #if CONFIG_IS_ENABLED(CYCLIC)
 	/**
 	 * @cyclic_list: list of registered cyclic functions
@@ -9,11 +9,13 @@
 #include <../lib/libavb/libavb.h>
 #include <mapmem.h>
 #include <mmc.h>
+#include <part.h>
 
 #define AVB_MAX_ARGS			1024
 #define VERITY_TABLE_OPT_RESTART	"restart_on_corruption"
 #define VERITY_TABLE_OPT_LOGGING	"ignore_corruption"
 #define ALLOWED_BUF_ALIGN		8
+#define AVB_MAX_PRELOADED		4
 
 enum avb_boot_state {
 	AVB_GREEN,
@@ -22,10 +24,25 @@ enum avb_boot_state {
 	AVB_RED,
 };
 
+/**
+ * struct avb_preloaded_part - partition already loaded into memory
+ *
+ * @name: Partition name, including any slot suffix
+ * @addr: Where the partition contents are
+ * @size: Number of bytes loaded
+ */
+struct avb_preloaded_part {
+	char name[PART_NAME_LEN];
+	u8 *addr;
+	size_t size;
+};
+
 struct AvbOpsData {
 	struct AvbOps ops;
 	int mmc_dev;
 	enum avb_boot_state boot_state;
+	struct avb_preloaded_part preloaded[AVB_MAX_PRELOADED];
+	int num_preloaded;
 #ifdef CONFIG_OPTEE_TA_AVB
 	struct udevice *tee;
 	u32 session;
@@ -46,6 +63,8 @@ enum mmc_io_type {
 
 AvbOps *avb_ops_alloc(int boot_device);
 void avb_ops_free(AvbOps *ops);
+int avb_add_preloaded_partition(AvbOps *ops, const char *partition,
+				void *addr, size_t size);
 
 char *avb_set_state(AvbOps *ops, enum avb_boot_state boot_state);
 char *avb_set_enforce_verity(const char *cmdline);
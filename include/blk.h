@@ -80,6 +80,9 @@ struct blk_desc {
 		uint32_t mbr_sig;	/* MBR integer signature */
 		efi_guid_t guid_sig;	/* GPT GUID Signature */
 	};
+#if CONFIG_IS_ENABLED(PART_CACHE)
+	struct part_cache *part_cache;	/* entries read from the table */
+#endif
 #if CONFIG_IS_ENABLED(BLK)
 	/*
 	 * For now we have a few functions which take struct blk_desc as a
@@ -149,6 +152,64 @@ void blkcache_fill(int iftype, int dev,
  */
 void blkcache_invalidate(int iftype, int dev);
 
+/**
+ * blkcache_generation() - get the number of cache invalidations so far
+ *
+ * This changes whenever blkcache_invalidate() is called, i.e. on any write
+ * to a block device or when a device is (re)initialised. Anything read from
+ * a device while this stays the same is still valid.
+ *
+ * Return: invalidation count
+ */
+ulong blkcache_generation(void);
+
+/**
+ * blkcache_readahead_start() - check whether to read ahead
+ *
+ * This is called on a cache miss. If the read follows on from the previous
+ * one on the same device, a read-ahead buffer is returned which the caller
+ * should fill by reading *@countp blocks from @start, then call
+ * blkcache_readahead_done().
+ *
+ * @param iftype - uclass_id_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number of the read
+ * @param blkcnt - number of blocks to read
+ * @param blksz - size in bytes of each block
+ * @param countp - on entry, the number of blocks available on the device from
+ *	@start; on exit, the number of blocks to read into the buffer
+ * Return: buffer to read into, or NULL to read the blocks normally
+ */
+void *blkcache_readahead_start(int iftype, int dev, lbaint_t start,
+			       lbaint_t blkcnt, unsigned long blksz,
+			       lbaint_t *countp);
+
+/**
+ * blkcache_readahead_done() - record the result of reading ahead
+ *
+ * @param iftype - uclass_id_x for type of device
+ * @param dev - device index of particular type
+ * @param start - starting block number held in the read-ahead buffer
+ * @param blkcnt - number of blocks successfully read, 0 on error
+ * @param blksz - size in bytes of each block
+ */
+void blkcache_readahead_done(int iftype, int dev, lbaint_t start,
+			     lbaint_t blkcnt, unsigned long blksz);
+
+/**
+ * blkcache_readahead_configure() - set the read-ahead window
+ *
+ * @param size - size of the window in bytes, 0 to disable read-ahead
+ */
+void blkcache_readahead_configure(ulong size);
+
+/**
+ * blkcache_readahead_size() - get the read-ahead window
+ *
+ * Return: size of the window in bytes, 0 if read-ahead is disabled
+ */
+ulong blkcache_readahead_size(void);
+
 /**
  * blkcache_configure() - configure block cache
  *
@@ -163,18 +224,45 @@ void blkcache_configure(unsigned blocks, unsigned entries);
 struct block_cache_stats {
 	unsigned hits;
 	unsigned misses;
+	unsigned evictions;
 	unsigned entries; /* current entry count */
 	unsigned max_blocks_per_entry;
 	unsigned max_entries;
 };
 
+/*
+ * per-device statistics of the block cache
+ */
+struct block_cache_dev_stats {
+	int iftype;
+	int devnum;
+	unsigned hits;
+	unsigned misses;
+	unsigned evictions;
+	unsigned entries; /* current entry count */
+};
+
 /**
  * get_blkcache_stats() - return statistics and reset
  *
+ * This also resets the hit, miss and eviction counters of each device
+ *
  * @param stats - statistics are copied here
  */
 void blkcache_stats(struct block_cache_stats *stats);
 
+/**
+ * blkcache_dev_stats() - return statistics for a device
+ *
+ * Devices are known to the cache once data has been cached for them. The
+ * counters are reset by blkcache_stats() so call this first.
+ *
+ * @param seq - index of the device in the cache, starting at 0
+ * @param stats - statistics are copied here
+ * Return: 0 if OK, -ENOENT if there is no device with that index
+ */
+int blkcache_dev_stats(int seq, struct block_cache_dev_stats *stats);
+
 /** blkcache_free() - free all memory allocated to the block cache */
 void blkcache_free(void);
 
@@ -191,8 +279,25 @@ static inline void blkcache_fill(int iftype, int dev,
 				 lbaint_t start, lbaint_t blkcnt,
 				 unsigned long blksz, void const *buffer) {}
 
+static inline void *blkcache_readahead_start(int iftype, int dev,
+					     lbaint_t start, lbaint_t blkcnt,
+					     unsigned long blksz,
+					     lbaint_t *countp)
+{
+	return NULL;
+}
+
+static inline void blkcache_readahead_done(int iftype, int dev,
+					   lbaint_t start, lbaint_t blkcnt,
+					   unsigned long blksz) {}
+
 static inline void blkcache_invalidate(int iftype, int dev) {}
 
+static inline ulong blkcache_generation(void)
+{
+	return 0;
+}
+
 static inline void blkcache_free(void) {}
 
 #endif
@@ -200,6 +305,30 @@ static inline void blkcache_free(void) {}
 struct udevice;
 
 /* Operations on block devices */
+/**
+ * struct blk_req - an asynchronous block read
+ *
+ * Set up by blk_read_submit(). Must not be changed by the caller or reused
+ * until blk_req_poll() or blk_req_wait() reports that it is complete.
+ *
+ * @dev: Block device being read
+ * @start: Start block for the read
+ * @blkcnt: Number of blocks to read
+ * @buffer: Place to put the data
+ * @done: Number of blocks read, or -ve on error; valid once @complete is set
+ * @complete: true once the read has finished
+ * @priv: For use by the driver while the read is in progress
+ */
+struct blk_req {
+	struct udevice *dev;
+	lbaint_t start;
+	lbaint_t blkcnt;
+	void *buffer;
+	long done;
+	bool complete;
+	void *priv;
+};
+
 struct blk_ops {
 	/**
 	 * read() - read from a block device
@@ -258,6 +387,33 @@ struct blk_ops {
 	 */
 	int (*select_hwpart)(struct udevice *dev, int hwpart);
 
+	/**
+	 * read_submit() - start reading from a block device
+	 *
+	 * Starts the read described by @req and returns without waiting for
+	 * it to finish. The driver may finish it early, setting req->done
+	 * and req->complete itself.
+	 *
+	 * @dev:	Device to read from
+	 * @req:	Read to start, with @start, @blkcnt and @buffer set
+	 * @return 0 if OK, -ENOSYS to have the read done synchronously
+	 *	instead, other -ve on error
+	 */
+	int (*read_submit)(struct udevice *dev, struct blk_req *req);
+
+	/**
+	 * req_poll() - check progress of a read started by read_submit()
+	 *
+	 * This must not wait for the read to finish, but may move it along,
+	 * e.g. by starting the next transfer once the previous is done.
+	 *
+	 * @dev:	Device being read
+	 * @req:	Read to check
+	 * @return 0 if the read has finished, with req->done set, -EBUSY if
+	 *	it is still in progress
+	 */
+	int (*req_poll)(struct udevice *dev, struct blk_req *req);
+
 #if IS_ENABLED(CONFIG_BOUNCE_BUFFER)
 	/**
 	 * buffer_aligned() - test memory alignment of block operation buffer
@@ -307,6 +463,45 @@ unsigned long blk_derase(struct blk_desc *block_dev, lbaint_t start,
 long blk_read(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
 	      void *buffer);
 
+/**
+ * blk_read_submit() - Start reading from a block device
+ *
+ * This starts a read and returns, if possible before it has finished, so
+ * that the caller can do other work meanwhile. Use blk_req_poll() or
+ * blk_req_wait() to find out when it is done. Only one read can be in
+ * progress at a time on each device; a further read (of either kind)
+ * waits for it to finish first.
+ *
+ * Devices without support for this, or when CONFIG_BLK_ASYNC is not
+ * enabled, complete the read before returning.
+ *
+ * @dev: Device to read from
+ * @start: Start block for the read
+ * @blkcnt: Number of blocks to read
+ * @buf: Place to put the data, which must stay valid until the read is done
+ * @req: Returns the request, to be passed to blk_req_poll()
+ * Return: 0 if OK, -ve on error
+ */
+int blk_read_submit(struct udevice *dev, lbaint_t start, lbaint_t blkcnt,
+		    void *buf, struct blk_req *req);
+
+/**
+ * blk_req_poll() - Check whether a read started by blk_read_submit() is done
+ *
+ * @req: Request to check
+ * Return: 0 if the read has finished (see @req->done), -EBUSY if not
+ */
+int blk_req_poll(struct blk_req *req);
+
+/**
+ * blk_req_wait() - Wait for a read started by blk_read_submit() to finish
+ *
+ * @req: Request to wait for
+ * Return: number of blocks read (which may be less than requested), or -ve
+ * on error
+ */
+long blk_req_wait(struct blk_req *req);
+
 /**
  * blk_write() - Write to a block device
  *
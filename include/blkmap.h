@@ -65,6 +65,24 @@ int blkmap_map_mem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 int blkmap_map_pmem(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
 		    phys_addr_t paddr);
 
+/**
+ * blkmap_map_pmem_cow() - Map region of physical memory, copy-on-write
+ *
+ * Like blkmap_map_pmem(), but writes never reach the mapped memory.
+ * Written blocks are kept in private copies instead, so an image that
+ * has been loaded into memory can be modified without changing the
+ * image itself or copying all of it first. The copies are freed when
+ * the blkmap is destroyed.
+ *
+ * @dev: Blkmap to create the mapping on
+ * @blknr: Start block number of the mapping
+ * @blkcnt: Number of blocks to map
+ * @paddr: The target physical memory address of the mapping
+ * Returns: 0 on success, negative error code on failure
+ */
+int blkmap_map_pmem_cow(struct udevice *dev, lbaint_t blknr, lbaint_t blkcnt,
+			phys_addr_t paddr);
+
 /**
  * blkmap_from_label() - Find blkmap from label
  *
@@ -30,6 +30,10 @@ struct board_f {
 	 * @new_bloblist: relocated blob list information
 	 */
 	struct bloblist_hdr *new_bloblist;
+	/**
+	 * @new_event_stats: relocated event and probe counts
+	 */
+	struct event_stats *new_event_stats;
 };
 
 #endif
@@ -321,6 +321,23 @@ int bootdev_hunt(const char *spec, bool show);
  */
 int bootdev_hunt_prio(enum bootdev_prio_t prio, bool show);
 
+/**
+ * bootdev_hunt_stop() - Stop hunting for bootdevs in the background
+ *
+ * With CONFIG_BOOTSTD_HUNT_ASYNC, a scan runs the hunters in a task while it
+ * looks at the bootdevs already found. This waits for the hunter which the
+ * task is running, if any, then stops the task, so that nothing is using the
+ * hardware when the scan ends or the OS is booted. Any hunters not yet run
+ * are left for the next scan.
+ */
+#if CONFIG_IS_ENABLED(BOOTSTD_HUNT_ASYNC)
+void bootdev_hunt_stop(void);
+#else
+static inline void bootdev_hunt_stop(void)
+{
+}
+#endif
+
 /**
  * bootdev_unhunt() - Mark a device as needing to be hunted again
  *
@@ -285,6 +285,35 @@ void bootflow_iter_uninit(struct bootflow_iter *iter);
 int bootflow_iter_drop_bootmeth(struct bootflow_iter *iter,
 				const struct udevice *bmeth);
 
+/**
+ * bootflow_scan_last() - find the bootflow which was booted last time
+ *
+ * This looks up the bootflow recorded in the bootflow_last environment
+ * variable by bootflow_boot(), trying just that bootdev, partition and
+ * bootmeth. It fails if the partition UUID has changed since then.
+ *
+ * @iter:	Place to store private info (inited by this call, even on
+ *	error)
+ * @flags:	Flags for iterator (enum bootflow_iter_flags_t). If this
+ *	includes BOOTFLOWIF_HUNT, hunters with the bootdev's priority are run
+ *	if it is not found
+ * @bflow:	Place to put the bootflow if found
+ * Return: 0 if found, -ENOENT if nothing is recorded, -ESTALE if the partition
+ *	has changed, other -ve if the bootflow could not be found
+ */
+#if CONFIG_IS_ENABLED(BOOTSTD_LAST_BOOTFLOW)
+int bootflow_scan_last(struct bootflow_iter *iter, int flags,
+		       struct bootflow *bflow);
+#else
+static inline int bootflow_scan_last(struct bootflow_iter *iter, int flags,
+				     struct bootflow *bflow)
+{
+	bootflow_iter_init(iter, flags);
+
+	return -ENOSYS;
+}
+#endif
+
 /**
  * bootflow_scan_first() - find the first bootflow for a device or label
  *
@@ -456,6 +456,78 @@ static inline int bootstage_init(bool first)
 
 #endif /* ENABLE_BOOTSTAGE */
 
+/**
+ * enum bootstage_span_cat - Category of a bootstage span
+ *
+ * @BOOTSTAGE_SPAN_USER: Span added by other code
+ * @BOOTSTAGE_SPAN_INITCALL: Initcall, or event sent by an init sequence
+ * @BOOTSTAGE_SPAN_PROBE: Probe of a device
+ */
+enum bootstage_span_cat {
+	BOOTSTAGE_SPAN_USER,
+	BOOTSTAGE_SPAN_INITCALL,
+	BOOTSTAGE_SPAN_PROBE,
+
+	BOOTSTAGE_SPAN_CAT_COUNT,
+};
+
+#ifndef USE_HOSTCC
+#include <linux/errno.h>
+
+#if defined(ENABLE_BOOTSTAGE) && CONFIG_IS_ENABLED(BOOTSTAGE_SPANS)
+/**
+ * bootstage_span_begin() - Start a span of boot activity
+ *
+ * The span becomes the parent of any span started before this one ends.
+ * Spans must be ended in the reverse order they were started.
+ *
+ * @cat: Category of the span
+ * @name: Name of the span, or NULL to use @addr
+ * @addr: Address of the code the span covers, e.g. an initcall, used as the
+ *	name if @name is NULL
+ * Return: span number, or -ENOENT if bootstage is not set up, or -ENOSPC if
+ *	there is no space left to record it
+ */
+int bootstage_span_begin(enum bootstage_span_cat cat, const char *name,
+			 ulong addr);
+
+/**
+ * bootstage_span_end() - Finish a span of boot activity
+ *
+ * @span: Span number returned by bootstage_span_begin(). If this is an error
+ *	code, nothing is done
+ */
+void bootstage_span_end(int span);
+#else
+static inline int bootstage_span_begin(enum bootstage_span_cat cat,
+				       const char *name, ulong addr)
+{
+	return -ENOSYS;
+}
+
+static inline void bootstage_span_end(int span)
+{
+}
+#endif
+#endif /* !USE_HOSTCC */
+
+/**
+ * bootstage_export_json() - Write the bootstage data in Chrome trace format
+ *
+ * This produces a JSON object which can be loaded into Perfetto or
+ * chrome://tracing. Each span is a complete ('X') event carrying the number
+ * of its parent, and each mark is an instant ('i') event. Accumulated times
+ * are listed in 'otherData'.
+ *
+ * @buf: Buffer to write to; the output is always nul-terminated if @size is
+ *	not 0
+ * @size: Size of the buffer in bytes, which may be 0 to find out how much is
+ *	needed
+ * Return: length of the output, not counting the nul terminator; if this is
+ *	@size or more, the output was truncated
+ */
+int bootstage_export_json(char *buf, int size);
+
 /* helpers for SPL */
 int _bootstage_stash_default(void);
 int _bootstage_unstash_default(void);
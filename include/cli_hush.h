@@ -15,6 +15,20 @@
 #if CONFIG_IS_ENABLED(HUSH_OLD_PARSER)
 extern int u_boot_hush_start(void);
 extern int parse_string_outer(const char *str, int flag);
+
+/**
+ * parse_buffer_outer() - Run commands from a buffer
+ *
+ * This is like parse_string_outer() but the commands need not be
+ * nul-terminated, so they can be run from where they are, e.g. in a script
+ * image
+ *
+ * @buf: Commands to run
+ * @len: Number of bytes in @buf
+ * @flag: FLAG_... flags
+ * Return: 0 if OK, else the return code of the command which failed
+ */
+int parse_buffer_outer(const char *buf, int len, int flag);
 extern int parse_file_outer(void);
 int set_local_var(const char *s, int flg_export);
 #else
@@ -28,6 +42,11 @@ static inline int parse_string_outer(const char *str, int flag)
 	return 1;
 }
 
+static inline int parse_buffer_outer(const char *buf, int len, int flag)
+{
+	return 1;
+}
+
 static inline int parse_file_outer(void)
 {
 	return 0;
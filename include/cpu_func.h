@@ -70,6 +70,110 @@ void invalidate_dcache_range(unsigned long start, unsigned long stop);
 void invalidate_dcache_all(void);
 void invalidate_icache_all(void);
 
+/*
+ * Cache maintenance without waiting for completion, for use by
+ * dcache_batch_sync(). The default versions are the same as
+ * flush_dcache_range() and invalidate_dcache_range(), and
+ * dcache_range_sync() does nothing.
+ */
+void flush_dcache_range_nosync(unsigned long start, unsigned long stop);
+void invalidate_dcache_range_nosync(unsigned long start, unsigned long stop);
+void dcache_range_sync(void);
+
+/* Number of ranges of each type which a struct dcache_batch can hold */
+#define DCACHE_BATCH_RANGES	8
+
+/**
+ * struct dcache_batch - Ranges of memory waiting for cache maintenance
+ *
+ * A driver which sets up several descriptors and buffers for DMA can add each
+ * to a batch, then call dcache_batch_sync() before starting the DMA. Adjacent
+ * and overlapping ranges are merged, and only one barrier is needed for the
+ * whole batch.
+ *
+ * @flush: Ranges to clean and invalidate, each [start, end)
+ * @inval: Ranges to invalidate, each [start, end)
+ * @num_flush: Number of ranges in @flush
+ * @num_inval: Number of ranges in @inval
+ */
+struct dcache_batch {
+	struct dcache_batch_range {
+		ulong start;
+		ulong end;
+	} flush[DCACHE_BATCH_RANGES], inval[DCACHE_BATCH_RANGES];
+	int num_flush;
+	int num_inval;
+};
+
+#if CONFIG_IS_ENABLED(DCACHE_BATCH)
+
+/**
+ * dcache_batch_init() - Set up an empty batch
+ *
+ * @batch: Batch to set up
+ */
+void dcache_batch_init(struct dcache_batch *batch);
+
+/**
+ * dcache_batch_flush() - Add a range to clean and invalidate
+ *
+ * The range is expanded to whole cache lines. If the batch is full, the
+ * maintenance which is already queued is done first.
+ *
+ * @batch: Batch to add to
+ * @start: Start address
+ * @stop: End address (exclusive)
+ */
+void dcache_batch_flush(struct dcache_batch *batch, ulong start, ulong stop);
+
+/**
+ * dcache_batch_invalidate() - Add a range to invalidate
+ *
+ * See dcache_batch_flush()
+ *
+ * @batch: Batch to add to
+ * @start: Start address
+ * @stop: End address (exclusive)
+ */
+void dcache_batch_invalidate(struct dcache_batch *batch, ulong start,
+			     ulong stop);
+
+/**
+ * dcache_batch_sync() - Do the cache maintenance for a batch
+ *
+ * This does the maintenance for each range, then waits once for it all to
+ * complete. If the ranges to flush add up to at least
+ * CONFIG_DCACHE_BATCH_FLUSH_ALL_SIZE, the whole cache is flushed instead,
+ * which is quicker for large buffers. The batch is left empty.
+ *
+ * @batch: Batch to sync
+ */
+void dcache_batch_sync(struct dcache_batch *batch);
+
+#else
+
+static inline void dcache_batch_init(struct dcache_batch *batch)
+{
+}
+
+static inline void dcache_batch_flush(struct dcache_batch *batch, ulong start,
+				      ulong stop)
+{
+	flush_dcache_range(start, stop);
+}
+
+static inline void dcache_batch_invalidate(struct dcache_batch *batch,
+					   ulong start, ulong stop)
+{
+	invalidate_dcache_range(start, stop);
+}
+
+static inline void dcache_batch_sync(struct dcache_batch *batch)
+{
+}
+
+#endif
+
 enum {
 	/* Disable caches (else flush caches but leave them active) */
 	CBL_DISABLE_CACHES		= 1 << 0,
@@ -0,0 +1,187 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * eMMC Command Queue Host Controller Interface (CQHCI)
+ *
+ * Register and descriptor layout follow JESD84-B51 Appendix B.
+ */
+
+#ifndef __CQHCI_H
+#define __CQHCI_H
+
+#include <blk.h>
+#include <linux/bitops.h>
+#include <linux/types.h>
+
+struct mmc;
+
+/* Registers, relative to the start of the CQHCI block */
+#define CQHCI_VER		0x00
+#define CQHCI_CAP		0x04
+#define CQHCI_CFG		0x08
+#define  CQHCI_DCMD		BIT(12)
+#define  CQHCI_TASK_DESC_SZ	BIT(8)
+#define  CQHCI_ENABLE		BIT(0)
+#define CQHCI_CTL		0x0c
+#define  CQHCI_CLEAR_ALL_TASKS	BIT(8)
+#define  CQHCI_HALT		BIT(0)
+#define CQHCI_IS		0x10
+#define  CQHCI_IS_HAC		BIT(0)
+#define  CQHCI_IS_TCC		BIT(1)
+#define  CQHCI_IS_RED		BIT(2)
+#define  CQHCI_IS_TCL		BIT(3)
+#define  CQHCI_IS_GCE		BIT(4)
+#define  CQHCI_IS_ICCE		BIT(5)
+#define  CQHCI_IS_ERR		(CQHCI_IS_RED | CQHCI_IS_GCE | CQHCI_IS_ICCE)
+#define  CQHCI_IS_MASK		(CQHCI_IS_HAC | CQHCI_IS_TCC | CQHCI_IS_TCL | \
+				 CQHCI_IS_ERR)
+#define CQHCI_ISTE		0x14
+#define CQHCI_ISGE		0x18
+#define CQHCI_IC		0x1c
+#define CQHCI_TDLBA		0x20
+#define CQHCI_TDLBAU		0x24
+#define CQHCI_TDBR		0x28
+#define CQHCI_TCN		0x2c
+#define CQHCI_DQS		0x30
+#define CQHCI_DPT		0x34
+#define CQHCI_TCLR		0x38
+#define CQHCI_SSC1		0x40
+#define CQHCI_SSC2		0x44
+#define CQHCI_CRDCT		0x48
+#define CQHCI_RMEM		0x50
+#define CQHCI_TERRI		0x54
+#define CQHCI_CRI		0x58
+#define CQHCI_CRA		0x5c
+
+/* Descriptor attribute fields, shared by task and transfer descriptors */
+#define CQHCI_VALID		BIT(0)
+#define CQHCI_END		BIT(1)
+#define CQHCI_INT		BIT(2)
+#define CQHCI_ACT(x)		(((x) & 0x7) << 3)
+#define  CQHCI_ACT_TRAN		0x4
+#define  CQHCI_ACT_TASK		0x5
+#define  CQHCI_ACT_LINK		0x6
+
+/* Task descriptor fields */
+#define CQHCI_FORCED_PROG	BIT(6)
+#define CQHCI_DATA_DIR		BIT(12)	/* 1 = read */
+#define CQHCI_BLK_COUNT(x)	(((u64)(x) & 0xffff) << 16)
+#define CQHCI_BLK_ADDR(x)	(((u64)(x) & 0xffffffff) << 32)
+
+/* Transfer and link descriptor fields (32-bit addressing) */
+#define CQHCI_DAT_LENGTH(x)	(((u64)(x) & 0xffff) << 16)
+#define CQHCI_DAT_ADDR(x)	(((u64)(x) & 0xffffffff) << 32)
+
+#define CQHCI_NUM_SLOTS		32
+/* Transfer descriptors per task and the data each one moves */
+#define CQHCI_MAX_SEGS		16
+#define CQHCI_SEG_BLOCKS	64
+#define CQHCI_TASK_BLOCKS	(CQHCI_MAX_SEGS * CQHCI_SEG_BLOCKS)
+
+/**
+ * struct cqhci_xfer - a transfer in progress on a command queue engine
+ *
+ * @start:	First block of the transfer
+ * @blkcnt:	Number of blocks in the transfer
+ * @queued:	Number of blocks handed to the engine so far
+ * @addr:	Physical address of the buffer
+ * @buf:	Buffer being transferred to or from
+ * @busy:	Slots with a task still queued
+ * @last:	Time in microseconds when a task last completed
+ * @write:	true if writing to the card
+ */
+struct cqhci_xfer {
+	lbaint_t start;
+	lbaint_t blkcnt;
+	lbaint_t queued;
+	ulong addr;
+	void *buf;
+	u32 busy;
+	ulong last;
+	bool write;
+};
+
+/**
+ * struct cqhci_host - state of a command queue engine
+ *
+ * @base:	Start of the CQHCI register block
+ * @mmc:	MMC device which owns the engine
+ * @num_slots:	Number of task slots in use, limited by the card queue depth
+ * @desc:	Task descriptor list; each slot holds a task descriptor
+ *		followed by a link to its transfer descriptors
+ * @trans:	Transfer descriptors, CQHCI_MAX_SEGS per slot
+ * @xfer:	Transfer in progress, if any
+ */
+struct cqhci_host {
+	void __iomem *base;
+	struct mmc *mmc;
+	int num_slots;
+	u64 *desc;
+	u64 *trans;
+	struct cqhci_xfer xfer;
+};
+
+/**
+ * cqhci_init() - set up a command queue engine
+ *
+ * Allocates the descriptor lists. The engine stays disabled until
+ * cqhci_enable() is called.
+ *
+ * @cq:		Engine to set up
+ * @mmc:	MMC device which owns the engine
+ * @base:	Start of the CQHCI register block
+ * Return: 0 if OK, -ENOMEM if out of memory, -EINVAL if the descriptors
+ * cannot be reached with 32-bit addressing
+ */
+int cqhci_init(struct cqhci_host *cq, struct mmc *mmc, void __iomem *base);
+
+/**
+ * cqhci_enable() - hand the bus over to the command queue engine
+ *
+ * The card must already be in command queue mode. No commands may be sent
+ * through the host's normal command path until cqhci_disable() is called.
+ *
+ * @cq:		Engine to enable
+ * Return: 0 if OK, -ve on error
+ */
+int cqhci_enable(struct cqhci_host *cq);
+
+/**
+ * cqhci_disable() - stop the command queue engine
+ *
+ * Any tasks still queued (after an error) are discarded.
+ *
+ * @cq:		Engine to disable
+ * Return: 0 if OK, -ETIMEDOUT if the engine did not halt
+ */
+int cqhci_disable(struct cqhci_host *cq);
+
+/**
+ * cqhci_xfer_start() - start a transfer through the command queue engine
+ *
+ * The transfer is split into tasks of up to CQHCI_TASK_BLOCKS blocks and as
+ * many of them as there are slots are queued. Use cqhci_xfer_poll() to keep
+ * the slots busy until all have completed.
+ *
+ * @cq:		Engine to use, which must be enabled and idle
+ * @start:	First block to transfer
+ * @blkcnt:	Number of blocks to transfer
+ * @buf:	Buffer to transfer to or from; must be cache-line aligned and
+ *		lie in the low 4GiB
+ * @write:	true to write to the card, false to read from it
+ * Return: 0 if OK, -EINVAL if @buf cannot be used
+ */
+int cqhci_xfer_start(struct cqhci_host *cq, lbaint_t start, lbaint_t blkcnt,
+		     void *buf, bool write);
+
+/**
+ * cqhci_xfer_poll() - move a transfer along without waiting
+ *
+ * Reaps completed tasks and queues further ones in the freed slots.
+ *
+ * @cq:		Engine with a transfer started by cqhci_xfer_start()
+ * Return: 0 once the transfer has completed, -EBUSY while it is still in
+ * progress, -EIO or -ETIMEDOUT if it failed
+ */
+int cqhci_xfer_poll(struct cqhci_host *cq);
+
+#endif /* __CQHCI_H */
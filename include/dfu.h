@@ -341,6 +341,21 @@ int dfu_read(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
  */
 int dfu_write(struct dfu_entity *de, void *buf, int size, int blk_seq_num);
 
+/**
+ * dfu_write_direct() - write to dfu entity without buffering
+ *
+ * Write the contents of @buf straight to the medium at the current offset,
+ * in chunks of at most the DFU buffer size, without copying it into the DFU
+ * buffer. @buf must be aligned to ARCH_DMA_MINALIGN. This may be called
+ * repeatedly; after the last call use dfu_flush() as with dfu_write().
+ *
+ * @de:			dfu entity
+ * @buf:		buffer
+ * @size:		size of buffer
+ * Return:		0 for success, negative value for error
+ */
+int dfu_write_direct(struct dfu_entity *de, void *buf, long size);
+
 /**
  * dfu_flush() - flush to dfu entity
  *
@@ -427,6 +442,9 @@ static inline void dfu_set_defer_flush(struct dfu_entity *dfu)
  * This function adds support for writing data starting from fixed memory
  * address (like $loadaddr) to dfu managed medium (e.g. NAND, MMC, file system)
  *
+ * If @buf is aligned to ARCH_DMA_MINALIGN the data is written from there
+ * directly, rather than being copied through the DFU buffer.
+ *
  * @dfu:	dfu entity to which we want to store data
  * @buf:	fixed memory address from where data starts
  * @size:	number of bytes to write
@@ -230,6 +230,13 @@ void device_free(struct udevice *dev);
 static inline void device_free(struct udevice *dev) {}
 #endif
 
+/*
+ * With DM_ARENA, a device and the plat data allocated for it when it is bound
+ * share one block: the struct udevice followed by the driver's plat, the
+ * uclass plat and the parent plat, each rounded up to DM_ALLOC_ALIGN bytes
+ */
+#define DM_ALLOC_ALIGN		(2 * sizeof(size_t))
+
 /**
  * device_chld_unbind() - Unbind all device's children from the device if bound
  *			  to drv
@@ -12,6 +12,25 @@
 #include <dm/ofnode.h>
 #include <dm/uclass-id.h>
 
+struct udevice_id;
+
+/**
+ * struct dm_compat_entry - Compatible string handled by a driver
+ *
+ * With DM_COMPAT_TABLE the build generates an array of these, sorted by
+ * compatible string and then in linker-list order.
+ *
+ * @compat: Compatible string
+ * @drv: Driver whose match table contains the string
+ */
+struct dm_compat_entry {
+	const char *compat;
+	struct driver *drv;
+};
+
+extern const struct dm_compat_entry dm_compat_table[];
+extern const int dm_compat_table_count;
+
 /**
  * lists_driver_lookup_name() - Return u_boot_driver corresponding to name
  *
@@ -23,6 +42,21 @@
  */
 struct driver *lists_driver_lookup_name(const char *name);
 
+/**
+ * lists_driver_lookup_compat() - Find the driver for a compatible string
+ *
+ * This returns the first driver, in linker-list order, whose match table
+ * contains the string. With DM_COMPAT_TABLE the lookup searches the table
+ * generated at build time, and with DM_COMPAT_INDEX it uses a hash table
+ * once U-Boot has relocated.
+ *
+ * @compat: Compatible string to look up
+ * @idp: Returns the matching entry of the driver's match table
+ * Return: pointer to driver, or NULL if not found
+ */
+struct driver *lists_driver_lookup_compat(const char *compat,
+					  const struct udevice_id **idp);
+
 /**
  * lists_uclass_lookup() - Return uclass_driver based on ID of the class
  *
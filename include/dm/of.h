@@ -17,12 +17,14 @@ typedef u32 phandle;
  *
  * @name: Property name
  * @length: Length of property in bytes
+ * @hash: Hash of @name, see of_prop_hash()
  * @value: Pointer to property value
  * @next: Pointer to next property, or NULL if none
  */
 struct property {
 	char *name;
 	int length;
+	u32 hash;
 	void *value;
 	struct property *next;
 };
@@ -79,6 +79,18 @@ int of_simple_addr_cells(const struct device_node *np);
  */
 int of_simple_size_cells(const struct device_node *np);
 
+/**
+ * of_prop_hash() - hash a property name
+ *
+ * Each property records the hash of its name, so that of_find_property()
+ * only needs to compare names whose hashes match. This is the 32-bit FNV-1a
+ * hash, which scripts/gen_live_tree.py also uses.
+ *
+ * @name: Property name
+ * Return: hash of @name
+ */
+u32 of_prop_hash(const char *name);
+
 /**
  * of_find_property() - find a property in a node
  *
@@ -51,6 +51,48 @@ struct driver_rt {
 	struct udevice *dev;
 };
 
+/**
+ * struct dm_hot_plat - platform data generated for a device in U-Boot proper
+ *
+ * dtoc creates a table of these in dt-hot.c, sorted by @of_offset, for the
+ * drivers selected by CONFIG_OF_PLATDATA_HOT_DRIVERS
+ *
+ * @of_offset: Offset of the device's node in the devicetree dtoc was given
+ * @name: Name of the driver the data is for
+ * @plat: Pointer to the struct dtd_... holding the data
+ */
+struct dm_hot_plat {
+	int of_offset;
+	const char *name;
+	const void *plat;
+};
+
+struct udevice;
+
+#if CONFIG_IS_ENABLED(OF_PLATDATA_HOT)
+extern const struct dm_hot_plat dm_hot_plat[];
+extern const int dm_hot_plat_count;
+extern const int dm_hot_plat_fdt_size;
+
+/**
+ * dev_get_hot_plat() - Get the platform data which dtoc generated for a device
+ *
+ * This allows a driver to fill in its platform data without reading the
+ * devicetree. Phandles in the data hold the devicetree offset of the target
+ * node, rather than an index as in SPL.
+ *
+ * @dev: Device to check
+ * Return: pointer to the struct dtd_... for the device, or NULL if there is
+ * none, or the control devicetree is not the one it was generated from
+ */
+const void *dev_get_hot_plat(const struct udevice *dev);
+#else
+static inline const void *dev_get_hot_plat(const struct udevice *dev)
+{
+	return NULL;
+}
+#endif
+
 /*
  * NOTE: Avoid using these except in extreme circumstances, where device tree
  * is not feasible (e.g. serial driver in SPL where <8KB of SRAM is
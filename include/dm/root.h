@@ -10,6 +10,7 @@
 #define _DM_ROOT_H_
 
 #include <dm/tag.h>
+#include <dm/uclass-id.h>
 
 struct udevice;
 
@@ -171,6 +172,48 @@ int dm_remove_devices_flags(uint flags);
 static inline int dm_remove_devices_flags(uint flags) { return 0; }
 #endif
 
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/**
+ * dm_lazy_set_uclasses() - Set which uclasses are bound only when needed
+ *
+ * This affects later scans of the devicetree, not nodes already put off.
+ * dm_init() sets the list from CONFIG_DM_LAZY_BIND_UCLASSES.
+ *
+ * @names: Space-separated list of uclass names
+ * Return: 0 if OK, -ENOENT if a name is not known
+ */
+int dm_lazy_set_uclasses(const char *names);
+
+/**
+ * dm_lazy_bind_uclass() - Bind the subtrees which may hold devices in a uclass
+ *
+ * This is called when a uclass is looked up, so that the devicetree nodes
+ * whose binding was put off are bound before it is used.
+ *
+ * @id: Uclass being looked up
+ */
+void dm_lazy_bind_uclass(enum uclass_id id);
+
+/**
+ * dm_lazy_bind_all() - Bind all the subtrees whose binding was put off
+ */
+void dm_lazy_bind_all(void);
+
+/**
+ * dm_lazy_drop_parent() - Forget the subtrees which would be bound to a device
+ *
+ * This is called when @parent is unbound.
+ *
+ * @parent: Device being unbound, or NULL to forget all of them
+ */
+void dm_lazy_drop_parent(struct udevice *parent);
+#else
+static inline int dm_lazy_set_uclasses(const char *names) { return 0; }
+static inline void dm_lazy_bind_uclass(enum uclass_id id) {}
+static inline void dm_lazy_bind_all(void) {}
+static inline void dm_lazy_drop_parent(struct udevice *parent) {}
+#endif
+
 /**
  * dm_get_stats() - Get some stats for driver mode
  *
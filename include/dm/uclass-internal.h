@@ -329,6 +329,18 @@ static inline int uclass_pre_remove_device(struct udevice *dev) { return 0; }
  */
 int uclass_get_count(void);
 
+/**
+ * uclass_get_no_lazy() - Get a uclass, without binding devices put off for it
+ *
+ * This is uclass_get() for use when binding a device, which does not need
+ * the devices whose binding was put off by DM_LAZY_BIND.
+ *
+ * @id:		ID to look up
+ * @ucp:	Returns pointer to uclass (there is only one per ID)
+ * Return: 0 if OK, -ve on error
+ */
+int uclass_get_no_lazy(enum uclass_id id, struct uclass **ucp);
+
 /**
  * uclass_find() - Find uclass by its id
  *
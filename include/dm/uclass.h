@@ -30,12 +30,23 @@
  * @dev_head: List of devices in this uclass (devices are attached to their
  * uclass when their bind method is called)
  * @sibling_node: Next uclass in the linked list of uclasses
+ * @node_idx: Hash table of the devices with a devicetree node, by node, or
+ * NULL if there is none (do not access outside driver model)
+ * @phandle_idx: Hash table of the same devices, by phandle
+ * @idx_size: Number of slots in each table, a power of two
+ * @idx_count: Number of devices in @node_idx
  */
 struct uclass {
 	void *priv_;
 	struct uclass_driver *uc_drv;
 	struct list_head dev_head;
 	struct list_head sibling_node;
+#if CONFIG_IS_ENABLED(DM_UCLASS_INDEX)
+	struct udevice **node_idx;
+	struct udevice **phandle_idx;
+	uint idx_size;
+	uint idx_count;
+#endif
 };
 
 struct driver;
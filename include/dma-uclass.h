@@ -134,6 +134,28 @@ struct dma_ops {
 	 */
 	int (*transfer)(struct udevice *dev, int direction, dma_addr_t dst,
 			dma_addr_t src, size_t len);
+	/**
+	 * transfer_start() - Start a DMA transfer without waiting for it.
+	 *   Only one transfer is outstanding at a time. Optional; if it is
+	 *   not provided, transfer() is used instead.
+	 *
+	 * @dev: The DMA device
+	 * @direction: direction of data transfer (should be one from
+	 *   enum dma_direction)
+	 * @dst: The destination pointer.
+	 * @src: The source pointer.
+	 * @len: Length of the data to be copied (number of bytes).
+	 * @return zero on success, or -ve error code.
+	 */
+	int (*transfer_start)(struct udevice *dev, int direction,
+			      dma_addr_t dst, dma_addr_t src, size_t len);
+	/**
+	 * transfer_wait() - Wait for a transfer started by transfer_start()
+	 *
+	 * @dev: The DMA device
+	 * @return zero on success, or -ve error code.
+	 */
+	int (*transfer_wait)(struct udevice *dev);
 };
 
 #endif /* _DMA_UCLASS_H */
@@ -11,6 +11,7 @@
 
 #include <linux/bitops.h>
 #include <linux/errno.h>
+#include <linux/string.h>
 #include <linux/types.h>
 
 struct udevice;
@@ -342,4 +343,77 @@ static inline int dma_memcpy(void *dst, void *src, size_t len)
 	return -ENOSYS;
 }
 #endif /* CONFIG_DMA */
+
+/**
+ * struct dma_copy - a bulk copy which may be running in the background
+ *
+ * @dev: DMA device doing the copy, or NULL if it is already complete
+ * @dst: Destination buffer
+ * @src: Source buffer
+ * @len: Number of bytes to copy
+ */
+struct dma_copy {
+	struct udevice *dev;
+	void *dst;
+	void *src;
+	size_t len;
+};
+
+#if CONFIG_IS_ENABLED(DMA_BULK_COPY)
+/**
+ * dma_copy_start() - start copying a buffer, with DMA if worthwhile
+ *
+ * Copies of at least CONFIG_DMA_BULK_COPY_THRESHOLD bytes between
+ * non-overlapping, cache-aligned buffers are handed to the first DMA device
+ * that supports memory-to-memory transfers. Anything else is copied with
+ * memmove() before this function returns. The caller may do other work, as long as it does
+ * not touch either buffer, then must call dma_copy_wait().
+ *
+ * @copy: Copy to set up
+ * @dst: Destination buffer
+ * @src: Source buffer
+ * @len: Number of bytes to copy
+ */
+void dma_copy_start(struct dma_copy *copy, void *dst, const void *src,
+		    size_t len);
+
+/**
+ * dma_copy_wait() - wait for a copy started by dma_copy_start()
+ *
+ * If the DMA transfer fails, the copy is redone with memcpy(), so the
+ * destination always holds the data when this returns.
+ *
+ * @copy: Copy to wait for
+ */
+void dma_copy_wait(struct dma_copy *copy);
+#else
+static inline void dma_copy_start(struct dma_copy *copy, void *dst,
+				  const void *src, size_t len)
+{
+	memmove(dst, src, len);
+	copy->dev = NULL;
+}
+
+static inline void dma_copy_wait(struct dma_copy *copy)
+{
+}
+#endif
+
+/**
+ * dma_bulk_copy() - copy a buffer, with DMA if worthwhile
+ *
+ * This is dma_copy_start() followed by dma_copy_wait(), so it can be used in
+ * place of memmove().
+ *
+ * @dst: Destination buffer
+ * @src: Source buffer
+ * @len: Number of bytes to copy
+ */
+static inline void dma_bulk_copy(void *dst, const void *src, size_t len)
+{
+	struct dma_copy copy;
+
+	dma_copy_start(&copy, dst, src, len);
+	dma_copy_wait(&copy);
+}
 #endif	/* _DMA_H_ */
@@ -6,8 +6,11 @@
 #ifndef __DT_STRUCTS
 #define __DT_STRUCTS
 
-/* These structures may only be used in SPL */
-#if CONFIG_IS_ENABLED(OF_PLATDATA)
+/*
+ * These structures may only be used in SPL, or in U-Boot proper for the
+ * drivers selected by OF_PLATDATA_HOT
+ */
+#if CONFIG_IS_ENABLED(OF_PLATDATA) || CONFIG_IS_ENABLED(OF_PLATDATA_HOT)
 struct driver_info;
 
 /**
@@ -52,8 +55,12 @@ struct phandle_2_arg {
 	int arg[2];
 };
 
+#if CONFIG_IS_ENABLED(OF_PLATDATA)
 #include <generated/dt-structs-gen.h>
 #include <generated/dt-decl.h>
+#else
+#include <generated/dt-structs-hot.h>
+#endif
 #endif
 
 #endif
@@ -274,6 +274,7 @@ extern const efi_guid_t efi_guid_host_dev;
 #endif
 /* GUID of the EFI_BLOCK_IO_PROTOCOL */
 extern const efi_guid_t efi_block_io_guid;
+extern const efi_guid_t efi_block_io2_guid;
 extern const efi_guid_t efi_global_variable_guid;
 extern const efi_guid_t efi_guid_console_control;
 extern const efi_guid_t efi_guid_device_path;
@@ -626,7 +627,7 @@ void efi_timer_check(void);
 efi_status_t efi_check_pe(void *buffer, size_t size, void **nt_header);
 /* PE loader implementation */
 efi_status_t efi_load_pe(struct efi_loaded_image_obj *handle,
-			 void *efi, size_t efi_size,
+			 void *efi, size_t efi_size, bool in_place,
 			 struct efi_loaded_image *loaded_image_info);
 /* Called once to store the pristine gd pointer */
 void efi_save_gd(void);
@@ -806,6 +807,8 @@ efi_status_t efi_driver_init(void);
 int efi_disk_probe(void *ctx, struct event *event);
 /* Called when a block device is removed */
 int efi_disk_remove(void *ctx, struct event *event);
+/* Called by efi_timer_check() to complete EFI_BLOCK_IO2 requests */
+void efi_disk_check_io(void);
 /* Called by board init to initialize the EFI memory map */
 int efi_memory_init(void);
 /* Adds new or overrides configuration table entry to the system table */
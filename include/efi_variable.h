@@ -145,6 +145,27 @@ struct efi_var_file {
  */
 efi_status_t efi_var_to_file(void);
 
+/**
+ * efi_var_file_sync() - persist non-volatile variables after a change
+ *
+ * The file is written immediately unless CONFIG_EFI_VARIABLE_FILE_STORE_DELAY
+ * is set, in which case the write is deferred until efi_var_file_check()
+ * finds the delay expired or efi_var_file_flush() is called.
+ *
+ * Return:	status code
+ */
+efi_status_t efi_var_file_sync(void);
+
+/**
+ * efi_var_file_flush() - write out deferred changes of non-volatile variables
+ */
+void efi_var_file_flush(void);
+
+/**
+ * efi_var_file_check() - write out deferred changes once the delay expired
+ */
+void efi_var_file_check(void);
+
 /**
  * efi_var_collect() - collect variables in buffer
  *
@@ -204,6 +204,51 @@ extern struct hsearch_data env_htab;
  */
 int env_do_env_set(int flag, int argc, char *const argv[], int env_flag);
 
+/**
+ * env_journal_load() - Replay the journal which follows the environment
+ *
+ * This is called once the environment has been imported from storage. It
+ * applies each valid record, then remembers the resulting environment, so
+ * that the next save can write only the changes.
+ *
+ * @buf: Contents of the journal
+ * @size: Size of the journal in bytes
+ * @seed: CRC of the environment which was imported
+ * Return: number of records replayed, or -ENOMEM if out of memory
+ */
+int env_journal_load(const void *buf, uint size, u32 seed);
+
+/**
+ * env_journal_reset() - Note that the whole environment has been saved
+ *
+ * This must be called once the environment has been written out from
+ * env_export(), which also erases the journal
+ *
+ * @seed: CRC of the environment which was written
+ */
+void env_journal_reset(u32 seed);
+
+/**
+ * env_journal_add() - Get a record of the changes since the last save
+ *
+ * Once the record is written, call env_journal_added()
+ *
+ * @size: Size of the journal in bytes
+ * @recp: Returns the record, which the caller must free
+ * @offsetp: Returns the offset in the journal at which to write the record
+ * Return: size of the record in bytes, 0 if nothing has changed, -ENOSPC if
+ *	the whole environment must be saved instead, e.g. because the journal
+ *	is full, -ENOMEM if out of memory
+ */
+int env_journal_add(uint size, void **recp, uint *offsetp);
+
+/**
+ * env_journal_added() - Note that a record has been written
+ *
+ * @rec_size: Size of the record, as returned by env_journal_add()
+ */
+void env_journal_added(uint rec_size);
+
 /**
  * env_ext4_get_intf() - Provide the interface for env in EXT4
  *
@@ -0,0 +1,137 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Counts and times for events and device probes
+ *
+ * These are cheap enough to leave enabled in production builds: recording
+ * an event or a probe is an increment and an addition in a fixed table.
+ */
+
+#ifndef __EVENT_STATS_H
+#define __EVENT_STATS_H
+
+#include <event.h>
+#include <dm/uclass-id.h>
+#include <linux/types.h>
+
+struct udevice;
+
+/**
+ * struct event_stat - count and time for one thing being measured
+ *
+ * @count: Number of times it happened
+ * @time_us: Total time taken, in microseconds
+ */
+struct event_stat {
+	u32 count;
+	u32 time_us;
+};
+
+/**
+ * struct event_stats - all the counts and times
+ *
+ * This holds no pointers, so it can be copied when U-Boot relocates.
+ *
+ * @event: Events sent, indexed by enum event_t; the time is that taken by
+ *	all the spies for the event
+ * @uclass: Devices probed, indexed by enum uclass_id
+ * @num_drivers: Number of entries in @driver
+ * @driver: Devices probed, indexed by the position of the driver in the
+ *	driver linker list
+ */
+struct event_stats {
+	struct event_stat event[EVT_COUNT];
+	struct event_stat uclass[UCLASS_COUNT];
+	int num_drivers;
+	struct event_stat driver[];
+};
+
+#if CONFIG_IS_ENABLED(EVENT_STATS)
+/**
+ * event_stats_start() - Get the start time for something to be measured
+ *
+ * Return: current time in microseconds, or 0 if the timer is not yet ready,
+ * in which case only the count is recorded
+ */
+ulong event_stats_start(void);
+
+/**
+ * event_stats_add_event() - Record that an event was sent
+ *
+ * @type: Event type
+ * @start: Value returned by event_stats_start() before the event was sent
+ */
+void event_stats_add_event(enum event_t type, ulong start);
+
+/**
+ * event_stats_add_probe() - Record that a device was probed
+ *
+ * The time includes probing the device's parents and anything else needed by
+ * the device, so a bus shows the time for the first device on it as well
+ *
+ * @dev: Device which was probed
+ * @start: Value returned by event_stats_start() before the probe started
+ */
+void event_stats_add_probe(struct udevice *dev, ulong start);
+
+/**
+ * event_stats_get() - Get the counts and times
+ *
+ * Return: stats, or NULL if nothing has been recorded yet
+ */
+struct event_stats *event_stats_get(void);
+
+/**
+ * event_stats_reset() - Set all the counts and times back to zero
+ */
+void event_stats_reset(void);
+
+/**
+ * event_stats_get_size() - Get the size of the stats table
+ *
+ * Return: number of bytes needed for the table
+ */
+int event_stats_get_size(void);
+
+/**
+ * event_stats_relocate() - Move the stats to a new place
+ *
+ * This is used when U-Boot relocates, since the table is allocated before
+ * relocation, in memory which may not be available afterwards
+ *
+ * @to: Where to put the stats; must be at least event_stats_get_size() bytes
+ */
+void event_stats_relocate(void *to);
+#else
+static inline ulong event_stats_start(void)
+{
+	return 0;
+}
+
+static inline void event_stats_add_event(enum event_t type, ulong start)
+{
+}
+
+static inline void event_stats_add_probe(struct udevice *dev, ulong start)
+{
+}
+
+static inline struct event_stats *event_stats_get(void)
+{
+	return NULL;
+}
+
+static inline void event_stats_reset(void)
+{
+}
+
+static inline int event_stats_get_size(void)
+{
+	return 0;
+}
+
+static inline void event_stats_relocate(void *to)
+{
+}
+#endif
+
+#endif
@@ -104,6 +104,8 @@ struct expo_theme {
  * type set to EXPOACT_NONE if there is no action
  * @text_mode: true to use text mode for the menu (no vidconsole)
  * @popup: true to use popup menus, instead of showing all items
+ * @drawn_id: ID of the scene currently shown on the display, or 0 if the
+ *	display must be redrawn in full (CONFIG_EXPO_PARTIAL_REDRAW)
  * @priv: Private data for the controller
  * @theme: Information about fonts styles, etc.
  * @scene_head: List of scenes
@@ -118,6 +120,7 @@ struct expo {
 	struct expo_action action;
 	bool text_mode;
 	bool popup;
+	uint drawn_id;
 	void *priv;
 	struct expo_theme theme;
 	struct list_head scene_head;
@@ -230,6 +233,9 @@ enum {
  * @flags: Flags for this object
  * @bit_length: Number of bits used for this object in CMOS RAM
  * @start_bit: Start bit to use for this object in CMOS RAM
+ * @drawn: Area of the display covered when this object was last rendered,
+ *	with a width of 0 if it was not (CONFIG_EXPO_PARTIAL_REDRAW)
+ * @drawn_sig: Signature of the object's state when it was last rendered
  * @sibling: Node to link this object to its siblings
  */
 struct scene_obj {
@@ -241,6 +247,8 @@ struct scene_obj {
 	u8 flags;
 	u8 bit_length;
 	u16 start_bit;
+	struct scene_dim drawn;
+	u32 drawn_sig;
 	struct list_head sibling;
 };
 
@@ -479,6 +487,17 @@ int expo_first_scene_id(struct expo *exp);
  */
 int expo_render(struct expo *exp);
 
+/**
+ * expo_redraw() - Make the next render redraw the whole display
+ *
+ * With CONFIG_EXPO_PARTIAL_REDRAW, expo_render() only redraws the objects
+ * which have changed. Call this if something else has drawn on the display,
+ * so that the next render starts from scratch.
+ *
+ * @exp: Expo to update
+ */
+void expo_redraw(struct expo *exp);
+
 /**
  * expo_set_text_mode() - Controls whether the expo renders in text mode
  *
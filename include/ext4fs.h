@@ -30,11 +30,15 @@
 
 struct disk_partition;
 
+#define EXT4_ENCRYPT_FL		0x00000800 /* Encrypted inode */
 #define EXT4_INDEX_FL		0x00001000 /* Inode uses hash tree index */
 #define EXT4_TOPDIR_FL		0x00020000 /* Top of directory hierarchies*/
 #define EXT4_EXTENTS_FL		0x00080000 /* Inode uses extents */
+#define EXT4_CASEFOLD_FL	0x40000000 /* Casefolded directory */
 #define EXT4_EXT_MAGIC			0xf30a
 
+#define EXT4_FEATURE_COMPAT_DIR_INDEX	0x0020
+
 #define EXT4_FEATURE_RO_COMPAT_SPARSE_SUPER  0x0001
 #define EXT4_FEATURE_RO_COMPAT_LARGE_FILE    0x0002
 #define EXT4_FEATURE_RO_COMPAT_BTREE_DIR     0x0004
@@ -165,12 +169,18 @@ struct ext_filesystem {
 	int curr_inode_no;
 	uint16_t first_pass_ibmap;
 
+	/* Bitmaps changed since loading, EXT4_BMAP_DIRTY_... per group */
+	u8 *bmap_dirty;
+
 	/* Journal Related */
 
 	/* Block Device Descriptor */
 	struct blk_desc *dev_desc;
 };
 
+#define EXT4_BMAP_DIRTY_BLOCK	0x1
+#define EXT4_BMAP_DIRTY_INODE	0x2
+
 struct ext_block_cache {
 	char *buf;
 	lbaint_t block;
@@ -209,6 +219,8 @@ int ext4fs_devread(lbaint_t sector, int byte_offset, int byte_len, char *buf);
 void ext4fs_set_blk_dev(struct blk_desc *rbdd, struct disk_partition *info);
 long int read_allocated_block(struct ext2_inode *inode, int fileblock,
 			      struct ext_block_cache *cache);
+long int read_allocated_run(struct ext2_inode *inode, int fileblock, int max,
+			    int *countp, struct ext_block_cache *cache);
 int ext4fs_probe(struct blk_desc *fs_dev_desc,
 		 struct disk_partition *fs_partition);
 int ext4_read_file(const char *filename, void *buf, loff_t offset, loff_t len,
@@ -51,6 +51,7 @@ enum {
 	FASTBOOT_COMMAND_OEM_RUN,
 	FASTBOOT_COMMAND_OEM_CONSOLE,
 	FASTBOOT_COMMAND_OEM_BOARD,
+	FASTBOOT_COMMAND_OEM_STREAM,
 	FASTBOOT_COMMAND_ACMD,
 	FASTBOOT_COMMAND_UCMD,
 	FASTBOOT_COMMAND_COUNT
@@ -163,6 +164,16 @@ int fastboot_handle_command(char *cmd_string, char *response);
  */
 u32 fastboot_data_remaining(void);
 
+/**
+ * fastboot_data_rate() - return the speed of the last download
+ *
+ * This runs from the download command to the end of the data, so it includes
+ * the time taken to write a download which is flashed as it arrives.
+ *
+ * Return: Bytes per second, or 0 if there has been no download
+ */
+u32 fastboot_data_rate(void);
+
 /**
  * fastboot_data_download() - Copy image data to fastboot_buf_addr.
  *
@@ -177,6 +188,22 @@ u32 fastboot_data_remaining(void);
 void fastboot_data_download(const void *fastboot_data,
 			    unsigned int fastboot_data_len, char *response);
 
+/**
+ * fastboot_data_stream_buf() - Find where streamed data goes next
+ *
+ * When the current download is written to flash as it arrives, data is
+ * held in one half of the download buffer while the other half is written.
+ * A transport may receive data straight into the buffer, at the place this
+ * returns, and then pass that pointer to fastboot_data_download(), which
+ * does not copy it.
+ *
+ * @len: Number of bytes about to be passed to fastboot_data_download()
+ * @size: Returns the space available at the returned pointer
+ * Return: Where data goes after those @len bytes, or NULL if the current
+ *	download is not being streamed
+ */
+void *fastboot_data_stream_buf(u32 len, u32 *size);
+
 /**
  * fastboot_data_complete() - Mark current transfer complete
  *
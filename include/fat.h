@@ -25,7 +25,11 @@ struct disk_partition;
 #define DIRENTSPERCLUST	((mydata->clust_size * mydata->sect_size) / \
 			 sizeof(dir_entry))
 
+#ifdef CONFIG_XPL_BUILD
 #define FATBUFBLOCKS	6
+#else
+#define FATBUFBLOCKS	CONFIG_FS_FAT_BUF_SECTORS
+#endif
 #define FATBUFSIZE	(mydata->sect_size * FATBUFBLOCKS)
 #define FAT12BUFSIZE	((FATBUFSIZE*2)/3)
 #define FAT16BUFSIZE	(FATBUFSIZE/2)
@@ -39,4 +39,37 @@ void fastboot_mmc_flash_write(const char *cmd, void *download_buffer,
  * @response: Pointer to fastboot response buffer
  */
 void fastboot_mmc_erase(const char *cmd, char *response);
+
+/**
+ * fastboot_mmc_stream_start() - Prepare to write an image as it arrives
+ *
+ * @cmd: Named partition to write image to, which must stay valid until
+ *	fastboot_mmc_stream_end() is called
+ * @size: Size of the image, in bytes
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error
+ */
+int fastboot_mmc_stream_start(const char *cmd, u32 size, char *response);
+
+/**
+ * fastboot_mmc_stream_write() - Write the next part of a streamed image
+ *
+ * @buf: Pointer to image data. If @len is not a whole number of blocks this
+ *	must be the last part, and @buf must have room to pad it to one.
+ * @len: Size of the data
+ * @response: Pointer to fastboot response buffer
+ * Return: 0 if OK, -ve on error
+ */
+int fastboot_mmc_stream_write(void *buf, u32 len, char *response);
+
+/**
+ * fastboot_mmc_stream_end() - Finish writing a streamed image
+ *
+ * This must be called after fastboot_mmc_stream_start(), even if writing
+ * failed, to free resources. It writes OKAY to @response if the whole image
+ * was written.
+ *
+ * @response: Pointer to fastboot response buffer
+ */
+void fastboot_mmc_stream_end(char *response);
 #endif
@@ -150,6 +150,22 @@ int fs_size(const char *filename, loff_t *size);
 int fs_read(const char *filename, ulong addr, loff_t offset, loff_t len,
 	    loff_t *actread);
 
+/**
+ * fs_read_max() - read a whole file, if it is not too large
+ *
+ * This is the same as fs_size() followed by fs_read(), but the partition only
+ * has to be set up once, by fs_set_blk_dev(), beforehand.
+ *
+ * @filename:	full path of the file to read from
+ * @addr:	address of the buffer to write to
+ * @max_len:	maximum number of bytes which may be written to @addr
+ * @actread:	returns the actual number of bytes read
+ * Return:	0 if OK with valid *actread, -ENOSPC if the file is larger than
+ *	@max_len, other non-zero value on other error
+ */
+int fs_read_max(const char *filename, ulong addr, loff_t max_len,
+		loff_t *actread);
+
 /**
  * fs_write() - write file to the partition previously set by fs_set_blk_dev()
  *
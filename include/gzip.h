@@ -10,6 +10,7 @@
 #include <linux/types.h>
 
 struct blk_desc;
+struct gunzip_stream;
 
 /**
  * gzip_parse_header() - Parse a header from a gzip file
@@ -49,6 +50,66 @@ int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp);
 int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 	   int stoponerr, int offset);
 
+/**
+ * gunzip_stream_start() - Start decompressing gzipped data piece by piece
+ *
+ * The compressed data is then passed to gunzip_stream_feed() in pieces of
+ * any size, as it becomes available, and the output written directly to
+ * @dst.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * Return: stream state, or NULL if out of memory
+ */
+struct gunzip_stream *gunzip_stream_start(void *dst, ulong dstlen);
+
+/**
+ * gunzip_stream_feed() - Decompress the next piece of gzipped data
+ *
+ * Anything following the end of the compressed data is ignored.
+ *
+ * @gs: Stream state from gunzip_stream_start()
+ * @src: Next piece of compressed data
+ * @len: Length of data at @src
+ * Return: 0 if more data is needed, 1 if the end of the compressed data has
+ * been reached, -ENOSPC if the destination buffer is full, -EIO if the data
+ * is corrupt
+ */
+int gunzip_stream_feed(struct gunzip_stream *gs, const void *src, ulong len);
+
+/**
+ * gunzip_stream_open() - Start decompressing gzipped data held in memory
+ *
+ * Unlike gunzip_stream_start(), all the compressed data is available up front
+ * and the output is taken piece by piece with gunzip_stream_read(), so that
+ * it can be processed without a buffer for the whole output.
+ *
+ * @src: Gzipped data
+ * @len: Length of data at @src
+ * Return: stream state, or NULL if the header is invalid or out of memory
+ */
+struct gunzip_stream *gunzip_stream_open(const void *src, ulong len);
+
+/**
+ * gunzip_stream_read() - Decompress the next piece of a stream
+ *
+ * @gs: Stream state from gunzip_stream_open()
+ * @dst: Destination for uncompressed data
+ * @len: Number of bytes to write to @dst
+ * Return: 0 if OK, -EIO if the data is corrupt or ends before @len bytes have
+ * been produced
+ */
+int gunzip_stream_read(struct gunzip_stream *gs, void *dst, ulong len);
+
+/**
+ * gunzip_stream_end() - Finish decompressing and free the stream state
+ *
+ * @gs: Stream state from gunzip_stream_start()
+ * @sizep: Returns the number of bytes written to the destination buffer
+ * Return: 0 if OK, -EIO if the end of the compressed data was not reached
+ */
+int gunzip_stream_end(struct gunzip_stream *gs, ulong *sizep);
+
 /**
  * gzwrite progress indicators: defined weak to allow board-specific
  * overrides:
@@ -88,6 +88,12 @@ struct hash_algo {
  *
  * This common function is used to implement specific hash commands.
  *
+ * @algo_name may list several algorithms separated by commas, and @argv may
+ * hold several "address count" pairs. Each region is then read once, with
+ * every algorithm updated from each chunk in turn. An optional final
+ * argument gives a comma-separated destination (or expected hash, with
+ * HASH_FLAG_VERIFY) for each algorithm of each region, in that order.
+ *
  * @algo_name:		Hash algorithm being used (lower case!)
  * @flags:		Flags value (HASH_FLAG_...)
  * @cmdtp:		Pointer to command table entry
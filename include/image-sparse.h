@@ -26,6 +26,15 @@ struct sparse_storage {
 				 lbaint_t blk,
 				 lbaint_t blkcnt);
 
+	/*
+	 * Optional: make blocks read back as zero without sending the data,
+	 * e.g. by an erase. Returns the number of blocks zeroed; anything
+	 * less than blkcnt makes the caller write zeroes instead.
+	 */
+	lbaint_t	(*write_zeroes)(struct sparse_storage *info,
+					lbaint_t blk,
+					lbaint_t blkcnt);
+
 	void		(*mssg)(const char *str, char *response);
 };
 
@@ -42,3 +51,45 @@ static inline int is_sparse_image(void *buf)
 
 int write_sparse_image(struct sparse_storage *info, const char *part_name,
 		       void *data, char *response);
+
+struct sparse_stream;
+
+/**
+ * sparse_stream_start() - Start writing a sparse image as it is received
+ *
+ * Unlike write_sparse_image() the image does not need to be in memory all at
+ * once. It is passed to sparse_stream_write() in pieces of any size, in
+ * order, and sparse_stream_end() is called after the last one.
+ *
+ * @info: Storage to write to, which must stay valid until the end
+ * @part_name: Name of the partition, which must stay valid until the end
+ * @response: Pointer to response buffer, passed to @info->mssg on error
+ * Return: stream state, or NULL if out of memory
+ */
+struct sparse_stream *sparse_stream_start(struct sparse_storage *info,
+					  const char *part_name,
+					  char *response);
+
+/**
+ * sparse_stream_write() - Write the next piece of a sparse image
+ *
+ * RAW data is written directly from @data where possible, so @data may be
+ * reused once this returns. Data after the last chunk is ignored.
+ *
+ * @ss: Stream state from sparse_stream_start()
+ * @data: Next bytes of the image
+ * @len: Number of bytes at @data
+ * @response: Pointer to response buffer, passed to @info->mssg on error
+ * Return: 0 if OK, -1 on error, after which the rest of the image is ignored
+ */
+int sparse_stream_write(struct sparse_stream *ss, void *data, uint32_t len,
+			char *response);
+
+/**
+ * sparse_stream_end() - Finish writing a sparse image and free @ss
+ *
+ * @ss: Stream state from sparse_stream_start()
+ * @response: Pointer to response buffer, passed to @info->mssg on error
+ * Return: 0 if the whole image was written, -1 otherwise
+ */
+int sparse_stream_end(struct sparse_stream *ss, char *response);
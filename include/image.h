@@ -1062,6 +1062,7 @@ int booti_setup(ulong image, ulong *relocated_addr, ulong *size,
 
 #define FIT_IMAGES_PATH		"/images"
 #define FIT_CONFS_PATH		"/configurations"
+#define FIT_COMPAT_INDEX_PROP	"compat-index"
 
 /* hash/signature/key node */
 #define FIT_HASH_NODENAME	"hash"
@@ -1285,6 +1286,22 @@ struct image_summary {
 	char keydest_path[NODE_MAX_NAME_LEN];
 };
 
+/**
+ * fit_add_compat_index() - add an index of configurations by compatible
+ *
+ * Adds a "compat-index" property to the configurations node, listing each
+ * compatible string of each configuration followed by the configuration's
+ * name, in the order of the configurations. fit_conf_find_compat() uses
+ * this to find a configuration without searching each one in turn.
+ * Configurations without compatible strings, e.g. with a compressed FDT,
+ * are left out.
+ *
+ * @fit:	Pointer to the FIT format image header
+ * Return: 0 on success, -ENOSPC if the FIT needs more space, other -ve on
+ *	error
+ */
+int fit_add_compat_index(void *fit);
+
 /**
  * fit_add_verification_data() - add verification data to FIT image nodes
  *
@@ -1296,11 +1313,14 @@ struct image_summary {
  * @engine_id:	Engine to use for signing
  * @cmdname:	Command name used when reporting errors
  * @algo_name:	Algorithm name, or NULL if to be read from FIT
+ * @jobs:	Number of threads to calculate image hashes with
  * @summary:	Returns information about what data was written
  *
  * Adds hash values for all component images in the FIT blob.
  * Hashes are calculated for all component images which have hash subnodes
  * with algorithm property set to one of the supported hash algorithms.
+ * With more than one job they are calculated in parallel; the result is the
+ * same.
  *
  * Also add signatures if signature nodes are present.
  *
@@ -1312,7 +1332,7 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary);
+			      int jobs, struct image_summary *summary);
 
 /**
  * fit_image_verify_with_data() - Verify an image with given data
@@ -1327,6 +1347,70 @@ int fit_image_verify_with_data(const void *fit, int image_noffset,
 			       const void *key_blob, const void *data,
 			       size_t size);
 
+/* Most hashes of one image that fit_image_hash_stream_start() handles */
+#define FIT_HASH_STREAM_MAX	4
+
+/**
+ * struct fit_hash_stream - Hashes of an image being calculated piecewise
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @image_noffset: Offset in @fit of the image being checked
+ * @count:	Number of hash nodes
+ * @noffset:	Offset in @fit of each hash node
+ * @algo:	Algorithm for each hash node
+ * @ctx:	Progressive hashing context for each hash node, NULL if the
+ *		node is to be ignored
+ */
+struct fit_hash_stream {
+	const void *fit;
+	int image_noffset;
+	int count;
+	int noffset[FIT_HASH_STREAM_MAX];
+	struct hash_algo *algo[FIT_HASH_STREAM_MAX];
+	void *ctx[FIT_HASH_STREAM_MAX];
+};
+
+/**
+ * fit_image_hash_stream_start() - Start verifying an image piece by piece
+ *
+ * This does the same checks as fit_image_verify_with_data() but with the
+ * data provided in pieces, e.g. as it is read from storage. It is not
+ * possible when the image must be checked against a signature, or when a
+ * hash algorithm lacks progressive support, in which case the image must be
+ * checked in one go instead.
+ *
+ * @fit:	Pointer to the FIT format image header
+ * @image_noffset: Offset in @fit of image to verify
+ * @key_blob:	FDT containing public keys
+ * @hs:		Returns the hashing state
+ * Return: 0 if OK, -ENOTSUPP if the image must be verified in one go
+ */
+int fit_image_hash_stream_start(const void *fit, int image_noffset,
+				const void *key_blob,
+				struct fit_hash_stream *hs);
+
+/**
+ * fit_image_hash_stream_update() - Add the next piece of image data
+ *
+ * @hs:		Hashing state
+ * @data:	Next piece of image data
+ * @size:	Size of data at @data
+ */
+void fit_image_hash_stream_update(struct fit_hash_stream *hs,
+				  const void *data, size_t size);
+
+/**
+ * fit_image_hash_stream_finish() - Check the hashes of the whole image
+ *
+ * This frees the hashing state, so must be called once the hashing has been
+ * started, even if the image is not wanted after all.
+ *
+ * @hs:		Hashing state
+ * Return: 1 if all hashes are valid, 0 otherwise (like
+ * fit_image_verify_with_data())
+ */
+int fit_image_hash_stream_finish(struct fit_hash_stream *hs);
+
 int fit_image_verify(const void *fit, int noffset);
 #if CONFIG_IS_ENABLED(FIT_SIGNATURE)
 int fit_config_verify(const void *fit, int conf_noffset);
@@ -1399,10 +1483,30 @@ int fit_check_format(const void *fit, ulong size);
  * copied into the configuration node in the FIT image. This is required to
  * match configurations with compressed FDTs.
  *
+ * If the configurations node has a "compat-index" property, as written by
+ * ``mkimage -I``, that is used to find the configuration without looking at
+ * each one.
+ *
  * Returns: offset to the configuration to use if one was found, -1 otherwise
  */
 int fit_conf_find_compat(const void *fit, const void *fdt);
 
+/**
+ * fit_conf_get_compat_node() - find the compatible strings for a configuration
+ *
+ * These are in the configuration node itself if it has a "compatible"
+ * property, else in the root node of its (uncompressed) FDT.
+ *
+ * @fit: pointer to the FIT format image header
+ * @images_noffset: offset of the images node
+ * @noffset: offset of the configuration node
+ * @fdtp: returns the device tree holding the strings
+ * Return: offset in *@fdtp of the node with the "compatible" property, or
+ *	-ENOENT if there is none
+ */
+int fit_conf_get_compat_node(const void *fit, int images_noffset,
+			     int noffset, const void **fdtp);
+
 /**
  * fit_conf_get_node - get node offset for configuration of a given unit name
  * @fit: pointer to the FIT format image header
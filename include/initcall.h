@@ -8,6 +8,7 @@
 
 #include <asm/types.h>
 #include <event.h>
+#include <linker_lists.h>
 
 _Static_assert(EVT_COUNT < 256, "Can only support 256 event types with 8 bits");
 
@@ -35,4 +36,95 @@ typedef int (*init_fnc_t)(void);
  */
 int initcall_run_list(const init_fnc_t init_sequence[]);
 
+/**
+ * struct initcall_async - Hardware set-up which runs alongside other init
+ *
+ * Some hardware spends a long time waiting, e.g. for an eMMC to power up or
+ * a link to train. An asynchronous initcall starts it off and is then polled
+ * between other initcalls, and from schedule() once the command line is
+ * running, until it is done. Code which needs the hardware calls
+ * initcall_async_join() first.
+ *
+ * Use INITCALL_ASYNC() to declare one.
+ *
+ * @name: Name of the initcall
+ * @after: Name of an initcall which must be done before this one starts, or
+ *	NULL if none. If that one fails, this one is not started and fails
+ *	with -ENODEV
+ * @start: Start the hardware off. Return: 0 if OK, -ve on error, which
+ *	finishes the initcall
+ * @poll: Check progress, which must not block for long. Return: -EAGAIN if
+ *	not done yet, 0 if done, other -ve value on error. May be NULL if
+ *	@start does all the work
+ */
+struct initcall_async {
+	const char *name;
+	const char *after;
+	int (*start)(void);
+	int (*poll)(void);
+};
+
+/* Declare an asynchronous initcall */
+#define INITCALL_ASYNC(_name, _after, _start, _poll)			\
+	ll_entry_declare(struct initcall_async, _name, initcall_async) = { \
+		.name = #_name,						\
+		.after = _after,					\
+		.start = _start,					\
+		.poll = _poll,						\
+	}
+
+#if CONFIG_IS_ENABLED(INITCALL_ASYNC)
+/**
+ * initcall_async_start_all() - Start the asynchronous initcalls
+ *
+ * This is an initcall in init_sequence_r. Initcalls which depend on another
+ * one are started when that one is done.
+ *
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+int initcall_async_start_all(void);
+
+/**
+ * initcall_async_poll() - Make progress with the asynchronous initcalls
+ *
+ * This is called between initcalls and from a cyclic function. It does
+ * nothing if none are running.
+ */
+void initcall_async_poll(void);
+
+/**
+ * initcall_async_join() - Wait for an asynchronous initcall to finish
+ *
+ * This must not be called from an asynchronous initcall's own functions.
+ *
+ * @name: Name of the initcall
+ * Return: result of the initcall, -ENOENT if there is none with this name,
+ *	-EAGAIN if the initcalls have not been started, or -EDEADLK if called
+ *	from an asynchronous initcall
+ */
+int initcall_async_join(const char *name);
+
+/**
+ * initcall_async_join_all() - Wait for all asynchronous initcalls to finish
+ *
+ * Return: 0 if all succeeded, else the error from the first one which
+ *	failed, taking them in name order
+ */
+int initcall_async_join_all(void);
+#else
+static inline void initcall_async_poll(void)
+{
+}
+
+static inline int initcall_async_join(const char *name)
+{
+	return 0;
+}
+
+static inline int initcall_async_join_all(void)
+{
+	return 0;
+}
+#endif
+
 #endif
@@ -10,6 +10,23 @@
 
 #define dma_mapping_error(x, y)	0
 
+#ifndef dma_coherent_is_uncached
+/**
+ * dma_coherent_is_uncached() - Check if memory is mapped uncached
+ *
+ * Memory from dma_alloc_coherent() may be mapped uncached, in which case it
+ * needs no cache maintenance. Architectures which do this override this
+ * function.
+ *
+ * @vaddr: Address of the memory
+ * Return: true if the memory is uncached, false if it needs cache maintenance
+ */
+static inline bool dma_coherent_is_uncached(const void *vaddr)
+{
+	return false;
+}
+#endif
+
 /**
  * Map a buffer to make it available to the DMA device
  *
@@ -98,6 +98,8 @@ void nand_wait_ready(struct mtd_info *mtd);
 
 /* Extended commands for large page devices */
 #define NAND_CMD_READSTART	0x30
+#define NAND_CMD_READCACHESEQ	0x31
+#define NAND_CMD_READCACHEEND	0x3f
 #define NAND_CMD_RNDOUTSTART	0xE0
 #define NAND_CMD_CACHEDPROG	0x15
 
@@ -247,6 +249,11 @@ enum nand_ecc_algo {
  * kmap'ed, vmalloc'ed highmem buffers being passed from upper layers
  */
 #define NAND_USE_BOUNCE_BUFFER	0x00100000
+/*
+ * Chip supports READ CACHE SEQUENTIAL/END, so multi-page reads can overlap
+ * reading the next page from the array with data output of the current one
+ */
+#define NAND_CACHE_READ		0x00200000
 /*
  * Whether the NAND chip is a boot medium. Drivers might use this information
  * to select ECC algorithms supported by the boot ROM or similar restrictions.
@@ -293,7 +300,8 @@ enum nand_ecc_algo {
 /* ONFI subfeature parameters length */
 #define ONFI_SUBFEATURE_PARAM_LEN	4
 
-/* ONFI optional commands SET/GET FEATURES supported? */
+/* ONFI optional commands READ CACHE and SET/GET FEATURES supported? */
+#define ONFI_OPT_CMD_READ_CACHE		(1 << 1)
 #define ONFI_OPT_CMD_SET_GET_FEATURES	(1 << 2)
 
 struct nand_onfi_params {
@@ -870,6 +878,8 @@ struct nand_manufacturer_ops {
  *			data_buf.
  * @pagebuf_bitflips:	[INTERN] holds the bitflip count for the page which is
  *			currently in data_buf.
+ * @cont_read:		[INTERN] state of the READ CACHE sequence in progress,
+ *			covering pages @first_page to @last_page
  * @subpagesize:	[INTERN] holds the subpagesize
  * @onfi_version:	[INTERN] holds the chip ONFI version (BCD encoded),
  *			non 0 if ONFI supported.
@@ -948,6 +958,11 @@ struct nand_chip {
 	int pagemask;
 	int pagebuf;
 	unsigned int pagebuf_bitflips;
+	struct {
+		bool ongoing;
+		int first_page;
+		int last_page;
+	} cont_read;
 	int subpagesize;
 	uint8_t bits_per_cell;
 	uint16_t ecc_strength_ds;
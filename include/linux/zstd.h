@@ -455,4 +455,49 @@ struct abuf;
  */
 int zstd_decompress(struct abuf *in, struct abuf *out);
 
+/**
+ * struct zstd_seek_entry - Position of one frame in a stream of zstd data
+ *
+ * @in_offset: Offset of the frame in the compressed data
+ * @in_size: Compressed size of the frame
+ * @out_offset: Offset of the frame's content in the decompressed data
+ * @out_size: Decompressed size of the frame
+ */
+struct zstd_seek_entry {
+	uint64_t in_offset;
+	uint32_t in_size;
+	uint64_t out_offset;
+	uint32_t out_size;
+};
+
+/**
+ * zstd_seek_table() - Find the frames in a stream of zstd data
+ *
+ * This uses the seek table of the zstd seekable format if there is one.
+ * Otherwise it walks the frame headers, in which case each frame must record
+ * its content size. Skippable frames are left out.
+ *
+ * @in: Compressed data
+ * @entriesp: Returns an allocated list of frames, which the caller must free
+ * Return: number of frames, -ENOTSUPP if a frame does not record its
+ *	content size, -ENOMEM if out of memory, other -ve on error
+ */
+int zstd_seek_table(struct abuf *in, struct zstd_seek_entry **entriesp);
+
+/**
+ * zstd_decompress_range() - Decompress part of a stream of zstd data
+ *
+ * Only the frames which hold the requested range are decompressed, so this
+ * is much quicker than zstd_decompress() for data made of many frames, such
+ * as that written in the seekable format.
+ *
+ * @in: Compressed data
+ * @offset: Offset of the range in the decompressed data
+ * @out: Output buffer, whose size is the number of bytes wanted
+ * Return: number of bytes written to @out, which is less than its size only
+ *	if the data ends first, or -ve on error
+ */
+int zstd_decompress_range(struct abuf *in, uint64_t offset,
+			  struct abuf *out);
+
 #endif  /* LINUX_ZSTD_H */
@@ -696,6 +696,48 @@ static inline int log_get_default_format(void)
 	       (IS_ENABLED(CONFIG_LOGF_FUNC) ? BIT(LOGF_FUNC) : 0);
 }
 
+/* "LOGR" */
+#define LOG_RING_MAGIC		0x52474f4c
+
+/**
+ * struct log_ring_hdr - header of the log ring, stored in a bloblist record
+ *
+ * This is passed on to later phases and the OS in the BLOBLISTT_U_BOOT_LOG
+ * bloblist record. It is followed by @size bytes of data, which hold a
+ * sequence of records (struct log_ring_rec followed by the message text)
+ * starting at offset @start and wrapping around to the start of the data as
+ * needed. Fields are in the byte order of the machine that wrote them.
+ *
+ * @magic: LOG_RING_MAGIC
+ * @size: Size of the data area, in bytes
+ * @start: Offset of the oldest record in the data area
+ * @used: Number of bytes of records in the data area
+ * @dropped: Number of records discarded to make space for newer ones
+ */
+struct log_ring_hdr {
+	u32 magic;
+	u32 size;
+	u32 start;
+	u32 used;
+	u32 dropped;
+};
+
+/**
+ * struct log_ring_rec - header of a record in the log ring
+ *
+ * @level: Log level (enum log_level_t)
+ * @flags: Record flags (enum log_rec_flags)
+ * @cat: Log category (enum log_category_t)
+ * @len: Length of the message text which follows, not including any
+ *	terminator
+ */
+struct log_ring_rec {
+	u8 level;
+	u8 flags;
+	u16 cat;
+	u16 len;
+} __packed;
+
 struct global_data;
 /**
  * log_fixup_for_gd_move() - Handle global_data moving to a new place
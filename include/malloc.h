@@ -879,6 +879,141 @@ void malloc_enable_testing(int max_allocs);
 /** malloc_disable_testing() - Put malloc() into normal mode */
 void malloc_disable_testing(void);
 
+/* Number of size classes used with CONFIG_SYS_MALLOC_SIZE_CLASSES */
+#define MALLOC_NUM_CLASSES	5
+
+/**
+ * struct malloc_class_stats - Statistics for a malloc() size class
+ *
+ * @size: Largest allocation in the class, in bytes
+ * @hits: Number of allocations taken from the free list
+ * @misses: Number of allocations made when the free list was empty
+ * @frees: Number of chunks put on the free list
+ * @spills: Number of chunks freed to the pool since the free list was full
+ * @count: Number of chunks on the free list now
+ */
+struct malloc_class_stats {
+	ulong size;
+	ulong hits;
+	ulong misses;
+	ulong frees;
+	ulong spills;
+	ulong count;
+};
+
+/**
+ * malloc_get_class_stats() - Get statistics for the malloc() size classes
+ *
+ * @stats: Returns the statistics for each class, smallest first
+ * @max: Maximum number of classes to return
+ * Return: number of classes returned
+ */
+int malloc_get_class_stats(struct malloc_class_stats *stats, int max);
+
+/**
+ * malloc_class_flush() - Free all chunks on the size-class free lists
+ *
+ * This returns the chunks to the pool, so they can be merged with their
+ * neighbours. It is called automatically when the pool runs out of space.
+ *
+ * Return: number of chunks freed
+ */
+int malloc_class_flush(void);
+
+/* Site index used with CONFIG_SYS_MALLOC_PROFILE when the site table is full */
+#define MALLOC_PROF_NO_SITE	0xffff
+
+/**
+ * struct malloc_prof_site - Memory allocated by one call site
+ *
+ * @caller: Address the allocation function returns to, adjusted to be the
+ *	link-time address, or 0 if this entry is unused
+ * @live: Number of bytes allocated from the main pool and not yet freed
+ * @count: Number of allocations from the main pool not yet freed
+ * @peak: Largest value of @live
+ * @total: Total number of allocations, including those from the
+ *	pre-relocation pool
+ * @early: Number of bytes allocated from the pre-relocation pool
+ */
+struct malloc_prof_site {
+	ulong caller;
+	ulong live;
+	ulong count;
+	ulong peak;
+	ulong total;
+	ulong early;
+};
+
+/**
+ * struct malloc_prof - Profile of malloc() use
+ *
+ * @sites: Table of call sites, indexed by a hash of the caller
+ * @num_sites: Number of entries in @sites
+ * @live: Number of bytes allocated from the main pool and not yet freed
+ * @peak: Largest value of @live, i.e. the high-water mark of the main pool
+ * @early_peak: High-water mark of the pre-relocation pool
+ * @untracked: Number of allocations not recorded since @sites was full
+ */
+struct malloc_prof {
+	struct malloc_prof_site *sites;
+	int num_sites;
+	ulong live;
+	ulong peak;
+	ulong early_peak;
+	ulong untracked;
+};
+
+/**
+ * malloc_prof_alloc() - Record an allocation from the main pool
+ *
+ * @caller: Address the allocation function returns to
+ * @size: Number of bytes allocated
+ * Return: index of the call site, or MALLOC_PROF_NO_SITE if not recorded
+ */
+uint malloc_prof_alloc(ulong caller, size_t size);
+
+/**
+ * malloc_prof_free() - Record freeing an allocation from the main pool
+ *
+ * @site: Index of the call site, as returned by malloc_prof_alloc()
+ * @size: Number of bytes which were allocated
+ */
+void malloc_prof_free(uint site, size_t size);
+
+/**
+ * malloc_prof_early() - Record an allocation from the pre-relocation pool
+ *
+ * @caller: Address the allocation function returns to
+ * @size: Number of bytes allocated
+ */
+void malloc_prof_early(ulong caller, size_t size);
+
+/**
+ * malloc_prof_reset() - Forget allocations from the main pool
+ *
+ * This is called when the main pool is set up, since anything allocated from
+ * an earlier pool cannot be freed into it.
+ */
+void malloc_prof_reset(void);
+
+/**
+ * malloc_prof_get() - Get the malloc() profile
+ *
+ * Return: profile, which is updated as memory is allocated and freed
+ */
+const struct malloc_prof *malloc_prof_get(void);
+
+/**
+ * malloc_prof_show() - Show the malloc() profile
+ *
+ * This shows the high-water marks, then the call sites using the most memory.
+ * Sites are sorted by the number of bytes they have not freed, then by how
+ * much they allocated from the pre-relocation pool.
+ *
+ * @max: Maximum number of sites to show, or 0 for all
+ */
+void malloc_prof_show(int max);
+
 #if CONFIG_IS_ENABLED(SYS_MALLOC_SIMPLE)
 #define malloc malloc_simple
 #define realloc realloc_simple
@@ -940,6 +1075,9 @@ int initf_malloc(void);
 void *malloc_simple(size_t size);
 void *memalign_simple(size_t alignment, size_t bytes);
 
+/* As memalign_simple(), but recording @caller with CONFIG_SYS_MALLOC_PROFILE */
+void *memalign_simple_caller(size_t alignment, size_t bytes, ulong caller);
+
 #pragma GCC visibility push(hidden)
 # if __STD_C
 
@@ -68,6 +68,7 @@ struct bd_info;
 #define MMC_CAP_NONREMOVABLE	BIT(14)
 #define MMC_CAP_NEEDS_POLL	BIT(15)
 #define MMC_CAP_CD_ACTIVE_HIGH  BIT(16)
+#define MMC_CAP_CMD23		BIT(17)
 
 #define MMC_MODE_8BIT		BIT(30)
 #define MMC_MODE_4BIT		BIT(29)
@@ -75,6 +76,7 @@ struct bd_info;
 #define MMC_MODE_SPI		BIT(27)
 
 #define SD_DATA_4BIT	0x00040000
+#define SD_SCR_CMD23_SUPPORT	BIT(1)
 
 #define IS_SD(x)	((x)->version & SD_VERSION_SD)
 #define IS_MMC(x)	((x)->version & MMC_VERSION_MMC)
@@ -105,6 +107,7 @@ struct bd_info;
 #define MMC_CMD_ERASE_GROUP_START	35
 #define MMC_CMD_ERASE_GROUP_END		36
 #define MMC_CMD_ERASE			38
+#define MMC_CMD_CMDQ_TASK_MGMT		48
 #define MMC_CMD_APP_CMD			55
 #define MMC_CMD_SPI_READ_OCR		58
 #define MMC_CMD_SPI_CRC_ON_OFF		59
@@ -205,6 +208,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 /*
  * EXT_CSD fields
  */
+#define EXT_CSD_CMDQ_MODE_EN		15	/* R/W */
 #define EXT_CSD_ENH_START_ADDR		136	/* R/W */
 #define EXT_CSD_ENH_SIZE_MULT		140	/* R/W */
 #define EXT_CSD_GP_SIZE_MULT		143	/* R/W */
@@ -223,6 +227,7 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_ERASE_GROUP_DEF		175	/* R/W */
 #define EXT_CSD_BOOT_BUS_WIDTH		177
 #define EXT_CSD_PART_CONF		179	/* R/W */
+#define EXT_CSD_ERASED_MEM_CONT		181	/* RO */
 #define EXT_CSD_BUS_WIDTH		183	/* R/W */
 #define EXT_CSD_STROBE_SUPPORT		184	/* R/W */
 #define EXT_CSD_HS_TIMING		185	/* R/W */
@@ -235,6 +240,8 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 #define EXT_CSD_BOOT_MULT		226	/* RO */
 #define EXT_CSD_SEC_FEATURE		231	/* RO */
 #define EXT_CSD_GENERIC_CMD6_TIME       248     /* RO */
+#define EXT_CSD_CMDQ_DEPTH		307	/* RO */
+#define EXT_CSD_CMDQ_SUPPORT		308	/* RO */
 #define EXT_CSD_BKOPS_SUPPORT		502	/* RO */
 
 /*
@@ -310,6 +317,11 @@ static inline bool mmc_is_tuning_cmd(uint cmdidx)
 
 #define EXT_CSD_SEC_FEATURE_TRIM_EN	(1 << 4) /* Support secure & insecure trim */
 
+#define EXT_CSD_CMDQ_SUPPORTED		(1 << 0)
+#define EXT_CSD_CMDQ_DEPTH_MASK		0x1f
+
+#define MMC_CMDQ_DISCARD_QUEUE		1	/* CMD48 TM op-code */
+
 #define R1_ILLEGAL_COMMAND		(1 << 22)
 #define R1_APP_CMD			(1 << 5)
 
@@ -560,6 +572,43 @@ struct dm_mmc_ops {
 	 * @return 0 if success, -ve on error
 	 */
 	int (*hs400_prepare_ddr)(struct udevice *dev);
+
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	/**
+	 * cqe_enable() - hand the bus to or take it back from the host
+	 *		  command queue engine
+	 *
+	 * Called after the card has been switched into command queue mode,
+	 * and before it is switched back out.
+	 *
+	 * @dev:	Device to update
+	 * @enable:	true to enable the engine, false to disable it
+	 * @return 0 if OK, -ENOSYS if there is no engine, other -ve on error
+	 */
+	int (*cqe_enable)(struct udevice *dev, bool enable);
+
+	/**
+	 * cqe_xfer_start() - start a transfer through the command queue engine
+	 *
+	 * @dev:	Device to use
+	 * @start:	First block to transfer
+	 * @blkcnt:	Number of blocks to transfer
+	 * @buf:	Buffer to transfer to or from
+	 * @write:	true to write to the card, false to read from it
+	 * @return 0 if OK, -ve on error
+	 */
+	int (*cqe_xfer_start)(struct udevice *dev, lbaint_t start,
+			      lbaint_t blkcnt, void *buf, bool write);
+
+	/**
+	 * cqe_xfer_poll() - move a transfer along without waiting for it
+	 *
+	 * @dev:	Device with a transfer started by cqe_xfer_start()
+	 * @return 0 if the transfer has finished, -EBUSY if it is still in
+	 *	progress, other -ve on error
+	 */
+	int (*cqe_xfer_poll)(struct udevice *dev);
+#endif
 };
 
 #define mmc_get_ops(dev)        ((struct dm_mmc_ops *)(dev)->driver->ops)
@@ -576,6 +625,10 @@ int mmc_deferred_probe(struct mmc *mmc);
 int mmc_reinit(struct mmc *mmc);
 int mmc_get_b_max(struct mmc *mmc, void *dst, lbaint_t blkcnt);
 int mmc_hs400_prepare_ddr(struct mmc *mmc);
+int mmc_cqe_enable(struct mmc *mmc, bool enable);
+int mmc_cqe_xfer_start(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt,
+		       void *buf, bool write);
+int mmc_cqe_xfer_poll(struct mmc *mmc);
 int mmc_send_stop_transmission(struct mmc *mmc, bool write);
 
 #else
@@ -672,6 +725,23 @@ static inline bool supports_uhs(uint caps)
 #endif
 }
 
+/**
+ * struct mmc_handoff - eMMC setup passed from SPL to U-Boot proper
+ *
+ * This is stored in the bloblist with tag BLOBLISTT_U_BOOT_MMC
+ *
+ * @cid: CID of the card, so that the information is only used for it
+ * @mode: Bus mode selected in SPL (enum bus_mode)
+ * @bus_width: Bus width selected in SPL (1, 4 or 8)
+ * @ext_csd: EXT_CSD as read by SPL before switching bus mode
+ */
+struct mmc_handoff {
+	u32 cid[4];
+	u32 mode;
+	u32 bus_width;
+	u8 ext_csd[512];
+};
+
 /*
  * With CONFIG_DM_MMC enabled, struct mmc can be accessed from the MMC device
  * with mmc_get_mmc_dev().
@@ -736,6 +806,8 @@ struct mmc {
 	char op_cond_pending;	/* 1 if we are waiting on an op_cond command */
 	char init_in_progress;	/* 1 if we have done mmc_start_init() */
 	char preinit;		/* start init as early as possible */
+	char init_async;	/* 1 to leave the card powering up after start */
+	ulong op_cond_start;	/* time the op_cond command was first sent */
 	int ddr_mode;
 #if CONFIG_IS_ENABLED(DM_MMC)
 	struct udevice *dev;	/* Device for this MMC controller */
@@ -756,6 +828,10 @@ struct mmc {
 	u32 quirks;
 	bool tuning:1;
 	bool hs400_tuning:1;
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	u8 cmdq_depth;		/* tasks the card can queue, 0 if not used */
+	struct blk_req *cqe_req;	/* asynchronous read in progress */
+#endif
 
 	enum bus_mode user_speed_mode; /* input speed mode from user */
 
@@ -884,6 +960,28 @@ int board_mmc_getwp(struct mmc *mmc);
 #endif
 
 int mmc_set_dsr(struct mmc *mmc, u16 val);
+
+#if CONFIG_IS_ENABLED(MMC_WRITE)
+/**
+ * mmc_erase_reads_zero() - Check if erasing blocks leaves them reading as 0
+ *
+ * This is true for eMMC devices which report that erased memory reads as
+ * zero, as long as the range is made of whole erase groups or the device can
+ * trim single blocks.
+ *
+ * @mmc:	MMC device
+ * @start:	First block to erase
+ * @blkcnt:	Number of blocks to erase
+ * Return: true if the blocks can be zeroed with blk_derase()
+ */
+bool mmc_erase_reads_zero(struct mmc *mmc, lbaint_t start, lbaint_t blkcnt);
+#else
+static inline bool mmc_erase_reads_zero(struct mmc *mmc, lbaint_t start,
+					lbaint_t blkcnt)
+{
+	return false;
+}
+#endif
 /* Function to change the size of boot partition and rpmb partitions */
 int mmc_boot_partition_size_change(struct mmc *mmc, unsigned long bootsize,
 					unsigned long rpmbsize);
@@ -953,6 +1051,18 @@ int mmc_get_op_cond(struct mmc *mmc, bool quiet);
  */
 int mmc_start_init(struct mmc *mmc);
 
+/**
+ * mmc_poll_init() - Check whether a card has finished powering up
+ *
+ * This sends the op_cond command once, for a card left powering up by
+ * mmc_start_init() when @mmc->init_async is set. It does not block.
+ *
+ * @mmc:	MMC device to check
+ * Return: 0 if the card is ready or nothing is pending, -EAGAIN if it is
+ * still busy, -ETIMEDOUT if it has taken too long, other -ve on error
+ */
+int mmc_poll_init(struct mmc *mmc);
+
 /**
  * Set preinit flag of mmc device.
  *
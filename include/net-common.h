@@ -201,7 +201,15 @@ int eth_send(void *packet, int length);	   /* Send a packet */
 int eth_receive(void *packet, int length); /* Receive a packet*/
 extern void (*push_packet)(void *packet, int length);
 #endif
-int eth_rx(void);			/* Check for received packets */
+
+/**
+ * eth_rx() - Check for received packets and process them
+ *
+ * Up to ETH_PACKETS_BATCH_RECV packets are handed to the network stack.
+ *
+ * Return: number of packets received, or -ve on error
+ */
+int eth_rx(void);
 
 /**
  * reset_phy() - Reset the Ethernet PHY
@@ -296,6 +304,72 @@ void eth_halt(void);			/* stop SCC */
 const char *eth_get_name(void);		/* get name of current device */
 int eth_get_dev_index(void);
 
+/**
+ * eth_set_rx_csum_ok() - Report that the checksums of a packet are correct
+ *
+ * A driver whose eth_pdata has ETH_CSUM_RX calls this from its recv() method
+ * when the hardware has checked the IPv4 header checksum and the TCP or UDP
+ * checksum of the packet being returned and found them correct. The network
+ * stack then skips checking them again.
+ *
+ * @dev: device receiving the packet
+ */
+void eth_set_rx_csum_ok(struct udevice *dev);
+
+/**
+ * eth_tx_csum_offload() - Check if the current device inserts TCP checksums
+ *
+ * Return: true if the TCP checksum of sent packets may be left as zero
+ */
+bool eth_tx_csum_offload(void);
+
+/**
+ * struct eth_stats - traffic counters for an Ethernet device
+ *
+ * The uclass counts packets passing through eth_send() and eth_rx(). Drivers
+ * may add the events only they can see, such as packets dropped for lack of
+ * a receive buffer, using eth_get_stats().
+ *
+ * @rx_packets: Packets received
+ * @rx_bytes: Bytes received, including the Ethernet header
+ * @rx_errors: Failed calls to the recv() method
+ * @rx_dropped: Packets dropped by the driver
+ * @rx_csum_errors: Packets dropped because an IP or UDP checksum was wrong
+ * @tx_packets: Packets sent
+ * @tx_bytes: Bytes sent, including the Ethernet header
+ * @tx_errors: Failed calls to the send() method
+ * @tx_ring_full: Packets not sent because the transmit ring was full
+ */
+struct eth_stats {
+	u64 rx_packets;
+	u64 rx_bytes;
+	ulong rx_errors;
+	ulong rx_dropped;
+	ulong rx_csum_errors;
+	u64 tx_packets;
+	u64 tx_bytes;
+	ulong tx_errors;
+	ulong tx_ring_full;
+};
+
+/**
+ * eth_get_stats() - Get the traffic counters of a device
+ *
+ * The counters may be updated or cleared through the returned pointer.
+ *
+ * @dev: Ethernet device
+ * Return: counters for @dev
+ */
+struct eth_stats *eth_get_stats(struct udevice *dev);
+
+/**
+ * eth_count_rx_csum_error() - Count a checksum error on the current device
+ */
+void eth_count_rx_csum_error(void);
+
+/* The checksums of the packet being processed were checked by the MAC */
+extern bool net_rx_csum_ok;
+
 int eth_initialize(void);		/* Initialize network subsystem */
 void eth_try_another(int first_restart);	/* Change the device */
 void eth_set_current(void);		/* set nterface to ethcur var */
@@ -313,6 +387,7 @@ enum eth_state_t {
  * @enetaddr: The Ethernet MAC address that is loaded from EEPROM or env
  * @phy_interface: PHY interface to use - see PHY_INTERFACE_MODE_...
  * @max_speed: Maximum speed of Ethernet connection supported by MAC
+ * @csum_offload: Checksum offload supported by the MAC, ETH_CSUM_...
  * @priv_pdata: device specific plat
  */
 struct eth_pdata {
@@ -320,9 +395,15 @@ struct eth_pdata {
 	unsigned char enetaddr[ARP_HLEN];
 	int phy_interface;
 	int max_speed;
+	unsigned int csum_offload;
 	void *priv_pdata;
 };
 
+/* The MAC reports packets with correct checksums, see eth_set_rx_csum_ok() */
+#define ETH_CSUM_RX	BIT(0)
+/* The MAC inserts the TCP checksum of the IPv4 packets it sends */
+#define ETH_CSUM_TX	BIT(1)
+
 struct ethernet_hdr {
 	u8		et_dest[ARP_HLEN];	/* Destination node	*/
 	u8		et_src[ARP_HLEN];	/* Source node		*/
@@ -107,6 +107,17 @@ int eth_send(void *packet, int length);	   /* Send a packet */
 int eth_receive(void *packet, int length); /* Receive a packet*/
 extern void (*push_packet)(void *packet, int length);
 #endif
+/**
+ * eth_mcast_join() - join or leave an IP multicast group
+ *
+ * Ask the current Ethernet device to receive the frames sent to the MAC
+ * address of a group, or to stop receiving them.
+ *
+ * @mcast_addr: group address
+ * @join: 1 to join the group, 0 to leave it
+ * Return: 0 if OK, -ENOSYS if the device has no multicast filter to set,
+ *	other -ve on error
+ */
 int eth_mcast_join(struct in_addr mcast_addr, int join);
 
 /**********************************************************************/
@@ -289,6 +300,7 @@ extern char	net_root_path[CONFIG_BOOTP_MAX_ROOT_PATH_LEN];	/* Our root path */
 extern u8		net_ethaddr[ARP_HLEN];		/* Our ethernet address */
 extern u8		net_server_ethaddr[ARP_HLEN];	/* Boot server enet address */
 extern struct in_addr	net_server_ip;	/* Server IP addr (0 = unknown) */
+extern struct in_addr	net_mcast_addr;	/* Multicast group joined (0 = none) */
 extern uchar		*net_tx_packet;		/* THE transmit packet */
 extern uchar		*net_rx_packets[PKTBUFSRX]; /* Receive packets */
 extern uchar		*net_rx_packet;		/* Current receive packet */
@@ -5,6 +5,8 @@
  * Copyright 2017 Duncan Hare, All rights reserved.
  */
 
+#include <linux/log2.h>
+
 #define TCP_ACTIVITY 127		/* Number of packets received   */
 					/* before console progress mark */
 /**
@@ -68,8 +70,8 @@ struct ip_tcp_hdr {
  * TCP header options, Seq, MSS, and SACK
  */
 
-#define TCP_SACK 32			/* Number of packets analyzed   */
-					/* on leading edge of stream    */
+#define TCP_SACK 32			/* Number of out-of-order	*/
+					/* ranges tracked		*/
 
 #define TCP_O_END	0x00		/* End of option list		*/
 #define TCP_1_NOP	0x01		/* Single padding NOP		*/
@@ -86,7 +88,11 @@ struct ip_tcp_hdr {
 #define TCP_OPT_LEN_8	0x08
 #define TCP_OPT_LEN_A	0x0a		/* Timestamp Length		*/
 #define TCP_MSS		1460		/* Max segment size		*/
-#define TCP_SCALE	0x01		/* Scale			*/
+#define TCP_RX_WINDOW	CONFIG_PROT_TCP_WINDOW	/* Receive window	*/
+/* Window scale shift which makes TCP_RX_WINDOW fit in 16 bits */
+#define TCP_SCALE	(TCP_RX_WINDOW > 0xffff ? \
+			 ilog2(TCP_RX_WINDOW >> 16) + 1 : 0)
+#define TCP_ACK_DELAY	20		/* Max ms to delay an ACK	*/
 
 /**
  * struct tcp_mss - TCP option structure for MSS (Max segment size)
@@ -278,6 +284,7 @@ enum tcp_state {
 };
 
 enum tcp_state tcp_get_tcp_state(void);
+u32 tcp_get_ack_edge(void);
 void tcp_set_tcp_state(enum tcp_state new_state);
 int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 		       u8 action, u32 tcp_seq_num, u32 tcp_ack_num);
@@ -301,5 +308,16 @@ void tcp_set_tcp_handler(rxhand_tcp *f);
 
 void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int len);
 
+/**
+ * tcp_ack_delayed() - Check whether the last segment's ACK may be delayed
+ *
+ * An ACK is only delayed for a full-sized segment arriving in order, and no
+ * more than every other segment is left unacknowledged (RFC 1122).
+ *
+ * Return: true if the application may wait up to TCP_ACK_DELAY ms before
+ * sending the ACK
+ */
+bool tcp_ack_delayed(void);
+
 u16 tcp_set_pseudo_header(uchar *pkt, struct in_addr src, struct in_addr dest,
 			  int tcp_len, int pkt_len);
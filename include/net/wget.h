@@ -8,6 +8,17 @@
  */
 void wget_start(void);
 
+/**
+ * wget_set_range() - fetch only part of the file
+ *
+ * The part is requested with an HTTP Range header and stored at the load
+ * address. Use (0, 0) to fetch the whole file again.
+ *
+ * @start: offset of the first byte to fetch
+ * @size: number of bytes to fetch, 0 to fetch up to the end of the file
+ */
+void wget_set_range(ulong start, ulong size);
+
 enum wget_state {
 	WGET_CLOSED,
 	WGET_CONNECTING,
@@ -9,8 +9,37 @@
 #ifndef _OF_LIVE_H
 #define _OF_LIVE_H
 
+#include <linux/types.h>
+
 struct abuf;
 struct device_node;
+struct property;
+
+/**
+ * struct of_live_static - Live tree generated at build time
+ *
+ * With OF_LIVE_STATIC, scripts/gen_live_tree.py generates this from the
+ * control devicetree. The names of nodes and properties and the values of
+ * properties start off as offsets into that devicetree; the rest of the
+ * pointers are set up by the linker.
+ *
+ * @fdt_size: Size of the devicetree the tree was generated from
+ * @fdt_crc: CRC32 of that devicetree
+ * @nodes: Nodes, starting with the root
+ * @node_count: Number of nodes
+ * @props: Properties of all the nodes
+ * @prop_count: Number of properties
+ */
+struct of_live_static {
+	u32 fdt_size;
+	u32 fdt_crc;
+	struct device_node *nodes;
+	int node_count;
+	struct property *props;
+	int prop_count;
+};
+
+extern struct of_live_static of_live_static;
 
 /**
  * of_live_build() - build a live (hierarchical) tree from a flat DT
@@ -21,6 +50,20 @@ struct device_node;
  */
 int of_live_build(const void *fdt_blob, struct device_node **rootp);
 
+/**
+ * of_live_static_attach() - Use the live tree generated at build time
+ *
+ * This checks that @fdt_blob is the devicetree which of_live_static was
+ * generated from and, if so, points the names and values in the tree at it.
+ * Nothing is allocated. The tree may be attached again to another copy of the
+ * same devicetree, but only while nothing is using it.
+ *
+ * @fdt_blob: Devicetree to attach to
+ * @rootp: Returns the root node of the tree
+ * Return: 0 if OK, -ENOENT if @fdt_blob is not the right devicetree
+ */
+int of_live_static_attach(const void *fdt_blob, struct device_node **rootp);
+
 /**
  * unflatten_device_tree() - create tree of device_nodes from flat blob
  *
@@ -478,6 +478,20 @@ int os_read_file(const char *name, void **bufp, int *sizep);
  */
 int os_map_file(const char *pathname, int os_flags, void **bufp, int *sizep);
 
+/**
+ * os_map_fd() - Map an open file from the host filesystem into memory
+ *
+ * Changes to the mapping are written back to the file, so it can be used as
+ * the backing store for an emulated device without a system call per access.
+ *
+ * @fd:		File descriptor as returned by os_open()
+ * @size:	Number of bytes to map, from the start of the file
+ * @os_flags:	OS_O_RDONLY to map read-only, else the mapping is writable
+ * @bufp:	Returns the mapped address
+ * Return:	0 if OK, -EFBIG if @size cannot be mapped, other -ve on error
+ */
+int os_map_fd(int fd, off_t size, int os_flags, void **bufp);
+
 /**
  * os_unmap() - Unmap a file previously mapped
  *
@@ -485,7 +499,7 @@ int os_map_file(const char *pathname, int os_flags, void **bufp, int *sizep);
  * @size: Size in bytes
  * Return:	0 if OK, -ve on error
  */
-int os_unmap(void *buf, int size);
+int os_unmap(void *buf, size_t size);
 
 /*
  * os_find_text_base() - Find the text section in this running process
@@ -530,6 +544,43 @@ int os_setup_signal_handlers(void);
  */
 void os_signal_action(int sig, unsigned long pc);
 
+/**
+ * os_prof_timer() - start or stop the profiling timer
+ *
+ * While the timer runs, os_prof_action() is called at the given rate, as
+ * measured in CPU time used by the process.
+ *
+ * @hz:		number of calls per second, or 0 to stop the timer
+ * @stack_top:	returns the top of the stack, if @hz is not 0
+ * Return:	0 for success, -1 on error
+ */
+int os_prof_timer(unsigned int hz, unsigned long *stack_top);
+
+/**
+ * os_prof_action() - handle a tick of the profiling timer
+ *
+ * @pc:		program counter of the interrupted code
+ * @fp:		frame pointer of the interrupted code, or 0 if not known
+ * @sp:		stack pointer of the interrupted code
+ */
+void os_prof_action(unsigned long pc, unsigned long fp, unsigned long sp);
+
+/**
+ * os_initjmp() - set up a jump buffer to start a function on a new stack
+ *
+ * A later longjmp() to @jmp calls @func on the given stack. The host's jump
+ * buffers cannot be written directly, so this runs a signal handler on the
+ * new stack which calls setjmp().
+ *
+ * @jmp:	jump buffer to set up
+ * @func:	function to call, which must not return
+ * @stack_base:	lowest address of the stack
+ * @stack_size:	size of the stack in bytes
+ * Return:	0 for success, -1 on error
+ */
+int os_initjmp(void *jmp, void (*func)(void), void *stack_base,
+	       size_t stack_size);
+
 /**
  * os_get_time_offset() - get time offset
  *
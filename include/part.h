@@ -232,6 +232,20 @@ void part_print(struct blk_desc *desc);
 void part_init(struct blk_desc *desc);
 void dev_print(struct blk_desc *desc);
 
+#if CONFIG_IS_ENABLED(PART_CACHE)
+/**
+ * part_cache_invalidate() - drop the cached partition entries of a device
+ *
+ * This must be called when the partition table may have changed, e.g.
+ * after writing to the device.
+ *
+ * @desc:	block device descriptor
+ */
+void part_cache_invalidate(struct blk_desc *desc);
+#else
+static inline void part_cache_invalidate(struct blk_desc *desc) {}
+#endif
+
 /**
  * blk_get_device_by_str() - Get a block device given its interface/hw partition
  *
@@ -368,6 +382,7 @@ static inline int part_get_info_whole_disk(struct blk_desc *desc,
 { return -1; }
 static inline void part_print(struct blk_desc *desc) {}
 static inline void part_init(struct blk_desc *desc) {}
+static inline void part_cache_invalidate(struct blk_desc *desc) {}
 static inline void dev_print(struct blk_desc *desc) {}
 static inline int blk_get_device_by_str(const char *ifname, const char *dev_str,
 					struct blk_desc **desc)
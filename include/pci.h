@@ -847,6 +847,7 @@ struct udevice;
  * @vendor:	PCI vendor ID (see pci_ids.h)
  * @device:	PCI device ID (see pci_ids.h)
  * @class:	PCI class, 3 bytes: (base, sub, prog-if)
+ * @header_type: PCI header type, including the multi-function bit
  * @is_virtfn:	True for Virtual Function device
  * @pfdev:	Handle to Physical Function device
  * @virtid:	Virtual Function Index
@@ -856,6 +857,7 @@ struct pci_child_plat {
 	unsigned short vendor;
 	unsigned short device;
 	unsigned int class;
+	u8 header_type;
 
 	/* Variables for CONFIG_PCI_SRIOV */
 	bool is_virtfn;
@@ -910,6 +912,27 @@ struct dm_pci_ops {
  */
 pci_dev_t dm_pci_get_bdf(const struct udevice *dev);
 
+/**
+ * dm_pci_get_header_type() - Get the header type of a device
+ *
+ * This is read once when the bus is scanned, so no config access is needed.
+ *
+ * @dev:	Device to check
+ * Return: value of the PCI_HEADER_TYPE register, including the
+ * multi-function bit
+ */
+u8 dm_pci_get_header_type(const struct udevice *dev);
+
+/**
+ * dm_pci_get_class() - Get the class of a device
+ *
+ * This is read once when the bus is scanned, so no config access is needed.
+ *
+ * @dev:	Device to check
+ * Return: PCI class, 3 bytes: (base, sub, prog-if)
+ */
+uint dm_pci_get_class(const struct udevice *dev);
+
 /**
  * pci_bind_bus_devices() - scan a PCI bus and bind devices
  *
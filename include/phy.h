@@ -159,6 +159,8 @@ struct phy_device {
 	u32 phy_id;
 	bool is_c45;
 	u32 flags;
+	/* Time autonegotiation was last (re)started, from get_timer() */
+	ulong aneg_start;
 };
 
 struct fixed_link {
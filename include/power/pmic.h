@@ -160,12 +160,17 @@ struct pmic {
  * @reg_count: device's register count
  * @read:      read 'len' bytes at "reg" and store it into the 'buffer'
  * @write:     write 'len' bytes from the 'buffer' to the register at 'reg' address
+ * @reg_volatile: optional; return true if register 'reg' can change without
+ *		being written, or does not read back what was written. With
+ *		CONFIG_PMIC_REG_CACHE all other registers are cached by the
+ *		uclass, so that reads and unchanged updates skip the bus.
  */
 struct dm_pmic_ops {
 	int (*reg_count)(struct udevice *dev);
 	int (*read)(struct udevice *dev, uint reg, uint8_t *buffer, int len);
 	int (*write)(struct udevice *dev, uint reg, const uint8_t *buffer,
 		     int len);
+	bool (*reg_volatile)(struct udevice *dev, uint reg);
 };
 
 /**
@@ -301,11 +306,19 @@ int pmic_clrsetbits(struct udevice *dev, uint reg, uint clr, uint set);
 
 /*
  * This structure holds the private data for PMIC uclass
- * For now we store information about the number of bytes
- * being sent at once to the device.
+ * We store information about the number of bytes being sent at once to
+ * the device, and the register cache if the driver supports it.
+ *
+ * @trans_len:	Number of bytes per register
+ * @cache:	Cached register values, or NULL if not caching
+ * @cache_valid: One byte per register, non-zero if @cache holds its value
+ * @cache_size:	Number of registers in @cache
  */
 struct uc_pmic_priv {
 	uint trans_len;
+	u8 *cache;
+	u8 *cache_valid;
+	uint cache_size;
 };
 
 #endif /* DM_PMIC */
@@ -76,6 +76,7 @@ struct regmap_range {
 };
 
 struct regmap_bus;
+struct udevice;
 
 /**
  * struct regmap_config - Configure the behaviour of a regmap
@@ -88,14 +89,25 @@ struct regmap_bus;
  *			which starts at this address, instead of finding the
  *			start from device tree.
  * @r_size:		Same as above for the range size
+ * @cache:		Keep a copy of register values, so that reads and
+ *			unchanged updates do not access the hardware. This
+ *			needs CONFIG_REGMAP_CACHE and is ignored without it.
+ * @max_register:	Highest register offset to cache
+ * @volatile_reg:	Optional function returning true for registers which
+ *			must not be cached, e.g. status registers
  */
 struct regmap_config {
 	enum regmap_size_t width;
 	u32 reg_offset_shift;
 	ulong r_start;
 	ulong r_size;
+	bool cache;
+	uint max_register;
+	bool (*volatile_reg)(struct udevice *dev, uint offset);
 };
 
+struct regmap_cache;
+
 /**
  * struct regmap - a way of accessing hardware/bus registers
  *
@@ -103,6 +115,7 @@ struct regmap_config {
  *			REGMAP_SIZE_32 if set to 0.
  * @reg_offset_shift	Left shift the register offset by this value before
  *			performing read or write.
+ * @cache:		Register cache, or NULL if not caching
  * @range_count:	Number of ranges available within the map
  * @ranges:		Array of ranges
  */
@@ -110,6 +123,7 @@ struct regmap {
 	enum regmap_endianness_t endianness;
 	enum regmap_size_t width;
 	u32 reg_offset_shift;
+	struct regmap_cache *cache;
 	int range_count;
 	struct regmap_range ranges[0];
 };
@@ -142,6 +156,35 @@ int regmap_write(struct regmap *map, uint offset, uint val);
  */
 int regmap_read(struct regmap *map, uint offset, uint *valp);
 
+/**
+ * regmap_bulk_write() - Write consecutive registers of a regmap
+ *
+ * @map:	Regmap to write to
+ * @offset:	Offset of the first register
+ * @val:	Array of values to write, each the width of the regmap
+ * @val_count:	Number of registers to write
+ *
+ * Registers are @map->width bytes apart, or one apart if the regmap has a
+ * reg_offset_shift, as with regmap_write().
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int regmap_bulk_write(struct regmap *map, uint offset, const void *val,
+		      size_t val_count);
+
+/**
+ * regmap_bulk_read() - Read consecutive registers of a regmap
+ *
+ * @map:	Regmap to read from
+ * @offset:	Offset of the first register
+ * @val:	Array to receive the values, each the width of the regmap
+ * @val_count:	Number of registers to read
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int regmap_bulk_read(struct regmap *map, uint offset, void *val,
+		     size_t val_count);
+
 /**
  * regmap_raw_write() - Write a value of specified length to a regmap
  *
@@ -428,6 +471,44 @@ struct regmap *devm_regmap_init(struct udevice *dev,
 				const struct regmap_bus *bus,
 				void *bus_context,
 				const struct regmap_config *config);
+/**
+ * regmap_cache_init() - Set up a register cache for a regmap
+ *
+ * @map:	Regmap to cache
+ * @dev:	Device to pass to @config->volatile_reg
+ * @config:	Configuration giving the registers to cache
+ *
+ * devm_regmap_init() calls this when @config->cache is set. Other users,
+ * such as syscon drivers, can call it once the regmap exists. The cache is
+ * freed by regmap_uninit().
+ *
+ * Return: 0 if OK (or caching is disabled), -ve on error
+ */
+int regmap_cache_init(struct regmap *map, struct udevice *dev,
+		      const struct regmap_config *config);
+
+/**
+ * regmap_cache_sync() - Write all cached values back to the hardware
+ *
+ * @map:	Regmap to sync
+ *
+ * This restores the registers after the hardware has lost its state, e.g.
+ * after a power domain was switched off.
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int regmap_cache_sync(struct regmap *map);
+
+/**
+ * regmap_cache_drop() - Forget all cached values
+ *
+ * @map:	Regmap whose cache is dropped
+ *
+ * Use this when the hardware may have been changed behind the regmap's back.
+ * The next access to each register goes to the hardware.
+ */
+void regmap_cache_drop(struct regmap *map);
+
 /**
  * regmap_get_range() - Obtain the base memory address of a regmap range
  *
@@ -14,11 +14,18 @@
  * @label: Label for this device (allocated)
  * @filename: Name of file this is attached to, or NULL (allocated)
  * @fd: File descriptor of file, or 0 for none (file is not open)
+ * @map: File mapped into memory, or NULL if it could not be mapped, in which
+ *	case @fd is used for each access
+ * @map_size: Size of @map in bytes
+ * @map_rw: true if @map is writable, i.e. the file was opened read-write
  */
 struct host_sb_plat {
 	char *label;
 	char *filename;
 	int fd;
+	void *map;
+	off_t map_size;
+	bool map_rw;
 };
 
 /**
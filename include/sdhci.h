@@ -125,6 +125,7 @@
 #define  SDHCI_INT_CARD_INSERT	BIT(6)
 #define  SDHCI_INT_CARD_REMOVE	BIT(7)
 #define  SDHCI_INT_CARD_INT	BIT(8)
+#define  SDHCI_INT_CQE		BIT(14)
 #define  SDHCI_INT_ERROR	BIT(15)
 #define  SDHCI_INT_TIMEOUT	BIT(16)
 #define  SDHCI_INT_CRC		BIT(17)
@@ -253,6 +254,8 @@
 #define SDHCI_QUIRK_SUPPORT_SINGLE	(1 << 10)
 /* Capability register bit-63 indicates HS400 support */
 #define SDHCI_QUIRK_CAPS_BIT63_FOR_HS400	BIT(11)
+/* The controller cannot be used with CMD23 (SET_BLOCK_COUNT) */
+#define SDHCI_QUIRK_BROKEN_CMD23	BIT(12)
 
 /* to make gcc happy */
 struct sdhci_host;
@@ -362,6 +365,9 @@ struct sdhci_host {
 #if CONFIG_IS_ENABLED(MMC_SDHCI_ADMA)
 	struct sdhci_adma_desc *adma_desc_table;
 #endif
+#if CONFIG_IS_ENABLED(MMC_CQE)
+	struct cqhci_host *cqe;	/* Command queue engine, set up by the driver */
+#endif
 };
 
 #ifdef CONFIG_MMC_SDHCI_IO_ACCESSORS
@@ -1,6 +1,7 @@
 #ifndef __SERIAL_H__
 #define __SERIAL_H__
 
+#include <cyclic.h>
 #include <post.h>
 
 struct serial_device {
@@ -294,6 +295,13 @@ struct dm_serial_ops {
  * @buf:	Pointer to the RX buffer
  * @rd_ptr:	Read pointer in the RX buffer
  * @wr_ptr:	Write pointer in the RX buffer
+ *
+ * @tx_buf:	TX buffer, holding output not yet accepted by the UART
+ * @tx_rd:	Read pointer in the TX buffer
+ * @tx_wr:	Write pointer in the TX buffer
+ * @tx_busy:	true while the TX buffer is being drained, to avoid recursion
+ * @tx_cyclic:	Cyclic function which drains the TX buffer from schedule()
+ * @dev:	Serial device, for use by @tx_cyclic
  */
 struct serial_dev_priv {
 	struct stdio_dev *sdev;
@@ -303,6 +311,14 @@ struct serial_dev_priv {
 	uint rd_ptr;
 	uint wr_ptr;
 #endif
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+	char tx_buf[CONFIG_SERIAL_TX_BUFFER_SIZE];
+	uint tx_rd;
+	uint tx_wr;
+	bool tx_busy;
+	struct cyclic_info tx_cyclic;
+	struct udevice *dev;
+#endif
 };
 
 /* Access the serial operations for a device */
@@ -381,4 +397,19 @@ static inline void serial_flush(void) {}
 int serial_getc(void);
 int serial_tstc(void);
 
+/**
+ * serial_tx_congested() - Check whether console output is backing up
+ *
+ * Return: true if the TX buffer of the current serial device is more than
+ * three-quarters full, false if not or if there is no TX buffer
+ */
+#if CONFIG_IS_ENABLED(SERIAL_TX_BUFFER)
+bool serial_tx_congested(void);
+#else
+static inline bool serial_tx_congested(void)
+{
+	return false;
+}
+#endif
+
 #endif
@@ -190,6 +190,25 @@ static inline int spi_flash_erase(struct spi_flash *flash, u32 offset,
 }
 #endif
 
+/**
+ * spi_flash_update_sector() - Update part of a sector, if it has changed
+ *
+ * This reads the sector and compares it with the new data. If they differ, the
+ * sector is only erased if some bits must change from 0 to 1, and only the
+ * pages which differ are programmed.
+ *
+ * @flash: Flash to update
+ * @offset: Offset to write to
+ * @len: Number of bytes to write, which must not go past the end of the sector
+ * @buf: Data to write
+ * @cmp_buf: Buffer of flash->sector_size bytes, used to hold the sector
+ * @skipped: Incremented by @len if the data is unchanged
+ * Return: 0 if OK, -EINVAL if @len goes past the end of the sector, other -ve
+ *	on error
+ */
+int spi_flash_update_sector(struct spi_flash *flash, u32 offset, size_t len,
+			    const void *buf, void *cmp_buf, size_t *skipped);
+
 static inline int spi_flash_protect(struct spi_flash *flash, u32 ofs, u32 len,
 					bool prot)
 {
@@ -310,12 +310,38 @@ struct spl_load_info;
 typedef ulong (*spl_load_reader)(struct spl_load_info *load, ulong sector,
 				 ulong count, void *buf);
 
+/**
+ * spl_load_submit() - Start reading from device without waiting
+ *
+ * Only one read can be in progress at a time. It must be finished with
+ * the device's &spl_load_wait before anything else is read.
+ *
+ * @load: Information about the load state
+ * @offset: Offset to read from in bytes, as for spl_load_reader()
+ * @count: Number of bytes to read, as for spl_load_reader()
+ * @buf: Buffer to read into, which must stay valid until the read is done
+ * @return 0 if the read was started, -ve on error
+ */
+typedef int (*spl_load_submit)(struct spl_load_info *load, ulong sector,
+			       ulong count, void *buf);
+
+/**
+ * spl_load_wait() - Wait for a read started by spl_load_submit()
+ *
+ * @load: Information about the load state
+ * @return number of bytes read, 0 on error
+ */
+typedef ulong (*spl_load_wait)(struct spl_load_info *load);
+
 /**
  * Information required to load data from a device
  *
  * @read: Function to call to read from the device
  * @priv: Private data for the device
  * @bl_len: Block length for reading in bytes
+ * @submit: Function to start a read without waiting, or NULL if the device
+ *	    can only read synchronously
+ * @wait: Function to wait for a read started by @submit
  */
 struct spl_load_info {
 	spl_load_reader read;
@@ -323,6 +349,10 @@ struct spl_load_info {
 #if IS_ENABLED(CONFIG_SPL_LOAD_BLOCK)
 	int bl_len;
 #endif
+#if CONFIG_IS_ENABLED(FIT_STREAM)
+	spl_load_submit submit;
+	spl_load_wait wait;
+#endif
 };
 
 static inline int spl_get_bl_len(struct spl_load_info *info)
@@ -354,6 +384,31 @@ static inline void spl_load_init(struct spl_load_info *load,
 	load->read = h_read;
 	load->priv = priv;
 	spl_set_bl_len(load, bl_len);
+#if CONFIG_IS_ENABLED(FIT_STREAM)
+	load->submit = NULL;
+	load->wait = NULL;
+#endif
+}
+
+/**
+ * spl_load_set_async() - Let a loader start reads without waiting for them
+ *
+ * This is used by the FIT loader to read the next chunk of an image while
+ * the previous one is hashed or decompressed. It has no effect unless
+ * CONFIG_SPL_FIT_STREAM is enabled.
+ *
+ * @load: Load information set up by spl_load_init()
+ * @submit: Function to start a read
+ * @wait: Function to wait for the read to finish
+ */
+static inline void spl_load_set_async(struct spl_load_info *load,
+				      spl_load_submit submit,
+				      spl_load_wait wait)
+{
+#if CONFIG_IS_ENABLED(FIT_STREAM)
+	load->submit = submit;
+	load->wait = wait;
+#endif
 }
 
 /*
@@ -1095,9 +1150,50 @@ int spl_load_fit_image(struct spl_image_info *spl_image,
  */
 static inline bool spl_decompression_enabled(void)
 {
-	return IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_LZMA);
+	return IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_LZMA) ||
+		IS_ENABLED(CONFIG_SPL_LZ4) || IS_ENABLED(CONFIG_SPL_ZSTD);
 }
 
+#if CONFIG_IS_ENABLED(SCRATCH)
+/**
+ * spl_scratch_alloc() - allocate a temporary buffer in the SPL scratch area
+ *
+ * The scratch area is a region of DRAM (CONFIG_SPL_SCRATCH_ADDR) used for
+ * large buffers which are only needed while images are loaded, so that they
+ * do not take up the SPL heap. Buffers are cache-line aligned.
+ *
+ * @size: Number of bytes needed
+ * Return: pointer to the buffer, or NULL if there is not enough space left
+ */
+void *spl_scratch_alloc(size_t size);
+
+/**
+ * spl_scratch_mark() - note how much of the scratch area is in use
+ *
+ * Return: value to pass to spl_scratch_release()
+ */
+ulong spl_scratch_mark(void);
+
+/**
+ * spl_scratch_release() - free scratch buffers allocated since a mark
+ *
+ * @mark: Value returned by spl_scratch_mark()
+ */
+void spl_scratch_release(ulong mark);
+#else
+static inline void *spl_scratch_alloc(size_t size)
+{
+	return NULL;
+}
+
+static inline ulong spl_scratch_mark(void)
+{
+	return 0;
+}
+
+static inline void spl_scratch_release(ulong mark) {}
+#endif
+
 /**
  * spl_write_upl_handoff() - Write a Universal Payload hand-off structure
  *
@@ -0,0 +1,129 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Cooperative tasks, which let a long-running job yield while it waits
+ */
+
+#ifndef __task_h
+#define __task_h
+
+#include <linux/list.h>
+#include <linux/types.h>
+#include <u-boot/schedule.h>
+#ifdef CONFIG_HAVE_INITJMP
+#include <asm/setjmp.h>
+#endif
+
+struct task;
+
+/**
+ * typedef task_func_t - Function run by a task
+ *
+ * @arg: Argument passed to task_start()
+ * Return: result of the task, which is returned by task_join()
+ */
+typedef int (*task_func_t)(void *arg);
+
+/**
+ * struct task - A cooperative task
+ *
+ * This is normally embedded in the state of the driver which starts the task.
+ * It must remain valid until task_join() returns.
+ *
+ * @name: Name of the task, for messages
+ * @func: Function to run
+ * @arg: Argument for @func
+ * @stack: Stack allocated for the task, or NULL once it has finished
+ * @stack_size: Size of @stack in bytes
+ * @ctx: Saved context, used to switch back to the task after it yields
+ * @ret: Return value from @func, once @done is true
+ * @done: true once @func has returned
+ * @sibling: Node in the list of tasks which have not finished
+ */
+#ifdef CONFIG_HAVE_INITJMP
+struct task {
+	const char *name;
+	task_func_t func;
+	void *arg;
+	void *stack;
+	size_t stack_size;
+	jmp_buf ctx;
+	int ret;
+	bool done;
+	struct list_head sibling;
+};
+#endif
+
+#if CONFIG_IS_ENABLED(TASK)
+
+/**
+ * task_start() - Start a new task
+ *
+ * The task does not run until the next call to schedule()
+ *
+ * @task: Task to start
+ * @name: Name of the task
+ * @func: Function to run
+ * @arg: Argument for @func
+ * @stack_size: Stack size in bytes, or 0 to use CONFIG_TASK_STACK_SIZE
+ * Return: 0 if OK, -ENOMEM if there is no memory for the stack, other -ve
+ *	if the stack could not be set up
+ */
+int task_start(struct task *task, const char *name, task_func_t func,
+	       void *arg, size_t stack_size);
+
+/**
+ * task_yield() - Let other tasks run
+ *
+ * When called from a task, this switches back to the code which called
+ * schedule(), and returns the next time that the task is run. Otherwise it is
+ * the same as calling schedule().
+ *
+ * schedule() calls this from a task, so any delay or polling loop which calls
+ * schedule() yields.
+ */
+void task_yield(void);
+
+/**
+ * task_run_all() - Run each task until it yields or finishes
+ *
+ * This is called from schedule(). It does nothing when called from a task.
+ */
+void task_run_all(void);
+
+/**
+ * task_current() - Get the task which is running
+ *
+ * Return: the current task, or NULL if not running in a task
+ */
+struct task *task_current(void);
+
+/**
+ * task_join() - Wait for a task to finish
+ *
+ * This lets all tasks run until @task has finished
+ *
+ * @task: Task to wait for
+ * Return: result of the task's function, or -EDEADLK if called from @task
+ *	itself
+ */
+int task_join(struct task *task);
+
+#else
+
+static inline void task_yield(void)
+{
+	schedule();
+}
+
+static inline void task_run_all(void)
+{
+}
+
+static inline struct task *task_current(void)
+{
+	return NULL;
+}
+
+#endif
+
+#endif
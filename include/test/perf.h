@@ -0,0 +1,10 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+#ifndef __TEST_PERF_H__
+#define __TEST_PERF_H__
+
+#include <test/test.h>
+
+/* Declare a new performance test */
+#define PERF_TEST(_name, _flags)	UNIT_TEST(_name, _flags, perf_test)
+
+#endif /* __TEST_PERF_H__ */
@@ -57,6 +57,8 @@ enum tpm_version {
  * @pcr_select_min:	Minimum size in bytes of the pcrSelect array
  * @plat_hier_disabled:	Platform hierarchy has been disabled (TPM is locked
  *			down until next reboot)
+ * @active_pcr_banks:	Mask of active PCR banks (TCG2_BOOT_HASH_ALG_...), or 0
+ *			if not read from the TPM yet
  */
 struct tpm_chip_priv {
 	enum tpm_version version;
@@ -69,6 +71,7 @@ struct tpm_chip_priv {
 	uint pcr_count;
 	uint pcr_select_min;
 	bool plat_hier_disabled;
+	u32 active_pcr_banks;
 };
 
 /**
@@ -111,4 +111,81 @@ int trace_early_init(void);
  */
 int trace_init(void *buff, size_t buff_size);
 
+/**
+ * trace_sample_start() - Start sampling the program counter
+ *
+ * Any samples taken earlier are discarded. The sample buffer is allocated
+ * on first use.
+ *
+ * @hz: Number of samples to take each second
+ * Return: 0 if OK, -ENOMEM if out of memory, -EINVAL if @hz is 0, or other
+ *	-ve error if the architecture cannot take samples
+ */
+int trace_sample_start(unsigned int hz);
+
+/* trace_sample_stop() - Stop sampling the program counter */
+void trace_sample_stop(void);
+
+/**
+ * trace_sample_record() - Record a sample
+ *
+ * This is called by the architecture from its timer interrupt. Up to
+ * CONFIG_TRACE_SAMPLE_DEPTH callers are found by walking the frame records
+ * from @fp, as long as they lie between @sp and the top of the stack.
+ *
+ * @pc: Program counter of the interrupted code
+ * @fp: Frame pointer of the interrupted code
+ * @sp: Stack pointer of the interrupted code
+ */
+void trace_sample_record(unsigned long pc, unsigned long fp,
+			 unsigned long sp);
+
+/**
+ * trace_sample_folded() - Write the samples as folded stacks
+ *
+ * Each line holds a semicolon-separated call stack, outermost caller first,
+ * followed by a space and the number of samples with that stack. Addresses
+ * are unrelocated, so can be looked up in u-boot.map or with addr2line.
+ * This is the input format of flamegraph.pl
+ *
+ * Sampling must be stopped first.
+ *
+ * @buf: Buffer to write to; the output is nul-terminated if @size is not 0
+ * @size: Size of buffer, which may be 0 to find out how much is needed
+ * Return: length of the output, not counting the nul terminator
+ */
+int trace_sample_folded(char *buf, int size);
+
+/**
+ * trace_sample_pprof() - Write the samples as a legacy CPU profile
+ *
+ * This is the binary format written by gperftools, which pprof reads, e.g.
+ * with 'pprof u-boot profile.bin'. Sampling must be stopped first.
+ *
+ * @buf: Buffer to write to
+ * @size: Size of buffer, which may be 0 to find out how much is needed
+ * Return: number of bytes in the profile, which is more than @size if the
+ *	buffer is too small
+ */
+int trace_sample_pprof(void *buf, int size);
+
+/* trace_sample_print_stats() - Show information about sampling */
+void trace_sample_print_stats(void);
+
+/**
+ * arch_trace_sample_start() - Start the sampling timer
+ *
+ * The architecture calls trace_sample_record() from the timer interrupt
+ * until arch_trace_sample_stop() is called
+ *
+ * @hz: Number of samples to take each second
+ * @stack_top: Returns the top of the stack, above which frame records are
+ *	not looked for
+ * Return: 0 if OK, -ve on error
+ */
+int arch_trace_sample_start(unsigned int hz, unsigned long *stack_top);
+
+/* arch_trace_sample_stop() - Stop the sampling timer */
+void arch_trace_sample_stop(void);
+
 #endif
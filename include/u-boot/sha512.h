@@ -29,6 +29,23 @@ typedef struct {
 
 extern const uint8_t sha512_der_prefix[];
 
+/**
+ * sha512_process() - Hash whole blocks of data
+ *
+ * This is used by both SHA-384 and SHA-512. It may be provided by
+ * architecture code to make use of hardware support.
+ *
+ * @ctx:	Hashing context
+ * @data:	Data to hash
+ * @blocks:	Number of SHA512_BLOCK_SIZE blocks at @data
+ */
+void sha512_process(sha512_context *ctx, const uint8_t *data,
+		    unsigned int blocks);
+
+/* The portable C implementation of sha512_process() */
+void sha512_process_generic(sha512_context *ctx, const uint8_t *data,
+			    unsigned int blocks);
+
 void sha512_starts(sha512_context * ctx);
 void sha512_update(sha512_context *ctx, const uint8_t *input, uint32_t length);
 void sha512_finish(sha512_context * ctx, uint8_t digest[SHA512_SUM_LEN]);
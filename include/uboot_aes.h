@@ -107,4 +107,10 @@ void aes_cbc_encrypt_blocks(u32 key_size, u8 *key_exp, u8 *iv, u8 *src, u8 *dst,
 void aes_cbc_decrypt_blocks(u32 key_size, u8 *key_exp, u8 *iv, u8 *src, u8 *dst,
 			    u32 num_aes_blocks);
 
+/* The portable C implementations of aes_cbc_encrypt/decrypt_blocks() */
+void aes_cbc_encrypt_blocks_generic(u32 key_size, u8 *key_exp, u8 *iv, u8 *src,
+				    u8 *dst, u32 num_aes_blocks);
+void aes_cbc_decrypt_blocks_generic(u32 key_size, u8 *key_exp, u8 *iv, u8 *src,
+				    u8 *dst, u32 num_aes_blocks);
+
 #endif /* _AES_REF_H_ */
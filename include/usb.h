@@ -658,11 +658,14 @@ struct usb_dev_plat {
  *		so this will be false.
  * @companion:  True if this is a companion controller to another USB
  *		controller
+ * @scan_ret:	Result of scanning for the root hub, kept until the bus is
+ *		reported when CONFIG_USB_SCAN_PARALLEL is enabled
  */
 struct usb_bus_priv {
 	int next_addr;
 	bool desc_before_addr;
 	bool companion;
+	int scan_ret;
 };
 
 /**
@@ -941,6 +944,25 @@ bool usb_device_has_child_on_port(struct usb_device *parent, int port);
 int usb_hub_probe(struct usb_device *dev, int ifnum);
 void usb_hub_reset(void);
 
+/**
+ * usb_hub_scan_hold() - Hold back scanning of hub ports
+ *
+ * While held, configuring a hub powers up its ports and queues them to be
+ * scanned, but does not wait for them. This allows the ports of several
+ * controllers to power up and debounce together.
+ */
+void usb_hub_scan_hold(void);
+
+/**
+ * usb_hub_scan_release() - Scan the hub ports queued while held
+ *
+ * This scans all queued ports, along with those of any hubs found on them,
+ * until every port has a device or has timed out
+ *
+ * Return: 0 if OK, -ve on error
+ */
+int usb_hub_scan_release(void);
+
 /*
  * usb_find_usb2_hub_address_port() - Get hub address and port for TT setting
  *
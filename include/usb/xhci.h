@@ -1260,6 +1260,23 @@ int xhci_ctrl_tx(struct usb_device *udev, unsigned long pipe,
 int xhci_check_maxpacket(struct usb_device *udev);
 void xhci_flush_cache(uintptr_t addr, u32 type_len);
 void xhci_inval_cache(uintptr_t addr, u32 type_len);
+
+struct dcache_batch;
+
+/**
+ * xhci_cache_batch_start() - Collect cache flushes in a batch
+ *
+ * Until xhci_cache_batch_end() is called, xhci_flush_cache() adds to @batch
+ * rather than flushing straight away
+ *
+ * @batch: Batch to use
+ */
+void xhci_cache_batch_start(struct dcache_batch *batch);
+
+/**
+ * xhci_cache_batch_end() - Do the flushes collected since the batch started
+ */
+void xhci_cache_batch_end(void);
 void xhci_cleanup(struct xhci_ctrl *ctrl);
 struct xhci_ring *xhci_ring_alloc(struct xhci_ctrl *ctrl, unsigned int num_segs,
 				  bool link_trbs);
@@ -96,6 +96,24 @@ enum video_format {
  * @bg_col_idx:	Background color code (bit 3 = bold, bit 0-2 = color)
  * @last_sync:	Monotonic time of last video sync
  */
+/**
+ * struct video_damage - Area of the frame buffer written since the last sync
+ *
+ * This is only used with CONFIG_VIDEO_DAMAGE. The area is empty when @xend is
+ * not greater than @xstart.
+ *
+ * @xstart:	Left edge of the area, in pixels
+ * @ystart:	Top edge of the area, in pixels
+ * @xend:	Right edge of the area (exclusive), in pixels
+ * @yend:	Bottom edge of the area (exclusive), in pixels
+ */
+struct video_damage {
+	int xstart;
+	int ystart;
+	int xend;
+	int yend;
+};
+
 struct video_priv {
 	/* Things set up by the driver: */
 	ushort xsize;
@@ -120,6 +138,7 @@ struct video_priv {
 	u8 fg_col_idx;
 	u8 bg_col_idx;
 	ulong last_sync;
+	struct video_damage damage;
 };
 
 /**
@@ -231,6 +250,21 @@ int video_clear(struct udevice *dev);
  */
 int video_fill(struct udevice *dev, u32 colour);
 
+/**
+ * video_fill_pixels() - Fill a run of pixels with a colour
+ *
+ * This writes whole machine words where it can, so is much faster than
+ * writing one pixel at a time. Only 8, 16 and 32bpp are supported; nothing is
+ * written for other depths.
+ *
+ * @dst:	Address of the first pixel, which must be aligned to the pixel size
+ * @colour:	Colour to write, in the frame buffer's format
+ * @pixels:	Number of pixels to write
+ * @bpix:	Pixel depth
+ */
+void video_fill_pixels(void *dst, u32 colour, int pixels,
+		       enum video_log2_bpp bpix);
+
 /**
  * video_fill_part() - Erase a region
  *
@@ -300,6 +334,26 @@ void video_bmp_get_info(void *bmp_image, ulong *widthp, ulong *heightp,
 int video_bmp_display(struct udevice *dev, ulong bmp_image, int x, int y,
 		      bool align);
 
+/**
+ * video_bmp_display_gz() - Display a gzipped BMP file without unpacking it
+ *
+ * The pixel data is decompressed one row at a time and written straight to
+ * the frame buffer, so no buffer is needed for the whole image. RLE8-encoded
+ * images are not supported this way.
+ *
+ * @dev:	Device to display the bitmap on
+ * @addr:	Address of the gzipped bitmap image
+ * @len:	Maximum length of the gzipped data
+ * @x:		X position in pixels from the left
+ * @y:		Y position in pixels from the top
+ * @align:	true to adjust the coordinates, see video_bmp_display()
+ * Return: 0 if OK, -ENOENT if this is not a gzipped BMP image,
+ *	-EPROTONOSUPPORT if the image must be fully decompressed to be shown,
+ *	other -ve on error
+ */
+int video_bmp_display_gz(struct udevice *dev, ulong addr, ulong len, int x,
+			 int y, bool align);
+
 /**
  * video_get_xsize() - Get the width of the display in pixels
  *
@@ -341,12 +395,13 @@ void video_set_default_colors(struct udevice *dev, bool invert);
  */
 int video_default_font_height(struct udevice *dev);
 
-#ifdef CONFIG_VIDEO_COPY
+#if defined(CONFIG_VIDEO_COPY) || defined(CONFIG_VIDEO_DAMAGE)
 /**
  * vidconsole_sync_copy() - Sync back to the copy framebuffer
  *
  * This ensures that the copy framebuffer has the same data as the framebuffer
- * for a particular region. It should be called after the framebuffer is updated
+ * for a particular region. It should be called after the framebuffer is updated.
+ * With CONFIG_VIDEO_DAMAGE it also records the region as damaged.
  *
  * @from and @to can be in either order. The region between them is synced.
  *
@@ -378,6 +433,27 @@ static inline int video_sync_copy_all(struct udevice *dev)
 
 #endif
 
+#ifdef CONFIG_VIDEO_DAMAGE
+/**
+ * video_damage() - Record that part of the frame buffer has been written
+ *
+ * The area is merged into the device's damaged area, which is flushed and
+ * reset by the next video_sync(). Parts outside the display are ignored.
+ *
+ * @vid: Video device being updated
+ * @x: Left edge of the area, in pixels
+ * @y: Top edge of the area, in pixels
+ * @width: Width of the area, in pixels
+ * @height: Height of the area, in pixels
+ */
+void video_damage(struct udevice *vid, int x, int y, int width, int height);
+#else
+static inline void video_damage(struct udevice *vid, int x, int y, int width,
+				int height)
+{
+}
+#endif
+
 /**
  * video_is_active() - Test if one video device it active
  *
@@ -0,0 +1,70 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Running compute jobs on secondary CPUs
+ */
+
+#ifndef __WORKER_H
+#define __WORKER_H
+
+/**
+ * typedef worker_fn - Carry out one job
+ *
+ * This may run on any CPU, at the same time as other jobs. It must only
+ * compute on the memory it is given: no console output, driver calls,
+ * malloc() or changes to other global state.
+ *
+ * @priv: Private data passed to worker_run()
+ * @job: Job number, from 0 to one less than the number of jobs
+ */
+typedef void (*worker_fn)(void *priv, int job);
+
+#if CONFIG_IS_ENABLED(WORKER_CPUS)
+/**
+ * worker_run() - Run a set of jobs, using secondary CPUs if available
+ *
+ * The boot CPU takes jobs too, so this works (sequentially) when no other
+ * CPU can be started. Secondary CPUs are powered off again before this
+ * returns, so they are free for the OS to start.
+ *
+ * @fn: Function to call for each job
+ * @priv: Private data to pass to @fn
+ * @count: Number of jobs
+ * Return: number of CPUs which ran the jobs, including the boot CPU
+ */
+int worker_run(worker_fn fn, void *priv, int count);
+#else
+static inline int worker_run(worker_fn fn, void *priv, int count)
+{
+	int job;
+
+	for (job = 0; job < count; job++)
+		fn(priv, job);
+
+	return 1;
+}
+#endif
+
+/**
+ * worker_secondary() - Take jobs until there are none left
+ *
+ * This is called by architecture code on each secondary CPU it starts.
+ */
+void worker_secondary(void);
+
+/**
+ * arch_worker_start() - Start secondary CPUs to take jobs
+ *
+ * Each CPU started must call worker_secondary() and then tell
+ * arch_worker_stop() that it is done.
+ *
+ * @max: Most CPUs to start
+ * Return: number of CPUs started
+ */
+int arch_worker_start(int max);
+
+/**
+ * arch_worker_stop() - Wait for started CPUs to finish and power off
+ */
+void arch_worker_stop(void);
+
+#endif /* __WORKER_H */
@@ -31,6 +31,7 @@
 #define xyzModem_ymodem 2
 /* Don't define this until the protocol support is in place */
 /*#define xyzModem_zmodem 3 */
+#define xyzModem_ymodem_g 4	/* YMODEM-g, streaming without ACKs */
 
 #define xyzModem_access   -1
 #define xyzModem_noZmodem -2
@@ -28,6 +28,7 @@
 #else
 #include <string.h>
 #endif
+#include <linux/compiler_attributes.h>
 #include "uboot_aes.h"
 
 /* forward s-box */
@@ -633,8 +634,8 @@ void aes_apply_cbc_chain_data(u8 *cbc_chain_data, u8 *src, u8 *dst)
 		*dst++ = *src++ ^ *cbc_chain_data++;
 }
 
-void aes_cbc_encrypt_blocks(u32 key_len, u8 *key_exp, u8 *iv, u8 *src, u8 *dst,
-			    u32 num_aes_blocks)
+void aes_cbc_encrypt_blocks_generic(u32 key_len, u8 *key_exp, u8 *iv, u8 *src,
+				    u8 *dst, u32 num_aes_blocks)
 {
 	u8 tmp_data[AES_BLOCK_LENGTH];
 	u8 *cbc_chain_data = iv;
@@ -659,8 +660,8 @@ void aes_cbc_encrypt_blocks(u32 key_len, u8 *key_exp, u8 *iv, u8 *src, u8 *dst,
 	}
 }
 
-void aes_cbc_decrypt_blocks(u32 key_len, u8 *key_exp, u8 *iv, u8 *src, u8 *dst,
-			    u32 num_aes_blocks)
+void aes_cbc_decrypt_blocks_generic(u32 key_len, u8 *key_exp, u8 *iv, u8 *src,
+				    u8 *dst, u32 num_aes_blocks)
 {
 	u8 tmp_data[AES_BLOCK_LENGTH], tmp_block[AES_BLOCK_LENGTH];
 	/* Convenient array of 0's for IV */
@@ -688,3 +689,17 @@ void aes_cbc_decrypt_blocks(u32 key_len, u8 *key_exp, u8 *iv, u8 *src, u8 *dst,
 		dst += AES_BLOCK_LENGTH;
 	}
 }
+
+__weak void aes_cbc_encrypt_blocks(u32 key_len, u8 *key_exp, u8 *iv, u8 *src,
+				   u8 *dst, u32 num_aes_blocks)
+{
+	aes_cbc_encrypt_blocks_generic(key_len, key_exp, iv, src, dst,
+				       num_aes_blocks);
+}
+
+__weak void aes_cbc_decrypt_blocks(u32 key_len, u8 *key_exp, u8 *iv, u8 *src,
+				   u8 *dst, u32 num_aes_blocks)
+{
+	aes_cbc_decrypt_blocks_generic(key_len, key_exp, iv, src, dst,
+				       num_aes_blocks);
+}
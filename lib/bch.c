@@ -387,7 +387,7 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 			      unsigned int *syn)
 {
 	int i, j, s;
-	unsigned int m;
+	unsigned int m, e, step;
 	uint32_t poly;
 	const int t = GF_T(bch);
 
@@ -405,8 +405,16 @@ static void compute_syndromes(struct bch_control *bch, uint32_t *ecc,
 		s -= 32;
 		while (poly) {
 			i = deg(poly);
-			for (j = 0; j < 2*t; j += 2)
-				syn[j] ^= a_pow(bch, (j+1)*(i+s));
+			/*
+			 * walk a^((j+1)(i+s)) by multiplying by a^(2(i+s)) each
+			 * time, rather than reducing a large product modulo n
+			 */
+			e = i+s;
+			step = mod_s(bch, 2*e);
+			for (j = 0; j < 2*t; j += 2) {
+				syn[j] ^= bch->a_pow_tab[e];
+				e = mod_s(bch, e+step);
+			}
 
 			poly ^= (1 << i);
 		}
@@ -12,9 +12,29 @@
 
 #include <compiler.h>
 
+/* Bit-reflected CRC32C (Castagnoli) polynomial */
+#define CRC32C_POLY_LE	0x82f63b78
+
 uint32_t crc32c_cal(uint32_t crc, const char *data, int length,
 		    uint32_t *crc32c_table)
 {
+#ifdef CONFIG_ARM64_CRC32
+	/*
+	 * The CRC32C instructions use the Castagnoli polynomial, which is
+	 * entry 128 of a table set up by crc32c_init() for it
+	 */
+	if (crc32c_table[128] == CRC32C_POLY_LE) {
+		for (; length > 0 && ((uintptr_t)data & 7); length--)
+			crc = __builtin_aarch64_crc32cb(crc, *data++);
+		for (; length >= 8; length -= 8, data += 8)
+			crc = __builtin_aarch64_crc32cx(crc,
+					le64_to_cpu(*(const uint64_t *)data));
+		for (; length > 0; length--)
+			crc = __builtin_aarch64_crc32cb(crc, *data++);
+
+		return crc;
+	}
+#endif
 	while (length--)
 		crc = crc32c_table[(u8)(crc ^ *data++)] ^ (crc >> 8);
 
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Batched cache maintenance, for drivers which set up several descriptors
+ * and buffers before starting DMA
+ *
+ * Each cache-maintenance call normally ends with a barrier, which waits for
+ * the operation to reach the point of coherency. Batching lets adjacent and
+ * overlapping ranges be merged, with one barrier at the end.
+ */
+
+#include <cpu_func.h>
+#include <asm/cache.h>
+#include <linux/kernel.h>
+
+__weak void flush_dcache_range_nosync(unsigned long start, unsigned long stop)
+{
+	flush_dcache_range(start, stop);
+}
+
+__weak void invalidate_dcache_range_nosync(unsigned long start,
+					   unsigned long stop)
+{
+	invalidate_dcache_range(start, stop);
+}
+
+__weak void dcache_range_sync(void)
+{
+}
+
+void dcache_batch_init(struct dcache_batch *batch)
+{
+	batch->num_flush = 0;
+	batch->num_inval = 0;
+}
+
+/**
+ * batch_add() - Add a range to a list, merging it with any it touches
+ *
+ * @range: List of ranges
+ * @count: Number of ranges in the list, updated by this function
+ * @start: Start address, aligned to a cache line
+ * @end: End address, aligned to a cache line
+ * Return: true if added, false if the list is full
+ */
+static bool batch_add(struct dcache_batch_range *range, int *count,
+		      ulong start, ulong end)
+{
+	int i, j;
+
+	for (i = 0; i < *count; i++) {
+		if (start > range[i].end || end < range[i].start)
+			continue;
+		start = min(start, range[i].start);
+		end = max(end, range[i].end);
+
+		/* The larger range may now touch others, so absorb them */
+		for (j = i + 1; j < *count;) {
+			if (start > range[j].end || end < range[j].start) {
+				j++;
+				continue;
+			}
+			start = min(start, range[j].start);
+			end = max(end, range[j].end);
+			range[j] = range[--*count];
+		}
+		range[i].start = start;
+		range[i].end = end;
+
+		return true;
+	}
+	if (*count == DCACHE_BATCH_RANGES)
+		return false;
+	range[*count].start = start;
+	range[(*count)++].end = end;
+
+	return true;
+}
+
+void dcache_batch_flush(struct dcache_batch *batch, ulong start, ulong stop)
+{
+	start = rounddown(start, ARCH_DMA_MINALIGN);
+	stop = roundup(stop, ARCH_DMA_MINALIGN);
+	if (!batch_add(batch->flush, &batch->num_flush, start, stop)) {
+		dcache_batch_sync(batch);
+		batch_add(batch->flush, &batch->num_flush, start, stop);
+	}
+}
+
+void dcache_batch_invalidate(struct dcache_batch *batch, ulong start,
+			     ulong stop)
+{
+	start = rounddown(start, ARCH_DMA_MINALIGN);
+	stop = roundup(stop, ARCH_DMA_MINALIGN);
+	if (!batch_add(batch->inval, &batch->num_inval, start, stop)) {
+		dcache_batch_sync(batch);
+		batch_add(batch->inval, &batch->num_inval, start, stop);
+	}
+}
+
+void dcache_batch_sync(struct dcache_batch *batch)
+{
+	ulong total = 0;
+	int i;
+
+	if (!batch->num_flush && !batch->num_inval)
+		return;
+	for (i = 0; i < batch->num_flush; i++)
+		total += batch->flush[i].end - batch->flush[i].start;
+
+	/* Flushing the whole cache by set/way includes its own barriers */
+	if (CONFIG_DCACHE_BATCH_FLUSH_ALL_SIZE &&
+	    total >= CONFIG_DCACHE_BATCH_FLUSH_ALL_SIZE) {
+		flush_dcache_all();
+	} else {
+		for (i = 0; i < batch->num_flush; i++)
+			flush_dcache_range_nosync(batch->flush[i].start,
+						  batch->flush[i].end);
+	}
+
+	/* Invalidation discards data, so is only ever done by address */
+	for (i = 0; i < batch->num_inval; i++)
+		invalidate_dcache_range_nosync(batch->inval[i].start,
+					       batch->inval[i].end);
+	dcache_range_sync();
+	dcache_batch_init(batch);
+}
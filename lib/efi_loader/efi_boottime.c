@@ -10,6 +10,7 @@
 #include <dm/device.h>
 #include <dm/root.h>
 #include <efi_loader.h>
+#include <efi_variable.h>
 #include <irq_func.h>
 #include <log.h>
 #include <malloc.h>
@@ -877,6 +878,10 @@ void efi_timer_check(void)
 		evt->is_signaled = false;
 		efi_signal_event(evt);
 	}
+	if (IS_ENABLED(CONFIG_EFI_BLOCK_IO2))
+		efi_disk_check_io();
+	if (IS_ENABLED(CONFIG_EFI_VARIABLE_FILE_STORE))
+		efi_var_file_check();
 	efi_process_event_queue();
 	schedule();
 }
@@ -2114,9 +2119,12 @@ efi_status_t EFIAPI efi_load_image(bool boot_policy,
 	efi_dp_split_file_path(file_path, &dp, &fp);
 	ret = efi_setup_loaded_image(dp, fp, image_obj, &info);
 	if (ret == EFI_SUCCESS)
-		ret = efi_load_pe(*image_obj, dest_buffer, source_size, info);
-	if (!source_buffer)
-		/* Release buffer to which file was loaded */
+		ret = efi_load_pe(*image_obj, dest_buffer, source_size,
+				  !source_buffer, info);
+	/* Release buffer to which file was loaded unless it holds the image */
+	if (!source_buffer &&
+	    (!info || info->image_base != dest_buffer ||
+	     (ret != EFI_SUCCESS && ret != EFI_SECURITY_VIOLATION)))
 		efi_free_pages((uintptr_t)dest_buffer,
 			       efi_size_in_pages(source_size));
 	if (ret == EFI_SUCCESS || ret == EFI_SECURITY_VIOLATION) {
@@ -3260,6 +3268,8 @@ efi_status_t EFIAPI efi_start_image(efi_handle_t image_handle,
 		EFI_PRINT("%lu returned by started image\n",
 			  (unsigned long)((uintptr_t)exit_status &
 			  ~EFI_ERROR_MASK));
+		if (IS_ENABLED(CONFIG_EFI_VARIABLE_FILE_STORE))
+			efi_var_file_flush();
 		current_image = parent_image;
 		return EFI_EXIT(exit_status);
 	}
@@ -24,6 +24,7 @@ struct efi_system_partition efi_system_partition = {
 };
 
 const efi_guid_t efi_block_io_guid = EFI_BLOCK_IO_PROTOCOL_GUID;
+const efi_guid_t efi_block_io2_guid = EFI_BLOCK_IO2_PROTOCOL_GUID;
 const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 
 /**
@@ -31,6 +32,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
  *
  * @header:	EFI object header
  * @ops:	EFI disk I/O protocol interface
+ * @ops2:	EFI block I/O 2 protocol interface
  * @media:	block I/O media information
  * @dp:		device path to the block device
  * @volume:	simple file system protocol of the partition
@@ -38,6 +40,7 @@ const efi_guid_t efi_system_partition_guid = PARTITION_SYSTEM_GUID;
 struct efi_disk_obj {
 	struct efi_object header;
 	struct efi_block_io ops;
+	struct efi_block_io2 ops2;
 	struct efi_block_io_media media;
 	struct efi_device_path *dp;
 	struct efi_simple_file_system_protocol *volume;
@@ -147,6 +150,36 @@ static efi_status_t efi_disk_rw_blocks(struct efi_block_io *this,
 	return EFI_SUCCESS;
 }
 
+/**
+ * efi_disk_check_rw() - check the parameters of a block read or write
+ *
+ * @media:			media being accessed
+ * @media_id:			id of the medium to be accessed
+ * @lba:			starting logical block
+ * @buffer_size:		size of the buffer
+ * @buffer:			pointer to the buffer
+ * Return:			status code
+ */
+static efi_status_t efi_disk_check_rw(struct efi_block_io_media *media,
+				      u32 media_id, u64 lba,
+				      efi_uintn_t buffer_size, void *buffer)
+{
+	/* TODO: check for media changes */
+	if (media_id != media->media_id)
+		return EFI_MEDIA_CHANGED;
+	if (!media->media_present)
+		return EFI_NO_MEDIA;
+	/* media->io_align is a power of 2 or 0 */
+	if (media->io_align &&
+	    (uintptr_t)buffer & (media->io_align - 1))
+		return EFI_INVALID_PARAMETER;
+	if (lba * media->block_size + buffer_size >
+	    (media->last_block + 1) * media->block_size)
+		return EFI_INVALID_PARAMETER;
+
+	return EFI_SUCCESS;
+}
+
 /**
  * efi_disk_read_blocks() - reads blocks from device
  *
@@ -171,18 +204,9 @@ static efi_status_t EFIAPI efi_disk_read_blocks(struct efi_block_io *this,
 
 	if (!this)
 		return EFI_INVALID_PARAMETER;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
+	r = efi_disk_check_rw(this->media, media_id, lba, buffer_size, buffer);
+	if (r != EFI_SUCCESS)
+		return r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
@@ -239,18 +263,9 @@ static efi_status_t EFIAPI efi_disk_write_blocks(struct efi_block_io *this,
 		return EFI_INVALID_PARAMETER;
 	if (this->media->read_only)
 		return EFI_WRITE_PROTECTED;
-	/* TODO: check for media changes */
-	if (media_id != this->media->media_id)
-		return EFI_MEDIA_CHANGED;
-	if (!this->media->media_present)
-		return EFI_NO_MEDIA;
-	/* media->io_align is a power of 2 or 0 */
-	if (this->media->io_align &&
-	    (uintptr_t)buffer & (this->media->io_align - 1))
-		return EFI_INVALID_PARAMETER;
-	if (lba * this->media->block_size + buffer_size >
-	    (this->media->last_block + 1) * this->media->block_size)
-		return EFI_INVALID_PARAMETER;
+	r = efi_disk_check_rw(this->media, media_id, lba, buffer_size, buffer);
+	if (r != EFI_SUCCESS)
+		return r;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 	if (buffer_size > EFI_LOADER_BOUNCE_BUFFER_SIZE) {
@@ -307,6 +322,257 @@ static const struct efi_block_io block_io_disk_template = {
 	.flush_blocks = &efi_disk_flush_blocks,
 };
 
+#if IS_ENABLED(CONFIG_EFI_BLOCK_IO2)
+/**
+ * struct efi_disk_io2_req - read started by ReadBlocksEx()
+ *
+ * @link:	node in efi_disk_io2_reqs
+ * @diskobj:	disk being read
+ * @token:	token of the caller, signalled when the read is complete
+ * @req:	block-layer request
+ */
+struct efi_disk_io2_req {
+	struct list_head link;
+	struct efi_disk_obj *diskobj;
+	struct efi_block_io2_token *token;
+	struct blk_req req;
+};
+
+/* Reads which have been started but not yet signalled */
+static LIST_HEAD(efi_disk_io2_reqs);
+
+/**
+ * efi_disk_io2_complete() - record the result of a read and signal it
+ *
+ * @io:		request which has finished, which is freed
+ * @ret:	result of the block-layer request
+ */
+static void efi_disk_io2_complete(struct efi_disk_io2_req *io, long ret)
+{
+	struct efi_block_io2_token *token = io->token;
+
+	token->transaction_status = ret == io->req.blkcnt ? EFI_SUCCESS :
+		EFI_DEVICE_ERROR;
+	list_del(&io->link);
+	free(io);
+	efi_signal_event(token->event);
+}
+
+/**
+ * efi_disk_io2_finish() - wait for all outstanding reads from a disk
+ *
+ * @diskobj:	disk to wait for, or NULL for all disks
+ */
+static void efi_disk_io2_finish(struct efi_disk_obj *diskobj)
+{
+	struct efi_disk_io2_req *io, *next;
+
+	list_for_each_entry_safe(io, next, &efi_disk_io2_reqs, link) {
+		if (!diskobj || io->diskobj == diskobj)
+			efi_disk_io2_complete(io, blk_req_wait(&io->req));
+	}
+}
+
+void efi_disk_check_io(void)
+{
+	struct efi_disk_io2_req *io, *next;
+
+	list_for_each_entry_safe(io, next, &efi_disk_io2_reqs, link) {
+		int ret;
+
+		ret = blk_req_poll(&io->req);
+		if (ret == -EBUSY)
+			continue;
+		efi_disk_io2_complete(io, ret ? ret : io->req.done);
+	}
+}
+
+/**
+ * efi_disk_io2_signal() - signal completion of a synchronous operation
+ *
+ * @token:	token of the caller, or NULL if the call was blocking
+ * @ret:	result of the operation
+ * Return:	result to return to the caller
+ */
+static efi_status_t efi_disk_io2_signal(struct efi_block_io2_token *token,
+					efi_status_t ret)
+{
+	if (ret == EFI_SUCCESS && token && token->event) {
+		token->transaction_status = EFI_SUCCESS;
+		efi_signal_event(token->event);
+	}
+
+	return ret;
+}
+
+/**
+ * efi_disk_reset_ex() - reset block device
+ *
+ * This function implements the Reset service of the EFI_BLOCK_IO2_PROTOCOL.
+ * Outstanding reads are completed first.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @extended_verification:	extended verification
+ * Return:			status code
+ */
+static efi_status_t EFIAPI efi_disk_reset_ex(struct efi_block_io2 *this,
+					     char extended_verification)
+{
+	EFI_ENTRY("%p, %x", this, extended_verification);
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	efi_disk_io2_finish(container_of(this, struct efi_disk_obj, ops2));
+
+	return EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_read_blocks_ex() - reads blocks from device
+ *
+ * This function implements the ReadBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL. If @token has an event, the read is started and
+ * the event is signalled from efi_timer_check() once it is complete.
+ *
+ * See the Unified Extensible Firmware Interface (UEFI) specification for
+ * details.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be read from
+ * @lba:			starting logical block for reading
+ * @token:			token for a non-blocking read, or NULL
+ * @buffer_size:		size of the read buffer
+ * @buffer:			pointer to the destination buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI
+efi_disk_read_blocks_ex(struct efi_block_io2 *this, u32 media_id, u64 lba,
+			struct efi_block_io2_token *token,
+			efi_uintn_t buffer_size, void *buffer)
+{
+	struct efi_disk_obj *diskobj;
+	struct efi_disk_io2_req *io;
+	struct udevice *dev;
+	efi_status_t ret;
+	u32 blksz;
+
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+
+	/* The bounce buffer is shared, so bounced reads are blocking */
+	if (!token || !token->event ||
+	    IS_ENABLED(CONFIG_EFI_LOADER_BOUNCE_BUFFER)) {
+		ret = EFI_CALL(efi_disk_read_blocks(&diskobj->ops, media_id,
+						    lba, buffer_size, buffer));
+		return EFI_EXIT(efi_disk_io2_signal(token, ret));
+	}
+
+	ret = efi_disk_check_rw(this->media, media_id, lba, buffer_size,
+				buffer);
+	if (ret != EFI_SUCCESS)
+		return EFI_EXIT(ret);
+	blksz = this->media->block_size;
+	if (buffer_size & (blksz - 1))
+		return EFI_EXIT(EFI_BAD_BUFFER_SIZE);
+
+	io = calloc(1, sizeof(*io));
+	if (!io)
+		return EFI_EXIT(EFI_OUT_OF_RESOURCES);
+	io->diskobj = diskobj;
+	io->token = token;
+
+	dev = diskobj->header.dev;
+	if (CONFIG_IS_ENABLED(PARTITIONS) &&
+	    device_get_uclass_id(dev) == UCLASS_PARTITION) {
+		struct disk_part *part = dev_get_uclass_plat(dev);
+
+		lba += part->gpt_part_info.start;
+		dev = dev_get_parent(dev);
+	}
+	if (blk_read_submit(dev, lba, buffer_size / blksz, buffer, &io->req)) {
+		free(io);
+		return EFI_EXIT(EFI_DEVICE_ERROR);
+	}
+	token->transaction_status = EFI_NOT_READY;
+	list_add_tail(&io->link, &efi_disk_io2_reqs);
+
+	return EFI_EXIT(EFI_SUCCESS);
+}
+
+/**
+ * efi_disk_write_blocks_ex() - writes blocks to device
+ *
+ * This function implements the WriteBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL. Writes always complete before returning, so any
+ * event in @token is signalled straight away.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @media_id:			id of the medium to be written to
+ * @lba:			starting logical block for writing
+ * @token:			token for a non-blocking write, or NULL
+ * @buffer_size:		size of the write buffer
+ * @buffer:			pointer to the source buffer
+ * Return:			status code
+ */
+static efi_status_t EFIAPI
+efi_disk_write_blocks_ex(struct efi_block_io2 *this, u32 media_id, u64 lba,
+			 struct efi_block_io2_token *token,
+			 efi_uintn_t buffer_size, void *buffer)
+{
+	struct efi_disk_obj *diskobj;
+	efi_status_t ret;
+
+	EFI_ENTRY("%p, %x, %llx, %p, %zx, %p", this, media_id, lba, token,
+		  buffer_size, buffer);
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	diskobj = container_of(this, struct efi_disk_obj, ops2);
+
+	/* Don't let a read started earlier see the new data */
+	efi_disk_io2_finish(diskobj);
+	ret = EFI_CALL(efi_disk_write_blocks(&diskobj->ops, media_id, lba,
+					     buffer_size, buffer));
+
+	return EFI_EXIT(efi_disk_io2_signal(token, ret));
+}
+
+/**
+ * efi_disk_flush_blocks_ex() - flushes modified data to the device
+ *
+ * This function implements the FlushBlocksEx service of the
+ * EFI_BLOCK_IO2_PROTOCOL. As we always write synchronously this only waits
+ * for outstanding reads.
+ *
+ * @this:			pointer to the BLOCK_IO2_PROTOCOL
+ * @token:			token for a non-blocking flush, or NULL
+ * Return:			status code
+ */
+static efi_status_t EFIAPI
+efi_disk_flush_blocks_ex(struct efi_block_io2 *this,
+			 struct efi_block_io2_token *token)
+{
+	EFI_ENTRY("%p, %p", this, token);
+	if (!this)
+		return EFI_EXIT(EFI_INVALID_PARAMETER);
+	efi_disk_io2_finish(container_of(this, struct efi_disk_obj, ops2));
+
+	return EFI_EXIT(efi_disk_io2_signal(token, EFI_SUCCESS));
+}
+
+static const struct efi_block_io2 block_io2_disk_template = {
+	.reset = &efi_disk_reset_ex,
+	.read_blocks_ex = &efi_disk_read_blocks_ex,
+	.write_blocks_ex = &efi_disk_write_blocks_ex,
+	.flush_blocks_ex = &efi_disk_flush_blocks_ex,
+};
+#else
+static inline void efi_disk_io2_finish(struct efi_disk_obj *diskobj)
+{
+}
+#endif
+
 /**
  * efi_fs_from_path() - retrieve simple file system protocol
  *
@@ -504,6 +770,14 @@ static efi_status_t efi_disk_add_dev(
 			goto error;
 	}
 	diskobj->ops = block_io_disk_template;
+#if IS_ENABLED(CONFIG_EFI_BLOCK_IO2)
+	diskobj->ops2 = block_io2_disk_template;
+	diskobj->ops2.media = &diskobj->media;
+	ret = efi_add_protocol(&diskobj->header, &efi_block_io2_guid,
+			       &diskobj->ops2);
+	if (ret != EFI_SUCCESS)
+		goto error;
+#endif
 
 	/* Fill in EFI IO Media info (for read/write callbacks) */
 	diskobj->media.removable_media = desc->removable;
@@ -754,6 +1028,7 @@ int efi_disk_remove(void *ctx, struct event *event)
 	dp = diskobj->dp;
 	volume = diskobj->volume;
 
+	efi_disk_io2_finish(diskobj);
 	ret = efi_delete_handle(handle);
 	/* Do not delete DM device if there are still EFI drivers attached. */
 	if (ret != EFI_SUCCESS)
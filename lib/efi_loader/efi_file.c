@@ -24,6 +24,8 @@ struct file_system {
 	struct efi_device_path *dp;
 	struct blk_desc *desc;
 	int part;
+	/* modification count, invalidates cached file sizes */
+	unsigned int gen;
 };
 #define to_fs(x) container_of(x, struct file_system, base)
 
@@ -33,6 +35,9 @@ struct file_handle {
 	loff_t offset;       /* current file position/cursor */
 	int isdir;
 	u64 open_mode;
+	loff_t size;	/* cached file size, see efi_get_file_size() */
+	unsigned int size_gen;
+	bool size_valid;
 
 	/* for reading a directory: */
 	struct fs_dir_stream *dirs;
@@ -57,6 +62,18 @@ static int set_blk_dev(struct file_handle *fh)
 	return fs_set_blk_dev_with_part(fh->fs->desc, fh->fs->part);
 }
 
+/**
+ * efi_fs_modified() - note that the file system has been changed
+ *
+ * This invalidates the file sizes cached by all handles on the volume.
+ *
+ * @fs:		file system
+ */
+static void efi_fs_modified(struct file_system *fs)
+{
+	fs->gen++;
+}
+
 /**
  * is_dir() - check if file handle points to directory
  *
@@ -151,6 +168,7 @@ static int efi_create_file(struct file_handle *fh, u64 attributes)
 	loff_t actwrite;
 	void *buffer = &actwrite;
 
+	efi_fs_modified(fh->fs);
 	if (attributes & EFI_FILE_DIRECTORY)
 		return fs_mkdir(fh->path);
 	else
@@ -390,6 +408,7 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 
 	EFI_ENTRY("%p", file);
 
+	efi_fs_modified(fh->fs);
 	if (set_blk_dev(fh) || fs_unlink(fh->path))
 		ret = EFI_WARN_DELETE_FAILURE;
 
@@ -400,6 +419,10 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 /**
  * efi_get_file_size() - determine the size of a file
  *
+ * Looking up the size walks the path on the volume. Loaders read large files
+ * in many small chunks, so the size is cached in the handle until anything on
+ * the volume is modified.
+ *
  * @fh:		file handle
  * @file_size:	pointer to receive file size
  * Return:	status code
@@ -407,12 +430,21 @@ static efi_status_t EFIAPI efi_file_delete(struct efi_file_handle *file)
 static efi_status_t efi_get_file_size(struct file_handle *fh,
 				      loff_t *file_size)
 {
+	if (fh->size_valid && fh->size_gen == fh->fs->gen) {
+		*file_size = fh->size;
+		return EFI_SUCCESS;
+	}
+
 	if (set_blk_dev(fh))
 		return EFI_DEVICE_ERROR;
 
 	if (fs_size(fh->path, file_size))
 		return EFI_DEVICE_ERROR;
 
+	fh->size = *file_size;
+	fh->size_gen = fh->fs->gen;
+	fh->size_valid = true;
+
 	return EFI_SUCCESS;
 }
 
@@ -679,6 +711,7 @@ static efi_status_t efi_file_write_int(struct efi_file_handle *this,
 		ret = EFI_DEVICE_ERROR;
 		goto out;
 	}
+	efi_fs_modified(fh->fs);
 	if (fs_write(fh->path, map_to_sysmem(buffer), fh->offset, *buffer_size,
 		     &actwrite)) {
 		ret = EFI_DEVICE_ERROR;
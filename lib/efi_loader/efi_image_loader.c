@@ -123,14 +123,15 @@ static efi_status_t efi_loader_relocate(const IMAGE_BASE_RELOCATION *rel,
 	end = (const IMAGE_BASE_RELOCATION *)((const char *)rel + rel_size);
 	while (rel < end && rel->SizeOfBlock) {
 		const uint16_t *relocs = (const uint16_t *)(rel + 1);
+		void *page = efi_reloc + rel->VirtualAddress;
+
 		i = (rel->SizeOfBlock - sizeof(*rel)) / sizeof(uint16_t);
 		while (i--) {
-			uint32_t offset = (uint32_t)(*relocs & 0xfff) +
-					  rel->VirtualAddress;
+			uint32_t offset = *relocs & 0xfff;
 			int type = *relocs >> EFI_PAGE_SHIFT;
-			uint64_t *x64 = efi_reloc + offset;
-			uint32_t *x32 = efi_reloc + offset;
-			uint16_t *x16 = efi_reloc + offset;
+			uint64_t *x64 = page + offset;
+			uint32_t *x32 = page + offset;
+			uint16_t *x16 = page + offset;
 
 			switch (type) {
 			case IMAGE_REL_BASED_ABSOLUTE:
@@ -163,7 +164,7 @@ static efi_status_t efi_loader_relocate(const IMAGE_BASE_RELOCATION *rel,
 #endif
 			default:
 				log_err("Unknown Relocation off %x type %x\n",
-					offset, type);
+					offset + rel->VirtualAddress, type);
 				return EFI_LOAD_ERROR;
 			}
 			relocs++;
@@ -816,20 +817,66 @@ static u32 section_size(IMAGE_SECTION_HEADER *sec)
 		return sec->SizeOfRawData;
 }
 
+/**
+ * efi_pe_in_place() - check if a PE binary can be run where it was loaded
+ *
+ * This is the case if the file layout matches the memory layout, i.e. the
+ * raw data of each section is at its virtual address, all sections fit into
+ * the pages of the buffer, and the buffer is aligned as required.
+ *
+ * @efi:		page aligned buffer with the EFI binary
+ * @efi_size:		size of @efi binary
+ * @sections:		section headers
+ * @num_sections:	number of sections
+ * @align:		section alignment
+ * Return:		true if the binary can be used in place
+ */
+static bool efi_pe_in_place(void *efi, size_t efi_size,
+			    IMAGE_SECTION_HEADER *sections, int num_sections,
+			    u32 align)
+{
+	u64 buf_size = efi_size_in_pages(efi_size) << EFI_PAGE_SHIFT;
+	int i;
+
+	if (align & (align - 1))
+		return false;
+	if (align && ((uintptr_t)efi & (align - 1)))
+		return false;
+
+	for (i = 0; i < num_sections; i++) {
+		IMAGE_SECTION_HEADER *sec = &sections[i];
+
+		if (sec->SizeOfRawData &&
+		    sec->PointerToRawData != sec->VirtualAddress)
+			return false;
+		if ((u64)sec->VirtualAddress + section_size(sec) > buf_size)
+			return false;
+	}
+
+	return true;
+}
+
 /**
  * efi_load_pe() - relocate EFI binary
  *
  * This function loads all sections from a PE binary into a newly reserved
  * piece of memory. On success the entry point is returned as handle->entry.
  *
+ * If @in_place is set and the file layout of the binary matches its memory
+ * layout, the sections are not copied but the buffer @efi itself becomes the
+ * loaded image. The caller can tell by loaded_image_info->image_base == @efi
+ * and must not free the buffer in this case.
+ *
  * @handle:		loaded image handle
  * @efi:		pointer to the EFI binary
  * @efi_size:		size of @efi binary
+ * @in_place:		@efi was allocated with efi_allocate_pages() and may
+ *			be used for the loaded image
  * @loaded_image_info:	loaded image protocol
  * Return:		status code
  */
 efi_status_t efi_load_pe(struct efi_loaded_image_obj *handle,
-			 void *efi, size_t efi_size,
+			 void *efi, size_t efi_size, bool in_place,
 			 struct efi_loaded_image *loaded_image_info)
 {
 	IMAGE_NT_HEADERS32 *nt;
@@ -842,6 +889,7 @@ efi_status_t efi_load_pe(struct efi_loaded_image_obj *handle,
 	unsigned long rel_size;
 	int rel_idx = IMAGE_DIRECTORY_ENTRY_BASERELOC;
 	uint64_t image_base;
+	u32 section_alignment, entry, rel_addr;
 	unsigned long virt_size = 0;
 	int supported = 0;
 	efi_status_t ret;
@@ -897,39 +945,43 @@ efi_status_t efi_load_pe(struct efi_loaded_image_obj *handle,
 		image_base = opt->ImageBase;
 		efi_set_code_and_data_type(loaded_image_info, opt->Subsystem);
 		handle->image_type = opt->Subsystem;
-		efi_reloc = efi_alloc_aligned_pages(virt_size,
-						    loaded_image_info->image_code_type,
-						    opt->SectionAlignment);
-		if (!efi_reloc) {
-			log_err("Out of memory\n");
-			ret = EFI_OUT_OF_RESOURCES;
-			goto err;
-		}
-		handle->entry = efi_reloc + opt->AddressOfEntryPoint;
+		section_alignment = opt->SectionAlignment;
+		entry = opt->AddressOfEntryPoint;
 		rel_size = opt->DataDirectory[rel_idx].Size;
-		rel = efi_reloc + opt->DataDirectory[rel_idx].VirtualAddress;
+		rel_addr = opt->DataDirectory[rel_idx].VirtualAddress;
 	} else if (nt->OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC) {
 		IMAGE_OPTIONAL_HEADER32 *opt = &nt->OptionalHeader;
 		image_base = opt->ImageBase;
 		efi_set_code_and_data_type(loaded_image_info, opt->Subsystem);
 		handle->image_type = opt->Subsystem;
+		section_alignment = opt->SectionAlignment;
+		entry = opt->AddressOfEntryPoint;
+		rel_size = opt->DataDirectory[rel_idx].Size;
+		rel_addr = opt->DataDirectory[rel_idx].VirtualAddress;
+	} else {
+		log_err("Invalid optional header magic %x\n",
+			nt->OptionalHeader.Magic);
+		ret = EFI_LOAD_ERROR;
+		goto err;
+	}
+
+	if (in_place)
+		in_place = efi_pe_in_place(efi, efi_size, sections,
+					   num_sections, section_alignment);
+	if (in_place) {
+		efi_reloc = efi;
+	} else {
 		efi_reloc = efi_alloc_aligned_pages(virt_size,
 						    loaded_image_info->image_code_type,
-						    opt->SectionAlignment);
+						    section_alignment);
 		if (!efi_reloc) {
 			log_err("Out of memory\n");
 			ret = EFI_OUT_OF_RESOURCES;
 			goto err;
 		}
-		handle->entry = efi_reloc + opt->AddressOfEntryPoint;
-		rel_size = opt->DataDirectory[rel_idx].Size;
-		rel = efi_reloc + opt->DataDirectory[rel_idx].VirtualAddress;
-	} else {
-		log_err("Invalid optional header magic %x\n",
-			nt->OptionalHeader.Magic);
-		ret = EFI_LOAD_ERROR;
-		goto err;
 	}
+	handle->entry = efi_reloc + entry;
+	rel = efi_reloc + rel_addr;
 
 #if IS_ENABLED(CONFIG_EFI_TCG2_PROTOCOL)
 	/* Measure an PE/COFF image */
@@ -940,40 +992,56 @@ efi_status_t efi_load_pe(struct efi_loaded_image_obj *handle,
 		 * this is not expected.
 		 */
 		log_err("PE image measurement failed, no tpm device found\n");
-		goto err;
+		goto err_free;
 	}
 
 #endif
 
 	/* Copy PE headers */
-	memcpy(efi_reloc, efi,
-	       sizeof(*dos)
-		 + sizeof(*nt)
-		 + nt->FileHeader.SizeOfOptionalHeader
-		 + num_sections * sizeof(IMAGE_SECTION_HEADER));
-
-	/* Load sections into RAM */
+	if (!in_place)
+		memcpy(efi_reloc, efi,
+		       sizeof(*dos)
+			 + sizeof(*nt)
+			 + nt->FileHeader.SizeOfOptionalHeader
+			 + num_sections * sizeof(IMAGE_SECTION_HEADER));
+
+	/* Load sections into RAM, zero what is not in the file */
 	for (i = num_sections - 1; i >= 0; i--) {
 		IMAGE_SECTION_HEADER *sec = &sections[i];
 		u32 copy_size = section_size(sec);
 
 		if (copy_size > sec->SizeOfRawData) {
 			copy_size = sec->SizeOfRawData;
-			memset(efi_reloc + sec->VirtualAddress, 0,
-			       sec->Misc.VirtualSize);
+			memset(efi_reloc + sec->VirtualAddress + copy_size, 0,
+			       sec->Misc.VirtualSize - copy_size);
 		}
-		memcpy(efi_reloc + sec->VirtualAddress,
-		       efi + sec->PointerToRawData,
-		       copy_size);
+		if (!in_place)
+			memcpy(efi_reloc + sec->VirtualAddress,
+			       efi + sec->PointerToRawData,
+			       copy_size);
 	}
 
 	/* Run through relocations */
 	if (efi_loader_relocate(rel, rel_size, efi_reloc,
 				(unsigned long)image_base) != EFI_SUCCESS) {
-		efi_free_pages((uintptr_t) efi_reloc,
-			       (virt_size + EFI_PAGE_MASK) >> EFI_PAGE_SHIFT);
 		ret = EFI_LOAD_ERROR;
-		goto err;
+		goto err_free;
+	}
+
+	if (in_place) {
+		u64 pages = efi_size_in_pages(virt_size);
+		u64 buf_pages = efi_size_in_pages(efi_size);
+
+		/* Retype the buffer and release what follows the image */
+		ret = efi_add_memory_map_pg((uintptr_t)efi_reloc, pages,
+					    loaded_image_info->image_code_type,
+					    false);
+		if (ret != EFI_SUCCESS)
+			goto err;
+		if (buf_pages > pages)
+			efi_free_pages((uintptr_t)efi_reloc +
+				       (pages << EFI_PAGE_SHIFT),
+				       buf_pages - pages);
 	}
 
 	/* Flush cache */
@@ -996,6 +1064,10 @@ efi_status_t efi_load_pe(struct efi_loaded_image_obj *handle,
 	else
 		return EFI_SECURITY_VIOLATION;
 
+err_free:
+	if (!in_place)
+		efi_free_pages((uintptr_t)efi_reloc,
+			       efi_size_in_pages(virt_size));
 err:
 	return ret;
 }
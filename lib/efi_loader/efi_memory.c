@@ -17,7 +17,6 @@
 #include <asm/cache.h>
 #include <asm/global_data.h>
 #include <asm/sections.h>
-#include <linux/list_sort.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -25,6 +24,18 @@ DECLARE_GLOBAL_DATA_PTR;
 /* Magic number identifying memory allocated from pool */
 #define EFI_ALLOC_POOL_MAGIC 0x1fe67ddf6491caa2
 
+/* Magic number identifying a page shared by small pool allocations */
+#define EFI_POOL_PAGE_MAGIC 0x7c1b5a0d93e24f68
+
+/*
+ * Pool allocations of up to 1 << EFI_POOL_MAX_SHIFT bytes, including their
+ * header, are made from pages shared with allocations of the same memory type
+ * and size, in chunks of a power of two from 1 << EFI_POOL_MIN_SHIFT bytes
+ */
+#define EFI_POOL_MIN_SHIFT	7
+#define EFI_POOL_MAX_SHIFT	9
+#define EFI_POOL_SIZES		(EFI_POOL_MAX_SHIFT - EFI_POOL_MIN_SHIFT + 1)
+
 efi_uintn_t efi_memory_map_key;
 
 struct efi_mem_list {
@@ -47,11 +58,12 @@ void *efi_bounce_buffer;
 /**
  * struct efi_pool_allocation - memory block allocated from pool
  *
- * @num_pages:	number of pages allocated
+ * @num_pages:	number of pages allocated, or 0 for a chunk of a page shared
+ *		with other small allocations (see struct efi_pool_page)
  * @checksum:	checksum
  * @data:	allocated pool memory
  *
- * U-Boot services each UEFI AllocatePool() request as a separate
+ * U-Boot services each larger UEFI AllocatePool() request as a separate
  * (multiple) page allocation. We have to track the number of pages
  * to be able to free the correct amount later.
  *
@@ -84,30 +96,45 @@ static u64 checksum(struct efi_pool_allocation *alloc)
 }
 
 /**
- * efi_mem_cmp() - comparator function for sorting memory map
+ * struct efi_pool_page - page shared by small pool allocations
  *
- * Sorts the memory list from highest address to lowest address
+ * The page is divided into chunks of 1 << @shift bytes, each starting with a
+ * struct efi_pool_allocation whose @num_pages is 0. The chunks which would
+ * overlap this header are never used.
  *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
+ * @link:	node in the list of pages of this memory type and chunk size
+ *		which have free chunks
+ * @checksum:	checksum calculated by page_checksum(), used to check that a
+ *		chunk being freed is in one of these pages
+ * @free:	bitmap of the free chunks
+ * @shift:	log2 of the chunk size
+ * @type:	memory type of the page
+ */
+struct efi_pool_page {
+	struct list_head link;
+	u64 checksum;
+	u64 free;
+	u8 shift;
+	u8 type;
+};
+
+/* Pages with free chunks, by memory type and chunk size */
+static struct list_head efi_pool_pages[EFI_MAX_MEMORY_TYPE][EFI_POOL_SIZES];
+
+/**
+ * page_checksum() - calculate checksum for a page of small pool allocations
  *
- * @priv:	unused
- * @a:		first memory area
- * @b:		second memory area
- * Return:	1 if @a is before @b, -1 if @b is before @a, 0 if equal
+ * @page:	page header
+ * Return:	checksum, always non-zero
  */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static u64 page_checksum(struct efi_pool_page *page)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
-
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+	u64 addr = (uintptr_t)page;
+	u64 ret = (addr >> 32) ^ (addr << 32) ^ page->shift ^
+		  ((u64)page->type << 8) ^ EFI_POOL_PAGE_MAGIC;
+	if (!ret)
+		++ret;
+	return ret;
 }
 
 /**
@@ -122,50 +149,58 @@ static uint64_t desc_get_end(struct efi_mem_desc *desc)
 }
 
 /**
- * efi_mem_sort() - sort memory map
+ * efi_mem_can_merge() - check whether two memory areas can be merged
+ *
+ * @upper:	memory area at the higher address
+ * @lower:	memory area at the lower address
+ * Return:	true if @lower ends where @upper starts and they have the same
+ *		type and attributes
+ */
+static bool efi_mem_can_merge(struct efi_mem_desc *upper,
+			      struct efi_mem_desc *lower)
+{
+	return desc_get_end(lower) == upper->physical_start &&
+		upper->type == lower->type &&
+		upper->attribute == lower->attribute;
+}
+
+/**
+ * efi_mem_insert() - add a memory area to the memory map
+ *
+ * The map is kept in descending address order, with adjacent areas merged
+ * where possible. So only the neighbours of the new area can need merging with
+ * it and there is no need to sort the whole map.
  *
- * Sort the memory map and then try to merge adjacent memory areas.
+ * @newmem:	memory area to add, which must not overlap any in the map
  */
-static void efi_mem_sort(void)
+static void efi_mem_insert(struct efi_mem_list *newmem)
 {
+	struct efi_mem_desc *desc = &newmem->desc;
 	struct efi_mem_list *lmem;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
-
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
-
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each_entry(lmem, &efi_mem, link) {
-			struct efi_mem_desc *prev;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
-
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
-
-			cur = &lmem->desc;
-			prev = &prevmem->desc;
-
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
-
-				merge_again = true;
-				break;
-			}
-
-			prevmem = lmem;
+
+	/* Insert before the first area below the new one */
+	list_for_each_entry(lmem, &efi_mem, link) {
+		if (lmem->desc.physical_start < desc->physical_start)
+			break;
+	}
+	list_add_tail(&newmem->link, &lmem->link);
+
+	if (newmem->link.prev != &efi_mem) {
+		lmem = list_entry(newmem->link.prev, struct efi_mem_list, link);
+		if (efi_mem_can_merge(&lmem->desc, desc)) {
+			desc->num_pages += lmem->desc.num_pages;
+			list_del(&lmem->link);
+			free(lmem);
+		}
+	}
+	if (!list_is_last(&newmem->link, &efi_mem)) {
+		lmem = list_entry(newmem->link.next, struct efi_mem_list, link);
+		if (efi_mem_can_merge(desc, &lmem->desc)) {
+			desc->num_pages += lmem->desc.num_pages;
+			desc->physical_start = lmem->desc.physical_start;
+			desc->virtual_start = lmem->desc.virtual_start;
+			list_del(&lmem->link);
+			free(lmem);
 		}
 	}
 }
@@ -272,9 +307,8 @@ efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 				   int memory_type,
 				   bool overlap_conventional)
 {
-	struct efi_mem_list *lmem;
+	struct efi_mem_list *lmem, *next;
 	struct efi_mem_list *newlist;
-	bool carve_again;
 	uint64_t carved_pages = 0;
 	struct efi_event *evt;
 
@@ -310,48 +344,49 @@ efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each_entry(lmem, &efi_mem, link) {
-			s64 r;
+	/*
+	 * Carve the new area out of the map. The map is in descending order,
+	 * so stop at the first area which is entirely below it.
+	 */
+	list_for_each_entry_safe(lmem, next, &efi_mem, link) {
+		s64 r;
 
-			r = efi_mem_carve_out(lmem, &newlist->desc,
+		if (desc_get_end(&lmem->desc) <= start)
+			break;
+		r = efi_mem_carve_out(lmem, &newlist->desc,
+				      overlap_conventional);
+		if (r == EFI_CARVE_LOOP_AGAIN) {
+			/*
+			 * We split the entry and the part above the split,
+			 * which was added before it, starts at the new area,
+			 * so carve that now
+			 */
+			r = efi_mem_carve_out(list_entry(lmem->link.prev,
+							 struct efi_mem_list,
+							 link),
+					      &newlist->desc,
 					      overlap_conventional);
-			switch (r) {
-			case EFI_CARVE_OUT_OF_RESOURCES:
-				free(newlist);
-				return EFI_OUT_OF_RESOURCES;
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				free(newlist);
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
 		}
-	} while (carve_again);
+		switch (r) {
+		case EFI_CARVE_OUT_OF_RESOURCES:
+			free(newlist);
+			return EFI_OUT_OF_RESOURCES;
+		case EFI_CARVE_OVERLAPS_NONRAM:
+			/*
+			 * The user requested to only have RAM overlaps,
+			 * but we hit a non-RAM region. Error out.
+			 */
+			free(newlist);
+			return EFI_NO_MAPPING;
+		case EFI_CARVE_NO_OVERLAP:
+			/* Just ignore this list entry */
+			break;
+		default:
+			/* We carved a number of pages */
+			carved_pages += r;
+			break;
+		}
+	}
 
 	if (overlap_conventional && (carved_pages != pages)) {
 		/*
@@ -362,11 +397,8 @@ efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 		return EFI_NO_MAPPING;
 	}
 
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/* Add our new map, keeping the map in descending order */
+	efi_mem_insert(newlist);
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -433,6 +465,9 @@ static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 			else
 				return EFI_NOT_FOUND;
 		}
+		/* The map is in descending order, so nothing below matches */
+		if (addr >= start)
+			break;
 	}
 
 	return EFI_NOT_FOUND;
@@ -602,6 +637,160 @@ void *efi_alloc_aligned_pages(u64 len, int memory_type, size_t align)
 	return (void *)(uintptr_t)aligned_mem;
 }
 
+/**
+ * pool_page_list() - get the list of pages with free chunks
+ *
+ * @type:	memory type
+ * @shift:	log2 of the chunk size
+ * Return:	list of pages
+ */
+static struct list_head *pool_page_list(uint type, uint shift)
+{
+	struct list_head *head;
+
+	head = &efi_pool_pages[type][shift - EFI_POOL_MIN_SHIFT];
+	if (!head->next)
+		INIT_LIST_HEAD(head);
+
+	return head;
+}
+
+/**
+ * pool_page_all_free() - get the bitmap of a page with all its chunks free
+ *
+ * @shift:	log2 of the chunk size
+ * Return:	bitmap
+ */
+static u64 pool_page_all_free(uint shift)
+{
+	uint first = ALIGN(sizeof(struct efi_pool_page), 1 << shift) >> shift;
+
+	return GENMASK_ULL((EFI_PAGE_SIZE >> shift) - 1, first);
+}
+
+/**
+ * pool_chunk_shift() - get the chunk size to use for a pool allocation
+ *
+ * @pool_type:	type of the pool
+ * @size:	number of bytes to be allocated
+ * Return:	log2 of the chunk size, or 0 to allocate whole pages
+ */
+static uint pool_chunk_shift(enum efi_memory_type pool_type, efi_uintn_t size)
+{
+	uint shift;
+
+	switch (pool_type) {
+	case EFI_LOADER_CODE:
+	case EFI_LOADER_DATA:
+	case EFI_BOOT_SERVICES_CODE:
+	case EFI_BOOT_SERVICES_DATA:
+	case EFI_RUNTIME_SERVICES_CODE:
+	case EFI_RUNTIME_SERVICES_DATA:
+		break;
+	default:
+		return 0;
+	}
+
+	for (shift = EFI_POOL_MIN_SHIFT; shift <= EFI_POOL_MAX_SHIFT; shift++) {
+		/* each chunk must be aligned like a whole allocation */
+		if ((1 << shift) < ARCH_DMA_MINALIGN)
+			continue;
+		if (size + sizeof(struct efi_pool_allocation) <= 1 << shift)
+			return shift;
+	}
+
+	return 0;
+}
+
+/**
+ * efi_allocate_pool_chunk() - allocate memory from a shared page
+ *
+ * @pool_type:	type of the pool from which memory is to be allocated
+ * @shift:	log2 of the chunk size, from pool_chunk_shift()
+ * @buffer:	allocated memory
+ * Return:	status code
+ */
+static efi_status_t efi_allocate_pool_chunk(enum efi_memory_type pool_type,
+					    uint shift, void **buffer)
+{
+	struct list_head *head = pool_page_list(pool_type, shift);
+	struct efi_pool_allocation *alloc;
+	struct efi_pool_page *page;
+	uint idx;
+
+	if (list_empty(head)) {
+		efi_status_t r;
+		u64 addr;
+
+		r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, 1,
+				       &addr);
+		if (r != EFI_SUCCESS)
+			return r;
+		page = (struct efi_pool_page *)(uintptr_t)addr;
+		page->free = pool_page_all_free(shift);
+		page->shift = shift;
+		page->type = pool_type;
+		page->checksum = page_checksum(page);
+		list_add(&page->link, head);
+	} else {
+		page = list_first_entry(head, struct efi_pool_page, link);
+	}
+
+	idx = __ffs64(page->free);
+	page->free &= ~BIT_ULL(idx);
+	if (!page->free)
+		list_del(&page->link);
+
+	alloc = (void *)page + (idx << shift);
+	alloc->num_pages = 0;
+	alloc->checksum = checksum(alloc);
+	*buffer = alloc->data;
+
+	return EFI_SUCCESS;
+}
+
+/**
+ * efi_free_pool_chunk() - free memory allocated from a shared page
+ *
+ * The page is freed once all its chunks are free, unless it is the only page
+ * left with free chunks of its type and size.
+ *
+ * @alloc:	allocation header, with a valid checksum
+ * Return:	status code
+ */
+static efi_status_t efi_free_pool_chunk(struct efi_pool_allocation *alloc)
+{
+	struct efi_pool_page *page;
+	struct list_head *head;
+	uint offset, idx;
+
+	page = (struct efi_pool_page *)((uintptr_t)alloc & ~EFI_PAGE_MASK);
+	offset = (uintptr_t)alloc & EFI_PAGE_MASK;
+	if (page->checksum != page_checksum(page) ||
+	    offset & ((1 << page->shift) - 1) ||
+	    !(pool_page_all_free(page->shift) & BIT_ULL(offset >> page->shift)))
+		return EFI_INVALID_PARAMETER;
+	idx = offset >> page->shift;
+	if (page->free & BIT_ULL(idx))
+		return EFI_INVALID_PARAMETER;
+
+	/* Avoid double free */
+	alloc->checksum = 0;
+
+	head = pool_page_list(page->type, page->shift);
+	if (!page->free)
+		list_add(&page->link, head);
+	page->free |= BIT_ULL(idx);
+	if (page->free != pool_page_all_free(page->shift) ||
+	    list_is_singular(head))
+		return EFI_SUCCESS;
+
+	list_del(&page->link);
+	page->checksum = 0;
+
+	return efi_free_pages((uintptr_t)page, 1);
+}
+
 /**
  * efi_allocate_pool - allocate memory from pool
  *
@@ -617,6 +806,7 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 	struct efi_pool_allocation *alloc;
 	u64 num_pages = efi_size_in_pages(size +
 					  sizeof(struct efi_pool_allocation));
+	uint shift;
 
 	if (!buffer)
 		return EFI_INVALID_PARAMETER;
@@ -626,6 +816,10 @@ efi_status_t efi_allocate_pool(enum efi_memory_type pool_type, efi_uintn_t size,
 		return EFI_SUCCESS;
 	}
 
+	shift = pool_chunk_shift(pool_type, size);
+	if (shift)
+		return efi_allocate_pool_chunk(pool_type, shift, buffer);
+
 	r = efi_allocate_pages(EFI_ALLOCATE_ANY_PAGES, pool_type, num_pages,
 			       &addr);
 	if (r == EFI_SUCCESS) {
@@ -681,11 +875,17 @@ efi_status_t efi_free_pool(void *buffer)
 	alloc = container_of(buffer, struct efi_pool_allocation, data);
 
 	/* Check that this memory was allocated by efi_allocate_pool() */
-	if (((uintptr_t)alloc & EFI_PAGE_MASK) ||
-	    alloc->checksum != checksum(alloc)) {
+	if (alloc->checksum != checksum(alloc) ||
+	    (alloc->num_pages && ((uintptr_t)alloc & EFI_PAGE_MASK))) {
 		printf("%s: illegal free 0x%p\n", __func__, buffer);
 		return EFI_INVALID_PARAMETER;
 	}
+	if (!alloc->num_pages) {
+		ret = efi_free_pool_chunk(alloc);
+		if (ret == EFI_INVALID_PARAMETER)
+			printf("%s: illegal free 0x%p\n", __func__, buffer);
+		return ret;
+	}
 	/* Avoid double free */
 	alloc->checksum = 0;
 
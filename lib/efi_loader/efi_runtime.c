@@ -252,6 +252,8 @@ static void EFIAPI efi_reset_system_boottime(
 			break;
 		}
 	}
+	if (IS_ENABLED(CONFIG_EFI_VARIABLE_FILE_STORE))
+		efi_var_file_flush();
 	switch (reset_type) {
 	case EFI_RESET_COLD:
 	case EFI_RESET_WARM:
@@ -12,6 +12,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <time.h>
 #include <efi_loader.h>
 #include <efi_variable.h>
 #include <u-boot/crc.h>
@@ -25,6 +26,15 @@
 
 static const efi_guid_t shim_lock_guid = SHIM_LOCK_GUID;
 
+#ifdef CONFIG_EFI_VARIABLE_FILE_STORE
+/* length and CRC32 of the last file written, to skip identical writes */
+static loff_t efi_var_file_len;
+static u32 efi_var_file_crc;
+/* changes are waiting to be written since efi_var_file_start */
+static bool efi_var_file_pending;
+static ulong efi_var_file_start;
+#endif
+
 /**
  * efi_set_blk_dev_to_system_partition() - select EFI system partition
  *
@@ -67,10 +77,15 @@ efi_status_t efi_var_to_file(void)
 	int r;
 	static bool once;
 
+	efi_var_file_pending = false;
 	ret = efi_var_collect(&buf, &len, EFI_VARIABLE_NON_VOLATILE);
 	if (ret != EFI_SUCCESS)
 		goto error;
 
+	/* Skip the write if the file already has these contents */
+	if (len == efi_var_file_len && buf->crc32 == efi_var_file_crc)
+		goto out;
+
 	ret = efi_set_blk_dev_to_system_partition();
 	if (ret != EFI_SUCCESS) {
 		if (!once) {
@@ -82,8 +97,13 @@ efi_status_t efi_var_to_file(void)
 	once = false;
 
 	r = fs_write(EFI_VAR_FILE_NAME, map_to_sysmem(buf), 0, len, &actlen);
-	if (r || len != actlen)
+	if (r || len != actlen) {
 		ret = EFI_DEVICE_ERROR;
+		efi_var_file_len = 0;
+	} else {
+		efi_var_file_len = len;
+		efi_var_file_crc = buf->crc32;
+	}
 
 error:
 	if (ret != EFI_SUCCESS)
@@ -96,6 +116,37 @@ out:
 #endif
 }
 
+efi_status_t efi_var_file_sync(void)
+{
+#ifdef CONFIG_EFI_VARIABLE_FILE_STORE
+	if (!CONFIG_EFI_VARIABLE_FILE_STORE_DELAY)
+		return efi_var_to_file();
+
+	if (!efi_var_file_pending) {
+		efi_var_file_start = get_timer(0);
+		efi_var_file_pending = true;
+	}
+#endif
+	return EFI_SUCCESS;
+}
+
+void efi_var_file_flush(void)
+{
+#ifdef CONFIG_EFI_VARIABLE_FILE_STORE
+	if (efi_var_file_pending)
+		efi_var_to_file();
+#endif
+}
+
+void efi_var_file_check(void)
+{
+#ifdef CONFIG_EFI_VARIABLE_FILE_STORE
+	if (efi_var_file_pending &&
+	    get_timer(efi_var_file_start) >= CONFIG_EFI_VARIABLE_FILE_STORE_DELAY)
+		efi_var_to_file();
+#endif
+}
+
 efi_status_t efi_var_restore(struct efi_var_file *buf, bool safe)
 {
 	struct efi_var_entry *var, *last_var;
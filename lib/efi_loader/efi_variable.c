@@ -397,11 +397,11 @@ efi_status_t efi_set_variable_int(const u16 *variable_name,
 		ret = EFI_SUCCESS;
 
 	/*
-	 * Write non-volatile EFI variables to file
-	 * TODO: check if a value change has occured to avoid superfluous writes
+	 * Write non-volatile EFI variables to file, the write is skipped if
+	 * the contents did not change
 	 */
 	if (attributes & EFI_VARIABLE_NON_VOLATILE)
-		efi_var_to_file();
+		efi_var_file_sync();
 
 	return EFI_SUCCESS;
 }
@@ -571,6 +571,9 @@ efi_set_variable_runtime(u16 *variable_name, const efi_guid_t *vendor,
  */
 void efi_variables_boot_exit_notify(void)
 {
+	/* Write out deferred changes while the ESP is still accessible */
+	efi_var_file_flush();
+
 	/* Switch variable services functions to runtime version */
 	efi_runtime_services.get_variable = efi_get_variable_runtime;
 	efi_runtime_services.get_next_variable_name =
@@ -5,7 +5,7 @@
  * Copyright (c) 2018 Heinrich Schuchardt <xypron.glpk@gmx.de>
  *
  * This unit test checks the following boottime services:
- * AllocatePages, FreePages, GetMemoryMap
+ * AllocatePages, FreePages, AllocatePool, FreePool, GetMemoryMap
  *
  * The memory type used for the device tree is checked.
  */
@@ -13,6 +13,8 @@
 #include <efi_selftest.h>
 
 #define EFI_ST_NUM_PAGES 8
+#define EFI_ST_NUM_POOLS 3
+#define EFI_ST_POOL_SIZE 24
 
 static const efi_guid_t fdt_guid = EFI_FDT_GUID;
 static struct efi_boot_services *boottime;
@@ -107,7 +109,9 @@ static int execute(void)
 	efi_uintn_t desc_size;
 	u32 desc_version;
 	struct efi_mem_desc *memory_map;
+	void *pools[EFI_ST_NUM_POOLS];
 	efi_status_t ret;
+	int i;
 
 	/* Allocate two page ranges with different memory type */
 	ret = boottime->allocate_pages(EFI_ALLOCATE_ANY_PAGES,
@@ -125,6 +129,21 @@ static int execute(void)
 		return EFI_ST_FAILURE;
 	}
 
+	/* Allocate small pools, which may share a page */
+	for (i = 0; i < EFI_ST_NUM_POOLS; ++i) {
+		ret = boottime->allocate_pool(EFI_LOADER_DATA,
+					      EFI_ST_POOL_SIZE, &pools[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("AllocatePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+		if ((uintptr_t)pools[i] & 7) {
+			efi_st_error("Pool memory is not 8 byte aligned\n");
+			return EFI_ST_FAILURE;
+		}
+		memset(pools[i], i, EFI_ST_POOL_SIZE);
+	}
+
 	/* Load memory map */
 	ret = boottime->get_memory_map(&map_size, NULL, &map_key, &desc_size,
 				       &desc_version);
@@ -156,7 +175,27 @@ static int execute(void)
 			       EFI_RUNTIME_SERVICES_DATA) != EFI_ST_SUCCESS)
 		return EFI_ST_FAILURE;
 
+	for (i = 0; i < EFI_ST_NUM_POOLS; ++i) {
+		if (find_in_memory_map(map_size, memory_map, desc_size,
+				       (uintptr_t)pools[i],
+				       EFI_LOADER_DATA) != EFI_ST_SUCCESS)
+			return EFI_ST_FAILURE;
+	}
+
 	/* Free memory */
+	for (i = 0; i < EFI_ST_NUM_POOLS; ++i) {
+		u8 *buf = pools[i];
+
+		if (buf[0] != i || buf[EFI_ST_POOL_SIZE - 1] != i) {
+			efi_st_error("Pool memory was overwritten\n");
+			return EFI_ST_FAILURE;
+		}
+		ret = boottime->free_pool(pools[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePool did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
 	ret = boottime->free_pages(p1, EFI_ST_NUM_PAGES);
 	if (ret != EFI_SUCCESS) {
 		efi_st_error("FreePages did not return EFI_SUCCESS\n");
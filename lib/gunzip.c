@@ -8,14 +8,18 @@
 #include <command.h>
 #include <console.h>
 #include <div64.h>
+#include <errno.h>
 #include <gzip.h>
 #include <image.h>
 #include <malloc.h>
 #include <memalign.h>
 #include <u-boot/crc.h>
 #include <watchdog.h>
+#include <asm/global_data.h>
 #include <u-boot/zlib.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 #define HEADER0			'\x1f'
 #define HEADER1			'\x8b'
 #define	ZALLOC_ALIGNMENT	16
@@ -43,6 +47,49 @@ void gzfree(void *x, void *addr, unsigned nb)
 	free (addr);
 }
 
+/*
+ * Inflate state of the last raw-deflate stream, with its 32KB window, kept
+ * for the next stream so that it need not be allocated again
+ */
+static struct internal_state *gunzip_state_cache;
+
+/*
+ * The state is only cached once the full malloc() is running in U-Boot
+ * proper. Before that BSS may not be usable, the heap may move, or free()
+ * may do nothing.
+ */
+static bool gunzip_can_cache(void)
+{
+	return !IS_ENABLED(CONFIG_XPL_BUILD) &&
+		(gd->flags & GD_FLG_FULL_MALLOC_INIT);
+}
+
+/* Set up @s for raw deflate data, reusing the cached state if there is one */
+static int gunzip_inflate_init(z_stream *s)
+{
+	s->zalloc = gzalloc;
+	s->zfree = gzfree;
+	if (gunzip_can_cache() && gunzip_state_cache) {
+		s->state = gunzip_state_cache;
+		gunzip_state_cache = NULL;
+
+		return inflateReset(s);
+	}
+
+	return inflateInit2(s, -MAX_WBITS);
+}
+
+/* Finish with @s, keeping its state for next time if nothing else is */
+static void gunzip_inflate_end(z_stream *s)
+{
+	if (gunzip_can_cache() && !gunzip_state_cache && s->state) {
+		gunzip_state_cache = s->state;
+		s->state = NULL;
+		return;
+	}
+	inflateEnd(s);
+}
+
 int gzip_parse_header(const unsigned char *src, unsigned long len)
 {
 	int i, flags;
@@ -71,6 +118,184 @@ int gzip_parse_header(const unsigned char *src, unsigned long len)
 	return i;
 }
 
+/* Longest gzip header accepted by gunzip_stream_feed(), e.g. for the name */
+#define GUNZIP_STREAM_HEAD_MAX	256
+
+struct gunzip_stream {
+	z_stream s;
+	unsigned char head[GUNZIP_STREAM_HEAD_MAX];
+	int head_len;		/* bytes in @head, -1 once the header is done */
+	bool done;		/* end of compressed data seen */
+};
+
+/* Like gzip_parse_header() but reports -EAGAIN when it needs more data */
+static int gunzip_stream_header(const unsigned char *src, int len)
+{
+	int i = 10, flags;
+
+	if (len < 10)
+		return -EAGAIN;
+	flags = src[3];
+	if (src[2] != DEFLATED || (flags & RESERVED) != 0) {
+		puts("Error: Bad gzipped data\n");
+		return -EIO;
+	}
+	if ((flags & EXTRA_FIELD) != 0) {
+		if (len < 12)
+			return -EAGAIN;
+		i = 12 + src[10] + (src[11] << 8);
+	}
+	if ((flags & ORIG_NAME) != 0) {
+		while (i < len && src[i])
+			i++;
+		if (i++ >= len)
+			return -EAGAIN;
+	}
+	if ((flags & COMMENT) != 0) {
+		while (i < len && src[i])
+			i++;
+		if (i++ >= len)
+			return -EAGAIN;
+	}
+	if ((flags & HEAD_CRC) != 0)
+		i += 2;
+
+	return i <= len ? i : -EAGAIN;
+}
+
+struct gunzip_stream *gunzip_stream_start(void *dst, ulong dstlen)
+{
+	struct gunzip_stream *gs;
+
+	gs = calloc(1, sizeof(*gs));
+	if (!gs)
+		return NULL;
+
+	if (gunzip_inflate_init(&gs->s) != Z_OK) {
+		free(gs);
+		return NULL;
+	}
+	gs->s.next_out = dst;
+	gs->s.avail_out = dstlen;
+
+	return gs;
+}
+
+static int gunzip_stream_inflate(struct gunzip_stream *gs,
+				 const unsigned char *src, ulong len)
+{
+	int r;
+
+	gs->s.next_in = (unsigned char *)src;
+	gs->s.avail_in = len;
+	while (gs->s.avail_in) {
+		r = inflate(&gs->s, Z_NO_FLUSH);
+		if (r == Z_STREAM_END) {
+			gs->done = true;
+			return 1;
+		}
+		if (r != Z_OK && r != Z_BUF_ERROR) {
+			printf("Error: inflate() returned %d\n", r);
+			return -EIO;
+		}
+		if (!gs->s.avail_out)
+			return -ENOSPC;
+	}
+
+	return 0;
+}
+
+int gunzip_stream_feed(struct gunzip_stream *gs, const void *src, ulong len)
+{
+	const unsigned char *in = src;
+	int hl, n;
+
+	if (gs->done)
+		return 1;
+
+	/* Gather the header, which may be split across pieces */
+	if (gs->head_len >= 0) {
+		n = min_t(ulong, len, sizeof(gs->head) - gs->head_len);
+		memcpy(gs->head + gs->head_len, in, n);
+		hl = gunzip_stream_header(gs->head, gs->head_len + n);
+		if (hl == -EAGAIN) {
+			gs->head_len += n;
+			if (gs->head_len == sizeof(gs->head)) {
+				puts("Error: gunzip header too long\n");
+				return -EIO;
+			}
+			return 0;
+		}
+		if (hl < 0)
+			return hl;
+
+		/* Skip whatever was not header in the bytes just copied */
+		if (hl < gs->head_len) {
+			n = gunzip_stream_inflate(gs, gs->head + hl,
+						  gs->head_len - hl);
+			if (n)
+				return n;
+			hl = gs->head_len;
+		}
+		in += hl - gs->head_len;
+		len -= hl - gs->head_len;
+		gs->head_len = -1;
+	}
+
+	return gunzip_stream_inflate(gs, in, len);
+}
+
+struct gunzip_stream *gunzip_stream_open(const void *src, ulong len)
+{
+	struct gunzip_stream *gs;
+	int hl;
+
+	hl = gzip_parse_header(src, len);
+	if (hl < 0)
+		return NULL;
+
+	gs = gunzip_stream_start(NULL, 0);
+	if (!gs)
+		return NULL;
+	gs->head_len = -1;
+	gs->s.next_in = (unsigned char *)src + hl;
+	gs->s.avail_in = len - hl;
+
+	return gs;
+}
+
+int gunzip_stream_read(struct gunzip_stream *gs, void *dst, ulong len)
+{
+	int r;
+
+	gs->s.next_out = dst;
+	gs->s.avail_out = len;
+	while (gs->s.avail_out) {
+		if (gs->done)
+			return -EIO;
+		r = inflate(&gs->s, Z_NO_FLUSH);
+		if (r == Z_STREAM_END) {
+			gs->done = true;
+		} else if (r != Z_OK) {
+			printf("Error: inflate() returned %d\n", r);
+			return -EIO;
+		}
+	}
+
+	return 0;
+}
+
+int gunzip_stream_end(struct gunzip_stream *gs, ulong *sizep)
+{
+	int ret = gs->done ? 0 : -EIO;
+
+	*sizep = gs->s.total_out;
+	gunzip_inflate_end(&gs->s);
+	free(gs);
+
+	return ret;
+}
+
 int gunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp)
 {
 	int offset = gzip_parse_header(src, *lenp);
@@ -191,20 +416,24 @@ int gzwrite(unsigned char *src, int len,
 		return -1;
 	}
 
-	gzwrite_progress_init(szexpected);
+	/* inflate() writes straight into the buffer passed to blk_dwrite() */
+	writebuf = (unsigned char *)malloc_cache_aligned(szwritebuf);
+	if (!writebuf) {
+		printf("%s: cannot allocate %lu bytes\n", __func__, szwritebuf);
+		return -1;
+	}
 
-	s.zalloc = gzalloc;
-	s.zfree = gzfree;
+	gzwrite_progress_init(szexpected);
 
-	r = inflateInit2(&s, -MAX_WBITS);
+	r = gunzip_inflate_init(&s);
 	if (r != Z_OK) {
 		printf("Error: inflateInit2() returned %d\n", r);
+		free(writebuf);
 		return -1;
 	}
 
 	s.next_in = src + i;
 	s.avail_in = payload_size+8;
-	writebuf = (unsigned char *)malloc_cache_aligned(szwritebuf);
 
 	/* decompress until deflate stream ends or end of file */
 	do {
@@ -246,6 +475,12 @@ int gzwrite(unsigned char *src, int len,
 			blocks_written = blk_dwrite(dev, outblock,
 						    writeblocks, writebuf);
 			outblock += blocks_written;
+			if (blocks_written != writeblocks) {
+				printf("%s: wrote %lu of " LBAF " blocks\n",
+				       __func__, blocks_written, writeblocks);
+				r = -1;
+				goto out;
+			}
 			if (ctrlc()) {
 				puts("abort\n");
 				goto out;
@@ -265,7 +500,7 @@ out:
 	gzwrite_progress_finish(r, totalfilled, szexpected,
 				expected_crc, crc);
 	free(writebuf);
-	inflateEnd(&s);
+	gunzip_inflate_end(&s);
 
 	return r;
 }
@@ -281,10 +516,7 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 	int err = 0;
 	int r;
 
-	s.zalloc = gzalloc;
-	s.zfree = gzfree;
-
-	r = inflateInit2(&s, -MAX_WBITS);
+	r = gunzip_inflate_init(&s);
 	if (r != Z_OK) {
 		printf("Error: inflateInit2() returned %d\n", r);
 		return -1;
@@ -303,7 +535,7 @@ int zunzip(void *dst, int dstlen, unsigned char *src, unsigned long *lenp,
 		}
 	} while (r == Z_BUF_ERROR);
 	*lenp = s.next_out - (unsigned char *) dst;
-	inflateEnd(&s);
+	gunzip_inflate_end(&s);
 
 	return err;
 }
@@ -53,8 +53,13 @@
  * which describes the current status.
  */
 
+/*
+ * @stale is only used by himport_r(), to mark entries which have not been seen
+ * yet when importing over an existing table
+ */
 struct env_entry_node {
 	int used;
+	bool stale;
 	struct env_entry entry;
 };
 
@@ -83,6 +88,16 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+/* Round @nel up to a prime, as needed to step through all indices */
+static unsigned int hprime(size_t nel)
+{
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	return nel;
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -107,12 +122,10 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	}
 
 	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = hprime(nel);
 	htab->filled = 0;
+	htab->deleted = 0;
+	htab->busy = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (struct env_entry_node *)calloc(htab->size + 1,
@@ -126,6 +139,96 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	return 1;
 }
 
+/*
+ * First hash function: compute a value for the given string and take the
+ * modulus with the table size, but prevent zero. Perhaps use a better method.
+ */
+static unsigned int hfirst(const char *key, unsigned int size)
+{
+	unsigned int len = strlen(key);
+	unsigned int hval = len;
+
+	while (len-- > 0) {
+		hval <<= 4;
+		hval += key[len];
+	}
+	hval %= size;
+
+	return hval ? hval : 1;
+}
+
+/* Second hash function: the step between probes, as suggested in [Knuth] */
+static unsigned int hstep(unsigned int idx, unsigned int hval2,
+			  unsigned int size)
+{
+	/* Because SIZE is prime this guarantees to step through all indices */
+	if (idx <= hval2)
+		return size + idx - hval2;
+
+	return idx - hval2;
+}
+
+/*
+ * Move all entries to a new table with at least @nel elements, which also
+ * drops the markers left by deleted entries. The entries keep their key and
+ * data strings, so only the table itself is reallocated.
+ *
+ * Returns 0 if there is not enough memory, leaving the table as it was.
+ */
+static int hresize_r(size_t nel, struct hsearch_data *htab)
+{
+	struct env_entry_node *table;
+	unsigned int size = hprime(nel);
+	unsigned int i;
+
+	table = calloc(size + 1, sizeof(struct env_entry_node));
+	if (!table)
+		return 0;
+
+	for (i = 1; i <= htab->size; ++i) {
+		struct env_entry_node *node = &htab->table[i];
+		unsigned int hval, hval2, idx;
+
+		if (node->used <= 0)
+			continue;
+		hval = hfirst(node->entry.key, size);
+		hval2 = 1 + hval % (size - 2);
+		for (idx = hval; table[idx].used; idx = hstep(idx, hval2, size))
+			;
+		table[idx] = *node;
+		table[idx].used = hval;
+	}
+	debug("hresize: %u -> %u entries, %u filled\n", htab->size, size,
+	      htab->filled);
+	free(htab->table);
+	htab->table = table;
+	htab->size = size;
+	htab->deleted = 0;
+
+	return 1;
+}
+
+/*
+ * Keep at least a quarter of the table free, counting deleted entries as used,
+ * so that searches stay short and always find a free entry to stop at. The
+ * table doubles when it is at least half full of live entries, otherwise it is
+ * just rebuilt at the same size to drop the deleted entries.
+ *
+ * This is not done while a callback is running, since the caller may still be
+ * using an index into the table.
+ */
+static void hgrow_r(struct hsearch_data *htab)
+{
+	size_t nel = htab->size;
+
+	if (htab->busy || (htab->filled + htab->deleted + 1) * 4 <= nel * 3)
+		return;
+	if ((htab->filled + 1) * 2 > nel)
+		nel *= 2;
+	if (!hresize_r(nel, htab))
+		debug("hresize: no memory for %zu entries\n", nel);
+}
+
 /*
  * hdestroy()
  */
@@ -218,12 +321,20 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 }
 
 static int
-do_callback(const struct env_entry *e, const char *name, const char *value,
-	    enum env_op op, int flags)
+do_callback(struct hsearch_data *htab, const struct env_entry *e,
+	    const char *name, const char *value, enum env_op op, int flags)
 {
 #ifndef CONFIG_XPL_BUILD
-	if (e->callback)
-		return e->callback(name, value, op, flags);
+	int ret;
+
+	if (e->callback) {
+		/* The callback may set other variables */
+		htab->busy++;
+		ret = e->callback(name, value, op, flags);
+		htab->busy--;
+
+		return ret;
+	}
 #endif
 	return 0;
 }
@@ -253,8 +364,9 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 			}
 
 			/* If there is a callback, call it */
-			if (do_callback(&htab->table[idx].entry, item.key,
-					item.data, env_op_overwrite, flag)) {
+			if (do_callback(htab, &htab->table[idx].entry,
+					item.key, item.data, env_op_overwrite,
+					flag)) {
 				debug("callback() rejected setting variable "
 					"%s, skipping it!\n", item.key);
 				__set_errno(EINVAL);
@@ -282,27 +394,15 @@ int hsearch_r(struct env_entry item, enum env_action action,
 	      struct env_entry **retval, struct hsearch_data *htab, int flag)
 {
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
+	/* Make room first, so that idx stays valid until we return */
+	if (action == ENV_ENTER)
+		hgrow_r(htab);
 
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	hval = hfirst(item.key, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -329,14 +429,7 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		hval2 = 1 + hval % (htab->size - 2);
 
 		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
+			idx = hstep(idx, hval2, htab->size);
 
 			/*
 			 * If we visited all entries leave the loop
@@ -374,10 +467,13 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		 * Create new entry;
 		 * create copies of item.key and item.data
 		 */
-		if (first_deleted)
+		if (first_deleted) {
 			idx = first_deleted;
+			--htab->deleted;
+		}
 
 		htab->table[idx].used = hval;
+		htab->table[idx].stale = false;
 		htab->table[idx].entry.key = strdup(item.key);
 		htab->table[idx].entry.data = strdup(item.data);
 		if (!htab->table[idx].entry.key ||
@@ -406,8 +502,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		}
 
 		/* If there is a callback, call it */
-		if (do_callback(&htab->table[idx].entry, item.key, item.data,
-				env_op_create, flag)) {
+		if (do_callback(htab, &htab->table[idx].entry, item.key,
+				item.data, env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
 			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
@@ -447,6 +543,7 @@ static void _hdelete(const char *key, struct hsearch_data *htab,
 	htab->table[idx].used = USED_DELETED;
 
 	--htab->filled;
+	++htab->deleted;
 }
 
 int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
@@ -474,7 +571,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (do_callback(&htab->table[idx].entry, key, NULL,
+	if (do_callback(htab, &htab->table[idx].entry, key, NULL,
 			env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
@@ -747,6 +844,51 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
 	return res;
 }
 
+/*
+ * Deal with a variable which may already be in the table, when importing
+ * over it without H_NOCLEAR. The result must be the same as if the table had
+ * been destroyed first, so an old entry with a different value is dropped
+ * without asking change_ok() or calling its callback. Use a NULL @value for a
+ * variable which is to be deleted.
+ *
+ * Returns true if there is nothing more to do for the variable.
+ */
+static bool himport_reuse(struct hsearch_data *htab, const char *name,
+			  const char *value)
+{
+	struct env_entry e, *ep;
+	int idx;
+
+	e.key = name;
+	idx = hsearch_r(e, ENV_FIND, &ep, htab, 0);
+	if (!idx || !htab->table[idx].stale)
+		return false;
+	if (value && !strcmp(ep->data, value)) {
+		htab->table[idx].stale = false;
+		return true;
+	}
+	_hdelete(name, htab, ep, idx);
+
+	return !value;
+}
+
+/* Mark all entries as stale, or drop those still marked */
+static void himport_stale(struct hsearch_data *htab, bool drop)
+{
+	int i;
+
+	for (i = 1; i <= htab->size; ++i) {
+		struct env_entry_node *node = &htab->table[i];
+
+		if (node->used <= 0)
+			continue;
+		if (!drop)
+			node->stale = true;
+		else if (node->stale)
+			_hdelete(node->entry.key, htab, &node->entry, i);
+	}
+}
+
 /*
  * Import linearized data into hash table.
  *
@@ -764,6 +906,11 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
  * the linear list of "name=value" pairs will be removed from the
  * current hash table.
  *
+ * Discarding the old data does not rebuild the table: entries whose value
+ * is unchanged are kept as they are, and only the rest are replaced,
+ * created or dropped. This makes it cheap to reimport a large environment
+ * which has only a few changes. The table grows as needed (see hgrow_r()).
+ *
  * The separator character for the "name=value" pairs can be selected,
  * so we both support importing from externally stored environment
  * data (separated by NUL characters) and from plain text files
@@ -791,6 +938,7 @@ int himport_r(struct hsearch_data *htab,
 {
 	char *data, *sp, *dp, *name, *value;
 	char *localvars[nvars];
+	bool reuse = false;
 	int i;
 
 	/* Test for correct arguments.  */
@@ -817,12 +965,11 @@ int himport_r(struct hsearch_data *htab,
 	flag |= H_NOCLEAR;
 #endif
 
-	if ((flag & H_NOCLEAR) == 0 && !nvars) {
-		/* Destroy old hash table if one exists */
-		debug("Destroy Hash Table: %p table = %p\n", htab,
-		       htab->table);
-		if (htab->table)
-			hdestroy_r(htab);
+	if ((flag & H_NOCLEAR) == 0 && !nvars && htab->table) {
+		/* Drop old entries at the end, unless they are imported again */
+		debug("Reuse Hash Table: %p table = %p\n", htab, htab->table);
+		himport_stale(htab, false);
+		reuse = true;
 	}
 
 	/*
@@ -858,6 +1005,8 @@ int himport_r(struct hsearch_data *htab,
 	}
 
 	if (!size) {
+		if (reuse)
+			himport_stale(htab, true);
 		free(data);
 		return 1;		/* everything OK */
 	}
@@ -904,6 +1053,8 @@ int himport_r(struct hsearch_data *htab,
 			debug("DELETE CANDIDATE: \"%s\"\n", name);
 			if (!drop_var_from_set(name, nvars, localvars))
 				continue;
+			if (reuse && himport_reuse(htab, name, NULL))
+				continue;
 
 			if (hdelete_r(name, htab, flag))
 				debug("DELETE ERROR ##############################\n");
@@ -923,6 +1074,8 @@ int himport_r(struct hsearch_data *htab,
 
 		if (*name == 0) {
 			debug("INSERT: unable to use an empty key\n");
+			if (reuse)
+				himport_stale(htab, true);
 			__set_errno(EINVAL);
 			free(data);
 			return 0;
@@ -931,6 +1084,8 @@ int himport_r(struct hsearch_data *htab,
 		/* Skip variables which are not supposed to be processed */
 		if (!drop_var_from_set(name, nvars, localvars))
 			continue;
+		if (reuse && himport_reuse(htab, name, value))
+			continue;
 
 		/* enter into hash table */
 		e.key = name;
@@ -951,6 +1106,8 @@ int himport_r(struct hsearch_data *htab,
 						/* without '\0' termination */
 	debug("INSERT: free(data = %p)\n", data);
 	free(data);
+	if (reuse)
+		himport_stale(htab, true);
 
 	if (flag & H_NOCLEAR)
 		goto end;
@@ -989,15 +1146,18 @@ end:
 int hwalk_r(struct hsearch_data *htab, int (*callback)(struct env_entry *entry))
 {
 	int i;
-	int retval;
+	int retval = 0;
 
+	/* Do not move entries while walking them */
+	htab->busy++;
 	for (i = 1; i <= htab->size; ++i) {
 		if (htab->table[i].used > 0) {
 			retval = callback(&htab->table[i].entry);
 			if (retval)
-				return retval;
+				break;
 		}
 	}
+	htab->busy--;
 
-	return 0;
+	return retval;
 }
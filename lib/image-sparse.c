@@ -49,61 +49,191 @@
 
 static void default_log(const char *ignored, char *response) {}
 
-static lbaint_t write_sparse_chunk_raw(struct sparse_storage *info,
-				       lbaint_t blk, lbaint_t blkcnt,
-				       void *data,
+/**
+ * struct sparse_raw - RAW chunk data waiting to be written
+ *
+ * RAW data which is not aligned for DMA is copied to a bounce buffer. This is
+ * only written when it is full or when the run of RAW chunks ends, so that
+ * consecutive chunks are written with as few, large, transfers as possible.
+ *
+ * @buf: Bounce buffer, allocated on first use
+ * @max: Size of @buf in blocks
+ * @cnt: Number of blocks held in @buf
+ */
+struct sparse_raw {
+	void *buf;
+	lbaint_t max;
+	lbaint_t cnt;
+};
+
+static lbaint_t write_sparse_fail(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t n, lbaint_t write_blks,
+				  const char *func, char *response)
+{
+	if (IS_ERR_VALUE(write_blks)) {
+		printf("%s: Write failed, block #" LBAFU " [" LBAFU "] (%lld)\n",
+		       func, blk, n, (long long)write_blks);
+		info->mssg("flash write failure", response);
+		return write_blks;
+	}
+
+	/* write_blks < n */
+	printf("%s: Write failed, block #" LBAFU " [" LBAFU "]\n",
+	       func, blk, n);
+	info->mssg("flash write failure(incomplete)", response);
+	return -1;
+}
+
+/* Write out the contents of the bounce buffer at @blk */
+static lbaint_t write_sparse_raw_flush(struct sparse_storage *info,
+				       struct sparse_raw *raw, lbaint_t blk,
 				       char *response)
 {
-	lbaint_t n = blkcnt, write_blks, blks = 0;
-	lbaint_t aligned_buf_blks = FASTBOOT_MAX_BLK_WRITE;
-	uint32_t *aligned_buf = NULL;
+	lbaint_t n = raw->cnt, write_blks;
 
-	if (CONFIG_IS_ENABLED(SYS_DCACHE_OFF)) {
-		write_blks = info->write(info, blk, n, data);
-		if (write_blks < n)
-			goto write_fail;
+	if (!n)
+		return 0;
+	raw->cnt = 0;
 
-		return write_blks;
-	}
+	/* write_blks might be > n due to NAND bad-blocks */
+	write_blks = info->write(info, blk, n, raw->buf);
+	if (write_blks < n)
+		return write_sparse_fail(info, blk, n, write_blks, __func__,
+					 response);
 
-	aligned_buf = memalign(ARCH_DMA_MINALIGN, info->blksz * aligned_buf_blks);
-	if (!aligned_buf) {
-		info->mssg("Malloc failed for: CHUNK_TYPE_RAW", response);
-		return -ENOMEM;
+	return write_blks;
+}
+
+/*
+ * Write a RAW chunk which follows @raw->cnt blocks that are still in the
+ * bounce buffer, all starting at @blk. Returns the number of blocks written
+ * out, which is less than the total so far if some are left in the buffer.
+ */
+static lbaint_t write_sparse_chunk_raw(struct sparse_storage *info,
+				       struct sparse_raw *raw, lbaint_t blk,
+				       lbaint_t blkcnt, void *data,
+				       char *response)
+{
+	lbaint_t n, write_blks, blks = 0;
+
+	/* Data the device can use directly is written in one go */
+	if (CONFIG_IS_ENABLED(SYS_DCACHE_OFF) ||
+	    IS_ALIGNED((ulong)data, ARCH_DMA_MINALIGN)) {
+		blks = write_sparse_raw_flush(info, raw, blk, response);
+		if (IS_ERR_VALUE(blks))
+			return blks;
+
+		write_blks = info->write(info, blk + blks, blkcnt, data);
+		if (write_blks < blkcnt)
+			return write_sparse_fail(info, blk + blks, blkcnt,
+						 write_blks, __func__,
+						 response);
+
+		return blks + write_blks;
 	}
 
-	while (blkcnt > 0) {
-		n = min(aligned_buf_blks, blkcnt);
-		memcpy(aligned_buf, data, n * info->blksz);
-
-		/* write_blks might be > n due to NAND bad-blocks */
-		write_blks = info->write(info, blk + blks, n, aligned_buf);
-		if (write_blks < n) {
-			free(aligned_buf);
-			goto write_fail;
+	if (!raw->buf) {
+		raw->max = FASTBOOT_MAX_BLK_WRITE;
+		raw->buf = memalign(ARCH_DMA_MINALIGN, info->blksz * raw->max);
+		if (!raw->buf) {
+			info->mssg("Malloc failed for: CHUNK_TYPE_RAW",
+				   response);
+			return -ENOMEM;
 		}
+	}
 
-		blks += write_blks;
+	while (blkcnt > 0) {
+		n = min(raw->max - raw->cnt, blkcnt);
+		memcpy(raw->buf + raw->cnt * info->blksz, data,
+		       n * info->blksz);
+		raw->cnt += n;
 		data += n * info->blksz;
 		blkcnt -= n;
+
+		if (raw->cnt == raw->max) {
+			write_blks = write_sparse_raw_flush(info, raw,
+							    blk + blks,
+							    response);
+			if (IS_ERR_VALUE(write_blks))
+				return write_blks;
+			blks += write_blks;
+		}
 	}
 
-	free(aligned_buf);
 	return blks;
+}
 
-write_fail:
-	if (IS_ERR_VALUE(write_blks)) {
-		printf("%s: Write failed, block #" LBAFU " [" LBAFU "] (%lld)\n",
-		       __func__, blk + blks, n, (long long)write_blks);
-		info->mssg("flash write failure", response);
-		return write_blks;
+/**
+ * struct sparse_fill - buffer used to write FILL chunks
+ *
+ * @buf: Buffer holding the fill value, allocated on first use
+ * @val: Value @buf is currently filled with
+ */
+struct sparse_fill {
+	uint32_t *buf;
+	uint32_t val;
+};
+
+/*
+ * Write a FILL chunk of @blkcnt blocks at @blk. Returns the number of blocks
+ * the chunk took up on the device, which may be more than @blkcnt if bad
+ * blocks were skipped.
+ */
+static lbaint_t write_sparse_chunk_fill(struct sparse_storage *info,
+					struct sparse_fill *fill, lbaint_t blk,
+					lbaint_t blkcnt, uint32_t fill_val,
+					char *response)
+{
+	int fill_buf_num_blks;
+	lbaint_t blks, start = blk;
+	int i;
+	int j;
+
+	/* Let the device zero the blocks itself if it can */
+	if (!fill_val && info->write_zeroes &&
+	    info->write_zeroes(info, blk, blkcnt) == blkcnt)
+		return blkcnt;
+
+	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
+
+	/* The buffer is kept, and refilled for a new value */
+	if (!fill->buf) {
+		fill->buf = (uint32_t *)
+			    memalign(ARCH_DMA_MINALIGN,
+				     ROUNDUP(info->blksz * fill_buf_num_blks,
+					     ARCH_DMA_MINALIGN));
+		if (!fill->buf) {
+			info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
+				   response);
+			return -ENOMEM;
+		}
+		fill->val = ~fill_val;
+	}
+	if (fill->val != fill_val) {
+		for (i = 0;
+		     i < (info->blksz * fill_buf_num_blks / sizeof(fill_val));
+		     i++)
+			fill->buf[i] = fill_val;
+		fill->val = fill_val;
 	}
 
-	/* write_blks < n */
-	printf("%s: Write failed, block #" LBAFU " [" LBAFU "]\n",
-	       __func__, blk + blks, n);
-	info->mssg("flash write failure(incomplete)", response);
-	return -1;
+	for (i = 0; i < blkcnt;) {
+		j = blkcnt - i;
+		if (j > fill_buf_num_blks)
+			j = fill_buf_num_blks;
+		blks = info->write(info, blk, j, fill->buf);
+		/* blks might be > j (eg. NAND bad-blocks) */
+		if (blks < j) {
+			printf("%s: %s " LBAFU " [%d]\n", __func__,
+			       "Write failed, block #", blk, j);
+			info->mssg("flash write failure", response);
+			return -EIO;
+		}
+		blk += blks;
+		i += j;
+	}
+
+	return blk - start;
 }
 
 int write_sparse_image(struct sparse_storage *info,
@@ -116,16 +246,13 @@ int write_sparse_image(struct sparse_storage *info,
 	unsigned int chunk;
 	unsigned int offset;
 	uint64_t chunk_data_sz;
-	uint32_t *fill_buf = NULL;
 	uint32_t fill_val;
 	sparse_header_t *sparse_header;
 	chunk_header_t *chunk_header;
 	uint32_t total_blocks = 0;
-	int fill_buf_num_blks;
-	int i;
-	int j;
-
-	fill_buf_num_blks = CONFIG_IMAGE_SPARSE_FILLBUF_SIZE / info->blksz;
+	struct sparse_raw raw = { };
+	struct sparse_fill fill = { };
+	int ret = -1;
 
 	/* Read and skip over sparse image header */
 	sparse_header = (sparse_header_t *)data;
@@ -191,28 +318,38 @@ int write_sparse_image(struct sparse_storage *info,
 
 		chunk_data_sz = ((u64)sparse_header->blk_sz) * chunk_header->chunk_sz;
 		blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
+
+		/* Only RAW chunks add to the data waiting to be written */
+		if (chunk_header->chunk_type != CHUNK_TYPE_RAW) {
+			blks = write_sparse_raw_flush(info, &raw, blk,
+						      response);
+			if (IS_ERR_VALUE(blks))
+				goto out;
+			blk += blks;
+		}
+
 		switch (chunk_header->chunk_type) {
 		case CHUNK_TYPE_RAW:
 			if (chunk_header->total_sz !=
 			    (sparse_header->chunk_hdr_sz + chunk_data_sz)) {
 				info->mssg("Bogus chunk size for chunk type Raw",
 					   response);
-				return -1;
+				goto out;
 			}
 
-			if (blk + blkcnt > info->start + info->size) {
+			if (blk + raw.cnt + blkcnt > info->start + info->size) {
 				printf(
 				    "%s: Request would exceed partition size!\n",
 				    __func__);
 				info->mssg("Request would exceed partition size!",
 					   response);
-				return -1;
+				goto out;
 			}
 
-			blks = write_sparse_chunk_raw(info, blk, blkcnt,
+			blks = write_sparse_chunk_raw(info, &raw, blk, blkcnt,
 						      data, response);
 			if (IS_ERR_VALUE(blks))
-				return -1;
+				goto out;
 
 			blk += blks;
 			bytes_written += ((u64)blkcnt) * info->blksz;
@@ -224,61 +361,30 @@ int write_sparse_image(struct sparse_storage *info,
 			if (chunk_header->total_sz !=
 			    (sparse_header->chunk_hdr_sz + sizeof(uint32_t))) {
 				info->mssg("Bogus chunk size for chunk type FILL", response);
-				return -1;
-			}
-
-			fill_buf = (uint32_t *)
-				   memalign(ARCH_DMA_MINALIGN,
-					    ROUNDUP(
-						info->blksz * fill_buf_num_blks,
-						ARCH_DMA_MINALIGN));
-			if (!fill_buf) {
-				info->mssg("Malloc failed for: CHUNK_TYPE_FILL",
-					   response);
-				return -1;
+				goto out;
 			}
 
 			fill_val = *(uint32_t *)data;
 			data = (char *)data + sizeof(uint32_t);
 
-			for (i = 0;
-			     i < (info->blksz * fill_buf_num_blks /
-				  sizeof(fill_val));
-			     i++)
-				fill_buf[i] = fill_val;
-
 			if (blk + blkcnt > info->start + info->size) {
 				printf(
 				    "%s: Request would exceed partition size!\n",
 				    __func__);
 				info->mssg("Request would exceed partition size!",
 					   response);
-				return -1;
+				goto out;
 			}
 
-			for (i = 0; i < blkcnt;) {
-				j = blkcnt - i;
-				if (j > fill_buf_num_blks)
-					j = fill_buf_num_blks;
-				blks = info->write(info, blk, j, fill_buf);
-				/* blks might be > j (eg. NAND bad-blocks) */
-				if (blks < j) {
-					printf("%s: %s " LBAFU " [%d]\n",
-					       __func__,
-					       "Write failed, block #",
-					       blk, j);
-					info->mssg("flash write failure",
-						   response);
-					free(fill_buf);
-					return -1;
-				}
-				blk += blks;
-				i += j;
-			}
 			bytes_written += ((u64)blkcnt) * info->blksz;
 			total_blocks += DIV_ROUND_UP_ULL(chunk_data_sz,
 							 sparse_header->blk_sz);
-			free(fill_buf);
+
+			blks = write_sparse_chunk_fill(info, &fill, blk, blkcnt,
+						       fill_val, response);
+			if (IS_ERR_VALUE(blks))
+				goto out;
+			blk += blks;
 			break;
 
 		case CHUNK_TYPE_DONT_CARE:
@@ -291,7 +397,7 @@ int write_sparse_image(struct sparse_storage *info,
 			    sparse_header->chunk_hdr_sz + sizeof(uint32_t)) {
 				info->mssg("Bogus chunk size for chunk type CRC32",
 					   response);
-				return -1;
+				goto out;
 			}
 			total_blocks += chunk_header->chunk_sz;
 			data += chunk_data_sz;
@@ -301,18 +407,391 @@ int write_sparse_image(struct sparse_storage *info,
 			printf("%s: Unknown chunk type: %x\n", __func__,
 			       chunk_header->chunk_type);
 			info->mssg("Unknown chunk type", response);
-			return -1;
+			goto out;
 		}
 	}
 
+	blks = write_sparse_raw_flush(info, &raw, blk, response);
+	if (IS_ERR_VALUE(blks))
+		goto out;
+
 	debug("Wrote %d blocks, expected to write %d blocks\n",
 	      total_blocks, sparse_header->total_blks);
 	printf("........ wrote %llu bytes to '%s'\n", bytes_written, part_name);
 
 	if (total_blocks != sparse_header->total_blks) {
 		info->mssg("sparse image write failure", response);
-		return -1;
+		goto out;
+	}
+	ret = 0;
+
+out:
+	free(fill.buf);
+	free(raw.buf);
+
+	return ret;
+}
+
+enum sparse_stream_state {
+	SPARSE_STREAM_FILE_HDR,
+	SPARSE_STREAM_CHUNK_HDR,
+	SPARSE_STREAM_RAW,
+	SPARSE_STREAM_FILL,
+	SPARSE_STREAM_CRC32,
+	SPARSE_STREAM_DONE,
+	SPARSE_STREAM_ERROR,
+};
+
+/**
+ * struct sparse_stream - state for writing a sparse image as it arrives
+ *
+ * @info: Storage the image is written to
+ * @part_name: Name of the partition, for messages
+ * @state: What the next bytes of the image hold
+ * @header: Sparse image header
+ * @hold: Start of the header or chunk field being collected
+ * @need: Size of the field being collected, in bytes
+ * @held: Number of bytes of the field collected so far
+ * @skip: Number of bytes to drop before the next field, e.g. the part of a
+ *	header which is longer than we know about
+ * @chunk: Header of the current chunk
+ * @chunks: Number of chunks processed so far
+ * @blkcnt: Size of the current chunk in storage blocks
+ * @left: RAW data bytes of the current chunk which are still to come
+ * @part: Buffer for a storage block which is split between two writes
+ * @part_len: Number of bytes held in @part
+ * @blk: Next storage block to write
+ * @total_blocks: Number of sparse blocks covered so far
+ * @bytes_written: Number of bytes covered so far
+ * @raw: RAW data waiting to be written
+ * @fill: Buffer for FILL chunks
+ */
+struct sparse_stream {
+	struct sparse_storage *info;
+	const char *part_name;
+	enum sparse_stream_state state;
+	sparse_header_t header;
+	u8 hold[sizeof(sparse_header_t)];
+	uint32_t need;
+	uint32_t held;
+	uint32_t skip;
+	chunk_header_t chunk;
+	unsigned int chunks;
+	lbaint_t blkcnt;
+	uint64_t left;
+	void *part;
+	lbaint_t part_len;
+	lbaint_t blk;
+	uint32_t total_blocks;
+	uint64_t bytes_written;
+	struct sparse_raw raw;
+	struct sparse_fill fill;
+};
+
+static void sparse_stream_collect(struct sparse_stream *ss,
+				  enum sparse_stream_state state,
+				  uint32_t need)
+{
+	ss->state = state;
+	ss->need = need;
+	ss->held = 0;
+}
+
+/* Move on to the next chunk, or finish if that was the last one */
+static void sparse_stream_chunk_done(struct sparse_stream *ss)
+{
+	if (++ss->chunks == ss->header.total_chunks)
+		ss->state = SPARSE_STREAM_DONE;
+	else
+		sparse_stream_collect(ss, SPARSE_STREAM_CHUNK_HDR,
+				      sizeof(chunk_header_t));
+}
+
+static int sparse_stream_file_hdr(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	sparse_header_t *hdr = &ss->header;
+	uint32_t offset;
+
+	memcpy(hdr, ss->hold, sizeof(*hdr));
+	if (hdr->file_hdr_sz < sizeof(sparse_header_t) ||
+	    hdr->chunk_hdr_sz < sizeof(chunk_header_t)) {
+		info->mssg("sparse image header size issue", response);
+		return -EINVAL;
+	}
+
+	div_u64_rem(hdr->blk_sz, info->blksz, &offset);
+	if (!hdr->blk_sz || offset) {
+		printf("%s: Sparse image block size issue [%u]\n",
+		       __func__, hdr->blk_sz);
+		info->mssg("sparse image block size issue", response);
+		return -EINVAL;
+	}
+
+	puts("Flashing Sparse Image\n");
+	ss->skip = hdr->file_hdr_sz - sizeof(sparse_header_t);
+	if (hdr->total_chunks)
+		sparse_stream_collect(ss, SPARSE_STREAM_CHUNK_HDR,
+				      sizeof(chunk_header_t));
+	else
+		ss->state = SPARSE_STREAM_DONE;
+
+	return 0;
+}
+
+static int sparse_stream_chunk_hdr(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	chunk_header_t *chunk = &ss->chunk;
+	uint32_t hdr_sz = ss->header.chunk_hdr_sz;
+	uint64_t chunk_data_sz;
+	lbaint_t blks;
+
+	memcpy(chunk, ss->hold, sizeof(*chunk));
+	ss->skip = hdr_sz - sizeof(chunk_header_t);
+
+	chunk_data_sz = (u64)ss->header.blk_sz * chunk->chunk_sz;
+	ss->blkcnt = DIV_ROUND_UP_ULL(chunk_data_sz, info->blksz);
+
+	/* Only RAW chunks add to the data waiting to be written */
+	if (chunk->chunk_type != CHUNK_TYPE_RAW) {
+		blks = write_sparse_raw_flush(info, &ss->raw, ss->blk,
+					      response);
+		if (IS_ERR_VALUE(blks))
+			return blks;
+		ss->blk += blks;
+	}
+
+	switch (chunk->chunk_type) {
+	case CHUNK_TYPE_RAW:
+		if (chunk->total_sz != hdr_sz + chunk_data_sz) {
+			info->mssg("Bogus chunk size for chunk type Raw",
+				   response);
+			return -EINVAL;
+		}
+		if (ss->blk + ss->raw.cnt + ss->blkcnt >
+		    info->start + info->size)
+			break;
+
+		ss->bytes_written += (u64)ss->blkcnt * info->blksz;
+		ss->total_blocks += chunk->chunk_sz;
+		ss->left = chunk_data_sz;
+		ss->state = SPARSE_STREAM_RAW;
+		if (!ss->left)
+			sparse_stream_chunk_done(ss);
+		return 0;
+
+	case CHUNK_TYPE_FILL:
+		if (chunk->total_sz != hdr_sz + sizeof(uint32_t)) {
+			info->mssg("Bogus chunk size for chunk type FILL",
+				   response);
+			return -EINVAL;
+		}
+		if (ss->blk + ss->blkcnt > info->start + info->size)
+			break;
+
+		ss->bytes_written += (u64)ss->blkcnt * info->blksz;
+		ss->total_blocks += chunk->chunk_sz;
+		sparse_stream_collect(ss, SPARSE_STREAM_FILL,
+				      sizeof(uint32_t));
+		return 0;
+
+	case CHUNK_TYPE_DONT_CARE:
+		ss->blk += info->reserve(info, ss->blk, ss->blkcnt);
+		ss->total_blocks += chunk->chunk_sz;
+		sparse_stream_chunk_done(ss);
+		return 0;
+
+	case CHUNK_TYPE_CRC32:
+		if (chunk->total_sz != hdr_sz + sizeof(uint32_t)) {
+			info->mssg("Bogus chunk size for chunk type CRC32",
+				   response);
+			return -EINVAL;
+		}
+		ss->total_blocks += chunk->chunk_sz;
+		sparse_stream_collect(ss, SPARSE_STREAM_CRC32,
+				      sizeof(uint32_t));
+		return 0;
+
+	default:
+		printf("%s: Unknown chunk type: %x\n", __func__,
+		       chunk->chunk_type);
+		info->mssg("Unknown chunk type", response);
+		return -EINVAL;
+	}
+
+	printf("%s: Request would exceed partition size!\n", __func__);
+	info->mssg("Request would exceed partition size!", response);
+
+	return -ENOSPC;
+}
+
+/*
+ * Write RAW chunk data from @data, returning the number of bytes used. Blocks
+ * which are split between two calls are put together in @ss->part.
+ */
+static long sparse_stream_raw(struct sparse_stream *ss, void *data,
+			      uint32_t len, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t blks, blkcnt;
+	uint64_t n;
+
+	n = min_t(uint64_t, len, ss->left);
+	if (ss->part_len || n < info->blksz) {
+		n = min_t(uint64_t, n, info->blksz - ss->part_len);
+		if (!ss->part) {
+			ss->part = memalign(ARCH_DMA_MINALIGN, info->blksz);
+			if (!ss->part) {
+				info->mssg("Malloc failed for: CHUNK_TYPE_RAW",
+					   response);
+				return -ENOMEM;
+			}
+		}
+		memcpy(ss->part + ss->part_len, data, n);
+		ss->part_len += n;
+		data = ss->part;
+		blkcnt = ss->part_len == info->blksz ? 1 : 0;
+	} else {
+		blkcnt = lldiv(n, info->blksz);
+		n = blkcnt * info->blksz;
+	}
+
+	if (blkcnt) {
+		blks = write_sparse_chunk_raw(info, &ss->raw, ss->blk, blkcnt,
+					      data, response);
+		if (IS_ERR_VALUE(blks))
+			return blks;
+		ss->blk += blks;
+		ss->part_len = 0;
+	}
+
+	ss->left -= n;
+	if (!ss->left)
+		sparse_stream_chunk_done(ss);
+
+	return n;
+}
+
+/* The field in @ss->hold is complete, so act on it */
+static int sparse_stream_field(struct sparse_stream *ss, char *response)
+{
+	uint32_t fill_val;
+	lbaint_t blks;
+
+	switch (ss->state) {
+	case SPARSE_STREAM_FILE_HDR:
+		return sparse_stream_file_hdr(ss, response);
+	case SPARSE_STREAM_CHUNK_HDR:
+		return sparse_stream_chunk_hdr(ss, response);
+	case SPARSE_STREAM_FILL:
+		memcpy(&fill_val, ss->hold, sizeof(fill_val));
+		blks = write_sparse_chunk_fill(ss->info, &ss->fill, ss->blk,
+					       ss->blkcnt, fill_val, response);
+		if (IS_ERR_VALUE(blks))
+			return blks;
+		ss->blk += blks;
+		break;
+	default:
+		break;
 	}
+	sparse_stream_chunk_done(ss);
 
 	return 0;
 }
+
+struct sparse_stream *sparse_stream_start(struct sparse_storage *info,
+					  const char *part_name,
+					  char *response)
+{
+	struct sparse_stream *ss;
+
+	if (!info->mssg)
+		info->mssg = default_log;
+
+	ss = calloc(1, sizeof(*ss));
+	if (!ss) {
+		info->mssg("Malloc failed for sparse image", response);
+		return NULL;
+	}
+	ss->info = info;
+	ss->part_name = part_name;
+	ss->blk = info->start;
+	sparse_stream_collect(ss, SPARSE_STREAM_FILE_HDR,
+			      sizeof(sparse_header_t));
+
+	return ss;
+}
+
+int sparse_stream_write(struct sparse_stream *ss, void *data, uint32_t len,
+			char *response)
+{
+	uint32_t n;
+	long ret;
+
+	while (len && ss->state < SPARSE_STREAM_DONE) {
+		if (ss->skip) {
+			n = min(len, ss->skip);
+			ss->skip -= n;
+		} else if (ss->state == SPARSE_STREAM_RAW) {
+			ret = sparse_stream_raw(ss, data, len, response);
+			if (ret < 0)
+				goto err;
+			n = ret;
+		} else {
+			n = min(len, ss->need - ss->held);
+			memcpy(ss->hold + ss->held, data, n);
+			ss->held += n;
+			if (ss->held == ss->need) {
+				ret = sparse_stream_field(ss, response);
+				if (ret)
+					goto err;
+			}
+		}
+		data += n;
+		len -= n;
+	}
+
+	return ss->state == SPARSE_STREAM_ERROR ? -1 : 0;
+err:
+	ss->state = SPARSE_STREAM_ERROR;
+
+	return -1;
+}
+
+int sparse_stream_end(struct sparse_stream *ss, char *response)
+{
+	struct sparse_storage *info = ss->info;
+	lbaint_t blks;
+	int ret = -1;
+
+	if (ss->state == SPARSE_STREAM_ERROR)
+		goto out;
+	if (ss->state != SPARSE_STREAM_DONE) {
+		info->mssg("sparse image is truncated", response);
+		goto out;
+	}
+
+	blks = write_sparse_raw_flush(info, &ss->raw, ss->blk, response);
+	if (IS_ERR_VALUE(blks))
+		goto out;
+
+	debug("Wrote %d blocks, expected to write %d blocks\n",
+	      ss->total_blocks, ss->header.total_blks);
+	printf("........ wrote %llu bytes to '%s'\n", ss->bytes_written,
+	       ss->part_name);
+
+	if (ss->total_blocks != ss->header.total_blks) {
+		info->mssg("sparse image write failure", response);
+		goto out;
+	}
+	ret = 0;
+
+out:
+	free(ss->fill.buf);
+	free(ss->raw.buf);
+	free(ss->part);
+	free(ss);
+
+	return ret;
+}
@@ -3,6 +3,7 @@
  * Copyright (c) 2013 The Chromium OS Authors.
  */
 
+#include <bootstage.h>
 #include <efi.h>
 #include <initcall.h>
 #include <log.h>
@@ -54,6 +55,7 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 	enum event_t type;
 	init_fnc_t func;
 	int ret = 0;
+	int span;
 
 	for (ptr = init_sequence; func = *ptr, func; ptr++) {
 		reloc_ofs = calc_reloc_ofs();
@@ -71,9 +73,20 @@ int initcall_run_list(const init_fnc_t init_sequence[])
 			debug("initcall: %p\n", (char *)func - reloc_ofs);
 		}
 
+		if (type)
+			span = bootstage_span_begin(BOOTSTAGE_SPAN_INITCALL,
+						    event_type_name(type), 0);
+		else
+			span = bootstage_span_begin(BOOTSTAGE_SPAN_INITCALL,
+						    NULL,
+						    (ulong)func - reloc_ofs);
 		ret = type ? event_notify_null(type) : func();
+		bootstage_span_end(span);
 		if (ret)
 			break;
+
+		/* Let any slow hardware make progress */
+		initcall_async_poll();
 	}
 
 	if (ret) {
@@ -162,16 +162,40 @@ static long lmb_regions_adjacent(struct alist *lmb_rgn_lst, unsigned long r1,
 	return lmb_addrs_adjacent(base1, size1, base2, size2);
 }
 
-static void lmb_remove_region(struct alist *lmb_rgn_lst, unsigned long r)
+/**
+ * lmb_find_end() - Find the first region which ends at or above an address
+ *
+ * The regions in each list are sorted by base address and do not overlap, so
+ * their end addresses are sorted too and a binary search can be used.
+ *
+ * @lmb_rgn_lst: List of regions to search
+ * @addr: Address to look for
+ * Return: index of the first region whose last byte is at or above @addr, or
+ *	the number of regions if there is none
+ */
+static unsigned long lmb_find_end(struct alist *lmb_rgn_lst, phys_addr_t addr)
 {
-	unsigned long i;
 	struct lmb_region *rgn = lmb_rgn_lst->data;
+	unsigned long low = 0, high = lmb_rgn_lst->count;
 
-	for (i = r; i < lmb_rgn_lst->count - 1; i++) {
-		rgn[i].base = rgn[i + 1].base;
-		rgn[i].size = rgn[i + 1].size;
-		rgn[i].flags = rgn[i + 1].flags;
+	while (low < high) {
+		unsigned long mid = low + (high - low) / 2;
+
+		if (rgn[mid].base + rgn[mid].size - 1 < addr)
+			low = mid + 1;
+		else
+			high = mid;
 	}
+
+	return low;
+}
+
+static void lmb_remove_region(struct alist *lmb_rgn_lst, unsigned long r)
+{
+	struct lmb_region *rgn = lmb_rgn_lst->data;
+
+	memmove(&rgn[r], &rgn[r + 1],
+		(lmb_rgn_lst->count - r - 1) * sizeof(*rgn));
 	lmb_rgn_lst->count--;
 }
 
@@ -196,11 +220,9 @@ static void lmb_fix_over_lap_regions(struct alist *lmb_rgn_lst,
 	phys_addr_t base2 = rgn[r2].base;
 	phys_size_t size2 = rgn[r2].size;
 
-	if (base1 + size1 > base2 + size2) {
-		printf("This will not be a case any time\n");
-		return;
-	}
-	rgn[r1].size = base2 + size2 - base1;
+	/* Region 1 may have grown to cover all of region 2 */
+	if (base1 + size1 < base2 + size2)
+		rgn[r1].size = base2 + size2 - base1;
 	lmb_remove_region(lmb_rgn_lst, r2);
 }
 
@@ -340,13 +362,13 @@ static long lmb_resize_regions(struct alist *lmb_rgn_lst,
 		rgnbase = rgn[idx].base;
 		rgnsize = rgn[idx].size;
 
-		if (lmb_addrs_overlap(base, size, rgnbase,
-				      rgnsize)) {
-			if (rgn[idx].flags != LMB_NONE)
-				return -1;
-			rgn_cnt++;
-			idx_end = idx;
-		}
+		/* The overlapping regions are next to each other */
+		if (!lmb_addrs_overlap(base, size, rgnbase, rgnsize))
+			break;
+		if (rgn[idx].flags != LMB_NONE)
+			return -1;
+		rgn_cnt++;
+		idx_end = idx;
 		idx++;
 	}
 
@@ -385,14 +407,18 @@ static long lmb_add_region_flags(struct alist *lmb_rgn_lst, phys_addr_t base,
 				 phys_size_t size, enum lmb_flags flags)
 {
 	unsigned long coalesced = 0;
-	long ret, i;
+	long ret, i, j;
 	struct lmb_region *rgn = lmb_rgn_lst->data;
 
 	if (alist_err(lmb_rgn_lst))
 		return -1;
 
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < lmb_rgn_lst->count; i++) {
+	/*
+	 * First try and coalesce this LMB with another. Regions which end
+	 * before base - 1 cannot touch it, so skip those.
+	 */
+	i = base ? lmb_find_end(lmb_rgn_lst, base - 1) : 0;
+	for (; i < lmb_rgn_lst->count; i++) {
 		phys_addr_t rgnbase = rgn[i].base;
 		phys_size_t rgnsize = rgn[i].size;
 		phys_size_t rgnflags = rgn[i].flags;
@@ -409,14 +435,22 @@ static long lmb_add_region_flags(struct alist *lmb_rgn_lst, phys_addr_t base,
 		ret = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
 		if (ret > 0) {
 			if (flags != rgnflags)
-				break;
+				continue;
 			rgn[i].base -= size;
 			rgn[i].size += size;
 			coalesced++;
 			break;
 		} else if (ret < 0) {
+			/* The next region may still overlap the new one */
 			if (flags != rgnflags)
-				break;
+				continue;
+
+			/* Regions merged below must have the same flags */
+			for (j = i + 1; j < lmb_rgn_lst->count &&
+			     rgn[j].base <= end; j++) {
+				if (rgn[j].flags != flags)
+					return -1;
+			}
 			rgn[i].size += size;
 			coalesced++;
 			break;
@@ -432,20 +466,26 @@ static long lmb_add_region_flags(struct alist *lmb_rgn_lst, phys_addr_t base,
 			} else {
 				return -1;
 			}
+		} else if (rgnbase > base) {
+			/* This and all later regions are beyond the new one */
+			i = lmb_rgn_lst->count;
+			break;
 		}
 	}
 
-	if (lmb_rgn_lst->count && i < lmb_rgn_lst->count - 1) {
-		rgn = lmb_rgn_lst->data;
-		if (rgn[i].flags == rgn[i + 1].flags) {
-			if (lmb_regions_adjacent(lmb_rgn_lst, i, i + 1)) {
-				lmb_coalesce_regions(lmb_rgn_lst, i, i + 1);
-				coalesced++;
-			} else if (lmb_regions_overlap(lmb_rgn_lst, i, i + 1)) {
-				/* fix overlapping area */
-				lmb_fix_over_lap_regions(lmb_rgn_lst, i, i + 1);
-				coalesced++;
-			}
+	/* The region may now reach one or more of those after it */
+	rgn = lmb_rgn_lst->data;
+	while (lmb_rgn_lst->count && i < lmb_rgn_lst->count - 1 &&
+	       rgn[i].flags == rgn[i + 1].flags) {
+		if (lmb_regions_adjacent(lmb_rgn_lst, i, i + 1)) {
+			lmb_coalesce_regions(lmb_rgn_lst, i, i + 1);
+			coalesced++;
+		} else if (lmb_regions_overlap(lmb_rgn_lst, i, i + 1)) {
+			/* fix overlapping area */
+			lmb_fix_over_lap_regions(lmb_rgn_lst, i, i + 1);
+			coalesced++;
+		} else {
+			break;
 		}
 	}
 
@@ -458,17 +498,11 @@ static long lmb_add_region_flags(struct alist *lmb_rgn_lst, phys_addr_t base,
 	rgn = lmb_rgn_lst->data;
 
 	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = lmb_rgn_lst->count; i >= 0; i--) {
-		if (i && base < rgn[i - 1].base) {
-			rgn[i] = rgn[i - 1];
-		} else {
-			rgn[i].base = base;
-			rgn[i].size = size;
-			rgn[i].flags = flags;
-			break;
-		}
-	}
-
+	i = lmb_find_end(lmb_rgn_lst, base);
+	memmove(&rgn[i + 1], &rgn[i], (lmb_rgn_lst->count - i) * sizeof(*rgn));
+	rgn[i].base = base;
+	rgn[i].size = size;
+	rgn[i].flags = flags;
 	lmb_rgn_lst->count++;
 
 	return 0;
@@ -504,19 +538,16 @@ static long _lmb_free(phys_addr_t base, phys_size_t size)
 	phys_addr_t end = base + size - 1;
 	int i;
 
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
 	rgn = lmb_rgn_lst->data;
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < lmb_rgn_lst->count; i++) {
-		rgnbegin = rgn[i].base;
-		rgnend = rgnbegin + rgn[i].size - 1;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_find_end(lmb_rgn_lst, base);
+	if (i == lmb_rgn_lst->count)
+		return -1;
+	rgnbegin = rgn[i].base;
+	rgnend = rgnbegin + rgn[i].size - 1;
 
 	/* Didn't find the region */
-	if (i == lmb_rgn_lst->count)
+	if (rgnbegin > base || end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -603,14 +634,13 @@ static long lmb_overlaps_region(struct alist *lmb_rgn_lst, phys_addr_t base,
 	unsigned long i;
 	struct lmb_region *rgn = lmb_rgn_lst->data;
 
-	for (i = 0; i < lmb_rgn_lst->count; i++) {
-		phys_addr_t rgnbase = rgn[i].base;
-		phys_size_t rgnsize = rgn[i].size;
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
+	/* Later regions start above this one, so it is the only candidate */
+	i = lmb_find_end(lmb_rgn_lst, base);
+	if (i < lmb_rgn_lst->count &&
+	    lmb_addrs_overlap(base, size, rgn[i].base, rgn[i].size))
+		return i;
 
-	return (i < lmb_rgn_lst->count) ? i : -1;
+	return -1;
 }
 
 static phys_addr_t lmb_align_down(phys_addr_t addr, phys_size_t size)
@@ -791,7 +821,7 @@ phys_addr_t lmb_alloc_addr_flags(phys_addr_t base, phys_size_t size,
 /* Return number of bytes from a given address that are free */
 phys_size_t lmb_get_free_size(phys_addr_t addr)
 {
-	int i;
+	unsigned long i;
 	long rgn;
 	struct lmb_region *lmb_used = lmb.used_mem.data;
 	struct lmb_region *lmb_memory = lmb.free_mem.data;
@@ -799,16 +829,14 @@ phys_size_t lmb_get_free_size(phys_addr_t addr)
 	/* check if the requested address is in the memory regions */
 	rgn = lmb_overlaps_region(&lmb.free_mem, addr, 1);
 	if (rgn >= 0) {
-		for (i = 0; i < lmb.used_mem.count; i++) {
+		i = lmb_find_end(&lmb.used_mem, addr);
+		if (i < lmb.used_mem.count) {
 			if (addr < lmb_used[i].base) {
 				/* first reserved range > requested address */
 				return lmb_used[i].base - addr;
 			}
-			if (lmb_used[i].base +
-			    lmb_used[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+			/* requested addr is in this reserved range */
+			return 0;
 		}
 		/* if we come here: no reserved ranges above requested addr */
 		return lmb_memory[lmb.free_mem.count - 1].base +
@@ -819,15 +847,13 @@ phys_size_t lmb_get_free_size(phys_addr_t addr)
 
 int lmb_is_reserved_flags(phys_addr_t addr, int flags)
 {
-	int i;
+	unsigned long i;
 	struct lmb_region *lmb_used = lmb.used_mem.data;
 
-	for (i = 0; i < lmb.used_mem.count; i++) {
-		phys_addr_t upper = lmb_used[i].base +
-			lmb_used[i].size - 1;
-		if (addr >= lmb_used[i].base && addr <= upper)
-			return (lmb_used[i].flags & flags) == flags;
-	}
+	i = lmb_find_end(&lmb.used_mem, addr);
+	if (i < lmb.used_mem.count && addr >= lmb_used[i].base)
+		return (lmb_used[i].flags & flags) == flags;
+
 	return 0;
 }
 
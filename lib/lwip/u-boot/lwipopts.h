@@ -132,6 +132,7 @@
 
 #define PBUF_LINK_HLEN                  14
 #define PBUF_POOL_BUFSIZE               LWIP_MEM_ALIGN_SIZE(TCP_MSS + 40 + PBUF_LINK_HLEN)
+#define LWIP_SUPPORT_CUSTOM_PBUF        1
 
 #define LWIP_HAVE_LOOPIF                0
 
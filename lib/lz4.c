@@ -46,6 +46,19 @@ static FORCE_INLINE void LZ4_copy8(void *dst, const void *src)
 	put_unaligned(get_unaligned((const u64 *)src), (u64 *)dst);
 }
 
+/*
+ * Two loads followed by two stores, so that the compiler can use a load/store
+ * pair (e.g. ldp/stp on ARMv8) without needing FP/SIMD registers
+ */
+static FORCE_INLINE void LZ4_copy16(void *dst, const void *src)
+{
+	u64 a = get_unaligned((const u64 *)src);
+	u64 b = get_unaligned((const u64 *)src + 1);
+
+	put_unaligned(a, (u64 *)dst);
+	put_unaligned(b, (u64 *)dst + 1);
+}
+
 typedef  uint8_t BYTE;
 typedef uint16_t U16;
 typedef uint32_t U32;
@@ -71,12 +84,32 @@ static void LZ4_wildCopy(void* dstPtr, const void* srcPtr, void* dstEnd)
     do { LZ4_copy8(d,s); d+=8; s+=8; } while (d<e);
 }
 
+/*
+ * As LZ4_wildCopy() but 16 bytes at a time, so it may overwrite up to
+ * FASTCOPYLENGTH - 1 bytes beyond dstEnd. Source and destination must be at
+ * least FASTCOPYLENGTH bytes apart.
+ */
+static FORCE_INLINE void LZ4_wildCopy16(void *dstPtr, const void *srcPtr,
+					void *dstEnd)
+{
+	BYTE *d = dstPtr;
+	const BYTE *s = srcPtr;
+	BYTE *e = dstEnd;
+
+	do {
+		LZ4_copy16(d, s);
+		d += 16;
+		s += 16;
+	} while (d < e);
+}
+
 /**************************************
 *  Common Constants
 **************************************/
 #define MINMATCH 4
 
 #define WILDCOPYLENGTH 8
+#define FASTCOPYLENGTH 16
 #define LASTLITERALS 5
 #define MFLIMIT (WILDCOPYLENGTH + MINMATCH)
 
@@ -336,8 +369,17 @@ static FORCE_INLINE int LZ4_decompress_generic(
 			if (!partialDecoding || (cpy == oend))
 				break;
 		} else {
-			/* may overwrite up to WILDCOPYLENGTH beyond cpy */
-			LZ4_wildCopy(op, ip, cpy);
+			/*
+			 * may overwrite up to WILDCOPYLENGTH beyond cpy, or
+			 * FASTCOPYLENGTH when there is room for that on both
+			 * the input and the output side
+			 */
+			if (endOnInput && length > WILDCOPYLENGTH &&
+			    cpy <= oend - FASTCOPYLENGTH &&
+			    ip + length <= iend - FASTCOPYLENGTH)
+				LZ4_wildCopy16(op, ip, cpy);
+			else
+				LZ4_wildCopy(op, ip, cpy);
 			ip += length;
 			op = cpy;
 		}
@@ -493,9 +535,15 @@ _copy_match:
 			while (op < cpy)
 				*op++ = *match++;
 		} else {
-			LZ4_copy8(op, match);
-			if (length > 16)
-				LZ4_wildCopy(op + 8, match + 8, cpy);
+			if (length > 16 && offset >= FASTCOPYLENGTH &&
+			    cpy <= oend - FASTCOPYLENGTH) {
+				/* no overlap within a 16-byte copy */
+				LZ4_wildCopy16(op, match, cpy);
+			} else {
+				LZ4_copy8(op, match);
+				if (length > 16)
+					LZ4_wildCopy(op + 8, match + 8, cpy);
+			}
 		}
 		op = cpy; /* wildcopy correction */
 	}
@@ -5,6 +5,8 @@
 
 #include <compiler.h>
 #include <image.h>
+#include <malloc.h>
+#include <worker.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <asm/unaligned.h>
@@ -15,19 +17,134 @@
 
 #define LZ4F_BLOCKUNCOMPRESSED_FLAG 0x80000000U
 
+/**
+ * struct ulz4_block - One block of an LZ4 frame, for decompressing in a job
+ *
+ * @in: Block data
+ * @header: Block header (size and flag)
+ * @out: Where to write the decompressed data
+ * @out_max: Space available at @out
+ * @ret: Returns the decompressed size, or -ve error
+ */
+struct ulz4_block {
+	const void *in;
+	u32 header;
+	void *out;
+	size_t out_max;
+	int ret;
+};
+
+static void ulz4_block_job(void *priv, int job)
+{
+	struct ulz4_block *blk = (struct ulz4_block *)priv + job;
+	u32 block_size = blk->header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+
+	if (blk->header & LZ4F_BLOCKUNCOMPRESSED_FLAG) {
+		if (block_size > blk->out_max) {
+			blk->ret = -ENOBUFS;
+		} else {
+			memcpy(blk->out, blk->in, block_size);
+			blk->ret = block_size;
+		}
+	} else {
+		/* constant folding essential, do not touch params! */
+		blk->ret = LZ4_decompress_generic(blk->in, blk->out, block_size,
+				blk->out_max, endOnInputSize,
+				decode_full_block, noDict, blk->out, NULL, 0);
+	}
+}
+
+/*
+ * Decompress the (independent) blocks of a frame as separate jobs, each
+ * into its own slot of the output buffer, then close up any gaps. Returns
+ * -EAGAIN if this is not possible or fails, so that the caller can go
+ * through the frame in order and report exactly what went wrong.
+ */
+static int ulz4fn_blocks(const void *src, size_t srcn, const void *in,
+			 int has_block_checksum, u8 block_desc, void *dst,
+			 size_t *dstn)
+{
+	const void *end = dst + *dstn;
+	struct ulz4_block *blocks;
+	size_t block_max;
+	const void *pos;
+	int count, i;
+	void *out;
+
+	/* Block maximum size 4 (64KB) to 7 (4MB) */
+	if (block_desc >> 4 < 4)
+		return -EAGAIN;
+	block_max = 1 << (8 + 2 * (block_desc >> 4));
+
+	/* Blocks must not be overwritten by other blocks' output */
+	if (dst < src + srcn && src < end)
+		return -EAGAIN;
+
+	for (pos = in, count = 0;; count++) {
+		u32 block_size;
+
+		if (pos - src + sizeof(u32) > srcn)
+			return -EAGAIN;
+		block_size = get_unaligned_le32(pos) &
+			~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+		pos += sizeof(u32);
+		if (!block_size)
+			break;
+		if (pos - src + block_size > srcn)
+			return -EAGAIN;
+		pos += block_size;
+		if (has_block_checksum)
+			pos += sizeof(u32);
+	}
+	if (count < 2 || (count - 1) * block_max >= *dstn)
+		return -EAGAIN;
+
+	blocks = malloc(count * sizeof(*blocks));
+	if (!blocks)
+		return -EAGAIN;
+	for (pos = in, i = 0; i < count; i++) {
+		struct ulz4_block *blk = &blocks[i];
+
+		blk->header = get_unaligned_le32(pos);
+		blk->in = pos + sizeof(u32);
+		blk->out = dst + i * block_max;
+		blk->out_max = min(block_max, (size_t)(end - blk->out));
+		pos = blk->in + (blk->header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG);
+		if (has_block_checksum)
+			pos += sizeof(u32);
+	}
+
+	worker_run(ulz4_block_job, blocks, count);
+
+	for (out = dst, i = 0; i < count; i++) {
+		if (blocks[i].ret < 0) {
+			free(blocks);
+			return -EAGAIN;
+		}
+		if (blocks[i].out != out)
+			memmove(out, blocks[i].out, blocks[i].ret);
+		out += blocks[i].ret;
+	}
+	free(blocks);
+	*dstn = out - dst;
+
+	return 0;
+}
+
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 {
 	const void *end = dst + *dstn;
 	const void *in = src;
 	void *out = dst;
 	int has_block_checksum;
+	u8 block_desc;
 	int ret;
+	size_t dst_max = *dstn;
 	*dstn = 0;
 
 	{ /* With in-place decompression the header may become invalid later. */
 		u32 magic;
 		u8 flags, version, independent_blocks, has_content_size;
-		u8 block_desc;
 
 		if (srcn < sizeof(u32) + 3*sizeof(u8))
 			return -EINVAL;	/* input overrun */
@@ -61,6 +178,18 @@ int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
 		in += sizeof(u8);
 	}
 
+	/* Blocks are independent, so they can be decompressed in parallel */
+	if (CONFIG_IS_ENABLED(WORKER_CPUS)) {
+		size_t size = dst_max;
+
+		ret = ulz4fn_blocks(src, srcn, in, has_block_checksum,
+				    block_desc, dst, &size);
+		if (ret != -EAGAIN) {
+			*dstn = size;
+			return ret;
+		}
+	}
+
 	while (1) {
 		u32 block_header, block_size;
 
@@ -176,7 +176,19 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
         state -= (state < 4) ? state : 3;
         symbol = 1;
 
+#ifdef _LZMA_SIZE_OPT
         do { GET_BIT(prob + symbol, symbol) } while (symbol < 0x100);
+#else
+        /* Unrolled, since most of the time is spent on plain literals */
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+        GET_BIT(prob + symbol, symbol)
+#endif
       }
       else
       {
@@ -400,9 +412,13 @@ static int MY_FAST_CALL LzmaDec_DecodeReal(CLzmaDec *p, SizeT limit, const Byte
           const Byte *lim = dest + curLen;
           dicPos += curLen;
 
-          do
-            *(dest) = (Byte)*(dest + src);
-          while (++dest != lim);
+          /* A match at least its own length back does not overlap */
+          if (rep0 >= curLen)
+            memcpy(dest, dest + src, curLen);
+          else
+            do
+              *(dest) = (Byte)*(dest + src);
+            while (++dest != lim);
         }
         else
         {
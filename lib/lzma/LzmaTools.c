@@ -30,8 +30,11 @@
 #include "LzmaTools.h"
 #include "LzmaDec.h"
 
+#include <linux/errno.h>
+#include <linux/kernel.h>
 #include <linux/string.h>
 #include <malloc.h>
+#include <asm/unaligned.h>
 
 static void *SzAlloc(void *p, size_t size) { return malloc(size); }
 static void SzFree(void *p, void *address) { free(address); }
@@ -120,4 +123,110 @@ int lzmaBuffToBuffDecompress(unsigned char *outStream, SizeT *uncompressedSize,
     return res;
 }
 
+/**
+ * struct lzma_stream - state for decompressing LZMA data piece by piece
+ *
+ * @dec: LZMA decoder, using the destination buffer as its dictionary
+ * @alloc: Allocator for the decoder's probability tables
+ * @hdr: Header, gathered until it is complete
+ * @hdr_len: Number of header bytes seen so far
+ * @limit: Number of bytes to decompress to the destination buffer
+ * @done: true once the end of the compressed data has been reached
+ */
+struct lzma_stream {
+	CLzmaDec dec;
+	ISzAlloc alloc;
+	Byte hdr[LZMA_DATA_OFFSET];
+	int hdr_len;
+	SizeT limit;
+	bool done;
+};
+
+struct lzma_stream *lzma_stream_start(void *dst, ulong dstlen)
+{
+	struct lzma_stream *ls;
+
+	ls = calloc(1, sizeof(*ls));
+	if (!ls)
+		return NULL;
+	LzmaDec_Construct(&ls->dec);
+	ls->alloc.Alloc = SzAlloc;
+	ls->alloc.Free = SzFree;
+	ls->dec.dic = dst;
+	ls->dec.dicBufSize = dstlen;
+
+	return ls;
+}
+
+/* Set up the decoder once the whole header is available */
+static int lzma_stream_header(struct lzma_stream *ls)
+{
+	u64 size = get_unaligned_le64(ls->hdr + LZMA_SIZE_OFFSET);
+
+	if (LzmaDec_AllocateProbs(&ls->dec, ls->hdr, LZMA_PROPS_SIZE,
+				  &ls->alloc) != SZ_OK)
+		return -EIO;
+	LzmaDec_Init(&ls->dec);
+
+	/* All ones means that the size is unknown, with an end marker */
+	ls->limit = ls->dec.dicBufSize;
+	if (size != (u64)-1) {
+		if (size > ls->limit)
+			return -ENOSPC;
+		ls->limit = size;
+	}
+
+	return 0;
+}
+
+int lzma_stream_feed(struct lzma_stream *ls, const void *src, ulong len)
+{
+	const Byte *in = src;
+	ELzmaStatus status;
+	SizeT in_len;
+	int ret;
+
+	if (ls->done)
+		return 1;
+
+	/* Gather the header, which may be split across pieces */
+	if (ls->hdr_len < LZMA_DATA_OFFSET) {
+		int n = min_t(ulong, LZMA_DATA_OFFSET - ls->hdr_len, len);
+
+		memcpy(ls->hdr + ls->hdr_len, in, n);
+		ls->hdr_len += n;
+		in += n;
+		len -= n;
+		if (ls->hdr_len < LZMA_DATA_OFFSET)
+			return 0;
+		ret = lzma_stream_header(ls);
+		if (ret)
+			return ret;
+	}
+
+	/* Once the limit is reached, only an end marker is accepted */
+	in_len = len;
+	if (LzmaDec_DecodeToDic(&ls->dec, ls->limit, in, &in_len,
+				LZMA_FINISH_END, &status) != SZ_OK)
+		return ls->dec.dicPos == ls->dec.dicBufSize ? -ENOSPC : -EIO;
+	if (status == LZMA_STATUS_FINISHED_WITH_MARK ||
+	    status == LZMA_STATUS_MAYBE_FINISHED_WITHOUT_MARK) {
+		ls->done = true;
+		return 1;
+	}
+
+	return 0;
+}
+
+int lzma_stream_end(struct lzma_stream *ls, ulong *sizep)
+{
+	int ret = ls->done ? 0 : -EIO;
+
+	*sizep = ls->dec.dicPos;
+	LzmaDec_FreeProbs(&ls->dec, &ls->alloc);
+	free(ls);
+
+	return ret;
+}
+
 #endif
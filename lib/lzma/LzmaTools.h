@@ -11,6 +11,7 @@
 #ifndef __LZMA_TOOL_H__
 #define __LZMA_TOOL_H__
 
+#include <linux/types.h>
 #include <lzma/LzmaTypes.h>
 
 /**
@@ -28,4 +29,43 @@
 int lzmaBuffToBuffDecompress(unsigned char *outStream, SizeT *uncompressedSize,
 			     const unsigned char *inStream, SizeT length);
 
+struct lzma_stream;
+
+/**
+ * lzma_stream_start() - Start decompressing LZMA data piece by piece
+ *
+ * The compressed data is then passed to lzma_stream_feed() in pieces of any
+ * size, as it becomes available, and the output written directly to @dst,
+ * which also serves as the decoder's dictionary. The probability tables are
+ * allocated once the header has been seen.
+ *
+ * @dst: Destination for uncompressed data
+ * @dstlen: Size of destination buffer
+ * Return: stream state, or NULL if out of memory
+ */
+struct lzma_stream *lzma_stream_start(void *dst, ulong dstlen);
+
+/**
+ * lzma_stream_feed() - Decompress the next piece of LZMA data
+ *
+ * Anything following the end of the compressed data is ignored.
+ *
+ * @ls: Stream state from lzma_stream_start()
+ * @src: Next piece of compressed data
+ * @len: Length of data at @src
+ * Return: 0 if more data is needed, 1 if the end of the compressed data has
+ * been reached, -ENOSPC if the destination buffer is full, -EIO if the data
+ * is corrupt or out of memory
+ */
+int lzma_stream_feed(struct lzma_stream *ls, const void *src, ulong len);
+
+/**
+ * lzma_stream_end() - Finish decompressing and free the stream state
+ *
+ * @ls: Stream state from lzma_stream_start()
+ * @sizep: Returns the number of bytes written to the destination buffer
+ * Return: 0 if OK, -EIO if the end of the compressed data was not reached
+ */
+int lzma_stream_end(struct lzma_stream *ls, ulong *sizep);
+
 #endif
@@ -18,6 +18,7 @@
 #include <dm/of_access.h>
 #include <linux/err.h>
 #include <linux/sizes.h>
+#include <u-boot/crc.h>
 
 enum {
 	BUF_STEP	= SZ_64K,
@@ -174,6 +175,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 				np->phandle = be32_to_cpup(p);
 			pp->name = (char *)pname;
 			pp->length = sz;
+			pp->hash = of_prop_hash(pname);
 			pp->value = (__be32 *)p;
 			*prev_pp = pp;
 			prev_pp = &pp->next;
@@ -201,6 +203,7 @@ static void *unflatten_dt_node(const void *blob, void *mem, int *poffset,
 					__alignof__(struct property));
 		if (!dryrun) {
 			pp->name = "name";
+			pp->hash = of_prop_hash(pp->name);
 			pp->length = sz;
 			pp->value = pp + 1;
 			*prev_pp = pp;
@@ -318,15 +321,54 @@ int unflatten_device_tree(const void *blob, struct device_node **mynodes)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(OF_LIVE_STATIC)
+/* Devicetree which the names and values in of_live_static point into */
+static const void *of_live_static_base;
+
+int of_live_static_attach(const void *fdt_blob, struct device_node **rootp)
+{
+	struct of_live_static *lt = &of_live_static;
+	struct device_node *np;
+	struct property *pp;
+	long delta;
+
+	if (fdt_magic(fdt_blob) != FDT_MAGIC ||
+	    fdt_totalsize(fdt_blob) != lt->fdt_size ||
+	    crc32(0, fdt_blob, lt->fdt_size) != lt->fdt_crc)
+		return -ENOENT;
+
+	delta = (ulong)fdt_blob - (ulong)of_live_static_base;
+	for (pp = lt->props; pp != lt->props + lt->prop_count; pp++) {
+		pp->name += delta;
+		pp->value += delta;
+	}
+	for (np = lt->nodes; np != lt->nodes + lt->node_count; np++) {
+		np->name += delta;
+		np->type = of_get_property(np, "device_type", NULL);
+		if (!np->type)
+			np->type = "<NULL>";
+	}
+	of_live_static_base = fdt_blob;
+	*rootp = lt->nodes;
+
+	return 0;
+}
+#endif
+
 int of_live_build(const void *fdt_blob, struct device_node **rootp)
 {
 	int ret;
 
 	debug("%s: start\n", __func__);
-	ret = unflatten_device_tree(fdt_blob, rootp);
-	if (ret) {
-		debug("Failed to create live tree: err=%d\n", ret);
-		return ret;
+	if (CONFIG_IS_ENABLED(OF_LIVE_STATIC) &&
+	    !of_live_static_attach(fdt_blob, rootp)) {
+		debug("Using live tree generated at build time\n");
+	} else {
+		ret = unflatten_device_tree(fdt_blob, rootp);
+		if (ret) {
+			debug("Failed to create live tree: err=%d\n", ret);
+			return ret;
+		}
 	}
 	ret = of_alias_scan();
 	if (ret) {
@@ -246,6 +246,144 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 	return 0;
 }
 
+#ifdef __SIZEOF_INT128__
+/*
+ * On 64-bit machines, work on 64-bit limbs with a 128-bit accumulator.
+ * This needs a quarter of the multiplications of the 32-bit code above.
+ */
+typedef unsigned __int128 uint128_t;
+
+/**
+ * subtract_modulus64() - subtract modulus from the given value
+ *
+ * @mod:	Modulus, as little endian 64-bit word array
+ * @len:	Number of 64-bit words in each array
+ * @num:	Number to subtract modulus from, as little endian word array
+ */
+static void subtract_modulus64(const uint64_t mod[], uint len, uint64_t num[])
+{
+	uint64_t borrow = 0;
+	uint128_t acc;
+	uint i;
+
+	for (i = 0; i < len; i++) {
+		acc = (uint128_t)num[i] - mod[i] - borrow;
+		num[i] = (uint64_t)acc;
+		borrow = (uint64_t)(acc >> 64) & 1;
+	}
+}
+
+/**
+ * montgomery_mul64() - Perform montgomery multiply using 64-bit limbs
+ *
+ * Operation: montgomery result[] = a[] * b[] / R mod modulus
+ *
+ * This is montgomery_mul() with montgomery_mul_add_step() folded in.
+ *
+ * @mod:	Modulus, as little endian 64-bit word array
+ * @n0inv:	-1 / mod[0] mod 2^64
+ * @len:	Number of 64-bit words in each array
+ * @result:	Place to put result, as little endian 64-bit word array
+ * @a:		Multiplier, as little endian 64-bit word array
+ * @b:		Multiplicand, as little endian 64-bit word array
+ */
+static void montgomery_mul64(const uint64_t mod[], uint64_t n0inv, uint len,
+			     uint64_t result[], const uint64_t a[],
+			     const uint64_t b[])
+{
+	uint128_t acc_a, acc_b;
+	uint64_t d0;
+	uint i, j;
+
+	memset(result, '\0', len * sizeof(result[0]));
+	for (j = 0; j < len; j++) {
+		acc_a = (uint128_t)a[j] * b[0] + result[0];
+		d0 = (uint64_t)acc_a * n0inv;
+		acc_b = (uint128_t)d0 * mod[0] + (uint64_t)acc_a;
+		for (i = 1; i < len; i++) {
+			acc_a = (acc_a >> 64) + (uint128_t)a[j] * b[i] +
+				result[i];
+			acc_b = (acc_b >> 64) + (uint128_t)d0 * mod[i] +
+				(uint64_t)acc_a;
+			result[i - 1] = (uint64_t)acc_b;
+		}
+
+		acc_a = (acc_a >> 64) + (acc_b >> 64);
+		result[len - 1] = (uint64_t)acc_a;
+
+		if (acc_a >> 64)
+			subtract_modulus64(mod, len, result);
+	}
+}
+
+/**
+ * pow_mod64() - in-place public exponentiation using 64-bit limbs
+ *
+ * This follows pow_mod(), see there for details.
+ *
+ * @key:	RSA key, with an even number of 32-bit words
+ * @inout:	Big-endian word array containing value and result
+ */
+static int pow_mod64(const struct rsa_public_key *key, uint32_t *inout)
+{
+	uint len = key->len / 2;
+	uint64_t mod[len], rr[len], val[len], acc[len], tmp[len];
+	uint64_t a_scaled[len];
+	uint64_t inv, n0inv;
+	uint32_t *ptr;
+	uint i;
+	int j, k;
+
+	if (num_public_exponent_bits(key, &k) || k < 2 ||
+	    !is_public_exponent_bit_set(key, 0))
+		return -EINVAL;
+
+	for (i = 0; i < len; i++) {
+		mod[i] = key->modulus[2 * i] |
+			(uint64_t)key->modulus[2 * i + 1] << 32;
+		rr[i] = key->rr[2 * i] | (uint64_t)key->rr[2 * i + 1] << 32;
+	}
+	for (i = 0, ptr = inout + key->len - 2; i < len; i++, ptr -= 2)
+		val[i] = get_unaligned_be32(&ptr[1]) |
+			(uint64_t)get_unaligned_be32(&ptr[0]) << 32;
+
+	/* Extend 1 / mod[0] from 32 to 64 bits with one Newton step */
+	inv = (uint32_t)-key->n0inv;
+	inv *= 2 - mod[0] * inv;
+	n0inv = -inv;
+
+	montgomery_mul64(mod, n0inv, len, acc, val, rr);
+	memcpy(a_scaled, acc, sizeof(acc));
+
+	for (j = k - 2; j > 0; --j) {
+		montgomery_mul64(mod, n0inv, len, tmp, acc, acc);
+		if (is_public_exponent_bit_set(key, j))
+			montgomery_mul64(mod, n0inv, len, acc, tmp, a_scaled);
+		else
+			memcpy(acc, tmp, sizeof(acc));
+	}
+
+	montgomery_mul64(mod, n0inv, len, tmp, acc, acc);
+	montgomery_mul64(mod, n0inv, len, acc, tmp, val);
+
+	/* Make sure result < mod; result is at most 1x mod too large. */
+	for (i = len; i-- > 0;) {
+		if (acc[i] != mod[i])
+			break;
+	}
+	if ((int)i < 0 || acc[i] > mod[i])
+		subtract_modulus64(mod, len, acc);
+
+	/* Convert to bigendian byte array */
+	for (i = len, ptr = inout; i-- > 0; ptr += 2) {
+		put_unaligned_be32((uint32_t)(acc[i] >> 32), ptr);
+		put_unaligned_be32((uint32_t)acc[i], ptr + 1);
+	}
+
+	return 0;
+}
+#endif
+
 static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
 {
 	int i;
@@ -299,7 +437,12 @@ int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
 
 	memcpy(buf, sig, sig_len);
 
-	ret = pow_mod(&key, buf);
+#ifdef __SIZEOF_INT128__
+	if (!(key.len & 1))
+		ret = pow_mod64(&key, buf);
+	else
+#endif
+		ret = pow_mod(&key, buf);
 	if (ret)
 		return ret;
 
@@ -15,6 +15,8 @@
 #include <version_string.h>
 #include <asm/io.h>
 #include <linux/bitops.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
 #include <linux/unaligned/be_byteshift.h>
 #include <linux/unaligned/generic.h>
 #include <linux/unaligned/le_byteshift.h>
@@ -58,15 +60,23 @@ int tcg2_get_pcr_info(struct udevice *dev, u32 *supported_pcr, u32 *active_pcr,
 
 int tcg2_get_active_pcr_banks(struct udevice *dev, u32 *active_pcr_banks)
 {
+	struct tpm_chip_priv *priv = dev_get_uclass_priv(dev);
 	u32 supported = 0;
 	u32 pcr_banks = 0;
 	u32 active = 0;
 	int rc;
 
+	/* this takes two commands on a slow bus, so only ask the TPM once */
+	if (priv->active_pcr_banks) {
+		*active_pcr_banks = priv->active_pcr_banks;
+		return 0;
+	}
+
 	rc = tcg2_get_pcr_info(dev, &supported, &active, &pcr_banks);
 	if (rc)
 		return rc;
 
+	priv->active_pcr_banks = active;
 	*active_pcr_banks = active;
 
 	return 0;
@@ -92,16 +102,87 @@ u32 tcg2_event_get_size(struct tpml_digest_values *digest_list)
 	return len;
 }
 
+/*
+ * Hash this much data with each algorithm in turn, so that it is still in the
+ * cache for the next one
+ */
+#define TCG2_HASH_CHUNK		SZ_16K
+
+/**
+ * struct tcg2_hash_ctx - hash state for all the algorithms
+ *
+ * sha384 and sha512 both use a sha512_context, so each has its own
+ */
+struct tcg2_hash_ctx {
+	sha1_context sha1;
+	sha256_context sha256;
+	sha512_context sha384;
+	sha512_context sha512;
+};
+
+static void tcg2_hash_start(struct tcg2_hash_ctx *ctx, u16 alg)
+{
+	switch (alg) {
+	case TPM2_ALG_SHA1:
+		sha1_starts(&ctx->sha1);
+		break;
+	case TPM2_ALG_SHA256:
+		sha256_starts(&ctx->sha256);
+		break;
+	case TPM2_ALG_SHA384:
+		sha384_starts(&ctx->sha384);
+		break;
+	case TPM2_ALG_SHA512:
+		sha512_starts(&ctx->sha512);
+		break;
+	}
+}
+
+static void tcg2_hash_update(struct tcg2_hash_ctx *ctx, u16 alg,
+			     const u8 *input, u32 length)
+{
+	switch (alg) {
+	case TPM2_ALG_SHA1:
+		sha1_update(&ctx->sha1, input, length);
+		break;
+	case TPM2_ALG_SHA256:
+		sha256_update(&ctx->sha256, input, length);
+		break;
+	case TPM2_ALG_SHA384:
+		sha384_update(&ctx->sha384, input, length);
+		break;
+	case TPM2_ALG_SHA512:
+		sha512_update(&ctx->sha512, input, length);
+		break;
+	}
+}
+
+static void tcg2_hash_finish(struct tcg2_hash_ctx *ctx, u16 alg, u8 *final)
+{
+	switch (alg) {
+	case TPM2_ALG_SHA1:
+		sha1_finish(&ctx->sha1, final);
+		break;
+	case TPM2_ALG_SHA256:
+		sha256_finish(&ctx->sha256, final);
+		break;
+	case TPM2_ALG_SHA384:
+		sha384_finish(&ctx->sha384, final);
+		break;
+	case TPM2_ALG_SHA512:
+		sha512_finish(&ctx->sha512, final);
+		break;
+	}
+}
+
 int tcg2_create_digest(struct udevice *dev, const u8 *input, u32 length,
 		       struct tpml_digest_values *digest_list)
 {
 	u8 final[sizeof(union tpmu_ha)];
-	sha256_context ctx_256;
-	sha512_context ctx_512;
-	sha1_context ctx;
-	u32 active;
+	struct tcg2_hash_ctx ctx;
+	u32 active, pos, chunk;
 	size_t i;
-	u32 len;
+	u16 alg;
 	int rc;
 
 	rc = tcg2_get_active_pcr_banks(dev, &active);
@@ -113,42 +194,35 @@ int tcg2_create_digest(struct udevice *dev, const u8 *input, u32 length,
 		if (!(active & hash_algo_list[i].hash_mask))
 			continue;
 
-		switch (hash_algo_list[i].hash_alg) {
+		alg = hash_algo_list[i].hash_alg;
+		switch (alg) {
 		case TPM2_ALG_SHA1:
-			sha1_starts(&ctx);
-			sha1_update(&ctx, input, length);
-			sha1_finish(&ctx, final);
-			len = TPM2_SHA1_DIGEST_SIZE;
-			break;
 		case TPM2_ALG_SHA256:
-			sha256_starts(&ctx_256);
-			sha256_update(&ctx_256, input, length);
-			sha256_finish(&ctx_256, final);
-			len = TPM2_SHA256_DIGEST_SIZE;
-			break;
 		case TPM2_ALG_SHA384:
-			sha384_starts(&ctx_512);
-			sha384_update(&ctx_512, input, length);
-			sha384_finish(&ctx_512, final);
-			len = TPM2_SHA384_DIGEST_SIZE;
-			break;
 		case TPM2_ALG_SHA512:
-			sha512_starts(&ctx_512);
-			sha512_update(&ctx_512, input, length);
-			sha512_finish(&ctx_512, final);
-			len = TPM2_SHA512_DIGEST_SIZE;
 			break;
 		default:
-			printf("%s: unsupported algorithm %x\n", __func__,
-			       hash_algo_list[i].hash_alg);
+			printf("%s: unsupported algorithm %x\n", __func__, alg);
 			continue;
 		}
 
-		digest_list->digests[digest_list->count].hash_alg =
-			hash_algo_list[i].hash_alg;
-		memcpy(&digest_list->digests[digest_list->count].digest, final,
-		       len);
-		digest_list->count++;
+		tcg2_hash_start(&ctx, alg);
+		digest_list->digests[digest_list->count++].hash_alg = alg;
+	}
+
+	/* read the data once, feeding each chunk to all the algorithms */
+	for (pos = 0; pos < length; pos += chunk) {
+		chunk = min_t(u32, length - pos, TCG2_HASH_CHUNK);
+		for (i = 0; i < digest_list->count; i++)
+			tcg2_hash_update(&ctx, digest_list->digests[i].hash_alg,
+					 input + pos, chunk);
+	}
+
+	for (i = 0; i < digest_list->count; i++) {
+		alg = digest_list->digests[i].hash_alg;
+		tcg2_hash_finish(&ctx, alg, final);
+		memcpy(&digest_list->digests[i].digest, final,
+		       tpm2_algorithm_to_len(alg));
 	}
 
 	return 0;
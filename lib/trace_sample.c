@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Statistical profiling, by sampling the program counter from a timer
+ * interrupt
+ *
+ * Unlike function tracing this needs no instrumentation, so it can be used to
+ * profile a normal build. Each sample holds the unrelocated program counter
+ * and, if TRACE_SAMPLE_DEPTH is not 0, the return addresses found by
+ * walking the frame records. Samples are kept in a ring buffer, so the most
+ * recent ones are kept if it fills up.
+ */
+
+#include <malloc.h>
+#include <sort.h>
+#include <trace.h>
+#include <vsprintf.h>
+#include <asm/global_data.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	/* Number of addresses in each sample: the PC and its callers */
+	SAMPLE_WORDS	= 1 + CONFIG_TRACE_SAMPLE_DEPTH,
+};
+
+/**
+ * struct sample_info - Information about sampling
+ *
+ * @buf: Ring buffer of samples, each SAMPLE_WORDS long and zero-padded
+ * @head: Index of the next sample to write
+ * @count: Number of samples taken since sampling started, which may be more
+ *	than there is space for
+ * @stack_top: Top of the stack, as given by the architecture
+ * @hz: Sampling rate
+ * @running: true if sampling is running
+ */
+struct sample_info {
+	ulong *buf;
+	uint head;
+	ulong count;
+	ulong stack_top;
+	uint hz;
+	bool running;
+};
+
+static struct sample_info sample_info;
+
+int trace_sample_start(unsigned int hz)
+{
+	struct sample_info *info = &sample_info;
+	int ret;
+
+	if (!hz)
+		return -EINVAL;
+	trace_sample_stop();
+	if (!info->buf) {
+		info->buf = calloc(CONFIG_TRACE_SAMPLE_COUNT,
+				   SAMPLE_WORDS * sizeof(ulong));
+		if (!info->buf)
+			return -ENOMEM;
+	}
+	info->head = 0;
+	info->count = 0;
+	info->hz = hz;
+	ret = arch_trace_sample_start(hz, &info->stack_top);
+	if (ret)
+		return ret;
+	info->running = true;
+
+	return 0;
+}
+
+void trace_sample_stop(void)
+{
+	struct sample_info *info = &sample_info;
+
+	if (info->running) {
+		arch_trace_sample_stop();
+		info->running = false;
+	}
+}
+
+void trace_sample_record(unsigned long pc, unsigned long fp,
+			 unsigned long sp)
+{
+	struct sample_info *info = &sample_info;
+	ulong *rec;
+	int i;
+
+	if (!info->running)
+		return;
+	rec = &info->buf[info->head * SAMPLE_WORDS];
+	rec[0] = pc - gd->reloc_off;
+
+	/* Each frame record holds the caller's frame pointer, then the LR */
+	for (i = 1; i < SAMPLE_WORDS; i++) {
+		ulong *frame = (ulong *)fp;
+
+		if (fp < sp || fp & (sizeof(ulong) - 1) ||
+		    fp + 2 * sizeof(ulong) > info->stack_top || !frame[1])
+			break;
+		rec[i] = frame[1] - gd->reloc_off;
+		sp = fp + 2 * sizeof(ulong);
+		fp = frame[0];
+	}
+	for (; i < SAMPLE_WORDS; i++)
+		rec[i] = 0;
+
+	if (++info->head == CONFIG_TRACE_SAMPLE_COUNT)
+		info->head = 0;
+	info->count++;
+}
+
+static int h_cmp_sample(const void *v1, const void *v2)
+{
+	const ulong *s1 = v1, *s2 = v2;
+	int i;
+
+	for (i = 0; i < SAMPLE_WORDS; i++) {
+		if (s1[i] != s2[i])
+			return s1[i] < s2[i] ? -1 : 1;
+	}
+
+	return 0;
+}
+
+/**
+ * sort_samples() - Sort the samples so that identical ones are together
+ *
+ * This loses the order in which they were taken, which does not matter once
+ * sampling has stopped, since it restarts with an empty buffer
+ *
+ * Return: number of samples held
+ */
+static int sort_samples(void)
+{
+	struct sample_info *info = &sample_info;
+	int num;
+
+	num = min_t(ulong, info->count, CONFIG_TRACE_SAMPLE_COUNT);
+	if (!info->running && num)
+		qsort(info->buf, num, SAMPLE_WORDS * sizeof(ulong),
+		      h_cmp_sample);
+
+	return info->running ? 0 : num;
+}
+
+/* Get the number of addresses in a sample */
+static int sample_depth(const ulong *rec)
+{
+	int depth;
+
+	for (depth = 1; depth < SAMPLE_WORDS && rec[depth]; depth++)
+		;
+
+	return depth;
+}
+
+int trace_sample_folded(char *buf, int size)
+{
+	const ulong *rec, *next;
+	int num, len, i, j;
+	uint count;
+
+	len = 0;
+	if (size)
+		*buf = '\0';
+	num = sort_samples();
+	for (i = 0; i < num; i += count) {
+		rec = &sample_info.buf[i * SAMPLE_WORDS];
+		for (count = 1, next = rec + SAMPLE_WORDS; i + count < num &&
+		     !h_cmp_sample(rec, next); count++, next += SAMPLE_WORDS)
+			;
+		for (j = sample_depth(rec) - 1; j >= 0; j--)
+			len += snprintf(len < size ? buf + len : NULL,
+					len < size ? size - len : 0, "%#lx%s",
+					rec[j], j ? ";" : "");
+		len += snprintf(len < size ? buf + len : NULL,
+				len < size ? size - len : 0, " %u\n", count);
+	}
+
+	return len;
+}
+
+/**
+ * put_word() - Add a word to a profile
+ *
+ * @buf: Buffer holding the profile
+ * @size: Size of buffer
+ * @pos: Position to write at, updated by this function whether or not there
+ *	is space
+ * @val: Value to write
+ */
+static void put_word(void *buf, int size, int *pos, ulong val)
+{
+	if (*pos + sizeof(ulong) <= size)
+		memcpy(buf + *pos, &val, sizeof(ulong));
+	*pos += sizeof(ulong);
+}
+
+int trace_sample_pprof(void *buf, int size)
+{
+	const ulong *rec, *next;
+	char map[80];
+	int num, pos, maplen, depth, i, j;
+	uint count;
+
+	pos = 0;
+	num = sort_samples();
+
+	/* Header: header count, header words, version, period, padding */
+	put_word(buf, size, &pos, 0);
+	put_word(buf, size, &pos, 3);
+	put_word(buf, size, &pos, 0);
+	put_word(buf, size, &pos, 1000000 / (sample_info.hz ?: 1));
+	put_word(buf, size, &pos, 0);
+
+	for (i = 0; i < num; i += count) {
+		rec = &sample_info.buf[i * SAMPLE_WORDS];
+		for (count = 1, next = rec + SAMPLE_WORDS; i + count < num &&
+		     !h_cmp_sample(rec, next); count++, next += SAMPLE_WORDS)
+			;
+		depth = sample_depth(rec);
+		put_word(buf, size, &pos, count);
+		put_word(buf, size, &pos, depth);
+		for (j = 0; j < depth; j++)
+			put_word(buf, size, &pos, rec[j]);
+	}
+
+	/* Trailer, then the mapping, which is the identity */
+	put_word(buf, size, &pos, 0);
+	put_word(buf, size, &pos, 1);
+	put_word(buf, size, &pos, 0);
+	maplen = snprintf(map, sizeof(map),
+			  "%0*lx-%0*lx r-xp 00000000 00:00 0 u-boot\n",
+			  (int)sizeof(ulong) * 2, 0UL,
+			  (int)sizeof(ulong) * 2, ~0UL);
+	if (pos + maplen <= size)
+		memcpy(buf + pos, map, maplen);
+
+	return pos + maplen;
+}
+
+void trace_sample_print_stats(void)
+{
+	struct sample_info *info = &sample_info;
+
+	printf("Sampling %s at %u Hz\n", info->running ? "running" : "stopped",
+	       info->hz);
+	print_grouped_ull(info->count, 10);
+	puts(" samples taken\n");
+	if (info->count > CONFIG_TRACE_SAMPLE_COUNT) {
+		print_grouped_ull(info->count - CONFIG_TRACE_SAMPLE_COUNT, 10);
+		puts(" samples overwritten\n");
+	}
+	print_grouped_ull(min_t(ulong, info->count, CONFIG_TRACE_SAMPLE_COUNT),
+			  10);
+	puts(" samples held\n");
+	printf("%15d call depth limit\n", SAMPLE_WORDS - 1);
+}
@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Running compute jobs on secondary CPUs
+ */
+
+#define LOG_CATEGORY LOGC_CORE
+
+#include <log.h>
+#include <worker.h>
+#include <asm/global_data.h>
+#include <linux/kernel.h>
+#include <u-boot/schedule.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * struct worker_state - Jobs being run
+ *
+ * @fn: Function to call for each job
+ * @priv: Private data to pass to @fn
+ * @count: Number of jobs
+ * @next: Next job to be taken
+ */
+static struct worker_state {
+	worker_fn fn;
+	void *priv;
+	int count;
+	int next;
+} state;
+
+static void worker_loop(bool boot_cpu)
+{
+	int job;
+
+	while ((job = __atomic_fetch_add(&state.next, 1, __ATOMIC_ACQ_REL)) <
+	       state.count) {
+		state.fn(state.priv, job);
+		if (boot_cpu)
+			schedule();
+	}
+}
+
+void worker_secondary(void)
+{
+	worker_loop(false);
+}
+
+__weak int arch_worker_start(int max)
+{
+	return 0;
+}
+
+__weak void arch_worker_stop(void)
+{
+}
+
+int worker_run(worker_fn fn, void *priv, int count)
+{
+	int cpus = 0;
+
+	state.fn = fn;
+	state.priv = priv;
+	state.count = count;
+	__atomic_store_n(&state.next, 0, __ATOMIC_RELEASE);
+
+	/* Secondary CPUs share our page tables, so wait until they are final */
+	if (count > 1 && (gd->flags & GD_FLG_RELOC))
+		cpus = arch_worker_start(min(count - 1,
+					     CONFIG_WORKER_CPUS_MAX));
+	log_debug("%d jobs on %d CPUs\n", count, cpus + 1);
+
+	worker_loop(true);
+	if (cpus)
+		arch_worker_stop();
+
+	return cpus + 1;
+}
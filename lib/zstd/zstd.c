@@ -8,16 +8,273 @@
 #include <abuf.h>
 #include <log.h>
 #include <malloc.h>
+#include <worker.h>
+#include <asm/unaligned.h>
+#include <linux/bitops.h>
 #include <linux/errno.h>
+#include <linux/kernel.h>
 #include <linux/zstd.h>
 
+/* Seek table of the seekable format, held in a skippable frame at the end */
+#define ZSTD_SEEK_TABLE_MAGIC	0x184d2a5e
+#define ZSTD_SEEKABLE_MAGIC	0x8f92eab1
+#define ZSTD_SEEK_FOOTER_SIZE	9
+#define ZSTD_SEEK_CHECKSUM_FLAG	BIT(7)
+#define ZSTD_SEEK_RESERVED	0x7c
+
+static bool zstd_is_skippable(u32 magic)
+{
+	return (magic & ZSTD_MAGIC_SKIPPABLE_MASK) == ZSTD_MAGIC_SKIPPABLE_START;
+}
+
+/*
+ * Read the seek table at the end of @data into @entries (if not NULL).
+ * Returns the number of frames, or -ENOENT if there is no valid seek table
+ */
+static int zstd_read_seek_table(const void *data, size_t size,
+				struct zstd_seek_entry *entries)
+{
+	const void *footer = data + size - ZSTD_SEEK_FOOTER_SIZE;
+	size_t entry_size, table_size;
+	u64 in_offset, out_offset;
+	const void *pos;
+	u32 count, i;
+	u8 desc;
+
+	if (size < 2 * sizeof(u32) + ZSTD_SEEK_FOOTER_SIZE ||
+	    get_unaligned_le32(footer + 5) != ZSTD_SEEKABLE_MAGIC)
+		return -ENOENT;
+	count = get_unaligned_le32(footer);
+	desc = *(u8 *)(footer + 4);
+	if (desc & ZSTD_SEEK_RESERVED || count > INT_MAX / 12)
+		return -ENOENT;
+
+	entry_size = desc & ZSTD_SEEK_CHECKSUM_FLAG ? 12 : 8;
+	table_size = count * entry_size + ZSTD_SEEK_FOOTER_SIZE;
+	if (table_size > size - 2 * sizeof(u32))
+		return -ENOENT;
+	pos = footer - count * entry_size;
+	if (get_unaligned_le32(pos - 8) != ZSTD_SEEK_TABLE_MAGIC ||
+	    get_unaligned_le32(pos - 4) != table_size)
+		return -ENOENT;
+
+	for (i = 0, in_offset = 0, out_offset = 0; i < count; i++) {
+		u32 in_size = get_unaligned_le32(pos);
+		u32 out_size = get_unaligned_le32(pos + 4);
+
+		if (entries) {
+			entries[i].in_offset = in_offset;
+			entries[i].in_size = in_size;
+			entries[i].out_offset = out_offset;
+			entries[i].out_size = out_size;
+		}
+		in_offset += in_size;
+		out_offset += out_size;
+		pos += entry_size;
+	}
+
+	/* The frames must all come before the seek table */
+	if (in_offset > size - table_size - 2 * sizeof(u32))
+		return -ENOENT;
+
+	return count;
+}
+
+/*
+ * Walk the frames at the start of @data, filling in @entries (if not NULL).
+ * Skippable frames are left out and walking stops at anything which is not
+ * a frame. Returns the number of frames, or -ve on error
+ */
+static int zstd_walk_frames(const void *data, size_t size,
+			    struct zstd_seek_entry *entries)
+{
+	u64 out_offset = 0;
+	size_t pos, len;
+	int count = 0;
+
+	for (pos = 0; size - pos >= sizeof(u32); pos += len) {
+		u32 magic = get_unaligned_le32(data + pos);
+		zstd_frame_header header;
+
+		if (magic != ZSTD_MAGICNUMBER && !zstd_is_skippable(magic))
+			break;
+		len = zstd_find_frame_compressed_size(data + pos, size - pos);
+		if (zstd_is_error(len))
+			return -EINVAL;
+		if (zstd_is_skippable(magic))
+			continue;
+		if (zstd_get_frame_header(&header, data + pos, size - pos))
+			return -EINVAL;
+		if (header.frameContentSize == ZSTD_CONTENTSIZE_UNKNOWN ||
+		    header.frameContentSize > U32_MAX)
+			return -ENOTSUPP;
+		if (entries) {
+			entries[count].in_offset = pos;
+			entries[count].in_size = len;
+			entries[count].out_offset = out_offset;
+			entries[count].out_size = header.frameContentSize;
+		}
+		out_offset += header.frameContentSize;
+		count++;
+	}
+	if (!count)
+		return -EINVAL;
+
+	return count;
+}
+
+int zstd_seek_table(struct abuf *in, struct zstd_seek_entry **entriesp)
+{
+	int (*read)(const void *data, size_t size,
+		    struct zstd_seek_entry *entries);
+	struct zstd_seek_entry *entries;
+	int count;
+
+	read = zstd_read_seek_table;
+	count = read(abuf_data(in), abuf_size(in), NULL);
+	if (count == -ENOENT) {
+		read = zstd_walk_frames;
+		count = read(abuf_data(in), abuf_size(in), NULL);
+	}
+	if (count < 0)
+		return count;
+
+	entries = malloc(count * sizeof(*entries) ?: 1);
+	if (!entries)
+		return -ENOMEM;
+	read(abuf_data(in), abuf_size(in), entries);
+	*entriesp = entries;
+
+	return count;
+}
+
+/**
+ * struct zstd_frames - A run of frames to decompress in one job
+ *
+ * @in: Compressed data
+ * @out: Output buffer
+ * @entries: Frames to decompress
+ * @count: Number of frames in @entries
+ * @workspace: Workspace for the decompression context
+ * @ret: Returns 0 if all frames decompressed to their expected size, else
+ *	-ve error
+ */
+struct zstd_frames {
+	const void *in;
+	void *out;
+	const struct zstd_seek_entry *entries;
+	int count;
+	void *workspace;
+	int ret;
+};
+
+static void zstd_frames_job(void *priv, int job)
+{
+	struct zstd_frames *zj = (struct zstd_frames *)priv + job;
+	size_t wsize = zstd_dctx_workspace_bound();
+	zstd_dctx *ctx;
+	int i;
+
+	zj->ret = -EINVAL;
+	ctx = zstd_init_dctx(zj->workspace, wsize);
+	if (!ctx)
+		return;
+	for (i = 0; i < zj->count; i++) {
+		const struct zstd_seek_entry *e = &zj->entries[i];
+		size_t len;
+
+		len = zstd_decompress_dctx(ctx, zj->out + e->out_offset,
+					   e->out_size, zj->in + e->in_offset,
+					   e->in_size);
+		if (zstd_is_error(len) || len != e->out_size)
+			return;
+	}
+	zj->ret = 0;
+}
+
+/*
+ * Decompress the frames of @in as separate jobs, each writing to its own
+ * part of @out. Returns -EAGAIN if this is not possible or fails, so that the
+ * caller can go through the frames in order and report what went wrong.
+ */
+static int zstd_decompress_frames(struct abuf *in, struct abuf *out)
+{
+	const void *src = abuf_data(in), *dst = abuf_data(out);
+	size_t wsize = zstd_dctx_workspace_bound();
+	struct zstd_seek_entry *entries;
+	struct zstd_frames *jobs;
+	int count, njobs, i, ret;
+	u64 total;
+
+	/* Frames must not be overwritten by other frames' output */
+	if (dst < src + abuf_size(in) && src < dst + abuf_size(out))
+		return -EAGAIN;
+
+	count = zstd_seek_table(in, &entries);
+	if (count < 2) {
+		if (count >= 0)
+			free(entries);
+		return -EAGAIN;
+	}
+	total = entries[count - 1].out_offset + entries[count - 1].out_size;
+	if (total > abuf_size(out) || total > INT_MAX) {
+		free(entries);
+		return -EAGAIN;
+	}
+
+	njobs = min(count, CONFIG_IS_ENABLED(WORKER_CPUS, (CONFIG_WORKER_CPUS_MAX),
+					     (0)) + 1);
+	jobs = calloc(njobs, sizeof(*jobs));
+	if (!jobs) {
+		free(entries);
+		return -EAGAIN;
+	}
+
+	ret = -EAGAIN;
+	for (i = 0; i < njobs; i++) {
+		struct zstd_frames *zj = &jobs[i];
+		int first = i * count / njobs;
+
+		zj->in = src;
+		zj->out = abuf_data(out);
+		zj->entries = &entries[first];
+		zj->count = (i + 1) * count / njobs - first;
+		zj->workspace = malloc(wsize);
+		if (!zj->workspace)
+			goto do_free;
+	}
+
+	worker_run(zstd_frames_job, jobs, njobs);
+
+	for (i = 0; i < njobs; i++) {
+		if (jobs[i].ret)
+			goto do_free;
+	}
+	ret = total;
+
+do_free:
+	for (i = 0; i < njobs; i++)
+		free(jobs[i].workspace);
+	free(jobs);
+	free(entries);
+
+	return ret;
+}
+
 int zstd_decompress(struct abuf *in, struct abuf *out)
 {
 	zstd_dctx *ctx;
-	size_t wsize, len;
+	size_t wsize, len, size, pos, done;
 	void *workspace;
 	int ret;
 
+	/* Independent frames can be decompressed in parallel */
+	if (CONFIG_IS_ENABLED(WORKER_CPUS)) {
+		ret = zstd_decompress_frames(in, out);
+		if (ret != -EAGAIN)
+			return ret;
+	}
+
 	wsize = zstd_dctx_workspace_bound();
 	workspace = malloc(wsize);
 	if (!workspace) {
@@ -33,29 +290,114 @@ int zstd_decompress(struct abuf *in, struct abuf *out)
 		goto do_free;
 	}
 
-	/*
-	 * Find out how large the frame actually is, there may be junk at
-	 * the end of the frame that zstd_decompress_dctx() can't handle.
-	 */
-	len = zstd_find_frame_compressed_size(abuf_data(in), abuf_size(in));
-	if (zstd_is_error(len)) {
-		log_err("%s: failed to detect compressed size: %d\n", __func__,
-			zstd_get_error_code(len));
-		ret = -EINVAL;
-		goto do_free;
+	for (pos = 0, done = 0; abuf_size(in) - pos >= sizeof(u32); pos += len) {
+		const void *src = abuf_data(in) + pos;
+		u32 magic = get_unaligned_le32(src);
+
+		/* Anything after the last frame is ignored */
+		if (pos && magic != ZSTD_MAGICNUMBER &&
+		    !zstd_is_skippable(magic))
+			break;
+
+		/*
+		 * Find out how large the frame actually is, there may be junk
+		 * at the end of the frame that zstd_decompress_dctx() can't
+		 * handle.
+		 */
+		len = zstd_find_frame_compressed_size(src, abuf_size(in) - pos);
+		if (zstd_is_error(len)) {
+			log_err("%s: failed to detect compressed size: %d\n",
+				__func__, zstd_get_error_code(len));
+			ret = -EINVAL;
+			goto do_free;
+		}
+		if (zstd_is_skippable(magic))
+			continue;
+
+		size = zstd_decompress_dctx(ctx, abuf_data(out) + done,
+					    abuf_size(out) - done, src, len);
+		if (zstd_is_error(size)) {
+			log_err("%s: failed to decompress: %d\n", __func__,
+				zstd_get_error_code(size));
+			ret = -EINVAL;
+			goto do_free;
+		}
+		done += size;
 	}
 
-	len = zstd_decompress_dctx(ctx, abuf_data(out), abuf_size(out),
-				   abuf_data(in), len);
-	if (zstd_is_error(len)) {
-		log_err("%s: failed to decompress: %d\n", __func__,
-			zstd_get_error_code(len));
-		ret = -EINVAL;
+	ret = done;
+do_free:
+	free(workspace);
+	return ret;
+}
+
+int zstd_decompress_range(struct abuf *in, u64 offset, struct abuf *out)
+{
+	struct zstd_seek_entry *entries;
+	size_t wsize, want, done;
+	void *workspace, *bounce = NULL;
+	zstd_dctx *ctx;
+	int count, i, ret;
+
+	count = zstd_seek_table(in, &entries);
+	if (count < 0)
+		return count;
+
+	wsize = zstd_dctx_workspace_bound();
+	workspace = malloc(wsize);
+	if (!workspace) {
+		ret = -ENOMEM;
 		goto do_free;
 	}
+	ctx = zstd_init_dctx(workspace, wsize);
+	if (!ctx) {
+		ret = -EPERM;
+		goto do_free;
+	}
+
+	want = min_t(size_t, abuf_size(out), INT_MAX);
+	for (i = 0, done = 0; i < count && done < want; i++) {
+		const struct zstd_seek_entry *e = &entries[i];
+		u64 skip, end = e->out_offset + e->out_size;
+		size_t len, size;
+		void *dest;
+
+		if (end <= offset + done)
+			continue;
+		skip = offset + done - e->out_offset;
+		len = min_t(u64, e->out_size - skip, want - done);
+
+		/* Partial frames go through a bounce buffer */
+		dest = abuf_data(out) + done;
+		if (skip || len != e->out_size) {
+			free(bounce);
+			bounce = malloc(e->out_size);
+			if (!bounce) {
+				ret = -ENOMEM;
+				goto do_free;
+			}
+			dest = bounce;
+		}
+
+		size = zstd_decompress_dctx(ctx, dest, e->out_size,
+					    abuf_data(in) + e->in_offset,
+					    e->in_size);
+		if (zstd_is_error(size) || size != e->out_size) {
+			log_err("%s: failed to decompress frame %d\n", __func__,
+				i);
+			ret = -EINVAL;
+			goto do_free;
+		}
+		if (dest == bounce)
+			memcpy(abuf_data(out) + done, bounce + skip, len);
+		done += len;
+	}
+	ret = done;
 
-	ret = len;
 do_free:
+	free(bounce);
 	free(workspace);
+	free(entries);
+
 	return ret;
 }
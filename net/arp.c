@@ -27,6 +27,81 @@ int		arp_wait_try;
 uchar	       *arp_tx_packet; /* THE ARP transmit packet */
 static uchar	arp_tx_packet_buf[PKTSIZE_ALIGN + PKTALIGN];
 
+#ifdef CONFIG_NET_ARP_CACHE
+/**
+ * struct arp_cache_ent - an address learned from an ARP packet
+ *
+ * @ip: IP address, zero if the entry is unused
+ * @ethaddr: Ethernet address for @ip
+ * @dev_index: Index of the Ethernet device it was seen on
+ * @time: Time it was last seen, from get_timer()
+ */
+struct arp_cache_ent {
+	struct in_addr ip;
+	uchar ethaddr[ARP_HLEN];
+	int dev_index;
+	ulong time;
+};
+
+/* Not cleared by arp_init(), so that entries outlive each net_loop() */
+static struct arp_cache_ent arp_cache[CONFIG_NET_ARP_CACHE_SIZE];
+
+static void arp_cache_add(struct in_addr ip, const uchar *ethaddr)
+{
+	struct arp_cache_ent *ent, *oldest = &arp_cache[0];
+	int i;
+
+	if (!ip.s_addr)
+		return;
+	for (i = 0; i < ARRAY_SIZE(arp_cache); i++) {
+		ent = &arp_cache[i];
+		if (ent->ip.s_addr == ip.s_addr) {
+			oldest = ent;
+			break;
+		}
+		/* otherwise use a free entry, or else the oldest one */
+		if (!oldest->ip.s_addr)
+			continue;
+		if (!ent->ip.s_addr || ent->time < oldest->time)
+			oldest = ent;
+	}
+	oldest->ip = ip;
+	memcpy(oldest->ethaddr, ethaddr, ARP_HLEN);
+	oldest->dev_index = eth_get_dev_index();
+	oldest->time = get_timer(0);
+}
+
+static bool arp_cache_find(struct in_addr ip, uchar *ethaddr)
+{
+	struct arp_cache_ent *ent;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(arp_cache); i++) {
+		ent = &arp_cache[i];
+		if (ent->ip.s_addr != ip.s_addr)
+			continue;
+		if (ent->dev_index == eth_get_dev_index() &&
+		    get_timer(ent->time) < CONFIG_NET_ARP_CACHE_TIMEOUT * 1000) {
+			memcpy(ethaddr, ent->ethaddr, ARP_HLEN);
+			return true;
+		}
+		ent->ip.s_addr = 0;
+		break;
+	}
+
+	return false;
+}
+#else
+static inline void arp_cache_add(struct in_addr ip, const uchar *ethaddr)
+{
+}
+
+static inline bool arp_cache_find(struct in_addr ip, uchar *ethaddr)
+{
+	return false;
+}
+#endif
+
 void arp_init(void)
 {
 	/* XXX problem with bss workaround */
@@ -68,23 +143,38 @@ void arp_raw_request(struct in_addr source_ip, const uchar *target_ethaddr,
 	net_send_packet(arp_tx_packet, eth_hdr_size + ARP_HDR_SIZE);
 }
 
-void arp_request(void)
+/* Work out which address to ask for to reach @ip: the host or the gateway */
+static struct in_addr arp_next_hop(struct in_addr ip, bool warn)
 {
-	if ((net_arp_wait_packet_ip.s_addr & net_netmask.s_addr) !=
-	    (net_ip.s_addr & net_netmask.s_addr)) {
-		if (net_gateway.s_addr == 0) {
+	if ((ip.s_addr & net_netmask.s_addr) ==
+	    (net_ip.s_addr & net_netmask.s_addr))
+		return ip;
+	if (net_gateway.s_addr == 0) {
+		if (warn)
 			puts("## Warning: gatewayip needed but not set\n");
-			net_arp_wait_reply_ip = net_arp_wait_packet_ip;
-		} else {
-			net_arp_wait_reply_ip = net_gateway;
-		}
-	} else {
-		net_arp_wait_reply_ip = net_arp_wait_packet_ip;
+		return ip;
 	}
 
+	return net_gateway;
+}
+
+void arp_request(void)
+{
+	net_arp_wait_reply_ip = arp_next_hop(net_arp_wait_packet_ip, true);
+
 	arp_raw_request(net_ip, net_null_ethaddr, net_arp_wait_reply_ip);
 }
 
+bool arp_lookup(struct in_addr ip, uchar *ethaddr)
+{
+	if (!arp_cache_find(arp_next_hop(ip, false), ethaddr))
+		return false;
+	debug_cond(DEBUG_DEV_PKT, "ARP cache hit for %pI4 (%pM)\n", &ip,
+		   ethaddr);
+
+	return true;
+}
+
 int arp_timeout_check(void)
 {
 	ulong t;
@@ -158,6 +248,8 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 		net_copy_ip(&arp->ar_tpa, &arp->ar_spa);
 		memcpy(&arp->ar_sha, net_ethaddr, ARP_HLEN);
 		net_copy_ip(&arp->ar_spa, &net_ip);
+		/* the sender's addresses are now in the target fields */
+		arp_cache_add(net_read_ip(&arp->ar_tpa), &arp->ar_tha);
 
 #ifdef CONFIG_CMD_LINK_LOCAL
 		/*
@@ -178,6 +270,8 @@ void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len)
 		return;
 
 	case ARPOP_REPLY:		/* arp reply */
+		arp_cache_add(net_read_ip(&arp->ar_spa), &arp->ar_sha);
+
 		/* are we waiting for a reply? */
 		if (!arp_is_waiting())
 			break;
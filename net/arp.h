@@ -25,6 +25,18 @@ void arp_request(void);
 void arp_raw_request(struct in_addr source_ip, const uchar *targetEther,
 	struct in_addr target_ip);
 int arp_timeout_check(void);
+
+/**
+ * arp_lookup() - look up an address in the ARP cache
+ *
+ * This finds the Ethernet address of the host, or of the gateway if @ip is
+ * on another subnet, if an ARP packet from it was seen recently.
+ *
+ * @ip: IP address to send to
+ * @ethaddr: Returns the Ethernet address to send to
+ * Return: true if found, false if an ARP request is needed
+ */
+bool arp_lookup(struct in_addr ip, uchar *ethaddr);
 void arp_receive(struct ethernet_hdr *et, struct ip_udp_hdr *ip, int len);
 
 #endif /* __ARP_H__ */
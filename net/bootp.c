@@ -45,6 +45,9 @@
 #define CFG_DHCP_MIN_EXT_LEN 64
 #endif
 
+/* Time to wait for a reply to an INIT-REBOOT request before discovering */
+#define DHCP_REBOOT_TIMEOUT_MS	1000
+
 #ifndef CFG_BOOTP_ID_CACHE_SIZE
 #define CFG_BOOTP_ID_CACHE_SIZE 4
 #endif
@@ -505,6 +508,12 @@ static int dhcp_extended(u8 *e, int message_type, struct in_addr server_ip,
 		*e++ = tmp >> 8;
 		*e++ = tmp & 0xff;
 	}
+
+	if (IS_ENABLED(CONFIG_BOOTP_RAPID_COMMIT) &&
+	    message_type == DHCP_DISCOVER) {
+		*e++ = 80;	/* Rapid Commit */
+		*e++ = 0;
+	}
 #if defined(CONFIG_BOOTP_SEND_HOSTNAME)
 	hostname = env_get("hostname");
 	if (hostname) {
@@ -708,6 +717,25 @@ static int bootp_extended(u8 *e)
 }
 #endif
 
+/*
+ *	Bootp ID is the lower 4 bytes of our ethernet address
+ *	plus the current time in ms.
+ */
+static u32 bootp_new_id(void)
+{
+	u32 id;
+
+	id = ((u32)net_ethaddr[2] << 24)
+		| ((u32)net_ethaddr[3] << 16)
+		| ((u32)net_ethaddr[4] << 8)
+		| (u32)net_ethaddr[5];
+	id += get_timer(0);
+	id = htonl(id);
+	bootp_add_id(id);
+
+	return id;
+}
+
 void bootp_reset(void)
 {
 	bootp_num_ids = 0;
@@ -800,17 +828,7 @@ void bootp_request(void)
 	extlen = bootp_extended((u8 *)bp->bp_vend);
 #endif
 
-	/*
-	 *	Bootp ID is the lower 4 bytes of our ethernet address
-	 *	plus the current time in ms.
-	 */
-	bootp_id = ((u32)net_ethaddr[2] << 24)
-		| ((u32)net_ethaddr[3] << 16)
-		| ((u32)net_ethaddr[4] << 8)
-		| (u32)net_ethaddr[5];
-	bootp_id += get_timer(0);
-	bootp_id = htonl(bootp_id);
-	bootp_add_id(bootp_id);
+	bootp_id = bootp_new_id();
 	net_copy_u32(&bp->bp_id, &bootp_id);
 
 	/*
@@ -912,6 +930,8 @@ static void dhcp_process_options(uchar *popt, uchar *end)
 			break;
 		case 66:	/* Ignore TFTP server name */
 			break;
+		case 80:	/* Ignore Rapid Commit */
+			break;
 		case 67:	/* Bootfile option */
 			if (!net_boot_file_name_explicit) {
 				size = truncate_sz("Bootfile",
@@ -999,13 +1019,17 @@ static int dhcp_message_type(unsigned char *popt)
 	return -1;
 }
 
-static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
+/*
+ * Send a DHCPREQUEST for @requested_ip with transaction ID @id. The server
+ * ID is left out if @server_ip is zero, as for an INIT-REBOOT request.
+ */
+static void dhcp_send_request_packet(const u32 *id, struct in_addr server_ip,
+				     struct in_addr requested_ip)
 {
 	uchar *pkt, *iphdr;
 	struct bootp_hdr *bp;
 	int pktlen, iplen, extlen;
 	int eth_hdr_size;
-	struct in_addr offered_ip;
 	struct in_addr zero_ip;
 	struct in_addr bcast_ip;
 
@@ -1038,20 +1062,9 @@ static void dhcp_send_request_packet(struct bootp_hdr *bp_offer)
 	memcpy(bp->bp_chaddr, net_ethaddr, 6);
 	copy_filename(bp->bp_file, net_boot_file_name, sizeof(bp->bp_file));
 
-	/*
-	 * ID is the id of the OFFER packet
-	 */
-
-	net_copy_u32(&bp->bp_id, &bp_offer->bp_id);
-
-	/*
-	 * Copy options from OFFER packet if present
-	 */
-
-	/* Copy offered IP into the parameters request list */
-	net_copy_ip(&offered_ip, &bp_offer->bp_yiaddr);
-	extlen = dhcp_extended((u8 *)bp->bp_vend, DHCP_REQUEST,
-		dhcp_server_ip, offered_ip);
+	net_copy_u32(&bp->bp_id, id);
+	extlen = dhcp_extended((u8 *)bp->bp_vend, DHCP_REQUEST, server_ip,
+			       requested_ip);
 
 	iplen = BOOTP_HDR_SIZE - OPT_FIELD_SIZE + extlen;
 	pktlen = eth_hdr_size + IP_UDP_HDR_SIZE + iplen;
@@ -1069,6 +1082,7 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			 unsigned src, unsigned len)
 {
 	struct bootp_hdr *bp = (struct bootp_hdr *)pkt;
+	struct in_addr offered_ip;
 
 	debug("DHCPHandler: got packet: (src=%d, dst=%d, len=%d) state: %d\n",
 	      src, dest, len, dhcp_state);
@@ -1080,6 +1094,14 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	debug("DHCPHandler: got DHCP packet: (src=%d, dst=%d, len=%d) state: "
 	      "%d\n", src, dest, len, dhcp_state);
 
+	if (dhcp_state == REBOOTING &&
+	    dhcp_message_type((u8 *)bp->bp_vend) == DHCP_NAK) {
+		puts("DHCP lease refused\n");
+		env_set("dhcp_lease", NULL);
+		bootp_request();
+		return;
+	}
+
 	if (net_read_ip(&bp->bp_yiaddr).s_addr == 0) {
 #if defined(CONFIG_SERVERIP_FROM_PROXYDHCP)
 		store_bootp_params(bp);
@@ -1106,10 +1128,15 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("got BOOTP response; transitioning to BOUND\n");
 				goto dhcp_got_bootp;
 			}
-			dhcp_packet_process_options(bp);
 			if (CONFIG_IS_ENABLED(EFI_LOADER) &&
 			    IS_ENABLED(CONFIG_NETDEVICES))
 				efi_net_set_dhcp_ack(pkt, len);
+			if (IS_ENABLED(CONFIG_BOOTP_RAPID_COMMIT) &&
+			    dhcp_message_type((u8 *)bp->bp_vend) == DHCP_ACK) {
+				debug("got rapid-commit ACK; transitioning to BOUND\n");
+				goto dhcp_got_bootp;
+			}
+			dhcp_packet_process_options(bp);
 
 #if defined(CONFIG_SERVERIP_FROM_PROXYDHCP)
 			if (!net_server_ip.s_addr)
@@ -1121,22 +1148,36 @@ static void dhcp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			dhcp_state = REQUESTING;
 
 			net_set_timeout_handler(5000, bootp_timeout_handler);
-			dhcp_send_request_packet(bp);
+			net_copy_ip(&offered_ip, &bp->bp_yiaddr);
+			dhcp_send_request_packet(&bp->bp_id, dhcp_server_ip,
+						 offered_ip);
 #ifdef CONFIG_SYS_BOOTFILE_PREFIX
 		}
 #endif	/* CONFIG_SYS_BOOTFILE_PREFIX */
 
 		return;
 		break;
+	case REBOOTING:
 	case REQUESTING:
-		debug("DHCP State: REQUESTING\n");
+		debug("DHCP State: %s\n",
+		      dhcp_state == REBOOTING ? "REBOOTING" : "REQUESTING");
 
 		if (dhcp_message_type((u8 *)bp->bp_vend) == DHCP_ACK) {
+			if (dhcp_state == REBOOTING &&
+			    CONFIG_IS_ENABLED(EFI_LOADER) &&
+			    IS_ENABLED(CONFIG_NETDEVICES))
+				efi_net_set_dhcp_ack(pkt, len);
 dhcp_got_bootp:
 			dhcp_packet_process_options(bp);
 			/* Store net params from reply */
 			store_net_params(bp);
 			dhcp_state = BOUND;
+			if (IS_ENABLED(CONFIG_BOOTP_INIT_REBOOT)) {
+				char tmp[22];
+
+				ip_to_string(net_ip, tmp);
+				env_set("dhcp_lease", tmp);
+			}
 			printf("DHCP client bound to address %pI4 (%lu ms)\n",
 			       &net_ip, get_timer(bootp_start));
 			net_set_timeout_handler(0, (thand_f *)0);
@@ -1156,8 +1197,43 @@ dhcp_got_bootp:
 	}
 }
 
+static void dhcp_reboot_timeout_handler(void)
+{
+	puts("No reply to DHCP lease request\n");
+	bootp_request();
+}
+
+/*
+ * Ask for the lease we had before, skipping DHCPDISCOVER (RFC 2131 section
+ * 3.2). If the server refuses or does not answer, start again from INIT.
+ */
+static void dhcp_reboot_request(struct in_addr lease)
+{
+	struct in_addr zero_ip;
+	u32 id;
+
+	bootstage_mark_name(BOOTSTAGE_ID_BOOTP_START, "bootp_start");
+	printf("DHCP requesting previous lease %pI4\n", &lease);
+	zero_ip.s_addr = 0;
+	dhcp_server_ip = zero_ip;
+	dhcp_state = REBOOTING;
+	id = bootp_new_id();
+	net_set_timeout_handler(DHCP_REBOOT_TIMEOUT_MS,
+				dhcp_reboot_timeout_handler);
+	net_set_udp_handler(dhcp_handler);
+	dhcp_send_request_packet(&id, zero_ip, lease);
+}
+
 void dhcp_request(void)
 {
+	if (IS_ENABLED(CONFIG_BOOTP_INIT_REBOOT)) {
+		struct in_addr lease = env_get_ip("dhcp_lease");
+
+		if (lease.s_addr) {
+			dhcp_reboot_request(lease);
+			return;
+		}
+	}
 	bootp_request();
 }
 #endif	/* CONFIG_CMD_DHCP */
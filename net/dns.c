@@ -35,6 +35,92 @@ char *net_dns_env_var;	/* The envvar to store the answer in */
 
 static int dns_our_port;
 
+#ifdef CONFIG_DNS_CACHE
+/* Longest name which is cached; longer ones are always looked up */
+#define DNS_CACHE_NAME_LEN	64
+
+/**
+ * struct dns_cache_ent - an A record from an earlier lookup
+ *
+ * @name: Host name, empty if the entry is unused
+ * @ip: Its IP address
+ * @time: Time the answer arrived, from get_timer()
+ * @ttl_ms: Time for which the answer may be used, in milliseconds
+ */
+struct dns_cache_ent {
+	char name[DNS_CACHE_NAME_LEN];
+	struct in_addr ip;
+	ulong time;
+	ulong ttl_ms;
+};
+
+static struct dns_cache_ent dns_cache[CONFIG_DNS_CACHE_SIZE];
+
+static void dns_cache_add(const char *name, struct in_addr ip, u32 ttl)
+{
+	struct dns_cache_ent *ent, *oldest = &dns_cache[0];
+	int i;
+
+	if (!ttl || strlen(name) >= DNS_CACHE_NAME_LEN)
+		return;
+	for (i = 0; i < ARRAY_SIZE(dns_cache); i++) {
+		ent = &dns_cache[i];
+		if (!strcmp(ent->name, name)) {
+			oldest = ent;
+			break;
+		}
+		/* otherwise use a free entry, or else the oldest one */
+		if (!*oldest->name)
+			continue;
+		if (!*ent->name || ent->time < oldest->time)
+			oldest = ent;
+	}
+	strcpy(oldest->name, name);
+	oldest->ip = ip;
+	oldest->time = get_timer(0);
+	oldest->ttl_ms = min_t(u32, ttl, CONFIG_DNS_CACHE_MAX_TTL) * 1000;
+}
+
+static bool dns_cache_find(const char *name, struct in_addr *ip)
+{
+	struct dns_cache_ent *ent;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(dns_cache); i++) {
+		ent = &dns_cache[i];
+		if (strcmp(ent->name, name))
+			continue;
+		if (get_timer(ent->time) < ent->ttl_ms) {
+			*ip = ent->ip;
+			return true;
+		}
+		*ent->name = '\0';
+		break;
+	}
+
+	return false;
+}
+#else
+static inline void dns_cache_add(const char *name, struct in_addr ip, u32 ttl)
+{
+}
+
+static inline bool dns_cache_find(const char *name, struct in_addr *ip)
+{
+	return false;
+}
+#endif
+
+static void dns_set_result(struct in_addr ip_addr)
+{
+	char ip_str[22];
+
+	ip_to_string(ip_addr, ip_str);
+	printf("%s\n", ip_str);
+	if (net_dns_env_var)
+		env_set(net_dns_env_var, ip_str);
+}
+
 /*
  * make port a little random (1024-17407)
  * This keeps the math somewhat trivial to compute, and seems to work with
@@ -118,7 +204,6 @@ static void dns_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	const unsigned char *p, *e, *s;
 	u16 type, i;
 	int found, stop, dlen;
-	char ip_str[22];
 	struct in_addr ip_addr;
 
 	debug("%s\n", __func__);
@@ -191,10 +276,9 @@ static void dns_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		memcpy(&ip_addr, p, 4);
 
 		if (p + dlen <= e) {
-			ip_to_string(ip_addr, ip_str);
-			printf("%s\n", ip_str);
-			if (net_dns_env_var)
-				env_set(net_dns_env_var, ip_str);
+			dns_cache_add(net_dns_resolve, ip_addr,
+				      get_unaligned_be32(p - 6));
+			dns_set_result(ip_addr);
 		} else {
 			puts("server responded with invalid IP number\n");
 		}
@@ -205,8 +289,17 @@ static void dns_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 void dns_start(void)
 {
+	struct in_addr ip_addr;
+
 	debug("%s\n", __func__);
 
+	if (dns_cache_find(net_dns_resolve, &ip_addr)) {
+		debug("DNS: using cached answer\n");
+		dns_set_result(ip_addr);
+		net_set_state(NETLOOP_SUCCESS);
+		return;
+	}
+
 	net_set_timeout_handler(DNS_TIMEOUT, dns_timeout_handler);
 	net_set_udp_handler(dns_handler);
 
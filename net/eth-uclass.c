@@ -27,10 +27,14 @@ DECLARE_GLOBAL_DATA_PTR;
  * struct eth_device_priv - private structure for each Ethernet device
  *
  * @state: The state of the Ethernet MAC driver (defined by enum eth_state_t)
+ * @rx_csum_ok: true if the MAC checked the checksums of the packet received
+ * @stats: Traffic counters, see eth_get_stats()
  */
 struct eth_device_priv {
 	enum eth_state_t state;
 	bool running;
+	bool rx_csum_ok;
+	struct eth_stats stats;
 };
 
 /**
@@ -400,6 +404,27 @@ end:
 	in_init_halt = false;
 }
 
+#ifdef CONFIG_TFTP_MULTICAST
+int eth_mcast_join(struct in_addr mcast_ip, int join)
+{
+	struct udevice *current = eth_get_dev();
+	u8 mcast_mac[ARP_HLEN] = { 0x01, 0x00, 0x5e };
+	u32 ip = ntohl(mcast_ip.s_addr);
+
+	if (!current)
+		return -ENODEV;
+	if (!eth_get_ops(current)->mcast)
+		return -ENOSYS;
+
+	/* RFC1112: the low 23 bits of the group address go in the MAC */
+	mcast_mac[3] = (ip >> 16) & 0x7f;
+	mcast_mac[4] = (ip >> 8) & 0xff;
+	mcast_mac[5] = ip & 0xff;
+
+	return eth_get_ops(current)->mcast(current, mcast_mac, join);
+}
+#endif
+
 int eth_is_active(struct udevice *dev)
 {
 	struct eth_device_priv *priv;
@@ -411,8 +436,24 @@ int eth_is_active(struct udevice *dev)
 	return priv->state == ETH_STATE_ACTIVE;
 }
 
+struct eth_stats *eth_get_stats(struct udevice *dev)
+{
+	struct eth_device_priv *priv = dev_get_uclass_priv(dev);
+
+	return &priv->stats;
+}
+
+void eth_count_rx_csum_error(void)
+{
+	struct udevice *current = eth_get_dev();
+
+	if (current)
+		eth_get_stats(current)->rx_csum_errors++;
+}
+
 int eth_send(void *packet, int length)
 {
+	struct eth_stats *stats;
 	struct udevice *current;
 	int ret;
 
@@ -423,10 +464,18 @@ int eth_send(void *packet, int length)
 	if (!eth_is_active(current))
 		return -EINVAL;
 
+	stats = eth_get_stats(current);
 	ret = eth_get_ops(current)->send(current, packet, length);
 	if (ret < 0) {
 		/* We cannot completely return the error at present */
 		debug("%s: send() returned error %d\n", __func__, ret);
+		if (ret == -ENOSPC || ret == -EBUSY)
+			stats->tx_ring_full++;
+		else
+			stats->tx_errors++;
+	} else {
+		stats->tx_packets++;
+		stats->tx_bytes += length;
 	}
 #if defined(CONFIG_CMD_PCAP)
 	if (ret >= 0)
@@ -435,13 +484,35 @@ int eth_send(void *packet, int length)
 	return ret;
 }
 
+bool net_rx_csum_ok;
+
+void eth_set_rx_csum_ok(struct udevice *dev)
+{
+	struct eth_device_priv *priv = dev_get_uclass_priv(dev);
+
+	priv->rx_csum_ok = true;
+}
+
+bool eth_tx_csum_offload(void)
+{
+	struct udevice *current = eth_get_dev();
+	struct eth_pdata *pdata;
+
+	if (!current)
+		return false;
+	pdata = dev_get_plat(current);
+
+	return pdata->csum_offload & ETH_CSUM_TX;
+}
+
 int eth_rx(void)
 {
+	struct eth_device_priv *priv;
 	struct udevice *current;
 	uchar *packet;
 	int flags;
 	int ret;
-	int i;
+	int i, num = 0;
 
 	current = eth_get_dev();
 	if (!current)
@@ -451,12 +522,20 @@ int eth_rx(void)
 		return -EINVAL;
 
 	/* Process up to 32 packets at one time */
+	priv = dev_get_uclass_priv(current);
 	flags = ETH_RECV_CHECK_DEVICE;
 	for (i = 0; i < ETH_PACKETS_BATCH_RECV; i++) {
+		priv->rx_csum_ok = false;
 		ret = eth_get_ops(current)->recv(current, flags, &packet);
 		flags = 0;
-		if (ret > 0)
+		if (ret > 0) {
+			priv->stats.rx_packets++;
+			priv->stats.rx_bytes += ret;
+			net_rx_csum_ok = priv->rx_csum_ok;
 			net_process_received_packet(packet, ret);
+			net_rx_csum_ok = false;
+			num++;
+		}
 		if (ret >= 0 && eth_get_ops(current)->free_pkt)
 			eth_get_ops(current)->free_pkt(current, packet, ret);
 		if (ret <= 0)
@@ -467,8 +546,9 @@ int eth_rx(void)
 	if (ret < 0) {
 		/* We cannot completely return the error at present */
 		debug("%s: recv() returned error %d\n", __func__, ret);
+		priv->stats.rx_errors++;
 	}
-	return ret;
+	return num ? num : ret;
 }
 
 int eth_initialize(void)
@@ -3,10 +3,16 @@
  * Copyright (C) 2023 The Android Open Source Project
  */
 
+#include <errno.h>
 #include <fastboot.h>
+#include <malloc.h>
 #include <net.h>
 #include <net/fastboot_tcp.h>
 #include <net/tcp.h>
+#include <asm/unaligned.h>
+
+/* Each message starts with its length, as a big endian 64-bit number */
+#define FASTBOOT_MSG_HDR_LEN	8
 
 static char command[FASTBOOT_COMMAND_LEN] = {0};
 static char response[FASTBOOT_RESPONSE_LEN] = {0};
@@ -25,14 +31,42 @@ static enum fastboot_tcp_state {
 	FASTBOOT_DISCONNECTING
 } state = FASTBOOT_CLOSED;
 
+/* Sequence number of the next byte we send */
+static u32 tx_seq;
+/* Sequence number of the next byte of the stream to be parsed */
+static u32 rx_seq;
+/* Whether anything was sent in answer to the current segment */
+static bool answered;
+
+/* Header of the message being received, and how much of it has arrived */
+static u8 msg_hdr[FASTBOOT_MSG_HDR_LEN];
+static unsigned int msg_hdr_len;
+/* Bytes of the message being received which are still to come */
+static u64 msg_left;
+/* Length of the command received so far */
+static unsigned int command_len;
+/* Bytes of the download still to come, whether or not they are stored */
+static u32 download_left;
+
+/*
+ * Data which arrives beyond a hole in the stream, held at its sequence number
+ * modulo TCP_RX_WINDOW until the hole is filled. TCP accepts nothing further
+ * than that beyond the hole.
+ */
+static uchar *rx_ring;
+
 static void fastboot_tcp_answer(u8 action, unsigned int len)
 {
-	const u32 response_seq_num = curr_tcp_ack_num;
 	const u32 response_ack_num = curr_tcp_seq_num +
 		  (curr_request_len > 0 ? curr_request_len : 1);
 
+	/* Anything sent carries the ACK, so a delayed one is not needed */
+	if (!answered)
+		net_set_timeout_handler(0, NULL);
 	net_send_tcp_packet(len, htons(curr_sport), htons(curr_dport),
-			    action, response_seq_num, response_ack_num);
+			    action, tx_seq, response_ack_num);
+	tx_seq += len;
+	answered = true;
 }
 
 static void fastboot_tcp_reset(void)
@@ -67,73 +101,213 @@ static void fastboot_tcp_send_message(const char *message, unsigned int len)
 	memset(pkt, '\0', PKTSIZE);
 }
 
+/* Send an ACK which was delayed */
+static void fastboot_tcp_ack_timeout(void)
+{
+	net_set_timeout_handler(0, NULL);
+	fastboot_tcp_answer(TCP_ACK, 0);
+}
+
+/**
+ * fastboot_tcp_run_command() - Run the command which has just been received
+ */
+static void fastboot_tcp_run_command(void)
+{
+	int fastboot_command_id;
+
+	command[command_len] = '\0';
+	command_len = 0;
+	fastboot_command_id = fastboot_handle_command(command, response);
+	fastboot_tcp_send_message(response, strlen(response));
+
+	/* The following data is the download */
+	if (!strncmp("DATA", response, 4))
+		download_left = fastboot_data_remaining();
+	fastboot_handle_boot(fastboot_command_id,
+			     strncmp("OKAY", response, 4) == 0);
+}
+
+/**
+ * fastboot_tcp_download() - Pass download data on as it arrives
+ *
+ * If the download fails part way, its FAIL response is sent at once and
+ * the rest of the data is thrown away.
+ *
+ * @data: Pointer to the data
+ * @len: Length of the data
+ */
+static void fastboot_tcp_download(const uchar *data, unsigned int len)
+{
+	if (fastboot_data_remaining() == download_left) {
+		fastboot_data_download(data, len, response);
+		if (*response) {
+			fastboot_tcp_send_message(response, strlen(response));
+		} else if (len == download_left) {
+			fastboot_data_complete(response);
+			fastboot_tcp_send_message(response, strlen(response));
+		}
+	}
+	download_left -= len;
+}
+
+/**
+ * fastboot_tcp_parse() - Parse the next part of the stream
+ *
+ * Messages may be split across segments, or share them, in any way.
+ *
+ * @data: Pointer to the data
+ * @len: Length of the data
+ * Return: 0 if OK, -EINVAL if the connection has been reset
+ */
+static int fastboot_tcp_parse(const uchar *data, unsigned int len)
+{
+	unsigned int n;
+
+	while (len) {
+		if (msg_hdr_len < FASTBOOT_MSG_HDR_LEN) {
+			n = min(len, FASTBOOT_MSG_HDR_LEN - msg_hdr_len);
+			memcpy(msg_hdr + msg_hdr_len, data, n);
+			msg_hdr_len += n;
+			data += n;
+			len -= n;
+			if (msg_hdr_len == FASTBOOT_MSG_HDR_LEN) {
+				msg_left = get_unaligned_be64(msg_hdr);
+				if (!msg_left)
+					msg_hdr_len = 0;
+			}
+			continue;
+		}
+
+		n = min_t(u64, len, msg_left);
+		if (download_left) {
+			n = min(n, download_left);
+			fastboot_tcp_download(data, n);
+		} else if (command_len + n < FASTBOOT_COMMAND_LEN) {
+			memcpy(command + command_len, data, n);
+			command_len += n;
+		} else {
+			fastboot_tcp_reset();
+			return -EINVAL;
+		}
+		data += n;
+		len -= n;
+		msg_left -= n;
+
+		if (!msg_left) {
+			msg_hdr_len = 0;
+			if (command_len)
+				fastboot_tcp_run_command();
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * fastboot_tcp_data() - Handle data received on the connection
+ *
+ * Data which follows what has been parsed is parsed straight from the
+ * packet, followed by anything received earlier which it joins up with.
+ * Data beyond a hole waits in rx_ring.
+ *
+ * @pkt: Pointer to the data
+ * @seq: Sequence number of the first byte
+ * @len: Length of the data
+ */
+static void fastboot_tcp_data(const uchar *pkt, u32 seq, unsigned int len)
+{
+	u32 edge = tcp_get_ack_edge();
+	unsigned int n, pos;
+
+	if ((s32)(seq - rx_seq) > 0) {
+		if (!rx_ring) {
+			fastboot_tcp_reset();
+			return;
+		}
+		while (len) {
+			pos = seq % TCP_RX_WINDOW;
+			n = min(len, TCP_RX_WINDOW - pos);
+			memcpy(rx_ring + pos, pkt, n);
+			pkt += n;
+			seq += n;
+			len -= n;
+		}
+		return;
+	}
+
+	n = rx_seq - seq;
+	if (n < len) {
+		rx_seq = seq + len;
+		if (fastboot_tcp_parse(pkt + n, len - n))
+			return;
+	}
+
+	while ((s32)(edge - rx_seq) > 0 && state == FASTBOOT_CONNECTED) {
+		pos = rx_seq % TCP_RX_WINDOW;
+		n = min(edge - rx_seq, TCP_RX_WINDOW - pos);
+		rx_seq += n;
+		if (fastboot_tcp_parse(rx_ring + pos, n))
+			return;
+	}
+}
+
 static void fastboot_tcp_handler_ipv4(uchar *pkt, u16 dport,
 				      struct in_addr sip, u16 sport,
 				      u32 tcp_seq_num, u32 tcp_ack_num,
 				      u8 action, unsigned int len)
 {
-	int fastboot_command_id;
-	u64 command_size;
 	u8 tcp_fin = action & TCP_FIN;
-	u8 tcp_push = action & TCP_PUSH;
 
 	curr_sport = sport;
 	curr_dport = dport;
 	curr_tcp_seq_num = tcp_seq_num;
 	curr_tcp_ack_num = tcp_ack_num;
 	curr_request_len = len;
+	answered = false;
 
 	switch (state) {
 	case FASTBOOT_CLOSED:
-		if (tcp_push) {
+		if (len) {
+			tx_seq = tcp_ack_num;
 			if (len != handshake_length ||
-			    strlen(pkt) != handshake_length ||
 			    memcmp(pkt, handshake, handshake_length) != 0) {
 				fastboot_tcp_reset();
 				break;
 			}
+			rx_seq = tcp_seq_num + len;
+			msg_hdr_len = 0;
+			command_len = 0;
+			download_left = 0;
 			fastboot_tcp_send_packet(TCP_ACK | TCP_PUSH,
 						 handshake, handshake_length);
 			state = FASTBOOT_CONNECTED;
 		}
 		break;
 	case FASTBOOT_CONNECTED:
+		if (len)
+			fastboot_tcp_data(pkt, tcp_seq_num, len);
+		if (state != FASTBOOT_CONNECTED)
+			break;
 		if (tcp_fin) {
 			fastboot_tcp_answer(TCP_FIN | TCP_ACK, 0);
 			state = FASTBOOT_DISCONNECTING;
 			break;
 		}
-		if (tcp_push) {
-			// First 8 bytes is big endian message length
-			command_size = __be64_to_cpu(*(u64 *)pkt);
-			len -= 8;
-			pkt += 8;
-
-			// Only single packet messages are supported ATM
-			if (strlen(pkt) != command_size) {
-				fastboot_tcp_reset();
-				break;
-			}
-			strlcpy(command, pkt, len + 1);
-			fastboot_command_id = fastboot_handle_command(command, response);
-			fastboot_tcp_send_message(response, strlen(response));
-			fastboot_handle_boot(fastboot_command_id,
-					     strncmp("OKAY", response, 4) == 0);
+		if (len && !answered) {
+			if (tcp_ack_delayed())
+				net_set_timeout_handler(TCP_ACK_DELAY,
+							fastboot_tcp_ack_timeout);
+			else
+				fastboot_tcp_answer(TCP_ACK, 0);
 		}
 		break;
 	case FASTBOOT_DISCONNECTING:
-		if (tcp_push)
+		if (action & TCP_PUSH)
 			state = FASTBOOT_CLOSED;
 		break;
 	}
 
-	memset(command, 0, FASTBOOT_COMMAND_LEN);
 	memset(response, 0, FASTBOOT_RESPONSE_LEN);
-	curr_sport = 0;
-	curr_dport = 0;
-	curr_tcp_seq_num = 0;
-	curr_tcp_ack_num = 0;
-	curr_request_len = 0;
 }
 
 void fastboot_tcp_start_server(void)
@@ -141,5 +315,11 @@ void fastboot_tcp_start_server(void)
 	printf("Using %s device\n", eth_get_name());
 	printf("Listening for fastboot command on tcp %pI4\n", &net_ip);
 
+	if (!rx_ring)
+		rx_ring = malloc(TCP_RX_WINDOW);
+	if (!rx_ring)
+		printf("No memory for out-of-order data\n");
+	state = FASTBOOT_CLOSED;
+	tcp_set_tcp_state(TCP_CLOSED);
 	tcp_set_tcp_handler(fastboot_tcp_handler_ipv4);
 }
@@ -12,6 +12,8 @@
 #include <lwip/etharp.h>
 #include <lwip/init.h>
 #include <lwip/prot/etharp.h>
+#include <lwip/priv/tcp_priv.h>
+#include <malloc.h>
 #include <net.h>
 
 /* xx:xx:xx:xx:xx:xx\0 */
@@ -244,9 +246,115 @@ static struct pbuf *alloc_pbuf_and_copy(uchar *data, int len)
         return p;
 }
 
-int net_lwip_rx(struct udevice *udev, struct netif *netif)
+/**
+ * struct net_lwip_rx_pbuf - A received frame, handed to lwIP in place
+ *
+ * @pc: The pbuf, which refers to the driver's buffer to start with
+ * @held: true if lwIP still held the pbuf when the driver wanted the buffer
+ *	back, so that the frame now lives in @data
+ * @freed: true if lwIP freed the pbuf while it still referred to the
+ *	driver's buffer
+ * @len: Length of the frame
+ * @data: Room for the frame, should lwIP hold on to it
+ */
+struct net_lwip_rx_pbuf {
+	struct pbuf_custom pc;
+	bool held;
+	bool freed;
+	int len;
+	uchar data[] __aligned(ARCH_DMA_MINALIGN);
+};
+
+static void net_lwip_rx_pbuf_free(struct pbuf *p)
+{
+	struct net_lwip_rx_pbuf *rp = (struct net_lwip_rx_pbuf *)p;
+
+	if (rp->held)
+		free(rp);
+	else
+		rp->freed = true;
+}
+
+/**
+ * net_lwip_rx_hold() - Move a frame which lwIP holds out of the driver buffer
+ *
+ * lwIP keeps a received frame when it is out-of-order TCP data, or data the
+ * application has not taken yet. The driver needs its buffer back, so the
+ * frame is copied into the room kept for it. Queued TCP segments point at
+ * their header, which moves along with the rest.
+ *
+ * @rp: The frame
+ * @packet: The driver buffer holding it
+ */
+static void net_lwip_rx_hold(struct net_lwip_rx_pbuf *rp, uchar *packet)
+{
+	struct pbuf *p = &rp->pc.pbuf;
+#if LWIP_TCP && TCP_QUEUE_OOSEQ
+	struct tcp_pcb *pcb;
+	struct tcp_seg *seg;
+	uchar *hdr;
+#endif
+
+	memcpy(rp->data, packet, rp->len);
+	p->payload = rp->data + ((uchar *)p->payload - packet);
+#if LWIP_TCP && TCP_QUEUE_OOSEQ
+	for (pcb = tcp_active_pcbs; pcb; pcb = pcb->next) {
+		for (seg = pcb->ooseq; seg; seg = seg->next) {
+			hdr = (uchar *)seg->tcphdr;
+			if (hdr >= packet && hdr < packet + rp->len)
+				seg->tcphdr = (void *)(rp->data + (hdr - packet));
+		}
+	}
+#endif
+	rp->held = true;
+}
+
+/**
+ * net_lwip_rx_input() - Pass a received frame to lwIP
+ *
+ * With LWIP_ZERO_COPY_RX the pbuf refers to the driver buffer, which is only
+ * copied if lwIP keeps the frame once it has been processed.
+ *
+ * @netif: Interface the frame arrived on
+ * @packet: Frame received
+ * @len: Length of the frame
+ */
+static void net_lwip_rx_input(struct netif *netif, uchar *packet, int len)
 {
+	struct net_lwip_rx_pbuf *rp;
 	struct pbuf *pbuf;
+
+	if (!IS_ENABLED(CONFIG_LWIP_ZERO_COPY_RX)) {
+		pbuf = alloc_pbuf_and_copy(packet, len);
+		if (pbuf)
+			netif->input(pbuf, netif);
+		return;
+	}
+
+	rp = malloc(sizeof(*rp) + len);
+	if (!rp) {
+		LINK_STATS_INC(link.memerr);
+		LINK_STATS_INC(link.drop);
+		return;
+	}
+	rp->held = false;
+	rp->freed = false;
+	rp->len = len;
+	rp->pc.custom_free_function = net_lwip_rx_pbuf_free;
+	pbuf = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &rp->pc, packet,
+				   len);
+	LINK_STATS_INC(link.recv);
+	if (netif->input(pbuf, netif) != ERR_OK)
+		pbuf_free(pbuf);
+
+	if (rp->freed)
+		free(rp);
+	else
+		net_lwip_rx_hold(rp, packet);
+}
+
+int net_lwip_rx(struct udevice *udev, struct netif *netif)
+{
 	uchar *packet;
 	int flags;
 	int len;
@@ -260,11 +368,8 @@ int net_lwip_rx(struct udevice *udev, struct netif *netif)
 		len = eth_get_ops(udev)->recv(udev, flags, &packet);
 		flags = 0;
 
-		if (len > 0) {
-			pbuf = alloc_pbuf_and_copy(packet, len);
-			if (pbuf)
-				netif->input(pbuf, netif);
-		}
+		if (len > 0)
+			net_lwip_rx_input(netif, packet, len);
 		if (len >= 0 && eth_get_ops(udev)->free_pkt)
 			eth_get_ops(udev)->free_pkt(udev, packet, len);
 		if (len <= 0)
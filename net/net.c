@@ -150,6 +150,8 @@ u8 net_server_ethaddr[6];
 struct in_addr	net_ip;
 /* Server IP addr (0 = unknown) */
 struct in_addr	net_server_ip;
+/* Multicast group joined (0 = none) */
+struct in_addr	net_mcast_addr;
 /* Current receive packet */
 uchar *net_rx_packet;
 /* Current rx packet length */
@@ -435,6 +437,8 @@ int net_loop(enum proto_t protocol)
 {
 	int ret = -EINVAL;
 	enum net_loop_state prev_net_state = net_state;
+	int busy_rounds;
+	bool poll;
 
 #if defined(CONFIG_CMD_PING)
 	if (protocol != PING)
@@ -635,28 +639,35 @@ restart:
 	 *	Main packet reception loop.  Loop receiving packets until
 	 *	someone sets `net_state' to a state that terminates.
 	 */
+	busy_rounds = 0;
+	poll = true;
 	for (;;) {
-		schedule();
-		if (arp_timeout_check() > 0)
-			time_start = get_timer(0);
-
-		if (IS_ENABLED(CONFIG_IPV6)) {
-			if (use_ip6 && (ndisc_timeout_check() > 0))
+		if (poll) {
+			schedule();
+			if (arp_timeout_check() > 0)
 				time_start = get_timer(0);
+
+			if (IS_ENABLED(CONFIG_IPV6)) {
+				if (use_ip6 && (ndisc_timeout_check() > 0))
+					time_start = get_timer(0);
+			}
 		}
 
 		/*
 		 *	Check the ethernet for a new packet.  The ethernet
 		 *	receive routine will process it.
-		 *	Most drivers return the most recent packet size, but not
-		 *	errors that may have happened.
+		 *	While packets keep coming, only look at the console
+		 *	and run the cyclic functions now and then.
 		 */
-		eth_rx();
+		poll = eth_rx() <= 0 ||
+			++busy_rounds >= CONFIG_NET_BUSY_POLL_ROUNDS;
+		if (poll)
+			busy_rounds = 0;
 
 		/*
 		 *	Abort if ctrl-c was pressed.
 		 */
-		if (ctrlc()) {
+		if (poll && ctrlc()) {
 			/* cancel any ARP that may not have completed */
 			net_arp_wait_packet_ip.s_addr = 0;
 
@@ -937,6 +948,8 @@ int net_send_ip_packet(uchar *ether, struct in_addr dest, int dport, int sport,
 	/* if broadcast, make the ether address a broadcast and don't do ARP */
 	if (dest.s_addr == 0xFFFFFFFF)
 		ether = (uchar *)net_bcast_ethaddr;
+	else if (memcmp(ether, net_null_ethaddr, 6) == 0)
+		arp_lookup(dest, ether);
 
 	pkt = (uchar *)net_tx_packet;
 
@@ -1006,15 +1019,62 @@ struct hole {
 	u16 unused;
 };
 
+/**
+ * struct defrag_ctx - a datagram being reassembled
+ *
+ * @pkt_buff: IP header of the first fragment received, then the payload
+ * @first_hole: index of the first hole in the payload
+ * @total_len: length of the payload once known, 0xffff before, 0 if the
+ *	context is free
+ * @last_used: value of defrag_clock when the last fragment arrived
+ */
+struct defrag_ctx {
+	uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
+	u16 first_hole;
+	u16 total_len;
+	ulong last_used;
+};
+
+static struct defrag_ctx defrag_ctxs[CONFIG_NET_DEFRAG_CONTEXTS];
+static ulong defrag_clock;
+
+/*
+ * Find the context for the datagram a fragment belongs to, by source
+ * address and IP ID. A new datagram takes a free context, or the one which
+ * has been waiting for longest.
+ */
+static struct defrag_ctx *defrag_find(struct ip_udp_hdr *ip, bool *newp)
+{
+	struct defrag_ctx *ctx, *victim = &defrag_ctxs[0];
+	struct ip_udp_hdr *localip;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(defrag_ctxs); i++) {
+		ctx = &defrag_ctxs[i];
+		localip = (struct ip_udp_hdr *)ctx->pkt_buff;
+		if (ctx->total_len && localip->ip_id == ip->ip_id &&
+		    !memcmp(&localip->ip_src, &ip->ip_src, sizeof(ip->ip_src))) {
+			*newp = false;
+			return ctx;
+		}
+		if (victim->total_len &&
+		    (!ctx->total_len || ctx->last_used < victim->last_used))
+			victim = ctx;
+	}
+	*newp = true;
+
+	return victim;
+}
+
 static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 {
-	static uchar pkt_buff[IP_PKTSIZE] __aligned(PKTALIGN);
-	static u16 first_hole, total_len;
+	struct defrag_ctx *ctx;
 	struct hole *payload, *thisfrag, *h, *newh;
-	struct ip_udp_hdr *localip = (struct ip_udp_hdr *)pkt_buff;
+	struct ip_udp_hdr *localip;
 	uchar *indata = (uchar *)ip;
 	int offset8, start, len, done = 0;
 	u16 ip_off = ntohs(ip->ip_off);
+	bool new;
 
 	/*
 	 * Calling code already rejected <, but we don't have to deal
@@ -1024,7 +1084,9 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 		return NULL;
 
 	/* payload starts after IP header, this fragment is in there */
-	payload = (struct hole *)(pkt_buff + IP_HDR_SIZE);
+	ctx = defrag_find(ip, &new);
+	localip = (struct ip_udp_hdr *)ctx->pkt_buff;
+	payload = (struct hole *)(ctx->pkt_buff + IP_HDR_SIZE);
 	offset8 =  (ip_off & IP_OFFS);
 	thisfrag = payload + offset8;
 	start = offset8 * 8;
@@ -1037,16 +1099,17 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (start + len > IP_MAXUDP) /* fragment extends too far */
 		return NULL;
 
-	if (!total_len || localip->ip_id != ip->ip_id) {
-		/* new (or different) packet, reset structs */
-		total_len = 0xffff;
+	if (new) {
+		/* new packet, reset structs */
+		ctx->total_len = 0xffff;
 		payload[0].last_byte = ~0;
 		payload[0].next_hole = 0;
 		payload[0].prev_hole = 0;
-		first_hole = 0;
+		ctx->first_hole = 0;
 		/* any IP header will work, copy the first we received */
 		memcpy(localip, ip, IP_HDR_SIZE);
 	}
+	ctx->last_used = ++defrag_clock;
 
 	/*
 	 * What follows is the reassembly algorithm. We use the payload
@@ -1055,7 +1118,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	 * so it is represented as byte count, not as 8-byte blocks.
 	 */
 
-	h = payload + first_hole;
+	h = payload + ctx->first_hole;
 	while (h->last_byte < start) {
 		if (!h->next_hole) {
 			/* no hole that far away */
@@ -1072,7 +1135,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 
 	if (!(ip_off & IP_FLAGS_MFRAG)) {
 		/* no more fragmentss: truncate this (last) hole */
-		total_len = start + len;
+		ctx->total_len = start + len;
 		h->last_byte = start + len;
 	}
 
@@ -1093,7 +1156,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 			done = 1;
 		} else if (!h->prev_hole) {
 			/* first hole */
-			first_hole = h->next_hole;
+			ctx->first_hole = h->next_hole;
 			payload[h->next_hole].prev_hole = 0;
 		} else if (!h->next_hole) {
 			/* last hole */
@@ -1118,7 +1181,7 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 		if (h->prev_hole)
 			payload[h->prev_hole].next_hole = (h - payload);
 		else
-			first_hole = (h - payload);
+			ctx->first_hole = (h - payload);
 
 	} else {
 		/* fragment sits in the middle: split the hole */
@@ -1136,8 +1199,10 @@ static struct ip_udp_hdr *__net_defragment(struct ip_udp_hdr *ip, int *lenp)
 	if (!done)
 		return NULL;
 
-	*lenp = total_len + IP_HDR_SIZE;
+	*lenp = ctx->total_len + IP_HDR_SIZE;
 	localip->ip_len = htons(*lenp);
+	/* the buffer stays untouched until the next fragment arrives */
+	ctx->total_len = 0;
 	return localip;
 }
 
@@ -1344,19 +1409,25 @@ void net_process_received_packet(uchar *in_packet, int len)
 		/* Can't deal with IP options (headers != 20 bytes) */
 		if ((ip->ip_hl_v & 0x0f) != 0x05)
 			return;
-		/* Check the Checksum of the header */
-		if (!ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
+		/* Check the Checksum of the header, unless the MAC did */
+		if (!net_rx_csum_ok && !ip_checksum_ok((uchar *)ip, IP_HDR_SIZE)) {
 			debug("checksum bad\n");
+			eth_count_rx_csum_error();
 			return;
 		}
 		/* If it is not for us, ignore it */
 		dst_ip = net_read_ip(&ip->ip_dst);
 		if (net_ip.s_addr && dst_ip.s_addr != net_ip.s_addr &&
-		    dst_ip.s_addr != 0xFFFFFFFF) {
+		    dst_ip.s_addr != 0xFFFFFFFF &&
+		    (!net_mcast_addr.s_addr ||
+		     dst_ip.s_addr != net_mcast_addr.s_addr)) {
 				return;
 		}
 		/* Read source IP address for later use */
 		src_ip = net_read_ip(&ip->ip_src);
+		/* The MAC cannot have checked the payload of a fragment */
+		if (ntohs(ip->ip_off) & (IP_OFFS | IP_FLAGS_MFRAG))
+			net_rx_csum_ok = false;
 		/*
 		 * The function returns the unchanged packet if it's not
 		 * a fragment, and either the complete packet or NULL if
@@ -1409,7 +1480,8 @@ void net_process_received_packet(uchar *in_packet, int len)
 			   "received UDP (to=%pI4, from=%pI4, len=%d)\n",
 			   &dst_ip, &src_ip, len);
 
-		if (IS_ENABLED(CONFIG_UDP_CHECKSUM) && ip->udp_xsum != 0) {
+		if (IS_ENABLED(CONFIG_UDP_CHECKSUM) && ip->udp_xsum != 0 &&
+		    !net_rx_csum_ok) {
 			ulong   xsum;
 			u8 *sumptr;
 			ushort  sumlen;
@@ -1439,6 +1511,7 @@ void net_process_received_packet(uchar *in_packet, int len)
 			if ((xsum != 0x00000000) && (xsum != 0x0000ffff)) {
 				printf(" UDP wrong checksum %08lx %08x\n",
 				       xsum, ntohs(ip->udp_xsum));
+				eth_count_rx_csum_error();
 				return;
 			}
 		}
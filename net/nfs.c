@@ -45,17 +45,47 @@
 #include <time.h>
 
 #define HASHES_PER_LINE 65	/* Number of "loading" hashes per line	*/
+#define HASH_BYTES	(NFS_READ_SIZE / 2 * 10)	/* Bytes per hash */
 #define NFS_RETRY_COUNT 30
+/* NFSv2 cannot read more than this at a time */
+#define NFS2_MAXDATA	8192
+/* IP, UDP, RPC and NFS headers in front of the data of a READ reply */
+#define NFS_READ_OVERHEAD	(IP_UDP_HDR_SIZE + \
+				 (6 + NFS_MAX_ATTRS) * sizeof(uint32_t))
 
 #define NFS_RPC_ERR	1
 #define NFS_RPC_DROP	124
 
 static int fs_mounted;
 static unsigned long rpc_id;
-static int nfs_offset = -1;
-static int nfs_len;
 static const ulong nfs_timeout = CONFIG_NFS_TIMEOUT;
 
+/**
+ * struct nfs_read_slot - a READ request waiting for its reply
+ *
+ * @xid: RPC transaction ID of the request
+ * @offset: offset of the first byte asked for
+ * @len: number of bytes asked for, 0 if the slot is free
+ */
+struct nfs_read_slot {
+	ulong xid;
+	u32 offset;
+	u32 len;
+};
+
+/*
+ * Up to CONFIG_NFS_READ_WINDOW READ requests are in flight at once. The next
+ * one starts at nfs_read_offset. Once a reply reports the end of the file,
+ * nfs_read_end is where it is.
+ */
+static struct nfs_read_slot nfs_read_slots[CONFIG_NFS_READ_WINDOW];
+static int nfs_read_size;
+static u32 nfs_read_offset;
+static u32 nfs_read_end;
+static bool nfs_read_eof;
+static ulong nfs_read_bytes;
+static ulong nfs_read_hash;
+
 static char dirfh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle of directory */
 static unsigned int dirfh3_length; /* (variable) length of dirfh when NFSv3 */
 static char filefh[NFS3_FHSIZE]; /* NFSv2 / NFSv3 file handle */
@@ -395,7 +425,7 @@ static void nfs_lookup_req(char *fname)
 /**************************************************************************
 NFS_READ - Read File on NFS Server
 **************************************************************************/
-static void nfs_read_req(int offset, int readlen)
+static void nfs_read_req(u32 offset, u32 readlen)
 {
 	uint32_t data[1024];
 	uint32_t *p;
@@ -425,6 +455,120 @@ static void nfs_read_req(int offset, int readlen)
 	rpc_req(PROG_NFS, NFS_READ, data, len);
 }
 
+static void nfs_read_slot_req(struct nfs_read_slot *slot)
+{
+	nfs_read_req(slot->offset, slot->len);
+	slot->xid = rpc_id;
+}
+
+/* Send READ requests for the rest of the file until the window is full */
+static void nfs_read_fill(void)
+{
+	struct nfs_read_slot *slot;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nfs_read_slots) && !nfs_read_eof; i++) {
+		slot = &nfs_read_slots[i];
+		if (slot->len)
+			continue;
+		slot->offset = nfs_read_offset;
+		slot->len = nfs_read_size;
+		nfs_read_offset += nfs_read_size;
+		nfs_read_slot_req(slot);
+	}
+}
+
+/* Send the READ requests still waiting for a reply again */
+static void nfs_read_resend(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(nfs_read_slots); i++)
+		if (nfs_read_slots[i].len)
+			nfs_read_slot_req(&nfs_read_slots[i]);
+}
+
+/**
+ * nfs_read_start() - start reading the file
+ *
+ * The read size is CONFIG_NFS_READ_SIZE, limited by what NFSv2 allows and by
+ * the largest datagram which can be reassembled. Without CONFIG_IP_DEFRAG a
+ * reply must fit in a single Ethernet frame.
+ */
+static void nfs_read_start(void)
+{
+	int size = CONFIG_NFS_READ_SIZE;
+	int max_defrag;
+
+	max_defrag = config_opt_enabled(CONFIG_IP_DEFRAG, CONFIG_NET_MAXDEFRAG,
+					0);
+	if (choosen_nfs_version != NFS_V3)
+		size = min(size, NFS2_MAXDATA);
+	size = min(size, max_t(int, max_defrag - NFS_READ_OVERHEAD,
+			       NFS_READ_SIZE));
+	nfs_read_size = size - size % NFS_READ_SIZE;
+	debug("NFS read size %d\n", nfs_read_size);
+
+	memset(nfs_read_slots, '\0', sizeof(nfs_read_slots));
+	nfs_read_offset = 0;
+	nfs_read_end = 0;
+	nfs_read_eof = false;
+	nfs_read_bytes = 0;
+	nfs_read_hash = 0;
+	nfs_read_fill();
+}
+
+/**
+ * nfs_read_update() - account for a READ reply and send the next requests
+ *
+ * A server may return less than asked for, in which case the rest is asked
+ * for again.
+ *
+ * @slot: request the reply is for
+ * @rlen: number of bytes received
+ * @eof: true if the reply says the end of the file has been reached
+ * Return: true once the whole file has been received
+ */
+static bool nfs_read_update(struct nfs_read_slot *slot, int rlen, bool eof)
+{
+	int i;
+
+	nfs_read_bytes += rlen;
+	while (nfs_read_bytes > nfs_read_hash) {
+		if (nfs_read_hash &&
+		    !(nfs_read_hash % (HASH_BYTES * HASHES_PER_LINE)))
+			puts("\n\t ");
+		putc('#');
+		nfs_read_hash += HASH_BYTES;
+	}
+
+	if (eof || !rlen) {
+		if (!nfs_read_eof || slot->offset + rlen < nfs_read_end)
+			nfs_read_end = slot->offset + rlen;
+		nfs_read_eof = true;
+	} else if (rlen < slot->len) {
+		slot->offset += rlen;
+		slot->len -= rlen;
+		nfs_read_slot_req(slot);
+		return false;
+	}
+	slot->len = 0;
+
+	/* Nothing is needed from beyond the end of the file */
+	for (i = 0; i < ARRAY_SIZE(nfs_read_slots); i++) {
+		slot = &nfs_read_slots[i];
+		if (nfs_read_eof && slot->offset >= nfs_read_end)
+			slot->len = 0;
+	}
+	nfs_read_fill();
+
+	for (i = 0; i < ARRAY_SIZE(nfs_read_slots); i++)
+		if (nfs_read_slots[i].len)
+			return false;
+
+	return nfs_read_eof;
+}
+
 /**************************************************************************
 RPC request dispatcher
 **************************************************************************/
@@ -455,7 +599,7 @@ static void nfs_send(void)
 		nfs_lookup_req(nfs_filename);
 		break;
 	case STATE_READ_REQ:
-		nfs_read_req(nfs_offset, nfs_len);
+		nfs_read_resend();
 		break;
 	case STATE_READLINK_REQ:
 		nfs_readlink_req();
@@ -711,20 +855,38 @@ static int nfs_readlink_reply(uchar *pkt, unsigned len)
 	return 0;
 }
 
-static int nfs_read_reply(uchar *pkt, unsigned len)
+/**
+ * nfs_read_reply() - handle the reply to a READ request
+ *
+ * @pkt: reply
+ * @len: length of the reply
+ * @slotp: returns the request this is the reply to
+ * @eof: returns true if the end of the file has been reached
+ * Return: number of bytes received, -NFS_RPC_DROP if this is not the reply to
+ *	a request in flight, other -ve on error
+ */
+static int nfs_read_reply(uchar *pkt, unsigned len,
+			  struct nfs_read_slot **slotp, bool *eof)
 {
 	struct rpc_t rpc_pkt;
-	int rlen;
+	struct nfs_read_slot *slot = NULL;
+	int rlen, i;
 	uchar *data_ptr;
 
 	debug("%s\n", __func__);
 
-	memcpy(&rpc_pkt.u.data[0], pkt, sizeof(rpc_pkt.u.reply));
+	/* Only the headers are copied, the data goes straight to memory */
+	memcpy(&rpc_pkt.u.data[0], pkt, min_t(size_t, len,
+					       sizeof(rpc_pkt.u.reply)));
 
-	if (ntohl(rpc_pkt.u.reply.id) > rpc_id)
-		return -NFS_RPC_ERR;
-	else if (ntohl(rpc_pkt.u.reply.id) < rpc_id)
+	for (i = 0; i < ARRAY_SIZE(nfs_read_slots); i++) {
+		if (nfs_read_slots[i].len &&
+		    nfs_read_slots[i].xid == ntohl(rpc_pkt.u.reply.id))
+			slot = &nfs_read_slots[i];
+	}
+	if (!slot)
 		return -NFS_RPC_DROP;
+	*slotp = slot;
 
 	if (rpc_pkt.u.reply.rstatus  ||
 	    rpc_pkt.u.reply.verifier ||
@@ -737,34 +899,32 @@ static int nfs_read_reply(uchar *pkt, unsigned len)
 		return -ntohl(rpc_pkt.u.reply.data[0]);
 	}
 
-	if ((nfs_offset != 0) && !((nfs_offset) %
-			(NFS_READ_SIZE / 2 * 10 * HASHES_PER_LINE)))
-		puts("\n\t ");
-	if (!(nfs_offset % ((NFS_READ_SIZE / 2) * 10)))
-		putc('#');
-
 	if (choosen_nfs_version != NFS_V3) {
 		rlen = ntohl(rpc_pkt.u.reply.data[18]);
 		data_ptr = (uchar *)&(rpc_pkt.u.reply.data[19]);
+		/* A short read is the end of the file */
+		*eof = rlen < slot->len;
 	} else {  /* NFS_V3 */
 		int nfsv3_data_offset =
 			nfs3_get_attributes_offset(rpc_pkt.u.reply.data);
 
 		/* count value */
 		rlen = ntohl(rpc_pkt.u.reply.data[1 + nfsv3_data_offset]);
-		/* Skip unused values :
-			EOF:		32 bits value,
+		*eof = ntohl(rpc_pkt.u.reply.data[2 + nfsv3_data_offset]);
+		/* Skip unused value :
 			data_size:	32 bits value,
 		*/
 		data_ptr = (uchar *)
 			&(rpc_pkt.u.reply.data[4 + nfsv3_data_offset]);
 	}
 
-	if (((uchar *)&(rpc_pkt.u.reply.data[0]) - (uchar *)(&rpc_pkt) + rlen) > len)
-			return -9999;
+	if (rlen < 0 || rlen > slot->len ||
+	    data_ptr - (uchar *)&rpc_pkt + rlen > len)
+		return -9999;
 
-	if (store_block(data_ptr, nfs_offset, rlen))
-			return -9999;
+	if (store_block(pkt + (data_ptr - (uchar *)&rpc_pkt), slot->offset,
+			rlen))
+		return -9999;
 
 	return rlen;
 }
@@ -789,12 +949,15 @@ static void nfs_timeout_handler(void)
 static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			unsigned src, unsigned len)
 {
+	struct nfs_read_slot *slot;
+	bool eof;
 	int rlen;
 	int reply;
 
 	debug("%s\n", __func__);
 
-	if (len > sizeof(struct rpc_t))
+	/* READ replies are stored without being copied, so may be larger */
+	if (len > sizeof(struct rpc_t) && nfs_state != STATE_READ_REQ)
 		return;
 
 	if (dest != nfs_our_port)
@@ -865,9 +1028,7 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			nfs_send();
 		} else {
 			nfs_state = STATE_READ_REQ;
-			nfs_offset = 0;
-			nfs_len = NFS_READ_SIZE;
-			nfs_send();
+			nfs_read_start();
 		}
 		break;
 
@@ -890,22 +1051,22 @@ static void nfs_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 		break;
 
 	case STATE_READ_REQ:
-		rlen = nfs_read_reply(pkt, len);
+		rlen = nfs_read_reply(pkt, len, &slot, &eof);
 		if (rlen == -NFS_RPC_DROP)
 			break;
 		net_set_timeout_handler(nfs_timeout, nfs_timeout_handler);
-		if (rlen > 0) {
-			nfs_offset += rlen;
+		if (rlen >= 0) {
+			if (!nfs_read_update(slot, rlen, eof))
+				break;
+			nfs_download_state = NETLOOP_SUCCESS;
+			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		} else if ((rlen == -NFSERR_ISDIR) || (rlen == -NFSERR_INVAL)) {
 			/* symbolic link */
 			nfs_state = STATE_READLINK_REQ;
 			nfs_send();
 		} else {
-			if (!rlen)
-				nfs_download_state = NETLOOP_SUCCESS;
-			if (rlen < 0)
-				debug("NFS READ error (%d)\n", rlen);
+			debug("NFS READ error (%d)\n", rlen);
 			nfs_state = STATE_UMOUNT_REQ;
 			nfs_send();
 		}
@@ -39,19 +39,35 @@ static u32 tcp_ack_edge;
 static int tcp_activity_count;
 
 /*
- * Search for TCP_SACK and review the comments before the code section
- * TCP_SACK is the number of packets at the front of the stream
+ * Data received beyond tcp_ack_edge, in sequence order. The application
+ * stores each segment in place as it arrives, so only the edges of these
+ * hills are kept, to be reported in SACK options and to move tcp_ack_edge on
+ * when the holes between them are filled.
  */
-
-enum pkt_state {PKT, NOPKT};
-struct sack_r {
-	struct sack_edges se;
-	enum pkt_state st;
-};
-
-static struct sack_r edge_a[TCP_SACK];
-static unsigned int sack_idx;
-static unsigned int prev_len;
+static struct sack_edges tcp_hills[TCP_SACK];
+static unsigned int tcp_num_hills;
+/* Hill holding the last segment received, which SACK reports first */
+static int tcp_last_hill;
+
+/* Window scale shift agreed with the server, 0 if none */
+static u8 tcp_rcv_scale;
+/* Window scale option seen in the packet being processed */
+static bool tcp_opt_scale;
+/* SACK-permitted option seen in the packet being processed */
+static bool tcp_opt_sack;
+
+/* Largest segment received so far */
+static unsigned int tcp_max_seg;
+/* The ACK for the segment just received may be delayed */
+static bool tcp_delay_ack;
+/* A segment has been received and not acknowledged yet */
+static bool tcp_ack_owed;
+
+/* Whether sequence number @a comes before @b, allowing for wrap-around */
+static inline bool tcp_seq_before(u32 a, u32 b)
+{
+	return (s32)(a - b) < 0;
+}
 
 /*
  * TCP lengths are stored as a rounded up number of 32 bit words.
@@ -79,6 +95,16 @@ enum tcp_state tcp_get_tcp_state(void)
 	return current_tcp_state;
 }
 
+/**
+ * tcp_get_ack_edge() - get the sequence number of the next byte expected
+ *
+ * Return: Sequence number up to which the stream has been received
+ */
+u32 tcp_get_ack_edge(void)
+{
+	return tcp_ack_edge;
+}
+
 /**
  * tcp_set_tcp_state() - set current TCP state
  * @new_state: new TCP state
@@ -236,6 +262,31 @@ void net_set_syn_options(union tcp_build_pkt *b)
 	b->ip.end = TCP_O_END;
 }
 
+/**
+ * tcp_set_synack_options() - set TCP options when answering a SYN
+ * @b: the packet
+ *
+ * These are the options of our own SYN, except that window scaling and SACK
+ * are only offered if the SYN did, and the SYN's timestamp is echoed.
+ */
+static void tcp_set_synack_options(union tcp_build_pkt *b)
+{
+	u32 rcv = rmt_timestamp;
+
+	net_set_syn_options(b);
+	rmt_timestamp = rcv;
+	b->ip.t_opt.t_rcv = rcv;
+	if (!tcp_rcv_scale) {
+		b->ip.scale.kind = TCP_1_NOP;
+		b->ip.scale.len = TCP_1_NOP;
+		b->ip.scale.scale = TCP_1_NOP;
+	}
+	if (!tcp_opt_sack) {
+		b->ip.sack_p.kind = TCP_1_NOP;
+		b->ip.sack_p.len = TCP_1_NOP;
+	}
+}
+
 int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 		       u8 action, u32 tcp_seq_num, u32 tcp_ack_num)
 {
@@ -259,6 +310,7 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 			   &net_server_ip, &net_ip,
 			   tcp_seq_num, tcp_ack_num);
 		tcp_activity_count = 0;
+		tcp_rcv_scale = 0;
 		net_set_syn_options(b);
 		tcp_seq_num = 0;
 		tcp_ack_num = 0;
@@ -271,6 +323,13 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 		}
 		break;
 	case TCP_SYN | TCP_ACK:
+		debug_cond(DEBUG_DEV_PKT,
+			   "TCP Hdr:SYN ACK (%pI4, %pI4, s=%u, a=%u)\n",
+			   &net_server_ip, &net_ip, tcp_seq_num, tcp_ack_num);
+		tcp_activity_count = 0;
+		tcp_set_synack_options(b);
+		pkt_hdr_len = IP_TCP_O_SIZE;
+		break;
 	case TCP_ACK:
 		pkt_hdr_len = IP_HDR_SIZE + net_set_ack_options(b);
 		b->ip.hdr.tcp_flags = action;
@@ -317,7 +376,14 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	pkt_len	= pkt_hdr_len + payload_len;
 	tcp_len	= pkt_len - IP_HDR_SIZE;
 
-	tcp_ack_edge = tcp_ack_num;
+	/*
+	 * While data is flowing, acknowledge it up to the first hole, which
+	 * is tracked here rather than by the application
+	 */
+	if (current_tcp_state != TCP_ESTABLISHED)
+		tcp_ack_edge = tcp_ack_num;
+	if (b->ip.hdr.tcp_flags & TCP_ACK)
+		tcp_ack_owed = false;
 	/* TCP Header */
 	b->ip.hdr.tcp_ack = htonl(tcp_ack_edge);
 	b->ip.hdr.tcp_src = htons(sport);
@@ -338,14 +404,25 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	 * SOCs is may not be considered a constraint to buffer space, if
 	 * it is, then the u-boot tftp or nfs kernel netboot should be
 	 * considered.
+	 *
+	 * The application places the data in its final location as it
+	 * arrives, in order or not, so the window is not limited by the
+	 * number of packet buffers. The window field of SYN segments is never
+	 * scaled (RFC 7323).
 	 */
-	b->ip.hdr.tcp_win = htons(PKTBUFSRX * TCP_MSS >> TCP_SCALE);
+	if (tcp_rcv_scale && !(action & TCP_SYN))
+		b->ip.hdr.tcp_win = htons(TCP_RX_WINDOW >> tcp_rcv_scale);
+	else
+		b->ip.hdr.tcp_win = htons(min(TCP_RX_WINDOW, 0xffff));
 
 	b->ip.hdr.tcp_xsum = 0;
 	b->ip.hdr.tcp_ugr = 0;
 
-	b->ip.hdr.tcp_xsum = tcp_set_pseudo_header(pkt, net_ip, net_server_ip,
-						   tcp_len, pkt_len);
+	/* A MAC with checksum offload fills this in as it sends the packet */
+	if (!eth_tx_csum_offload())
+		b->ip.hdr.tcp_xsum = tcp_set_pseudo_header(pkt, net_ip,
+							   net_server_ip,
+							   tcp_len, pkt_len);
 
 	net_set_ip_header((uchar *)&b->ip, net_server_ip, net_ip,
 			  pkt_len, IPPROTO_TCP);
@@ -353,112 +430,112 @@ int tcp_set_tcp_header(uchar *pkt, int dport, int sport, int payload_len,
 	return pkt_hdr_len;
 }
 
+/**
+ * tcp_update_sack() - Set up the SACK option from the hills received
+ *
+ * The hill holding the last segment received comes first, as RFC 2018 asks,
+ * followed by the others in sequence order.
+ */
+static void tcp_update_sack(void)
+{
+	unsigned int i, hill = 0;
+
+	if (!IS_ENABLED(CONFIG_PROT_TCP_SACK))
+		return;
+
+	if (tcp_last_hill >= 0)
+		tcp_lost.hill[hill++] = tcp_hills[tcp_last_hill];
+	for (i = 0; i < tcp_num_hills && hill < TCP_SACK_HILLS - 1; i++) {
+		if (i != tcp_last_hill)
+			tcp_lost.hill[hill++] = tcp_hills[i];
+	}
+	tcp_lost.len = hill ? TCP_OPT_LEN_2 + hill * TCP_OPT_LEN_8 : 0;
+}
+
 /**
  * tcp_hole() - Selective Acknowledgment (Essential for fast stream transfer)
  * @tcp_seq_num: TCP sequence start number
  * @len: the length of sequence numbers
+ *
+ * Record the data received, moving tcp_ack_edge on if it is next in the
+ * stream, else adding it to the hills received out of order.
+ *
+ * Return: 0 if the data is new or a duplicate, -ENOSPC if it is out of order
+ * and cannot be recorded, so must be dropped
  */
-void tcp_hole(u32 tcp_seq_num, u32 len)
+int tcp_hole(u32 tcp_seq_num, u32 len)
 {
-	u32 idx_sack, sack_in;
-	u32 sack_end = TCP_SACK - 1;
-	u32 hill = 0;
-	enum pkt_state expect = PKT;
-	u32 seq = tcp_seq_num - tcp_seq_init;
-	u32 hol_l = tcp_ack_edge - tcp_seq_init;
-	u32 hol_r = 0;
-
-	/* Place new seq number in correct place in receive array */
-	if (prev_len == 0)
-		prev_len = len;
-
-	idx_sack = sack_idx + ((tcp_seq_num - tcp_ack_edge) / prev_len);
-	if (idx_sack < TCP_SACK) {
-		edge_a[idx_sack].se.l = tcp_seq_num;
-		edge_a[idx_sack].se.r = tcp_seq_num + len;
-		edge_a[idx_sack].st = PKT;
+	u32 l = tcp_seq_num, r = tcp_seq_num + len;
+	unsigned int i;
+
+	debug_cond(DEBUG_DEV_PKT, "TCP hole seq %u, len %u, edge %u, hills %u\n",
+		   tcp_seq_num - tcp_seq_init, len, tcp_ack_edge - tcp_seq_init,
+		   tcp_num_hills);
+
+	if (len > tcp_max_seg)
+		tcp_max_seg = len;
+	tcp_last_hill = -1;
+
+	/* Nothing new */
+	if (!tcp_seq_before(tcp_ack_edge, r))
+		return 0;
+
+	if (!tcp_seq_before(tcp_ack_edge, l)) {
+		/* Next in the stream: swallow the hills it reaches */
+		tcp_ack_edge = r;
+		while (tcp_num_hills &&
+		       !tcp_seq_before(tcp_ack_edge, tcp_hills[0].l)) {
+			if (tcp_seq_before(tcp_ack_edge, tcp_hills[0].r))
+				tcp_ack_edge = tcp_hills[0].r;
+			tcp_num_hills--;
+			memmove(&tcp_hills[0], &tcp_hills[1],
+				tcp_num_hills * sizeof(*tcp_hills));
+		}
+		tcp_update_sack();
 
-		/*
-		 * The fin (last) packet is not the same length as data
-		 * packets, and if it's length is recorded and used for
-		 *  array index calculation, calculation breaks.
-		 */
-		if (prev_len < len)
-			prev_len = len;
+		return 0;
 	}
 
-	debug_cond(DEBUG_DEV_PKT,
-		   "TCP 1 seq %d, edg %d, len %d, sack_idx %d, sack_end %d\n",
-		    seq, hol_l, len, sack_idx, sack_end);
+	if (r - tcp_ack_edge > TCP_RX_WINDOW)
+		return -ENOSPC;
 
-	/* Right edge of contiguous stream, is the left edge of first hill */
-	hol_l = tcp_seq_num - tcp_seq_init;
-	hol_r = hol_l + len;
-
-	if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
-		tcp_lost.len = TCP_OPT_LEN_2;
-
-	debug_cond(DEBUG_DEV_PKT,
-		   "TCP 1 in %d, seq %d, pkt_l %d, pkt_r %d, sack_idx %d, sack_end %d\n",
-		   idx_sack, seq, hol_l, hol_r, sack_idx, sack_end);
-
-	for (sack_in = sack_idx; sack_in < sack_end && hill < TCP_SACK_HILLS;
-	     sack_in++)  {
-		switch (expect) {
-		case NOPKT:
-			switch (edge_a[sack_in].st) {
-			case NOPKT:
-				debug_cond(DEBUG_INT_STATE, "N");
-				break;
-			case PKT:
-				debug_cond(DEBUG_INT_STATE, "n");
-				if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
-					tcp_lost.hill[hill].l =
-						edge_a[sack_in].se.l;
-					tcp_lost.hill[hill].r =
-						edge_a[sack_in].se.r;
-				}
-				expect = PKT;
-				break;
-			}
-			break;
-		case PKT:
-			switch (edge_a[sack_in].st) {
-			case NOPKT:
-				debug_cond(DEBUG_INT_STATE, "p");
-				if (sack_in > sack_idx &&
-				    hill < TCP_SACK_HILLS) {
-					hill++;
-					if (IS_ENABLED(CONFIG_PROT_TCP_SACK))
-						tcp_lost.len += TCP_OPT_LEN_8;
-				}
-				expect = NOPKT;
-				break;
-			case PKT:
-				debug_cond(DEBUG_INT_STATE, "P");
-
-				if (tcp_ack_edge == edge_a[sack_in].se.l) {
-					tcp_ack_edge = edge_a[sack_in].se.r;
-					edge_a[sack_in].st = NOPKT;
-					sack_idx++;
-				} else {
-					if (IS_ENABLED(CONFIG_PROT_TCP_SACK) &&
-					    hill < TCP_SACK_HILLS)
-						tcp_lost.hill[hill].r =
-							edge_a[sack_in].se.r;
-				if (IS_ENABLED(CONFIG_PROT_TCP_SACK) &&
-				    sack_in == sack_end - 1)
-					tcp_lost.hill[hill].r =
-						edge_a[sack_in].se.r;
-				}
-				break;
-			}
+	/* Find the first hill which this data reaches or follows */
+	for (i = 0; i < tcp_num_hills; i++) {
+		if (!tcp_seq_before(tcp_hills[i].r, l))
 			break;
+	}
+	if (i == tcp_num_hills || tcp_seq_before(r, tcp_hills[i].l)) {
+		if (tcp_num_hills == TCP_SACK)
+			return -ENOSPC;
+		memmove(&tcp_hills[i + 1], &tcp_hills[i],
+			(tcp_num_hills - i) * sizeof(*tcp_hills));
+		tcp_hills[i].l = l;
+		tcp_hills[i].r = r;
+		tcp_num_hills++;
+	} else {
+		if (tcp_seq_before(l, tcp_hills[i].l))
+			tcp_hills[i].l = l;
+		if (tcp_seq_before(tcp_hills[i].r, r))
+			tcp_hills[i].r = r;
+		/* Join the hills which now touch */
+		while (i + 1 < tcp_num_hills &&
+		       !tcp_seq_before(tcp_hills[i].r, tcp_hills[i + 1].l)) {
+			if (tcp_seq_before(tcp_hills[i].r, tcp_hills[i + 1].r))
+				tcp_hills[i].r = tcp_hills[i + 1].r;
+			tcp_num_hills--;
+			memmove(&tcp_hills[i + 1], &tcp_hills[i + 2],
+				(tcp_num_hills - i - 1) * sizeof(*tcp_hills));
 		}
 	}
-	debug_cond(DEBUG_INT_STATE, "\n");
-	if (!IS_ENABLED(CONFIG_PROT_TCP_SACK) || tcp_lost.len <= TCP_OPT_LEN_2)
-		sack_idx = 0;
+	tcp_last_hill = i;
+	tcp_update_sack();
+
+	return 0;
+}
+
+bool tcp_ack_delayed(void)
+{
+	return tcp_delay_ack;
 }
 
 /**
@@ -476,30 +553,33 @@ void tcp_parse_options(uchar *o, int o_len)
 	 * All other options have length fields.
 	 */
 	for (p = o; p < (o + o_len); p = p + p[1]) {
-		if (!p[1])
+		/* Process optional NOPs */
+		while (p < (o + o_len) && p[0] == TCP_1_NOP)
+			p++;
+		if (p + 1 >= (o + o_len) || !p[1])
 			return; /* Finished processing options */
 
 		switch (p[0]) {
 		case TCP_O_END:
 			return;
-		case TCP_O_MSS:
-		case TCP_O_SCL:
 		case TCP_P_SACK:
+			tcp_opt_sack = true;
+			break;
+		case TCP_O_MSS:
 		case TCP_V_SACK:
 			break;
+		case TCP_O_SCL:
+			tcp_opt_scale = true;
+			break;
 		case TCP_O_TS:
 			tsopt = (struct tcp_t_opt *)p;
 			rmt_timestamp = tsopt->t_snd;
-			return;
+			break;
 		}
-
-		/* Process optional NOPs */
-		if (p[0] == TCP_O_NOP)
-			p++;
 	}
 }
 
-static u8 tcp_state_machine(u8 tcp_flags, u32 tcp_seq_num, int payload_len)
+static u8 tcp_state_machine(u8 tcp_flags, u32 tcp_seq_num, int *payload_len)
 {
 	u8 tcp_fin = tcp_flags & TCP_FIN;
 	u8 tcp_syn = tcp_flags & TCP_SYN;
@@ -507,7 +587,8 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 tcp_seq_num, int payload_len)
 	u8 tcp_push = tcp_flags & TCP_PUSH;
 	u8 tcp_ack = tcp_flags & TCP_ACK;
 	u8 action = TCP_DATA;
-	int i;
+	unsigned int prev_hills;
+	u32 prev_edge;
 
 	/*
 	 * tcp_flags are examined to determine TX action in a given state
@@ -532,6 +613,8 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 tcp_seq_num, int payload_len)
 		debug_cond(DEBUG_INT_STATE, "TCP CLOSED %x\n", tcp_flags);
 		if (tcp_syn) {
 			action = TCP_SYN | TCP_ACK;
+			/* Scale the window if the SYN offers to */
+			tcp_rcv_scale = tcp_opt_scale ? TCP_SCALE : 0;
 			tcp_seq_init = tcp_seq_num;
 			tcp_ack_edge = tcp_seq_num + 1;
 			current_tcp_state = TCP_SYN_RECEIVED;
@@ -548,15 +631,19 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 tcp_seq_num, int payload_len)
 			current_tcp_state = TCP_CLOSE_WAIT;
 		} else if (tcp_ack || (tcp_syn && tcp_ack)) {
 			action |= TCP_ACK;
+			/* The ACK of our SYN ACK carries no SYN to count */
 			tcp_seq_init = tcp_seq_num;
-			tcp_ack_edge = tcp_seq_num + 1;
-			sack_idx = 0;
-			edge_a[sack_idx].se.l = tcp_ack_edge;
-			edge_a[sack_idx].se.r = tcp_ack_edge;
-			prev_len = 0;
+			tcp_ack_edge = tcp_seq_num + (tcp_syn ? 1 : 0);
+			tcp_num_hills = 0;
+			tcp_last_hill = -1;
+			tcp_lost.len = 0;
+			tcp_max_seg = 0;
+			tcp_ack_owed = false;
+			/* Scaling is used only if both ends offer it */
+			if (tcp_syn && current_tcp_state == TCP_SYN_SENT &&
+			    tcp_opt_scale)
+				tcp_rcv_scale = TCP_SCALE;
 			current_tcp_state = TCP_ESTABLISHED;
-			for (i = 0; i < TCP_SACK; i++)
-				edge_a[i].st = NOPKT;
 
 			if (tcp_syn && tcp_ack)
 				action |= TCP_PUSH;
@@ -566,14 +653,23 @@ static u8 tcp_state_machine(u8 tcp_flags, u32 tcp_seq_num, int payload_len)
 		break;
 	case TCP_ESTABLISHED:
 		debug_cond(DEBUG_INT_STATE, "TCP_ESTABLISHED %x\n", tcp_flags);
-		if (payload_len > 0) {
-			tcp_hole(tcp_seq_num, payload_len);
+		tcp_delay_ack = false;
+		if (*payload_len > 0) {
+			prev_edge = tcp_ack_edge;
+			prev_hills = tcp_num_hills;
+			if (tcp_hole(tcp_seq_num, *payload_len)) {
+				*payload_len = 0;
+				return TCP_DATA;
+			}
+			tcp_delay_ack = !tcp_push && !tcp_fin && !tcp_ack_owed &&
+					prev_edge == tcp_seq_num &&
+					!prev_hills &&
+					*payload_len >= tcp_max_seg;
+			tcp_ack_owed = true;
 			tcp_fin = TCP_DATA;  /* cause standalone FIN */
 		}
 
-		if ((tcp_fin) &&
-		    (!IS_ENABLED(CONFIG_PROT_TCP_SACK) ||
-		     tcp_lost.len <= TCP_OPT_LEN_2)) {
+		if (tcp_fin && !tcp_num_hills) {
 			action = action | TCP_FIN | TCP_PUSH | TCP_ACK;
 			current_tcp_state = TCP_CLOSE_WAIT;
 		} else if (tcp_ack) {
@@ -647,6 +743,14 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 		   "TCP RX in RX Sum (to=%pI4, from=%pI4, len=%d)\n",
 		   &b->ip.hdr.ip_src, &b->ip.hdr.ip_dst, pkt_len);
 
+	/* A connection to a server comes from whoever sent the SYN */
+	if (current_tcp_state == TCP_CLOSED &&
+	    (b->ip.hdr.tcp_flags & (TCP_SYN | TCP_ACK)) == TCP_SYN &&
+	    net_read_ip(&b->ip.hdr.ip_src).s_addr != net_server_ip.s_addr) {
+		net_server_ip = net_read_ip(&b->ip.hdr.ip_src);
+		memset(net_server_ethaddr, 0, ARP_HLEN);
+	}
+
 	b->ip.hdr.ip_src = net_server_ip;
 	b->ip.hdr.ip_dst = net_ip;
 	b->ip.hdr.ip_sum = 0;
@@ -657,10 +761,11 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 		return;
 	}
 
-	/* Build pseudo header and verify TCP header */
+	/* Build pseudo header and verify TCP header, unless the MAC did */
 	tcp_rx_xsum = b->ip.hdr.tcp_xsum;
 	b->ip.hdr.tcp_xsum = 0;
-	if (tcp_rx_xsum != tcp_set_pseudo_header((uchar *)b, b->ip.hdr.ip_src,
+	if (!net_rx_csum_ok &&
+	    tcp_rx_xsum != tcp_set_pseudo_header((uchar *)b, b->ip.hdr.ip_src,
 						 b->ip.hdr.ip_dst, tcp_len,
 						 pkt_len)) {
 		debug_cond(DEBUG_DEV_PKT,
@@ -672,6 +777,8 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 	tcp_hdr_len = GET_TCP_HDR_LEN_IN_BYTES(b->ip.hdr.tcp_hlen);
 	payload_len = tcp_len - tcp_hdr_len;
 
+	tcp_opt_scale = false;
+	tcp_opt_sack = false;
 	if (tcp_hdr_len > TCP_HDR_SIZE)
 		tcp_parse_options((uchar *)b + IP_TCP_HDR_SIZE,
 				  tcp_hdr_len - TCP_HDR_SIZE);
@@ -684,7 +791,7 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 
 	/* Packets are not ordered. Send to app as received. */
 	tcp_action = tcp_state_machine(b->ip.hdr.tcp_flags,
-				       tcp_seq_num, payload_len);
+				       tcp_seq_num, &payload_len);
 
 	tcp_activity_count++;
 	if (tcp_activity_count > TCP_ACTIVITY) {
@@ -692,7 +799,9 @@ void rxhand_tcp_f(union tcp_build_pkt *b, unsigned int pkt_len)
 		tcp_activity_count = 0;
 	}
 
-	if ((tcp_action & TCP_PUSH) || payload_len > 0) {
+	/* The application is told about a reset, which is never answered */
+	if ((tcp_action & TCP_PUSH) || payload_len > 0 ||
+	    tcp_action == TCP_RST) {
 		debug_cond(DEBUG_DEV_PKT,
 			   "TCP Notify (action=%x, Seq=%u,Ack=%u,Pay%d)\n",
 			   tcp_action, tcp_seq_num, tcp_ack_num, payload_len);
@@ -7,12 +7,14 @@
  */
 #include <command.h>
 #include <display_options.h>
+#include <div64.h>
 #include <efi_loader.h>
 #include <env.h>
 #include <image.h>
 #include <led.h>
 #include <lmb.h>
 #include <log.h>
+#include <malloc.h>
 #include <mapmem.h>
 #include <net.h>
 #include <net6.h>
@@ -83,6 +85,10 @@ static ulong	tftp_block_wrap;
 static ulong	tftp_block_wrap_offset;
 static int	tftp_state;
 static ulong	tftp_load_addr;
+/* tftp_load_addr mapped into our address space */
+static uchar	*tftp_load_buf;
+/* bytes from tftp_load_addr already reserved in the LMB */
+static ulong	tftp_load_reserved;
 #ifdef CONFIG_TFTP_TSIZE
 /* The file size reported by the server */
 static int	tftp_tsize;
@@ -115,7 +121,17 @@ static int	tftp_put_final_block_sent;
 
 /* default TFTP block size */
 #define TFTP_BLOCK_SIZE		512
-#define TFTP_MTU_BLOCKSIZE6 (CONFIG_TFTP_BLOCKSIZE - 20)
+/* Block size to ask for, which SPL can set separately */
+#ifdef CONFIG_XPL_BUILD
+#define TFTP_BLOCKSIZE		CONFIG_SPL_TFTP_BLOCKSIZE
+#else
+#define TFTP_BLOCKSIZE		CONFIG_TFTP_BLOCKSIZE
+#endif
+#define TFTP_MTU_BLOCKSIZE6 (TFTP_BLOCKSIZE - 20)
+/* Largest block which fits in an Ethernet frame */
+#define TFTP_MTU_BLOCKSIZE4	1468
+/* RFC2348 sets a hard upper limit */
+#define TFTP_MAX_BLOCKSIZE	65464
 /* sequence number is 16 bit */
 #define TFTP_SEQUENCE_SIZE	((ulong)(1<<16))
 
@@ -140,36 +156,102 @@ static char tftp_filename[MAX_LEN];
  * tftp behaves the same way as it was
  * never declared
  */
-#ifdef CONFIG_TFTP_WINDOWSIZE
+#if defined(CONFIG_XPL_BUILD) && defined(CONFIG_SPL_TFTP_WINDOWSIZE)
+#define TFTP_WINDOWSIZE CONFIG_SPL_TFTP_WINDOWSIZE
+#elif defined(CONFIG_TFTP_WINDOWSIZE)
 #define TFTP_WINDOWSIZE CONFIG_TFTP_WINDOWSIZE
 #else
 #define TFTP_WINDOWSIZE 1
 #endif
 
+#ifdef CONFIG_TFTP_WINDOWSIZE_MAX
+#define TFTP_WINDOWSIZE_MAX CONFIG_TFTP_WINDOWSIZE_MAX
+#else
+#define TFTP_WINDOWSIZE_MAX TFTP_WINDOWSIZE
+#endif
+
 static unsigned short tftp_block_size = TFTP_BLOCK_SIZE;
-static unsigned short tftp_block_size_option = CONFIG_TFTP_BLOCKSIZE;
+static unsigned short tftp_block_size_option = TFTP_BLOCKSIZE;
 static unsigned short tftp_window_size_option = TFTP_WINDOWSIZE;
+static int saved_tftp_block_size_option;
+
+/*
+ * With CONFIG_TFTP_WINDOWSIZE_ADAPTIVE, the window size and block size to
+ * ask for in the next download: 0 if not decided yet. tftp_adapting is set
+ * while the current download uses them and tftp_lost counts the blocks it had
+ * to ask for again.
+ */
+static unsigned short tftp_adapt_window;
+static unsigned short tftp_adapt_block_size;
+static bool tftp_adapting;
+static int tftp_lost;
+
+#ifdef CONFIG_TFTP_MULTICAST_BITMAP_SIZE
+#define TFTP_MCAST_BITMAP_SIZE	CONFIG_TFTP_MULTICAST_BITMAP_SIZE
+#else
+#define TFTP_MCAST_BITMAP_SIZE	0
+#endif
+/* Furthest a multicast block can be from the last one and still be placed */
+#define TFTP_MCAST_SPAN		0x4000
+
+/*
+ * With CONFIG_TFTP_MULTICAST, the state of an RFC2090 multicast download.
+ * Block numbers here count from the start of the file and do not wrap:
+ * tftp_mcast_pos is the last block received or asked for, tftp_mcast_next
+ * the first one missing and tftp_mcast_last the final one, 0 until it is seen.
+ */
+static bool tftp_mcast_ask;	/* ask the server for a multicast transfer */
+static bool tftp_mcast_disabled;	/* download again with unicast */
+static bool tftp_mcast_active;
+static bool tftp_mcast_master;
+static int tftp_mcast_port;
+static int tftp_server_port;
+static ulong tftp_mcast_pos;
+static ulong tftp_mcast_next;
+static ulong tftp_mcast_last;
+static u8 *tftp_mcast_bitmap;
+
+/*
+ * Reserve the LMB region up to @end bytes from the load address. When the
+ * server told us the file size, the whole file is reserved at once rather
+ * than block by block.
+ */
+static int tftp_reserve(ulong end)
+{
+	ulong start = tftp_load_addr + tftp_load_reserved;
+	ulong size = end;
+
+#ifdef CONFIG_TFTP_TSIZE
+	size = max_t(ulong, size, tftp_tsize);
+#endif
+	if (size > end &&
+	    !lmb_read_check(start, size - tftp_load_reserved)) {
+		tftp_load_reserved = size;
+		return 0;
+	}
+	if (lmb_read_check(start, end - tftp_load_reserved))
+		return -1;
+	tftp_load_reserved = end;
+
+	return 0;
+}
 
-static inline int store_block(int block, uchar *src, unsigned int len)
+static inline int store_block(ulong block, uchar *src, unsigned int len)
 {
 	ulong offset = block * tftp_block_size + tftp_block_wrap_offset -
 			tftp_block_size;
 	ulong newsize = offset + len;
 	ulong store_addr = tftp_load_addr + offset;
-	void *ptr;
 
-	if (CONFIG_IS_ENABLED(LMB)) {
-		if (store_addr < tftp_load_addr ||
-		    lmb_read_check(store_addr, len)) {
+	if (CONFIG_IS_ENABLED(LMB) && newsize > tftp_load_reserved) {
+		if (store_addr < tftp_load_addr || tftp_reserve(newsize)) {
 			puts("\nTFTP error: ");
 			puts("trying to overwrite reserved memory...\n");
 			return -1;
 		}
 	}
 
-	ptr = map_sysmem(store_addr, len);
-	memcpy(ptr, src, len);
-	unmap_sysmem(ptr);
+	memcpy(tftp_load_buf + offset, src, len);
 
 	if (net_boot_file_size < newsize)
 		net_boot_file_size = newsize;
@@ -215,6 +297,174 @@ static int load_block(unsigned block, uchar *dst, unsigned len)
 
 static void tftp_send(void);
 static void tftp_timeout_handler(void);
+static void show_block_marker(void);
+static void tftp_complete(void);
+
+/* Leave the multicast group, if any */
+static void tftp_mcast_stop(void)
+{
+	if (!IS_ENABLED(CONFIG_TFTP_MULTICAST) || !tftp_mcast_active)
+		return;
+
+	eth_mcast_join(net_mcast_addr, 0);
+	net_mcast_addr.s_addr = 0;
+	tftp_mcast_active = false;
+}
+
+/* As master client, acknowledge the blocks received so far */
+static void tftp_mcast_ack(void)
+{
+	tftp_mcast_pos = tftp_mcast_next - 1;
+	tftp_cur_block = tftp_mcast_pos % TFTP_SEQUENCE_SIZE;
+	tftp_send();
+}
+
+/* Ask the server for the file again, to hear where the transfer has got to */
+static void tftp_mcast_request(void)
+{
+	int port = tftp_remote_port, state = tftp_state;
+
+	tftp_state = STATE_SEND_RRQ;
+	tftp_remote_port = tftp_server_port;
+	tftp_send();
+	tftp_state = state;
+	tftp_remote_port = port;
+}
+
+/* Give up on multicast and download the whole file with unicast */
+static void tftp_mcast_fallback(const char *msg)
+{
+	printf("\nTFTP %s; starting again with unicast\n", msg);
+	tftp_mcast_stop();
+	tftp_mcast_disabled = true;
+	net_set_state(NETLOOP_RESTART);
+}
+
+/**
+ * tftp_mcast_oack() - handle the multicast option of an OACK
+ *
+ * The value is "addr,port,mc". The group address and port come in the first
+ * OACK, later ones may leave them empty and just make us the master client
+ * (mc = 1) or not.
+ *
+ * @val: option value
+ * Return: 0 if OK, -EINVAL if the value is not valid, -ENOMEM if there is no
+ *	memory for the bitmap
+ */
+static int tftp_mcast_oack(const char *val)
+{
+	const char *port, *mc;
+
+	port = strchr(val, ',');
+	mc = port ? strchr(port + 1, ',') : NULL;
+	if (!mc)
+		return -EINVAL;
+
+	if (!tftp_mcast_active) {
+		if (port == val || mc == port + 1)
+			return -EINVAL;
+		if (!tftp_mcast_bitmap)
+			tftp_mcast_bitmap = malloc(TFTP_MCAST_BITMAP_SIZE);
+		if (!tftp_mcast_bitmap)
+			return -ENOMEM;
+		memset(tftp_mcast_bitmap, '\0', TFTP_MCAST_BITMAP_SIZE);
+
+		net_mcast_addr = string_to_ip(val);
+		tftp_mcast_port = dectoul(port + 1, NULL);
+		if (eth_mcast_join(net_mcast_addr, 1))
+			debug("Cannot set the multicast filter\n");
+		debug("Multicast group %pI4:%d\n", &net_mcast_addr,
+		      tftp_mcast_port);
+		tftp_mcast_active = true;
+		tftp_mcast_pos = 0;
+		tftp_mcast_next = 1;
+		tftp_mcast_last = 0;
+		new_transfer();
+	}
+	tftp_mcast_master = dectoul(mc + 1, NULL) == 1;
+
+	return 0;
+}
+
+static bool tftp_mcast_have(ulong block)
+{
+	return tftp_mcast_bitmap[block / 8] & BIT(block % 8);
+}
+
+/**
+ * tftp_mcast_data() - handle a block of a multicast download
+ *
+ * Blocks are stored in place in whatever order they come. The master client
+ * acknowledges the blocks up to the first one missing, so the server sends
+ * it next. The download is complete once every block up to the final one has
+ * arrived.
+ *
+ * @block: block number, as sent
+ * @src: data
+ * @len: length of the data
+ */
+static void tftp_mcast_data(ushort block, uchar *src, unsigned int len)
+{
+	short delta = block - (ushort)tftp_mcast_pos;
+	ulong blk = tftp_mcast_pos + delta;
+	bool new;
+
+	/* Too far from the last block to tell where this one goes */
+	if (abs(delta) > TFTP_MCAST_SPAN || (long)blk < 1)
+		return;
+	if (blk >= TFTP_MCAST_BITMAP_SIZE * 8) {
+		tftp_mcast_fallback("multicast file too large");
+		return;
+	}
+
+	tftp_mcast_pos = blk;
+	timeout_count = 0;
+	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+
+	new = !tftp_mcast_have(blk);
+	if (new) {
+		if (store_block(blk, src, len)) {
+			tftp_mcast_stop();
+			eth_halt();
+			net_set_state(NETLOOP_FAIL);
+			return;
+		}
+		tftp_mcast_bitmap[blk / 8] |= BIT(blk % 8);
+		tftp_cur_block = blk;
+		show_block_marker();
+	}
+	if (len < tftp_block_size)
+		tftp_mcast_last = blk;
+
+	while (tftp_mcast_next < TFTP_MCAST_BITMAP_SIZE * 8 &&
+	       tftp_mcast_have(tftp_mcast_next))
+		tftp_mcast_next++;
+
+	if (tftp_mcast_last && tftp_mcast_next > tftp_mcast_last) {
+		/* The final ACK tells the server we have it all */
+		tftp_mcast_ack();
+		tftp_mcast_stop();
+		tftp_complete();
+	} else if (tftp_mcast_master && new) {
+		tftp_mcast_ack();
+	}
+}
+
+/* Nothing has come for a while during a multicast download */
+static void tftp_mcast_timeout(void)
+{
+	if (++timeout_count > timeout_count_max) {
+		tftp_mcast_fallback("multicast timeout");
+		return;
+	}
+
+	puts("T ");
+	net_set_timeout_handler(timeout_ms, tftp_timeout_handler);
+	if (tftp_mcast_master)
+		tftp_mcast_ack();
+	else
+		tftp_mcast_request();
+}
 
 /**********************************************************************/
 
@@ -277,6 +527,76 @@ static void update_block_number(void)
 	show_block_marker();
 }
 
+/**
+ * tftp_adapt_start() - Pick the window and block size for a download
+ *
+ * Unless the user has chosen them, use the window size and block size
+ * worked out by the previous downloads.
+ *
+ * @protocol: Protocol being started
+ */
+static void tftp_adapt_start(enum proto_t protocol)
+{
+	tftp_adapting = false;
+	tftp_lost = 0;
+	if (!IS_ENABLED(CONFIG_TFTP_WINDOWSIZE_ADAPTIVE) || protocol != TFTPGET)
+		return;
+	if (IS_ENABLED(CONFIG_NET_TFTP_VARS) && env_get("tftpwindowsize"))
+		return;
+
+	if (!tftp_adapt_window)
+		tftp_adapt_window = TFTP_WINDOWSIZE;
+	tftp_window_size_option = tftp_adapt_window;
+	tftp_adapting = true;
+
+	if (IS_ENABLED(CONFIG_NET_TFTP_VARS) && env_get("tftpblocksize"))
+		return;
+	if (tftp_adapt_block_size &&
+	    tftp_adapt_block_size < tftp_block_size_option) {
+		if (!saved_tftp_block_size_option)
+			saved_tftp_block_size_option = tftp_block_size_option;
+		tftp_block_size_option = tftp_adapt_block_size;
+	}
+}
+
+/**
+ * tftp_adapt_shrink() - Use a smaller window or block size after a timeout
+ *
+ * The window size is halved, as is a block size which needs IP fragmentation,
+ * for the following downloads.
+ *
+ * Return: true if either was reduced, false if they are as small as they go
+ */
+static bool tftp_adapt_shrink(void)
+{
+	bool shrunk = false;
+
+	if (tftp_windowsize > 1) {
+		tftp_adapt_window = tftp_windowsize / 2;
+		shrunk = true;
+	}
+	if (tftp_block_size > TFTP_MTU_BLOCKSIZE4) {
+		tftp_adapt_block_size = max(tftp_block_size / 2,
+					    TFTP_MTU_BLOCKSIZE4);
+		shrunk = true;
+	}
+
+	return shrunk;
+}
+
+/* Grow the window and block size after a download with nothing lost */
+static void tftp_adapt_complete(void)
+{
+	if (!tftp_adapting || tftp_lost)
+		return;
+
+	tftp_adapt_window = min(tftp_window_size_option * 2,
+				TFTP_WINDOWSIZE_MAX);
+	if (tftp_adapt_block_size)
+		tftp_adapt_block_size = min(tftp_adapt_block_size * 2,
+					    TFTP_MAX_BLOCKSIZE);
+}
+
 /* The TFTP get or put is complete */
 static void tftp_complete(void)
 {
@@ -292,10 +612,14 @@ static void tftp_complete(void)
 	time_start = get_timer(time_start);
 	if (time_start > 0) {
 		puts("\n\t ");	/* Line up with "Loading: " */
-		print_size(net_boot_file_size /
-			time_start * 1000, "/s");
+		print_size(lldiv((u64)net_boot_file_size * 1000, time_start),
+			   "/s");
+		if (tftp_windowsize > 1 || tftp_lost)
+			printf(" (window %d, block size %d, %d lost)",
+			       tftp_windowsize, tftp_block_size, tftp_lost);
 	}
 	puts("\ndone\n");
+	tftp_adapt_complete();
 
 	led_activity_off();
 
@@ -360,6 +684,9 @@ static void tftp_send(void)
 		if (tftp_state == STATE_SEND_RRQ && tftp_window_size_option > 1)
 			pkt += sprintf((char *)pkt, "windowsize%c%d%c",
 					0, tftp_window_size_option, 0);
+
+		if (tftp_state == STATE_SEND_RRQ && tftp_mcast_ask)
+			pkt += sprintf((char *)pkt, "multicast%c%c", 0, 0);
 		len = pkt - xp;
 		break;
 
@@ -457,7 +784,8 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	int i;
 	u16 timeout_val_rcvd;
 
-	if (dest != tftp_our_port) {
+	if (dest != tftp_our_port &&
+	    !(tftp_mcast_active && dest == tftp_mcast_port)) {
 			return;
 	}
 	if (tftp_state != STATE_SEND_RRQ && src != tftp_remote_port &&
@@ -572,6 +900,20 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 				debug("windowsize = %s, %d\n",
 				      (char *)pkt + i + 11, tftp_windowsize);
 			}
+			if (IS_ENABLED(CONFIG_TFTP_MULTICAST) && tftp_mcast_ask &&
+			    strcasecmp((char *)pkt + i, "multicast") == 0) {
+				if (tftp_mcast_oack((char *)pkt + i + 10)) {
+					printf("Invalid multicast option\n");
+					tftp_state = STATE_INVALID_OPTION;
+				}
+			}
+		}
+
+		if (tftp_mcast_active && tftp_state == STATE_OACK) {
+			/* Only the master client acknowledges */
+			if (tftp_mcast_master)
+				tftp_mcast_ack();
+			break;
 		}
 
 		tftp_next_ack = tftp_windowsize;
@@ -590,6 +932,11 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			return;
 		len -= 2;
 
+		if (tftp_mcast_active) {
+			tftp_mcast_data(ntohs(*(__be16 *)pkt), pkt + 2, len);
+			break;
+		}
+
 		if (ntohs(*(__be16 *)pkt) != (ushort)(tftp_cur_block + 1)) {
 			debug("Received unexpected block: %d, expected: %d\n",
 			      ntohs(*(__be16 *)pkt),
@@ -611,6 +958,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 			if (tftp_last_nack != tftp_cur_block) {
 				tftp_send();
 				tftp_last_nack = tftp_cur_block;
+				tftp_lost++;
 				tftp_next_ack = (ushort)(tftp_cur_block +
 							 tftp_windowsize);
 			}
@@ -677,6 +1025,7 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 	case TFTP_ERROR:
 		printf("\nTFTP error: '%s' (%d)\n",
 		       pkt + 2, ntohs(*(__be16 *)pkt));
+		tftp_mcast_stop();
 
 		switch (ntohs(*(__be16 *)pkt)) {
 		case TFTP_ERR_FILE_NOT_FOUND:
@@ -701,6 +1050,18 @@ static void tftp_handler(uchar *pkt, unsigned dest, struct in_addr sip,
 
 static void tftp_timeout_handler(void)
 {
+	tftp_lost++;
+	if (tftp_mcast_active) {
+		tftp_mcast_timeout();
+		return;
+	}
+	if (tftp_adapting && tftp_state == STATE_DATA && tftp_adapt_shrink()) {
+		printf("\nTFTP timeout; starting again with window size %d\n",
+		       tftp_adapt_window);
+		net_set_state(NETLOOP_RESTART);
+		return;
+	}
+
 	if (++timeout_count > timeout_count_max) {
 		restart("Retry count exceeded");
 	} else {
@@ -714,10 +1075,11 @@ static void tftp_timeout_handler(void)
 static int tftp_init_load_addr(void)
 {
 	tftp_load_addr = image_load_addr;
+	tftp_load_buf = map_sysmem(tftp_load_addr, 0);
+	tftp_load_reserved = 0;
 	return 0;
 }
 
-static int saved_tftp_block_size_option;
 static void sanitize_tftp_block_size_option(enum proto_t protocol)
 {
 	int cap, max_defrag;
@@ -728,8 +1090,7 @@ static void sanitize_tftp_block_size_option(enum proto_t protocol)
 		if (max_defrag) {
 			/* Account for IP, UDP and TFTP headers. */
 			cap = max_defrag - (20 + 8 + 4);
-			/* RFC2348 sets a hard upper limit. */
-			cap = min(cap, 65464);
+			cap = min(cap, TFTP_MAX_BLOCKSIZE);
 			break;
 		}
 		/*
@@ -746,7 +1107,7 @@ static void sanitize_tftp_block_size_option(enum proto_t protocol)
 		 * (and small enough that it fits net_tx_packet which
 		 * has room for PKTSIZE_ALIGN bytes).
 		 */
-		cap = 1468;
+		cap = TFTP_MTU_BLOCKSIZE4;
 	}
 	if (tftp_block_size_option > cap) {
 		printf("Capping tftp block size option to %d (was %d)\n",
@@ -801,8 +1162,16 @@ void tftp_start(enum proto_t protocol)
 		}
 	}
 
+	tftp_adapt_start(protocol);
 	sanitize_tftp_block_size_option(protocol);
 
+	tftp_mcast_stop();
+	tftp_mcast_ask = IS_ENABLED(CONFIG_TFTP_MULTICAST) &&
+			 protocol == TFTPGET && !tftp_mcast_disabled &&
+			 !(IS_ENABLED(CONFIG_IPV6) && use_ip6) &&
+			 env_get_yesno("tftpmulticast") != 0;
+	tftp_mcast_disabled = false;
+
 	debug("TFTP blocksize = %i, TFTP windowsize = %d timeout = %ld ms\n",
 	      tftp_block_size_option, tftp_window_size_option, timeout_ms);
 
@@ -931,6 +1300,7 @@ void tftp_start(enum proto_t protocol)
 	if (ep != NULL)
 		tftp_our_port = simple_strtol(ep, NULL, 10);
 #endif
+	tftp_server_port = tftp_remote_port;
 	tftp_cur_block = 0;
 	tftp_windowsize = 1;
 	tftp_last_nack = 0;
@@ -23,15 +23,34 @@ DECLARE_GLOBAL_DATA_PTR;
 #define SERVER_PORT		80
 
 static const char bootfile1[] = "GET ";
-static const char bootfile3[] = " HTTP/1.0\r\n\r\n";
+static const char bootfile3[] = " HTTP/1.0\r\n";
 static const char http_eom[] = "\r\n\r\n";
 static const char http_ok[] = "200";
+static const char http_partial[] = "206";
 static const char content_len[] = "Content-Length";
+static const char connection[] = "Connection";
+static const char keep_alive[] = "keep-alive";
 static const char linefeed[] = "\r\n";
 static struct in_addr web_server_ip;
+static unsigned int server_port;
 static int our_port;
 static int wget_timeout_count;
 
+/* Part of the file to fetch, set by wget_set_range() */
+static ulong range_start;
+static ulong range_size;
+
+/*
+ * When the server agrees to keep the connection open after a transfer, the
+ * next transfer from the same server reuses it rather than connecting again.
+ */
+static bool wget_keep_alive;	/* server keeps this connection open */
+static bool wget_conn_open;	/* connection left open by the last transfer */
+static bool wget_reused;	/* this transfer reuses it */
+static struct in_addr keep_server_ip;
+static unsigned int keep_server_port;
+static uchar keep_server_ethaddr[ARP_HLEN];
+
 struct pkt_qd {
 	uchar *pkt;
 	unsigned int tcp_seq_num;
@@ -50,7 +69,6 @@ static unsigned long content_length;
 static unsigned int packets;
 
 static unsigned int initial_data_seq_num;
-static unsigned int next_data_seq_num;
 
 static enum  wget_state current_wget_state;
 
@@ -110,11 +128,8 @@ static void wget_send_stored(void)
 	int len = retry_len;
 	unsigned int tcp_ack_num = retry_tcp_seq_num + (len == 0 ? 1 : len);
 	unsigned int tcp_seq_num = retry_tcp_ack_num;
-	unsigned int server_port;
 	uchar *ptr, *offset;
 
-	server_port = env_get_ulong("httpdstp", 10, SERVER_PORT) & 0xffff;
-
 	switch (current_wget_state) {
 	case WGET_CLOSED:
 		debug_cond(DEBUG_WGET, "wget: send SYN\n");
@@ -140,6 +155,20 @@ static void wget_send_stored(void)
 
 		memcpy(offset, &bootfile3, strlen(bootfile3));
 		offset += strlen(bootfile3);
+
+		offset += sprintf((char *)offset, "Host: %pI4\r\n%s: %s\r\n",
+				  &web_server_ip, connection, keep_alive);
+		if (range_start || range_size) {
+			offset += sprintf((char *)offset, "Range: bytes=%lu-",
+					  range_start);
+			if (range_size)
+				offset += sprintf((char *)offset, "%lu",
+						  range_start + range_size - 1);
+			offset += sprintf((char *)offset, "%s", linefeed);
+		}
+
+		memcpy(offset, &linefeed, strlen(linefeed));
+		offset += strlen(linefeed);
 		net_send_tcp_packet((offset - ptr), server_port, our_port,
 				    TCP_PUSH, tcp_seq_num, tcp_ack_num);
 		current_wget_state = WGET_CONNECTED;
@@ -153,14 +182,19 @@ static void wget_send_stored(void)
 	}
 }
 
-static void wget_send(u8 action, unsigned int tcp_seq_num,
-		      unsigned int tcp_ack_num, int len)
+static void wget_store(u8 action, unsigned int tcp_seq_num,
+		       unsigned int tcp_ack_num, int len)
 {
 	retry_action = action;
 	retry_tcp_ack_num = tcp_ack_num;
 	retry_tcp_seq_num = tcp_seq_num;
 	retry_len = len;
+}
 
+static void wget_send(u8 action, unsigned int tcp_seq_num,
+		      unsigned int tcp_ack_num, int len)
+{
+	wget_store(action, tcp_seq_num, tcp_ack_num, len);
 	wget_send_stored();
 }
 
@@ -190,6 +224,82 @@ static void wget_timeout_handler(void)
 	}
 }
 
+/* Send an ACK which was delayed */
+static void wget_ack_timeout_handler(void)
+{
+	net_set_timeout_handler(wget_timeout, wget_timeout_handler);
+	wget_send_stored();
+}
+
+/**
+ * wget_header_is() - check the value of an HTTP response header
+ *
+ * @hdr: response, nul-terminated
+ * @name: header name
+ * @value: value to look for
+ * Return: true if @hdr has header @name starting with @value, ignoring case
+ */
+static bool wget_header_is(const char *hdr, const char *name,
+			   const char *value)
+{
+	int len = strlen(name);
+	const char *line = hdr;
+
+	while (line && strncmp(line, linefeed, strlen(linefeed))) {
+		if (!strncasecmp(line, name, len) && line[len] == ':') {
+			line += len + 1;
+			while (*line == ' ')
+				line++;
+
+			return !strncasecmp(line, value, strlen(value));
+		}
+		line = strstr(line, linefeed);
+		if (line)
+			line += strlen(linefeed);
+	}
+
+	return false;
+}
+
+static void wget_success(void)
+{
+	printf("Packets received %d, Transfer Successful\n", packets);
+	net_set_state(wget_loop_state);
+	efi_set_bootdev("Net", "", image_url,
+			map_sysmem(image_load_addr, 0),
+			net_boot_file_size);
+	env_set_hex("filesize", net_boot_file_size);
+}
+
+/**
+ * wget_check_done() - finish a transfer on a connection that stays open
+ *
+ * The server does not close the connection at the end of the body, so the
+ * transfer is complete as soon as all of it has been received.
+ *
+ * Return: true if the transfer is complete
+ */
+static bool wget_check_done(unsigned int tcp_seq_num, unsigned int tcp_ack_num,
+			    unsigned int len)
+{
+	if (!wget_keep_alive ||
+	    tcp_get_ack_edge() - initial_data_seq_num < content_length)
+		return false;
+
+	wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num, len);
+	net_set_timeout_handler(0, NULL);
+	puts("\n");
+	wget_conn_open = true;
+	keep_server_ip = web_server_ip;
+	keep_server_port = server_port;
+	memcpy(keep_server_ethaddr, net_server_ethaddr, ARP_HLEN);
+	current_wget_state = WGET_CLOSED;
+	wget_loop_state = NETLOOP_SUCCESS;
+	wget_success();
+
+	return true;
+}
+
 #define PKT_QUEUE_OFFSET 0x20000
 #define PKT_QUEUE_PACKET_SIZE 0x800
 
@@ -239,9 +349,9 @@ static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 		current_wget_state = WGET_TRANSFERRING;
 
 		initial_data_seq_num = tcp_seq_num + hlen;
-		next_data_seq_num    = tcp_seq_num + len;
 
-		if (strstr((char *)pkt, http_ok) == 0) {
+		if (strstr((char *)pkt, range_start || range_size ?
+			   http_partial : http_ok) == 0) {
 			debug_cond(DEBUG_WGET,
 				   "wget: Connected Bad Xfer\n");
 			wget_loop_state = NETLOOP_FAIL;
@@ -260,6 +370,9 @@ static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 				debug_cond(DEBUG_WGET,
 					   "wget: Connected Len %lu\n",
 					   content_length);
+				wget_keep_alive = wget_header_is((char *)pkt,
+								 connection,
+								 keep_alive);
 			}
 
 			net_boot_file_size = 0;
@@ -293,6 +406,8 @@ static void wget_connected(uchar *pkt, unsigned int tcp_seq_num,
 					return;
 				}
 			}
+			if (wget_check_done(tcp_seq_num, tcp_ack_num, len))
+				return;
 		}
 	}
 	wget_send(action, tcp_seq_num, tcp_ack_num, len);
@@ -319,6 +434,22 @@ static void wget_handler(uchar *pkt, u16 dport,
 {
 	enum tcp_state wget_tcp_state = tcp_get_tcp_state();
 
+	if (current_wget_state == WGET_CLOSED || ntohs(dport) != our_port)
+		return;
+
+	/* The server may have closed a connection which was left open */
+	if (wget_reused && current_wget_state != WGET_TRANSFERRING &&
+	    action & (TCP_RST | TCP_FIN)) {
+		debug_cond(DEBUG_WGET, "wget: Connection closed, reconnecting\n");
+		wget_reused = false;
+		if (!(action & TCP_RST))
+			wget_send(TCP_RST, tcp_seq_num, tcp_ack_num, len);
+		net_set_state(NETLOOP_RESTART);
+		return;
+	}
+	if (action == TCP_RST)
+		return;
+
 	net_set_timeout_handler(wget_timeout, wget_timeout_handler);
 	packets++;
 
@@ -358,11 +489,15 @@ static void wget_handler(uchar *pkt, u16 dport,
 			   "wget: Transferring, seq=%x, ack=%x,len=%x\n",
 			   tcp_seq_num, tcp_ack_num, len);
 
-		if (next_data_seq_num != tcp_seq_num) {
-			debug_cond(DEBUG_WGET, "wget: seq=%x packet was lost\n", next_data_seq_num);
+		/*
+		 * TCP has checked where this fits in the stream, so store it
+		 * in place even if earlier data is still missing
+		 */
+		if ((int)(tcp_seq_num - initial_data_seq_num) < 0) {
+			debug_cond(DEBUG_WGET, "wget: seq=%x is before the data\n",
+				   tcp_seq_num);
 			return;
 		}
-		next_data_seq_num = tcp_seq_num + len;
 
 		if (store_block(pkt, tcp_seq_num - initial_data_seq_num, len) != 0) {
 			wget_fail("wget: store error\n",
@@ -370,6 +505,9 @@ static void wget_handler(uchar *pkt, u16 dport,
 			net_set_state(NETLOOP_FAIL);
 			return;
 		}
+		if (wget_tcp_state == TCP_ESTABLISHED &&
+		    wget_check_done(tcp_seq_num, tcp_ack_num, len))
+			return;
 
 		switch (wget_tcp_state) {
 		case TCP_FIN_WAIT_2:
@@ -383,8 +521,15 @@ static void wget_handler(uchar *pkt, u16 dport,
 			net_set_state(NETLOOP_FAIL);
 			break;
 		case TCP_ESTABLISHED:
-			wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num,
-				  len);
+			if (tcp_ack_delayed()) {
+				wget_store(TCP_ACK, tcp_seq_num, tcp_ack_num,
+					   len);
+				net_set_timeout_handler(TCP_ACK_DELAY,
+							wget_ack_timeout_handler);
+			} else {
+				wget_send(TCP_ACK, tcp_seq_num, tcp_ack_num,
+					  len);
+			}
 			wget_loop_state = NETLOOP_SUCCESS;
 			break;
 		case TCP_CLOSE_WAIT:     /* End of transfer */
@@ -395,12 +540,7 @@ static void wget_handler(uchar *pkt, u16 dport,
 		}
 		break;
 	case WGET_TRANSFERRED:
-		printf("Packets received %d, Transfer Successful\n", packets);
-		net_set_state(wget_loop_state);
-		efi_set_bootdev("Net", "", image_url,
-				map_sysmem(image_load_addr, 0),
-				net_boot_file_size);
-		env_set_hex("filesize", net_boot_file_size);
+		wget_success();
 		break;
 	}
 }
@@ -466,9 +606,8 @@ void wget_start(void)
 	tcp_set_tcp_handler(wget_handler);
 
 	wget_timeout_count = 0;
-	current_wget_state = WGET_CLOSED;
-
-	our_port = random_port();
+	wget_keep_alive = false;
+	server_port = env_get_ulong("httpdstp", 10, SERVER_PORT) & 0xffff;
 
 	/*
 	 * Zero out server ether to force arp resolution in case
@@ -478,9 +617,34 @@ void wget_start(void)
 
 	memset(net_server_ethaddr, 0, 6);
 
+	wget_reused = wget_conn_open &&
+		      tcp_get_tcp_state() == TCP_ESTABLISHED &&
+		      keep_server_ip.s_addr == web_server_ip.s_addr &&
+		      keep_server_port == server_port;
+	wget_conn_open = false;
+	if (wget_reused) {
+		debug_cond(DEBUG_WGET, "wget: Reusing connection\n");
+		memcpy(net_server_ethaddr, keep_server_ethaddr, ARP_HLEN);
+		packets = 0;
+		current_wget_state = WGET_CONNECTING;
+		retry_action = TCP_ACK;
+		wget_send_stored();
+		return;
+	}
+
+	current_wget_state = WGET_CLOSED;
+
+	our_port = random_port();
+
 	wget_send(TCP_SYN, 0, 0, 0);
 }
 
+void wget_set_range(ulong start, ulong size)
+{
+	range_start = start;
+	range_size = size;
+}
+
 #if (IS_ENABLED(CONFIG_CMD_DNS))
 int wget_with_dns(ulong dst_addr, char *uri)
 {
@@ -343,38 +343,24 @@ static int overlay_update_local_references(void *fdto, uint32_t delta)
 }
 
 /**
- * overlay_fixup_one_phandle - Set an overlay phandle to the base one
+ * overlay_lookup_label - Look up the phandle of a labelled base node
  * @fdt: Base Device Tree blob
- * @fdto: Device tree overlay blob
  * @symbols_off: Node offset of the symbols node in the base device tree
- * @path: Path to a node holding a phandle in the overlay
- * @path_len: number of path characters to consider
- * @name: Name of the property holding the phandle reference in the overlay
- * @name_len: number of name characters to consider
- * @poffset: Offset within the overlay property where the phandle is stored
- * @label: Label of the node referenced by the phandle
- *
- * overlay_fixup_one_phandle() resolves an overlay phandle pointing to
- * a node in the base device tree.
+ * @label: Label of the node
+ * @phandle: Pointer which receives the phandle of the node
  *
- * This is part of the device tree overlay application process, when
- * you want all the phandles in the overlay to point to the actual
- * base dt nodes.
+ * overlay_lookup_label() finds the node a label in the __symbols__
+ * node of the base device tree refers to and returns its phandle.
  *
  * returns:
  *      0 on success
  *      Negative error code on failure
  */
-static int overlay_fixup_one_phandle(void *fdt, void *fdto,
-				     int symbols_off,
-				     const char *path, uint32_t path_len,
-				     const char *name, uint32_t name_len,
-				     int poffset, const char *label)
+static int overlay_lookup_label(const void *fdt, int symbols_off,
+				const char *label, uint32_t *phandle)
 {
 	const char *symbol_path;
-	uint32_t phandle;
-	fdt32_t phandle_prop;
-	int symbol_off, fixup_off;
+	int symbol_off;
 	int prop_len;
 
 	if (symbols_off < 0)
@@ -389,10 +375,42 @@ static int overlay_fixup_one_phandle(void *fdt, void *fdto,
 	if (symbol_off < 0)
 		return symbol_off;
 
-	phandle = fdt_get_phandle(fdt, symbol_off);
-	if (!phandle)
+	*phandle = fdt_get_phandle(fdt, symbol_off);
+	if (!*phandle)
 		return -FDT_ERR_NOTFOUND;
 
+	return 0;
+}
+
+/**
+ * overlay_fixup_one_phandle - Set an overlay phandle to the base one
+ * @fdto: Device tree overlay blob
+ * @path: Path to a node holding a phandle in the overlay
+ * @path_len: number of path characters to consider
+ * @name: Name of the property holding the phandle reference in the overlay
+ * @name_len: number of name characters to consider
+ * @poffset: Offset within the overlay property where the phandle is stored
+ * @phandle: Phandle of the referenced node in the base device tree
+ *
+ * overlay_fixup_one_phandle() updates one overlay phandle pointing to
+ * a node in the base device tree.
+ *
+ * This is part of the device tree overlay application process, when
+ * you want all the phandles in the overlay to point to the actual
+ * base dt nodes.
+ *
+ * returns:
+ *      0 on success
+ *      Negative error code on failure
+ */
+static int overlay_fixup_one_phandle(void *fdto,
+				     const char *path, uint32_t path_len,
+				     const char *name, uint32_t name_len,
+				     int poffset, uint32_t phandle)
+{
+	fdt32_t phandle_prop;
+	int fixup_off;
+
 	fixup_off = fdt_path_offset_namelen(fdto, path, path_len);
 	if (fixup_off == -FDT_ERR_NOTFOUND)
 		return -FDT_ERR_BADOVERLAY;
@@ -430,6 +448,7 @@ static int overlay_fixup_phandle(void *fdt, void *fdto, int symbols_off,
 {
 	const char *value;
 	const char *label;
+	uint32_t phandle = 0;
 	int len;
 
 	value = fdt_getprop_by_offset(fdto, property,
@@ -480,9 +499,17 @@ static int overlay_fixup_phandle(void *fdt, void *fdto, int symbols_off,
 		if ((*endptr != '\0') || (endptr <= (sep + 1)))
 			return -FDT_ERR_BADOVERLAY;
 
-		ret = overlay_fixup_one_phandle(fdt, fdto, symbols_off,
-						path, path_len, name, name_len,
-						poffset, label);
+		/* All references in the property are to the same label */
+		if (!phandle) {
+			ret = overlay_lookup_label(fdt, symbols_off, label,
+						   &phandle);
+			if (ret)
+				return ret;
+		}
+
+		ret = overlay_fixup_one_phandle(fdto, path, path_len,
+						name, name_len, poffset,
+						phandle);
 		if (ret)
 			return ret;
 	} while (len > 0);
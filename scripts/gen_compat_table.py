@@ -0,0 +1,106 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0+
+
+"""Generate a sorted table of compatible strings for the linked drivers
+
+This reads the output of nm on the objects being linked into U-Boot from
+stdin, to find which drivers are present, then scans the source tree for the
+compatible strings of each one. The result is a C file holding an array of
+(compatible, driver) pairs sorted by compatible string, which
+lists_driver_lookup_compat() can search instead of walking every driver.
+
+Usage: $(NM) $(u-boot-main) | gen_compat_table.py <srctree> <output.c>
+"""
+
+import contextlib
+import io
+import os
+import re
+import sys
+
+our_path = os.path.dirname(os.path.realpath(__file__))
+sys.path.insert(1, os.path.join(our_path, '../tools'))
+
+# pylint: disable=C0413
+from dtoc import src_scan
+
+RE_DRIVER = re.compile(r'_u_boot_list_2_driver_2_(\w+)')
+
+
+def c_string(val):
+    """Quote a string for use in C source
+
+    Args:
+        val (str): String to quote
+
+    Returns:
+        str: Quoted string
+    """
+    out = ''
+    for char in val:
+        if char in '\\"':
+            out += '\\' + char
+        elif ' ' <= char <= '~':
+            out += char
+        else:
+            out += '\\%03o' % ord(char)
+    return '"%s"' % out
+
+
+def get_entries(srctree, linked):
+    """Get the (compatible, driver) pairs for the linked drivers
+
+    Args:
+        srctree (str): Path to the U-Boot source tree
+        linked (set of str): Names of the drivers in the image
+
+    Returns:
+        list of tuple: (compatible, driver name), sorted by compatible string,
+            then by driver name, which is the order of the linker list
+    """
+    scan = src_scan.Scanner(srctree, None)
+    with contextlib.redirect_stdout(io.StringIO()):
+        scan.scan_drivers()
+
+    entries = set()
+    for name, driver in scan._drivers.items():
+        if name not in linked:
+            continue
+        # Drivers with the same name cannot be told apart here
+        for drv in [driver] + driver.dups:
+            for compat in drv.compat or {}:
+                entries.add((compat, name))
+    return sorted(entries)
+
+
+def run():
+    """Generate the table"""
+    if len(sys.argv) != 3:
+        print('Usage: %s <srctree> <output.c>' % sys.argv[0], file=sys.stderr)
+        sys.exit(1)
+    srctree, outfile = sys.argv[1:]
+
+    linked = set(RE_DRIVER.findall(sys.stdin.read()))
+    entries = get_entries(srctree, linked)
+
+    out = ['/* Generated by scripts/gen_compat_table.py - do not edit */',
+           '',
+           '#include <dm/device.h>',
+           '#include <dm/lists.h>',
+           '']
+    for name in sorted(set(name for _, name in entries)):
+        out.append('extern U_BOOT_DRIVER(%s);' % name)
+    out += ['',
+            'const struct dm_compat_entry dm_compat_table[] = {']
+    for compat, name in entries:
+        out.append('\t{ %s, DM_DRIVER_REF(%s) },' % (c_string(compat), name))
+    out += ['};',
+            '',
+            'const int dm_compat_table_count = ARRAY_SIZE(dm_compat_table);',
+            '']
+    with open(outfile, 'w', encoding='utf-8') as outf:
+        outf.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    run()
@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0+
+
+"""Generate the live tree for a devicetree blob at build time
+
+This produces a C file holding the struct device_node and struct property
+records which unflatten_device_tree() would create for the blob. Pointers
+between records are resolved by the linker. Node and property names and
+property values are left as offsets into the blob, which
+of_live_static_attach() turns into pointers once it has checked that the
+blob it is given is the one the file was generated from.
+
+Usage: gen_live_tree.py <input.dtb> <output.c>
+"""
+
+import struct
+import sys
+import zlib
+
+FDT_MAGIC = 0xd00dfeed
+FDT_BEGIN_NODE = 1
+FDT_END_NODE = 2
+FDT_PROP = 3
+FDT_NOP = 4
+FDT_END = 9
+
+
+class Prop:
+    """A property, as unflatten_dt_node() sets it up
+
+    Attributes:
+        name_off (int): Offset of the name in the blob
+        name (str): Name of the property
+        length (int): Length of the value
+        value_off (int): Offset of the value in the blob
+    """
+    def __init__(self, name_off, name, length, value_off):
+        self.name_off = name_off
+        self.name = name
+        self.length = length
+        self.value_off = value_off
+
+
+class Node:
+    """A node, as unflatten_dt_node() sets it up
+
+    Attributes:
+        name_off (int): Offset of the unit name in the blob
+        full_name (str): Path of the node
+        phandle (int): Phandle, or 0 if none
+        props (list of Prop): Properties, in blob order
+        parent (Node): Parent node, or None for the root
+        children (list of Node): Subnodes, in blob order
+        index (int): Index of the node in the generated array
+    """
+    def __init__(self, name_off, full_name, parent):
+        self.name_off = name_off
+        self.full_name = full_name
+        self.phandle = 0
+        self.props = []
+        self.parent = parent
+        self.children = []
+        self.index = 0
+
+
+def get_string(data, offset):
+    """Read a nul-terminated string from the blob"""
+    end = data.index(b'\0', offset)
+    return data[offset:end].decode('utf-8', 'replace')
+
+
+def prop_hash(data, offset):
+    """Hash a property name in the blob, as of_prop_hash() does"""
+    hsh = 0x811c9dc5
+    for char in data[offset:data.index(b'\0', offset)]:
+        hsh = ((hsh ^ char) * 0x01000193) & 0xffffffff
+    return hsh
+
+
+def scan(data):
+    """Parse a devicetree blob
+
+    Args:
+        data (bytes): Contents of the blob
+
+    Returns:
+        Node: Root node
+    """
+    (magic, _, off_struct, off_strings, _, version) = struct.unpack(
+        '>6L', data[:24])
+    if magic != FDT_MAGIC or version < 0x10:
+        raise ValueError('Not a devicetree blob (version 16 or later)')
+
+    pos = off_struct
+    root = None
+    node = None
+    while True:
+        token = struct.unpack('>L', data[pos:pos + 4])[0]
+        pos += 4
+        if token == FDT_BEGIN_NODE:
+            name = get_string(data, pos)
+            if not node:
+                full_name = '/'
+            elif not node.parent:
+                full_name = '/' + name
+            else:
+                full_name = node.full_name + '/' + name
+            new = Node(pos, full_name, node)
+            if node:
+                node.children.append(new)
+            else:
+                root = new
+            node = new
+            pos = (pos + len(name.encode()) + 1 + 3) & ~3
+        elif token == FDT_PROP:
+            length, name_off = struct.unpack('>2L', data[pos:pos + 8])
+            pos += 8
+            name = get_string(data, off_strings + name_off)
+            node.props.append(Prop(off_strings + name_off, name, length,
+                                   pos))
+            if length >= 4:
+                val = struct.unpack('>L', data[pos:pos + 4])[0]
+                if name in ('phandle', 'linux,phandle'):
+                    if not node.phandle:
+                        node.phandle = val
+                elif name == 'ibm,phandle':
+                    node.phandle = val
+            pos = (pos + length + 3) & ~3
+        elif token == FDT_END_NODE:
+            node = node.parent
+        elif token == FDT_NOP:
+            pass
+        elif token == FDT_END:
+            break
+        else:
+            raise ValueError('Bad token %d at offset %#x' % (token, pos - 4))
+    return root
+
+
+def c_string(val):
+    """Quote a string for use in C source"""
+    out = ''
+    for char in val:
+        if char in '\\"':
+            out += '\\' + char
+        elif ' ' <= char <= '~':
+            out += char
+        else:
+            out += '\\%03o' % ord(char)
+    return '"%s"' % out
+
+
+def run():
+    """Generate the file"""
+    if len(sys.argv) != 3:
+        print('Usage: %s <input.dtb> <output.c>' % sys.argv[0],
+              file=sys.stderr)
+        sys.exit(1)
+    with open(sys.argv[1], 'rb') as inf:
+        data = inf.read()
+    size = struct.unpack('>L', data[4:8])[0]
+    data = data[:size]
+    root = scan(data)
+
+    nodes = []
+    todo = [root]
+    while todo:
+        node = todo.pop()
+        node.index = len(nodes)
+        nodes.append(node)
+        todo += reversed(node.children)
+
+    def node_ref(node):
+        return '&dt_live_nodes[%d]' % node.index if node else 'NULL'
+
+    out = ['/*',
+           ' * Generated by scripts/gen_live_tree.py - do not edit',
+           ' *',
+           ' * Names and values are offsets into the devicetree, fixed up by',
+           ' * of_live_static_attach()',
+           ' */',
+           '',
+           '#include <of_live.h>',
+           '#include <dm/of.h>',
+           '']
+
+    prop_count = sum(len(node.props) for node in nodes)
+    out.append('static struct property dt_live_props[%d] = {' %
+               max(prop_count, 1))
+    first_prop = []
+    idx = 0
+    for node in nodes:
+        first_prop.append(idx if node.props else None)
+        for seq, prop in enumerate(node.props):
+            nxt = ('&dt_live_props[%d]' % (idx + 1)
+                   if seq + 1 < len(node.props) else 'NULL')
+            out.append('\t{ (char *)%#x, %d, %#x, (void *)%#x, %s },' %
+                       (prop.name_off, prop.length,
+                        prop_hash(data, prop.name_off), prop.value_off, nxt))
+            idx += 1
+    out += ['};', '']
+
+    out.append('static struct device_node dt_live_nodes[%d] = {' %
+               len(nodes))
+    for node in nodes:
+        parent = node.parent
+        sibling = None
+        if parent:
+            pos = parent.children.index(node)
+            if pos + 1 < len(parent.children):
+                sibling = parent.children[pos + 1]
+        first = first_prop[node.index]
+        props = '&dt_live_props[%d]' % first if first is not None else 'NULL'
+        out += ['\t{',
+                '\t\t.name = (const char *)%#x,' % node.name_off,
+                '\t\t.phandle = %#x,' % node.phandle,
+                '\t\t.full_name = %s,' % c_string(node.full_name),
+                '\t\t.properties = %s,' % props,
+                '\t\t.parent = %s,' % node_ref(parent),
+                '\t\t.child = %s,' % node_ref(node.children[0] if
+                                               node.children else None),
+                '\t\t.sibling = %s,' % node_ref(sibling),
+                '\t},']
+    out += ['};',
+            '',
+            'struct of_live_static of_live_static = {',
+            '\t.fdt_size = %#x,' % size,
+            '\t.fdt_crc = %#x,' % zlib.crc32(data),
+            '\t.nodes = dt_live_nodes,',
+            '\t.node_count = %d,' % len(nodes),
+            '\t.props = dt_live_props,',
+            '\t.prop_count = %d,' % prop_count,
+            '};',
+            '']
+    with open(sys.argv[2], 'w', encoding='utf-8') as outf:
+        outf.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    run()
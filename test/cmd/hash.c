@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the hash command with several algorithms and regions
+ */
+
+#include <command.h>
+#include <console.h>
+#include <env.h>
+#include <mapmem.h>
+#include <test/cmd.h>
+#include <test/ut.h>
+
+#define SHA256_ABC \
+	"ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"
+#define MD5_ABC		"900150983cd24fb0d6963f7d28e17f72"
+#define CRC32_ABC	"352441c2"
+
+static void hash_test_setup(void)
+{
+	void *buf;
+
+	buf = map_sysmem(0x1000, 0x1003);
+	memcpy(buf, "abc", 3);
+	memcpy(buf + 0x1000, "abc", 3);
+	unmap_sysmem(buf);
+}
+
+/* Test 'hash' with several algorithms over one region */
+static int cmd_test_hash_multi_algo(struct unit_test_state *uts)
+{
+	hash_test_setup();
+
+	ut_assertok(run_command("hash sha256,md5,crc32 1000 3", 0));
+	ut_assert_nextline("sha256 for 00001000 ... 00001002 ==> " SHA256_ABC);
+	ut_assert_nextline("md5 for 00001000 ... 00001002 ==> " MD5_ABC);
+	ut_assert_nextline("crc32 for 00001000 ... 00001002 ==> " CRC32_ABC);
+	ut_assert_console_end();
+
+	return 0;
+}
+CMD_TEST(cmd_test_hash_multi_algo, UTF_CONSOLE);
+
+/* Test 'hash' storing digests of several regions */
+static int cmd_test_hash_multi_region(struct unit_test_state *uts)
+{
+	hash_test_setup();
+
+	ut_assertok(run_command("hash md5,crc32 1000 3 2000 3 m1,c1,m2,c2", 0));
+	ut_assert_nextline("md5 for 00001000 ... 00001002 ==> " MD5_ABC);
+	ut_assert_nextline("crc32 for 00001000 ... 00001002 ==> " CRC32_ABC);
+	ut_assert_nextline("md5 for 00002000 ... 00002002 ==> " MD5_ABC);
+	ut_assert_nextline("crc32 for 00002000 ... 00002002 ==> " CRC32_ABC);
+	ut_assert_console_end();
+
+	ut_asserteq_str(MD5_ABC, env_get("m1"));
+	ut_asserteq_str(CRC32_ABC, env_get("c1"));
+	ut_asserteq_str(MD5_ABC, env_get("m2"));
+	ut_asserteq_str(CRC32_ABC, env_get("c2"));
+
+	/* one destination per digest is required */
+	ut_asserteq(1, run_command("hash md5,crc32 1000 3 2000 3 m1,c1", 0));
+	ut_assert_nextline("Expected 4 hashes");
+	ut_assertok(console_record_reset_enable());
+
+	return 0;
+}
+CMD_TEST(cmd_test_hash_multi_region, UTF_CONSOLE);
+
+/* Test 'hash -v' with several algorithms */
+static int cmd_test_hash_multi_verify(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_HASH_VERIFY))
+		return -EAGAIN;
+
+	hash_test_setup();
+
+	ut_assertok(run_command("hash -v sha256,crc32 1000 3 "
+				SHA256_ABC "," CRC32_ABC, 0));
+	ut_assert_console_end();
+
+	ut_asserteq(1, run_command("hash -v sha256,crc32 1000 3 "
+				   SHA256_ABC ",00000000", 0));
+	ut_assert_nextline("crc32 for 00001000 ... 00001002 ==> " CRC32_ABC
+			   " != 00000000 ** ERROR **");
+	ut_assert_console_end();
+
+	return 0;
+}
+CMD_TEST(cmd_test_hash_multi_verify, UTF_CONSOLE);
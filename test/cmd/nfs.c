@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the nfs command
+ */
+
+#include <command.h>
+#include <dm.h>
+#include <env.h>
+#include <mapmem.h>
+#include <net.h>
+#include <asm/eth.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include "../../net/nfs.h"
+
+#define NFS_PORT	2049
+#define MOUNT_PORT	635
+#define NFS_TEST_FH	0x12345678
+/* Three full reads and a short one */
+#define NFS_FILE_SIZE	(3 * NFS_READ_SIZE + 300)
+#define NFS_MAX_READS	8
+
+/* Words in the header of an RPC call, followed by the credentials */
+#define RPC_CALL_HDR	6
+#define RPC_CRED	9
+
+static u8 nfs_file[NFS_FILE_SIZE];
+static u32 nfs_read_offsets[NFS_MAX_READS];
+static u32 nfs_read_counts[NFS_MAX_READS];
+static int nfs_num_reads;
+/* Requests the fake server has not answered yet */
+static u32 nfs_pending[NFS_MAX_READS][3];
+static int nfs_num_pending;
+static bool nfs_umounted;
+
+/* Queue an RPC reply from the fake server */
+static void sb_rpc_reply(struct udevice *dev, void *packet, const u32 *words,
+			 int num_words, const void *data, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_send;
+	struct ip_udp_hdr *ip_send;
+	u32 *reply;
+	int size;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth_send = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_send->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_send->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_send->et_protlen = htons(PROT_IP);
+
+	ip_send = (void *)eth_send + ETHER_HDR_SIZE;
+	reply = (void *)ip_send + IP_UDP_HDR_SIZE;
+	memcpy(reply, words, num_words * sizeof(u32));
+	memcpy(reply + num_words, data, len);
+	size = num_words * sizeof(u32) + ALIGN(len, 4);
+
+	net_set_udp_header((uchar *)ip_send, net_read_ip(&ip->ip_src),
+			   ntohs(ip->udp_src), ntohs(ip->udp_dst), size);
+	net_copy_ip(&ip_send->ip_src, &ip->ip_dst);
+	ip_send->ip_sum = 0;
+	ip_send->ip_sum = compute_ip_checksum(ip_send, IP_HDR_SIZE);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + size;
+	++priv->recv_packets;
+}
+
+/* Answer a READ request for @count bytes at @offset */
+static void sb_nfs_read_reply(struct udevice *dev, void *packet, u32 xid,
+			      u32 offset, u32 count)
+{
+	u32 words[11] = { xid, htonl(MSG_REPLY) };
+
+	if (offset >= NFS_FILE_SIZE)
+		count = 0;
+	count = min_t(u32, count, NFS_FILE_SIZE - offset);
+	words[8] = htonl(count);
+	words[9] = htonl(offset + count == NFS_FILE_SIZE);
+	words[10] = htonl(count);
+	sb_rpc_reply(dev, packet, words, ARRAY_SIZE(words), nfs_file + offset,
+		     count);
+}
+
+/* Answer the pending READ requests while there is room to receive them */
+static void sb_nfs_flush(struct udevice *dev, void *packet)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+
+	while (nfs_num_pending && priv->recv_packets < PKTBUFSRX) {
+		nfs_num_pending--;
+		sb_nfs_read_reply(dev, packet, nfs_pending[nfs_num_pending][0],
+				  nfs_pending[nfs_num_pending][1],
+				  nfs_pending[nfs_num_pending][2]);
+	}
+}
+
+/*
+ * An NFSv3 server. The first four READ requests are held back and then
+ * answered out of order, with the first one cut short.
+ */
+static int sb_nfs_handler(struct udevice *dev, void *packet, unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	u32 *call = (void *)ip + IP_UDP_HDR_SIZE;
+	u32 *args = call + RPC_CALL_HDR + RPC_CRED;
+	u32 words[9] = { call[0], htonl(MSG_REPLY) };
+	u32 prog, proc, offset, count;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP)
+		return sandbox_eth_arp_req_to_reply(dev, packet, len);
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	prog = ntohl(call[3]);
+	proc = ntohl(call[5]);
+	if (prog == PROG_PORTMAP && proc == PORTMAP_GETPORT) {
+		/* The portmapper call has an empty credential */
+		prog = ntohl(call[RPC_CALL_HDR + 4]);
+		words[6] = htonl(prog == PROG_MOUNT ? MOUNT_PORT : NFS_PORT);
+		sb_rpc_reply(dev, packet, words, 7, NULL, 0);
+	} else if (prog == PROG_MOUNT && proc == MOUNT_ADDENTRY) {
+		words[7] = htonl(sizeof(u32));
+		words[8] = htonl(NFS_TEST_FH);
+		sb_rpc_reply(dev, packet, words, 9, NULL, 0);
+	} else if (prog == PROG_MOUNT && proc == MOUNT_UMOUNTALL) {
+		nfs_umounted = true;
+		sb_rpc_reply(dev, packet, words, 6, NULL, 0);
+	} else if (prog == PROG_NFS && proc == NFS3PROC_LOOKUP) {
+		words[7] = htonl(sizeof(u32));
+		words[8] = htonl(NFS_TEST_FH + 1);
+		sb_rpc_reply(dev, packet, words, 9, NULL, 0);
+	} else if (prog == PROG_NFS && proc == NFS_READ) {
+		offset = ntohl(args[3]);
+		count = ntohl(args[4]);
+		if (nfs_num_reads < NFS_MAX_READS) {
+			nfs_read_offsets[nfs_num_reads] = offset;
+			nfs_read_counts[nfs_num_reads] = count;
+		}
+		if (nfs_num_pending < NFS_MAX_READS) {
+			nfs_pending[nfs_num_pending][0] = call[0];
+			nfs_pending[nfs_num_pending][1] = offset;
+			nfs_pending[nfs_num_pending][2] = count;
+			nfs_num_pending++;
+		}
+		if (++nfs_num_reads < CONFIG_NFS_READ_WINDOW)
+			return 0;
+
+		if (nfs_num_reads == CONFIG_NFS_READ_WINDOW) {
+			/* Cut the first one short and keep the third back */
+			sb_nfs_read_reply(dev, packet, nfs_pending[3][0],
+					  nfs_pending[3][1], nfs_pending[3][2]);
+			sb_nfs_read_reply(dev, packet, nfs_pending[1][0],
+					  nfs_pending[1][1], nfs_pending[1][2]);
+			sb_nfs_read_reply(dev, packet, nfs_pending[0][0],
+					  nfs_pending[0][1],
+					  nfs_pending[0][2] / 2);
+			nfs_pending[0][0] = nfs_pending[2][0];
+			nfs_pending[0][1] = nfs_pending[2][1];
+			nfs_pending[0][2] = nfs_pending[2][2];
+			nfs_num_pending = 1;
+			return 0;
+		}
+		sb_nfs_flush(dev, packet);
+	}
+
+	return 0;
+}
+
+/* Several READ requests in flight, answered out of order */
+static int net_test_nfs_read_window(struct unit_test_state *uts)
+{
+	int i;
+
+	/* The fake server expects four requests of NFS_READ_SIZE */
+	if (CONFIG_NFS_READ_WINDOW != 4 ||
+	    CONFIG_NFS_READ_SIZE != NFS_READ_SIZE)
+		return -EAGAIN;
+
+	for (i = 0; i < NFS_FILE_SIZE; i++)
+		nfs_file[i] = i * 3;
+	nfs_num_reads = 0;
+	nfs_num_pending = 0;
+	nfs_umounted = false;
+	sandbox_eth_set_tx_handler(0, sb_nfs_handler);
+	sandbox_eth_set_priv(0, uts);
+
+	env_set("ethact", "eth@10002000");
+	env_set("ethrotate", "no");
+	ut_assertok(run_command("nfs 0x20000 1.1.2.2:/export/image", 0));
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	ut_asserteq(5, nfs_num_reads);
+	for (i = 0; i < 4; i++) {
+		ut_asserteq(i * NFS_READ_SIZE, nfs_read_offsets[i]);
+		ut_asserteq(NFS_READ_SIZE, nfs_read_counts[i]);
+	}
+	/* The rest of the short read is asked for again */
+	ut_asserteq(NFS_READ_SIZE / 2, nfs_read_offsets[4]);
+	ut_asserteq(NFS_READ_SIZE / 2, nfs_read_counts[4]);
+	ut_assert(nfs_umounted);
+	ut_asserteq(NFS_FILE_SIZE, env_get_hex("filesize", 0));
+	ut_asserteq_mem(nfs_file, map_sysmem(0x20000, NFS_FILE_SIZE),
+			NFS_FILE_SIZE);
+
+	return 0;
+}
+LIB_TEST(net_test_nfs_read_window, 0);
@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the tftpboot command
+ */
+
+#include <command.h>
+#include <dm.h>
+#include <env.h>
+#include <mapmem.h>
+#include <net.h>
+#include <asm/eth.h>
+#include <asm/unaligned.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define TFTP_PORT	69
+/* Port the fake server sends from */
+#define TFTP_TID	21313
+#define TFTP_RRQ	1
+#define TFTP_DATA	3
+#define TFTP_ACK	4
+#define TFTP_OACK	6
+#define TFTP_BLKSIZE	512
+
+#define MCAST_GROUP	"239.255.0.1"
+#define MCAST_PORT	1758
+/* Three full blocks and a short one */
+#define MCAST_FILE_SIZE	(3 * TFTP_BLKSIZE + 100)
+#define MCAST_BLOCKS	4
+#define MCAST_MAX_ACKS	8
+
+static u8 mcast_file[MCAST_FILE_SIZE];
+static int mcast_rrqs;
+static int mcast_acks[MCAST_MAX_ACKS];
+static int mcast_num_acks;
+
+/* Queue a UDP packet from the fake server */
+static void sb_udp_reply(struct udevice *dev, void *packet,
+			 struct in_addr dst, int dport, const void *data,
+			 int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_send;
+	struct ip_udp_hdr *ip_send;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth_send = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_send->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_send->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_send->et_protlen = htons(PROT_IP);
+
+	ip_send = (void *)eth_send + ETHER_HDR_SIZE;
+	net_set_udp_header((uchar *)ip_send, dst, dport, TFTP_TID, len);
+	net_copy_ip(&ip_send->ip_src, &ip->ip_dst);
+	ip_send->ip_sum = 0;
+	ip_send->ip_sum = compute_ip_checksum(ip_send, IP_HDR_SIZE);
+	memcpy((void *)ip_send + IP_UDP_HDR_SIZE, data, len);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_UDP_HDR_SIZE + len;
+	++priv->recv_packets;
+}
+
+/* Send a data block to the multicast group */
+static void sb_mcast_block(struct udevice *dev, void *packet, int block)
+{
+	int len = min(MCAST_FILE_SIZE - (block - 1) * TFTP_BLKSIZE,
+		      TFTP_BLKSIZE);
+	u8 buf[4 + TFTP_BLKSIZE];
+
+	put_unaligned_be16(TFTP_DATA, buf);
+	put_unaligned_be16(block, buf + 2);
+	memcpy(buf + 4, mcast_file + (block - 1) * TFTP_BLKSIZE, len);
+	sb_udp_reply(dev, packet, string_to_ip(MCAST_GROUP), MCAST_PORT, buf,
+		     4 + len);
+}
+
+/* Send an OACK with a multicast option */
+static void sb_mcast_oack(struct udevice *dev, void *packet, const char *val)
+{
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	u8 buf[64];
+	int len;
+
+	put_unaligned_be16(TFTP_OACK, buf);
+	len = 2 + sprintf((char *)buf + 2, "multicast%c%s", 0, val) + 1;
+	sb_udp_reply(dev, packet, net_read_ip(&ip->ip_src),
+		     ntohs(ip->udp_src), buf, len);
+}
+
+/*
+ * An RFC2090 server. The first request makes us a listener and we hear
+ * blocks 1 and 3. Asking again makes us the master client, to fetch the rest.
+ */
+static int sb_mcast_handler(struct udevice *dev, void *packet,
+			    unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	u8 *tftp = (void *)ip + IP_UDP_HDR_SIZE;
+	int end = len - ETHER_HDR_SIZE - IP_UDP_HDR_SIZE;
+	int block, i;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP)
+		return sandbox_eth_arp_req_to_reply(dev, packet, len);
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_UDP)
+		return 0;
+
+	if (ntohs(ip->udp_dst) == TFTP_PORT &&
+	    get_unaligned_be16(tftp) == TFTP_RRQ) {
+		bool mcast = false;
+
+		for (i = 2; i < end; i += strlen((char *)tftp + i) + 1)
+			if (!strcmp((char *)tftp + i, "multicast"))
+				mcast = true;
+		if (!mcast)
+			return 0;
+
+		if (!mcast_rrqs++) {
+			sb_mcast_oack(dev, packet, MCAST_GROUP ",1758,0");
+			sb_mcast_block(dev, packet, 1);
+			sb_mcast_block(dev, packet, 3);
+		} else {
+			sb_mcast_oack(dev, packet, ",,1");
+		}
+	} else if (ntohs(ip->udp_dst) == TFTP_TID &&
+		   get_unaligned_be16(tftp) == TFTP_ACK) {
+		block = get_unaligned_be16(tftp + 2);
+		if (mcast_num_acks < MCAST_MAX_ACKS)
+			mcast_acks[mcast_num_acks++] = block;
+		if (block < MCAST_BLOCKS)
+			sb_mcast_block(dev, packet, block + 1);
+	}
+
+	return 0;
+}
+
+/* Blocks missed while listening are fetched once we are master client */
+static int net_test_tftp_multicast(struct unit_test_state *uts)
+{
+	int i;
+
+	for (i = 0; i < MCAST_FILE_SIZE; i++)
+		mcast_file[i] = i * 7;
+	mcast_rrqs = 0;
+	mcast_num_acks = 0;
+	sandbox_eth_set_tx_handler(0, sb_mcast_handler);
+	sandbox_eth_set_priv(0, uts);
+
+	env_set("ethact", "eth@10002000");
+	env_set("ethrotate", "no");
+	env_set("tftptimeout", "1000");
+	ut_assertok(run_command("tftpboot 0x20000 1.1.2.2:image", 0));
+	env_set("tftptimeout", NULL);
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	ut_asserteq(2, mcast_rrqs);
+	ut_asserteq(3, mcast_num_acks);
+	ut_asserteq(1, mcast_acks[0]);
+	ut_asserteq(3, mcast_acks[1]);
+	ut_asserteq(MCAST_BLOCKS, mcast_acks[2]);
+	ut_asserteq(MCAST_FILE_SIZE, env_get_hex("filesize", 0));
+	ut_asserteq_mem(mcast_file, map_sysmem(0x20000, MCAST_FILE_SIZE),
+			MCAST_FILE_SIZE);
+	ut_asserteq(0, net_mcast_addr.s_addr);
+
+	return 0;
+}
+LIB_TEST(net_test_tftp_multicast, 0);
@@ -12,10 +12,13 @@
 #include <fdtdec.h>
 #include <log.h>
 #include <malloc.h>
+#include <mapmem.h>
 #include <net.h>
 #include <net/tcp.h>
 #include <net/wget.h>
+#include <vsprintf.h>
 #include <asm/eth.h>
+#include <asm/unaligned.h>
 #include <dm/test.h>
 #include <dm/device-internal.h>
 #include <dm/uclass-internal.h>
@@ -25,6 +28,7 @@
 
 #define SHIFT_TO_TCPHDRLEN_FIELD(x) ((x) << 4)
 #define LEN_B_TO_DW(x) ((x) >> 2)
+#define GET_TCP_HDR_LEN_IN_BYTES(x) ((x) >> 2)
 
 int net_set_ack_options(union tcp_build_pkt *b);
 
@@ -204,6 +208,208 @@ static int sb_http_handler(struct udevice *dev, void *packet,
 	return -EPROTONOSUPPORT;
 }
 
+/* Queue a TCP segment from the fake server in reply to @tcp */
+static void sb_tcp_reply(struct udevice *dev, void *packet, u32 seq, u32 ack,
+			 u8 flags, const void *data, int payload_len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *tcp = packet + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_send;
+	struct ip_tcp_hdr *tcp_send;
+	int pkt_len = IP_TCP_HDR_SIZE + payload_len;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth_send = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_send->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_send->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_send->et_protlen = htons(PROT_IP);
+	tcp_send = (void *)eth_send + ETHER_HDR_SIZE;
+	tcp_send->tcp_src = tcp->tcp_dst;
+	tcp_send->tcp_dst = tcp->tcp_src;
+	tcp_send->tcp_seq = htonl(seq);
+	tcp_send->tcp_ack = htonl(ack);
+	memcpy((void *)tcp_send + IP_TCP_HDR_SIZE, data, payload_len);
+	tcp_send->tcp_hlen = SHIFT_TO_TCPHDRLEN_FIELD(LEN_B_TO_DW(TCP_HDR_SIZE));
+	tcp_send->tcp_flags = flags;
+	tcp_send->tcp_win = htons(PKTBUFSRX * TCP_MSS >> TCP_SCALE);
+	tcp_send->tcp_xsum = 0;
+	tcp_send->tcp_ugr = 0;
+	tcp_send->tcp_xsum = tcp_set_pseudo_header((uchar *)tcp_send,
+						   tcp->ip_src, tcp->ip_dst,
+						   pkt_len - IP_HDR_SIZE,
+						   pkt_len);
+	net_set_ip_header((uchar *)tcp_send, tcp->ip_src, tcp->ip_dst,
+			  pkt_len, IPPROTO_TCP);
+
+	priv->recv_packet_length[priv->recv_packets] = ETHER_HDR_SIZE + pkt_len;
+	++priv->recv_packets;
+}
+
+static const char ooo_payload[] = "HTTP/1.1 200 OK\r\n"
+	"Content-Length: 30\r\n\r\n\r\n"
+	"<html><body>Hi</body></html>\r\n";
+#define OOO_PART	10
+
+/* Sequence number following the reply sent by sb_ooo_ack_handler() */
+static u32 ooo_end_seq;
+/* First SACK block received, if any */
+static struct sack_edges ooo_sack;
+
+/* Find the first SACK block in an ACK */
+static void sb_find_sack(struct ip_tcp_hdr *tcp, int hdr_len)
+{
+	u8 *opt = (u8 *)tcp + IP_TCP_HDR_SIZE;
+	u8 *end = (u8 *)tcp + IP_HDR_SIZE + hdr_len;
+
+	while (opt + 1 < end && *opt != TCP_O_END) {
+		if (*opt == TCP_1_NOP) {
+			opt++;
+			continue;
+		}
+		if (*opt == TCP_V_SACK && opt[1] >= 10) {
+			ooo_sack.l = get_unaligned_be32(opt + 2);
+			ooo_sack.r = get_unaligned_be32(opt + 6);
+			return;
+		}
+		if (opt[1] < 2)
+			return;
+		opt += opt[1];
+	}
+}
+
+/* Send the reply in three segments, the middle one last */
+static int sb_ooo_ack_handler(struct udevice *dev, void *packet,
+			      unsigned int len)
+{
+	struct ip_tcp_hdr *tcp = packet + ETHER_HDR_SIZE;
+	const char *payload = ooo_payload;
+	const int total = strlen(payload), part = OOO_PART;
+	int hdr_len = GET_TCP_HDR_LEN_IN_BYTES(tcp->tcp_hlen);
+	int recv_payload_len = len - ETHER_HDR_SIZE - IP_HDR_SIZE - hdr_len;
+	u32 seq = ntohl(tcp->tcp_seq);
+	u32 ack = ntohl(tcp->tcp_ack);
+
+	if (seq == 1 && ack == 1 && !recv_payload_len)
+		return 0;	/* ACK for three-way handshaking */
+
+	if (recv_payload_len) {
+		/* HTTP request */
+		seq += recv_payload_len;
+		sb_tcp_reply(dev, packet, 1, seq, TCP_ACK, payload,
+			     total - 2 * part);
+		sb_tcp_reply(dev, packet, 1 + total - part, seq, TCP_ACK,
+			     payload + total - part, part);
+		sb_tcp_reply(dev, packet, 1 + total - 2 * part, seq, TCP_ACK,
+			     payload + total - 2 * part, part);
+		ooo_end_seq = 1 + total;
+	} else if ((s32)(ack - ooo_end_seq) < 0) {
+		/* Not everything received yet */
+		sb_find_sack(tcp, hdr_len);
+	} else {
+		/* close connection */
+		sb_tcp_reply(dev, packet, ack, seq + 1, TCP_ACK | TCP_FIN,
+			     NULL, 0);
+	}
+
+	return 0;
+}
+
+static int sb_ooo_http_handler(struct udevice *dev, void *packet,
+			       unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *tcp = packet + ETHER_HDR_SIZE;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP)
+		return sb_arp_handler(dev, packet, len);
+	if (ntohs(eth->et_protlen) != PROT_IP || tcp->ip_p != IPPROTO_TCP)
+		return -EPROTONOSUPPORT;
+	if (tcp->tcp_flags == TCP_SYN)
+		return sb_syn_handler(dev, packet, len);
+	if (tcp->tcp_flags & TCP_ACK && !(tcp->tcp_flags & TCP_SYN))
+		return sb_ooo_ack_handler(dev, packet, len);
+
+	return 0;
+}
+
+static const char ka_body[] = "0123456789abcdef";
+
+/* Next sequence number of the keep-alive server */
+static u32 ka_seq;
+/* Number of connections opened to the keep-alive server */
+static int ka_syns;
+/* Last request received by the keep-alive server */
+static char ka_request[256];
+
+/*
+ * Answer each request with a reply that leaves the connection open, except
+ * for a request for /close
+ */
+static int sb_ka_http_handler(struct udevice *dev, void *packet,
+			      unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *tcp = packet + ETHER_HDR_SIZE;
+	int hdr_len, recv_payload_len;
+	ulong start = 0, end = sizeof(ka_body) - 2;
+	char reply[256];
+	char *range;
+	bool close;
+	int reply_len;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP)
+		return sb_arp_handler(dev, packet, len);
+	if (ntohs(eth->et_protlen) != PROT_IP || tcp->ip_p != IPPROTO_TCP)
+		return 0;
+
+	if (tcp->tcp_flags == TCP_SYN) {
+		ka_syns++;
+		ka_seq = 1;
+		return sb_syn_handler(dev, packet, len);
+	}
+
+	hdr_len = GET_TCP_HDR_LEN_IN_BYTES(tcp->tcp_hlen);
+	recv_payload_len = len - ETHER_HDR_SIZE - IP_HDR_SIZE - hdr_len;
+	if (tcp->tcp_flags & TCP_FIN) {
+		sb_tcp_reply(dev, packet, ka_seq, ntohl(tcp->tcp_seq) + 1,
+			     TCP_ACK, NULL, 0);
+		return 0;
+	}
+	if (!recv_payload_len)
+		return 0;
+
+	strlcpy(ka_request, (char *)tcp + IP_HDR_SIZE + hdr_len,
+		min((int)sizeof(ka_request), recv_payload_len + 1));
+	range = strstr(ka_request, "Range: bytes=");
+	if (range) {
+		start = simple_strtoul(range + 13, &range, 10);
+		end = simple_strtoul(range + 1, NULL, 10);
+	}
+	close = strstr(ka_request, "GET /close ");
+	reply_len = sprintf(reply, "HTTP/1.1 %s\r\n"
+			    "Content-Length: %lu\r\n"
+			    "Connection: %s\r\n\r\n%.*s",
+			    range ? "206 Partial Content" : "200 OK",
+			    end - start + 1, close ? "close" : "keep-alive",
+			    (int)(end - start + 1), ka_body + start);
+	sb_tcp_reply(dev, packet, ka_seq,
+		     ntohl(tcp->tcp_seq) + recv_payload_len,
+		     TCP_ACK | TCP_PUSH, reply, reply_len);
+	ka_seq += reply_len;
+	if (close) {
+		sb_tcp_reply(dev, packet, ka_seq,
+			     ntohl(tcp->tcp_seq) + recv_payload_len,
+			     TCP_ACK | TCP_FIN, NULL, 0);
+		ka_seq++;
+	}
+
+	return 0;
+}
+
 static int net_test_wget(struct unit_test_state *uts)
 {
 	sandbox_eth_set_tx_handler(0, sb_http_handler);
@@ -226,3 +432,135 @@ static int net_test_wget(struct unit_test_state *uts)
 	return 0;
 }
 LIB_TEST(net_test_wget, UTF_CONSOLE);
+
+/* Check what the stack leaves to a MAC with checksum offload */
+static int sb_csum_http_handler(struct udevice *dev, void *packet,
+				unsigned int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct unit_test_state *uts = priv->priv;
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *tcp = packet + ETHER_HDR_SIZE;
+	int first = priv->recv_packets;
+	int ret, i;
+
+	/* The TCP checksum is left for the MAC to insert */
+	if (ntohs(eth->et_protlen) == PROT_IP && tcp->ip_p == IPPROTO_TCP)
+		ut_asserteq(0, tcp->tcp_xsum);
+
+	ret = sb_http_handler(dev, packet, len);
+
+	/* The MAC checked the replies, so a bad checksum is not noticed */
+	for (i = first; i < priv->recv_packets; i++) {
+		eth = (void *)priv->recv_packet_buffer[i];
+		tcp = (void *)eth + ETHER_HDR_SIZE;
+		if (ntohs(eth->et_protlen) == PROT_IP &&
+		    tcp->ip_p == IPPROTO_TCP)
+			tcp->tcp_xsum = ~tcp->tcp_xsum;
+	}
+
+	return ret;
+}
+
+static int net_test_wget_csum_offload(struct unit_test_state *uts)
+{
+	sandbox_eth_set_tx_handler(0, sb_csum_http_handler);
+	sandbox_eth_set_priv(0, uts);
+	sandbox_eth_set_csum_offload(0, ETH_CSUM_RX | ETH_CSUM_TX);
+
+	env_set("ethact", "eth@10002000");
+	env_set("ethrotate", "no");
+	env_set("loadaddr", "0x20000");
+	ut_assertok(run_command("wget ${loadaddr} 1.1.2.2:/index.html", 0));
+	ut_assert_nextline("HTTP/1.1 200 OK");
+	ut_assert_nextline("Packets received 5, Transfer Successful");
+	ut_assert_nextline("Bytes transferred = 32 (20 hex)");
+
+	sandbox_eth_set_csum_offload(0, 0);
+	sandbox_eth_set_tx_handler(0, NULL);
+	ut_assert_console_end();
+
+	return 0;
+}
+LIB_TEST(net_test_wget_csum_offload, UTF_CONSOLE);
+
+/* Data arriving out of order is stored in place and SACKed */
+static int net_test_wget_out_of_order(struct unit_test_state *uts)
+{
+	const int total = strlen(ooo_payload), part = OOO_PART;
+
+	memset(&ooo_sack, '\0', sizeof(ooo_sack));
+	sandbox_eth_set_tx_handler(0, sb_ooo_http_handler);
+	sandbox_eth_set_priv(0, uts);
+
+	env_set("ethact", "eth@10002000");
+	env_set("ethrotate", "no");
+	env_set("loadaddr", "0x20000");
+	ut_assertok(run_command("wget ${loadaddr} 1.1.2.2:/index.html", 0));
+	ut_assert_nextline("HTTP/1.1 200 OK");
+	ut_assert_nextline("Packets received 6, Transfer Successful");
+	ut_assert_nextline("Bytes transferred = 32 (20 hex)");
+
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	if (IS_ENABLED(CONFIG_PROT_TCP_SACK)) {
+		ut_asserteq(1 + total - part, ooo_sack.l);
+		ut_asserteq(1 + total, ooo_sack.r);
+	}
+
+	run_command("md5sum ${loadaddr} ${filesize}", 0);
+	ut_assert_nextline("md5 for 00020000 ... 0002001f ==> 234af48e94b0085060249ecb5942ab57");
+	ut_assert_console_end();
+
+	return 0;
+}
+LIB_TEST(net_test_wget_out_of_order, UTF_CONSOLE);
+
+/* A connection left open by the server is used for the next request */
+static int net_test_wget_keep_alive(struct unit_test_state *uts)
+{
+	ka_syns = 0;
+	sandbox_eth_set_tx_handler(0, sb_ka_http_handler);
+	sandbox_eth_set_priv(0, uts);
+
+	env_set("ethact", "eth@10002000");
+	env_set("ethrotate", "no");
+	env_set("loadaddr", "0x20000");
+	ut_assertok(run_command("wget ${loadaddr} 1.1.2.2:/data.bin", 0));
+	ut_assert_nextline("HTTP/1.1 200 OK");
+	ut_assert_nextline("Packets received 2, Transfer Successful");
+	ut_assert_nextline("Bytes transferred = 16 (10 hex)");
+	ut_assertnull(strstr(ka_request, "Range:"));
+
+	/* Fetch part of the file over the same connection */
+	ut_assertok(run_command("wget 0x30000 1.1.2.2:/data.bin 2 4", 0));
+	ut_assert_nextline("HTTP/1.1 206 Partial Content");
+	ut_assert_nextline("Packets received 1, Transfer Successful");
+	ut_assert_nextline("Bytes transferred = 4 (4 hex)");
+	ut_asserteq(1, ka_syns);
+	ut_assertnonnull(strstr(ka_request, "Range: bytes=2-5\r\n"));
+	ut_assertnonnull(strstr(ka_request, "Connection: keep-alive\r\n"));
+	ut_asserteq(4, env_get_hex("filesize", 0));
+	ut_asserteq_mem(ka_body + 2, map_sysmem(0x30000, 4), 4);
+	ut_asserteq_mem(ka_body, map_sysmem(0x20000, 16), 16);
+
+	/* The server closes the connection after this one */
+	ut_assertok(run_command("wget ${loadaddr} 1.1.2.2:/close", 0));
+	ut_assert_nextline("HTTP/1.1 200 OK");
+	ut_assert_nextline("Packets received 3, Transfer Successful");
+	ut_assert_nextline("Bytes transferred = 16 (10 hex)");
+	ut_asserteq(1, ka_syns);
+
+	/* So the next request opens a new one */
+	ut_assertok(run_command("wget ${loadaddr} 1.1.2.2:/close", 0));
+	ut_assert_nextline("HTTP/1.1 200 OK");
+	ut_assert_nextline("Packets received 4, Transfer Successful");
+	ut_assert_nextline("Bytes transferred = 16 (10 hex)");
+	ut_asserteq(2, ka_syns);
+
+	sandbox_eth_set_tx_handler(0, NULL);
+	ut_assert_console_end();
+
+	return 0;
+}
+LIB_TEST(net_test_wget_keep_alive, UTF_CONSOLE);
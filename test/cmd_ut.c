@@ -130,6 +130,9 @@ static struct cmd_tbl cmd_ut_sub[] = {
 #ifdef CONFIG_CMD_PCI_MPS
 	U_BOOT_CMD_MKENT(pci_mps, CONFIG_SYS_MAXARGS, 1, do_ut_pci_mps, "", ""),
 #endif
+#ifdef CONFIG_UT_PERF
+	U_BOOT_CMD_MKENT(perf, CONFIG_SYS_MAXARGS, 1, do_ut_perf, "", ""),
+#endif
 #ifdef CONFIG_CMD_SEAMA
 	U_BOOT_CMD_MKENT(seama, CONFIG_SYS_MAXARGS, 1, do_ut_seama, "", ""),
 #endif
@@ -243,6 +246,9 @@ U_BOOT_LONGHELP(ut,
 #endif
 #ifdef CONFIG_CMD_PCI_MPS
 	"\npci_mps - PCI Express Maximum Payload Size"
+#endif
+#ifdef CONFIG_UT_PERF
+	"\nperf - throughput benchmarks"
 #endif
 	"\nprint  - printing things to the console"
 	"\nsetexpr - setexpr command"
@@ -0,0 +1,60 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for bootstage spans
+ */
+
+#include <bootstage.h>
+#include <malloc.h>
+#include <asm/global_data.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Test that spans nest and are exported in Chrome trace format */
+static int bootstage_test_spans(struct unit_test_state *uts)
+{
+	struct bootstage_data *old = gd->bootstage;
+	int outer, inner, next, len;
+	char buf[1024];
+
+	/* Use fresh data, since boot may have filled the span table */
+	ut_assertok(bootstage_init(false));
+
+	outer = bootstage_span_begin(BOOTSTAGE_SPAN_USER, "outer", 0);
+	ut_asserteq(0, outer);
+	inner = bootstage_span_begin(BOOTSTAGE_SPAN_INITCALL, NULL, 0x1234);
+	ut_asserteq(1, inner);
+	bootstage_span_end(inner);
+	bootstage_span_end(outer);
+	next = bootstage_span_begin(BOOTSTAGE_SPAN_PROBE, "next", 0);
+	ut_asserteq(2, next);
+	bootstage_span_end(next);
+
+	/* Ending an unrecorded span does nothing */
+	bootstage_span_end(-ENOSPC);
+
+	len = bootstage_export_json(NULL, 0);
+	ut_asserteq(len, bootstage_export_json(buf, sizeof(buf)));
+	ut_assert(len < sizeof(buf));
+	ut_asserteq(len, strlen(buf));
+	ut_assert(!strncmp("{\"traceEvents\":[", buf, 16));
+	ut_assertnonnull(strstr(buf, "{\"name\":\"outer\",\"cat\":\"user\","
+				"\"ph\":\"X\""));
+	ut_assertnonnull(strstr(buf, "\"args\":{\"span\":0,\"parent\":-1}}"));
+	ut_assertnonnull(strstr(buf, "{\"name\":\"0x1234\",\"cat\":\"initcall\","));
+	ut_assertnonnull(strstr(buf, "\"args\":{\"span\":1,\"parent\":0}}"));
+	ut_assertnonnull(strstr(buf, "{\"name\":\"next\",\"cat\":\"probe\","));
+	ut_assertnonnull(strstr(buf, "\"args\":{\"span\":2,\"parent\":-1}}"));
+
+	/* A short buffer is truncated but still terminated */
+	ut_asserteq(len, bootstage_export_json(buf, 10));
+	ut_asserteq(9, strlen(buf));
+
+	free(gd->bootstage);
+	gd->bootstage = old;
+
+	return 0;
+}
+COMMON_TEST(bootstage_test_spans, 0);
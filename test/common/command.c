@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Test for looking up commands with the sorted index
+ */
+
+#include <command.h>
+#include <linker_lists.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <vsprintf.h>
+
+/* Check that the index finds the same command as a search of the table */
+static int common_test_cmd_index(struct unit_test_state *uts)
+{
+	struct cmd_tbl *start = ll_entry_start(struct cmd_tbl, cmd);
+	const int count = ll_entry_count(struct cmd_tbl, cmd);
+	char name[40];
+	int i, len;
+
+	for (i = 0; i < count; i++) {
+		const char *cmd = start[i].name;
+
+		/* Every abbreviation, which may be ambiguous or not */
+		for (len = 1; len <= strlen(cmd) && len < sizeof(name); len++) {
+			strlcpy(name, cmd, len + 1);
+			ut_asserteq_ptr(find_cmd_tbl(name, start, count),
+					find_cmd(name));
+		}
+
+		/* With a size suffix */
+		snprintf(name, sizeof(name), "%s.b", cmd);
+		ut_asserteq_ptr(find_cmd_tbl(name, start, count),
+				find_cmd(name));
+	}
+	ut_assertnull(find_cmd("no-such-command"));
+	ut_assertnull(find_cmd(""));
+
+	return 0;
+}
+COMMON_TEST(common_test_cmd_index, 0);
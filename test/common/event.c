@@ -6,8 +6,10 @@
  * Written by Simon Glass <sjg@chromium.org>
  */
 
+#include <command.h>
 #include <dm.h>
 #include <event.h>
+#include <event_stats.h>
 #include <test/common.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -107,3 +109,42 @@ static int test_event_probe(struct unit_test_state *uts)
 	return 0;
 }
 COMMON_TEST(test_event_probe, UTF_DM | UTF_SCAN_FDT);
+
+/* Check that events and probes are counted */
+static int test_event_stats(struct unit_test_state *uts)
+{
+	struct event_stats *stats;
+	struct udevice *dev;
+	int idx;
+
+	if (!CONFIG_IS_ENABLED(EVENT_STATS))
+		return -EAGAIN;
+
+	event_stats_reset();
+	ut_assertok(event_notify_null(EVT_TEST));
+	stats = event_stats_get();
+	ut_assertnonnull(stats);
+	ut_asserteq(1, stats->event[EVT_TEST].count);
+
+	ut_assertok(uclass_first_device_err(UCLASS_TEST_FDT, &dev));
+	ut_asserteq(1, stats->uclass[UCLASS_TEST_FDT].count);
+	idx = dev->driver - ll_entry_start(struct driver, driver);
+	ut_asserteq(1, stats->driver[idx].count);
+	ut_assert(stats->event[EVT_DM_POST_PROBE].count >= 1);
+
+	/* A device which is already active is not counted again */
+	ut_assertok(device_probe(dev));
+	ut_asserteq(1, stats->driver[idx].count);
+
+	ut_assertok(run_command("perf show", 0));
+	ut_assert_nextline("Event                         Count    Time (us)");
+	ut_assert_skip_to_line("Uclass                        Count    Time (us)");
+	ut_assert_skip_to_line("Driver                        Count    Time (us)");
+
+	event_stats_reset();
+	ut_asserteq(0, stats->event[EVT_TEST].count);
+	ut_asserteq(0, stats->uclass[UCLASS_TEST_FDT].count);
+
+	return 0;
+}
+COMMON_TEST(test_event_stats, UTF_DM | UTF_SCAN_FDT | UTF_CONSOLE);
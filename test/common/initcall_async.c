@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for asynchronous initcalls
+ */
+
+#include <initcall.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/errno.h>
+
+/* These are started by board_init_r(), so record what happens from then */
+static struct async_test {
+	int slow_polls;
+	int slow_done;
+	bool after_started;
+	bool after_saw_slow_done;
+	bool dep_fail_started;
+} async_test;
+
+static int slow_start(void)
+{
+	async_test.slow_polls = 0;
+
+	return 0;
+}
+
+static int slow_poll(void)
+{
+	if (++async_test.slow_polls < 3)
+		return -EAGAIN;
+	async_test.slow_done = 1;
+
+	return 0;
+}
+INITCALL_ASYNC(test_slow, NULL, slow_start, slow_poll);
+
+static int after_start(void)
+{
+	async_test.after_started = true;
+	async_test.after_saw_slow_done = async_test.slow_done;
+
+	return 0;
+}
+INITCALL_ASYNC(test_after, "test_slow", after_start, NULL);
+
+static int fail_start(void)
+{
+	return -EIO;
+}
+INITCALL_ASYNC(test_fail, NULL, fail_start, NULL);
+
+static int dep_fail_start(void)
+{
+	async_test.dep_fail_started = true;
+
+	return 0;
+}
+INITCALL_ASYNC(test_dep_fail, "test_fail", dep_fail_start, NULL);
+
+/* Test that async initcalls complete in order, with their results */
+static int common_test_initcall_async(struct unit_test_state *uts)
+{
+	ut_assertok(initcall_async_join("test_after"));
+	ut_assert(async_test.after_started);
+	ut_assert(async_test.after_saw_slow_done);
+	ut_assertok(initcall_async_join("test_slow"));
+	ut_asserteq(3, async_test.slow_polls);
+
+	ut_asserteq(-EIO, initcall_async_join("test_fail"));
+	ut_asserteq(-ENODEV, initcall_async_join("test_dep_fail"));
+	ut_assert(!async_test.dep_fail_started);
+
+	ut_asserteq(-ENOENT, initcall_async_join("nonexistent"));
+
+	/* Entries are in name order, so test_dep_fail comes first */
+	ut_asserteq(-ENODEV, initcall_async_join_all());
+
+	return 0;
+}
+COMMON_TEST(common_test_initcall_async, 0);
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the malloc() size classes and profile
+ */
+
+#include <malloc.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/errno.h>
+
+/* Bytes added to each allocation for its header with SYS_MALLOC_PROFILE */
+#define PROF_HDR_SIZE	\
+	(CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE) ? 2 * sizeof(size_t) : 0)
+
+/* Get the statistics for the class holding @size-byte allocations */
+static void get_stats(int size, struct malloc_class_stats *cs)
+{
+	struct malloc_class_stats stats[MALLOC_NUM_CLASSES];
+	int i, count;
+
+	size += PROF_HDR_SIZE;
+	count = malloc_get_class_stats(stats, MALLOC_NUM_CLASSES);
+	for (i = 0; i < count; i++) {
+		if (size <= stats[i].size) {
+			*cs = stats[i];
+			return;
+		}
+	}
+}
+
+/* Test that freed small chunks are reused */
+static int common_test_malloc_class(struct unit_test_state *uts)
+{
+	struct malloc_class_stats before, after;
+	void *ptr, *ptr2;
+
+	get_stats(20, &before);
+	ptr = malloc(20);
+	ut_assertnonnull(ptr);
+	free(ptr);
+
+	/* Any size in the same class gets the same chunk back */
+	ptr2 = malloc(32);
+	ut_asserteq_ptr(ptr, ptr2);
+	get_stats(20, &after);
+	ut_asserteq(before.hits + 1, after.hits);
+	ut_asserteq(before.frees + 1, after.frees);
+	ut_asserteq(before.count, after.count);
+
+	/* calloc() must clear a reused chunk */
+	memset(ptr2, '\xff', 32);
+	free(ptr2);
+	ptr = calloc(1, 24);
+	ut_asserteq_ptr(ptr2, ptr);
+	ut_assertnull(memchr_inv(ptr, 0, 24));
+	free(ptr);
+
+	/* Larger allocations do not use the lists */
+	get_stats(256 - PROF_HDR_SIZE, &before);
+	ptr = malloc(300);
+	ut_assertnonnull(ptr);
+	free(ptr);
+	get_stats(256 - PROF_HDR_SIZE, &after);
+	ut_asserteq(before.frees, after.frees);
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_class, 0);
+
+/* Test that the lists are limited and can be flushed */
+static int common_test_malloc_class_limit(struct unit_test_state *uts)
+{
+	const int extra = 5;
+	struct malloc_class_stats before, after;
+	void *ptrs[CONFIG_SYS_MALLOC_CLASS_LIMIT + extra];
+	int i;
+
+	ut_assert(malloc_class_flush() >= 0);
+	get_stats(100, &before);
+	ut_asserteq(0, before.count);
+
+	for (i = 0; i < ARRAY_SIZE(ptrs); i++) {
+		ptrs[i] = malloc(100);
+		ut_assertnonnull(ptrs[i]);
+	}
+	for (i = 0; i < ARRAY_SIZE(ptrs); i++)
+		free(ptrs[i]);
+	get_stats(100, &after);
+	ut_asserteq(CONFIG_SYS_MALLOC_CLASS_LIMIT, after.count);
+	ut_asserteq(before.spills + extra, after.spills);
+
+	ut_assert(malloc_class_flush() >= CONFIG_SYS_MALLOC_CLASS_LIMIT);
+	get_stats(100, &after);
+	ut_asserteq(0, after.count);
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_class_limit, 0);
+
+/* Find the profile entry for a call site with @count allocations of @size */
+static const struct malloc_prof_site *find_site(ulong count, ulong size)
+{
+	const struct malloc_prof *prof = malloc_prof_get();
+	int i;
+
+	for (i = 0; i < prof->num_sites; i++) {
+		const struct malloc_prof_site *site = &prof->sites[i];
+
+		if (site->caller && site->count == count &&
+		    site->live == count * size)
+			return site;
+	}
+
+	return NULL;
+}
+
+/* Test that allocations are recorded against their call site */
+static int common_test_malloc_prof(struct unit_test_state *uts)
+{
+	const struct malloc_prof *prof = malloc_prof_get();
+	const struct malloc_prof_site *site;
+	const ulong size = 0x1235;
+	ulong live, total;
+	void *ptrs[3];
+	void *ptr;
+	int i;
+
+	if (!CONFIG_IS_ENABLED(SYS_MALLOC_PROFILE))
+		return -EAGAIN;
+	live = prof->live;
+	for (i = 0; i < ARRAY_SIZE(ptrs); i++) {
+		ptrs[i] = malloc(size);
+		ut_assertnonnull(ptrs[i]);
+	}
+	ut_asserteq(live + ARRAY_SIZE(ptrs) * size, prof->live);
+	ut_assert(prof->peak >= prof->live);
+	ut_assert(prof->early_peak > 0);
+
+	site = find_site(ARRAY_SIZE(ptrs), size);
+	ut_assertnonnull(site);
+	ut_assert(site->total >= ARRAY_SIZE(ptrs));
+	total = site->total;
+	free(ptrs[0]);
+	ut_asserteq((ARRAY_SIZE(ptrs) - 1) * size, site->live);
+	ut_asserteq(ARRAY_SIZE(ptrs) * size, site->peak);
+
+	/* realloc() moves the allocation to the caller of realloc() */
+	ptrs[1] = realloc(ptrs[1], size * 2);
+	ut_assertnonnull(ptrs[1]);
+	ut_asserteq(size, site->live);
+	ut_asserteq(total, site->total);
+	ut_asserteq(1, site->count);
+
+	/* Aligned allocations keep their alignment and can be resized */
+	ptr = memalign(0x1000, size);
+	ut_assertnonnull(ptr);
+	ut_asserteq(0, (ulong)ptr & 0xfff);
+	ut_assert(malloc_usable_size(ptr) >= size);
+	memset(ptr, '\xa5', size);
+	ptr = realloc(ptr, size * 2);
+	ut_assertnonnull(ptr);
+	ut_assertnull(memchr_inv(ptr, 0xa5, size));
+	free(ptr);
+
+	free(ptrs[1]);
+	free(ptrs[2]);
+	ut_asserteq(live, prof->live);
+
+	return 0;
+}
+COMMON_TEST(common_test_malloc_prof, 0);
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for cooperative tasks
+ */
+
+#include <task.h>
+#include <test/common.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <linux/errno.h>
+
+#define TEST_STEPS	3
+
+static struct task_test {
+	struct task task[3];
+	char order[2 * TEST_STEPS + 1];
+	int pos;
+	int self_join;
+} task_test;
+
+static int step_func(void *arg)
+{
+	char id = (ulong)arg;
+	int i;
+
+	for (i = 0; i < TEST_STEPS; i++) {
+		task_test.order[task_test.pos++] = id;
+		schedule();
+	}
+
+	return id;
+}
+
+static int join_func(void *arg)
+{
+	task_test.self_join = task_join(task_current());
+
+	/* Wait for the first task from inside a task */
+	return task_join(&task_test.task[0]);
+}
+
+/* Test that tasks run in turn, each until it calls schedule() */
+static int common_test_task(struct unit_test_state *uts)
+{
+	memset(&task_test, '\0', sizeof(task_test));
+	ut_assertnull(task_current());
+	ut_assertok(task_start(&task_test.task[0], "a", step_func, (void *)'a',
+			       0));
+	ut_assertok(task_start(&task_test.task[1], "b", step_func, (void *)'b',
+			       0));
+	ut_assertok(task_start(&task_test.task[2], "join", join_func, NULL,
+			       0));
+
+	/* Nothing runs until schedule() is called */
+	ut_asserteq(0, task_test.pos);
+	schedule();
+	ut_asserteq_str("ab", task_test.order);
+
+	ut_asserteq('b', task_join(&task_test.task[1]));
+	ut_asserteq_str("ababab", task_test.order);
+	ut_assert(task_test.task[0].done);
+	ut_asserteq('a', task_join(&task_test.task[0]));
+	ut_asserteq('a', task_join(&task_test.task[2]));
+	ut_asserteq(-EDEADLK, task_test.self_join);
+	ut_assertnull(task_test.task[2].stack);
+
+	return 0;
+}
+COMMON_TEST(common_test_task, 0);
@@ -4,14 +4,19 @@
  */
 
 #include <abuf.h>
+#include <blk.h>
+#include <blkmap.h>
 #include <bootm.h>
 #include <command.h>
+#include <dm.h>
 #include <gzip.h>
 #include <image.h>
 #include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <time.h>
 #include <asm/io.h>
+#include <asm/unaligned.h>
 
 #include <u-boot/lz4.h>
 #include <u-boot/zlib.h>
@@ -22,6 +27,7 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/sizes.h>
 #include <linux/zstd.h>
 #include <test/compression.h>
 #include <test/suites.h>
@@ -174,6 +180,29 @@ static int uncompress_using_gzip(struct unit_test_state *uts,
 	return ret;
 }
 
+static int uncompress_using_gzip_stream(struct unit_test_state *uts,
+					void *in, unsigned long in_size,
+					void *out, unsigned long out_max,
+					unsigned long *out_size)
+{
+	struct gunzip_stream *gs;
+	unsigned long pos, size = 0;
+	int ret = 0;
+
+	gs = gunzip_stream_start(out, out_max);
+	ut_assertnonnull(gs);
+
+	/* Feed small pieces to cross the header and block boundaries */
+	for (pos = 0; !ret && pos < in_size; pos += 5)
+		ret = gunzip_stream_feed(gs, in + pos, min(5UL, in_size - pos));
+	if (gunzip_stream_end(gs, &size) && ret >= 0)
+		ret = -EIO;
+	if (out_size)
+		*out_size = size;
+
+	return ret < 0;
+}
+
 static int compress_using_bzip2(struct unit_test_state *uts,
 				void *in, unsigned long in_size,
 				void *out, unsigned long out_max,
@@ -243,6 +272,29 @@ static int uncompress_using_lzma(struct unit_test_state *uts,
 	return (ret != SZ_OK);
 }
 
+static int uncompress_using_lzma_stream(struct unit_test_state *uts,
+					void *in, unsigned long in_size,
+					void *out, unsigned long out_max,
+					unsigned long *out_size)
+{
+	struct lzma_stream *ls;
+	unsigned long pos, size = 0;
+	int ret = 0;
+
+	ls = lzma_stream_start(out, out_max);
+	ut_assertnonnull(ls);
+
+	/* Feed small pieces to split the header and the range coder's input */
+	for (pos = 0; !ret && pos < in_size; pos += 5)
+		ret = lzma_stream_feed(ls, in + pos, min(5UL, in_size - pos));
+	if (lzma_stream_end(ls, &size) && ret >= 0)
+		ret = -EIO;
+	if (out_size)
+		*out_size = size;
+
+	return ret < 0;
+}
+
 static int compress_using_lzo(struct unit_test_state *uts,
 			      void *in, unsigned long in_size,
 			      void *out, unsigned long out_max,
@@ -473,6 +525,102 @@ static int compression_test_gzip(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_gzip, 0);
 
+static int compression_test_gzip_stream(struct unit_test_state *uts)
+{
+	return run_test(uts, "gzip_stream", compress_using_gzip,
+			uncompress_using_gzip_stream);
+}
+COMPRESSION_TEST(compression_test_gzip_stream, 0);
+
+/* Check that gunzip() gives the same result when its state is reused */
+static int compression_test_gzip_reuse(struct unit_test_state *uts)
+{
+	const int plain_size = strlen(plain);
+	ulong gz_size = SZ_1K, size;
+	u8 *gz, *out;
+	int i;
+
+	gz = malloc(gz_size);
+	ut_assertnonnull(gz);
+	out = malloc(plain_size + 1);
+	ut_assertnonnull(out);
+	ut_assertok(gzip(gz, &gz_size, (void *)plain, plain_size));
+
+	for (i = 0; i < 3; i++) {
+		memset(out, '\0', plain_size + 1);
+		size = gz_size;
+		ut_assertok(gunzip(out, plain_size, gz, &size));
+		ut_asserteq(plain_size, size);
+		ut_asserteq_mem(plain, out, plain_size);
+	}
+
+	/* A truncated stream is still caught after a good one */
+	size = gz_size / 2;
+	ut_asserteq(-1, gunzip(out, plain_size, gz, &size));
+
+	free(out);
+	free(gz);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzip_reuse, 0);
+
+/* Number of 512-byte blocks in the device used by the gzwrite test */
+#define GZWRITE_TEST_BLOCKS	16
+
+/* Check writing a gzipped image to a block device, over several writes */
+static int compression_test_gzwrite(struct unit_test_state *uts)
+{
+	const int plain_size = strlen(plain);
+	const int size = 5000, blksz = 512;
+	struct udevice *dev, *blk;
+	struct blk_desc *desc;
+	u8 *data, *gz, *disk;
+	ulong gz_size = SZ_8K;
+	int i;
+
+	if (!IS_ENABLED(CONFIG_CMD_UNZIP) || !IS_ENABLED(CONFIG_BLKMAP))
+		return -EAGAIN;
+
+	data = malloc(size);
+	gz = malloc(gz_size);
+	disk = malloc(GZWRITE_TEST_BLOCKS * blksz);
+	ut_assertnonnull(data);
+	ut_assertnonnull(gz);
+	ut_assertnonnull(disk);
+	for (i = 0; i < size; i++)
+		data[i] = plain[i % plain_size] ^ (i / plain_size);
+	ut_assertok(gzip(gz, &gz_size, data, size));
+	memset(disk, 0xaa, GZWRITE_TEST_BLOCKS * blksz);
+
+	ut_assertok(blkmap_create("gzwrite", &dev));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	ut_assertok(blkmap_map_mem(dev, 0, GZWRITE_TEST_BLOCKS, disk));
+	desc = dev_get_uclass_plat(blk);
+
+	/* Two blocks per write, starting at the second block */
+	ut_assertok(gzwrite(gz, gz_size, desc, 2 * blksz, blksz, 0));
+	ut_asserteq(0xaa, disk[blksz - 1]);
+	ut_asserteq_mem(data, disk + blksz, size);
+
+	/* The rest of the last block is zeroed, the next one is untouched */
+	ut_asserteq(0, disk[blksz + size]);
+	ut_asserteq(0, disk[blksz * 11 - 1]);
+	ut_asserteq(0xaa, disk[blksz * 11]);
+
+	/* Not enough room on the device, or the wrong expected size */
+	ut_asserteq(-1, gzwrite(gz, gz_size, desc, 2 * blksz, 12 * blksz, 0));
+	ut_asserteq(-1, gzwrite(gz, gz_size, desc, 2 * blksz, 0, size + 1));
+
+	ut_assertok(blkmap_destroy(dev));
+	free(disk);
+	free(gz);
+	free(data);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzwrite, 0);
+
 static int compression_test_bzip2(struct unit_test_state *uts)
 {
 	return run_test(uts, "bzip2", compress_using_bzip2,
@@ -487,6 +635,44 @@ static int compression_test_lzma(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lzma, 0);
 
+static int compression_test_lzma_stream(struct unit_test_state *uts)
+{
+	return run_test(uts, "lzma_stream", compress_using_lzma,
+			uncompress_using_lzma_stream);
+}
+COMPRESSION_TEST(compression_test_lzma_stream, 0);
+
+#define LZMA_SPEED_LOOPS	1024
+
+/* Report the LZMA decoder's throughput on the test data */
+static int compression_test_lzma_speed(struct unit_test_state *uts)
+{
+	ulong start, us;
+	SizeT size;
+	char *out;
+	int i;
+
+	out = malloc(sizeof(plain));
+	ut_assertnonnull(out);
+
+	start = timer_get_us();
+	for (i = 0; i < LZMA_SPEED_LOOPS; i++) {
+		size = sizeof(plain);
+		ut_asserteq(SZ_OK, lzmaBuffToBuffDecompress((u8 *)out, &size,
+					(u8 *)lzma_compressed,
+					lzma_compressed_size));
+	}
+	us = max(timer_get_us() - start, 1UL);
+	ut_asserteq(strlen(plain), size);
+	ut_asserteq_mem(plain, out, size);
+	printf("lzma: %lu bytes x %d in %lu us, %lu MB/s\n", (ulong)size,
+	       LZMA_SPEED_LOOPS, us, (ulong)size * LZMA_SPEED_LOOPS / us);
+	free(out);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lzma_speed, 0);
+
 static int compression_test_lzo(struct unit_test_state *uts)
 {
 	return run_test(uts, "lzo", compress_using_lzo, uncompress_using_lzo);
@@ -499,6 +685,207 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+/* Size of each block in the multi-block LZ4 frame */
+#define LZ4_TEST_BLOCK_SIZE	SZ_64K
+
+/* Add a block which expands to LZ4_TEST_BLOCK_SIZE bytes of 'A' */
+static u8 *lz4_add_run_block(u8 *p)
+{
+	u8 *hdr = p;
+	int len;
+
+	p += 4;
+	*p++ = 0x1f;			/* one literal, long match */
+	*p++ = 'A';
+	*p++ = 1;			/* offset */
+	*p++ = 0;
+	for (len = LZ4_TEST_BLOCK_SIZE - 1 - 5 - 4 - 15; len >= 255;
+	     len -= 255)
+		*p++ = 255;
+	*p++ = len;
+	*p++ = 0x50;			/* five final literals */
+	memset(p, 'A', 5);
+	p += 5;
+	put_unaligned_le32(p - hdr - 4, hdr);
+
+	return p;
+}
+
+/* Add an uncompressed block holding @size bytes of @ch */
+static u8 *lz4_add_raw_block(u8 *p, int ch, int size)
+{
+	put_unaligned_le32(size | 0x80000000, p);
+	memset(p + 4, ch, size);
+
+	return p + 4 + size;
+}
+
+/* Check decompressing a frame whose blocks may be handled in parallel */
+static int compression_test_lz4_blocks(struct unit_test_state *uts)
+{
+	const int out_size = 1000 + LZ4_TEST_BLOCK_SIZE + 100;
+	u8 *frame, *p, *out;
+	size_t size;
+	int i;
+
+	frame = malloc(SZ_4K);
+	ut_assertnonnull(frame);
+	out = malloc(3 * LZ4_TEST_BLOCK_SIZE + 1);
+	ut_assertnonnull(out);
+
+	/* Magic, independent blocks, 64KB max block size, header checksum */
+	put_unaligned_le32(LZ4F_MAGIC, frame);
+	p = frame + 4;
+	*p++ = 0x60;
+	*p++ = 0x40;
+	*p++ = 0;
+
+	/* A short first block leaves a gap which has to be closed up */
+	p = lz4_add_raw_block(p, 'x', 1000);
+	p = lz4_add_run_block(p);
+	p = lz4_add_raw_block(p, 'y', 100);
+	put_unaligned_le32(0, p);
+	p += 4;
+
+	/*
+	 * First with room for every block to have its own slot, which may be
+	 * used as scratch space, then with just enough room
+	 */
+	for (i = 0; i < 2; i++) {
+		size_t max = i ? out_size : 3 * LZ4_TEST_BLOCK_SIZE;
+
+		memset(out, '\0', 3 * LZ4_TEST_BLOCK_SIZE + 1);
+		size = max;
+		ut_assertok(ulz4fn(frame, p - frame, out, &size));
+		ut_asserteq(out_size, size);
+		ut_asserteq('x', out[0]);
+		ut_asserteq('x', out[999]);
+		ut_asserteq('A', out[1000]);
+		ut_asserteq('A', out[1000 + LZ4_TEST_BLOCK_SIZE - 1]);
+		ut_asserteq('y', out[1000 + LZ4_TEST_BLOCK_SIZE]);
+		ut_asserteq('y', out[out_size - 1]);
+		ut_asserteq('\0', out[max]);
+	}
+
+	/* Not enough space */
+	size = out_size - 1;
+	ut_asserteq(-ENOBUFS, ulz4fn(frame, p - frame, out, &size));
+
+	free(out);
+	free(frame);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_blocks, 0);
+
+/* Number of times to decode the block in the LZ4 speed test */
+#define LZ4_SPEED_LOOPS		64
+
+/* Add an LZ4 length-extension field for @len */
+static u8 *lz4_add_len(u8 *p, uint len)
+{
+	for (; len >= 255; len -= 255)
+		*p++ = 255;
+	*p++ = len;
+
+	return p;
+}
+
+/*
+ * Build an LZ4 block with a mix of literal runs and matches at offsets from
+ * 1 up to a few hundred bytes, so that the decoder uses all of its copy
+ * paths. The expected output is written to @plain as the block is built.
+ *
+ * Return: size of the block
+ */
+static int lz4_build_block(u8 *block, u8 *plain, int plain_max)
+{
+	uint seed = 0x1234;
+	u8 *p = block, *op = plain;
+	int i;
+
+	while (op - plain < plain_max - 1024) {
+		uint lit, mlen;
+		int offset;
+
+		seed = seed * 1103515245 + 12345;
+		lit = (seed >> 16) % 40;
+		mlen = 4 + (seed >> 8) % 60;
+		offset = 1 + (seed >> 20) % 300;
+		if (op + lit - plain < offset)
+			lit = offset;
+
+		*p++ = min(lit, 15U) << 4 | min(mlen - 4, 15U);
+		if (lit >= 15)
+			p = lz4_add_len(p, lit - 15);
+		for (i = 0; i < lit; i++) {
+			*p++ = 'a' + (seed + i) % 26;
+			*op++ = p[-1];
+		}
+		put_unaligned_le16(offset, p);
+		p += 2;
+		if (mlen - 4 >= 15)
+			p = lz4_add_len(p, mlen - 4 - 15);
+		for (i = 0; i < mlen; i++, op++)
+			*op = op[-offset];
+	}
+
+	/* The block must end with at least LASTLITERALS literals */
+	*p++ = 0xf0;
+	p = lz4_add_len(p, 16 - 15);
+	for (i = 0; i < 16; i++)
+		*p++ = *op++ = '0' + i % 10;
+
+	return p - block;
+}
+
+/* Check the LZ4 decoder's copy paths and report its throughput */
+static int compression_test_lz4_speed(struct unit_test_state *uts)
+{
+	const int plain_max = SZ_64K;
+	u8 *block, *plain, *out;
+	int block_size, size, i;
+	ulong start, us;
+
+	block = malloc(2 * plain_max);
+	plain = malloc(plain_max);
+	out = malloc(plain_max);
+	ut_assertnonnull(block);
+	ut_assertnonnull(plain);
+	ut_assertnonnull(out);
+
+	block_size = lz4_build_block(block, plain, plain_max);
+	ut_assert(block_size < 2 * plain_max);
+
+	/* Find the size of the output, then check it matches exactly */
+	size = LZ4_decompress_safe((char *)block, (char *)out, block_size,
+				   plain_max);
+	ut_assert(size > 0);
+	memset(out, '\0', plain_max);
+	ut_asserteq(size, LZ4_decompress_safe((char *)block, (char *)out,
+					      block_size, size));
+	ut_asserteq_mem(plain, out, size);
+
+	/* Too little space */
+	ut_assert(LZ4_decompress_safe((char *)block, (char *)out, block_size,
+				      size - 1) < 0);
+
+	start = timer_get_us();
+	for (i = 0; i < LZ4_SPEED_LOOPS; i++)
+		LZ4_decompress_safe((char *)block, (char *)out, block_size,
+				    plain_max);
+	us = max(timer_get_us() - start, 1UL);
+	printf("lz4: %d bytes x %d in %lu us, %lu MB/s\n", size,
+	       LZ4_SPEED_LOOPS, us, (ulong)size * LZ4_SPEED_LOOPS / us);
+
+	free(out);
+	free(plain);
+	free(block);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_speed, 0);
+
 static int compression_test_zstd(struct unit_test_state *uts)
 {
 	return run_test(uts, "zstd", compress_using_zstd,
@@ -506,6 +893,97 @@ static int compression_test_zstd(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_zstd, 0);
 
+/* Add @count copies of the zstd test frame */
+static u8 *zstd_add_frames(u8 *p, int count)
+{
+	for (; count; count--) {
+		memcpy(p, zstd_compressed, zstd_compressed_size);
+		p += zstd_compressed_size;
+	}
+
+	return p;
+}
+
+/* Check decompressing data made of several frames, all or in part */
+static int compression_test_zstd_frames(struct unit_test_state *uts)
+{
+	const int plain_size = strlen(plain);
+	struct zstd_seek_entry *entries;
+	struct abuf in, out;
+	u8 *data, *p, *buf;
+	int i;
+
+	data = malloc(SZ_4K);
+	ut_assertnonnull(data);
+	buf = malloc(SZ_4K);
+	ut_assertnonnull(buf);
+
+	/* Frames with a skippable frame between them and junk after */
+	p = zstd_add_frames(data, 1);
+	put_unaligned_le32(ZSTD_MAGIC_SKIPPABLE_START + 3, p);
+	put_unaligned_le32(4, p + 4);
+	p = memset(p + 8, 0xff, 4) + 4;
+	p = zstd_add_frames(p, 2);
+	memset(p, '\0', 16);
+	abuf_init_set(&in, data, p + 16 - data);
+	abuf_init_set(&out, buf, SZ_4K);
+	ut_asserteq(3 * plain_size, zstd_decompress(&in, &out));
+	for (i = 0; i < 3; i++)
+		ut_asserteq_mem(plain, buf + i * plain_size, plain_size);
+
+	ut_asserteq(3, zstd_seek_table(&in, &entries));
+	ut_asserteq(zstd_compressed_size + 12, entries[1].in_offset);
+	ut_asserteq(zstd_compressed_size, entries[1].in_size);
+	ut_asserteq(2 * plain_size, entries[2].out_offset);
+	ut_asserteq(plain_size, entries[2].out_size);
+	free(entries);
+
+	/* Three frames and a seek table, with no checksums */
+	p = zstd_add_frames(data, 3);
+	put_unaligned_le32(0x184d2a5e, p);
+	put_unaligned_le32(3 * 8 + 9, p + 4);
+	p += 8;
+	for (i = 0; i < 3; i++, p += 8) {
+		put_unaligned_le32(zstd_compressed_size, p);
+		put_unaligned_le32(plain_size, p + 4);
+	}
+	put_unaligned_le32(3, p);
+	p[4] = 0;
+	put_unaligned_le32(0x8f92eab1, p + 5);
+	abuf_init_set(&in, data, p + 9 - data);
+	ut_asserteq(3, zstd_seek_table(&in, &entries));
+	ut_asserteq(2 * zstd_compressed_size, entries[2].in_offset);
+	ut_asserteq(plain_size, entries[1].out_offset);
+	free(entries);
+
+	memset(buf, '\0', SZ_4K);
+	abuf_init_set(&out, buf, SZ_4K);
+	ut_asserteq(3 * plain_size, zstd_decompress(&in, &out));
+	ut_asserteq_mem(plain, buf + 2 * plain_size, plain_size);
+
+	/* A range spanning three frames */
+	memset(buf, '\0', SZ_4K);
+	abuf_init_set(&out, buf, plain_size + 20);
+	ut_asserteq(plain_size + 20,
+		    zstd_decompress_range(&in, plain_size - 10, &out));
+	ut_asserteq_mem(plain + plain_size - 10, buf, 10);
+	ut_asserteq_mem(plain, buf + 10, plain_size);
+	ut_asserteq_mem(plain, buf + 10 + plain_size, 10);
+	ut_asserteq('\0', buf[plain_size + 20]);
+
+	/* A range running off the end, and one after it */
+	abuf_init_set(&out, buf, SZ_4K);
+	ut_asserteq(5, zstd_decompress_range(&in, 3 * plain_size - 5, &out));
+	ut_asserteq_mem(plain + plain_size - 5, buf, 5);
+	ut_asserteq(0, zstd_decompress_range(&in, 3 * plain_size, &out));
+
+	free(buf);
+	free(data);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_zstd_frames, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -334,3 +334,37 @@ static int dm_test_blk_foreach(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_blk_foreach, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+/* Test that an asynchronous read gives the same data as a normal one */
+static int dm_test_blk_read_submit(struct unit_test_state *uts)
+{
+	char write[4 * 512], read[4 * 512];
+	struct blk_desc *desc;
+	struct blk_req req;
+	struct udevice *dev;
+	int i;
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", &desc));
+	dev = desc->bdev;
+	for (i = 0; i < sizeof(write); i++)
+		write[i] = i * 3;
+	ut_asserteq(4, blk_write(dev, 0, 4, write));
+
+	/* sandbox MMC has no support, so this completes immediately */
+	memset(read, '\0', sizeof(read));
+	ut_assertok(blk_read_submit(dev, 0, 4, read, &req));
+	ut_assert(req.complete);
+	ut_assertok(blk_req_poll(&req));
+	ut_asserteq(4, blk_req_wait(&req));
+	ut_asserteq_mem(write, read, sizeof(write));
+
+	/* a read off the end of the device reports the short count */
+	ut_assertok(blk_read_submit(dev, desc->lba - 2, 4, read, &req));
+	ut_assert(blk_req_wait(&req) != 4);
+	ut_assertok(blk_read_submit(dev, 1, 2, read, &req));
+	ut_asserteq(2, blk_req_wait(&req));
+	ut_asserteq_mem(write + 512, read, 2 * 512);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_read_submit, UTF_SCAN_PDATA | UTF_SCAN_FDT);
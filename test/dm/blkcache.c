@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the block cache
+ */
+
+#include <blk.h>
+#include <blkmap.h>
+#include <dm.h>
+#include <dm/test.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Test the block cache hashing, LRU eviction and per-device statistics */
+static int dm_test_blk_cache(struct unit_test_state *uts)
+{
+	struct block_cache_dev_stats dstats;
+	struct block_cache_stats stats;
+	char buf[4 * 512], out[2 * 512];
+	ulong gen;
+	int i;
+
+	blkcache_configure(4, 0);
+	blkcache_configure(4, 3);
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i / 512;
+
+	/* an entry crossing a hash window must be found from either side */
+	blkcache_fill(UCLASS_HOST, 0, 6, 4, 512, buf);
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 0, 6, 2, 512, out));
+	ut_asserteq(0, out[0]);
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 0, 8, 2, 512, out));
+	ut_asserteq(2, out[0]);
+	ut_asserteq(3, out[512]);
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 9, 2, 512, out));
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 1, 6, 2, 512, out));
+
+	/* fill up the cache so the LRU entry (block 6) is evicted */
+	blkcache_fill(UCLASS_HOST, 1, 0, 1, 512, buf);
+	blkcache_fill(UCLASS_HOST, 0, 100, 1, 512, buf);
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 1, 0, 1, 512, out));
+	blkcache_fill(UCLASS_HOST, 0, 200, 1, 512, buf);
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 6, 1, 512, out));
+
+	ut_assertok(blkcache_dev_stats(0, &dstats));
+	ut_asserteq(UCLASS_HOST, dstats.iftype);
+	ut_asserteq(0, dstats.devnum);
+	ut_asserteq(2, dstats.hits);
+	ut_asserteq(2, dstats.misses);
+	ut_asserteq(1, dstats.evictions);
+	ut_asserteq(2, dstats.entries);
+	ut_assertok(blkcache_dev_stats(1, &dstats));
+	ut_asserteq(1, dstats.devnum);
+	ut_asserteq(1, dstats.hits);
+	ut_asserteq(0, dstats.misses);
+	ut_asserteq(1, dstats.entries);
+	ut_asserteq(-ENOENT, blkcache_dev_stats(2, &dstats));
+
+	blkcache_stats(&stats);
+	ut_asserteq(3, stats.hits);
+	ut_asserteq(3, stats.misses);
+	ut_asserteq(1, stats.evictions);
+	ut_asserteq(3, stats.entries);
+
+	/* invalidating one device leaves the other alone */
+	gen = blkcache_generation();
+	blkcache_invalidate(UCLASS_HOST, 0);
+	ut_assert(blkcache_generation() != gen);
+	ut_asserteq(0, blkcache_read(UCLASS_HOST, 0, 100, 1, 512, out));
+	ut_asserteq(1, blkcache_read(UCLASS_HOST, 1, 0, 1, 512, out));
+	blkcache_stats(&stats);
+	ut_asserteq(1, stats.entries);
+
+	blkcache_configure(8, 32);
+
+	return 0;
+}
+DM_TEST(dm_test_blk_cache, 0);
+
+/* Test that sequential reads are served from the read-ahead buffer */
+static int dm_test_blk_readahead(struct unit_test_state *uts)
+{
+	static char disk[64 * 512];
+	struct block_cache_stats stats;
+	struct udevice *dev, *blk;
+	char buf[2 * 512];
+	ulong old_size;
+	int i;
+
+	if (!CONFIG_IS_ENABLED(BLOCK_READAHEAD) || !IS_ENABLED(CONFIG_BLKMAP))
+		return -EAGAIN;
+
+	for (i = 0; i < 64; i++)
+		memset(disk + i * 512, i, 512);
+	ut_assertok(blkmap_create("ratest", &dev));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+	ut_assertok(blkmap_map_mem(dev, 0, 64, disk));
+
+	blkcache_configure(8, 32);
+	old_size = blkcache_readahead_size();
+	blkcache_readahead_configure(16 * 512);
+	blkcache_stats(&stats);
+
+	/* the second of two adjacent reads triggers the read-ahead */
+	ut_asserteq(1, blk_read(blk, 10, 1, buf));
+	ut_asserteq(1, blk_read(blk, 11, 1, buf));
+	ut_asserteq(11, buf[0]);
+
+	/* later reads come from memory, not the device */
+	memset(disk + 12 * 512, 0xff, 2 * 512);
+	ut_asserteq(2, blk_read(blk, 12, 2, buf));
+	ut_asserteq(12, buf[0]);
+	ut_asserteq(13, buf[512]);
+	ut_asserteq(1, blk_read(blk, 26, 1, buf));
+	ut_asserteq(26, buf[0]);
+
+	/* running off the end of the window starts the next one */
+	ut_asserteq(1, blk_read(blk, 27, 1, buf));
+	ut_asserteq(27, buf[0]);
+
+	blkcache_stats(&stats);
+	ut_asserteq(2, stats.hits);
+	ut_asserteq(3, stats.misses);
+
+	/* writing drops the buffer */
+	ut_asserteq(1, blk_write(blk, 40, 1, buf));
+	ut_asserteq(2, blk_read(blk, 12, 2, buf));
+	ut_asserteq(0xff, (u8)buf[0]);
+
+	blkcache_readahead_configure(old_size);
+	ut_assertok(blkmap_destroy(dev));
+
+	return 0;
+}
+DM_TEST(dm_test_blk_readahead, 0);
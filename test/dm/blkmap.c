@@ -7,6 +7,7 @@
 #include <blk.h>
 #include <blkmap.h>
 #include <dm.h>
+#include <mapmem.h>
 #include <asm/test.h>
 #include <dm/test.h>
 #include <test/test.h>
@@ -110,6 +111,36 @@ static int dm_test_blkmap_write(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_blkmap_write, 0);
 
+static int dm_test_blkmap_cow(struct unit_test_state *uts)
+{
+	static char image[8 * BLKSZ];
+	struct udevice *dev, *blk;
+
+	ut_assertok(blkmap_create("cowtest", &dev));
+	ut_assertok(blk_get_from_parent(dev, &blk));
+
+	mkblob(identity, identity_mapping);
+	memcpy(image, identity, sizeof(image));
+	ut_assertok(blkmap_map_pmem_cow(dev, 0, 8, map_to_sysmem(image)));
+
+	/* Writes are visible through the device */
+	memset(buffer, 0xaa, 2 * BLKSZ);
+	ut_asserteq(2, blk_write(blk, 3, 2, buffer));
+	ut_asserteq(8, blk_read(blk, 0, 8, buffer));
+	ut_assertok(memcmp(buffer, identity, 3 * BLKSZ));
+	ut_asserteq(0xaa, (u8)buffer[3 * BLKSZ]);
+	ut_asserteq(0xaa, (u8)buffer[5 * BLKSZ - 1]);
+	ut_assertok(memcmp(buffer + 5 * BLKSZ, identity + 5 * BLKSZ,
+			   3 * BLKSZ));
+
+	/* ...but the image itself is untouched */
+	ut_assertok(memcmp(image, identity, sizeof(image)));
+
+	ut_assertok(blkmap_destroy(dev));
+	return 0;
+}
+DM_TEST(dm_test_blkmap_cow, 0);
+
 static int dm_test_blkmap_slicing(struct unit_test_state *uts)
 {
 	struct udevice *dev;
@@ -225,3 +225,39 @@ static int dm_test_clk_bulk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_clk_bulk, UTF_SCAN_FDT);
+
+/* Test that rates are cached until a rate is set */
+static int dm_test_clk_rate_cache(struct unit_test_state *uts)
+{
+	struct sandbox_clk_priv *priv;
+	struct clk spi, i2c;
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_CLK, "clk-sbox", &dev));
+	priv = dev_get_priv(dev);
+	memset(&spi, '\0', sizeof(spi));
+	spi.dev = dev;
+	spi.id = SANDBOX_CLK_ID_SPI;
+	i2c = spi;
+	i2c.id = SANDBOX_CLK_ID_I2C;
+
+	ut_asserteq(0, clk_set_rate(&spi, 1000));
+	ut_asserteq(1000, clk_get_rate(&spi));
+
+	/* Change the rate behind the uclass's back; the old one is kept */
+	priv->rate[SANDBOX_CLK_ID_SPI] = 5000;
+	ut_asserteq(1000, clk_get_rate(&spi));
+
+	/* Setting any rate drops the cache */
+	ut_asserteq(0, clk_set_rate(&i2c, 2000));
+	ut_asserteq(5000, clk_get_rate(&spi));
+	ut_asserteq(2000, clk_get_rate(&i2c));
+
+	/* Removing the provider drops it too, since its rates are reset */
+	ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+	ut_assertok(device_probe(dev));
+	ut_asserteq(0, clk_get_rate(&i2c));
+
+	return 0;
+}
+DM_TEST(dm_test_clk_rate_cache, UTF_SCAN_FDT);
@@ -12,6 +12,7 @@
 #include <malloc.h>
 #include <asm/global_data.h>
 #include <dm/device-internal.h>
+#include <dm/lists.h>
 #include <dm/root.h>
 #include <dm/util.h>
 #include <dm/test.h>
@@ -216,6 +217,35 @@ static int dm_test_autobind_uclass_pdata_valid(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_autobind_uclass_pdata_valid, UTF_SCAN_PDATA);
 
+#if CONFIG_IS_ENABLED(DM_ARENA)
+/* Test that plat data is allocated in the same block as the device */
+static int dm_test_alloc_plat_with_dev(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+	void *next;
+
+	/* Probing the bus binds its children */
+	ut_assertok(uclass_get_device_by_name(UCLASS_TEST_BUS, "some-bus",
+					      &bus));
+	next = (void *)bus + ALIGN(sizeof(*bus), DM_ALLOC_ALIGN);
+	ut_asserteq_ptr(next, dev_get_plat(bus));
+	next += ALIGN(bus->driver->plat_auto, DM_ALLOC_ALIGN);
+	ut_asserteq_ptr(next, dev_get_uclass_plat(bus));
+
+	/* The children have no uclass plat, but do have parent plat */
+	device_find_first_child(bus, &dev);
+	ut_assertnonnull(dev);
+	next = (void *)dev + ALIGN(sizeof(*dev), DM_ALLOC_ALIGN);
+	ut_asserteq_ptr(next, dev_get_plat(dev));
+	next += ALIGN(dev->driver->plat_auto, DM_ALLOC_ALIGN);
+	ut_asserteq_ptr(next, dev_get_parent_plat(dev));
+	ut_assert(!(dev_get_flags(dev) & DM_FLAG_ALLOC_PDATA));
+
+	return 0;
+}
+DM_TEST(dm_test_alloc_plat_with_dev, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+#endif
+
 /* Test that autoprobe finds all the expected devices */
 static int dm_test_autoprobe(struct unit_test_state *uts)
 {
@@ -1201,6 +1231,163 @@ static int dm_test_all_have_seq(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_all_have_seq, UTF_SCAN_PDATA);
 
+/* Check that each device in a uclass is found by its node and phandle */
+static int check_uclass_lookups(struct unit_test_state *uts,
+				enum uclass_id id)
+{
+	struct udevice *dev, *found;
+	struct uclass *uc;
+	int i = 0;
+	uint phandle;
+
+	uclass_id_foreach_dev(id, dev, uc) {
+		if (!ofnode_valid(dev_ofnode(dev)))
+			continue;
+		ut_assertok(uclass_find_device_by_ofnode(id, dev_ofnode(dev),
+							 &found));
+		ut_assert(ofnode_equal(dev_ofnode(dev), dev_ofnode(found)));
+		phandle = dev_read_phandle(dev);
+		if (phandle) {
+			ut_assertok(uclass_get_device_by_phandle_id(id, phandle,
+								    &found));
+			ut_asserteq(phandle, dev_read_phandle(found));
+		}
+		i++;
+	}
+	ut_assert(i > 0);
+
+	return 0;
+}
+
+/* Test finding devices by ofnode and phandle as they are unbound and bound */
+static int dm_test_uclass_find_by_node(struct unit_test_state *uts)
+{
+	ofnode nodes[32], parents[32];
+	struct udevice *dev, *next;
+	int count = 0, i;
+
+	ut_assertok(check_uclass_lookups(uts, UCLASS_TEST_FDT));
+
+	/* Unbind every other device and check the rest are still found */
+	i = 0;
+	uclass_foreach_dev_safe(dev, next, uclass_find(UCLASS_TEST_FDT)) {
+		if (!ofnode_valid(dev_ofnode(dev)) || i++ % 2 ||
+		    count == ARRAY_SIZE(nodes))
+			continue;
+		nodes[count] = dev_ofnode(dev);
+		parents[count++] = dev_ofnode(dev->parent);
+		ut_assertok(device_remove(dev, DM_REMOVE_NORMAL));
+		ut_assertok(device_unbind(dev));
+	}
+	ut_assert(count > 1);
+	ut_assertok(check_uclass_lookups(uts, UCLASS_TEST_FDT));
+	for (i = 0; i < count; i++)
+		ut_asserteq(-ENODEV, uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+								   nodes[i],
+								   &dev));
+
+	/* Bind them again */
+	for (i = 0; i < count; i++) {
+		struct udevice *parent;
+
+		ut_assertok(device_find_global_by_ofnode(parents[i], &parent));
+		ut_assertok(lists_bind_fdt(parent, nodes[i], &dev, NULL, false));
+		ut_assertok(uclass_find_device_by_ofnode(UCLASS_TEST_FDT,
+							 nodes[i], &next));
+		ut_asserteq_ptr(dev, next);
+	}
+	ut_assertok(check_uclass_lookups(uts, UCLASS_TEST_FDT));
+
+	return 0;
+}
+DM_TEST(dm_test_uclass_find_by_node, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(DM_LAZY_BIND)
+/* Test putting off binding a subtree until a uclass in it is looked up */
+static int dm_test_lazy_bind(struct unit_test_state *uts)
+{
+	struct udevice *bus, *dev;
+	struct uclass *uc;
+
+	ut_assertok(dm_lazy_set_uclasses("testbus"));
+	ut_assertok(dm_scan_fdt(false));
+
+	/* Neither the buses nor the devices on them are bound yet */
+	uc = uclass_find(UCLASS_TEST_BUS);
+	ut_assert(!uc || list_empty(&uc->dev_head));
+	uc = uclass_find(UCLASS_TEST_FDT);
+	ut_assertnonnull(uc);
+	ut_assert(!list_empty(&uc->dev_head));
+	uclass_foreach_dev(dev, uc)
+		ut_assert(strcmp(dev->name, "c-test@5"));
+
+	/* Looking up a uclass used on the buses binds them */
+	ut_assertok(uclass_get(UCLASS_TEST_FDT, &uc));
+	uc = uclass_find(UCLASS_TEST_BUS);
+	ut_assertnonnull(uc);
+	ut_asserteq(3, list_count_nodes(&uc->dev_head));
+
+	/* Each bus binds its own devices when probed, as usual */
+	ut_assertok(uclass_get_device_by_name(UCLASS_TEST_BUS, "some-bus",
+					      &bus));
+	ut_assertok(uclass_find_device_by_name(UCLASS_TEST_FDT, "c-test@5",
+					       &dev));
+	ut_asserteq_ptr(bus, dev->parent);
+
+	return 0;
+}
+DM_TEST(dm_test_lazy_bind, 0);
+#endif
+
+#if CONFIG_IS_ENABLED(DM_COMPAT_TABLE)
+/* Find the driver for a compatible string by walking the driver list */
+static struct driver *find_compat_driver(const char *compat,
+					 const struct udevice_id **idp)
+{
+	struct driver *drv = ll_entry_start(struct driver, driver);
+	const int n_ents = ll_entry_count(struct driver, driver);
+	const struct udevice_id *id;
+	struct driver *entry;
+
+	for (entry = drv; entry != drv + n_ents; entry++) {
+		for (id = entry->of_match; id && id->compatible; id++) {
+			if (!strcmp(id->compatible, compat)) {
+				*idp = id;
+				return entry;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+/* The generated table must give the same driver as a walk of the list */
+static int dm_test_compat_table(struct unit_test_state *uts)
+{
+	const struct udevice_id *id, *expect_id;
+	const char *compat;
+	int i;
+
+	ut_assert(dm_compat_table_count > 50);
+	for (i = 0; i < dm_compat_table_count; i++) {
+		compat = dm_compat_table[i].compat;
+		if (i)
+			ut_assert(strcmp(dm_compat_table[i - 1].compat,
+					 compat) <= 0);
+		/* Entries from drivers which are not built in are skipped */
+		expect_id = NULL;
+		id = NULL;
+		ut_asserteq_ptr(find_compat_driver(compat, &expect_id),
+				lists_driver_lookup_compat(compat, &id));
+		ut_asserteq_ptr(expect_id, id);
+	}
+	ut_assertnull(lists_driver_lookup_compat("not,a-driver", &id));
+
+	return 0;
+}
+DM_TEST(dm_test_compat_table, 0);
+#endif
+
 #if CONFIG_IS_ENABLED(DM_DMA)
 static int dm_test_dma_offset(struct unit_test_state *uts)
 {
@@ -8,6 +8,7 @@
 
 #include <dm.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <dm/test.h>
 #include <dma.h>
 #include <test/test.h>
@@ -122,3 +123,52 @@ static int dm_test_dma_rx(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_dma_rx, UTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(DMA_BULK_COPY)
+static int dm_test_dma_bulk_copy(struct unit_test_state *uts)
+{
+	size_t len = CONFIG_DMA_BULK_COPY_THRESHOLD;
+	struct dma_copy copy;
+	u8 *src, *dst;
+	int i;
+
+	src = malloc_cache_aligned(len * 2);
+	ut_assertnonnull(src);
+	dst = malloc_cache_aligned(len);
+	ut_assertnonnull(dst);
+	for (i = 0; i < len * 2; i++)
+		src[i] = i * 7;
+
+	/* a large copy goes to the DMA device and completes on wait */
+	memset(dst, '\0', len);
+	dma_copy_start(&copy, dst, src, len);
+	ut_assertnonnull(copy.dev);
+	dma_copy_wait(&copy);
+	ut_assertnull(copy.dev);
+	ut_asserteq_mem(src, dst, len);
+
+	/* a small one is done by the CPU straight away */
+	memset(dst, '\0', len);
+	dma_copy_start(&copy, dst, src + 1, len - 1);
+	ut_assertnull(copy.dev);
+	ut_asserteq_mem(src + 1, dst, len - 1);
+	dma_copy_wait(&copy);
+
+	/* so is one between overlapping buffers */
+	memcpy(dst, src + len / 2, len);
+	dma_copy_start(&copy, src, src + len / 2, len);
+	ut_assertnull(copy.dev);
+	dma_copy_wait(&copy);
+	ut_asserteq_mem(dst, src, len);
+
+	memset(dst, '\0', len);
+	dma_bulk_copy(dst, src, len);
+	ut_asserteq_mem(src, dst, len);
+
+	free(dst);
+	free(src);
+
+	return 0;
+}
+DM_TEST(dm_test_dma_bulk_copy, UTF_SCAN_FDT);
+#endif
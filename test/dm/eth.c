@@ -189,6 +189,32 @@ static int dm_test_eth(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_eth, UTF_SCAN_FDT);
 
+/* Check that the uclass counts the packets of a ping */
+static int dm_test_eth_stats(struct unit_test_state *uts)
+{
+	struct eth_stats *stats;
+	struct udevice *dev;
+
+	net_ping_ip = string_to_ip("1.1.2.2");
+	env_set("ethact", "eth@10002000");
+	ut_assertok(uclass_get_device_by_name(UCLASS_ETH, "eth@10002000",
+					      &dev));
+	stats = eth_get_stats(dev);
+	memset(stats, '\0', sizeof(*stats));
+
+	/* An ARP request and reply, then the echo request and reply */
+	ut_assertok(net_loop(PING));
+	ut_asserteq(2, stats->tx_packets);
+	ut_asserteq(2, stats->rx_packets);
+	ut_assert(stats->tx_bytes >= 2 * (ETHER_HDR_SIZE + ARP_HDR_SIZE));
+	ut_assert(stats->rx_bytes >= 2 * (ETHER_HDR_SIZE + ARP_HDR_SIZE));
+	ut_asserteq(0, stats->tx_errors);
+	ut_asserteq(0, stats->rx_csum_errors);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_stats, UTF_SCAN_FDT);
+
 static int dm_test_eth_alias(struct unit_test_state *uts)
 {
 	net_ping_ip = string_to_ip("1.1.2.2");
@@ -614,6 +640,100 @@ static int dm_test_eth_async_ping_reply(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_eth_async_ping_reply, UTF_SCAN_FDT);
 
+#if IS_ENABLED(CONFIG_IP_DEFRAG)
+#define DEFRAG_TEST_ID		0x1234
+/* An ICMP echo reply sent in two fragments of this size */
+#define DEFRAG_TEST_FRAG	16
+
+/* Queue one fragment of an ICMP packet in reply to @packet */
+static void sb_defrag_frag(struct udevice *dev, void *packet, int id,
+			   int offset, bool more, const void *data)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct ethernet_hdr *eth_recv;
+	struct ip_udp_hdr *ipr;
+
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth_recv = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth_recv->et_dest, eth->et_src, ARP_HLEN);
+	memcpy(eth_recv->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth_recv->et_protlen = htons(PROT_IP);
+
+	ipr = (void *)eth_recv + ETHER_HDR_SIZE;
+	memcpy(ipr, ip, IP_HDR_SIZE);
+	ipr->ip_len = htons(IP_HDR_SIZE + DEFRAG_TEST_FRAG);
+	ipr->ip_id = htons(id);
+	ipr->ip_off = htons(offset / 8 | (more ? IP_FLAGS_MFRAG : 0));
+	net_copy_ip(&ipr->ip_dst, &ip->ip_src);
+	net_copy_ip(&ipr->ip_src, &ip->ip_dst);
+	ipr->ip_sum = 0;
+	ipr->ip_sum = compute_ip_checksum(ipr, IP_HDR_SIZE);
+	memcpy((void *)ipr + IP_HDR_SIZE, data, DEFRAG_TEST_FRAG);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_HDR_SIZE + DEFRAG_TEST_FRAG;
+	++priv->recv_packets;
+}
+
+/*
+ * Reply to a ping in two fragments, with the first fragment of another
+ * datagram in between
+ */
+static int sb_defrag_ping_handler(struct udevice *dev, void *packet,
+				  unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_udp_hdr *ip = packet + ETHER_HDR_SIZE;
+	struct icmp_hdr *icmp = (struct icmp_hdr *)&ip->udp_src;
+	u8 reply[DEFRAG_TEST_FRAG * 2];
+	struct icmp_hdr *icmpr = (struct icmp_hdr *)reply;
+	int i;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP)
+		return sandbox_eth_arp_req_to_reply(dev, packet, len);
+	if (ntohs(eth->et_protlen) != PROT_IP || ip->ip_p != IPPROTO_ICMP ||
+	    icmp->type != ICMP_ECHO_REQUEST)
+		return 0;
+
+	for (i = 0; i < sizeof(reply); i++)
+		reply[i] = i;
+	memcpy(icmpr, icmp, ICMP_HDR_SIZE);
+	icmpr->type = ICMP_ECHO_REPLY;
+	icmpr->checksum = 0;
+	icmpr->checksum = compute_ip_checksum(reply, sizeof(reply));
+
+	sb_defrag_frag(dev, packet, DEFRAG_TEST_ID, 0, true, reply);
+	sb_defrag_frag(dev, packet, DEFRAG_TEST_ID + 1, 0, true, reply);
+	sb_defrag_frag(dev, packet, DEFRAG_TEST_ID, DEFRAG_TEST_FRAG, false,
+		       reply + DEFRAG_TEST_FRAG);
+
+	return 0;
+}
+
+/* Fragments of two datagrams arriving interleaved are both reassembled */
+static int dm_test_eth_defrag(struct unit_test_state *uts)
+{
+	if (CONFIG_NET_DEFRAG_CONTEXTS < 2)
+		return -EAGAIN;
+
+	net_ping_ip = string_to_ip("1.1.2.2");
+	sandbox_eth_set_tx_handler(0, sb_defrag_ping_handler);
+	sandbox_eth_set_priv(0, uts);
+
+	env_set("ethact", "eth@10002000");
+	ut_assertok(net_loop(PING));
+
+	sandbox_eth_set_tx_handler(0, NULL);
+
+	return 0;
+}
+DM_TEST(dm_test_eth_defrag, UTF_SCAN_FDT);
+#endif
+
 #if IS_ENABLED(CONFIG_IPV6_ROUTER_DISCOVERY)
 
 static u8 ip6_ra_buf[] = {0x60, 0xf, 0xc5, 0x4a, 0x0, 0x38, 0x3a, 0xff, 0xfe,
@@ -3,13 +3,22 @@
  * Copyright (C) 2015 Google, Inc
  */
 
+#include <cyclic.h>
 #include <dm.h>
+#include <env.h>
 #include <fastboot.h>
 #include <fb_mmc.h>
+#include <image-sparse.h>
+#include <malloc.h>
 #include <mmc.h>
+#include <net.h>
 #include <part.h>
 #include <part_efi.h>
+#include <time.h>
+#include <asm/eth.h>
+#include <asm/unaligned.h>
 #include <dm/test.h>
+#include <net/tcp.h>
 #include <test/ut.h>
 #include <linux/stringify.h>
 
@@ -92,3 +101,492 @@ static int dm_test_fastboot_mmc_part(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_fastboot_mmc_part, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+#define FB_STREAM_BUF_SIZE	0x8192
+#define FB_STREAM_PART_START	48
+#define FB_STREAM_PART_BLKS	256
+
+/* Send @image as a download which is flashed to "stream" as it arrives */
+static int fb_stream_download(struct unit_test_state *uts, u8 *image,
+			      u32 size, u32 piece, bool in_place,
+			      char *response)
+{
+	char cmd[FASTBOOT_COMMAND_LEN];
+	u32 n, space;
+	void *dst;
+
+	strcpy(cmd, "oem stream:stream");
+	ut_asserteq(FASTBOOT_COMMAND_OEM_STREAM,
+		    fastboot_handle_command(cmd, response));
+	ut_asserteq_str("OKAY", response);
+
+	snprintf(cmd, sizeof(cmd), "download:%08x", size);
+	ut_asserteq(FASTBOOT_COMMAND_DOWNLOAD,
+		    fastboot_handle_command(cmd, response));
+	if (strncmp("DATA", response, 4))
+		return 0;
+
+	while (fastboot_data_remaining()) {
+		n = min(piece, fastboot_data_remaining());
+		dst = image;
+
+		/* Act like a transport which receives into the buffer */
+		if (in_place) {
+			dst = fastboot_data_stream_buf(0, &space);
+			ut_assertnonnull(dst);
+			n = min(n, space);
+			memcpy(dst, image, n);
+		}
+		*response = '\0';
+		fastboot_data_download(dst, n, response);
+		if (*response)
+			return 0;
+		image += n;
+	}
+	fastboot_data_complete(response);
+
+	return 0;
+}
+
+/* Create the "stream" partition on mmc0 */
+static int fb_stream_part(struct unit_test_state *uts,
+			  struct blk_desc **mmc_dev_descp)
+{
+	char str_disk_guid[UUID_STR_LEN + 1];
+	struct disk_partition parts[1] = {
+		{
+			.start = FB_STREAM_PART_START,
+			.size = FB_STREAM_PART_BLKS,
+			.name = "stream",
+		},
+	};
+
+	ut_assertok(blk_get_device_by_str("mmc", "0", mmc_dev_descp));
+	if (CONFIG_IS_ENABLED(RANDOM_UUID)) {
+		gen_rand_uuid_str(parts[0].uuid, UUID_STR_FORMAT_STD);
+		gen_rand_uuid_str(str_disk_guid, UUID_STR_FORMAT_STD);
+	}
+	ut_assertok(gpt_restore(*mmc_dev_descp, str_disk_guid, parts,
+				ARRAY_SIZE(parts)));
+
+	return 0;
+}
+
+static int dm_test_fastboot_mmc_stream(struct unit_test_state *uts)
+{
+	char response[FASTBOOT_RESPONSE_LEN] = {0};
+	struct blk_desc *mmc_dev_desc;
+	u32 size = 40000, fill = 0x12345678;
+	sparse_header_t *hdr;
+	chunk_header_t *chunk;
+	u8 *buf, *image, *disk, *p;
+	int i;
+
+	ut_assertok(fb_stream_part(uts, &mmc_dev_desc));
+
+	buf = malloc(FB_STREAM_BUF_SIZE);
+	ut_assertnonnull(buf);
+	image = malloc(FB_STREAM_PART_BLKS * 512);
+	ut_assertnonnull(image);
+	disk = malloc(FB_STREAM_PART_BLKS * 512);
+	ut_assertnonnull(disk);
+	fastboot_init(buf, FB_STREAM_BUF_SIZE);
+
+	/* A raw image larger than the buffer, which is not whole blocks */
+	for (i = 0; i < size; i++)
+		image[i] = i * 7 + (i >> 9);
+	ut_assertok(fb_stream_download(uts, image, size, 3000, false,
+				       response));
+	ut_asserteq_str("OKAY", response);
+	ut_asserteq(FB_STREAM_PART_BLKS,
+		    blk_dread(mmc_dev_desc, FB_STREAM_PART_START,
+			      FB_STREAM_PART_BLKS, disk));
+	ut_asserteq_mem(image, disk, size);
+	ut_asserteq(0, disk[size]);
+
+	/* The same, received straight into the buffer */
+	memset(disk, '\0', FB_STREAM_PART_BLKS * 512);
+	ut_asserteq(FB_STREAM_PART_BLKS,
+		    blk_dwrite(mmc_dev_desc, FB_STREAM_PART_START,
+			       FB_STREAM_PART_BLKS, disk));
+	ut_assertok(fb_stream_download(uts, image, size, 4096, true,
+				       response));
+	ut_asserteq_str("OKAY", response);
+	ut_asserteq(FB_STREAM_PART_BLKS,
+		    blk_dread(mmc_dev_desc, FB_STREAM_PART_START,
+			      FB_STREAM_PART_BLKS, disk));
+	ut_asserteq_mem(image, disk, size);
+
+	/* Too large for the partition */
+	ut_assertok(fb_stream_download(uts, image,
+				       FB_STREAM_PART_BLKS * 512 + 1, 4096,
+				       false, response));
+	ut_asserteq_str("FAILtoo large for partition", response);
+
+	/* RAW (split across pieces), zero FILL, FILL, DONT_CARE, RAW */
+	hdr = (sparse_header_t *)image;
+	hdr->magic = SPARSE_HEADER_MAGIC;
+	hdr->major_version = 1;
+	hdr->minor_version = 0;
+	hdr->file_hdr_sz = sizeof(*hdr);
+	hdr->chunk_hdr_sz = sizeof(*chunk);
+	hdr->blk_sz = 512;
+	hdr->total_blks = 100;
+	hdr->total_chunks = 5;
+	p = (u8 *)(hdr + 1);
+
+	chunk = (chunk_header_t *)p;
+	chunk->chunk_type = CHUNK_TYPE_RAW;
+	chunk->chunk_sz = 60;
+	chunk->total_sz = sizeof(*chunk) + 60 * 512;
+	p += sizeof(*chunk);
+	for (i = 0; i < 60 * 512; i++)
+		*p++ = i * 3 + (i >> 9);
+
+	chunk = (chunk_header_t *)p;
+	chunk->chunk_type = CHUNK_TYPE_FILL;
+	chunk->chunk_sz = 10;
+	chunk->total_sz = sizeof(*chunk) + sizeof(u32);
+	p += sizeof(*chunk);
+	memset(p, '\0', sizeof(u32));
+	p += sizeof(u32);
+
+	chunk = (chunk_header_t *)p;
+	chunk->chunk_type = CHUNK_TYPE_FILL;
+	chunk->chunk_sz = 10;
+	chunk->total_sz = sizeof(*chunk) + sizeof(u32);
+	p += sizeof(*chunk);
+	memcpy(p, &fill, sizeof(u32));
+	p += sizeof(u32);
+
+	chunk = (chunk_header_t *)p;
+	chunk->chunk_type = CHUNK_TYPE_DONT_CARE;
+	chunk->chunk_sz = 10;
+	chunk->total_sz = sizeof(*chunk);
+	p += sizeof(*chunk);
+
+	chunk = (chunk_header_t *)p;
+	chunk->chunk_type = CHUNK_TYPE_RAW;
+	chunk->chunk_sz = 10;
+	chunk->total_sz = sizeof(*chunk) + 10 * 512;
+	p += sizeof(*chunk);
+	memset(p, 0xaa, 10 * 512);
+	p += 10 * 512;
+	size = p - image;
+
+	/* The DONT_CARE blocks keep whatever was there */
+	memset(disk, 0xee, FB_STREAM_PART_BLKS * 512);
+	ut_asserteq(FB_STREAM_PART_BLKS,
+		    blk_dwrite(mmc_dev_desc, FB_STREAM_PART_START,
+			       FB_STREAM_PART_BLKS, disk));
+	ut_assertok(fb_stream_download(uts, image, size, 1000, false,
+				       response));
+	ut_asserteq_str("OKAY", response);
+	ut_asserteq(FB_STREAM_PART_BLKS,
+		    blk_dread(mmc_dev_desc, FB_STREAM_PART_START,
+			      FB_STREAM_PART_BLKS, disk));
+	ut_asserteq_mem(image + sizeof(*hdr) + sizeof(*chunk), disk,
+			60 * 512);
+	for (i = 60 * 512; i < 70 * 512; i++)
+		ut_asserteq(0, disk[i]);
+	for (i = 70 * 512; i < 80 * 512; i += sizeof(u32))
+		ut_asserteq_mem(&fill, disk + i, sizeof(u32));
+	for (i = 80 * 512; i < 90 * 512; i++)
+		ut_asserteq(0xee, disk[i]);
+	for (i = 90 * 512; i < 100 * 512; i++)
+		ut_asserteq(0xaa, disk[i]);
+	ut_asserteq(0xee, disk[100 * 512]);
+
+	/* A sparse image which stops early */
+	hdr->total_chunks = 6;
+	ut_assertok(fb_stream_download(uts, image, size, 1000, false,
+				       response));
+	ut_asserteq_str("FAILsparse image is truncated", response);
+
+	free(disk);
+	free(image);
+	free(buf);
+	fastboot_init(NULL, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_fastboot_mmc_stream, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
+#if IS_ENABLED(CONFIG_TCP_FUNCTION_FASTBOOT)
+#define FB_TCP_PORT		5554
+#define FB_TCP_HOST_PORT	40000
+#define FB_TCP_HOST_IP		"192.0.2.99"
+#define FB_TCP_HOST_ISN		1000
+#define FB_TCP_IMAGE_SIZE	40000
+/* The host sends the image as two messages */
+#define FB_TCP_IMAGE_SPLIT	25000
+#define FB_TCP_SEG_SIZE		1000
+/* The host sends this segment after the one following it */
+#define FB_TCP_LATE_SEG		9
+#define FB_TCP_MAX_SEGS		64
+#define FB_TCP_RX_SIZE		512
+
+/**
+ * struct fb_tcp_host - A fastboot client talking to the TCP server
+ *
+ * @stream: Everything the client sends after the TCP handshake
+ * @stream_len: Length of @stream
+ * @seg_start: Offset of each segment in @stream
+ * @num_segs: Number of segments
+ * @next_seg: Next segment to send, counting those sent out of order
+ * @rx: Everything the server has sent
+ * @rx_len: Length of @rx
+ * @ack: Sequence number of the next byte expected from the server
+ * @scaled: true if the server's SYN ACK offers to scale its window
+ * @cyclic: Starts the connection once the server is listening
+ * @started: true once the SYN has been sent
+ * @start: Time at which the SYN was sent
+ */
+static struct fb_tcp_host {
+	u8 *stream;
+	u32 stream_len;
+	u32 seg_start[FB_TCP_MAX_SEGS + 1];
+	int num_segs;
+	int next_seg;
+	u8 rx[FB_TCP_RX_SIZE];
+	u32 rx_len;
+	u32 ack;
+	bool scaled;
+	struct cyclic_info cyclic;
+	bool started;
+	ulong start;
+} fb_host;
+
+/* Queue a segment from the client, with window scale and MSS options on SYN */
+static void fb_tcp_host_send(struct udevice *dev, u8 flags, u32 seq,
+			     const void *data, int len)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	struct in_addr host_ip = string_to_ip(FB_TCP_HOST_IP);
+	struct ethernet_hdr *eth;
+	struct ip_tcp_hdr *tcp;
+	int hdr_len = TCP_HDR_SIZE;
+	u8 *opt;
+
+	/* Don't allow the buffer to overrun */
+	if (priv->recv_packets >= PKTBUFSRX)
+		return;
+
+	eth = (void *)priv->recv_packet_buffer[priv->recv_packets];
+	memcpy(eth->et_dest, net_ethaddr, ARP_HLEN);
+	memcpy(eth->et_src, priv->fake_host_hwaddr, ARP_HLEN);
+	eth->et_protlen = htons(PROT_IP);
+
+	tcp = (void *)eth + ETHER_HDR_SIZE;
+	opt = (u8 *)tcp + IP_TCP_HDR_SIZE;
+	if (flags & TCP_SYN) {
+		/* MSS, NOP, window scale and SACK-permitted, NOP, NOP */
+		put_unaligned_be32(TCP_O_MSS << 24 | 4 << 16 | TCP_MSS, opt);
+		put_unaligned_be32(TCP_1_NOP << 24 | TCP_O_SCL << 16 | 3 << 8 | 7,
+				   opt + 4);
+		put_unaligned_be32(TCP_P_SACK << 24 | 2 << 16 | TCP_1_NOP << 8 |
+				   TCP_1_NOP, opt + 8);
+		hdr_len += 12;
+	}
+	memcpy(opt + hdr_len - TCP_HDR_SIZE, data, len);
+
+	tcp->tcp_src = htons(FB_TCP_HOST_PORT);
+	tcp->tcp_dst = htons(FB_TCP_PORT);
+	tcp->tcp_seq = htonl(seq);
+	tcp->tcp_ack = htonl(fb_host.ack);
+	tcp->tcp_hlen = (hdr_len >> 2) << 4;
+	tcp->tcp_flags = flags;
+	tcp->tcp_win = htons(0xffff);
+	tcp->tcp_xsum = 0;
+	tcp->tcp_ugr = 0;
+	tcp->tcp_xsum = tcp_set_pseudo_header((uchar *)tcp, host_ip, net_ip,
+					      hdr_len + len,
+					      IP_HDR_SIZE + hdr_len + len);
+	net_set_ip_header((uchar *)tcp, net_ip, host_ip,
+			  IP_HDR_SIZE + hdr_len + len, IPPROTO_TCP);
+
+	priv->recv_packet_length[priv->recv_packets] =
+		ETHER_HDR_SIZE + IP_HDR_SIZE + hdr_len + len;
+	++priv->recv_packets;
+}
+
+/* Send the next two segments, or as many as there is room for */
+static void fb_tcp_host_next(struct udevice *dev)
+{
+	struct eth_sandbox_priv *priv = dev_get_priv(dev);
+	int i, seg;
+
+	for (i = 0; i < 2 && fb_host.next_seg < fb_host.num_segs &&
+	     priv->recv_packets < PKTBUFSRX; i++) {
+		seg = fb_host.next_seg++;
+		if (seg == FB_TCP_LATE_SEG)
+			seg++;
+		else if (seg == FB_TCP_LATE_SEG + 1)
+			seg--;
+		fb_tcp_host_send(dev, TCP_ACK, FB_TCP_HOST_ISN + 1 +
+				 fb_host.seg_start[seg],
+				 fb_host.stream + fb_host.seg_start[seg],
+				 fb_host.seg_start[seg + 1] -
+				 fb_host.seg_start[seg]);
+	}
+}
+
+static int fb_tcp_host_handler(struct udevice *dev, void *packet,
+			       unsigned int len)
+{
+	struct ethernet_hdr *eth = packet;
+	struct ip_tcp_hdr *tcp = packet + ETHER_HDR_SIZE;
+	int hdr_len, payload_len;
+	u8 *opt;
+
+	if (ntohs(eth->et_protlen) == PROT_ARP)
+		return sandbox_eth_arp_req_to_reply(dev, packet, len);
+	if (ntohs(eth->et_protlen) != PROT_IP || tcp->ip_p != IPPROTO_TCP)
+		return 0;
+
+	hdr_len = (tcp->tcp_hlen >> 4) * 4;
+	payload_len = ntohs(tcp->ip_len) - IP_HDR_SIZE - hdr_len;
+	if (tcp->tcp_flags == (TCP_SYN | TCP_ACK)) {
+		for (opt = (u8 *)tcp + IP_TCP_HDR_SIZE;
+		     opt < (u8 *)tcp + IP_HDR_SIZE + hdr_len && *opt;
+		     opt += *opt == TCP_1_NOP ? 1 : opt[1]) {
+			if (*opt == TCP_O_SCL)
+				fb_host.scaled = true;
+		}
+		fb_host.ack = ntohl(tcp->tcp_seq) + 1;
+		fb_tcp_host_send(dev, TCP_ACK, FB_TCP_HOST_ISN + 1, NULL, 0);
+	} else if (payload_len > 0 && ntohl(tcp->tcp_seq) == fb_host.ack &&
+		   fb_host.rx_len + payload_len <= FB_TCP_RX_SIZE) {
+		memcpy(fb_host.rx + fb_host.rx_len,
+		       (u8 *)tcp + IP_HDR_SIZE + hdr_len, payload_len);
+		fb_host.rx_len += payload_len;
+		fb_host.ack += payload_len;
+	}
+	fb_tcp_host_next(dev);
+
+	return 0;
+}
+
+/* Connect once the server is listening, and give up if it gets stuck */
+static void fb_tcp_host_start(struct cyclic_info *c)
+{
+	struct udevice *dev = eth_get_dev();
+
+	if (!dev || !eth_is_active(dev))
+		return;
+	if (!fb_host.started) {
+		fb_host.started = true;
+		fb_host.start = get_timer(0);
+		fb_tcp_host_send(dev, TCP_SYN, FB_TCP_HOST_ISN, NULL, 0);
+	} else if (get_timer(fb_host.start) > 5000) {
+		net_set_state(NETLOOP_FAIL);
+	}
+}
+
+/* Add a message to what the client sends */
+static void fb_tcp_host_msg(const void *data, u32 len)
+{
+	put_unaligned_be64(len, fb_host.stream + fb_host.stream_len);
+	memcpy(fb_host.stream + fb_host.stream_len + 8, data, len);
+	fb_host.stream_len += 8 + len;
+}
+
+/* Check the next message which the server sent */
+static int fb_tcp_host_check(struct unit_test_state *uts, u32 *pos,
+			     const char *expect, int len)
+{
+	ut_assert(*pos + 8 <= fb_host.rx_len);
+	ut_asserteq(len, get_unaligned_be64(fb_host.rx + *pos));
+	ut_asserteq_strn(expect, (char *)fb_host.rx + *pos + 8);
+	*pos += 8 + len;
+
+	return 0;
+}
+
+/*
+ * A client connects, names the partition to stream to and sends an image
+ * larger than the buffer with one segment out of order, then asks for the
+ * download rate and continues.
+ */
+static int dm_test_fastboot_tcp(struct unit_test_state *uts)
+{
+	struct blk_desc *mmc_dev_desc;
+	char cmd[FASTBOOT_COMMAND_LEN];
+	u8 *buf, *image, *disk;
+	u32 pos = 0;
+	int i;
+
+	ut_assertok(fb_stream_part(uts, &mmc_dev_desc));
+	buf = malloc(FB_STREAM_BUF_SIZE);
+	ut_assertnonnull(buf);
+	image = malloc(FB_TCP_IMAGE_SIZE);
+	ut_assertnonnull(image);
+	disk = calloc(FB_STREAM_PART_BLKS, 512);
+	ut_assertnonnull(disk);
+	ut_asserteq(FB_STREAM_PART_BLKS,
+		    blk_dwrite(mmc_dev_desc, FB_STREAM_PART_START,
+			       FB_STREAM_PART_BLKS, disk));
+	for (i = 0; i < FB_TCP_IMAGE_SIZE; i++)
+		image[i] = i * 5 + (i >> 10);
+
+	memset(&fb_host, '\0', sizeof(fb_host));
+	fb_host.stream = malloc(FB_TCP_IMAGE_SIZE + 256);
+	ut_assertnonnull(fb_host.stream);
+	memcpy(fb_host.stream, "FB01", 4);
+	fb_host.stream_len = 4;
+	fb_tcp_host_msg("oem stream:stream", 17);
+	snprintf(cmd, sizeof(cmd), "download:%08x", FB_TCP_IMAGE_SIZE);
+	fb_tcp_host_msg(cmd, strlen(cmd));
+	fb_tcp_host_msg(image, FB_TCP_IMAGE_SPLIT);
+	fb_tcp_host_msg(image + FB_TCP_IMAGE_SPLIT,
+			FB_TCP_IMAGE_SIZE - FB_TCP_IMAGE_SPLIT);
+	fb_tcp_host_msg("getvar:download-rate", 20);
+	fb_tcp_host_msg("continue", 8);
+
+	/* The handshake goes on its own, then all is split up evenly */
+	fb_host.seg_start[1] = 4;
+	for (i = 1; fb_host.seg_start[i] < fb_host.stream_len; i++)
+		fb_host.seg_start[i + 1] = min(fb_host.seg_start[i] +
+					       FB_TCP_SEG_SIZE,
+					       fb_host.stream_len);
+	fb_host.num_segs = i;
+	ut_assert(fb_host.num_segs <= FB_TCP_MAX_SEGS);
+
+	fastboot_init(buf, FB_STREAM_BUF_SIZE);
+	env_set("ethact", "eth@10002000");
+	sandbox_eth_set_tx_handler(0, fb_tcp_host_handler);
+	cyclic_register(&fb_host.cyclic, fb_tcp_host_start, 0, "fb_tcp_host");
+	ut_assertok(net_loop(FASTBOOT_TCP));
+	cyclic_unregister(&fb_host.cyclic);
+	sandbox_eth_set_tx_handler(0, NULL);
+	fastboot_init(NULL, 0);
+
+	/* The window is scaled, since the client asked for that */
+	ut_assert(fb_host.scaled);
+	ut_asserteq_strn("FB01", (char *)fb_host.rx);
+	pos = 4;
+	ut_assertok(fb_tcp_host_check(uts, &pos, "OKAY", 4));
+	snprintf(cmd, sizeof(cmd), "DATA%08x", FB_TCP_IMAGE_SIZE);
+	ut_assertok(fb_tcp_host_check(uts, &pos, cmd, 12));
+	ut_assertok(fb_tcp_host_check(uts, &pos, "OKAY", 4));
+	ut_asserteq_strn("OKAY", (char *)fb_host.rx + pos + 8);
+	pos += 8 + get_unaligned_be64(fb_host.rx + pos);
+	ut_assertok(fb_tcp_host_check(uts, &pos, "OKAY", 4));
+	ut_asserteq(fb_host.rx_len, pos);
+	ut_assert(fastboot_data_rate() > 0);
+
+	ut_asserteq(FB_STREAM_PART_BLKS,
+		    blk_dread(mmc_dev_desc, FB_STREAM_PART_START,
+			      FB_STREAM_PART_BLKS, disk));
+	ut_asserteq_mem(image, disk, FB_TCP_IMAGE_SIZE);
+	ut_asserteq(0, disk[FB_TCP_IMAGE_SIZE]);
+
+	free(fb_host.stream);
+	free(disk);
+	free(image);
+	free(buf);
+
+	return 0;
+}
+DM_TEST(dm_test_fastboot_tcp, UTF_SCAN_FDT);
+#endif
@@ -22,6 +22,7 @@ static int dm_test_host(struct unit_test_state *uts)
 	struct udevice *dev, *part, *chk, *blk;
 	struct host_sb_plat *plat;
 	struct blk_desc *desc;
+	char buf[DEFAULT_BLKSZ], cmp[DEFAULT_BLKSZ];
 	char fname[256];
 	ulong mem_start;
 	loff_t actwrite;
@@ -48,6 +49,8 @@ static int dm_test_host(struct unit_test_state *uts)
 	ut_asserteq_str(fname, plat->filename);
 	ut_assert(fname != plat->filename);
 	ut_assert(plat->fd != 0);
+	ut_assertnonnull(plat->map);
+	ut_asserteq(true, plat->map_rw);
 
 	/* Get the block device */
 	ut_assertok(blk_get_from_parent(dev, &blk));
@@ -62,8 +65,19 @@ static int dm_test_host(struct unit_test_state *uts)
 	ut_assertok(fs_set_blk_dev_with_part(desc, 0));
 	ut_assertok(fs_write("/testing", 0, 0, 0x1000, &actwrite));
 
+	/* Writes through the mapping should reach the file */
+	ut_asserteq(1, blk_read(blk, 0, 1, buf));
+	buf[0] ^= 0xff;
+	ut_asserteq(1, blk_write(blk, 0, 1, buf));
+	ut_asserteq(0, os_lseek(plat->fd, 0, OS_SEEK_SET));
+	ut_asserteq(DEFAULT_BLKSZ, os_read(plat->fd, cmp, DEFAULT_BLKSZ));
+	ut_asserteq_mem(buf, cmp, DEFAULT_BLKSZ);
+	buf[0] ^= 0xff;
+	ut_asserteq(1, blk_write(blk, 0, 1, buf));
+
 	ut_assertok(host_detach_file(dev));
 	ut_asserteq(0, plat->fd);
+	ut_assertnull(plat->map);
 	ut_asserteq(-ENODEV, blk_get_from_parent(dev, &blk));
 	ut_assertok(device_unbind(dev));
 
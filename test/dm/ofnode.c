@@ -27,6 +27,9 @@
 #include <dm/test.h>
 #include <dm/uclass-internal.h>
 #include <linux/sizes.h>
+#include <os.h>
+#include <time.h>
+#include <asm/state.h>
 #include <test/test.h>
 #include <test/ut.h>
 
@@ -1355,6 +1358,108 @@ static int dm_test_livetree_align(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_livetree_align, UTF_SCAN_FDT | UTF_LIVE_TREE);
 
+#define PROP_LOOKUP_LOOPS	100000
+
+/* check the property-name hashes in the live tree, and time lookups */
+static int dm_test_livetree_prop_hash(struct unit_test_state *uts)
+{
+	const struct property *pp, *last = NULL;
+	const struct device_node *np, *big = NULL;
+	int count, most = 0;
+	ulong start;
+	int i;
+
+	for (np = of_find_all_nodes(NULL); np; np = of_find_all_nodes(np)) {
+		count = 0;
+		for (pp = np->properties; pp; pp = pp->next, count++) {
+			ut_asserteq(of_prop_hash(pp->name), pp->hash);
+			ut_asserteq_ptr(pp, of_find_property(np, pp->name,
+							     NULL));
+		}
+		if (count > most) {
+			most = count;
+			big = np;
+		}
+	}
+	ut_assertnonnull(big);
+	ut_assertnull(of_find_property(big, "no-such-property", NULL));
+
+	/* Time finding the last property in the node which has most */
+	for (pp = big->properties; pp; pp = pp->next)
+		last = pp;
+	start = timer_get_us();
+	for (i = 0; i < PROP_LOOKUP_LOOPS; i++)
+		ut_asserteq_ptr(last, of_find_property(big, last->name, NULL));
+	printf("%d lookups of %s in %s (%d properties): %lu us\n",
+	       PROP_LOOKUP_LOOPS, last->name, big->full_name, most,
+	       timer_get_us() - start);
+
+	return 0;
+}
+DM_TEST(dm_test_livetree_prop_hash, UTF_SCAN_FDT | UTF_LIVE_TREE);
+
+#if CONFIG_IS_ENABLED(OF_LIVE_STATIC)
+/* Check that two live trees hold the same nodes and properties */
+static int check_same_tree(struct unit_test_state *uts,
+			   const struct device_node *np,
+			   const struct device_node *ref,
+			   const struct device_node *parent)
+{
+	const struct property *pp, *rp;
+
+	for (; np || ref; np = np->sibling, ref = ref->sibling) {
+		ut_assertnonnull(np);
+		ut_assertnonnull(ref);
+		ut_asserteq_str(ref->full_name, np->full_name);
+		ut_asserteq_str(ref->name, np->name);
+		ut_asserteq_str(ref->type, np->type);
+		ut_asserteq(ref->phandle, np->phandle);
+		ut_asserteq_ptr(parent, np->parent);
+		for (pp = np->properties, rp = ref->properties; pp || rp;
+		     pp = pp->next, rp = rp->next) {
+			ut_assertnonnull(pp);
+			ut_assertnonnull(rp);
+			ut_asserteq_str(rp->name, pp->name);
+			ut_asserteq(rp->hash, pp->hash);
+			ut_asserteq(rp->length, pp->length);
+			ut_asserteq_mem(rp->value, pp->value, rp->length);
+		}
+		ut_assertok(check_same_tree(uts, np->child, ref->child, np));
+	}
+
+	return 0;
+}
+
+/* check the live tree generated at build time against an unflattened one */
+static int dm_test_livetree_static(struct unit_test_state *uts)
+{
+	struct device_node *root, *ref;
+	void *fdt = NULL;
+	char fname[256];
+	int size;
+
+	if (gd_of_root() == of_live_static.nodes) {
+		root = gd_of_root();
+		ut_assertok(unflatten_device_tree(gd->fdt_blob, &ref));
+	} else {
+		/* Running with another devicetree, e.g. test.dtb */
+		ut_asserteq(-ENOENT, of_live_static_attach(gd->fdt_blob, &root));
+		ut_assert(state_get_rel_filename("dts/dt.dtb", fname,
+						 sizeof(fname)) > 0);
+		ut_assertok(os_read_file(fname, &fdt, &size));
+		ut_assertok(of_live_static_attach(fdt, &root));
+		ut_asserteq_ptr(of_live_static.nodes, root);
+		ut_assertok(unflatten_device_tree(fdt, &ref));
+	}
+	ut_assertok(check_same_tree(uts, root, ref, NULL));
+	free(ref);
+	os_free(fdt);
+
+	return 0;
+}
+DM_TEST(dm_test_livetree_static, UTF_SCAN_FDT | UTF_LIVE_TREE);
+#endif
+
 /* check that it is possible to load an arbitrary livetree */
 static int dm_test_livetree_ensure(struct unit_test_state *uts)
 {
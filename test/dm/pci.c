@@ -131,6 +131,20 @@ static int dm_test_pci_drvdata(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_pci_drvdata, UTF_SCAN_PDATA | UTF_SCAN_FDT);
 
+/* Test that the header fields read while scanning the bus are kept */
+static int dm_test_pci_header_cache(struct unit_test_state *uts)
+{
+	struct udevice *swap;
+
+	ut_assertok(dm_pci_bus_find_bdf(PCI_BDF(0, 0x1f, 0), &swap));
+	ut_asserteq(PCI_CLASS_COMMUNICATION_SERIAL << 8,
+		    dm_pci_get_class(swap));
+	ut_asserteq(PCI_HEADER_TYPE_NORMAL, dm_pci_get_header_type(swap));
+
+	return 0;
+}
+DM_TEST(dm_test_pci_header_cache, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
 /* Test that devices on PCI bus#2 can be accessed correctly */
 static int dm_test_pci_mixed(struct unit_test_state *uts)
 {
@@ -129,6 +129,73 @@ static int dm_test_regmap_rw(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_regmap_rw, UTF_SCAN_PDATA | UTF_SCAN_FDT);
 
+/* The register at offset 4 is volatile in the cache test */
+static bool regmap_test_volatile(struct udevice *dev, uint offset)
+{
+	return offset == 4;
+}
+
+/* Register cache and bulk access test */
+static int dm_test_regmap_cache(struct unit_test_state *uts)
+{
+	struct regmap_config cfg = {
+		.cache = true,
+		.max_register = 12,
+		.volatile_reg = regmap_test_volatile,
+	};
+	const u32 vals[] = { 0x11223344, 0x55667788, 0x99aabbcc };
+	struct udevice *dev;
+	struct regmap *map;
+	u32 back[3];
+	u32 *buf;
+	uint reg;
+
+	if (!IS_ENABLED(CONFIG_REGMAP_CACHE))
+		return -EAGAIN;
+
+	sandbox_set_enable_memio(true);
+	ut_assertok(uclass_get_device(UCLASS_SYSCON, 0, &dev));
+	map = syscon_get_regmap(dev);
+	ut_assertok_ptr(map);
+	ut_assertok(regmap_cache_init(map, dev, &cfg));
+	buf = regmap_get_range(map, 0);
+
+	/* Cached registers are not read back from the hardware */
+	ut_assertok(regmap_write(map, 0, vals[0]));
+	ut_asserteq(vals[0], buf[0]);
+	buf[0] = 0;
+	ut_assertok(regmap_read(map, 0, &reg));
+	ut_asserteq(vals[0], reg);
+
+	/* Volatile ones are */
+	ut_assertok(regmap_write(map, 4, vals[1]));
+	buf[1] = 0;
+	ut_assertok(regmap_read(map, 4, &reg));
+	ut_asserteq(0, reg);
+
+	/* An update which changes nothing is not written */
+	ut_assertok(regmap_update_bits(map, 0, 0xff, 0x44));
+	ut_asserteq(0, buf[0]);
+
+	ut_assertok(regmap_cache_sync(map));
+	ut_asserteq(vals[0], buf[0]);
+	ut_asserteq(0, buf[1]);
+
+	buf[0] = 0;
+	regmap_cache_drop(map);
+	ut_assertok(regmap_read(map, 0, &reg));
+	ut_asserteq(0, reg);
+
+	ut_assertok(regmap_bulk_write(map, 0, vals, ARRAY_SIZE(vals)));
+	ut_asserteq_mem(vals, buf, sizeof(vals));
+	ut_assertok(regmap_bulk_read(map, 0, back, ARRAY_SIZE(back)));
+	ut_asserteq_mem(vals, back, sizeof(vals));
+	ut_asserteq(-ERANGE, regmap_bulk_read(map, 8, back, ARRAY_SIZE(back)));
+
+	return 0;
+}
+DM_TEST(dm_test_regmap_cache, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
 /* Get/Set test */
 static int dm_test_regmap_getset(struct unit_test_state *uts)
 {
@@ -232,6 +299,7 @@ static int remaptest_probe(struct udevice *dev)
 	 * REGMAP_TEST_BUF_SZ is the number of elements, so we need to multiply
 	 * it by 2 because r_size expects number of bytes.
 	 */
+	memset(&cfg, 0, sizeof(struct regmap_config));
 	cfg.reg_offset_shift = 1;
 	cfg.r_start = REGMAP_TEST_BUF_START;
 	cfg.r_size = REGMAP_TEST_BUF_SZ * 2;
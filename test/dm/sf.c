@@ -74,6 +74,61 @@ static int dm_test_spi_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_spi_flash, UTF_SCAN_PDATA | UTF_SCAN_FDT);
 
+/* Test updating part of a sector, with and without an erase */
+static int dm_test_spi_flash_update(struct unit_test_state *uts)
+{
+	int full_size = 0x200000;
+	struct spi_flash *flash;
+	struct udevice *dev;
+	size_t skipped = 0;
+	u8 *buf, *cmp, *dst;
+	uint size;
+	int i;
+
+	buf = map_sysmem(0x20000, full_size);
+	memset(buf, '\xff', full_size);
+	ut_assertok(os_write_file("spi.bin", buf, full_size));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	flash = dev_get_uclass_priv(dev);
+	size = flash->sector_size;
+	cmp = buf + size;
+	dst = cmp + size;
+
+	/* Program an erased sector, leaving the start and end alone */
+	for (i = 0; i < size; i++)
+		buf[i] = i * 3;
+	ut_assertok(spi_flash_update_sector(flash, 0x10, size - 0x20, buf + 0x10,
+					    cmp, &skipped));
+	ut_asserteq(0, skipped);
+	ut_assertok(spi_flash_read(flash, 0, size, dst));
+	ut_asserteq(0xff, dst[0]);
+	ut_asserteq_mem(buf + 0x10, dst + 0x10, size - 0x20);
+	ut_asserteq(0xff, dst[size - 1]);
+
+	/* Writing the same data is skipped */
+	ut_assertok(spi_flash_update_sector(flash, 0x10, size - 0x20, buf + 0x10,
+					    cmp, &skipped));
+	ut_asserteq(size - 0x20, skipped);
+
+	/* Setting bits needs an erase, which must keep the rest of the sector */
+	memset(buf + 0x100, '\xff', 0x10);
+	ut_assertok(spi_flash_update_sector(flash, 0x100, 0x10, buf + 0x100, cmp,
+					    &skipped));
+	ut_assertok(spi_flash_read(flash, 0, size, dst));
+	ut_asserteq(0xff, dst[0]);
+	ut_asserteq_mem(buf + 0x10, dst + 0x10, size - 0x20);
+	ut_asserteq(0xff, dst[size - 1]);
+
+	/* Updates may not cross a sector boundary */
+	ut_asserteq(-EINVAL, spi_flash_update_sector(flash, size - 1, 2, buf,
+						     cmp, &skipped));
+
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_update, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
 /* Functional test that sandbox SPI flash works correctly */
 static int dm_test_spi_flash_func(struct unit_test_state *uts)
 {
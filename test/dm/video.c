@@ -14,6 +14,7 @@
 #include <video.h>
 #include <video_console.h>
 #include <asm/test.h>
+#include <asm/unaligned.h>
 #include <asm/sdl.h>
 #include <dm/test.h>
 #include <dm/uclass-internal.h>
@@ -44,6 +45,51 @@ static int dm_test_video_base(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_base, UTF_SCAN_PDATA | UTF_SCAN_FDT);
 
+/* Test filling runs of pixels at each depth and alignment */
+static int dm_test_video_fill_pixels(struct unit_test_state *uts)
+{
+	static const u32 colours[] = { 0x12345678, 0xffffffff, 0 };
+	u8 buf[64 + 8];
+	int bpix, c, start, i, j;
+
+	for (bpix = VIDEO_BPP8; bpix <= VIDEO_BPP32; bpix++) {
+		int pbytes = VNBYTES(bpix);
+
+		for (c = 0; c < ARRAY_SIZE(colours); c++) {
+			for (start = 0; start < 8; start += pbytes) {
+				int pixels = (sizeof(buf) - 8 - start) / pbytes;
+				u8 expect[4];
+
+				memset(buf, 0xaa, sizeof(buf));
+				video_fill_pixels(buf + start, colours[c],
+						  pixels, bpix);
+
+				memcpy(expect, &colours[c], sizeof(expect));
+				if (pbytes == 1)
+					expect[0] = colours[c];
+				else if (pbytes == 2)
+					put_unaligned((u16)colours[c],
+						      (u16 *)expect);
+
+				for (i = 0; i < start; i++)
+					ut_asserteq(0xaa, buf[i]);
+				for (i = 0; i < pixels; i++) {
+					u8 *pix = buf + start + i * pbytes;
+
+					for (j = 0; j < pbytes; j++)
+						ut_asserteq(expect[j], pix[j]);
+				}
+				for (i = start + pixels * pbytes;
+				     i < sizeof(buf); i++)
+					ut_asserteq(0xaa, buf[i]);
+			}
+		}
+	}
+
+	return 0;
+}
+DM_TEST(dm_test_video_fill_pixels, 0);
+
 /**
  * compress_frame_buffer() - Compress the frame buffer and return its size
  *
@@ -452,6 +498,29 @@ static int dm_test_video_bmp24(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_video_bmp24, UTF_SCAN_PDATA | UTF_SCAN_FDT);
 
+/* Test drawing a gzipped bitmap file without unpacking it first */
+static int dm_test_video_bmp24_gz(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+	ulong src;
+
+	ut_assertok(uclass_find_first_device(UCLASS_VIDEO, &dev));
+	ut_assertnonnull(dev);
+	ut_assertok(sandbox_sdl_set_bpp(dev, VIDEO_BPP16));
+
+	ut_assertok(read_file(uts, "tools/logos/denx-24bpp.bmp.gz", &src));
+	ut_assertok(video_bmp_display_gz(dev, src, 100000, 0, 0, false));
+	ut_asserteq(3656, compress_frame_buffer(uts, dev));
+
+	/* An image that is not gzipped is left for the caller */
+	ut_assertok(read_file(uts, "tools/logos/denx.bmp", &src));
+	ut_asserteq(-ENOENT, video_bmp_display_gz(dev, src, 100000, 0, 0,
+						  false));
+
+	return 0;
+}
+DM_TEST(dm_test_video_bmp24_gz, UTF_SCAN_PDATA | UTF_SCAN_FDT);
+
 /* Test drawing a 24bpp bitmap file on a 32bpp display */
 static int dm_test_video_bmp24_32(struct unit_test_state *uts)
 {
@@ -122,3 +122,70 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 	return 0;
 }
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Fill the hash table well beyond its original size */
+static int env_test_htab_grow(struct unit_test_state *uts)
+{
+	struct hsearch_data htab;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+
+	ut_assertok(htab_fill(uts, &htab, ITERATIONS / 10));
+	ut_assertok(htab_check_fill(uts, &htab, ITERATIONS / 10));
+	ut_asserteq(ITERATIONS / 10, htab.filled);
+
+	/* At least a quarter of the table is kept free */
+	ut_assert(htab.filled * 4 <= htab.size * 3);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+ENV_TEST(env_test_htab_grow, 0);
+
+/* Import over an existing table, keeping the entries which are unchanged */
+static int env_test_htab_reimport(struct unit_test_state *uts)
+{
+	static const char env1[] = "a=1\0b=2\0c=3\0";
+	static const char env2[] = "a=1\0b=5\0d=4\0c=\0";
+	struct env_entry item, *ep;
+	struct hsearch_data htab;
+	const char *adata;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, himport_r(&htab, env1, sizeof(env1), '\0', 0, 0, 0,
+				 NULL));
+	ut_asserteq(3, htab.filled);
+
+	item.key = "a";
+	ut_assert(hsearch_r(item, ENV_FIND, &ep, &htab, 0));
+	adata = ep->data;
+
+	ut_asserteq(1, himport_r(&htab, env2, sizeof(env2), '\0', 0, 0, 0,
+				 NULL));
+	ut_asserteq(3, htab.filled);
+
+	/* The entry for 'a' is the same one */
+	ut_assert(hsearch_r(item, ENV_FIND, &ep, &htab, 0));
+	ut_asserteq_ptr(adata, ep->data);
+	ut_asserteq_str("1", ep->data);
+
+	item.key = "b";
+	ut_assert(hsearch_r(item, ENV_FIND, &ep, &htab, 0));
+	ut_asserteq_str("5", ep->data);
+
+	item.key = "c";
+	ut_assert(!hsearch_r(item, ENV_FIND, &ep, &htab, 0));
+
+	item.key = "d";
+	ut_assert(hsearch_r(item, ENV_FIND, &ep, &htab, 0));
+	ut_asserteq_str("4", ep->data);
+
+	/* Importing nothing empties the table */
+	ut_asserteq(1, himport_r(&htab, env2, 0, '\0', 0, 0, 0, NULL));
+	ut_asserteq(0, htab.filled);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+ENV_TEST(env_test_htab_reimport, 0);
@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the journal of environment changes
+ */
+
+#include <env.h>
+#include <env_internal.h>
+#include <malloc.h>
+#include <test/env.h>
+#include <test/ut.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+
+#define SEED	0x12345678
+
+/* Add a record of the changes to the journal in @buf */
+static int journal_add(struct unit_test_state *uts, char *buf, uint size,
+		       uint expect_pos)
+{
+	void *rec;
+	uint pos;
+	int len;
+
+	len = env_journal_add(size, &rec, &pos);
+	ut_assert(len > 0);
+	ut_asserteq(expect_pos, pos);
+	memcpy(buf + pos, rec, len);
+	free(rec);
+	env_journal_added(len);
+
+	return len;
+}
+
+/* Test saving changes to the journal and replaying them */
+static int env_test_journal(struct unit_test_state *uts)
+{
+	char buf[0x100];
+	void *rec;
+	uint pos;
+	int len;
+
+	memset(buf, 0xff, sizeof(buf));
+	ut_assertok(env_set("jtest", NULL));
+	ut_assertok(env_set("jtest2", NULL));
+	ut_asserteq(0, env_journal_load(buf, sizeof(buf), SEED));
+	ut_asserteq(0, env_journal_add(sizeof(buf), &rec, &pos));
+
+	ut_assertok(env_set("jtest", "1"));
+	len = journal_add(uts, buf, sizeof(buf), 0);
+
+	/* A deletion and an addition in the same record */
+	ut_assertok(env_set("jtest", NULL));
+	ut_assertok(env_set("jtest2", "2"));
+	journal_add(uts, buf, sizeof(buf), len);
+
+	/* Go back to the original environment and replay the journal */
+	ut_assertok(env_set("jtest", "3"));
+	ut_assertok(env_set("jtest2", NULL));
+	ut_asserteq(2, env_journal_load(buf, sizeof(buf), SEED));
+	ut_assertnull(env_get("jtest"));
+	ut_asserteq_str("2", env_get("jtest2"));
+
+	/* A journal for another environment is not replayed */
+	ut_assertok(env_set("jtest2", NULL));
+	ut_asserteq(0, env_journal_load(buf, sizeof(buf), SEED + 1));
+	ut_assertnull(env_get("jtest2"));
+
+	/* ...so the whole environment must be saved */
+	ut_assertok(env_set("jtest", "4"));
+	ut_asserteq(-ENOSPC, env_journal_add(sizeof(buf), &rec, &pos));
+
+	/* Once saved, the journal is empty but cannot take a large change */
+	env_journal_reset(SEED);
+	ut_asserteq(0, env_journal_add(sizeof(buf), &rec, &pos));
+	memset(buf, 'x', sizeof(buf) - 1);
+	buf[sizeof(buf) - 1] = '\0';
+	ut_assertok(env_set("jtest", buf));
+	ut_asserteq(-ENOSPC, env_journal_add(sizeof(buf), &rec, &pos));
+
+	ut_assertok(env_set("jtest", NULL));
+	env_journal_reset(SEED);
+
+	return 0;
+}
+ENV_TEST(env_test_journal, 0);
@@ -137,3 +137,23 @@ static int hush_test_or_and(struct unit_test_state *uts)
 	return 0;
 }
 HUSH_TEST(hush_test_or_and, 0);
+
+static int hush_test_list_len(struct unit_test_state *uts)
+{
+	static const char script[] = "echo foo\necho bar; echo baz";
+
+	/* Stop before the last command, with no newline or nul there */
+	ut_assertok(run_command_list(script, strlen("echo foo\necho bar"), 0));
+	ut_assert_nextline("foo");
+	ut_assert_nextline("bar");
+	ut_assert_console_end();
+
+	ut_assertok(run_command_list(script, sizeof(script) - 1, 0));
+	ut_assert_nextline("foo");
+	ut_assert_nextline("bar");
+	ut_assert_nextline("baz");
+	ut_assert_console_end();
+
+	return 0;
+}
+HUSH_TEST(hush_test_list_len, UTF_CONSOLE);
@@ -83,3 +83,34 @@ static int hush_test_until(struct unit_test_state *uts)
 	return 0;
 }
 HUSH_TEST(hush_test_until, UTF_CONSOLE);
+
+static int hush_test_run_loop(struct unit_test_state *uts)
+{
+	ut_assertok(env_set("loop_script",
+			    "for loop_j in foo bar; do echo $loop_j; done"));
+
+	/* The second run may use the script parsed by the first */
+	ut_assertok(run_command("run loop_script", 0));
+	ut_assert_nextline("foo");
+	ut_assert_nextline("bar");
+	ut_assertok(run_command("run loop_script", 0));
+	ut_assert_nextline("foo");
+	ut_assert_nextline("bar");
+
+	/* A changed script must be parsed again */
+	ut_assertok(env_set("loop_script", "echo quux"));
+	ut_assertok(run_command("run loop_script", 0));
+	ut_assert_nextline("quux");
+	ut_assert_console_end();
+
+	env_set("loop_script", NULL);
+	if (gd->flags & GD_FLG_HUSH_MODERN_PARSER) {
+		/* Reset local variable. */
+		ut_assertok(run_command("loop_j=", 0));
+	} else if (gd->flags & GD_FLG_HUSH_OLD_PARSER) {
+		puts("Beware: this test set local variable loop_j and it cannot be unset!");
+	}
+
+	return 0;
+}
+HUSH_TEST(hush_test_run_loop, UTF_CONSOLE);
@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Test batched cache maintenance
+ */
+
+#include <cpu_func.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Test that ranges are merged when they touch, and not otherwise */
+static int lib_test_dcache_batch(struct unit_test_state *uts)
+{
+	struct dcache_batch batch;
+	int i;
+
+	dcache_batch_init(&batch);
+	dcache_batch_flush(&batch, 0x1000, 0x1040);
+	dcache_batch_flush(&batch, 0x1040, 0x1080);
+	ut_asserteq(1, batch.num_flush);
+	ut_asserteq(0x1000, batch.flush[0].start);
+	ut_asserteq(0x1080, batch.flush[0].end);
+
+	/* A separate range, then one which joins them up */
+	dcache_batch_flush(&batch, 0x2000, 0x2040);
+	ut_asserteq(2, batch.num_flush);
+	dcache_batch_flush(&batch, 0x1070, 0x2010);
+	ut_asserteq(1, batch.num_flush);
+	ut_asserteq(0x1000, batch.flush[0].start);
+	ut_asserteq(0x2040, batch.flush[0].end);
+
+	/* Invalidation is kept separate */
+	dcache_batch_invalidate(&batch, 0x1000, 0x1040);
+	ut_asserteq(1, batch.num_flush);
+	ut_asserteq(1, batch.num_inval);
+
+	dcache_batch_sync(&batch);
+	ut_asserteq(0, batch.num_flush);
+	ut_asserteq(0, batch.num_inval);
+
+	/* When the batch is full it is synced before adding more */
+	for (i = 0; i <= DCACHE_BATCH_RANGES; i++)
+		dcache_batch_flush(&batch, 0x1000 * i, 0x1000 * i + 0x40);
+	ut_asserteq(1, batch.num_flush);
+	ut_asserteq(0x1000 * DCACHE_BATCH_RANGES, batch.flush[0].start);
+	dcache_batch_sync(&batch);
+
+	return 0;
+}
+LIB_TEST(lib_test_dcache_batch, 0);
@@ -0,0 +1,196 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for writing Android sparse images
+ */
+
+#include <image-sparse.h>
+#include <malloc.h>
+#include <linux/sizes.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+#define SPARSE_TEST_BLKSZ	512
+#define SPARSE_TEST_BLOCKS	32
+#define SPARSE_TEST_FILL	0x12345678
+
+/**
+ * struct sparse_test_dev - Block device written by the sparse image tests
+ *
+ * @disk: Device contents
+ * @writes: Number of calls to write()
+ * @zeroes: Number of calls to write_zeroes()
+ * @can_zero: true if write_zeroes() zeroes the blocks, else it does nothing
+ */
+struct sparse_test_dev {
+	u8 disk[SPARSE_TEST_BLOCKS * SPARSE_TEST_BLKSZ];
+	int writes;
+	int zeroes;
+	bool can_zero;
+};
+
+static lbaint_t sparse_test_write(struct sparse_storage *info, lbaint_t blk,
+				  lbaint_t blkcnt, const void *buffer)
+{
+	struct sparse_test_dev *dev = info->priv;
+
+	dev->writes++;
+	memcpy(dev->disk + blk * info->blksz, buffer, blkcnt * info->blksz);
+
+	return blkcnt;
+}
+
+static lbaint_t sparse_test_reserve(struct sparse_storage *info, lbaint_t blk,
+				    lbaint_t blkcnt)
+{
+	return blkcnt;
+}
+
+static lbaint_t sparse_test_write_zeroes(struct sparse_storage *info,
+					 lbaint_t blk, lbaint_t blkcnt)
+{
+	struct sparse_test_dev *dev = info->priv;
+
+	dev->zeroes++;
+	if (!dev->can_zero)
+		return 0;
+	memset(dev->disk + blk * info->blksz, '\0', blkcnt * info->blksz);
+
+	return blkcnt;
+}
+
+/* Add a chunk header, returning a pointer to where its data goes */
+static void *sparse_test_chunk(void *p, int type, int blocks, int data_size)
+{
+	chunk_header_t *chunk = p;
+
+	chunk->chunk_type = type;
+	chunk->reserved1 = 0;
+	chunk->chunk_sz = blocks;
+	chunk->total_sz = sizeof(*chunk) + data_size;
+
+	return chunk + 1;
+}
+
+/* Add a RAW chunk where each block is filled with its number */
+static void *sparse_test_raw(void *p, int first, int blocks)
+{
+	int i;
+
+	p = sparse_test_chunk(p, CHUNK_TYPE_RAW, blocks,
+			      blocks * SPARSE_TEST_BLKSZ);
+	for (i = 0; i < blocks; i++, p += SPARSE_TEST_BLKSZ)
+		memset(p, first + i, SPARSE_TEST_BLKSZ);
+
+	return p;
+}
+
+static void *sparse_test_fill(void *p, int blocks, u32 val)
+{
+	p = sparse_test_chunk(p, CHUNK_TYPE_FILL, blocks, sizeof(u32));
+	memcpy(p, &val, sizeof(val));
+
+	return p + sizeof(val);
+}
+
+/* Check that @dev holds the image built by lib_test_image_sparse() */
+static int sparse_test_check(struct unit_test_state *uts,
+			     struct sparse_test_dev *dev)
+{
+	u32 fill = SPARSE_TEST_FILL;
+	u8 *blk;
+	int i;
+
+	for (i = 0; i < 15; i++) {
+		blk = dev->disk + (1 + i) * SPARSE_TEST_BLKSZ;
+		if (i < 5 || i == 14) {
+			/* RAW */
+			ut_asserteq(i, blk[0]);
+			ut_asserteq(i, blk[SPARSE_TEST_BLKSZ - 1]);
+		} else if (i < 7) {
+			/* DONT_CARE */
+			ut_asserteq(0xee, blk[0]);
+		} else if (i < 11) {
+			ut_asserteq(0, blk[0]);
+			ut_asserteq(0, blk[SPARSE_TEST_BLKSZ - 1]);
+		} else {
+			ut_asserteq_mem(&fill, blk, sizeof(fill));
+			ut_asserteq_mem(&fill, blk + SPARSE_TEST_BLKSZ - 4,
+					sizeof(fill));
+		}
+	}
+
+	/* Nothing is written outside the image */
+	ut_asserteq(0xee, dev->disk[SPARSE_TEST_BLKSZ - 1]);
+	ut_asserteq(0xee, dev->disk[16 * SPARSE_TEST_BLKSZ]);
+
+	return 0;
+}
+
+static int lib_test_image_sparse(struct unit_test_state *uts)
+{
+	struct sparse_storage info = {
+		.blksz = SPARSE_TEST_BLKSZ,
+		.start = 1,
+		.size = SPARSE_TEST_BLOCKS - 1,
+		.write = sparse_test_write,
+		.reserve = sparse_test_reserve,
+		.write_zeroes = sparse_test_write_zeroes,
+	};
+	sparse_header_t *hdr;
+	struct sparse_test_dev *dev;
+	void *image, *p;
+
+	image = malloc(SZ_16K);
+	ut_assertnonnull(image);
+	dev = calloc(1, sizeof(*dev));
+	ut_assertnonnull(dev);
+	info.priv = dev;
+
+	/* Two RAW chunks in a row, DONT_CARE, zero and non-zero FILL, RAW */
+	hdr = image;
+	hdr->magic = SPARSE_HEADER_MAGIC;
+	hdr->major_version = 1;
+	hdr->minor_version = 0;
+	hdr->file_hdr_sz = sizeof(*hdr);
+	hdr->chunk_hdr_sz = sizeof(chunk_header_t);
+	hdr->blk_sz = SPARSE_TEST_BLKSZ;
+	hdr->total_blks = 15;
+	hdr->total_chunks = 6;
+	hdr->image_checksum = 0;
+	p = sparse_test_raw(hdr + 1, 0, 2);
+	p = sparse_test_raw(p, 2, 3);
+	p = sparse_test_chunk(p, CHUNK_TYPE_DONT_CARE, 2, 0);
+	p = sparse_test_fill(p, 4, 0);
+	p = sparse_test_fill(p, 3, SPARSE_TEST_FILL);
+	sparse_test_raw(p, 14, 1);
+	ut_assert(is_sparse_image(image));
+
+	/* The first two RAW chunks go in the same write */
+	memset(dev->disk, 0xee, sizeof(dev->disk));
+	dev->can_zero = true;
+	ut_assertok(write_sparse_image(&info, "test", image, NULL));
+	ut_assertok(sparse_test_check(uts, dev));
+	ut_asserteq(3, dev->writes);
+	ut_asserteq(1, dev->zeroes);
+
+	/* Without write_zeroes() support the zeroes are written */
+	memset(dev->disk, 0xee, sizeof(dev->disk));
+	dev->can_zero = false;
+	dev->writes = 0;
+	dev->zeroes = 0;
+	ut_assertok(write_sparse_image(&info, "test", image, NULL));
+	ut_assertok(sparse_test_check(uts, dev));
+	ut_asserteq(4, dev->writes);
+	ut_asserteq(1, dev->zeroes);
+
+	/* Too large for the partition */
+	info.size = 14;
+	ut_asserteq(-1, write_sparse_image(&info, "test", image, NULL));
+
+	free(dev);
+	free(image);
+
+	return 0;
+}
+LIB_TEST(lib_test_image_sparse, 0);
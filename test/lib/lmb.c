@@ -802,3 +802,117 @@ static int lib_test_lmb_flags(struct unit_test_state *uts)
 	return 0;
 }
 LIB_TEST(lib_test_lmb_flags, 0);
+
+/* Check lookups and allocation with many reserved regions */
+static int lib_test_lmb_many(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t ram_size = 0x1000000;
+	const phys_size_t step = 0x4000, rsv_size = 0x1000;
+	const int count = 100;
+	struct alist *mem_lst, *used_lst;
+	struct lmb_region *used;
+	struct lmb store;
+	phys_addr_t addr;
+	int i;
+
+	ut_assertok(setup_lmb_test(uts, &store, &mem_lst, &used_lst));
+	ut_assertok(lmb_add(ram, ram_size));
+
+	/* Reserve top-down, so each region goes at the start of the list */
+	for (i = count - 1; i >= 0; i--)
+		ut_assertok(lmb_reserve(ram + i * step, rsv_size));
+	ut_asserteq(count, used_lst->count);
+	used = used_lst->data;
+	for (i = 0; i < count; i++) {
+		ut_asserteq(ram + i * step, used[i].base);
+		ut_asserteq(rsv_size, used[i].size);
+	}
+
+	for (i = 0; i < count; i++) {
+		addr = ram + i * step;
+		ut_asserteq(1, lmb_is_reserved_flags(addr + rsv_size - 1,
+						     LMB_NONE));
+		ut_asserteq(0, lmb_is_reserved_flags(addr + rsv_size,
+						     LMB_NONE));
+		ut_asserteq(0, lmb_get_free_size(addr));
+		if (i < count - 1)
+			ut_asserteq(step - rsv_size,
+				    lmb_get_free_size(addr + rsv_size));
+	}
+	ut_asserteq(ram + ram_size - (ram + (count - 1) * step + rsv_size),
+		    lmb_get_free_size(ram + (count - 1) * step + rsv_size));
+
+	/* Filling a gap merges the regions either side */
+	ut_asserteq(2, lmb_reserve(ram + rsv_size, step - rsv_size));
+	ut_asserteq(count - 1, used_lst->count);
+	used = used_lst->data;
+	ut_asserteq(ram, used[0].base);
+	ut_asserteq(step + rsv_size, used[0].size);
+
+	/* Free a region in the middle, then allocate part of the larger gap */
+	addr = ram + 50 * step;
+	ut_assertok(lmb_free(addr, rsv_size));
+	ut_asserteq(count - 2, used_lst->count);
+	ut_asserteq(0, lmb_is_reserved_flags(addr, LMB_NONE));
+	ut_asserteq(addr, lmb_alloc_addr(addr, rsv_size * 2));
+	ut_asserteq(count - 1, used_lst->count);
+
+	/* Allocation below a limit uses the highest gap which fits */
+	addr = lmb_alloc_base(step - rsv_size, rsv_size, ram + 10 * step);
+	ut_asserteq(ram + 9 * step + rsv_size, addr);
+	addr = lmb_alloc_base(step - rsv_size, rsv_size, ram + 10 * step);
+	ut_asserteq(ram + 8 * step + rsv_size, addr);
+
+	/* Splitting a region keeps the list in order */
+	addr = ram + 20 * step;
+	ut_assertok(lmb_free(addr + 0x400, 0x400));
+	used = used_lst->data;
+	for (i = 1; i < used_lst->count; i++)
+		ut_assert(used[i - 1].base + used[i - 1].size <= used[i].base);
+	ut_asserteq(0x400, lmb_get_free_size(addr + 0x400));
+
+	lmb_pop(&store);
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_many, 0);
+
+/* Check reserving a region which is next to one region and overlaps another */
+static int lib_test_lmb_adjacent_overlap(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	struct alist *mem_lst, *used_lst;
+	struct lmb_region *used;
+	struct lmb store;
+
+	ut_assertok(setup_lmb_test(uts, &store, &mem_lst, &used_lst));
+	ut_assertok(lmb_add(ram, 0x100000));
+
+	/* The region below has different flags */
+	ut_assertok(lmb_reserve_flags(ram, 0x1000, LMB_NOOVERWRITE));
+	ut_assertok(lmb_reserve(ram + 0x2000, 0x1000));
+	ut_asserteq(1, lmb_reserve(ram + 0x1000, 0x2000));
+	ASSERT_LMB(mem_lst, used_lst, ram, 0x100000, 2, ram, 0x1000,
+		   ram + 0x1000, 0x2000, 0, 0);
+
+	/* The region below has the same flags */
+	ut_assertok(lmb_reserve(ram + 0x10000, 0x1000));
+	ut_assertok(lmb_reserve(ram + 0x12000, 0x800));
+	ut_asserteq(2, lmb_reserve(ram + 0x11000, 0x3000));
+	ut_asserteq(3, used_lst->count);
+	used = used_lst->data;
+	ut_asserteq(ram + 0x10000, used[2].base);
+	ut_asserteq(0x4000, used[2].size);
+
+	/* A region with different flags cannot be merged over */
+	ut_assertok(lmb_reserve_flags(ram + 0x16000, 0x1000, LMB_NOMAP));
+	ut_asserteq(-1, lmb_reserve(ram + 0x14000, 0x3000));
+	ut_asserteq(4, used_lst->count);
+	ut_asserteq(0x4000, used[2].size);
+
+	lmb_pop(&store);
+
+	return 0;
+}
+LIB_TEST(lib_test_lmb_adjacent_overlap, 0);
@@ -11,9 +11,12 @@
 
 #include <command.h>
 #include <log.h>
+#include <malloc.h>
+#include <time.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
+#include <linux/sizes.h>
 
 /* Xor mask used for marking memory regions */
 #define MASK 0xA5
@@ -221,3 +224,192 @@ static int lib_memdup(struct unit_test_state *uts)
 	return 0;
 }
 LIB_TEST(lib_memdup, 0);
+
+/**
+ * lib_strlen_strchr() - unit test for strlen(), strchr() and memchr()
+ *
+ * Test the search functions with varied alignment and length of the string.
+ * Each byte in the buffer is different, so each character can be found in one
+ * place only.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_strlen_strchr(struct unit_test_state *uts)
+{
+	char buf[BUFLEN];
+	int offset, len, pos;
+
+	for (offset = 0; offset <= SWEEP; ++offset) {
+		for (len = 0; len < BUFLEN - SWEEP; ++len) {
+			char *str = buf + offset;
+
+			init_buffer((u8 *)buf, MASK);
+			str[len] = '\0';
+			ut_asserteq(len, strlen(str));
+			ut_asserteq_ptr(str + len, strchr(str, '\0'));
+			ut_assertnull(strchr(str, 1));
+			ut_assertnull(memchr(str, 1, BUFLEN - offset));
+			ut_asserteq_ptr(str + len, memchr(str, '\0',
+							  BUFLEN - offset));
+			for (pos = 0; pos < len; pos++) {
+				ut_asserteq_ptr(str + pos, strchr(str, str[pos]));
+				ut_asserteq_ptr(str + pos,
+						memchr(str, str[pos], len));
+				ut_assertnull(memchr(str, str[pos], pos));
+			}
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_strlen_strchr, 0);
+
+/**
+ * lib_strcmp_memcmp() - unit test for strcmp() and memcmp()
+ *
+ * Test the compare functions with varied alignment and length of the buffers,
+ * changing each byte in turn so that the buffers differ there.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_strcmp_memcmp(struct unit_test_state *uts)
+{
+	int len = BUFLEN - SWEEP - 1;
+	char buf1[BUFLEN];
+	char buf2[BUFLEN];
+	char src[BUFLEN];
+	int offset1, offset2, pos;
+
+	/* All bytes in src are above 0x80 */
+	init_buffer((u8 *)src, MASK);
+	for (offset1 = 0; offset1 <= SWEEP; ++offset1) {
+		for (offset2 = 0; offset2 <= SWEEP; ++offset2) {
+			char *str1 = buf1 + offset1;
+			char *str2 = buf2 + offset2;
+
+			memcpy(str1, src, len);
+			memcpy(str2, src, len);
+			str1[len] = '\0';
+			str2[len] = '\0';
+			ut_asserteq(0, strcmp(str1, str2));
+			ut_asserteq(0, memcmp(str1, str2, len));
+
+			for (pos = 0; pos < len; pos++) {
+				/* compare as unsigned, so 0x80 is above 0x7f */
+				str2[pos] = 0x80;
+				str1[pos] = 0x7f;
+				ut_assert(strcmp(str1, str2) < 0);
+				ut_assert(strcmp(str2, str1) > 0);
+				ut_assert(memcmp(str1, str2, len) < 0);
+				ut_assert(memcmp(str2, str1, len) > 0);
+				ut_asserteq(0, memcmp(str1, str2, pos));
+
+				/* a shorter string is less than a longer one */
+				str1[pos] = '\0';
+				str2[pos] = 1;
+				ut_assert(strcmp(str1, str2) < 0);
+				str2[pos] = '\0';
+				ut_asserteq(0, strcmp(str1, str2));
+
+				str1[pos] = src[pos];
+				str2[pos] = src[pos];
+			}
+		}
+	}
+
+	return 0;
+}
+LIB_TEST(lib_strcmp_memcmp, 0);
+
+/* Size of the buffer used for the benchmark */
+#define BENCH_SIZE	SZ_64K
+/* Number of times to run each function */
+#define BENCH_LOOPS	100
+
+static void bench_show(const char *name, ulong start)
+{
+	ulong us = timer_get_us() - start;
+
+	printf("%-8s %8lu us %8llu MB/s\n", name, us,
+	       us ? (u64)BENCH_SIZE * BENCH_LOOPS / us : 0);
+}
+
+/**
+ * lib_string_bench_norun() - benchmark the string functions
+ *
+ * Run each function over a large buffer and show how long it takes. The
+ * barrier stops the compiler from hoisting calls out of the loop. This is
+ * useful for comparing the architecture-specific versions with those in
+ * lib/string.c:
+ *
+ *	ut lib -f lib_string_bench_norun
+ *
+ * On sandbox, pass -v to see the output.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_string_bench_norun(struct unit_test_state *uts)
+{
+	char *buf1, *buf2;
+	ulong start;
+	int i;
+
+	buf1 = malloc(BENCH_SIZE);
+	ut_assertnonnull(buf1);
+	buf2 = malloc(BENCH_SIZE);
+	ut_assertnonnull(buf2);
+	memset(buf1, 'a', BENCH_SIZE - 1);
+	buf1[BENCH_SIZE - 1] = '\0';
+	memcpy(buf2, buf1, BENCH_SIZE);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		barrier();
+		ut_asserteq(BENCH_SIZE - 1, strlen(buf1));
+	}
+	bench_show("strlen", start);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		barrier();
+		ut_assertnull(strchr(buf1, 'b'));
+	}
+	bench_show("strchr", start);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		barrier();
+		ut_asserteq(0, strcmp(buf1, buf2));
+	}
+	bench_show("strcmp", start);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		barrier();
+		ut_assertnull(memchr(buf1, 'b', BENCH_SIZE));
+	}
+	bench_show("memchr", start);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		barrier();
+		ut_asserteq(0, memcmp(buf1, buf2, BENCH_SIZE));
+	}
+	bench_show("memcmp", start);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		barrier();
+		memmove(buf2 + 1, buf2, BENCH_SIZE - 1);
+	}
+	bench_show("memmove", start);
+
+	free(buf2);
+	free(buf1);
+
+	return 0;
+}
+LIB_TEST(lib_string_bench_norun, UTF_MANUAL);
@@ -7,8 +7,11 @@
 
 #include <command.h>
 #include <hexdump.h>
+#include <malloc.h>
 #include <rand.h>
+#include <time.h>
 #include <uboot_aes.h>
+#include <linux/sizes.h>
 #include <test/lib.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -164,3 +167,116 @@ static int lib_test_aes(struct unit_test_state *uts)
 	return ret;
 }
 LIB_TEST(lib_test_aes, 0);
+
+/* An odd number of blocks, to cover any multi-block paths and the tail */
+#define CBC_BLOCKS	19
+#define CBC_LEN		(CBC_BLOCKS * AES_BLOCK_LENGTH)
+
+/* Check against NIST SP 800-38A F.2.1 and against the portable code */
+static int lib_test_aes_cbc_known(struct unit_test_state *uts)
+{
+	static const u8 key[AES128_KEY_LENGTH] = {
+		0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+		0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c,
+	};
+	static const u8 plain[AES_BLOCK_LENGTH] = {
+		0x6b, 0xc1, 0xbe, 0xe2, 0x2e, 0x40, 0x9f, 0x96,
+		0xe9, 0x3d, 0x7e, 0x11, 0x73, 0x93, 0x17, 0x2a,
+	};
+	static const u8 cipher[AES_BLOCK_LENGTH] = {
+		0x76, 0x49, 0xab, 0xac, 0x81, 0x19, 0xb2, 0x46,
+		0xce, 0xe9, 0x8e, 0x9b, 0x12, 0xe9, 0x19, 0x7d,
+	};
+	u8 key_exp[AES256_EXPAND_KEY_LENGTH];
+	u8 iv[AES_BLOCK_LENGTH], buf[AES_BLOCK_LENGTH];
+	u8 k[AES256_KEY_LENGTH];
+	u8 src[CBC_LEN], dst[CBC_LEN], ref[CBC_LEN];
+	int i, key_len;
+
+	for (i = 0; i < AES_BLOCK_LENGTH; i++)
+		iv[i] = i;
+	aes_expand_key((u8 *)key, AES128_KEY_LENGTH, key_exp);
+	aes_cbc_encrypt_blocks(AES128_KEY_LENGTH, key_exp, iv, (u8 *)plain,
+			       buf, 1);
+	ut_asserteq_mem(cipher, buf, AES_BLOCK_LENGTH);
+	aes_cbc_decrypt_blocks(AES128_KEY_LENGTH, key_exp, iv, (u8 *)cipher,
+			       buf, 1);
+	ut_asserteq_mem(plain, buf, AES_BLOCK_LENGTH);
+
+	for (key_len = AES128_KEY_LENGTH; key_len <= AES256_KEY_LENGTH;
+	     key_len += 8) {
+		rand_buf(k, key_len);
+		rand_buf(iv, AES_BLOCK_LENGTH);
+		rand_buf(src, CBC_LEN);
+		aes_expand_key(k, key_len, key_exp);
+
+		aes_cbc_encrypt_blocks(key_len, key_exp, iv, src, dst,
+				       CBC_BLOCKS);
+		aes_cbc_encrypt_blocks_generic(key_len, key_exp, iv, src, ref,
+					       CBC_BLOCKS);
+		ut_asserteq_mem(ref, dst, CBC_LEN);
+
+		aes_cbc_decrypt_blocks(key_len, key_exp, iv, src, dst,
+				       CBC_BLOCKS);
+		aes_cbc_decrypt_blocks_generic(key_len, key_exp, iv, src, ref,
+					       CBC_BLOCKS);
+		ut_asserteq_mem(ref, dst, CBC_LEN);
+	}
+
+	return 0;
+}
+LIB_TEST(lib_test_aes_cbc_known, 0);
+
+#define BENCH_SIZE	SZ_1M
+
+/**
+ * lib_aes_bench_norun() - benchmark AES-CBC
+ *
+ * Show how long it takes to encrypt and decrypt 1MB with each key size:
+ *
+ *	ut lib -f lib_aes_bench_norun
+ *
+ * On sandbox, pass -v to see the output.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_aes_bench_norun(struct unit_test_state *uts)
+{
+	const u32 num_block = BENCH_SIZE / AES_BLOCK_LENGTH;
+	u8 key_exp[AES256_EXPAND_KEY_LENGTH];
+	u8 key[AES256_KEY_LENGTH];
+	u8 iv[AES_BLOCK_LENGTH];
+	int key_len;
+	ulong start, us;
+	u8 *buf;
+
+	buf = malloc(BENCH_SIZE);
+	ut_assertnonnull(buf);
+	rand_buf(buf, BENCH_SIZE);
+	rand_buf(iv, AES_BLOCK_LENGTH);
+
+	for (key_len = AES128_KEY_LENGTH; key_len <= AES256_KEY_LENGTH;
+	     key_len += 8) {
+		rand_buf(key, key_len);
+		aes_expand_key(key, key_len, key_exp);
+
+		start = timer_get_us();
+		aes_cbc_encrypt_blocks(key_len, key_exp, iv, buf, buf,
+				       num_block);
+		us = timer_get_us() - start;
+		printf("AES-%d encrypt %8lu us %8lu KB/s\n", key_len * 8, us,
+		       us ? (ulong)((u64)BENCH_SIZE * 1000 / 1024 / us) : 0);
+
+		start = timer_get_us();
+		aes_cbc_decrypt_blocks(key_len, key_exp, iv, buf, buf,
+				       num_block);
+		us = timer_get_us() - start;
+		printf("AES-%d decrypt %8lu us %8lu KB/s\n", key_len * 8, us,
+		       us ? (ulong)((u64)BENCH_SIZE * 1000 / 1024 / us) : 0);
+	}
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_aes_bench_norun, UTF_MANUAL);
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit tests for the software BCH encoder and decoder
+ */
+
+#include <errno.h>
+#include <malloc.h>
+#include <time.h>
+#include <linux/bch.h>
+#include <test/lib.h>
+#include <test/ut.h>
+
+/* Parameters used by nand_bch for 8-bit correction over 512-byte steps */
+#define BCH_M		13
+#define BCH_T		8
+#define BCH_LEN		512
+#define BENCH_LOOPS	2000
+
+static void fill_data(u8 *data, uint seed)
+{
+	int i;
+
+	for (i = 0; i < BCH_LEN; i++)
+		data[i] = (i * 37 + seed * 101) ^ (i >> 3);
+}
+
+/* Flip @count distinct bits, spread over the data and the ECC bytes */
+static void flip_bits(u8 *data, u8 *ecc, uint ecc_bytes, int count)
+{
+	uint nbits = (BCH_LEN + ecc_bytes) * 8;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		uint bit = (i * 1021 + 13) % nbits;
+
+		if (bit < BCH_LEN * 8)
+			data[bit / 8] ^= 1 << (bit & 7);
+		else
+			ecc[bit / 8 - BCH_LEN] ^= 1 << (bit & 7);
+	}
+}
+
+static int lib_bch(struct unit_test_state *uts)
+{
+	unsigned int errloc[BCH_T];
+	struct bch_control *bch;
+	u8 data[BCH_LEN], orig[BCH_LEN];
+	u8 ecc[16], calc[16];
+	int count, i;
+
+	bch = init_bch(BCH_M, BCH_T, 0);
+	ut_assertnonnull(bch);
+	ut_assert(bch->ecc_bytes <= sizeof(ecc));
+
+	for (count = 0; count <= BCH_T; count++) {
+		fill_data(orig, count);
+		memcpy(data, orig, BCH_LEN);
+		memset(ecc, '\0', sizeof(ecc));
+		encode_bch(bch, data, BCH_LEN, ecc);
+
+		flip_bits(data, ecc, bch->ecc_bytes, count);
+		memset(calc, '\0', sizeof(calc));
+		encode_bch(bch, data, BCH_LEN, calc);
+		ut_asserteq(count, decode_bch(bch, data, BCH_LEN, ecc, calc,
+					      NULL, errloc));
+
+		for (i = 0; i < count; i++) {
+			if (errloc[i] < BCH_LEN * 8)
+				data[errloc[i] / 8] ^= 1 << (errloc[i] & 7);
+		}
+		ut_asserteq_mem(orig, data, BCH_LEN);
+	}
+
+	/* one error too many cannot be corrected */
+	fill_data(data, 0);
+	memset(ecc, '\0', sizeof(ecc));
+	encode_bch(bch, data, BCH_LEN, ecc);
+	flip_bits(data, ecc, bch->ecc_bytes, BCH_T + 1);
+	memset(calc, '\0', sizeof(calc));
+	encode_bch(bch, data, BCH_LEN, calc);
+	ut_asserteq(-EBADMSG, decode_bch(bch, data, BCH_LEN, ecc, calc, NULL,
+					 errloc));
+	free_bch(bch);
+
+	return 0;
+}
+LIB_TEST(lib_bch, 0);
+
+static void bench_show(const char *name, ulong start)
+{
+	ulong us = timer_get_us() - start;
+
+	printf("%-8s %8lu us %8llu KB/s\n", name, us,
+	       us ? (u64)BCH_LEN * BENCH_LOOPS * 1000 / 1024 / us : 0);
+}
+
+/**
+ * lib_bch_bench_norun() - benchmark BCH encoding and decoding
+ *
+ * Show how long it takes to encode a step, to check a clean step and to
+ * correct a step with the maximum number of errors:
+ *
+ *	ut lib -f lib_bch_bench_norun
+ *
+ * On sandbox, pass -v to see the output.
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_bch_bench_norun(struct unit_test_state *uts)
+{
+	unsigned int errloc[BCH_T];
+	struct bch_control *bch;
+	u8 data[BCH_LEN], bad[BCH_LEN];
+	u8 ecc[16], calc[16], bad_ecc[16];
+	ulong start;
+	int i;
+
+	bch = init_bch(BCH_M, BCH_T, 0);
+	ut_assertnonnull(bch);
+
+	fill_data(data, 0);
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		memset(ecc, '\0', sizeof(ecc));
+		encode_bch(bch, data, BCH_LEN, ecc);
+	}
+	bench_show("encode", start);
+
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		memset(calc, '\0', sizeof(calc));
+		encode_bch(bch, data, BCH_LEN, calc);
+		ut_asserteq(0, decode_bch(bch, data, BCH_LEN, ecc, calc, NULL,
+					  errloc));
+	}
+	bench_show("clean", start);
+
+	memcpy(bad, data, BCH_LEN);
+	memcpy(bad_ecc, ecc, sizeof(ecc));
+	flip_bits(bad, bad_ecc, bch->ecc_bytes, BCH_T);
+	start = timer_get_us();
+	for (i = 0; i < BENCH_LOOPS; i++) {
+		memset(calc, '\0', sizeof(calc));
+		encode_bch(bch, bad, BCH_LEN, calc);
+		ut_asserteq(BCH_T, decode_bch(bch, bad, BCH_LEN, bad_ecc, calc,
+					      NULL, errloc));
+	}
+	bench_show("correct", start);
+	free_bch(bch);
+
+	return 0;
+}
+LIB_TEST(lib_bch_bench_norun, UTF_MANUAL);
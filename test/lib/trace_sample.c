@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Test the sampling profiler
+ */
+
+#include <malloc.h>
+#include <time.h>
+#include <trace.h>
+#include <vsprintf.h>
+#include <asm/global_data.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* End of the mapping line written after the pprof samples */
+#define MAP_SUFFIX	" r-xp 00000000 00:00 0 u-boot\n"
+
+/* Burn some CPU time somewhere that the samples can be checked against */
+static noinline ulong sample_busy(ulong loops)
+{
+	volatile ulong val = 0;
+
+	while (loops--)
+		val += loops;
+
+	return val;
+}
+
+static int lib_test_trace_sample(struct unit_test_state *uts)
+{
+	ulong func, pc, start, *hdr;
+	int len, maplen, found, callers;
+	char *buf, *line, *end;
+
+	ut_asserteq(-EINVAL, trace_sample_start(0));
+	ut_assertok(trace_sample_start(1000));
+	start = get_timer(0);
+	while (get_timer(start) < 200)
+		sample_busy(100000);
+	trace_sample_stop();
+
+	len = trace_sample_folded(NULL, 0);
+	ut_assert(len > 0);
+	buf = malloc(len + 1);
+	ut_assertnonnull(buf);
+	ut_asserteq(len, trace_sample_folded(buf, len + 1));
+
+	/* Look for samples in sample_busy(), which is the last on each line */
+	func = (ulong)sample_busy - gd->reloc_off;
+	found = 0;
+	callers = 0;
+	for (line = buf; *line; line = end + 1) {
+		end = strchr(line, '\n');
+		ut_assertnonnull(end);
+		*end = '\0';
+		pc = hextoul(strrchr(line, ';') ? strrchr(line, ';') + 1 : line,
+			     NULL);
+		if (pc >= func && pc < func + 0x100) {
+			found += dectoul(strchr(line, ' ') + 1, NULL);
+			if (strchr(line, ';'))
+				callers++;
+		}
+	}
+	ut_assert(found > 0);
+	if (CONFIG_TRACE_SAMPLE_DEPTH)
+		ut_assert(callers > 0);
+	free(buf);
+
+	/* Check the header and trailer of the pprof profile */
+	len = trace_sample_pprof(NULL, 0);
+	buf = malloc(len);
+	ut_assertnonnull(buf);
+	ut_asserteq(len, trace_sample_pprof(buf, len));
+	hdr = (ulong *)buf;
+	ut_asserteq(0, hdr[0]);
+	ut_asserteq(3, hdr[1]);
+	ut_asserteq(1000, hdr[3]);
+	maplen = sizeof(ulong) * 4 + 1 + strlen(MAP_SUFFIX);
+	ut_asserteq_mem(MAP_SUFFIX, buf + len - strlen(MAP_SUFFIX),
+			strlen(MAP_SUFFIX));
+	hdr = (ulong *)(buf + len - maplen) - 3;
+	ut_asserteq(0, hdr[0]);
+	ut_asserteq(1, hdr[1]);
+	ut_asserteq(0, hdr[2]);
+	free(buf);
+
+	return 0;
+}
+LIB_TEST(lib_test_trace_sample, 0);
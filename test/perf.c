@@ -0,0 +1,536 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Throughput benchmarks for code on the boot path
+ *
+ * Each test runs its operation repeatedly for at least PERF_MIN_US and
+ * prints one line per result, of the form:
+ *
+ *	perf: <name> <value> <unit>
+ *
+ * test/py/tests/test_ut_perf.py collects these and compares them against a
+ * baseline. Tests which need input data (compressed images, a block device or
+ * a file) take it from environment variables and are skipped if these are not
+ * set:
+ *
+ *	perf_<alg>_addr, perf_<alg>_size, perf_<alg>_len - compressed data for
+ *		<alg> = gzip, lz4, lzma or zstd, and its uncompressed length
+ *	perf_if, perf_dev - block device and partition, e.g. "host" and "0"
+ *	perf_file - file to read from that partition
+ */
+
+#include <abuf.h>
+#include <blk.h>
+#include <command.h>
+#include <env.h>
+#include <fs.h>
+#include <gzip.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <part.h>
+#include <time.h>
+#include <u-boot/crc.h>
+#include <u-boot/lz4.h>
+#include <u-boot/sha256.h>
+#include <u-boot/sha512.h>
+#include <asm/global_data.h>
+#include <linux/libfdt.h>
+#include <linux/math64.h>
+#include <linux/sizes.h>
+#include <linux/zstd.h>
+#include <lzma/LzmaTypes.h>
+#include <lzma/LzmaTools.h>
+#include <test/perf.h>
+#include <test/suites.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Run each benchmark for at least this long, so timer resolution is no issue */
+#define PERF_MIN_US		200000
+
+/* Size of the buffers used by the memory and hashing benchmarks */
+#define PERF_BUF_SIZE		SZ_1M
+
+/* Largest amount of a block device to read in one go */
+#define PERF_BLK_MAX		SZ_4M
+
+/* Number of blocks read one at a time by the block cache benchmark */
+#define PERF_BLK_SMALL		64
+
+/**
+ * struct perf_ctx - what a benchmark operates on
+ *
+ * @src: Input data
+ * @dst: Output buffer
+ * @size: Size of @src
+ * @len: Size of @dst
+ * @desc: Block device, for block and filesystem benchmarks
+ * @start: First block to read from @desc
+ * @count: Number of blocks to read, or items to process
+ * @name: Name of a file or environment variable
+ */
+struct perf_ctx {
+	void *src;
+	void *dst;
+	ulong size;
+	ulong len;
+	struct blk_desc *desc;
+	lbaint_t start;
+	lbaint_t count;
+	const char *name;
+};
+
+typedef int (*perf_func)(struct perf_ctx *ctx);
+
+static void perf_report(const char *name, u64 amount, ulong us,
+			const char *unit)
+{
+	/* Amount per microsecond is millions per second; keep one decimal */
+	u64 rate = div_u64(amount * 10, us);
+
+	printf("perf: %s %llu.%llu %s\n", name, rate / 10, rate % 10, unit);
+}
+
+/**
+ * perf_run() - run an operation repeatedly and report its throughput
+ *
+ * @uts: Test state
+ * @name: Name of the result
+ * @func: Operation to run, which must return 0 on success
+ * @ctx: Context for @func
+ * @amount: Bytes (or items, for @unit != "MB/s") handled by each call
+ * @unit: Unit to report in: "MB/s" or a count of millions of items per second
+ * Return: 0 if OK, -ve if @func failed
+ */
+static int perf_run(struct unit_test_state *uts, const char *name,
+		    perf_func func, struct perf_ctx *ctx, ulong amount,
+		    const char *unit)
+{
+	ulong start, us;
+	u64 total = 0;
+
+	start = timer_get_us();
+	do {
+		ut_assertok(func(ctx));
+		total += amount;
+		us = timer_get_us() - start;
+	} while (us < PERF_MIN_US);
+	perf_report(name, total, us, unit);
+
+	return 0;
+}
+
+static int perf_alloc(struct unit_test_state *uts, struct perf_ctx *ctx,
+		      ulong size, ulong len)
+{
+	ulong i;
+
+	memset(ctx, '\0', sizeof(*ctx));
+	ctx->size = size;
+	ctx->len = len;
+	if (size) {
+		ctx->src = malloc(size);
+		ut_assertnonnull(ctx->src);
+	}
+	if (len) {
+		ctx->dst = malloc(len);
+		ut_assertnonnull(ctx->dst);
+	}
+
+	/* Something other than zeroes, so no hash or copy takes a shortcut */
+	for (i = 0; i < size / sizeof(u32); i++)
+		((u32 *)ctx->src)[i] = i * 0x9e3779b1;
+
+	return 0;
+}
+
+static void perf_free(struct perf_ctx *ctx)
+{
+	free(ctx->src);
+	free(ctx->dst);
+}
+
+static int perf_memcpy(struct perf_ctx *ctx)
+{
+	memcpy(ctx->dst, ctx->src, ctx->size);
+
+	return 0;
+}
+
+static int perf_test_memcpy(struct unit_test_state *uts)
+{
+	struct perf_ctx ctx;
+
+	ut_assertok(perf_alloc(uts, &ctx, PERF_BUF_SIZE, PERF_BUF_SIZE));
+	ut_assertok(perf_run(uts, "memcpy", perf_memcpy, &ctx, ctx.size,
+			     "MB/s"));
+	perf_free(&ctx);
+
+	return 0;
+}
+PERF_TEST(perf_test_memcpy, 0);
+
+static int perf_memset(struct perf_ctx *ctx)
+{
+	memset(ctx->dst, 0xa5, ctx->len);
+
+	return 0;
+}
+
+static int perf_test_memset(struct unit_test_state *uts)
+{
+	struct perf_ctx ctx;
+
+	ut_assertok(perf_alloc(uts, &ctx, 0, PERF_BUF_SIZE));
+	ut_assertok(perf_run(uts, "memset", perf_memset, &ctx, ctx.len,
+			     "MB/s"));
+	perf_free(&ctx);
+
+	return 0;
+}
+PERF_TEST(perf_test_memset, 0);
+
+static int perf_crc32(struct perf_ctx *ctx)
+{
+	crc32(0, ctx->src, ctx->size);
+
+	return 0;
+}
+
+static int perf_test_crc32(struct unit_test_state *uts)
+{
+	struct perf_ctx ctx;
+
+	if (!IS_ENABLED(CONFIG_CRC32))
+		return -EAGAIN;
+	ut_assertok(perf_alloc(uts, &ctx, PERF_BUF_SIZE, 0));
+	ut_assertok(perf_run(uts, "crc32", perf_crc32, &ctx, ctx.size,
+			     "MB/s"));
+	perf_free(&ctx);
+
+	return 0;
+}
+PERF_TEST(perf_test_crc32, 0);
+
+static int perf_sha256(struct perf_ctx *ctx)
+{
+	u8 digest[SHA256_SUM_LEN];
+
+	sha256_csum_wd(ctx->src, ctx->size, digest, CHUNKSZ_SHA256);
+
+	return 0;
+}
+
+static int perf_test_sha256(struct unit_test_state *uts)
+{
+	struct perf_ctx ctx;
+
+	if (!IS_ENABLED(CONFIG_SHA256))
+		return -EAGAIN;
+	ut_assertok(perf_alloc(uts, &ctx, PERF_BUF_SIZE, 0));
+	ut_assertok(perf_run(uts, "sha256", perf_sha256, &ctx, ctx.size,
+			     "MB/s"));
+	perf_free(&ctx);
+
+	return 0;
+}
+PERF_TEST(perf_test_sha256, 0);
+
+static int perf_sha512(struct perf_ctx *ctx)
+{
+	u8 digest[SHA512_SUM_LEN];
+
+	sha512_csum_wd(ctx->src, ctx->size, digest, CHUNKSZ_SHA512);
+
+	return 0;
+}
+
+static int perf_test_sha512(struct unit_test_state *uts)
+{
+	struct perf_ctx ctx;
+
+	if (!IS_ENABLED(CONFIG_SHA512))
+		return -EAGAIN;
+	ut_assertok(perf_alloc(uts, &ctx, PERF_BUF_SIZE, 0));
+	ut_assertok(perf_run(uts, "sha512", perf_sha512, &ctx, ctx.size,
+			     "MB/s"));
+	perf_free(&ctx);
+
+	return 0;
+}
+PERF_TEST(perf_test_sha512, 0);
+
+/**
+ * perf_get_input() - find compressed input given in the environment
+ *
+ * @uts: Test state
+ * @alg: Name of the algorithm, used in the variable names
+ * @ctx: Returns the input in @src and @size, with a buffer of the
+ *	uncompressed size in @dst and @len
+ * Return: 0 if OK, -EAGAIN if no input is provided
+ */
+static int perf_get_input(struct unit_test_state *uts, const char *alg,
+			  struct perf_ctx *ctx)
+{
+	char var[32];
+	ulong addr;
+
+	memset(ctx, '\0', sizeof(*ctx));
+	snprintf(var, sizeof(var), "perf_%s_addr", alg);
+	addr = env_get_hex(var, 0);
+	snprintf(var, sizeof(var), "perf_%s_size", alg);
+	ctx->size = env_get_hex(var, 0);
+	snprintf(var, sizeof(var), "perf_%s_len", alg);
+	ctx->len = env_get_hex(var, 0);
+	if (!addr || !ctx->size || !ctx->len)
+		return -EAGAIN;
+
+	ctx->dst = malloc(ctx->len);
+	ut_assertnonnull(ctx->dst);
+	ctx->src = map_sysmem(addr, ctx->size);
+
+	return 0;
+}
+
+static void perf_put_input(struct perf_ctx *ctx)
+{
+	unmap_sysmem(ctx->src);
+	free(ctx->dst);
+}
+
+static int perf_decomp(struct unit_test_state *uts, const char *alg,
+		       perf_func func)
+{
+	struct perf_ctx ctx;
+	int ret;
+
+	ret = perf_get_input(uts, alg, &ctx);
+	if (ret)
+		return ret;
+	ut_assertok(perf_run(uts, alg, func, &ctx, ctx.len, "MB/s"));
+	perf_put_input(&ctx);
+
+	return 0;
+}
+
+static int perf_gunzip(struct perf_ctx *ctx)
+{
+	unsigned long len = ctx->size;
+
+	return gunzip(ctx->dst, ctx->len, ctx->src, &len);
+}
+
+static int perf_test_gunzip(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_GZIP))
+		return -EAGAIN;
+
+	return perf_decomp(uts, "gzip", perf_gunzip);
+}
+PERF_TEST(perf_test_gunzip, 0);
+
+static int perf_lz4(struct perf_ctx *ctx)
+{
+	size_t len = ctx->len;
+
+	return ulz4fn(ctx->src, ctx->size, ctx->dst, &len);
+}
+
+static int perf_test_lz4(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_LZ4))
+		return -EAGAIN;
+
+	return perf_decomp(uts, "lz4", perf_lz4);
+}
+PERF_TEST(perf_test_lz4, 0);
+
+static int perf_lzma(struct perf_ctx *ctx)
+{
+	SizeT len = ctx->len;
+
+	return lzmaBuffToBuffDecompress(ctx->dst, &len, ctx->src, ctx->size);
+}
+
+static int perf_test_lzma(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_LZMA))
+		return -EAGAIN;
+
+	return perf_decomp(uts, "lzma", perf_lzma);
+}
+PERF_TEST(perf_test_lzma, 0);
+
+static int perf_zstd(struct perf_ctx *ctx)
+{
+	struct abuf in, out;
+	int ret;
+
+	abuf_init_set(&in, ctx->src, ctx->size);
+	abuf_init_set(&out, ctx->dst, ctx->len);
+	ret = zstd_decompress(&in, &out);
+
+	return ret < 0 ? ret : 0;
+}
+
+static int perf_test_zstd(struct unit_test_state *uts)
+{
+	if (!IS_ENABLED(CONFIG_ZSTD))
+		return -EAGAIN;
+
+	return perf_decomp(uts, "zstd", perf_zstd);
+}
+PERF_TEST(perf_test_zstd, 0);
+
+static int perf_fdt_walk(struct perf_ctx *ctx)
+{
+	int node, depth = 0;
+
+	for (node = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(ctx->src, node, &depth))
+		fdt_getprop(ctx->src, node, "compatible", NULL);
+
+	return 0;
+}
+
+/* Visit every node in the control devicetree, looking up a property in each */
+static int perf_test_fdt_walk(struct unit_test_state *uts)
+{
+	struct perf_ctx ctx;
+	int node, depth = 0;
+
+	memset(&ctx, '\0', sizeof(ctx));
+	ctx.src = (void *)gd->fdt_blob;
+	ut_assertnonnull(ctx.src);
+	for (node = 0; node >= 0 && depth >= 0;
+	     node = fdt_next_node(ctx.src, node, &depth))
+		ctx.count++;
+
+	return perf_run(uts, "fdt_walk", perf_fdt_walk, &ctx, ctx.count,
+			"Mnodes/s");
+}
+PERF_TEST(perf_test_fdt_walk, 0);
+
+static int perf_env_get(struct perf_ctx *ctx)
+{
+	return env_get(ctx->name) ? 0 : -ENOENT;
+}
+
+static int perf_test_env_get(struct unit_test_state *uts)
+{
+	struct perf_ctx ctx;
+
+	memset(&ctx, '\0', sizeof(ctx));
+	ctx.name = "perf_test_var";
+	ut_assertok(env_set(ctx.name, "1"));
+	ut_assertok(perf_run(uts, "env_get", perf_env_get, &ctx, 1,
+			     "Mops/s"));
+	env_set(ctx.name, NULL);
+
+	return 0;
+}
+PERF_TEST(perf_test_env_get, 0);
+
+static int perf_blk_read(struct perf_ctx *ctx)
+{
+	return blk_dread(ctx->desc, ctx->start, ctx->count, ctx->dst) ==
+		ctx->count ? 0 : -EIO;
+}
+
+/* Read single blocks over a small area, which the block cache should hold */
+static int perf_blk_read_small(struct perf_ctx *ctx)
+{
+	lbaint_t i;
+
+	for (i = 0; i < PERF_BLK_SMALL; i++) {
+		if (blk_dread(ctx->desc, ctx->start + i, 1, ctx->dst) != 1)
+			return -EIO;
+	}
+
+	return 0;
+}
+
+static int perf_test_blk_read(struct unit_test_state *uts)
+{
+	const char *ifname = env_get("perf_if");
+	const char *dev = env_get("perf_dev");
+	struct disk_partition info;
+	struct perf_ctx ctx;
+	ulong blksz;
+
+	if (!ifname || !dev)
+		return -EAGAIN;
+
+	memset(&ctx, '\0', sizeof(ctx));
+	ut_assert(blk_get_device_part_str(ifname, dev, &ctx.desc, &info,
+					  1) >= 0);
+	blksz = ctx.desc->blksz;
+	ctx.start = info.start;
+	ctx.count = min_t(lbaint_t, info.size, PERF_BLK_MAX / blksz);
+	ut_assert(ctx.count >= PERF_BLK_SMALL);
+	ctx.len = ctx.count * blksz;
+	ctx.dst = malloc(ctx.len);
+	ut_assertnonnull(ctx.dst);
+
+	ut_assertok(perf_run(uts, "blk_read", perf_blk_read, &ctx, ctx.len,
+			     "MB/s"));
+	ut_assertok(perf_run(uts, "blk_read_small", perf_blk_read_small, &ctx,
+			     PERF_BLK_SMALL * blksz, "MB/s"));
+	free(ctx.dst);
+
+	return 0;
+}
+PERF_TEST(perf_test_blk_read, 0);
+
+static int perf_fs_read(struct perf_ctx *ctx)
+{
+	const char *ifname = env_get("perf_if");
+	const char *dev = env_get("perf_dev");
+	loff_t actread;
+	int ret;
+
+	/* The filesystem is closed after each operation */
+	ret = fs_set_blk_dev(ifname, dev, FS_TYPE_ANY);
+	if (ret)
+		return ret;
+	ret = fs_read(ctx->name, map_to_sysmem(ctx->dst), 0, ctx->len,
+		      &actread);
+	if (ret)
+		return ret;
+
+	return actread == ctx->len ? 0 : -EIO;
+}
+
+static int perf_test_fs_read(struct unit_test_state *uts)
+{
+	const char *ifname = env_get("perf_if");
+	const char *dev = env_get("perf_dev");
+	struct perf_ctx ctx;
+	loff_t size;
+
+	memset(&ctx, '\0', sizeof(ctx));
+	ctx.name = env_get("perf_file");
+	if (!ifname || !dev || !ctx.name)
+		return -EAGAIN;
+
+	ut_assertok(fs_set_blk_dev(ifname, dev, FS_TYPE_ANY));
+	ut_assertok(fs_size(ctx.name, &size));
+	ctx.len = size;
+	ctx.dst = malloc(ctx.len);
+	ut_assertnonnull(ctx.dst);
+
+	ut_assertok(perf_run(uts, "fs_read", perf_fs_read, &ctx, ctx.len,
+			     "MB/s"));
+	free(ctx.dst);
+
+	return 0;
+}
+PERF_TEST(perf_test_fs_read, 0);
+
+int do_ut_perf(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
+{
+	struct unit_test *tests = UNIT_TEST_SUITE_START(perf_test);
+	const int n_ents = UNIT_TEST_SUITE_COUNT(perf_test);
+
+	return cmd_ut_category("perf", "perf_test_", tests, n_ents, argc, argv);
+}
@@ -83,9 +83,10 @@ class ReadonlyFitImage(object):
 def test_mkimage_hashes(u_boot_console):
     """ Test that hashes generated by mkimage are correct. """
 
-    def assemble_fit_image(dest_fit, its, destdir):
+    def assemble_fit_image(dest_fit, its, destdir, args=[]):
         dtc_args = f'-I dts -O dtb -i {destdir}'
-        util.run_and_log(cons, [mkimage, '-D', dtc_args, '-f', its, dest_fit])
+        util.run_and_log(cons, [mkimage, '-D', dtc_args, '-f', its] + args +
+                         [dest_fit])
 
     def dtc(dts):
         dtb = dts.replace('.dts', '.dtb')
@@ -112,3 +113,10 @@ def test_mkimage_hashes(u_boot_console):
         raise ValueError('FIT image has no "/image" nodes with "hash-..."')
 
     fit.verify_hashes()
+
+    # Calculating the hashes in several threads must give the same values
+    assemble_fit_image(fit_file, f'{datadir}/hash-images.its', tempdir,
+                       ['-j', '4'])
+    fit = ReadonlyFitImage(cons, fit_file)
+    fit.find_hashable_image_nodes()
+    fit.verify_hashes()
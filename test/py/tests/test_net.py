@@ -9,6 +9,7 @@ import u_boot_utils
 import uuid
 import datetime
 import re
+import time
 
 """
 Note: This test relies on boardenv_* containing configuration values to define
@@ -61,6 +62,8 @@ env__net_tftp_readable_file = {
     'crc32': 'c2244b26',
     'timeout': 50000,
     'fnu': 'ubtest-upload.bin',
+    # Optional: slowest acceptable transfer rate for the file, in KiB/s
+    'min_rate': 10000,
 }
 
 # Details regarding a file that may be read from a NFS server. This variable
@@ -295,6 +298,53 @@ def test_net_tftpboot(u_boot_console):
     output = u_boot_console.run_command('crc32 $fileaddr $filesize')
     assert expected_crc in output
 
+@pytest.mark.buildconfigspec('cmd_tftpboot')
+def test_net_tftpboot_rate(u_boot_console):
+    """Measure how fast the tftpboot command downloads a file.
+
+    The rate is logged along with the network stack in use, so that runs of
+    the same board built with the legacy stack and with lwIP can be compared.
+    If the boardenv_* file gives a 'min_rate' for the file, the download
+    must be at least that fast.
+    """
+
+    if not net_set_up:
+        pytest.skip('Network not initialized')
+
+    f = u_boot_console.config.env.get('env__net_tftp_readable_file', None)
+    if not f:
+        pytest.skip('No TFTP readable file to read')
+
+    sz = f.get('size', None)
+    if not sz:
+        pytest.skip('No size given for the TFTP readable file')
+
+    addr = f.get('addr', None)
+    fn = f['fn']
+    timeout = f.get('timeout', u_boot_console.p.timeout)
+    if not addr:
+        cmd = 'tftpboot %s' % (fn)
+    else:
+        cmd = 'tftpboot %x %s' % (addr, fn)
+
+    with u_boot_console.temporary_timeout(timeout):
+        tstart = time.time()
+        output = u_boot_console.run_command(cmd)
+        tend = time.time()
+    assert 'Bytes transferred = %d' % sz in output
+
+    if u_boot_console.config.buildconfig.get('config_net_lwip', 'n') == 'y':
+        stack = 'lwIP'
+    else:
+        stack = 'legacy'
+    rate = sz / 1024 / (tend - tstart)
+    u_boot_console.log.info('%s stack: %d bytes in %f seconds, %d KiB/s' %
+                            (stack, sz, tend - tstart, rate))
+
+    min_rate = f.get('min_rate', None)
+    if min_rate:
+        assert rate >= min_rate
+
 @pytest.mark.buildconfigspec('cmd_nfs')
 def test_net_nfs(u_boot_console):
     """Test the nfs command.
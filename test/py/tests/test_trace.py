@@ -273,6 +273,45 @@ def check_flamegraph(cons, fname, proftool, map_fname, trace_fg):
                 total += count
     return total
 
+
+def check_profile(cons, fname, proftool, map_fname, trace_prof):
+    """Check that the 'profile' output works
+
+    This checks that initcalls are found and that a profile shows no
+    differences when compared with itself
+
+    Args:
+        cons (ConsoleBase): U-Boot console
+        fname (str): Filename of trace file
+        proftool (str): Filename of proftool
+        map_fname (str): Filename of System.map
+        trace_prof (str): Filename of output file
+
+    Returns:
+        int: Number of microseconds used by the initf_dm() function, including
+            the functions it calls
+    """
+    util.run_and_log(
+        cons, [proftool, '-t', fname, '-o', trace_prof, '-m', map_fname,
+               'dump-profile'])
+
+    # Each line is: kind calls us total_us name
+    items = {}
+    with open(trace_prof, 'r') as fd:
+        for line in fd:
+            if line.startswith('#'):
+                continue
+            kind, calls, _, total_us, name = line.split(maxsplit=4)
+            items[kind, name.strip()] = int(calls), int(total_us)
+    assert ('initcall', 'initr_dm_devices') in items
+    assert items['func', 'dm_timer_init'][0] >= 2
+
+    out = util.run_and_log(
+        cons, [proftool, 'diff-profile', trace_prof, trace_prof])
+    assert not out.strip()
+
+    return items['func', 'initf_dm'][1]
+
 check_flamegraph
 @pytest.mark.slow
 @pytest.mark.boardspec('sandbox')
@@ -287,6 +326,7 @@ def test_trace(u_boot_console):
     map_fname = os.path.join(cons.config.build_dir, 'System.map')
     trace_dat = os.path.join(TMPDIR, 'trace.dat')
     trace_fg = os.path.join(TMPDIR, 'trace.fg')
+    trace_prof = os.path.join(TMPDIR, 'trace.prof')
 
     fname, dm_f_time = collect_trace(cons)
 
@@ -304,3 +344,9 @@ def test_trace(u_boot_console):
     # This allows for CI being slow to run
     diff = abs(fg_time - dm_f_time)
     assert diff / dm_f_time < 0.3
+
+    prof_time = check_profile(cons, fname, proftool, map_fname, trace_prof)
+
+    # Check that bootstage and the profile agree, as with funcgraph
+    diff = abs(prof_time - dm_f_time)
+    assert diff / dm_f_time < 0.01
@@ -0,0 +1,187 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""Run the 'ut perf' benchmarks and check them for regressions
+
+Each benchmark prints lines of the form 'perf: <name> <value> <unit>'. The
+results are written to perf.json in the result directory, in a form which
+can be used as the baseline for a later run.
+
+On sandbox, the inputs for the decompression, block-device and filesystem
+benchmarks are created here. On other boards, boardenv can supply them as
+U-Boot environment variables, set before the run (see test/perf.c for the
+names). The data must already be in memory or on the device:
+
+env__perf_env = {
+    'perf_gzip_addr': '0x10000000',
+    'perf_gzip_size': '0x123456',
+    'perf_gzip_len': '0x400000',
+    'perf_if': 'mmc',
+    'perf_dev': '0:1',
+    'perf_file': '/perf.bin',
+}
+
+To catch regressions, give the expected results, either as a dict or as the
+path to a perf.json from an earlier run, along with the drop allowed in
+percent (default 10):
+
+env__perf_baseline = {
+    'memcpy': 2500.0,
+    'sha256': 150.0,
+}
+env__perf_threshold = 10
+"""
+
+import gzip
+import json
+import lzma
+import os
+import random
+import re
+import shutil
+import subprocess
+
+import pytest
+import fs_helper
+
+# Size of the uncompressed data used on sandbox
+DATA_SIZE = 4 << 20
+
+# Where the compressed inputs are loaded on sandbox
+LOAD_ADDR = 0x1000000
+LOAD_STEP = 0x1000000
+
+RE_RESULT = re.compile(r'^perf: (\S+) ([0-9.]+) (\S+)\s*$', re.M)
+
+def make_data(path):
+    """Write some data which compresses reasonably well
+
+    Args:
+        path (str): File to write
+    """
+    rnd = random.Random(0)
+    words = [b'boot', b'dram', b'load', b'fit', b'image', b'kernel', b'fdt',
+             b'block', b'cache', b'read', b'spl', b'tpl', b'dev', b'node']
+    out = bytearray()
+    while len(out) < DATA_SIZE:
+        out += b' '.join(rnd.choice(words) for _ in range(12))
+        out += b' %08x\n' % rnd.getrandbits(32)
+    with open(path, 'wb') as outf:
+        outf.write(out[:DATA_SIZE])
+
+def compress(alg, src, dst):
+    """Compress a file with the given algorithm
+
+    Args:
+        alg (str): 'gzip', 'lz4', 'lzma' or 'zstd'
+        src (str): Input file
+        dst (str): Output file
+
+    Returns:
+        bool: True if done, False if no tool is available for @alg
+    """
+    with open(src, 'rb') as inf:
+        data = inf.read()
+    if alg == 'gzip':
+        out = gzip.compress(data)
+    elif alg == 'lzma':
+        out = lzma.compress(data, format=lzma.FORMAT_ALONE)
+    else:
+        if not shutil.which(alg):
+            return False
+        out = subprocess.check_output([alg, '-c', src])
+    with open(dst, 'wb') as outf:
+        outf.write(out)
+    return True
+
+def setup_sandbox(u_boot_console):
+    """Create the inputs for the benchmarks which need them
+
+    Args:
+        u_boot_console (ConsoleBase): U-Boot console
+
+    Returns:
+        dict: Environment variables to set
+    """
+    pdir = u_boot_console.config.persistent_data_dir
+    data = os.path.join(pdir, 'perf.bin')
+    make_data(data)
+
+    env = {}
+    addr = LOAD_ADDR
+    for alg in ['gzip', 'lz4', 'lzma', 'zstd']:
+        fname = os.path.join(pdir, f'perf.{alg}')
+        if not compress(alg, data, fname):
+            continue
+        u_boot_console.run_command(f'host load hostfs - {addr:x} {fname}')
+        env[f'perf_{alg}_addr'] = f'{addr:x}'
+        env[f'perf_{alg}_size'] = f'{os.path.getsize(fname):x}'
+        env[f'perf_{alg}_len'] = f'{DATA_SIZE:x}'
+        addr += LOAD_STEP
+
+    # Put the data on an ext4 filesystem on a host device
+    fs_img = fs_helper.mk_fs(u_boot_console.config, 'ext4', DATA_SIZE * 2,
+                             'perf')
+    u_boot_console.run_command(f'host bind perf {fs_img}')
+    output = u_boot_console.run_command('host info perf')
+    devnum = re.search(r'^\s*(\d+)\s.*\sperf\s', output, re.M).group(1)
+    u_boot_console.run_command(f'host load hostfs - {addr:x} {data}')
+    output = u_boot_console.run_command(
+        f'ext4write host {devnum} {addr:x} /perf.bin {DATA_SIZE:x}')
+    assert 'bytes written' in output
+    env['perf_if'] = 'host'
+    env['perf_dev'] = devnum
+    env['perf_file'] = '/perf.bin'
+
+    return env
+
+def get_baseline(u_boot_console):
+    """Get the expected results, if any
+
+    Args:
+        u_boot_console (ConsoleBase): U-Boot console
+
+    Returns:
+        dict: Result name -> expected value
+    """
+    baseline = u_boot_console.config.env.get('env__perf_baseline', {})
+    if isinstance(baseline, str):
+        with open(baseline, encoding='utf-8') as inf:
+            baseline = {name: val['value']
+                        for name, val in json.load(inf).items()}
+    return baseline
+
+@pytest.mark.buildconfigspec('ut_perf')
+def test_ut_perf(u_boot_console):
+    """Run the benchmarks and compare the results with the baseline"""
+    if u_boot_console.config.buildconfig.get('config_sandbox') == 'y':
+        env = setup_sandbox(u_boot_console)
+    else:
+        env = u_boot_console.config.env.get('env__perf_env', {})
+    for var, val in env.items():
+        u_boot_console.run_command(f'setenv {var} {val}')
+
+    with u_boot_console.temporary_timeout(120000):
+        output = u_boot_console.run_command('ut perf')
+    for var in env:
+        u_boot_console.run_command(f'setenv {var}')
+    if env.get('perf_if') == 'host':
+        u_boot_console.run_command('host unbind perf')
+    assert 'Failures: 0' in output
+
+    results = {name: {'value': float(val), 'unit': unit}
+               for name, val, unit in RE_RESULT.findall(output)}
+    assert results
+    with open(os.path.join(u_boot_console.config.result_dir, 'perf.json'), 'w',
+              encoding='utf-8') as outf:
+        json.dump(results, outf, indent=4, sort_keys=True)
+
+    threshold = u_boot_console.config.env.get('env__perf_threshold', 10)
+    slow = []
+    for name, expect in get_baseline(u_boot_console).items():
+        if name not in results:
+            continue
+        val = results[name]['value']
+        if val < expect * (100 - threshold) / 100:
+            unit = results[name]['unit']
+            slow.append(f'{name}: {val} {unit}, expected {expect}')
+    assert not slow, 'Slower than baseline: ' + ', '.join(slow)
@@ -11,6 +11,7 @@ the tool, checking its version and fetching it if needed.
 
 import collections
 import glob
+import hashlib
 import importlib
 import multiprocessing
 import os
@@ -51,6 +52,10 @@ class Bintool:
     # List of bintools to regard as missing
     missing_list = []
 
+    # Directory holding the output of earlier runs, or None to disable this.
+    # See run_cmd_cached()
+    cache_dir = None
+
     # Directory to store tools. Note that this set up by set_tool_dir() which
     # must be called before this class is used.
     tooldir = ''
@@ -132,6 +137,15 @@ class Bintool:
     def set_missing_list(cls, missing_list):
         cls.missing_list = missing_list or []
 
+    @classmethod
+    def set_cache_dir(cls, cache_dir):
+        """Set the directory used to cache bintool output
+
+        Args:
+            cache_dir (str): Directory to use, or None to disable caching
+        """
+        cls.cache_dir = cache_dir
+
     @staticmethod
     def get_tool_list(include_testing=False):
         """Get a list of the known tools
@@ -327,6 +341,89 @@ class Bintool:
         if result:
             return result.stdout
 
+    def _cache_key(self, args):
+        """Work out the key to use for caching the output of a command
+
+        The key covers the tool itself, the arguments and the contents of any
+        files named in the arguments. Paths in the output directory are
+        replaced with a placeholder, since that directory changes from one
+        run to the next.
+
+        Args:
+            args (list of str): Arguments to provide to the bintool
+
+        Returns:
+            str: Key to use, or None if the output cannot be cached, e.g.
+                because a directory is passed to the tool
+        """
+        path = self.get_path()
+        if not path:
+            return None
+        stat = os.stat(path)
+        hsh = hashlib.sha256()
+        hsh.update(f'{path}:{stat.st_size}:{stat.st_mtime_ns}\0'.encode())
+        outdir = tools.get_output_dir()
+        for arg in args:
+            arg = str(arg)
+            for part in arg.split(':'):
+                if os.path.isdir(part):
+                    return None
+                if os.path.isfile(part):
+                    hsh.update(hashlib.sha256(tools.read_file(part)).digest())
+            if outdir:
+                arg = arg.replace(outdir, '<outdir>')
+            hsh.update(arg.encode() + b'\0')
+        return hsh.hexdigest()
+
+    def run_cmd_cached(self, out_fnames, *args):
+        """Run the bintool, reusing its output from an earlier run if possible
+
+        If a cache directory is set with set_cache_dir(), the output files and
+        stdout of the tool are stored there, keyed by the tool, its arguments
+        and the contents of its input files. A later run with the same key
+        copies the files from the cache instead of running the tool.
+
+        Args:
+            out_fnames (list of str): Files written by the tool
+            args (list of str): Arguments to provide, in addition to the
+                bintool name
+
+        Returns:
+            str: Resulting stdout from the bintool, or None if the tool is not
+                present
+        """
+        key = None
+        if self.cache_dir and self.name not in self.missing_list:
+            key = self._cache_key(args)
+        if not key:
+            return self.run_cmd(*args)
+
+        keydir = os.path.join(self.cache_dir, key[:2], key)
+        names = [os.path.basename(fname) for fname in out_fnames]
+        if all(os.path.exists(os.path.join(keydir, name)) for name in names):
+            tout.info(f"bintool '{self.name}': using cached output {key}")
+            for name, fname in zip(names, out_fnames):
+                shutil.copyfile(os.path.join(keydir, name), fname)
+            return tools.read_file(os.path.join(keydir, 'stdout'),
+                                   binary=False)
+
+        stdout = self.run_cmd(*args)
+        if stdout is not None:
+            # Fill a new directory and rename it, so a reader never sees a
+            # partial entry, even when other binman instances share the cache
+            os.makedirs(os.path.dirname(keydir), exist_ok=True)
+            tmpdir = tempfile.mkdtemp(dir=os.path.dirname(keydir))
+            for name, fname in zip(names, out_fnames):
+                shutil.copyfile(fname, os.path.join(tmpdir, name))
+            tools.write_file(os.path.join(tmpdir, 'stdout'), stdout,
+                             binary=False)
+            try:
+                os.rename(tmpdir, keydir)
+            except OSError:
+                # Someone else stored the same output first
+                shutil.rmtree(tmpdir)
+        return stdout
+
     @classmethod
     def build_from_git(cls, git_repo, make_targets, bintool_path, flags=None):
         """Build a bintool from a git repo
@@ -353,6 +353,34 @@ class TestBintool(unittest.TestCase):
             result = btool.run_cmd_result('fred')
         self.assertIsNone(result)
 
+    def test_cached_run(self):
+        """Check that the output of a bintool is reused from the cache"""
+        infile = os.path.join(self._indir, 'in')
+        outfile = os.path.join(self._indir, 'out')
+        tools.write_file(infile, b'abc')
+        btool = Bintool('cp', 'copy files')
+        Bintool.set_cache_dir(os.path.join(self._indir, 'cache'))
+        try:
+            btool.run_cmd_cached([outfile], infile, outfile)
+            self.assertEqual(b'abc', tools.read_file(outfile))
+
+            # The same input should not run the tool
+            os.remove(outfile)
+            with unittest.mock.patch.object(btool, 'run_cmd') as run:
+                btool.run_cmd_cached([outfile], infile, outfile)
+            run.assert_not_called()
+            self.assertEqual(b'abc', tools.read_file(outfile))
+
+            # Different input should
+            tools.write_file(infile, b'def')
+            btool.run_cmd_cached([outfile], infile, outfile)
+            self.assertEqual(b'def', tools.read_file(outfile))
+
+            # A directory cannot be hashed, so is never cached
+            self.assertIsNone(btool._cache_key([self._indir]))
+        finally:
+            Bintool.set_cache_dir(None)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -50,6 +50,7 @@ class Bintoolmkimage(bintool.Bintool):
             args += ['-k', f'{priv_keys_dir}']
         if output_fname:
             args += ['-F', output_fname]
+            return self.run_cmd_cached([output_fname], *args)
         return self.run_cmd(*args)
 
     def fetch(self, method):
@@ -114,6 +114,10 @@ controlled by a description in the board device tree.'''
     build_parser = subparsers.add_parser('build', help='Build firmware image')
     build_parser.add_argument('-a', '--entry-arg', type=str, action='append',
             help='Set argument value arg=value')
+    build_parser.add_argument('--cache-dir', type=str,
+            default=os.environ.get('BINMAN_CACHE_DIR'),
+            help='Directory to keep bintool output in, to reuse when the '
+                 'inputs are unchanged (default $BINMAN_CACHE_DIR)')
     build_parser.add_argument('-b', '--board', type=str,
             help='Board name to build')
     build_parser.add_argument('-d', '--dt', type=str,
@@ -128,6 +132,8 @@ controlled by a description in the board device tree.'''
             help='Image filename to build (if not specified, build all)')
     build_parser.add_argument('-I', '--indir', action='append',
             help='Add a path to the list of directories to use for input files')
+    build_parser.add_argument('-j', '--jobs', type=int, default=1,
+            help='Number of images to build at once (default 1, 0=one per CPU)')
     build_parser.add_argument('-m', '--map', action='store_true',
         default=False, help='Output a map file for each image')
     build_parser.add_argument('-M', '--allow-missing', action='store_true',
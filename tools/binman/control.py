@@ -6,6 +6,7 @@
 #
 
 from collections import OrderedDict
+import concurrent.futures
 import glob
 try:
     import importlib.resources
@@ -739,6 +740,84 @@ def ProcessImage(image, update_fdt, write_map, get_contents=True,
 
     return has_problems
 
+def GetImageDeps(images):
+    """Work out which images use the output of other images
+
+    An image depends on another if one of its entries (e.g. a blob) reads the
+    file which the other image writes.
+
+    Args:
+        images: OrderedDict of Image objects to check, keyed by name
+
+    Returns:
+        dict:
+            key: Image name
+            value: set of names of images which must be built first
+    """
+    producers = {}
+    for name, image in images.items():
+        producers[os.path.basename(image._filename)] = name
+    deps = {}
+    for name, image in images.items():
+        deps[name] = set()
+        todo = list(image.GetEntries().values())
+        while todo:
+            entry = todo.pop()
+            fname = getattr(entry, '_filename', None)
+            if isinstance(fname, str):
+                producer = producers.get(os.path.basename(fname))
+                if producer and producer != name:
+                    deps[name].add(producer)
+            todo += (entry.GetEntries() or {}).values()
+    return deps
+
+def ProcessImages(images, jobs, update_fdt, write_map, allow_missing,
+                  allow_fake_blobs):
+    """Process a set of images, building independent ones in parallel
+
+    Images are started in batches: each batch holds the images whose
+    dependencies (see GetImageDeps()) have all been built. Any exception is
+    raised for the first failing image in the batch, in image order, so that
+    the result does not depend on timing.
+
+    Args:
+        images: OrderedDict of Image objects to process, keyed by name
+        jobs: Maximum number of images to build at once (1 for sequential,
+            0 to pick a suitable number for the machine)
+        update_fdt: True to update the FDT wth entry offsets, etc.
+        write_map: True to write a map file
+        allow_missing: Allow blob_ext objects to be missing
+        allow_fake_blobs: Allow blob_ext objects to be faked with dummy files
+
+    Returns:
+        True if one or more external blobs are missing or faked in any image,
+        False if all are present
+    """
+    def _Process(name):
+        return ProcessImage(images[name], update_fdt, write_map,
+                            allow_missing=allow_missing,
+                            allow_fake_blobs=allow_fake_blobs)
+
+    # Updating the FDT changes device trees shared between all images
+    if jobs == 1 or update_fdt or len(images) < 2:
+        return any([_Process(name) for name in images])
+
+    deps = GetImageDeps(images)
+    invalid = False
+    done = set()
+    todo = list(images)
+    with concurrent.futures.ThreadPoolExecutor(max_workers=jobs or None) as executor:
+        while todo:
+            ready = [name for name in todo if deps[name] <= done]
+            if not ready:
+                # Images depend on each other; build the rest in order
+                ready = todo
+            for result in executor.map(_Process, ready):
+                invalid |= result
+            done.update(ready)
+            todo = [name for name in todo if name not in done]
+    return invalid
+
 def Binman(args):
     """The main control code for binman
 
@@ -851,10 +930,10 @@ def Binman(args):
             if args.test_section_timeout:
                 # Set the first image to timeout, used in testThreadTimeout()
                 images[list(images.keys())[0]].test_section_timeout = True
-            invalid = False
             bintool.Bintool.set_missing_list(
                 args.force_missing_bintools.split(',') if
                 args.force_missing_bintools else None)
+            bintool.Bintool.set_cache_dir(args.cache_dir)
 
             # Create the directory here instead of Entry.check_fake_fname()
             # since that is called from a threaded context so different threads
@@ -862,10 +941,9 @@ def Binman(args):
             if args.fake_ext_blobs:
                 entry.Entry.create_fake_dir()
 
-            for image in images.values():
-                invalid |= ProcessImage(image, args.update_fdt, args.map,
-                                       allow_missing=args.allow_missing,
-                                       allow_fake_blobs=args.fake_ext_blobs)
+            invalid = ProcessImages(images, args.jobs, args.update_fdt,
+                                    args.map, args.allow_missing,
+                                    args.fake_ext_blobs)
 
             # Write the updated FDTs to our output files
             for dtb_item in state.GetAllFdts():
@@ -876,6 +954,7 @@ def Binman(args):
                 elf.UpdateFile(*elf_params, data)
 
             bintool.Bintool.set_missing_list(None)
+            bintool.Bintool.set_cache_dir(None)
 
             # This can only be True if -M is provided, since otherwise binman
             # would have raised an error already
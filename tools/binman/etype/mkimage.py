@@ -198,7 +198,7 @@ class Entry_mkimage(Entry_section):
         elif self._imagename:
             args += ['-n', imagename_fname]
         args += self._args + [output_fname]
-        if self.mkimage.run_cmd(*args) is not None:
+        if self.mkimage.run_cmd_cached([output_fname], *args) is not None:
             return tools.read_file(output_fname)
         else:
             # Bintool is missing; just use the input data as the output
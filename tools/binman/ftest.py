@@ -374,7 +374,8 @@ class TestFunctional(unittest.TestCase):
                     use_expanded=False, verbosity=None, allow_missing=False,
                     allow_fake_blobs=False, extra_indirs=None, threads=None,
                     test_section_timeout=False, update_fdt_in_elf=None,
-                    force_missing_bintools='', ignore_missing=False, output_dir=None):
+                    force_missing_bintools='', ignore_missing=False, output_dir=None,
+                    jobs=None):
         """Run binman with a given test file
 
         Args:
@@ -408,6 +409,7 @@ class TestFunctional(unittest.TestCase):
             ignore_missing (bool): True to return success even if there are
                 missing blobs or bintools
             output_dir: Specific output directory to use for image using -O
+            jobs: Number of images to build at once (None for default)
 
         Returns:
             int return code, 0 on success
@@ -456,6 +458,8 @@ class TestFunctional(unittest.TestCase):
                 args += ['-I', indir]
         if output_dir:
             args += ['-O', output_dir]
+        if jobs is not None:
+            args.append('-j%d' % jobs)
         return self._DoBinman(*args)
 
     def _SetupDtb(self, fname, outfile='u-boot.dtb'):
@@ -7899,6 +7903,34 @@ fdt         fdtmap                Extract the devicetree blob from the fdtmap
             entry_args=entry_args,
             extra_indirs=[test_subdir])[0]
 
+    def testImageJobs(self):
+        """Test building images in parallel, respecting their dependencies"""
+        testdir = TestFunctional._MakeInputDir('imagejobs')
+        self._DoTestFile('343_image_deps.dts', output_dir=testdir,
+                         extra_indirs=[testdir], jobs=3)
+        deps = control.GetImageDeps(control.images)
+        self.assertEqual({'first'}, deps['second'])
+        self.assertEqual(set(), deps['first'])
+        self.assertEqual(set(), deps['other'])
+
+        data = tools.read_file(os.path.join(testdir, 'second.bin'))
+        self.assertEqual(U_BOOT_DATA + U_BOOT_DATA, data)
+        data = tools.read_file(os.path.join(testdir, 'other.bin'))
+        self.assertEqual(U_BOOT_DATA, data)
+
+    def testImageJobsCycle(self):
+        """Test building images in parallel which depend on each other"""
+        with test_util.capture_sys_output() as (stdout, stderr):
+            ret = self._DoTestFile('344_image_deps_cycle.dts',
+                                   allow_missing=True, jobs=2)
+        self.assertEqual(103, ret)
+        deps = control.GetImageDeps(control.images)
+        self.assertEqual({'second'}, deps['first'])
+        self.assertEqual({'first'}, deps['second'])
+        err = stderr.getvalue()
+        self.assertRegex(err, "Image 'first'.*missing.*: blob-ext")
+        self.assertRegex(err, "Image 'second'.*missing.*: blob-ext")
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -51,6 +51,7 @@ TYPE_NAMES = {
 
 STRUCT_PREFIX = 'dtd_'
 VAL_PREFIX = 'dtv_'
+HOT_PREFIX = 'DTD_HOT_'
 
 # Properties which are considered to be phandles
 #    key: property name
@@ -170,8 +171,12 @@ class DtbPlatdata():
             the selected devices (see _valid_node), in alphabetical order
         _instantiate: Instantiate devices so they don't need to be bound at
             run-time
+        _hot (list of str): Names of drivers to generate platform data for,
+            for use alongside the devicetree in U-Boot proper, or None to
+            generate data for all drivers as normal
     """
-    def __init__(self, scan, dtb_fname, include_disabled, instantiate=False):
+    def __init__(self, scan, dtb_fname, include_disabled, instantiate=False,
+                 hot=None):
         self._scan = scan
         self._fdt = None
         self._dtb_fname = dtb_fname
@@ -185,6 +190,7 @@ class DtbPlatdata():
         self._basedir = None
         self._valid_uclasses = None
         self._instantiate = instantiate
+        self._hot = hot
 
     def setup_output_dirs(self, output_dirs):
         """Set up the output directories
@@ -428,6 +434,20 @@ class DtbPlatdata():
             node.parent_seq = None
             node.parent_driver = None
 
+    def select_hot_nodes(self):
+        """Drop the nodes which do not use one of the hot drivers
+
+        This must be called after prepare_nodes(), since it uses the struct
+        name to find the driver. The remaining nodes are renumbered.
+        """
+        self._valid_nodes_unsorted = [node for node in
+                                      self._valid_nodes_unsorted
+                                      if node.struct_name in self._hot]
+        self._valid_nodes = [node for node in self._valid_nodes
+                             if node.struct_name in self._hot]
+        for idx, node in enumerate(self._valid_nodes):
+            node.idx = idx
+
     @staticmethod
     def get_num_cells(node):
         """Get the number of cells in addresses and sizes for this node
@@ -577,6 +597,8 @@ class DtbPlatdata():
 
         # Output the struct definition
         for name in sorted(structs):
+            if self._hot:
+                self.out('#define %s%s\n' % (HOT_PREFIX, name))
             self.out('struct %s%s {\n' % (STRUCT_PREFIX, name))
             for pname in sorted(structs[name]):
                 prop = structs[name][pname]
@@ -620,8 +642,9 @@ class DtbPlatdata():
                     arg_values.append(
                         str(fdt_util.fdt32_to_cpu(prop.value[pos + 1 + i])))
                 pos += 1 + args
-                vals.append('\t{%d, {%s}}' % (target_node.idx,
-                                              ', '.join(arg_values)))
+                # Hot nodes refer to the target by its devicetree offset
+                idx = target_node.Offset() if self._hot else target_node.idx
+                vals.append('\t{%d, {%s}}' % (idx, ', '.join(arg_values)))
             for val in vals:
                 self.buf('\n\t\t%s,' % val)
         else:
@@ -1113,6 +1136,38 @@ class DtbPlatdata():
 
         self.out(''.join(self.get_buf()))
 
+    def generate_hot(self):
+        """Generate platform data for the hot drivers
+
+        This writes out the struct values for each valid node, along with a
+        table of them sorted by devicetree offset, so that U-Boot proper can
+        find the data for a device without reading its properties.
+
+        See the documentation in doc/develop/driver-model/of-plat.rst for more
+        information.
+        """
+        self.out('#include <dm.h>\n')
+        self.out('#include <dt-structs.h>\n')
+        self.out('\n')
+
+        nodes = sorted(self._valid_nodes, key=lambda node: node.Offset())
+        for node in nodes:
+            self.buf('/* Node %s offset %d */\n' % (node.path, node.Offset()))
+            self._output_values(node)
+            self.buf('\n')
+        self.out(''.join(self.get_buf()))
+
+        self.out('const struct dm_hot_plat dm_hot_plat[] = {\n')
+        for node in nodes:
+            self.out('\t{ %d, "%s", &%s%s },\n' %
+                     (node.Offset(), node.struct_name, VAL_PREFIX,
+                      node.var_name))
+        self.out('};\n')
+        self.out('\n')
+        self.out('const int dm_hot_plat_count = ARRAY_SIZE(dm_hot_plat);\n')
+        self.out('const int dm_hot_plat_fdt_size = %d;\n' %
+                 self._fdt.GetFdtObj().totalsize())
+
 
 # Types of output file we understand
 # key: Command used to generate this file
@@ -1134,6 +1189,17 @@ OUTPUT_FILES_NOINST = {
                    'Declares the U_BOOT_DRIVER() records and platform data'),
     }
 
+# Files generated for hot drivers in U-Boot proper
+OUTPUT_FILES_HOT = {
+    'struct':
+        OutputFile(Ftype.HEADER, 'dt-structs-hot.h',
+                   DtbPlatdata.generate_structs,
+                   'Defines the structs used to hold devicetree data'),
+    'hot':
+        OutputFile(Ftype.SOURCE, 'dt-hot.c', DtbPlatdata.generate_hot,
+                   'Declares the platform data for hot drivers'),
+    }
+
 # File generated with instantiate
 OUTPUT_FILES_INST = {
     'device':
@@ -1147,7 +1213,7 @@ OUTPUT_FILES_INST = {
 
 def run_steps(args, dtb_file, include_disabled, output, output_dirs, phase,
               instantiate, warning_disabled=False, drivers_additional=None,
-              basedir=None, scan=None):
+              basedir=None, scan=None, hot=None):
     """Run all the steps of the dtoc tool
 
     Args:
@@ -1170,6 +1236,8 @@ def run_steps(args, dtb_file, include_disabled, output, output_dirs, phase,
             grandparent of this file's directory
         scan (src_src.Scanner): Scanner from a previous run. This can help speed
             up tests. Use None for normal operation
+        hot (list of str): Names of drivers to generate platform data for in
+            U-Boot proper, or None to generate data for all drivers, for SPL
 
     Returns:
         DtbPlatdata object
@@ -1188,10 +1256,12 @@ def run_steps(args, dtb_file, include_disabled, output, output_dirs, phase,
         do_process = True
     else:
         do_process = False
-    plat = DtbPlatdata(scan, dtb_file, include_disabled, instantiate)
+    plat = DtbPlatdata(scan, dtb_file, include_disabled, instantiate, hot)
     plat.scan_dtb()
     plat.scan_tree(add_root=instantiate)
     plat.prepare_nodes()
+    if hot:
+        plat.select_hot_nodes()
     plat.scan_reg_sizes()
     plat.setup_output_dirs(output_dirs)
     plat.scan_structs()
@@ -1201,10 +1271,13 @@ def run_steps(args, dtb_file, include_disabled, output, output_dirs, phase,
     plat.assign_seqs()
 
     # Figure out what output files we plan to generate
-    output_files = dict(OUTPUT_FILES_COMMON)
-    if instantiate:
+    if hot:
+        output_files = dict(OUTPUT_FILES_HOT)
+    elif instantiate:
+        output_files = dict(OUTPUT_FILES_COMMON)
         output_files.update(OUTPUT_FILES_INST)
     else:
+        output_files = dict(OUTPUT_FILES_COMMON)
         output_files.update(OUTPUT_FILES_NOINST)
 
     cmds = args[0].split(',')
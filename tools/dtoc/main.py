@@ -89,6 +89,10 @@ def run_dtoc():
     parser.add_argument(
         '-i', '--instantiate', action='store_true', default=False,
         help='Instantiate devices to avoid needing device_bind()')
+    parser.add_argument(
+        '-H', '--hot-drivers', type=str,
+        help='Generate platform data for U-Boot proper, just for these drivers '
+             '(comma- or space-separated)')
     parser.add_argument('--include-disabled', action='store_true',
                       help='Include disabled nodes')
     parser.add_argument('-o', '--output', action='store',
@@ -119,7 +123,9 @@ def run_dtoc():
         dtb_platdata.run_steps(args.files, args.dtb_file, args.include_disabled,
                                args.output,
                                [args.c_output_dir, args.h_output_dir],
-                               args.phase, instantiate=args.instantiate)
+                               args.phase, instantiate=args.instantiate,
+                               hot=(args.hot_drivers.replace(',', ' ').split()
+                                    if args.hot_drivers else None))
 
 
 if __name__ == '__main__':
@@ -150,13 +150,15 @@ class TestDtoc(unittest.TestCase):
         self.assertEqual(expected, actual)
 
     @staticmethod
-    def run_test(args, dtb_file, output, instantiate=False):
+    def run_test(args, dtb_file, output, instantiate=False, hot=None):
         """Run a test using dtoc
 
         Args:
             args (list of str): List of arguments for dtoc
             dtb_file (str): Filename of .dtb file
             output (str): Filename of output file
+            instantiate (bool): True to instantiate devices
+            hot (list of str): Hot drivers to generate data for, or None
 
         Returns:
             DtbPlatdata object
@@ -165,7 +167,7 @@ class TestDtoc(unittest.TestCase):
         # drivers, which get updated during execution.
         return dtb_platdata.run_steps(
             args, dtb_file, False, output, [], None, instantiate,
-            warning_disabled=True, scan=copy_scan())
+            warning_disabled=True, scan=copy_scan(), hot=hot)
 
     def test_name(self):
         """Test conversion of device tree names to C identifiers"""
@@ -1016,6 +1018,68 @@ U_BOOT_DRVINFO(phandle_target) = {
 
 ''', data)
 
+    def test_hot(self):
+        """Test output of platform data for hot drivers in U-Boot proper"""
+        dtb_file = get_dtb_file('dtoc_test_phandle.dts')
+        output = tools.get_output_filename('output')
+        self.run_test(['struct'], dtb_file, output, hot=['source'])
+        with open(output) as infile:
+            data = infile.read()
+        self._check_strings(HEADER + '''
+#define DTD_HOT_source
+struct dtd_source {
+\tstruct phandle_2_arg clocks[4];
+\tunsigned char\tphandle_name_offset[13];
+};
+''', data)
+
+        # Phandles and the table use devicetree offsets, not indexes
+        dtb = fdt.FdtScan(dtb_file)
+        target = dtb.GetNode('/phandle-target').Offset()
+        target2 = dtb.GetNode('/phandle2-target').Offset()
+        target3 = dtb.GetNode('/phandle3-target').Offset()
+        source = dtb.GetNode('/phandle-source').Offset()
+        source2 = dtb.GetNode('/phandle-source2').Offset()
+        self.run_test(['hot'], dtb_file, output, hot=['source'])
+        with open(output) as infile:
+            data = infile.read()
+        self._check_strings('''/*
+ * DO NOT MODIFY
+ *
+ * Declares the platform data for hot drivers.
+ * This was generated by dtoc from a .dtb (device tree binary) file.
+ */
+
+#include <dm.h>
+#include <dt-structs.h>
+
+/* Node /phandle-source offset %d */
+static struct dtd_source dtv_phandle_source = {
+\t.clocks\t\t\t= {
+\t\t\t{%d, {}},
+\t\t\t{%d, {11}},
+\t\t\t{%d, {12, 13}},
+\t\t\t{%d, {}},},
+\t.phandle_name_offset\t= {0x0, 0x0, 0x0, 0x3, 0x66, 0x72, 0x65, 0x64,
+\t\t0x0, 0x0, 0x0, 0x0, 0x7b},
+};
+
+/* Node /phandle-source2 offset %d */
+static struct dtd_source dtv_phandle_source2 = {
+\t.clocks\t\t\t= {
+\t\t\t{%d, {}},},
+};
+
+const struct dm_hot_plat dm_hot_plat[] = {
+\t{ %d, "source", &dtv_phandle_source },
+\t{ %d, "source", &dtv_phandle_source2 },
+};
+
+const int dm_hot_plat_count = ARRAY_SIZE(dm_hot_plat);
+const int dm_hot_plat_fdt_size = %d;
+''' % (source, target, target2, target3, target, source2, target, source,
+       source2, dtb.GetFdtObj().totalsize()), data)
+
     def test_phandle_single(self):
         """Test output from a node containing a phandle reference"""
         dtb_file = get_dtb_file('dtoc_test_phandle_single.dts')
@@ -22,6 +22,9 @@
 #include "fit_common.h"
 #include <image.h>
 #include <u-boot/crc.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #define COPYFILE_BUFSIZE (64 * 1024)
 
@@ -127,58 +130,127 @@ err:
 	return -1;
 }
 
+int mmap_new_file(const char *cmdname, const char *fname, size_t size,
+		  void **blobp)
+{
+	void *ptr;
+	int fd;
+
+	fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+	if (fd < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n",
+			cmdname, fname, strerror(errno));
+		return -1;
+	}
+
+	if (ftruncate(fd, size)) {
+		fprintf(stderr, "%s: Can't expand %s: %s\n",
+			cmdname, fname, strerror(errno));
+		goto err;
+	}
+
+	ptr = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (ptr == MAP_FAILED) {
+		fprintf(stderr, "%s: Can't map %s: %s\n",
+			cmdname, fname, strerror(errno));
+		goto err;
+	}
+	*blobp = ptr;
+
+	return fd;
+err:
+	close(fd);
+	unlink(fname);
+
+	return -1;
+}
+
+int copyfile_range(int fd_src, off_t src_off, int fd_dst, off_t dst_off,
+		   size_t len)
+{
+	void *buf;
+	ssize_t size;
+
+#if defined(__linux__) && defined(__NR_copy_file_range)
+	/*
+	 * Let the kernel do the copy, sharing the blocks if the filesystem
+	 * can. Older kernels and some filesystems refuse, so carry on below
+	 * with whatever is left.
+	 */
+	while (len) {
+		loff_t in = src_off, out = dst_off;
+
+		size = syscall(__NR_copy_file_range, fd_src, &in, fd_dst, &out,
+			       len, 0);
+		if (size <= 0)
+			break;
+		src_off += size;
+		dst_off += size;
+		len -= size;
+	}
+	if (!len)
+		return 0;
+#endif
+	buf = malloc(COPYFILE_BUFSIZE);
+	if (!buf) {
+		printf("Can't allocate buffer to copy file\n");
+		return -1;
+	}
+
+	while (len) {
+		size = pread(fd_src, buf,
+			     len < COPYFILE_BUFSIZE ? len : COPYFILE_BUFSIZE,
+			     src_off);
+		if (size <= 0) {
+			printf("Can't read file (%s)\n",
+			       size ? strerror(errno) : "unexpected end");
+			break;
+		}
+		if (pwrite(fd_dst, buf, size, dst_off) != size) {
+			printf("Can't write file (%s)\n", strerror(errno));
+			break;
+		}
+		src_off += size;
+		dst_off += size;
+		len -= size;
+	}
+	free(buf);
+
+	return len ? -1 : 0;
+}
+
 int copyfile(const char *src, const char *dst)
 {
 	int fd_src = -1, fd_dst = -1;
-	void *buf = NULL;
-	ssize_t size;
-	size_t count;
+	struct stat sbuf;
 	int ret = -1;
 
-	fd_src = open(src, O_RDONLY);
+	fd_src = open(src, O_RDONLY | O_BINARY);
 	if (fd_src < 0) {
 		printf("Can't open file %s (%s)\n", src, strerror(errno));
 		goto out;
 	}
 
-	fd_dst = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	fd_dst = open(dst, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
 	if (fd_dst < 0) {
 		printf("Can't open file %s (%s)\n", dst, strerror(errno));
 		goto out;
 	}
 
-	buf = calloc(1, COPYFILE_BUFSIZE);
-	if (!buf) {
-		printf("Can't allocate buffer to copy file\n");
+	if (fstat(fd_src, &sbuf) < 0) {
+		printf("Can't stat file %s (%s)\n", src, strerror(errno));
 		goto out;
 	}
 
-	while (1) {
-		size = read(fd_src, buf, COPYFILE_BUFSIZE);
-		if (size < 0) {
-			printf("Can't read file %s\n", src);
-			goto out;
-		}
-		if (!size)
-			break;
-
-		count = size;
-		size = write(fd_dst, buf, count);
-		if (size < 0) {
-			printf("Can't write file %s\n", dst);
-			goto out;
-		}
-	}
-
-	ret = 0;
+	ret = copyfile_range(fd_src, 0, fd_dst, 0, sbuf.st_size);
+	if (ret)
+		printf("Can't copy file %s to %s\n", src, dst);
 
  out:
 	if (fd_src >= 0)
 		close(fd_src);
 	if (fd_dst >= 0)
 		close(fd_dst);
-	if (buf)
-		free(buf);
 
 	return ret;
 }
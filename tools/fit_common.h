@@ -41,10 +41,43 @@ int mmap_fdt(const char *cmdname, const char *fname, size_t size_inc,
 	     void **blobp, struct stat *sbuf, bool delete_on_error,
 	     bool read_only);
 
+/**
+ * mmap_new_file() - Create a file and map it into memory
+ *
+ * The file is created with @size bytes of zeroes, or truncated to that size
+ * if it exists. Changes to the mapping go straight to the file, so a large
+ * image can be built in it without holding a copy in memory.
+ *
+ * @cmdname:	Tool name (for displaying with error messages)
+ * @fname:	Filename to create
+ * @size:	Size of the file
+ * @blobp:	Returns pointer to the mapping
+ * Return: file descriptor if OK, -1 on error
+ */
+int mmap_new_file(const char *cmdname, const char *fname, size_t size,
+		  void **blobp);
+
+/**
+ * copyfile_range() - Copy part of one file to another
+ *
+ * On Linux the kernel does the copy, so the data does not pass through a
+ * user-space buffer and may be shared rather than copied on filesystems which
+ * support it. Otherwise pread()/pwrite() are used with a small buffer.
+ *
+ * @fd_src:	File to read from
+ * @src_off:	Offset in @fd_src to start reading at
+ * @fd_dst:	File to write to
+ * @dst_off:	Offset in @fd_dst to start writing at
+ * @len:	Number of bytes to copy
+ * Return: 0 if OK, -1 on error
+ */
+int copyfile_range(int fd_src, off_t src_off, int fd_dst, off_t dst_off,
+		   size_t len);
+
 /**
  * copyfile() - Copy a file
  *
- * This uses read()/write() to copy file @src to file @dst
+ * This uses copyfile_range() to copy file @src to file @dst
  *
  * If @dst exists, it is overwritten and truncated to the correct size.
  *
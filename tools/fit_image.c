@@ -61,6 +61,9 @@ static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 		ret = fit_set_timestamp(ptr, 0, time);
 	}
 
+	if (params->compat_index && !ret)
+		ret = fit_add_compat_index(ptr);
+
 	if (CONFIG_IS_ENABLED(FIT_SIGNATURE) && !ret)
 		ret = fit_pre_load_data(params->keydir, dest_blob, ptr);
 
@@ -80,6 +83,7 @@ static int fit_add_file_data(struct image_tool_params *params, size_t size_inc,
 						params->engine_id,
 						params->cmdname,
 						params->algo_name,
+						params->jobs,
 						&params->summary);
 	}
 
@@ -446,39 +450,28 @@ static int fit_build(struct image_tool_params *params, const char *fname)
 	size = fit_calc_size(params);
 	if (size < 0)
 		return -1;
-	buf = calloc(1, size);
-	if (!buf) {
-		fprintf(stderr, "%s: Out of memory (%d bytes)\n",
-			params->cmdname, size);
+
+	/* Build the FIT in the file itself so the data is not held in memory */
+	fd = mmap_new_file(params->cmdname, fname, size, (void **)&buf);
+	if (fd < 0)
 		return -1;
-	}
 	ret = fit_build_fdt(params, buf, size);
+	munmap(buf, size);
 	if (ret < 0) {
 		fprintf(stderr, "%s: Failed to build FIT image\n",
 			params->cmdname);
-		goto err_buf;
-	}
-	size = ret;
-	fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
-	if (fd < 0) {
-		fprintf(stderr, "%s: Can't open %s: %s\n",
-			params->cmdname, fname, strerror(errno));
-		goto err_buf;
+		goto err;
 	}
-	ret = write(fd, buf, size);
-	if (ret != size) {
+	if (ftruncate(fd, ret)) {
 		fprintf(stderr, "%s: Can't write %s: %s\n",
 			params->cmdname, fname, strerror(errno));
 		goto err;
 	}
 	close(fd);
-	free(buf);
 
 	return 0;
 err:
 	close(fd);
-err_buf:
-	free(buf);
 	return -1;
 }
 
@@ -495,16 +488,15 @@ err_buf:
  */
 static int fit_extract_data(struct image_tool_params *params, const char *fname)
 {
-	void *buf = NULL;
+	char datafile[MKIMAGE_MAX_TMPFILE_LEN + 6];
 	int buf_ptr;
 	int fit_size, unpadded_size, new_size, pad_boundary;
-	int fd;
+	int fd, datafd;
 	struct stat sbuf;
 	void *fdt;
 	int ret;
 	int images;
 	int node;
-	int image_number;
 	int align_size;
 
 	align_size = params->bl_len ? params->bl_len : 4;
@@ -513,23 +505,26 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		return -EIO;
 	fit_size = fdt_totalsize(fdt);
 
+	/*
+	 * The data is collected in a separate file, which the kernel can
+	 * copy into without going through our memory
+	 */
+	snprintf(datafile, sizeof(datafile), "%s.data", fname);
+	datafd = open(datafile, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
+	if (datafd < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n",
+			params->cmdname, datafile, strerror(errno));
+		munmap(fdt, sbuf.st_size);
+		close(fd);
+		return -EIO;
+	}
+
 	images = fdt_path_offset(fdt, FIT_IMAGES_PATH);
 	if (images < 0) {
 		debug("%s: Cannot find /images node: %d\n", __func__, images);
 		ret = -EINVAL;
 		goto err_munmap;
 	}
-	image_number = fdtdec_get_child_count(fdt, images);
-
-	/*
-	 * Allocate space to hold the image data we will extract,
-	 * extral space allocate for image alignment to prevent overflow.
-	 */
-	buf = calloc(1, fit_size + (align_size * image_number));
-	if (!buf) {
-		ret = -ENOMEM;
-		goto err_munmap;
-	}
 	buf_ptr = 0;
 
 	for (node = fdt_first_subnode(fdt, images);
@@ -541,7 +536,12 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		data = fdt_getprop(fdt, node, FIT_DATA_PROP, &len);
 		if (!data)
 			continue;
-		memcpy(buf + buf_ptr, data, len);
+		/* The mapping is shared, so the file holds the same data */
+		if (copyfile_range(fd, data - (char *)fdt, datafd, buf_ptr,
+				   len)) {
+			ret = -EIO;
+			goto err_munmap;
+		}
 		debug("Extracting data size %x\n", len);
 
 		ret = fdt_delprop(fdt, node, FIT_DATA_PROP);
@@ -593,37 +593,37 @@ static int fit_extract_data(struct image_tool_params *params, const char *fname)
 		}
 		new_size = params->external_offset;
 	}
-	if (lseek(fd, new_size, SEEK_SET) < 0) {
-		debug("%s: Failed to seek to end of file: %s\n", __func__,
-		      strerror(errno));
-		ret = -EIO;
-		goto err;
-	}
-	if (write(fd, buf, buf_ptr) != buf_ptr) {
+
+	/* Include the zero padding after the last image */
+	if (ftruncate(datafd, buf_ptr) ||
+	    copyfile_range(datafd, 0, fd, new_size, buf_ptr)) {
 		debug("%s: Failed to write external data to file %s\n",
 		      __func__, strerror(errno));
 		ret = -EIO;
 		goto err;
 	}
-	free(buf);
+	close(datafd);
+	unlink(datafile);
 	close(fd);
 	return 0;
 
 err_munmap:
 	munmap(fdt, sbuf.st_size);
 err:
-	free(buf);
+	close(datafd);
+	unlink(datafile);
 	close(fd);
 	return ret;
 }
 
 static int fit_import_data(struct image_tool_params *params, const char *fname)
 {
+	char newfile[MKIMAGE_MAX_TMPFILE_LEN + 5];
 	void *fdt, *old_fdt;
 	void *data = NULL;
 	const char *ext_data_prop = NULL;
 	int fit_size, new_size, size, data_base;
-	int fd;
+	int fd, newfd;
 	struct stat sbuf;
 	int ret;
 	int images;
@@ -635,14 +635,14 @@ static int fit_import_data(struct image_tool_params *params, const char *fname)
 	fit_size = fdt_totalsize(old_fdt);
 	data_base = ALIGN(fit_size, 4);
 
-	/* Allocate space to hold the new FIT */
+	/* Build the new FIT in a file, so large images are not held in memory */
+	snprintf(newfile, sizeof(newfile), "%s.new", fname);
 	size = sbuf.st_size + 16384;
-	fdt = calloc(1, size);
-	if (!fdt) {
-		fprintf(stderr, "%s: Failed to allocate memory (%d bytes)\n",
-			__func__, size);
-		ret = -ENOMEM;
-		goto err_munmap;
+	newfd = mmap_new_file(params->cmdname, newfile, size, &fdt);
+	if (newfd < 0) {
+		munmap(old_fdt, sbuf.st_size);
+		close(fd);
+		return -EIO;
 	}
 	ret = fdt_open_into(old_fdt, fdt, size);
 	if (ret) {
@@ -696,8 +696,6 @@ static int fit_import_data(struct image_tool_params *params, const char *fname)
 	}
 
 	munmap(old_fdt, sbuf.st_size);
-
-	/* Close the old fd so we can re-use it. */
 	close(fd);
 
 	/* Pack the FDT and place the data after it */
@@ -705,30 +703,31 @@ static int fit_import_data(struct image_tool_params *params, const char *fname)
 
 	new_size = fdt_totalsize(fdt);
 	debug("Size expanded from %x to %x\n", fit_size, new_size);
+	munmap(fdt, size);
 
-	fd = open(fname, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0666);
-	if (fd < 0) {
-		fprintf(stderr, "%s: Can't open %s: %s\n",
-			params->cmdname, fname, strerror(errno));
+	if (ftruncate(newfd, new_size)) {
+		fprintf(stderr, "%s: Can't write %s: %s\n",
+			params->cmdname, newfile, strerror(errno));
 		ret = -EIO;
 		goto err;
 	}
-	if (write(fd, fdt, new_size) != new_size) {
-		debug("%s: Failed to write external data to file %s\n",
-		      __func__, strerror(errno));
-		ret = -EIO;
-		goto err;
+	close(newfd);
+	if (rename(newfile, fname)) {
+		fprintf(stderr, "%s: Can't rename %s to %s: %s\n",
+			params->cmdname, newfile, fname, strerror(errno));
+		unlink(newfile);
+		return -EIO;
 	}
 
-	free(fdt);
-	close(fd);
 	return 0;
 
 err_munmap:
 	munmap(old_fdt, sbuf.st_size);
-err:
-	free(fdt);
+	munmap(fdt, size);
 	close(fd);
+err:
+	close(newfd);
+	unlink(newfile);
 	return ret;
 }
 
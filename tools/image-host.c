@@ -12,6 +12,7 @@
 #include <bootm.h>
 #include <fdt_region.h>
 #include <image.h>
+#include <pthread.h>
 #include <version.h>
 
 #if CONFIG_IS_ENABLED(FIT_SIGNATURE)
@@ -49,6 +50,157 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
 	return 0;
 }
 
+/**
+ * struct fit_hash_job - a hash value calculated ahead of time
+ *
+ * @data:	Image data to hash
+ * @size:	Size of @data in bytes
+ * @algo:	Name of the hash algorithm, or NULL if the node has none
+ * @value:	Returns the hash value
+ * @value_len:	Returns the length of @value in bytes
+ * @ret:	Returns 0 if OK, -1 if @algo is not supported
+ */
+struct fit_hash_job {
+	const void *data;
+	size_t size;
+	const char *algo;
+	uint8_t value[FIT_MAX_HASH_LEN];
+	int value_len;
+	int ret;
+};
+
+/**
+ * struct fit_hash_pool - image hashes calculated by worker threads
+ *
+ * All image hashes are calculated before anything is written to the FIT,
+ * since writing a property moves the image data around. The values are then
+ * written in the usual order, so the output is the same for any number of
+ * threads.
+ *
+ * @jobs:	Hashes to calculate, in the order their nodes appear in the FIT
+ * @count:	Number of jobs
+ * @next:	Next job for a worker to take
+ * @used:	Number of jobs whose values have been written to the FIT
+ * @lock:	Protects @next
+ */
+struct fit_hash_pool {
+	struct fit_hash_job *jobs;
+	int count;
+	int next;
+	int used;
+	pthread_mutex_t lock;
+};
+
+static void *fit_hash_worker(void *arg)
+{
+	struct fit_hash_pool *pool = arg;
+	struct fit_hash_job *job;
+	int i;
+
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		i = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+		if (i >= pool->count)
+			break;
+
+		job = &pool->jobs[i];
+		job->ret = -1;
+		if (job->algo)
+			job->ret = calculate_hash(job->data, job->size,
+						  job->algo, job->value,
+						  &job->value_len);
+	}
+
+	return NULL;
+}
+
+/**
+ * fit_hash_pool_run() - calculate the hashes of all component images
+ *
+ * This collects every hash node below @images_noffset and shares them out
+ * between @jobs threads, including the calling one. Problems with the nodes
+ * are not reported here, but when the values are written.
+ *
+ * @pool:	Pool to set up
+ * @fit:	Pointer to the FIT format image header
+ * @images_noffset: Offset of the images node
+ * @jobs:	Number of threads to use
+ * Return: 0 if OK, -ENOMEM if out of memory
+ */
+static int fit_hash_pool_run(struct fit_hash_pool *pool, void *fit,
+			     int images_noffset, int jobs)
+{
+	struct fit_hash_job *job;
+	pthread_t *threads;
+	int image, noffset;
+	int i, started;
+
+	memset(pool, '\0', sizeof(*pool));
+	fdt_for_each_subnode(image, fit, images_noffset) {
+		const void *data;
+		size_t size;
+
+		/* This is reported when the values are written */
+		if (fit_image_get_data(fit, image, &data, &size))
+			break;
+		fdt_for_each_subnode(noffset, fit, image) {
+			if (strncmp(fit_get_name(fit, noffset, NULL),
+				    FIT_HASH_NODENAME,
+				    strlen(FIT_HASH_NODENAME)))
+				continue;
+			job = realloc(pool->jobs,
+				      (pool->count + 1) * sizeof(*job));
+			if (!job)
+				goto err;
+			pool->jobs = job;
+			job += pool->count++;
+			job->data = data;
+			job->size = size;
+			if (fit_image_hash_get_algo(fit, noffset, &job->algo))
+				job->algo = NULL;
+		}
+	}
+
+	if (!pool->count)
+		return 0;
+	if (jobs > pool->count)
+		jobs = pool->count;
+	threads = calloc(jobs, sizeof(*threads));
+	if (!threads)
+		goto err;
+	pthread_mutex_init(&pool->lock, NULL);
+
+	/* If a thread cannot be started, the others pick up its share */
+	for (started = 0; started < jobs - 1; started++) {
+		if (pthread_create(&threads[started], NULL, fit_hash_worker,
+				   pool))
+			break;
+	}
+	fit_hash_worker(pool);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	pthread_mutex_destroy(&pool->lock);
+	free(threads);
+
+	return 0;
+err:
+	fprintf(stderr, "Out of memory for hash jobs\n");
+	free(pool->jobs);
+
+	return -ENOMEM;
+}
+
+/* Get the next precalculated hash, in FIT order */
+static const struct fit_hash_job *fit_hash_pool_next(struct fit_hash_pool *pool)
+{
+	if (!pool || pool->used >= pool->count)
+		return NULL;
+
+	return &pool->jobs[pool->used++];
+}
+
 /**
  * fit_image_process_hash - Process a single subnode of the images/ node
  *
@@ -60,10 +212,12 @@ static int fit_set_hash_value(void *fit, int noffset, uint8_t *value,
  * @noffset:	subnode offset
  * @data:	data to process
  * @size:	size of data in bytes
+ * @job:	hash already calculated for this node, or NULL to do it here
  * Return: 0 if ok, -1 on error
  */
 static int fit_image_process_hash(void *fit, const char *image_name,
-		int noffset, const void *data, size_t size)
+		int noffset, const void *data, size_t size,
+		const struct fit_hash_job *job)
 {
 	uint8_t value[FIT_MAX_HASH_LEN];
 	const char *node_name;
@@ -80,7 +234,14 @@ static int fit_image_process_hash(void *fit, const char *image_name,
 		return -ENOENT;
 	}
 
-	if (calculate_hash(data, size, algo, value, &value_len)) {
+	if (job) {
+		ret = job->ret;
+		value_len = job->value_len;
+		memcpy(value, job->value, sizeof(value));
+	} else {
+		ret = calculate_hash(data, size, algo, value, &value_len);
+	}
+	if (ret) {
 		fprintf(stderr,
 			"Unsupported hash algorithm (%s) for '%s' hash node in '%s' image node\n",
 			algo, node_name, image_name);
@@ -641,12 +802,14 @@ int fit_image_cipher_data(const char *keydir, void *keydest,
  * @comment:	Comment to add to signature nodes
  * @require_keys: Mark all keys as 'required'
  * @engine_id:	Engine to use for signing
+ * @pool:	Hashes already calculated, or NULL to calculate them here
  * @return: 0 on success, <0 on failure
  */
 int fit_image_add_verification_data(const char *keydir, const char *keyfile,
 		void *keydest, void *fit, int image_noffset,
 		const char *comment, int require_keys, const char *engine_id,
-		const char *cmdname, const char* algo_name)
+		const char *cmdname, const char* algo_name,
+		struct fit_hash_pool *pool)
 {
 	const char *image_name;
 	const void *data;
@@ -677,7 +840,8 @@ int fit_image_add_verification_data(const char *keydir, const char *keyfile,
 		if (!strncmp(node_name, FIT_HASH_NODENAME,
 			     strlen(FIT_HASH_NODENAME))) {
 			ret = fit_image_process_hash(fit, image_name, noffset,
-						data, size);
+						data, size,
+						fit_hash_pool_next(pool));
 		} else if (IMAGE_ENABLE_SIGN && (keydir || keyfile) &&
 			   !strncmp(node_name, FIT_SIG_NODENAME,
 				strlen(FIT_SIG_NODENAME))) {
@@ -1301,15 +1465,73 @@ int fit_cipher_data(const char *keydir, void *keydest, void *fit,
 	return 0;
 }
 
+int fit_add_compat_index(void *fit)
+{
+	int confs_noffset, images_noffset, noffset, compat_noffset;
+	char *index = NULL, *p;
+	size_t size = 0;
+	int ret;
+
+	confs_noffset = fdt_path_offset(fit, FIT_CONFS_PATH);
+	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
+	if (confs_noffset < 0 || images_noffset < 0) {
+		fprintf(stderr, "Can't find configurations or images nodes\n");
+		return -ENOENT;
+	}
+
+	/* List each compatible string with its configuration, in order */
+	fdt_for_each_subnode(noffset, fit, confs_noffset) {
+		const char *compat, *name;
+		const void *fdt;
+		int len, name_len;
+
+		compat_noffset = fit_conf_get_compat_node(fit, images_noffset,
+							  noffset, &fdt);
+		if (compat_noffset < 0)
+			continue;
+		compat = fdt_getprop(fdt, compat_noffset, "compatible", &len);
+		if (!compat || len <= 0 || compat[len - 1])
+			continue;
+		name = fdt_get_name(fit, noffset, &name_len);
+
+		for (; len > 0; len -= strlen(compat) + 1,
+		     compat += strlen(compat) + 1) {
+			p = realloc(index, size + strlen(compat) + name_len + 2);
+			if (!p) {
+				free(index);
+				return -ENOMEM;
+			}
+			index = p;
+			p += size;
+			strcpy(p, compat);
+			p += strlen(compat) + 1;
+			memcpy(p, name, name_len);
+			p[name_len] = '\0';
+			size = p + name_len + 1 - index;
+		}
+	}
+	if (!index)
+		return 0;
+
+	ret = fdt_setprop(fit, confs_noffset, FIT_COMPAT_INDEX_PROP, index,
+			  size);
+	free(index);
+	if (ret)
+		return ret == -FDT_ERR_NOSPACE ? -ENOSPC : -EIO;
+
+	return 0;
+}
+
 int fit_add_verification_data(const char *keydir, const char *keyfile,
 			      void *keydest, void *fit, const char *comment,
 			      int require_keys, const char *engine_id,
 			      const char *cmdname, const char *algo_name,
-			      struct image_summary *summary)
+			      int jobs, struct image_summary *summary)
 {
+	struct fit_hash_pool pool, *poolp = NULL;
 	int images_noffset, confs_noffset;
 	int noffset;
-	int ret;
+	int ret = 0;
 
 	/* Find images parent node offset */
 	images_noffset = fdt_path_offset(fit, FIT_IMAGES_PATH);
@@ -1319,6 +1541,13 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 		return images_noffset;
 	}
 
+	if (jobs > 1) {
+		ret = fit_hash_pool_run(&pool, fit, images_noffset, jobs);
+		if (ret)
+			return ret;
+		poolp = &pool;
+	}
+
 	/* Process its subnodes, print out component images details */
 	for (noffset = fdt_first_subnode(fit, images_noffset);
 	     noffset >= 0;
@@ -1329,14 +1558,18 @@ int fit_add_verification_data(const char *keydir, const char *keyfile,
 		 */
 		ret = fit_image_add_verification_data(keydir, keyfile, keydest,
 				fit, noffset, comment, require_keys, engine_id,
-				cmdname, algo_name);
+				cmdname, algo_name, poolp);
 		if (ret) {
 			fprintf(stderr, "Can't add verification data for node '%s' (%s)\n",
 				fdt_get_name(fit, noffset, NULL),
 				strerror(-ret));
-			return ret;
+			break;
 		}
 	}
+	if (poolp)
+		free(pool.jobs);
+	if (ret)
+		return ret;
 
 	/* If there are no keys, we can't sign configurations */
 	if (!IMAGE_ENABLE_SIGN || !(keydir || keyfile))
@@ -97,7 +97,10 @@ struct image_tool_params {
 	unsigned int external_offset;	/* Add padding to external data */
 	int bl_len;		/* Block length in byte for external data */
 	const char *engine_id;	/* Engine to use for signing */
+	int jobs;		/* Threads to calculate image hashes with */
 	bool reset_timestamp;	/* Reset the timestamp on an existing image */
+	bool compact_script;	/* Strip comments, etc. from a script image */
+	bool compat_index;	/* Add an index of configurations to a FIT */
 	struct image_summary summary;	/* results of signing process */
 };
 
@@ -29,6 +29,7 @@ static struct image_tool_params params = {
 	.dtc = MKIMAGE_DEFAULT_DTC_OPTIONS,
 	.imagename = "",
 	.imagename2 = "",
+	.jobs = 1,
 };
 
 static enum ih_category cur_category;
@@ -101,10 +102,11 @@ static void usage(const char *msg)
 		"          -d ==> use image data from 'datafile'\n"
 		"          -x ==> set XIP (execute in place)\n"
 		"          -s ==> create an image with no data\n"
+		"          -S ==> remove comments, etc. from a script image\n"
 		"          -v ==> verbose\n",
 		params.cmdname);
 	fprintf(stderr,
-		"       %s [-D dtc_options] [-f fit-image.its|-f auto|-f auto-conf|-F] [-b <dtb> [-b <dtb>]] [-E] [-B size] [-i <ramdisk.cpio.gz>] fit-image\n"
+		"       %s [-D dtc_options] [-f fit-image.its|-f auto|-f auto-conf|-F] [-b <dtb> [-b <dtb>]] [-E] [-B size] [-i <ramdisk.cpio.gz>] [-I] [-j jobs] fit-image\n"
 		"           <dtb> file is used with -f auto, it may occur multiple times.\n",
 		params.cmdname);
 	fprintf(stderr,
@@ -114,7 +116,9 @@ static void usage(const char *msg)
 		"          -E => place data outside of the FIT structure\n"
 		"          -B => align size in hex for FIT structure and header\n"
 		"          -b => append the device tree binary to the FIT\n"
-		"          -t => update the timestamp in the FIT\n");
+		"          -t => update the timestamp in the FIT\n"
+		"          -I => add an index of configurations by compatible\n"
+		"          -j => calculate image hashes with this many threads (0 = one per CPU)\n");
 #if CONFIG_IS_ENABLED(FIT_SIGNATURE)
 	fprintf(stderr,
 		"Signing / verified boot options: [-k keydir] [-K dtb] [ -c <comment>] [-p addr] [-r] [-N engine]\n"
@@ -160,7 +164,7 @@ static int add_content(int type, const char *fname)
 }
 
 static const char optstring[] =
-	"a:A:b:B:c:C:d:D:e:Ef:Fg:G:i:k:K:ln:N:o:O:p:qrR:stT:vVx";
+	"a:A:b:B:c:C:d:D:e:Ef:Fg:G:i:Ij:k:K:ln:N:o:O:p:qrR:sStT:vVx";
 
 static const struct option longopts[] = {
 	{ "load-address", required_argument, NULL, 'a' },
@@ -179,6 +183,8 @@ static const struct option longopts[] = {
 	{ "key-file", required_argument, NULL, 'G' },
 	{ "help", no_argument, NULL, 'h' },
 	{ "initramfs", required_argument, NULL, 'i' },
+	{ "compat-index", no_argument, NULL, 'I' },
+	{ "jobs", required_argument, NULL, 'j' },
 	{ "key-dir", required_argument, NULL, 'k' },
 	{ "key-dest", required_argument, NULL, 'K' },
 	{ "list", no_argument, NULL, 'l' },
@@ -191,6 +197,7 @@ static const struct option longopts[] = {
 	{ "key-required", no_argument, NULL, 'r' },
 	{ "secondary-config", required_argument, NULL, 'R' },
 	{ "no-copy", no_argument, NULL, 's' },
+	{ "compact-script", no_argument, NULL, 'S' },
 	{ "touch", no_argument, NULL, 't' },
 	{ "type", required_argument, NULL, 'T' },
 	{ "verbose", no_argument, NULL, 'v' },
@@ -294,6 +301,16 @@ static void process_args(int argc, char **argv)
 		case 'i':
 			params.fit_ramdisk = optarg;
 			break;
+		case 'I':
+			params.compat_index = true;
+			break;
+		case 'j':
+			params.jobs = strtol(optarg, &ptr, 10);
+			if (*ptr || params.jobs < 0)
+				usage("Invalid number of jobs");
+			if (!params.jobs)
+				params.jobs = sysconf(_SC_NPROCESSORS_ONLN);
+			break;
 		case 'k':
 			params.keydir = optarg;
 			break;
@@ -343,6 +360,9 @@ static void process_args(int argc, char **argv)
 		case 's':
 			params.skipcpy = 1;
 			break;
+		case 'S':
+			params.compact_script = true;
+			break;
 		case 't':
 			params.reset_timestamp = 1;
 			break;
@@ -402,6 +422,10 @@ static void process_args(int argc, char **argv)
 		params.type = type;
 	}
 
+	if (params.compact_script &&
+	    (params.type != IH_TYPE_SCRIPT || strchr(params.datafile, ':')))
+		usage("Only a single script image can be compacted");
+
 	if (!params.imagefile)
 		usage("Missing output filename");
 }
@@ -444,6 +468,112 @@ static void verify_image(const struct image_type_params *tparams)
 	(void)close(ifd);
 }
 
+/*
+ * Remove comments, indentation, trailing blanks and blank lines from a script,
+ * so that U-Boot has less to parse. Quoted text and anything escaped with a
+ * backslash is kept as it is. Returns the new length.
+ */
+static int compact_script(char *buf, int len)
+{
+	bool line_start = true;	/* nothing written for this line yet */
+	bool word_start = true;	/* a '#' here starts a comment */
+	int keep = 0;		/* length up to the last non-blank character */
+	char quote = 0;
+	int in, out;
+
+	for (in = out = 0; in < len; in++) {
+		char ch = buf[in];
+
+		if (quote) {
+			buf[out++] = ch;
+			if (ch == '\\' && quote == '"' && in + 1 < len)
+				buf[out++] = buf[++in];
+			else if (ch == quote)
+				quote = 0;
+			keep = out;
+			continue;
+		}
+		switch (ch) {
+		case '\n':
+			out = keep;
+			if (!line_start)
+				buf[out++] = ch;
+			keep = out;
+			line_start = true;
+			word_start = true;
+			break;
+		case ' ':
+		case '\t':
+			if (!line_start)
+				buf[out++] = ch;
+			word_start = true;
+			break;
+		case '#':
+			if (word_start) {
+				while (in + 1 < len && buf[in + 1] != '\n')
+					in++;
+				break;
+			}
+			/* fallthrough */
+		default:
+			buf[out++] = ch;
+			if (ch == '\\' && in + 1 < len)
+				buf[out++] = buf[++in];
+			else if (ch == '\'' || ch == '"')
+				quote = ch;
+			keep = out;
+			line_start = false;
+			word_start = ch == ';' || ch == '&' || ch == '|';
+			break;
+		}
+	}
+
+	return quote ? out : keep;
+}
+
+static void copy_script_compact(int ifd, const char *datafile)
+{
+	struct stat sbuf;
+	uint32_t size[2];
+	char *buf;
+	int dfd, len;
+
+	dfd = open(datafile, O_RDONLY | O_BINARY);
+	if (dfd < 0 || fstat(dfd, &sbuf) < 0) {
+		fprintf(stderr, "%s: Can't open %s: %s\n", params.cmdname,
+			datafile, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	buf = malloc(sbuf.st_size);
+	if (!buf) {
+		fprintf(stderr, "%s: Out of memory reading %s\n",
+			params.cmdname, datafile);
+		exit(EXIT_FAILURE);
+	}
+	if (read(dfd, buf, sbuf.st_size) != sbuf.st_size) {
+		fprintf(stderr, "%s: Can't read %s: %s\n", params.cmdname,
+			datafile, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	close(dfd);
+
+	len = compact_script(buf, sbuf.st_size);
+	if (params.vflag)
+		fprintf(stderr, "Compacted script %s from %ld to %d bytes\n",
+			datafile, (long)sbuf.st_size, len);
+
+	/* A script is a multi-file image with one file */
+	size[0] = cpu_to_uimage(len);
+	size[1] = 0;
+	if (write(ifd, size, sizeof(size)) != sizeof(size) ||
+	    write(ifd, buf, len) != len) {
+		fprintf(stderr, "%s: Write error on %s: %s\n", params.cmdname,
+			params.imagefile, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+	free(buf);
+}
+
 void copy_datafile(int ifd, char *file)
 {
 	if (!file)
@@ -644,8 +774,10 @@ int main(int argc, char **argv)
 	}
 
 	if (!params.skipcpy) {
-		if (params.type == IH_TYPE_MULTI ||
-		    params.type == IH_TYPE_SCRIPT) {
+		if (params.compact_script) {
+			copy_script_compact(ifd, params.datafile);
+		} else if (params.type == IH_TYPE_MULTI ||
+			   params.type == IH_TYPE_SCRIPT) {
 			char *file = params.datafile;
 			uint32_t size;
 
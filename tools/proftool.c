@@ -38,6 +38,7 @@
 /* from linux/kernel.h */
 #define __ALIGN_MASK(x, mask)	(((x) + (mask)) & ~(mask))
 #define ALIGN(x, a)		__ALIGN_MASK((x), (typeof(x))(a) - 1)
+#define ARRAY_SIZE(x)		(sizeof(x) / sizeof((x)[0]))
 
 /**
  * container_of - cast a member of a structure out to the containing structure
@@ -172,12 +173,22 @@ struct flame_state {
  * @name: Function name
  * @code_size: Total code size of the function
  * @flags: Either 0 or FUNCF_TRACE
+ * @calls: Number of calls to the function in the trace
+ * @total_us: Microseconds spent in the function, including its callees
+ * @self_us: Microseconds spent in the function, excluding its callees
+ * @initcalls: Number of calls made directly by initcall_run_list()
+ * @initcall_us: Microseconds spent in those calls, including callees
  */
 struct func_info {
 	unsigned long offset;
 	const char *name;
 	unsigned long code_size;
 	unsigned flags;
+	ulong calls;
+	ulong total_us;
+	ulong self_us;
+	ulong initcalls;
+	ulong initcall_us;
 };
 
 /**
@@ -206,6 +217,51 @@ struct trace_configline_info {
 	regex_t regex;
 };
 
+/**
+ * enum prof_kind - kinds of entry in a profile
+ *
+ * @PROF_PHASE: Boot phase (TPL, SPL, U-Boot proper, bootm), from bootstage
+ * @PROF_INITCALL: Initcall, from bootstage spans or from the trace
+ * @PROF_FUNC: Function, from the trace
+ */
+enum prof_kind {
+	PROF_PHASE,
+	PROF_INITCALL,
+	PROF_FUNC,
+
+	PROF_KIND_COUNT,
+};
+
+/**
+ * struct prof_item - an entry in a profile
+ *
+ * @kind: Kind of entry
+ * @name: Name of the phase, initcall or function
+ * @calls: Number of times it ran
+ * @us: Microseconds taken; for functions this excludes their callees
+ * @total_us: Microseconds taken, including any callees
+ */
+struct prof_item {
+	enum prof_kind kind;
+	char *name;
+	ulong calls;
+	ulong us;
+	ulong total_us;
+};
+
+/**
+ * struct profile - a list of profile entries, as written by dump-profile
+ *
+ * @item: Entries
+ * @count: Number of entries
+ * @alloced: Number of entries allocated
+ */
+struct profile {
+	struct prof_item *item;
+	int count;
+	int alloced;
+};
+
 /**
  * struct tw_len - holds information about a length value that need fix-ups
  *
@@ -281,13 +337,16 @@ static void outf(int level, const char *fmt, ...)
 static void usage(void)
 {
 	fprintf(stderr,
-		"Usage: proftool [-cmtv] <cmd> <profdata>\n"
+		"Usage: proftool [-bcfmotv] <cmd> <profdata>\n"
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out records in ftrace format for use by trace-cmd\n"
 		"   dump-flamegraph\tWrite a file for use with flamegraph.pl\n"
+		"   dump-profile\tWrite per-phase, per-initcall and per-function times\n"
+		"   diff-profile <old> <new>\tCompare two files from dump-profile\n"
 		"\n"
 		"Options:\n"
+		"   -b <fname>\tSpecify bootstage data (from U-Boot 'bootstage export')\n"
 		"   -c <cfg>\tSpecify config file\n"
 		"   -f <subtype>\tSpecify output subtype\n"
 		"   -m <map>\tSpecify System.map file\n"
@@ -1891,27 +1950,630 @@ static int make_flamegraph(FILE *fout, enum out_format_t out_format)
 	return ret;
 }
 
+static const char *const prof_kind_name[PROF_KIND_COUNT] = {
+	"phase", "initcall", "func",
+};
+
+/*
+ * Bootstage marks which start each boot phase. A phase lasts until the next
+ * one starts, or until the last mark.
+ */
+static const struct {
+	const char *mark;
+	const char *phase;
+} phase_marks[] = {
+	{ "TPL", "tpl" },
+	{ "VPL", "vpl" },
+	{ "SPL", "spl" },
+	{ "board_init_f", "proper" },
+	{ "bootm_start", "bootm" },
+};
+
+/**
+ * struct bs_mark - a bootstage mark read from the bootstage data
+ *
+ * @name: Name of the mark
+ * @ts: Time of the mark in microseconds
+ */
+struct bs_mark {
+	char *name;
+	ulong ts;
+};
+
+/**
+ * profile_add() - Add an entry to a profile
+ *
+ * @prof: Profile to add to
+ * @kind: Kind of entry
+ * @name: Name of entry (this is copied)
+ * @calls: Number of times it ran
+ * @us: Microseconds taken, excluding callees
+ * @total_us: Microseconds taken, including callees
+ * Returns: 0 if OK, -1 if out of memory
+ */
+static int profile_add(struct profile *prof, enum prof_kind kind,
+		       const char *name, ulong calls, ulong us, ulong total_us)
+{
+	struct prof_item *item;
+
+	if (prof->count == prof->alloced) {
+		prof->alloced += 256;
+		prof->item = realloc(prof->item,
+				     sizeof(struct prof_item) * prof->alloced);
+		if (!prof->item) {
+			error("Out of memory for profile\n");
+			return -1;
+		}
+	}
+	item = &prof->item[prof->count++];
+	item->kind = kind;
+	item->name = strdup(name);
+	item->calls = calls;
+	item->us = us;
+	item->total_us = total_us;
+
+	return item->name ? 0 : -1;
+}
+
+static int h_cmp_item_name(const void *v1, const void *v2)
+{
+	const struct prof_item *i1 = v1, *i2 = v2;
+
+	if (i1->kind != i2->kind)
+		return i1->kind - i2->kind;
+
+	return strcmp(i1->name, i2->name);
+}
+
+static int h_cmp_item_time(const void *v1, const void *v2)
+{
+	const struct prof_item *i1 = v1, *i2 = v2;
+
+	if (i1->kind != i2->kind)
+		return i1->kind - i2->kind;
+	if (i1->us != i2->us)
+		return i1->us < i2->us ? 1 : -1;
+
+	return strcmp(i1->name, i2->name);
+}
+
+/**
+ * profile_merge() - Sort a profile by name and combine duplicate entries
+ *
+ * An initcall can run more than once, e.g. an event which is sent before and
+ * after relocation, so its entries are added together
+ *
+ * @prof: Profile to update
+ */
+static void profile_merge(struct profile *prof)
+{
+	struct prof_item *item, *last = NULL;
+	int i, count = 0;
+
+	qsort(prof->item, prof->count, sizeof(struct prof_item),
+	      h_cmp_item_name);
+	for (i = 0, item = prof->item; i < prof->count; i++, item++) {
+		if (last && !h_cmp_item_name(last, item)) {
+			last->calls += item->calls;
+			last->us += item->us;
+			last->total_us += item->total_us;
+			free(item->name);
+			continue;
+		}
+		last = &prof->item[count++];
+		*last = *item;
+	}
+	prof->count = count;
+}
+
+static struct func_info *find_func_by_name(const char *name)
+{
+	int i;
+
+	for (i = 0; i < func_count; i++) {
+		if (!strcmp(func_list[i].name, name))
+			return &func_list[i];
+	}
+
+	return NULL;
+}
+
+/**
+ * json_get_str() - Read a string value from a line of JSON
+ *
+ * This only handles the simple JSON written by bootstage_export_json(), with
+ * one event per line
+ *
+ * @line: Line to search
+ * @key: Key to look for
+ * @buf: Returns the value, with escapes decoded
+ * @size: Size of @buf
+ * Returns: 0 if OK, -1 if the key was not found
+ */
+static int json_get_str(const char *line, const char *key, char *buf,
+			int size)
+{
+	char search[40];
+	const char *p;
+	int len = 0;
+
+	snprintf(search, sizeof(search), "\"%s\":\"", key);
+	p = strstr(line, search);
+	if (!p)
+		return -1;
+	for (p += strlen(search); *p && *p != '"' && len < size - 1; p++) {
+		if (*p == '\\' && p[1] == 'u') {
+			buf[len++] = strtoul(p + 2, NULL, 16);
+			p += 5;
+			continue;
+		} else if (*p == '\\' && p[1]) {
+			p++;
+		}
+		buf[len++] = *p;
+	}
+	buf[len] = '\0';
+
+	return 0;
+}
+
+/**
+ * json_get_num() - Read a numeric value from a line of JSON
+ *
+ * @line: Line to search
+ * @key: Key to look for
+ * @valp: Returns the value
+ * Returns: 0 if OK, -1 if the key was not found
+ */
+static int json_get_num(const char *line, const char *key, ulong *valp)
+{
+	char search[40];
+	const char *p;
+
+	snprintf(search, sizeof(search), "\"%s\":", key);
+	p = strstr(line, search);
+	if (!p)
+		return -1;
+	*valp = strtoul(p + strlen(search), NULL, 10);
+
+	return 0;
+}
+
+static int h_cmp_mark(const void *v1, const void *v2)
+{
+	const struct bs_mark *m1 = v1, *m2 = v2;
+
+	if (m1->ts != m2->ts)
+		return m1->ts < m2->ts ? -1 : 1;
+
+	return 0;
+}
+
+/**
+ * add_phases() - Work out how long each boot phase took from bootstage marks
+ *
+ * @prof: Profile to add the phases to
+ * @mark: Marks to use; these are sorted into time order
+ * @count: Number of marks
+ * Returns: 0 if OK, -1 on error
+ */
+static int add_phases(struct profile *prof, struct bs_mark *mark, int count)
+{
+	const char *phase = NULL;
+	ulong start = 0;
+	int i, j;
+
+	if (!count)
+		return 0;
+	qsort(mark, count, sizeof(struct bs_mark), h_cmp_mark);
+	for (i = 0; i < count; i++) {
+		for (j = 0; j < ARRAY_SIZE(phase_marks); j++) {
+			if (!strcmp(mark[i].name, phase_marks[j].mark))
+				break;
+		}
+		if (j == ARRAY_SIZE(phase_marks))
+			continue;
+		if (phase && profile_add(prof, PROF_PHASE, phase, 1,
+					 mark[i].ts - start,
+					 mark[i].ts - start))
+			return -1;
+		phase = phase_marks[j].phase;
+		start = mark[i].ts;
+	}
+	if (phase && profile_add(prof, PROF_PHASE, phase, 1,
+				 mark[count - 1].ts - start,
+				 mark[count - 1].ts - start))
+		return -1;
+
+	return profile_add(prof, PROF_PHASE, "total", 1, mark[count - 1].ts,
+			   mark[count - 1].ts);
+}
+
+/**
+ * read_bootstage() - Read the bootstage data written by 'bootstage export'
+ *
+ * The marks are used to work out the time taken by each boot phase and the
+ * initcall spans give the time taken by each initcall. Initcalls recorded by
+ * address are looked up in the map file.
+ *
+ * @fin: File to read
+ * @prof: Profile to add to
+ * Returns: 0 if OK, -1 on error
+ */
+static int read_bootstage(FILE *fin, struct profile *prof)
+{
+	char line[MAX_LINE_LEN], name[MAX_LINE_LEN], cat[20];
+	struct bs_mark *mark = NULL;
+	int count = 0, alloced = 0;
+	int ret, i;
+
+	while (fgets(line, sizeof(line), fin)) {
+		ulong ts, dur;
+
+		if (json_get_str(line, "name", name, sizeof(name)) ||
+		    json_get_str(line, "cat", cat, sizeof(cat)) ||
+		    json_get_num(line, "ts", &ts))
+			continue;
+		if (!strcmp(cat, "mark")) {
+			if (count == alloced) {
+				alloced += 64;
+				mark = realloc(mark,
+					       sizeof(struct bs_mark) * alloced);
+				assert(mark);
+			}
+			mark[count].name = strdup(name);
+			mark[count++].ts = ts;
+		} else if (!strcmp(cat, "initcall") &&
+			   !json_get_num(line, "dur", &dur)) {
+			struct func_info *func = NULL;
+			ulong addr;
+
+			if (!strncmp(name, "0x", 2)) {
+				addr = strtoul(name, NULL, 16);
+				if (addr >= text_offset)
+					func = find_func_by_offset(addr -
+								   text_offset);
+			}
+			if (profile_add(prof, PROF_INITCALL,
+					func ? func->name : name, 1, dur, dur))
+				return -1;
+		}
+	}
+	notice("%d bootstage marks found\n", count);
+
+	ret = add_phases(prof, mark, count);
+	for (i = 0; i < count; i++)
+		free(mark[i].name);
+	free(mark);
+
+	return ret;
+}
+
+/**
+ * read_bootstage_file() - Open and read the bootstage data
+ *
+ * @fname: Filename to read
+ * @prof: Profile to add to
+ * Returns: 0 if OK, non-zero on error
+ */
+static int read_bootstage_file(const char *fname, struct profile *prof)
+{
+	FILE *fin;
+	int err;
+
+	fin = fopen(fname, "r");
+	if (!fin) {
+		error("Cannot open bootstage file '%s'\n", fname);
+		return 1;
+	}
+	err = read_bootstage(fin, prof);
+	fclose(fin);
+
+	return err;
+}
+
+/**
+ * add_func_times() - Add up the time taken by each function in the trace
+ *
+ * This fills in the call count and timings in func_list. Calls made directly
+ * by initcall_run_list() are also counted as initcalls.
+ *
+ * The time for a recursive function is counted once for each level of
+ * recursion.
+ */
+static void add_func_times(void)
+{
+	struct {
+		struct func_info *func;
+		ulong timestamp;
+		ulong child_total;
+	} stack[MAX_STACK_DEPTH];
+	struct func_info *initcall_run;
+	struct trace_call *call;
+	int depth = 0;
+	int i;
+
+	initcall_run = find_func_by_name("initcall_run_list");
+	for (i = 0, call = call_list; i < call_count; i++, call++) {
+		bool entry = TRACE_CALL_TYPE(call) == FUNCF_ENTRY;
+		ulong timestamp = call->flags & FUNCF_TIMESTAMP_MASK;
+		struct func_info *func;
+		ulong total;
+
+		func = find_func_by_offset(call->func);
+		if (!func)
+			continue;
+
+		if (entry) {
+			if (depth < MAX_STACK_DEPTH) {
+				stack[depth].func = func;
+				stack[depth].timestamp = timestamp;
+				stack[depth].child_total = 0;
+			}
+			depth++;
+			func->calls++;
+			continue;
+		}
+
+		/* Ignore returns from functions which were entered untraced */
+		if (!depth)
+			continue;
+		if (--depth >= MAX_STACK_DEPTH)
+			continue;
+		total = timestamp - stack[depth].timestamp;
+		func->total_us += total;
+		func->self_us += total - stack[depth].child_total;
+		if (depth) {
+			stack[depth - 1].child_total += total;
+			if (initcall_run && stack[depth - 1].func == initcall_run) {
+				func->initcalls++;
+				func->initcall_us += total;
+			}
+		}
+	}
+}
+
+/**
+ * make_profile() - Build a profile from the trace and bootstage data
+ *
+ * Initcalls are taken from the bootstage data if there are any there, since
+ * that covers all boot phases. Otherwise they are taken from the trace.
+ *
+ * @prof: Profile to fill in, which holds any bootstage data already read
+ * Returns: 0 if OK, -1 on error
+ */
+static int make_profile(struct profile *prof)
+{
+	bool have_initcalls = false;
+	int i;
+
+	for (i = 0; i < prof->count; i++) {
+		if (prof->item[i].kind == PROF_INITCALL)
+			have_initcalls = true;
+	}
+
+	add_func_times();
+	for (i = 0; i < func_count; i++) {
+		struct func_info *func = &func_list[i];
+
+		if (func->calls && profile_add(prof, PROF_FUNC, func->name,
+					       func->calls, func->self_us,
+					       func->total_us))
+			return -1;
+		if (!have_initcalls && func->initcalls &&
+		    profile_add(prof, PROF_INITCALL, func->name,
+				func->initcalls, func->initcall_us,
+				func->initcall_us))
+			return -1;
+	}
+	profile_merge(prof);
+
+	return 0;
+}
+
+/**
+ * write_profile() - Write out a profile
+ *
+ * Each line has the kind of entry, the number of calls, the time excluding
+ * callees, the total time and the name. Within each kind, the entries which
+ * took longest come first.
+ *
+ * @fout: Output file
+ * @prof: Profile to write
+ */
+static void write_profile(FILE *fout, struct profile *prof)
+{
+	struct prof_item *item;
+	int i;
+
+	qsort(prof->item, prof->count, sizeof(struct prof_item),
+	      h_cmp_item_time);
+	fprintf(fout, "# kind calls us total_us name\n");
+	for (i = 0, item = prof->item; i < prof->count; i++, item++)
+		fprintf(fout, "%s %lu %lu %lu %s\n", prof_kind_name[item->kind],
+			item->calls, item->us, item->total_us, item->name);
+}
+
+/**
+ * read_profile() - Read a profile written by write_profile()
+ *
+ * @fname: Filename to read
+ * @prof: Profile to fill in
+ * Returns: 0 if OK, -1 on error
+ */
+static int read_profile(const char *fname, struct profile *prof)
+{
+	char line[MAX_LINE_LEN], kind_name[20];
+	int linenum, ret = 0;
+	FILE *fin;
+
+	fin = fopen(fname, "r");
+	if (!fin) {
+		error("Cannot open profile '%s'\n", fname);
+		return -1;
+	}
+	for (linenum = 1; !ret && fgets(line, sizeof(line), fin); linenum++) {
+		ulong calls, us, total_us;
+		int kind, pos = 0;
+
+		if (*line == '#' || *line == '\n')
+			continue;
+		line[strcspn(line, "\n")] = '\0';
+		if (sscanf(line, "%19s %lu %lu %lu %n", kind_name, &calls, &us,
+			   &total_us, &pos) != 4 || !pos) {
+			error("%s:%d: invalid format\n", fname, linenum);
+			ret = -1;
+			break;
+		}
+		for (kind = 0; kind < PROF_KIND_COUNT; kind++) {
+			if (!strcmp(kind_name, prof_kind_name[kind]))
+				break;
+		}
+		if (kind == PROF_KIND_COUNT) {
+			error("%s:%d: unknown kind '%s'\n", fname, linenum,
+			      kind_name);
+			ret = -1;
+			break;
+		}
+		ret = profile_add(prof, kind, line + pos, calls, us, total_us);
+	}
+	fclose(fin);
+	if (!ret)
+		profile_merge(prof);
+
+	return ret;
+}
+
+/**
+ * struct prof_diff - the change in one profile entry between two boots
+ *
+ * @item: Entry in the new profile, or in the old one if it has gone
+ * @old_us: Microseconds taken in the old profile, 0 if not present
+ * @new_us: Microseconds taken in the new profile, 0 if not present
+ */
+struct prof_diff {
+	const struct prof_item *item;
+	ulong old_us;
+	ulong new_us;
+};
+
+static int h_cmp_diff(const void *v1, const void *v2)
+{
+	const struct prof_diff *d1 = v1, *d2 = v2;
+	long delta1 = d1->new_us - d1->old_us;
+	long delta2 = d2->new_us - d2->old_us;
+
+	if (d1->item->kind != d2->item->kind)
+		return d1->item->kind - d2->item->kind;
+	if (delta1 != delta2)
+		return delta1 < delta2 ? 1 : -1;
+
+	return strcmp(d1->item->name, d2->item->name);
+}
+
+/**
+ * diff_profiles() - Write out the differences between two profiles
+ *
+ * Entries which changed are listed for each kind, with the largest increase
+ * (i.e. the worst regression) first and the largest improvement last
+ *
+ * @fout: Output file
+ * @old_fname: Profile from the earlier boot
+ * @new_fname: Profile from the later boot
+ * Returns: 0 if OK, -1 on error
+ */
+static int diff_profiles(FILE *fout, const char *old_fname,
+			 const char *new_fname)
+{
+	struct profile old_prof = {}, new_prof = {};
+	struct prof_item *oi, *ni, *oend, *nend;
+	enum prof_kind kind = PROF_KIND_COUNT;
+	struct prof_diff *diff;
+	int i, count = 0;
+
+	if (read_profile(old_fname, &old_prof) ||
+	    read_profile(new_fname, &new_prof))
+		return -1;
+
+	diff = calloc(old_prof.count + new_prof.count, sizeof(*diff));
+	if (!diff) {
+		error("Out of memory for diff\n");
+		return -1;
+	}
+	oi = old_prof.item;
+	oend = oi + old_prof.count;
+	ni = new_prof.item;
+	nend = ni + new_prof.count;
+	while (oi < oend || ni < nend) {
+		struct prof_diff *d = &diff[count];
+		int cmp;
+
+		if (oi == oend)
+			cmp = 1;
+		else if (ni == nend)
+			cmp = -1;
+		else
+			cmp = h_cmp_item_name(oi, ni);
+		if (cmp <= 0) {
+			d->item = oi;
+			d->old_us = oi++->us;
+		}
+		if (cmp >= 0) {
+			d->item = ni;
+			d->new_us = ni++->us;
+		}
+		if (d->old_us != d->new_us)
+			count++;
+		else
+			memset(d, '\0', sizeof(*d));
+	}
+
+	qsort(diff, count, sizeof(*diff), h_cmp_diff);
+	for (i = 0; i < count; i++) {
+		const struct prof_diff *d = &diff[i];
+		long delta = d->new_us - d->old_us;
+
+		if (d->item->kind != kind) {
+			kind = d->item->kind;
+			fprintf(fout, "%s%-40s %10s %10s %10s\n", i ? "\n" : "",
+				prof_kind_name[kind], "old_us", "new_us",
+				"delta");
+		}
+		fprintf(fout, "  %-38s %10lu %10lu %+10ld", d->item->name,
+			d->old_us, d->new_us, delta);
+		if (d->old_us)
+			fprintf(fout, " %+6.1f%%", delta * 100.0 / d->old_us);
+		fprintf(fout, "\n");
+	}
+	free(diff);
+
+	return 0;
+}
+
 /**
  * prof_tool() - Performs requested action
  *
  * @argc: Number of arguments (used to obtain the command
  * @argv: List of arguments
- * @trace_fname: Filename of input file (trace data from U-Boot)
+ * @trace_fname: Filename of input file (trace data from U-Boot), or NULL
+ * @bootstage_fname: Filename of bootstage data from U-Boot, or NULL
  * @map_fname: Filename of map file (System.map from U-Boot)
  * @trace_config_fname: Trace-configuration file, or NULL if none
  * @out_fname: Output filename
  */
 static int prof_tool(int argc, char *const argv[],
-		     const char *trace_fname, const char *map_fname,
-		     const char *trace_config_fname, const char *out_fname,
-		     enum out_format_t out_format)
+		     const char *trace_fname, const char *bootstage_fname,
+		     const char *map_fname, const char *trace_config_fname,
+		     const char *out_fname, enum out_format_t out_format)
 {
+	struct profile prof = {};
 	int err = 0;
 
 	if (read_map_file(map_fname))
 		return -1;
 	if (trace_fname && read_trace_file(trace_fname))
 		return -1;
+	if (bootstage_fname && read_bootstage_file(bootstage_fname, &prof))
+		return -1;
 	if (trace_config_fname && read_trace_config_file(trace_config_fname))
 		return -1;
 
@@ -1920,6 +2582,10 @@ static int prof_tool(int argc, char *const argv[],
 	for (; argc; argc--, argv++) {
 		const char *cmd = *argv;
 
+		if (!trace_fname && strcmp(cmd, "dump-profile")) {
+			error("Command '%s' needs trace data (-t)\n", cmd);
+			return -1;
+		}
 		if (!strcmp(cmd, "dump-ftrace")) {
 			FILE *fout;
 
@@ -1948,6 +2614,19 @@ static int prof_tool(int argc, char *const argv[],
 			}
 			err = make_flamegraph(fout, out_format);
 			fclose(fout);
+		} else if (!strcmp(cmd, "dump-profile")) {
+			FILE *fout;
+
+			fout = fopen(out_fname, "w");
+			if (!fout) {
+				fprintf(stderr, "Cannot write file '%s'\n",
+					out_fname);
+				return -1;
+			}
+			err = make_profile(&prof);
+			if (!err)
+				write_profile(fout, &prof);
+			fclose(fout);
 		} else {
 			warn("Unknown command '%s'\n", cmd);
 		}
@@ -1961,13 +2640,17 @@ int main(int argc, char *argv[])
 	enum out_format_t out_format = OUT_FMT_DEFAULT;
 	const char *map_fname = "System.map";
 	const char *trace_fname = NULL;
+	const char *bootstage_fname = NULL;
 	const char *config_fname = NULL;
 	const char *out_fname = NULL;
 	int opt;
 
 	verbose = 2;
-	while ((opt = getopt(argc, argv, "c:f:m:o:t:v:")) != -1) {
+	while ((opt = getopt(argc, argv, "b:c:f:m:o:t:v:")) != -1) {
 		switch (opt) {
+		case 'b':
+			bootstage_fname = optarg;
+			break;
 		case 'c':
 			config_fname = optarg;
 			break;
@@ -2006,13 +2689,33 @@ int main(int argc, char *argv[])
 	if (argc < 1)
 		usage();
 
-	if (!out_fname || !map_fname || !trace_fname) {
+	if (!strcmp(argv[0], "diff-profile")) {
+		FILE *fout = stdout;
+		int err;
+
+		if (argc != 3)
+			usage();
+		if (out_fname) {
+			fout = fopen(out_fname, "w");
+			if (!fout) {
+				fprintf(stderr, "Cannot write file '%s'\n",
+					out_fname);
+				return 1;
+			}
+		}
+		err = diff_profiles(fout, argv[1], argv[2]);
+		if (out_fname)
+			fclose(fout);
+		return err ? 1 : 0;
+	}
+
+	if (!out_fname || !map_fname || (!trace_fname && !bootstage_fname)) {
 		fprintf(stderr,
-			"Must provide trace data, System.map file and output file\n");
+			"Must provide trace or bootstage data, System.map file and output file\n");
 		usage();
 	}
 
 	debug("Debug enabled\n");
-	return prof_tool(argc, argv, trace_fname, map_fname, config_fname,
-			 out_fname, out_format);
+	return prof_tool(argc, argv, trace_fname, bootstage_fname, map_fname,
+			 config_fname, out_fname, out_format);
 }